@@ -72,4 +72,18 @@ icAct::GetPalette( void )
 	return m_pPalette;
 }
 
+//! パレットエフェクトをかけたパレットを取得する
+/*!
+	ヒットの点滅やPalFXのように数フレームだけ色を変える時に使う。 \n
+	同じパラメータなら、キャッシュにあるパレットが返る。
+	@param[in]	pCache	キャッシュ(キャラクター間で共有してよい)
+	@param[in]	param	パラメータ
+	@return	エフェクトをかけたパレット。キャッシュが足りない場合などは、元のパレットが返る。
+*/
+Cat_Palette*
+icAct::GetPalette( Cat_PaletteEffectCache* pCache, const Cat_PaletteEffectParam& param )
+{
+	return Cat_PaletteEffectCacheGet( pCache, m_pPalette, &param );
+}
+
 } // namespace ic
@@ -30,6 +30,16 @@ public:
 		@return	パレット
 	*/
 	Cat_Palette* GetPalette( void );
+
+	//! パレットエフェクトをかけたパレットを取得する
+	/*!
+		ヒットの点滅やPalFXのように数フレームだけ色を変える時に使う。 \n
+		同じパラメータなら、キャッシュにあるパレットが返る。
+		@param[in]	pCache	キャッシュ(キャラクター間で共有してよい)
+		@param[in]	param	パラメータ
+		@return	エフェクトをかけたパレット。キャッシュが足りない場合などは、元のパレットが返る。
+	*/
+	Cat_Palette* GetPalette( Cat_PaletteEffectCache* pCache, const Cat_PaletteEffectParam& param );
 private:
 	Cat_Palette*	m_pPalette;		/*!< パレット	*/
 };
@@ -0,0 +1,219 @@
+//! @file	icAfterImage.cpp
+// 残像
+
+#include "icCore.h"
+
+namespace ic {
+
+//! 実装
+class icAfterImageImpl {
+public:
+	//! 1フレーム分の記録
+	struct Frame {
+		icTexture*	pTexture;		/*!< テクスチャ(描画しなかったフレームは0)	*/
+		float		x;				/*!< 描画位置X								*/
+		float		y;				/*!< 描画位置Y								*/
+		float		w;				/*!< 描画する横幅							*/
+		float		h;				/*!< 描画する高さ							*/
+	};
+
+	//! コンストラクタ
+	/*!
+		@param[in]	nCount		残像の数
+		@param[in]	nInterval	残像の間隔(フレーム単位)
+	*/
+	icAfterImageImpl( uint32_t nCount, uint32_t nInterval )
+		: m_variant( icDrawVariant::Fade( CAT_PALETTEEFFECT_UNIT / 2 ) )
+	{
+		SetTiming( nCount, nInterval );
+	}
+
+	//! 残像の数と間隔を設定する
+	/*!
+		@param[in]	nCount		残像の数
+		@param[in]	nInterval	残像の間隔(フレーム単位)
+	*/
+	void SetTiming( uint32_t nCount, uint32_t nInterval ) {
+		m_nCount    = nCount;
+		m_nInterval = nInterval ? nInterval : 1;
+		// 一番古い残像と、このフレームの分が入る大きさ
+		m_frame.resize( m_nCount * m_nInterval + 1 );
+		m_trail.resize( m_nCount + 1 );
+		Clear();
+	}
+
+	//! 残像の描画の種類を設定する
+	/*!
+		@param[in]	variant	描画の種類
+	*/
+	void SetVariant( const icDrawVariant& variant ) {
+		m_variant = variant;
+	}
+
+	//! このフレームの描画を記録する
+	/*!
+		@param[in]	pTexture	テクスチャ
+		@param[in]	x			描画位置X
+		@param[in]	y			描画位置Y
+		@param[in]	w			描画する横幅
+		@param[in]	h			描画する高さ
+	*/
+	void Record( icTexture* pTexture, float x, float y, float w, float h ) {
+		Frame& frame = m_frame[m_nHead];
+		frame.pTexture = pTexture;
+		frame.x = x;
+		frame.y = y;
+		frame.w = w;
+		frame.h = h;
+		m_nHead = (m_nHead + 1) % m_frame.size();
+		if(m_nRecorded < m_frame.size()) {
+			m_nRecorded++;
+		}
+	}
+
+	//! 記録をクリアする
+	void Clear( void ) {
+		m_nHead     = 0;
+		m_nRecorded = 0;
+	}
+
+	//! 描画する残像を取得する
+	/*!
+		@param[out]	pTrail	残像を受け取る配列
+		@param[in]	nMax	\a pTrail の要素数
+		@return	取得した残像の数
+	*/
+	uint32_t GetTrail( icAfterImage::Trail* pTrail, uint32_t nMax ) const {
+		const uint32_t nSize  = m_frame.size();
+		const uint32_t nAlpha = m_variant.GetAlpha();
+		uint32_t rc = 0;
+
+		// 新しいものが上になるように、古いものから並べる
+		for(uint32_t i = m_nCount; (i > 0) && (rc < nMax); i--) {
+			const uint32_t nAge = i * m_nInterval;
+			if(nAge >= m_nRecorded) {
+				continue;	// まだ記録が無い
+			}
+			const Frame& frame = m_frame[(m_nHead + nSize - 1 - nAge) % nSize];
+			if(frame.pTexture == 0) {
+				continue;
+			}
+			icAfterImage::Trail& trail = pTrail[rc++];
+			trail.pTexture = frame.pTexture;
+			trail.x        = frame.x;
+			trail.y        = frame.y;
+			trail.w        = frame.w;
+			trail.h        = frame.h;
+			trail.nAge     = nAge;
+			// 残像ごとのアルファは毎フレーム同じなので、キャッシュのパレットがそのまま使える
+			trail.nAlpha   = nAlpha * (m_nCount + 1 - i) / (m_nCount + 1);
+		}
+		return rc;
+	}
+
+	//! 残像を描画する
+	/*!
+		@return	描画した残像の数
+	*/
+	uint32_t Draw( void ) {
+		icDrawVariant variant( m_variant );
+		const uint32_t rc = GetTrail( &m_trail[0], m_trail.size() );
+
+		for(uint32_t i = 0; i < rc; i++) {
+			const icAfterImage::Trail& trail = m_trail[i];
+			variant.SetAlpha( trail.nAlpha );
+			trail.pTexture->Draw( trail.x, trail.y, trail.w, trail.h, variant );
+		}
+		return rc;
+	}
+
+private:
+	std::vector<Frame>	m_frame;		/*!< 記録のリング					*/
+	std::vector<icAfterImage::Trail>	m_trail;	/*!< 描画する残像(Draw()の作業用)	*/
+	uint32_t			m_nHead;		/*!< 次に記録する場所				*/
+	uint32_t			m_nRecorded;	/*!< 記録したフレーム数				*/
+	uint32_t			m_nCount;		/*!< 残像の数						*/
+	uint32_t			m_nInterval;	/*!< 残像の間隔(フレーム単位)		*/
+	icDrawVariant		m_variant;		/*!< 描画の種類						*/
+};
+
+//! コンストラクタ
+/*!
+	@param[in]	nCount		残像の数
+	@param[in]	nInterval	残像の間隔(フレーム単位)
+*/
+icAfterImage::icAfterImage( uint32_t nCount, uint32_t nInterval )
+	: m_impl( new icAfterImageImpl( nCount, nInterval ) )
+{
+}
+
+//! 残像の数と間隔を設定する
+/*!
+	記録はクリアされる。
+	@param[in]	nCount		残像の数
+	@param[in]	nInterval	残像の間隔(フレーム単位)
+*/
+void
+icAfterImage::SetTiming( uint32_t nCount, uint32_t nInterval )
+{
+	m_impl->SetTiming( nCount, nInterval );
+}
+
+//! 残像の描画の種類を設定する
+/*!
+	アルファは一番新しい残像のもので、古いものほど薄くなる。
+	@param[in]	variant	描画の種類
+*/
+void
+icAfterImage::SetVariant( const icDrawVariant& variant )
+{
+	m_impl->SetVariant( variant );
+}
+
+//! このフレームの描画を記録する
+/*!
+	1フレームに1回呼ぶ。描画しないフレームは \a pTexture を0にする。
+	@param[in]	pTexture	テクスチャ
+	@param[in]	x			描画位置X
+	@param[in]	y			描画位置Y
+	@param[in]	w			描画する横幅
+	@param[in]	h			描画する高さ
+*/
+void
+icAfterImage::Record( icTexture* pTexture, float x, float y, float w, float h )
+{
+	m_impl->Record( pTexture, x, y, w, h );
+}
+
+//! 記録をクリアする
+void
+icAfterImage::Clear( void )
+{
+	m_impl->Clear();
+}
+
+//! 描画する残像を取得する
+/*!
+	Draw()で描画するものを、描画する順(古いもの順)に取得する。
+	@param[out]	pTrail	残像を受け取る配列
+	@param[in]	nMax	\a pTrail の要素数
+	@return	取得した残像の数
+*/
+uint32_t
+icAfterImage::GetTrail( Trail* pTrail, uint32_t nMax ) const
+{
+	return m_impl->GetTrail( pTrail, nMax );
+}
+
+//! 残像を描画する
+/*!
+	古いものから順に描画する。このフレームで記録したものは描画しない。
+	@return	描画した残像の数
+*/
+uint32_t
+icAfterImage::Draw( void )
+{
+	return m_impl->Draw();
+}
+
+} // namespace ic
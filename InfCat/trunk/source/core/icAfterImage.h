@@ -0,0 +1,89 @@
+//! @file	icAfterImage.h
+// 残像
+
+#ifndef INCL_CLASS_icAfterImage
+#define INCL_CLASS_icAfterImage
+
+#include "icCore.h"
+
+namespace ic {
+
+//! 残像
+/*!
+	過去のフレームで描画したテクスチャと位置をリングに記録しておき、 \n
+	古いものほど薄くして、パレットを差し替えて描画する。 \n
+	N個の残像はN回の描画だけで、テクスチャのメモリは増えない。 \n
+	記録するテクスチャは参照を持たないので、テクスチャプールより先に破棄すること。
+*/
+class icAfterImage : boost::noncopyable {
+public:
+	//! 描画する残像1つ分
+	struct Trail {
+		icTexture*	pTexture;		/*!< テクスチャ						*/
+		float		x;				/*!< 描画位置X						*/
+		float		y;				/*!< 描画位置Y						*/
+		float		w;				/*!< 描画する横幅					*/
+		float		h;				/*!< 描画する高さ					*/
+		uint32_t	nAge;			/*!< 最後の記録の何フレーム前か		*/
+		uint32_t	nAlpha;			/*!< アルファ(256で不透明)			*/
+	};
+
+	//! コンストラクタ
+	/*!
+		@param[in]	nCount		残像の数
+		@param[in]	nInterval	残像の間隔(フレーム単位)
+	*/
+	icAfterImage( uint32_t nCount, uint32_t nInterval );
+
+	//! 残像の数と間隔を設定する
+	/*!
+		記録はクリアされる。
+		@param[in]	nCount		残像の数
+		@param[in]	nInterval	残像の間隔(フレーム単位)
+	*/
+	void SetTiming( uint32_t nCount, uint32_t nInterval );
+
+	//! 残像の描画の種類を設定する
+	/*!
+		アルファは一番新しい残像のもので、古いものほど薄くなる。
+		@param[in]	variant	描画の種類
+	*/
+	void SetVariant( const icDrawVariant& variant );
+
+	//! このフレームの描画を記録する
+	/*!
+		1フレームに1回呼ぶ。描画しないフレームは \a pTexture を0にする。
+		@param[in]	pTexture	テクスチャ
+		@param[in]	x			描画位置X
+		@param[in]	y			描画位置Y
+		@param[in]	w			描画する横幅
+		@param[in]	h			描画する高さ
+	*/
+	void Record( icTexture* pTexture, float x, float y, float w, float h );
+
+	//! 記録をクリアする
+	void Clear( void );
+
+	//! 描画する残像を取得する
+	/*!
+		Draw()で描画するものを、描画する順(古いもの順)に取得する。
+		@param[out]	pTrail	残像を受け取る配列
+		@param[in]	nMax	\a pTrail の要素数
+		@return	取得した残像の数
+	*/
+	uint32_t GetTrail( Trail* pTrail, uint32_t nMax ) const;
+
+	//! 残像を描画する
+	/*!
+		古いものから順に描画する。このフレームで記録したものは描画しない。
+		@return	描画した残像の数
+	*/
+	uint32_t Draw( void );
+
+private:
+	boost::shared_ptr<class icAfterImageImpl>	m_impl;		/*!< 実装	*/
+};
+
+} // namespace ic
+
+#endif // INCL_CLASS_icAfterImage
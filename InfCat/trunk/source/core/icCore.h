@@ -7,6 +7,7 @@
 #include <vector>
 #include <list>
 #include <map>
+#include <algorithm>
 
 // libCat
 #include "Cat_PspCallback.h"
@@ -14,6 +15,9 @@
 #include "Cat_StreamFile.h"
 #include "Cat_Render.h"
 #include "Cat_Input.h"
+#include "Cat_PaletteEffect.h"
+#include "Cat_RenderState.h"
+#include "Cat_SpriteBatch.h"
 
 #ifndef CAT_MALLOC
 //! mۃ}N
@@ -28,16 +32,23 @@
 // boost
 #include <boost/shared_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/intrusive_ptr.hpp>
 #include <boost/utility.hpp>
 
 // InfCat
 #include "icAct.h"
+#include "icDrawVariant.h"
 #include "icTexture.h"
 #include "icTexturePool.h"
+#include "icTextureResidency.h"
+#include "icAfterImage.h"
 #include "icSffLoader.h"
 #include "icTextReader.h"
 #include "icSectionValue.h"
 #include "icDef.h"
+#include "icStage.h"
+#include "icFont.h"
+#include "icHud.h"
 
 // for DEBUG
 #include <pspdebug.h>
@@ -245,7 +245,7 @@ icDef::Load( Cat_Stream* pStream )
 	// LINE := '\n'
 	//      | '[' SECTION
 	//      | string KEY_VALUE
-	// SECTION   := string ']' '\n'
+	// SECTION   := string { string } ']' '\n'
 	// KEY_VALUE := '=' string [ ',' string ] '\n'
 
 	std::string strSection;
@@ -261,14 +261,21 @@ icDef::Load( Cat_Stream* pStream )
 
 		icToken token = scanner.GetToken();
 		if(token.Check( '[' )) {
-			// SECTION := string ']' '\n'
+			// SECTION := string { string } ']' '\n'
 			token = scanner.GetToken();
 			if(!token.Check( icScannerBase::eTokenTypeString )) {
 				// 文字列ではない
 				return false;
 			}
 			strSection = token.GetString();
-			if(!scanner.GetToken().Check( ']' )) {
+			// ステージの[BG 1]のように、空白を挟んだ名前は1つの空白でつなぐ
+			token = scanner.GetToken();
+			while(token.Check( icScannerBase::eTokenTypeString )) {
+				strSection += " ";
+				strSection += token.GetString();
+				token = scanner.GetToken();
+			}
+			if(!token.Check( ']' )) {
 				// ']'がない
 				return false;
 			}
@@ -337,4 +344,26 @@ icDef::GetValue( const std::string& strSection, const std::string& strKey, int32
 	return m_SectionValue.GetValue( strSection, strKey, nIndex );
 }
 
+//! セクションが幾つあるか
+/*!
+	@return セクション数
+*/
+int32_t
+icDef::GetSectionCount( void ) const
+{
+	return m_SectionValue.GetSectionCount();
+}
+
+//! セクション名を取得する
+/*!
+	ファイルに現れた順に並んでいる。
+	@param[in]	nIndex		セクションのインデックス
+	@return セクション名
+*/
+std::string
+icDef::GetSectionName( int32_t nIndex ) const
+{
+	return m_SectionValue.GetSectionName( nIndex );
+}
+
 } // namespace ic
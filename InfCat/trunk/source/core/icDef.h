@@ -35,6 +35,21 @@ public:
 		@return 値
 	*/
 	std::string GetValue( const std::string& strSection, const std::string& strKey, int32_t nIndex );
+
+	//! セクションが幾つあるか
+	/*!
+		@return セクション数
+	*/
+	int32_t GetSectionCount( void ) const;
+
+	//! セクション名を取得する
+	/*!
+		ファイルに現れた順に並んでいる。 \n
+		[BG 1]のように空白を挟んだ名前は、1つの空白でつないだ名前になる。
+		@param[in]	nIndex		セクションのインデックス(0～GetSectionCount()-1)
+		@return セクション名
+	*/
+	std::string GetSectionName( int32_t nIndex ) const;
 private:
 	icSectionValue	m_SectionValue;		/*!< 項目 */
 };
@@ -0,0 +1,216 @@
+//! @file	icDrawVariant.cpp
+// 描画の種類(影や残像)
+
+#include "icCore.h"
+
+namespace ic {
+
+//! パレットのキャッシュの大きさの初期値
+#define IC_DRAWVARIANT_CACHE_COUNT (32)
+
+//! 差し替えるパレットのキャッシュ
+static Cat_PaletteEffectCache* gpCache = 0;
+
+//! コンストラクタ
+/*!
+	パレットを変えずに、半透明で描画する。
+*/
+icDrawVariant::icDrawVariant()
+	: m_eBlend( eBLEND_ALPHA )
+{
+	Cat_PaletteEffectParamInit( &m_param );
+}
+
+//! コンストラクタ
+/*!
+	@param[in]	param	パレットエフェクトのパラメータ
+	@param[in]	eBlend	ブレンドの方法
+*/
+icDrawVariant::icDrawVariant( const Cat_PaletteEffectParam& param, enumBlend eBlend )
+	: m_param( param )
+	, m_eBlend( eBlend )
+{
+}
+
+//! 単色で描画する(影やシルエット)
+/*!
+	@param[in]	nColor	色(0xBBGGRR)
+	@param[in]	nAlpha	アルファ(256で不透明)
+	@param[in]	eBlend	ブレンドの方法
+	@return	描画の種類
+*/
+icDrawVariant
+icDrawVariant::Solid( uint32_t nColor, uint32_t nAlpha, enumBlend eBlend )
+{
+	icDrawVariant rc;
+	rc.m_param.fSolid      = 1;
+	rc.m_param.nSolidColor = nColor & 0xFFFFFF;
+	rc.m_param.nAlpha      = nAlpha;
+	rc.m_eBlend            = eBlend;
+	return rc;
+}
+
+//! 色を乗算して描画する
+/*!
+	@param[in]	nColor	乗算する色(0xBBGGRR、0xFFFFFFで元の色)
+	@param[in]	nAlpha	アルファ(256で不透明)
+	@param[in]	eBlend	ブレンドの方法
+	@return	描画の種類
+*/
+icDrawVariant
+icDrawVariant::Tint( uint32_t nColor, uint32_t nAlpha, enumBlend eBlend )
+{
+	icDrawVariant rc;
+	for(uint32_t i = 0; i < 3; i++) {
+		// 255を等倍(256)にする
+		rc.m_param.nMul[i] = (int32_t)((((nColor >> (i * 8)) & 0xFF) * CAT_PALETTEEFFECT_UNIT + 127) / 255);
+	}
+	rc.m_param.nAlpha = nAlpha;
+	rc.m_eBlend       = eBlend;
+	return rc;
+}
+
+//! 薄くして描画する
+/*!
+	@param[in]	nAlpha	アルファ(256で不透明)
+	@param[in]	eBlend	ブレンドの方法
+	@return	描画の種類
+*/
+icDrawVariant
+icDrawVariant::Fade( uint32_t nAlpha, enumBlend eBlend )
+{
+	icDrawVariant rc;
+	rc.m_param.nAlpha = nAlpha;
+	rc.m_eBlend       = eBlend;
+	return rc;
+}
+
+//! アルファを設定する
+/*!
+	@param[in]	nAlpha	アルファ(256で不透明)
+*/
+void
+icDrawVariant::SetAlpha( uint32_t nAlpha )
+{
+	m_param.nAlpha = nAlpha;
+}
+
+//! アルファを取得する
+/*!
+	@return	アルファ(256で不透明)
+*/
+uint32_t
+icDrawVariant::GetAlpha( void ) const
+{
+	return m_param.nAlpha;
+}
+
+//! パレットエフェクトのパラメータを取得する
+/*!
+	@return	パレットエフェクトのパラメータ
+*/
+const Cat_PaletteEffectParam&
+icDrawVariant::GetParam( void ) const
+{
+	return m_param;
+}
+
+//! ブレンドの方法を取得する
+/*!
+	@return	ブレンドの方法
+*/
+icDrawVariant::enumBlend
+icDrawVariant::GetBlend( void ) const
+{
+	return m_eBlend;
+}
+
+//! ブレンドの方法を設定する
+/*!
+	Cat_RenderStateBlendFunc()で設定するので、前と同じなら何も積まれない。
+	@param[in]	eBlend	ブレンドの方法
+*/
+void
+icDrawVariant::SetBlend( enumBlend eBlend )
+{
+	switch(eBlend) {
+	case eBLEND_ADD:
+		Cat_RenderStateBlendFunc( GU_ADD, GU_SRC_ALPHA, GU_FIX, 0, 0xFFFFFF );
+		break;
+	case eBLEND_SUB:
+		Cat_RenderStateBlendFunc( GU_REVERSE_SUBTRACT, GU_SRC_ALPHA, GU_FIX, 0, 0xFFFFFF );
+		break;
+	default:
+		Cat_RenderStateBlendFunc( GU_ADD, GU_SRC_ALPHA, GU_ONE_MINUS_SRC_ALPHA, 0, 0 );
+		break;
+	}
+}
+
+//! パレットのキャッシュを作成する
+/*!
+	作成していなければ、最初の描画の時にIC_DRAWVARIANT_CACHE_COUNTの大きさで作られる。 \n
+	残像の数 * 同時に描画するパレットの数 だけあれば、毎フレーム作り直さずに済む。
+	@param[in]	nCount	保持するパレットの数
+	@return 正常終了時 true \n
+			失敗時 false
+*/
+bool
+icDrawVariant::CreateCache( uint32_t nCount )
+{
+	DestroyCache();
+	gpCache = Cat_PaletteEffectCacheCreate( nCount );
+	return gpCache != 0;
+}
+
+//! パレットのキャッシュを破棄する
+void
+icDrawVariant::DestroyCache( void )
+{
+	if(gpCache) {
+		Cat_PaletteEffectCacheDestroy( gpCache );
+		gpCache = 0;
+	}
+}
+
+//! パレットのキャッシュを取得する
+/*!
+	@return	キャッシュ。作成に失敗した場合は0が返る。
+*/
+Cat_PaletteEffectCache*
+icDrawVariant::GetCache( void )
+{
+	if(gpCache == 0) {
+		// 最初に使う時に用意する
+		gpCache = Cat_PaletteEffectCacheCreate( IC_DRAWVARIANT_CACHE_COUNT );
+	}
+	return gpCache;
+}
+
+//! フレームを進める
+/*!
+	1フレームに1回、Cat_RenderScreenUpdate()の後に呼ぶ。
+*/
+void
+icDrawVariant::Update( void )
+{
+	Cat_PaletteEffectCacheUpdate( gpCache );
+}
+
+//! キャッシュの統計情報を取得する
+/*!
+	@param[out]	pStatistics	統計情報
+*/
+void
+icDrawVariant::GetStatistics( Cat_PaletteEffectStatistics* pStatistics )
+{
+	if(pStatistics == 0) {
+		return;
+	}
+	if(gpCache == 0) {
+		memset( pStatistics, 0, sizeof(Cat_PaletteEffectStatistics) );
+		return;
+	}
+	Cat_PaletteEffectCacheGetStatistics( gpCache, pStatistics );
+}
+
+} // namespace ic
@@ -0,0 +1,134 @@
+//! @file	icDrawVariant.h
+// 描画の種類(影や残像)
+
+#ifndef INCL_CLASS_icDrawVariant
+#define INCL_CLASS_icDrawVariant
+
+#include "icCore.h"
+
+namespace ic {
+
+//! 描画の種類
+/*!
+	ピクセルデータはそのままで、パレットを差し替えて描画するためのパラメータとブレンドの方法。 \n
+	影(単色)、色付け、フェードを、色を変えたテクスチャを作らずに描画できる。 \n
+	差し替えるパレットは、全体で1つのキャッシュに保持される。
+*/
+class icDrawVariant {
+public:
+	//! ブレンドの方法
+	enum enumBlend {
+		eBLEND_ALPHA,		/*!< 半透明(通常の描画)	*/
+		eBLEND_ADD,			/*!< 加算				*/
+		eBLEND_SUB,			/*!< 減算				*/
+	};
+
+	//! コンストラクタ
+	/*!
+		パレットを変えずに、半透明で描画する。
+	*/
+	icDrawVariant();
+
+	//! コンストラクタ
+	/*!
+		@param[in]	param	パレットエフェクトのパラメータ
+		@param[in]	eBlend	ブレンドの方法
+	*/
+	icDrawVariant( const Cat_PaletteEffectParam& param, enumBlend eBlend );
+
+	//! 単色で描画する(影やシルエット)
+	/*!
+		@param[in]	nColor	色(0xBBGGRR)
+		@param[in]	nAlpha	アルファ(256で不透明)
+		@param[in]	eBlend	ブレンドの方法
+		@return	描画の種類
+	*/
+	static icDrawVariant Solid( uint32_t nColor, uint32_t nAlpha, enumBlend eBlend = eBLEND_ALPHA );
+
+	//! 色を乗算して描画する
+	/*!
+		@param[in]	nColor	乗算する色(0xBBGGRR、0xFFFFFFで元の色)
+		@param[in]	nAlpha	アルファ(256で不透明)
+		@param[in]	eBlend	ブレンドの方法
+		@return	描画の種類
+	*/
+	static icDrawVariant Tint( uint32_t nColor, uint32_t nAlpha, enumBlend eBlend = eBLEND_ALPHA );
+
+	//! 薄くして描画する
+	/*!
+		@param[in]	nAlpha	アルファ(256で不透明)
+		@param[in]	eBlend	ブレンドの方法
+		@return	描画の種類
+	*/
+	static icDrawVariant Fade( uint32_t nAlpha, enumBlend eBlend = eBLEND_ALPHA );
+
+	//! アルファを設定する
+	/*!
+		@param[in]	nAlpha	アルファ(256で不透明)
+	*/
+	void SetAlpha( uint32_t nAlpha );
+
+	//! アルファを取得する
+	/*!
+		@return	アルファ(256で不透明)
+	*/
+	uint32_t GetAlpha( void ) const;
+
+	//! パレットエフェクトのパラメータを取得する
+	/*!
+		@return	パレットエフェクトのパラメータ
+	*/
+	const Cat_PaletteEffectParam& GetParam( void ) const;
+
+	//! ブレンドの方法を取得する
+	/*!
+		@return	ブレンドの方法
+	*/
+	enumBlend GetBlend( void ) const;
+
+	//! ブレンドの方法を設定する
+	/*!
+		Cat_RenderStateBlendFunc()で設定するので、前と同じなら何も積まれない。
+		@param[in]	eBlend	ブレンドの方法
+	*/
+	static void SetBlend( enumBlend eBlend );
+
+	//! パレットのキャッシュを作成する
+	/*!
+		作成していなければ、最初の描画の時にIC_DRAWVARIANT_CACHE_COUNTの大きさで作られる。 \n
+		残像の数 * 同時に描画するパレットの数 だけあれば、毎フレーム作り直さずに済む。
+		@param[in]	nCount	保持するパレットの数
+		@return 正常終了時 true \n
+				失敗時 false
+	*/
+	static bool CreateCache( uint32_t nCount );
+
+	//! パレットのキャッシュを破棄する
+	static void DestroyCache( void );
+
+	//! パレットのキャッシュを取得する
+	/*!
+		@return	キャッシュ。作成に失敗した場合は0が返る。
+	*/
+	static Cat_PaletteEffectCache* GetCache( void );
+
+	//! フレームを進める
+	/*!
+		1フレームに1回、Cat_RenderScreenUpdate()の後に呼ぶ。
+	*/
+	static void Update( void );
+
+	//! キャッシュの統計情報を取得する
+	/*!
+		@param[out]	pStatistics	統計情報
+	*/
+	static void GetStatistics( Cat_PaletteEffectStatistics* pStatistics );
+
+private:
+	Cat_PaletteEffectParam	m_param;		/*!< パレットエフェクトのパラメータ	*/
+	enumBlend				m_eBlend;		/*!< ブレンドの方法					*/
+};
+
+} // namespace ic
+
+#endif // INCL_CLASS_icDrawVariant
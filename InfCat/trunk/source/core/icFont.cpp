@@ -0,0 +1,657 @@
+//! @file	icFont.cpp
+// フォント
+
+#include "icCore.h"
+#include "Cat_StreamMemory.h"
+#include "Cat_SpriteTransform.h"
+#include <ctype.h>
+#include <stdlib.h>
+
+namespace ic {
+
+//! フォントファイルのヘッダ
+typedef struct {
+/*   0 */	char		szSignature[12];		/*!< "ElecbyteFnt"				*/
+/*  12 */	uint8_t		anVersion[4];			/*!< バージョン					*/
+/*  16 */	uint32_t	nImageOffset;			/*!< PCXイメージの位置			*/
+/*  20 */	uint32_t	nImageSize;				/*!< PCXイメージのサイズ		*/
+/*  24 */	uint32_t	nTextOffset;			/*!< 文字の表の位置				*/
+/*  28 */	uint32_t	nTextSize;				/*!< 文字の表のサイズ			*/
+/*  32 */	char		szComment[32];			/*!< コメント					*/
+} __attribute__((packed)) icFontHeader;
+
+//! ストリームの一部分をメモリストリームにする
+/*!
+	@param[in]	pStream	ストリーム
+	@param[in]	nOffset	位置
+	@param[in]	nSize	サイズ
+	@return	メモリストリーム \n
+			失敗した場合は、0が返る
+*/
+static Cat_Stream*
+OpenBlock( Cat_Stream* pStream, uint32_t nOffset, uint32_t nSize )
+{
+	if((nSize == 0) || (Cat_StreamSeek( pStream, nOffset ) < 0)) {
+		return 0;
+	}
+	void* pvData = CAT_MALLOC( nSize );
+	if(pvData == 0) {
+		return 0;
+	}
+	if(Cat_StreamRead( pStream, pvData, nSize ) != nSize) {
+		CAT_FREE( pvData );
+		return 0;
+	}
+	Cat_Stream* pBlock = Cat_StreamMemoryReadOpen( pvData, nSize, 1 );
+	if(pBlock == 0) {
+		CAT_FREE( pvData );
+	}
+	return pBlock;
+}
+
+//! 1行を区切る
+/*!
+	@param[in]	strLine			行
+	@param[in]	pszSeparator	区切文字
+	@return	区切った文字列
+*/
+static std::vector<std::string>
+Split( const std::string& strLine, const char* pszSeparator )
+{
+	std::vector<std::string> token;
+	std::string::size_type nStart = strLine.find_first_not_of( pszSeparator );
+	while(nStart != std::string::npos) {
+		const std::string::size_type nEnd = strLine.find_first_of( pszSeparator, nStart );
+		token.push_back( strLine.substr( nStart, (nEnd == std::string::npos) ? std::string::npos : nEnd - nStart ) );
+		nStart = strLine.find_first_not_of( pszSeparator, nEnd );
+	}
+	return token;
+}
+
+//! 実装
+class icFontImpl {
+public:
+	//! 文字
+	struct Glyph {
+		bool		fValid;			/*!< 定義されているかどうか				*/
+		int16_t		nSrcX;			/*!< PCXイメージでの左端				*/
+		int16_t		nWidth;			/*!< 横幅								*/
+		int16_t		u;				/*!< アトラスでの左端					*/
+		int16_t		v;				/*!< アトラスでの上端					*/
+	};
+
+	//! 並べた結果
+	struct Layout {
+		std::vector<Cat_SpriteInstance>	glyph;		/*!< 文字(先頭の文字の左端が0)	*/
+		int32_t		nWidth;			/*!< 横幅								*/
+		uint32_t	nLastUse;		/*!< 最後に使った時の通し番号			*/
+	};
+
+	//! コンストラクタ
+	/*!
+		@param[in]	nCacheCount		並べた結果をキャッシュする文字列の数
+	*/
+	icFontImpl( uint32_t nCacheCount )
+		: m_pAtlas( 0 )
+		, m_nCacheCount( nCacheCount ? nCacheCount : 1 )
+		, m_nUse( 0 )
+	{
+		Clear();
+		ResetStatistics();
+	}
+
+	//! デストラクタ
+	~icFontImpl() {
+		Release();
+	}
+
+	//! フォントファイルを読み込む
+	/*!
+		@param[in]	pStream	ストリーム
+		@return 成功した場合true \n
+				失敗したらfalseを返す
+	*/
+	bool Load( Cat_Stream* pStream ) {
+		Release();
+
+		icFontHeader header;
+		if((pStream == 0)
+			|| (Cat_StreamSeek( pStream, 0 ) < 0)
+			|| (Cat_StreamRead( pStream, &header, sizeof(header) ) != sizeof(header))
+			|| (memcmp( header.szSignature, "ElecbyteFnt", 11 ) != 0)) {
+			return false;
+		}
+
+		// 文字の表
+		Cat_Stream* pText = OpenBlock( pStream, header.nTextOffset, header.nTextSize );
+		if(pText == 0) {
+			return false;
+		}
+		const bool fText = LoadText( pText );
+		Cat_StreamClose( pText );
+		if(!fText) {
+			Release();
+			return false;
+		}
+
+		// PCXイメージ(512を超える幅でも縮小されないように分割させ、パレット番号を変えないように4bitにはしない)
+		Cat_Stream* pImage = OpenBlock( pStream, header.nImageOffset, header.nImageSize );
+		if(pImage == 0) {
+			Release();
+			return false;
+		}
+		const uint32_t nOption = Cat_TextureGetOption();
+		Cat_TextureSetOption( CAT_TEXTURE_OPTION_TILE );
+		Cat_Texture* pTexture = Cat_LoadImage( pImage );
+		Cat_StreamClose( pImage );
+		bool fResult = false;
+		if(pTexture && (pTexture->ePixelFormat == FORMAT_PIXEL_CLUT8) && pTexture->pPalette) {
+			for(uint32_t i = 0; i < 256; i++) {
+				m_anColor[i] = Cat_PaletteGetColor( pTexture->pPalette, i );
+			}
+			fResult = CreateAtlas( pTexture );
+		}
+		Cat_TextureSetOption( nOption );
+		if(pTexture) {
+			Cat_TextureRelease( pTexture );
+		}
+		if(!fResult) {
+			Release();
+		}
+		return fResult;
+	}
+
+	//! フォントを破棄する
+	void Release( void ) {
+		if(m_pAtlas) {
+			Cat_TextureRelease( m_pAtlas );
+			m_pAtlas = 0;
+		}
+		for(uint32_t i = 0; i < m_palette.size(); i++) {
+			if(m_palette[i]) {
+				Cat_PaletteRelease( m_palette[i] );
+			}
+		}
+		m_palette.clear();
+		m_queue.clear();
+		m_order.clear();
+		m_cache.clear();
+		Clear();
+	}
+
+	//! 文字の高さを取得する
+	/*!
+		@return	高さ(ドット単位)
+	*/
+	uint32_t GetHeight( void ) const {
+		return m_nHeight;
+	}
+
+	//! パレットのバンク数を取得する
+	/*!
+		@return	バンク数
+	*/
+	uint32_t GetBankCount( void ) const {
+		return m_palette.size();
+	}
+
+	//! アトラスを取得する
+	/*!
+		@return	アトラスのテクスチャ
+	*/
+	Cat_Texture* GetAtlas( void ) {
+		return m_pAtlas;
+	}
+
+	//! 文字列の横幅を取得する
+	/*!
+		@param[in]	str		文字列
+		@return	横幅(ドット単位)
+	*/
+	int32_t GetTextWidth( const std::string& str ) {
+		return GetLayout( str ).nWidth;
+	}
+
+	//! 文字列を溜める
+	/*!
+		@param[in]	x		描画位置X
+		@param[in]	y		描画位置Y
+		@param[in]	str		文字列
+		@param[in]	nBank	パレットのバンク
+		@param[in]	eAlign	揃え方
+		@return	溜めた文字数
+	*/
+	uint32_t Draw( float x, float y, const std::string& str, uint32_t nBank, icFont::enumAlign eAlign ) {
+		if((m_pAtlas == 0) || str.empty()) {
+			return 0;
+		}
+		if(nBank >= m_palette.size()) {
+			nBank = 0;
+		}
+		const Layout& layout = GetLayout( str );
+		if(eAlign == icFont::eALIGN_CENTER) {
+			x -= (float)(layout.nWidth / 2);
+		} else if(eAlign == icFont::eALIGN_RIGHT) {
+			x -= (float)layout.nWidth;
+		}
+
+		std::vector<Cat_SpriteInstance>& queue = m_queue[nBank];
+		if(queue.empty()) {
+			m_order.push_back( nBank );
+		}
+		for(std::vector<Cat_SpriteInstance>::const_iterator p = layout.glyph.begin(); p != layout.glyph.end(); ++p) {
+			queue.push_back( *p );
+			queue.back().x += x;
+			queue.back().y += y;
+		}
+		m_statistics.nTextCount++;
+		m_statistics.nGlyphCount += layout.glyph.size();
+		return layout.glyph.size();
+	}
+
+	//! 溜めた文字列を描画する
+	/*!
+		@return	Cat_SpriteTransformDraw()の回数
+	*/
+	uint32_t Flush( void ) {
+		uint32_t nBatch = 0;
+
+		m_statistics.nFlushCount++;
+		for(std::vector<uint32_t>::iterator p = m_order.begin(); p != m_order.end(); ++p) {
+			std::vector<Cat_SpriteInstance>& queue = m_queue[*p];
+			Cat_TextureSetTexturePalette( m_pAtlas, GetPalette( *p ) );
+			const uint32_t nDraw = Cat_SpriteTransformDraw( &queue[0], queue.size() );
+			nBatch += (nDraw + CAT_SPRITETRANSFORM_CHUNK - 1) / CAT_SPRITETRANSFORM_CHUNK;
+			m_statistics.nDropCount += queue.size() - nDraw;
+			queue.clear();
+		}
+		m_order.clear();
+		m_statistics.nBatchCount += nBatch;
+		return nBatch;
+	}
+
+	//! 統計情報を取得する
+	/*!
+		@param[out]	pStatistics		統計情報
+	*/
+	void GetStatistics( icFont::Statistics* pStatistics ) {
+		*pStatistics = m_statistics;
+	}
+
+	//! 統計情報をクリアする
+	void ResetStatistics( void ) {
+		memset( &m_statistics, 0, sizeof(m_statistics) );
+	}
+private:
+	//! 読み込んだ設定を初期値に戻す
+	void Clear( void ) {
+		memset( m_glyph, 0, sizeof(m_glyph) );
+		m_nWidth    = 0;
+		m_nHeight   = 0;
+		m_nSpacingX = 0;
+		m_nOffsetX  = 0;
+		m_nOffsetY  = 0;
+		m_nColors   = 256;
+	}
+
+	//! 文字の表を読み込む
+	/*!
+		[Def]のSize、Spacing、Colors、Offset、Typeと、[Map]の文字を読み込む。 \n
+		[Map]の1行は、Fixedなら「文字」、Variableなら「文字 左端 横幅」。 \n
+		文字は1文字か、0x41のような16進数で書く。
+		@param[in]	pStream	ストリーム
+		@return 成功した場合true \n
+				失敗したらfalseを返す
+	*/
+	bool LoadText( Cat_Stream* pStream ) {
+		icTextReader reader( pStream );
+		std::string strSection;
+		bool fFixed = true;
+		int32_t nIndex = 0;
+
+		while(!reader.eof()) {
+			std::string strLine = reader.ReadLine();
+			const std::string::size_type nComment = strLine.find( ';' );
+			if(nComment != std::string::npos) {
+				strLine.erase( nComment );
+			}
+			const std::string::size_type nStart = strLine.find_first_not_of( " \t" );
+			if(nStart == std::string::npos) {
+				continue;
+			}
+			if(strLine[nStart] == '[') {
+				const std::string::size_type nEnd = strLine.find( ']', nStart );
+				strSection = strLine.substr( nStart + 1, (nEnd == std::string::npos) ? std::string::npos : nEnd - nStart - 1 );
+				for(uint32_t i = 0; i < strSection.size(); i++) {
+					strSection[i] = tolower( strSection[i] );
+				}
+				continue;
+			}
+
+			if(strSection == "def") {
+				std::vector<std::string> token = Split( strLine, " \t=," );
+				if(token.size() < 2) {
+					continue;
+				}
+				std::string strKey = token[0];
+				for(uint32_t i = 0; i < strKey.size(); i++) {
+					strKey[i] = tolower( strKey[i] );
+				}
+				const int32_t n0 = atoi( token[1].c_str() );
+				const int32_t n1 = (token.size() > 2) ? atoi( token[2].c_str() ) : 0;
+				if(strKey == "size") {
+					m_nWidth  = n0;
+					m_nHeight = n1;
+				} else if(strKey == "spacing") {
+					m_nSpacingX = n0;
+				} else if(strKey == "colors") {
+					m_nColors = ((n0 > 0) && (n0 <= 256)) ? n0 : 256;
+				} else if(strKey == "offset") {
+					m_nOffsetX = n0;
+					m_nOffsetY = n1;
+				} else if(strKey == "type") {
+					fFixed = (tolower( token[1][0] ) != 'v');
+				}
+			} else if(strSection == "map") {
+				std::vector<std::string> token = Split( strLine, " \t" );
+				uint32_t nChar;
+				if(token[0].size() == 1) {
+					nChar = (uint8_t)token[0][0];
+				} else if((token[0].size() > 2) && (token[0][0] == '0') && (tolower( token[0][1] ) == 'x')) {
+					nChar = strtoul( token[0].c_str() + 2, 0, 16 );
+				} else {
+					nIndex++;
+					continue;
+				}
+				if(nChar < 256) {
+					Glyph& glyph = m_glyph[nChar];
+					if(fFixed) {
+						glyph.nSrcX  = (int16_t)(nIndex * m_nWidth);
+						glyph.nWidth = (int16_t)m_nWidth;
+					} else if(token.size() >= 3) {
+						glyph.nSrcX  = (int16_t)atoi( token[1].c_str() );
+						glyph.nWidth = (int16_t)atoi( token[2].c_str() );
+					}
+					glyph.fValid = glyph.nWidth > 0;
+				}
+				nIndex++;
+			}
+		}
+		return (m_nWidth > 0) && (m_nHeight > 0);
+	}
+
+	//! 文字をアトラスに並べる
+	/*!
+		1ドットずつ間を空けて、左上から行ごとに詰める。
+		@param[in]	nAtlasWidth		アトラスの横幅
+		@return	使った高さ \n
+				横幅に収まらない文字があれば0を返す
+	*/
+	uint32_t Pack( uint32_t nAtlasWidth ) {
+		uint32_t u = 0;
+		uint32_t v = 0;
+		for(uint32_t i = 0; i < 256; i++) {
+			Glyph& glyph = m_glyph[i];
+			if(!glyph.fValid) {
+				continue;
+			}
+			if((uint32_t)glyph.nWidth > nAtlasWidth) {
+				return 0;
+			}
+			if(u + glyph.nWidth > nAtlasWidth) {
+				u = 0;
+				v += m_nHeight + 1;
+			}
+			glyph.u = (int16_t)u;
+			glyph.v = (int16_t)v;
+			u += glyph.nWidth + 1;
+		}
+		return v + m_nHeight;
+	}
+
+	//! アトラスを作る
+	/*!
+		@param[in]	pImage	PCXイメージ
+		@return 成功した場合true \n
+				失敗したらfalseを返す
+	*/
+	bool CreateAtlas( Cat_Texture* pImage ) {
+		// なるべく正方形に近い大きさにする
+		uint32_t nAtlasWidth;
+		uint32_t nUsed = 0;
+		for(nAtlasWidth = 16; nAtlasWidth <= 512; nAtlasWidth *= 2) {
+			nUsed = Pack( nAtlasWidth );
+			if((nUsed != 0) && ((nUsed <= nAtlasWidth) || (nAtlasWidth == 512))) {
+				break;
+			}
+		}
+		uint32_t nAtlasHeight = 1;
+		while(nAtlasHeight < nUsed) {
+			nAtlasHeight *= 2;
+		}
+		if((nUsed == 0) || (nAtlasHeight > 512)) {
+			return false;
+		}
+
+		uint8_t* pbAtlas = (uint8_t*)CAT_MALLOC( nAtlasWidth * nAtlasHeight );
+		if(pbAtlas == 0) {
+			return false;
+		}
+		memset( pbAtlas, 0, nAtlasWidth * nAtlasHeight );
+		for(uint32_t i = 0; i < 256; i++) {
+			Glyph& glyph = m_glyph[i];
+			if(glyph.fValid
+				&& (Cat_TextureGetRegion( pImage, glyph.nSrcX, 0, glyph.nWidth, m_nHeight,
+					&pbAtlas[glyph.v * nAtlasWidth + glyph.u], nAtlasWidth, CAT_TEXTURE_REGION_RAW ) < 0)) {
+				// PCXイメージからはみ出している
+				glyph.fValid = false;
+			}
+		}
+
+		// 色のバンク。パレットは必要になった時に作る
+		m_palette.resize( 256 / m_nColors, 0 );
+		m_queue.resize( m_palette.size() );
+		m_pAtlas = Cat_TextureCreate( nAtlasWidth, nAtlasHeight, nAtlasWidth, pbAtlas, FORMAT_PIXEL_CLUT8, GetPalette( 0 ) );
+		CAT_FREE( pbAtlas );
+		return m_pAtlas != 0;
+	}
+
+	//! バンクのパレットを取得する
+	/*!
+		パレットの最後のColors色をバンクの色に差し替える。 \n
+		バンクnの色は、最後から数えてn番目のColors色になる。パレット番号0は透明にする。
+		@param[in]	nBank	バンク
+		@return	パレット
+	*/
+	Cat_Palette* GetPalette( uint32_t nBank ) {
+		if(m_palette[nBank] == 0) {
+			uint32_t anColor[256];
+			memcpy( anColor, m_anColor, sizeof(anColor) );
+			memcpy( &anColor[256 - m_nColors], &m_anColor[256 - m_nColors * (nBank + 1)], m_nColors * sizeof(uint32_t) );
+			anColor[0] &= 0x00FFFFFF;
+			m_palette[nBank] = Cat_PaletteCreate( FORMAT_PALETTE_8888, 256, anColor );
+		}
+		return m_palette[nBank];
+	}
+
+	//! 並べた結果を取得する
+	/*!
+		キャッシュに無ければ並べて、一番長く使っていないものと入れ替える。
+		@param[in]	str		文字列
+		@return	並べた結果
+	*/
+	const Layout& GetLayout( const std::string& str ) {
+		std::map<std::string, Layout>::iterator p = m_cache.find( str );
+		if(p != m_cache.end()) {
+			m_statistics.nCacheHitCount++;
+			p->second.nLastUse = ++m_nUse;
+			return p->second;
+		}
+		m_statistics.nCacheMissCount++;
+		if(m_cache.size() >= m_nCacheCount) {
+			std::map<std::string, Layout>::iterator pOldest = m_cache.begin();
+			for(std::map<std::string, Layout>::iterator q = m_cache.begin(); q != m_cache.end(); ++q) {
+				if(q->second.nLastUse < pOldest->second.nLastUse) {
+					pOldest = q;
+				}
+			}
+			m_cache.erase( pOldest );
+		}
+
+		Layout& layout = m_cache[str];
+		layout.nLastUse = ++m_nUse;
+		Cat_SpriteInstance instance;
+		memset( &instance, 0, sizeof(instance) );
+		instance.fScaleX = 1.0f;
+		instance.fScaleY = 1.0f;
+		instance.y       = (float)m_nOffsetY;
+		instance.nHeight = (int16_t)m_nHeight;
+		int32_t x = 0;
+		for(uint32_t i = 0; i < str.size(); i++) {
+			const Glyph& glyph = m_glyph[(uint8_t)str[i]];
+			if(glyph.fValid) {
+				instance.x      = (float)(x + m_nOffsetX);
+				instance.u      = glyph.u;
+				instance.v      = glyph.v;
+				instance.nWidth = glyph.nWidth;
+				layout.glyph.push_back( instance );
+				x += glyph.nWidth + m_nSpacingX;
+			} else {
+				// 無い文字は空白にする
+				x += m_nWidth + m_nSpacingX;
+			}
+		}
+		layout.nWidth = str.empty() ? 0 : x - m_nSpacingX;
+		return layout;
+	}
+
+	Glyph			m_glyph[256];			/*!< 文字								*/
+	int32_t			m_nWidth;				/*!< Sizeの横幅							*/
+	int32_t			m_nHeight;				/*!< Sizeの高さ							*/
+	int32_t			m_nSpacingX;			/*!< 文字の間隔							*/
+	int32_t			m_nOffsetX;				/*!< 描画オフセットX					*/
+	int32_t			m_nOffsetY;				/*!< 描画オフセットY					*/
+	uint32_t		m_nColors;				/*!< 1つのバンクの色数					*/
+	uint32_t		m_anColor[256];			/*!< PCXイメージのパレット				*/
+	Cat_Texture*	m_pAtlas;				/*!< アトラス							*/
+	std::vector<Cat_Palette*>	m_palette;	/*!< バンクのパレット(作っていなければ0)	*/
+	std::vector<std::vector<Cat_SpriteInstance> >	m_queue;	/*!< バンクごとに溜めた文字	*/
+	std::vector<uint32_t>		m_order;	/*!< 文字を溜めたバンク(最初に使った順)	*/
+	std::map<std::string, Layout>	m_cache;	/*!< 並べた結果のキャッシュ			*/
+	uint32_t		m_nCacheCount;			/*!< キャッシュする文字列の数			*/
+	uint32_t		m_nUse;					/*!< 使った時の通し番号					*/
+	icFont::Statistics	m_statistics;		/*!< 統計情報							*/
+};
+
+//! コンストラクタ
+/*!
+	@param[in]	nCacheCount		並べた結果をキャッシュする文字列の数
+*/
+icFont::icFont( uint32_t nCacheCount )
+	: m_impl( new icFontImpl( nCacheCount ) )
+{
+}
+
+//! フォントファイルを読み込む
+/*!
+	@param[in]	pStream	ストリーム
+	@return 成功した場合true \n
+			失敗したらfalseを返す
+*/
+bool
+icFont::Load( Cat_Stream* pStream )
+{
+	return m_impl->Load( pStream );
+}
+
+//! フォントを破棄する
+void
+icFont::Release( void )
+{
+	m_impl->Release();
+}
+
+//! 文字の高さを取得する
+/*!
+	@return	高さ(ドット単位)
+*/
+uint32_t
+icFont::GetHeight( void ) const
+{
+	return m_impl->GetHeight();
+}
+
+//! パレットのバンク数を取得する
+/*!
+	@return	バンク数
+*/
+uint32_t
+icFont::GetBankCount( void ) const
+{
+	return m_impl->GetBankCount();
+}
+
+//! アトラスを取得する
+/*!
+	@return	アトラスのテクスチャ(読み込んでいなければ0)
+*/
+Cat_Texture*
+icFont::GetAtlas( void )
+{
+	return m_impl->GetAtlas();
+}
+
+//! 文字列の横幅を取得する
+/*!
+	@param[in]	str		文字列
+	@return	横幅(ドット単位)
+*/
+int32_t
+icFont::GetTextWidth( const std::string& str )
+{
+	return m_impl->GetTextWidth( str );
+}
+
+//! 文字列を溜める
+/*!
+	@param[in]	x		描画位置X
+	@param[in]	y		描画位置Y(文字の上端)
+	@param[in]	str		文字列
+	@param[in]	nBank	パレットのバンク
+	@param[in]	eAlign	揃え方
+	@return	溜めた文字数
+*/
+uint32_t
+icFont::Draw( float x, float y, const std::string& str, uint32_t nBank, enumAlign eAlign )
+{
+	return m_impl->Draw( x, y, str, nBank, eAlign );
+}
+
+//! 溜めた文字列を描画する
+/*!
+	@return	Cat_SpriteTransformDraw()の回数
+*/
+uint32_t
+icFont::Flush( void )
+{
+	return m_impl->Flush();
+}
+
+//! 統計情報を取得する
+/*!
+	@param[out]	pStatistics		統計情報
+*/
+void
+icFont::GetStatistics( Statistics* pStatistics )
+{
+	m_impl->GetStatistics( pStatistics );
+}
+
+//! 統計情報をクリアする
+void
+icFont::ResetStatistics( void )
+{
+	m_impl->ResetStatistics();
+}
+
+} // namespace ic
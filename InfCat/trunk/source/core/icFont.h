@@ -0,0 +1,115 @@
+//! @file	icFont.h
+// フォント
+
+#ifndef INCL_CLASS_icFont
+#define INCL_CLASS_icFont
+
+#include "icCore.h"
+
+namespace ic {
+
+//! フォント
+/*!
+	MUGENのフォントファイル(.fnt、PCXイメージと文字の表)を読み込む。 \n
+	文字はPCXから切り出して1枚のアトラスに詰め直し、色の違いはパレットのバンクで描き分ける。 \n
+	Draw()は文字列を並べた結果を溜めておくだけで、Flush()でバンクごとに1回の描画にまとめる。 \n
+	並べた結果は文字列ごとにキャッシュするので、変わらない文字列は並べ直さない。
+*/
+class icFont : boost::noncopyable {
+public:
+	//! 揃え方
+	enum enumAlign {
+		eALIGN_LEFT,			/*!< 左揃え(xが左端)		*/
+		eALIGN_CENTER,			/*!< 中央揃え(xが中央)		*/
+		eALIGN_RIGHT,			/*!< 右揃え(xが右端)		*/
+	};
+
+	//! 統計情報
+	struct Statistics {
+		uint32_t	nTextCount;			/*!< Draw()した文字列の数						*/
+		uint32_t	nGlyphCount;		/*!< 溜めた文字数								*/
+		uint32_t	nCacheHitCount;		/*!< 並べた結果がキャッシュにあった回数			*/
+		uint32_t	nCacheMissCount;	/*!< 文字列を並べ直した回数						*/
+		uint32_t	nFlushCount;		/*!< Flush()の回数								*/
+		uint32_t	nBatchCount;		/*!< Cat_SpriteTransformDraw()の回数			*/
+		uint32_t	nDropCount;			/*!< 描画パケットに空きが無く描画しなかった文字数	*/
+	};
+
+	//! コンストラクタ
+	/*!
+		@param[in]	nCacheCount		並べた結果をキャッシュする文字列の数
+	*/
+	icFont( uint32_t nCacheCount = 64 );
+
+	//! フォントファイルを読み込む
+	/*!
+		@param[in]	pStream	ストリーム
+		@return 成功した場合true \n
+				失敗したらfalseを返す
+	*/
+	bool Load( Cat_Stream* pStream );
+
+	//! フォントを破棄する
+	void Release( void );
+
+	//! 文字の高さを取得する
+	/*!
+		@return	高さ(ドット単位)
+	*/
+	uint32_t GetHeight( void ) const;
+
+	//! パレットのバンク数を取得する
+	/*!
+		@return	バンク数
+	*/
+	uint32_t GetBankCount( void ) const;
+
+	//! アトラスを取得する
+	/*!
+		@return	アトラスのテクスチャ(読み込んでいなければ0)
+	*/
+	Cat_Texture* GetAtlas( void );
+
+	//! 文字列の横幅を取得する
+	/*!
+		@param[in]	str		文字列
+		@return	横幅(ドット単位)
+	*/
+	int32_t GetTextWidth( const std::string& str );
+
+	//! 文字列を溜める
+	/*!
+		描画はFlush()でまとめて行われる。
+		@param[in]	x		描画位置X
+		@param[in]	y		描画位置Y(文字の上端)
+		@param[in]	str		文字列
+		@param[in]	nBank	パレットのバンク(0～GetBankCount()-1)
+		@param[in]	eAlign	揃え方
+		@return	溜めた文字数
+	*/
+	uint32_t Draw( float x, float y, const std::string& str, uint32_t nBank = 0, enumAlign eAlign = eALIGN_LEFT );
+
+	//! 溜めた文字列を描画する
+	/*!
+		Cat_RenderBegin()とCat_RenderEnd()の間で呼ぶ。 \n
+		バンクごとにアトラスとパレットを設定して、最初に使った順に描画する。ブレンドは設定しない。
+		@return	Cat_SpriteTransformDraw()の回数
+	*/
+	uint32_t Flush( void );
+
+	//! 統計情報を取得する
+	/*!
+		@param[out]	pStatistics		統計情報
+	*/
+	void GetStatistics( Statistics* pStatistics );
+
+	//! 統計情報をクリアする
+	void ResetStatistics( void );
+
+private:
+	boost::shared_ptr<class icFontImpl>	m_impl;		/*!< 実装	*/
+};
+
+} // namespace ic
+
+#endif // INCL_CLASS_icFont
@@ -0,0 +1,410 @@
+//! @file	icHud.cpp
+// HUD(体力ゲージ、パワーゲージ、タイマー、顔グラなど)
+
+#include "icCore.h"
+#include "Cat_SpriteTransform.h"
+#include <math.h>
+
+namespace ic {
+
+//! 描画先で部品の間に空ける隙間(ドット単位)
+#define IC_HUD_GAP (1)
+
+//! 実装
+class icHudImpl {
+public:
+	//! 部品
+	struct Element {
+		icHudElement*	pElement;		/*!< 部品								*/
+		float			x;				/*!< 画面での左上の位置X				*/
+		float			y;				/*!< 画面での左上の位置Y				*/
+		int32_t			nWidth;			/*!< 横幅								*/
+		int32_t			nHeight;		/*!< 高さ								*/
+		bool			fSlot;			/*!< 描画先に場所があるかどうか			*/
+		int16_t			u;				/*!< 描画先での左端						*/
+		int16_t			v;				/*!< 描画先での上端						*/
+		bool			fValid;			/*!< 描画先に描いた結果があるかどうか	*/
+		uint32_t		nKey;			/*!< 描いた時のGetKey()の値				*/
+	};
+
+	//! コンストラクタ
+	icHudImpl()
+		: m_fCache( true )
+		, m_pvTarget( 0 )
+		, m_nFrame( 0 )
+		, m_fFrame( false )
+		, m_nOverflowCount( 0 )
+	{
+		Clear();
+		ResetStatistics();
+	}
+
+	//! 部品を追加する
+	/*!
+		@param[in]	pElement	部品
+		@param[in]	x			画面での左上の位置X
+		@param[in]	y			画面での左上の位置Y
+		@param[in]	nWidth		横幅
+		@param[in]	nHeight		高さ
+		@return	部品の番号
+	*/
+	uint32_t Add( icHudElement* pElement, float x, float y, uint32_t nWidth, uint32_t nHeight ) {
+		Element element;
+		element.pElement = pElement;
+		element.x        = x;
+		element.y        = y;
+		element.nWidth   = (int32_t)nWidth;
+		element.nHeight  = (int32_t)nHeight;
+		element.fSlot    = false;
+		element.u        = 0;
+		element.v        = 0;
+		element.fValid   = false;
+		element.nKey     = 0;
+
+		// 描画先の左上から、高さの揃った棚に詰める
+		if((element.nWidth > 0) && (element.nHeight > 0)
+			&& (element.nWidth <= CAT_RENDER_TARGET_WIDTH) && (element.nHeight <= CAT_RENDER_TARGET_HEIGHT)) {
+			if(m_nShelfX + element.nWidth > CAT_RENDER_TARGET_WIDTH) {
+				m_nShelfX = 0;
+				m_nShelfY += m_nShelfHeight + IC_HUD_GAP;
+				m_nShelfHeight = 0;
+			}
+			if(m_nShelfY + element.nHeight <= CAT_RENDER_TARGET_HEIGHT) {
+				element.fSlot = true;
+				element.u     = (int16_t)m_nShelfX;
+				element.v     = (int16_t)m_nShelfY;
+				m_nShelfX += element.nWidth + IC_HUD_GAP;
+				m_nShelfHeight = std::max<int32_t>( m_nShelfHeight, element.nHeight );
+			}
+		}
+		m_element.push_back( element );
+		return m_element.size() - 1;
+	}
+
+	//! 部品を全て取り除く
+	void Clear( void ) {
+		m_element.clear();
+		m_nShelfX      = 0;
+		m_nShelfY      = 0;
+		m_nShelfHeight = 0;
+	}
+
+	//! 部品の数を取得する
+	/*!
+		@return	部品の数
+	*/
+	uint32_t GetCount( void ) const {
+		return m_element.size();
+	}
+
+	//! 部品の位置を変える
+	/*!
+		@param[in]	nNo		部品の番号
+		@param[in]	x		画面での左上の位置X
+		@param[in]	y		画面での左上の位置Y
+	*/
+	void SetPosition( uint32_t nNo, float x, float y ) {
+		if(nNo < m_element.size()) {
+			m_element[nNo].x = x;
+			m_element[nNo].y = y;
+		}
+	}
+
+	//! 描画先に残すかどうかを設定する
+	/*!
+		@param[in]	fCache	残す場合はtrue
+	*/
+	void SetCache( bool fCache ) {
+		m_fCache = fCache;
+		Invalidate();
+	}
+
+	//! 描画先に残した結果を捨てる
+	void Invalidate( void ) {
+		for(std::vector<Element>::iterator p = m_element.begin(); p != m_element.end(); ++p) {
+			p->fValid = false;
+		}
+	}
+
+	//! 描画する
+	/*!
+		@return	描画先に描き直した部品数
+	*/
+	uint32_t Draw( void ) {
+		// 5650にはアルファが無く、部品の透明な所まで上書きしてしまうので、描画先を使わずにそのまま描画する
+		const bool fCache = m_fCache && (Cat_RenderGetFormat() != GU_PSM_5650);
+		void* pvTarget = fCache ? Cat_RenderGetTarget() : 0;
+
+		// 描き直した描画パケットが捨てられたかもしれない場合は、残した結果を当てにしない
+		Cat_RenderListStatistics list;
+		Cat_RenderGetListStatistics( &list );
+		const uint32_t nFrame = Cat_RenderGetFrame();
+		if((pvTarget != m_pvTarget) || (list.nOverflowCount != m_nOverflowCount) || (m_fFrame && (nFrame == m_nFrame))) {
+			Invalidate();
+			m_statistics.nInvalidateCount++;
+		}
+		m_pvTarget = pvTarget;
+		m_nFrame   = nFrame;
+		m_fFrame   = true;
+
+		const uint32_t nRedraw = pvTarget ? Redraw() : 0;
+
+		// 画面へは追加した順に描く。描画先にある部品が続いている間はまとめる
+		uint32_t nStart = 0;
+		for(uint32_t i = 0; i < m_element.size(); i++) {
+			Element& element = m_element[i];
+			if(!element.fValid) {
+				DrawCache( nStart, i );
+				nStart = i + 1;
+				element.pElement->Draw( element.x, element.y );
+				m_statistics.nDirectCount++;
+			}
+		}
+		DrawCache( nStart, m_element.size() );
+
+		Cat_RenderGetListStatistics( &list );
+		m_nOverflowCount = list.nOverflowCount;
+		m_statistics.nDrawCount++;
+		m_statistics.nElementCount += m_element.size();
+		m_statistics.nRedrawCount  += nRedraw;
+		return nRedraw;
+	}
+
+	//! 統計情報を取得する
+	/*!
+		@param[out]	pStatistics		統計情報
+	*/
+	void GetStatistics( icHud::Statistics* pStatistics ) {
+		*pStatistics = m_statistics;
+	}
+
+	//! 統計情報をクリアする
+	void ResetStatistics( void ) {
+		memset( &m_statistics, 0, sizeof(m_statistics) );
+	}
+private:
+	//! 入力が変わった部品を描画先に描き直す
+	/*!
+		描画先のアルファには、アルファテストに通ったピクセルだけステンシルで0xFFを書く。
+		@return	描き直した部品数
+	*/
+	uint32_t Redraw( void ) {
+		uint32_t rc = 0;
+
+		for(std::vector<Element>::iterator p = m_element.begin(); p != m_element.end(); ++p) {
+			if(!p->fSlot) {
+				continue;
+			}
+			const uint32_t nKey = p->pElement->GetKey();
+			if(p->fValid && (p->nKey == nKey)) {
+				continue;
+			}
+			if(rc == 0) {
+				if(Cat_RenderBeginTarget() < 0) {
+					break;
+				}
+				m_statistics.nTargetCount++;
+				sceGuClearColor( 0 );
+				sceGuClearStencil( 0 );
+				sceGuEnable( GU_ALPHA_TEST );
+				sceGuAlphaFunc( GU_GREATER, 0, 0xFF );
+				sceGuEnable( GU_STENCIL_TEST );
+				sceGuStencilFunc( GU_ALWAYS, 0xFF, 0xFF );
+				sceGuStencilOp( GU_KEEP, GU_KEEP, GU_REPLACE );
+			}
+			sceGuScissor( p->u, p->v, p->nWidth, p->nHeight );
+			sceGuClear( GU_COLOR_BUFFER_BIT | GU_STENCIL_BUFFER_BIT );
+			p->pElement->Draw( (float)p->u, (float)p->v );
+			p->nKey   = nKey;
+			p->fValid = true;
+			rc++;
+		}
+		if(rc) {
+			sceGuDisable( GU_STENCIL_TEST );
+			sceGuDisable( GU_ALPHA_TEST );
+			Cat_RenderEndTarget();
+		}
+		return rc;
+	}
+
+	//! 描画先にある部品をまとめて描画する
+	/*!
+		@param[in]	nStart	最初の部品の番号
+		@param[in]	nEnd	最後の部品の次の番号
+	*/
+	void DrawCache( uint32_t nStart, uint32_t nEnd ) {
+		if(nStart >= nEnd) {
+			return;
+		}
+		const int nVertexType = GU_TEXTURE_16BIT | GU_VERTEX_16BIT | GU_TRANSFORM_2D;
+		Cat_SpriteVertex16* pVertex = (Cat_SpriteVertex16*)Cat_RenderGetMemory( sizeof(Cat_SpriteVertex16) * 2 * (nEnd - nStart) );
+		if(pVertex == 0) {
+			return;
+		}
+		for(uint32_t i = nStart; i < nEnd; i++) {
+			const Element& element = m_element[i];
+			const int16_t x = (int16_t)floorf( element.x + 0.5f );
+			const int16_t y = (int16_t)floorf( element.y + 0.5f );
+			Cat_SpriteVertex16* p = &pVertex[(i - nStart) * 2];
+			p[0].u = element.u;
+			p[0].v = element.v;
+			p[0].x = x;
+			p[0].y = y;
+			p[0].z = 0;
+			p[1].u = (int16_t)(element.u + element.nWidth);
+			p[1].v = (int16_t)(element.v + element.nHeight);
+			p[1].x = (int16_t)(x + element.nWidth);
+			p[1].y = (int16_t)(y + element.nHeight);
+			p[1].z = 0;
+		}
+
+		// 描画先はフレームバッファと同じフォーマットの512x512のテクスチャとして読む
+		Cat_RenderStateEnableTexture( 1 );
+		Cat_RenderStateTexMode( Cat_RenderGetFormat(), 0 );
+		Cat_RenderStateTexImage( 512, 512, CAT_RENDER_TARGET_BUFFER_WIDTH, m_pvTarget );
+		Cat_RenderStateBlendFunc( GU_ADD, GU_SRC_ALPHA, GU_ONE_MINUS_SRC_ALPHA, 0, 0 );
+		Cat_RenderDrawArray( GU_SPRITES, nVertexType, 2 * (nEnd - nStart), 0, pVertex );
+		m_statistics.nCacheCount += nEnd - nStart;
+		m_statistics.nBatchCount++;
+	}
+
+	std::vector<Element>	m_element;		/*!< 部品(追加した順)						*/
+	int32_t			m_nShelfX;				/*!< 描画先の今の棚の空いている左端			*/
+	int32_t			m_nShelfY;				/*!< 描画先の今の棚の上端					*/
+	int32_t			m_nShelfHeight;			/*!< 描画先の今の棚の高さ					*/
+	bool			m_fCache;				/*!< 描画先に残すかどうか					*/
+	void*			m_pvTarget;				/*!< 前のDraw()の描画先						*/
+	uint32_t		m_nFrame;				/*!< 前のDraw()のフレーム番号				*/
+	bool			m_fFrame;				/*!< Draw()したことがあるかどうか			*/
+	uint32_t		m_nOverflowCount;		/*!< 前のDraw()の後の描画パケットの溢れた回数	*/
+	icHud::Statistics	m_statistics;		/*!< 統計情報								*/
+};
+
+//! コンストラクタ
+icHud::icHud()
+	: m_impl( new icHudImpl() )
+{
+}
+
+//! 部品を追加する
+/*!
+	@param[in]	pElement	部品
+	@param[in]	x			画面での左上の位置X(ドット単位)
+	@param[in]	y			画面での左上の位置Y(ドット単位)
+	@param[in]	nWidth		横幅(ドット単位)
+	@param[in]	nHeight		高さ(ドット単位)
+	@return	部品の番号
+*/
+uint32_t
+icHud::Add( icHudElement* pElement, float x, float y, uint32_t nWidth, uint32_t nHeight )
+{
+	return m_impl->Add( pElement, x, y, nWidth, nHeight );
+}
+
+//! 部品を全て取り除く
+void
+icHud::Clear( void )
+{
+	m_impl->Clear();
+}
+
+//! 部品の数を取得する
+/*!
+	@return	部品の数
+*/
+uint32_t
+icHud::GetCount( void ) const
+{
+	return m_impl->GetCount();
+}
+
+//! 部品の位置を変える
+/*!
+	@param[in]	nNo		部品の番号
+	@param[in]	x		画面での左上の位置X(ドット単位)
+	@param[in]	y		画面での左上の位置Y(ドット単位)
+*/
+void
+icHud::SetPosition( uint32_t nNo, float x, float y )
+{
+	m_impl->SetPosition( nNo, x, y );
+}
+
+//! 描画先に残すかどうかを設定する
+/*!
+	@param[in]	fCache	残す場合はtrue
+*/
+void
+icHud::SetCache( bool fCache )
+{
+	m_impl->SetCache( fCache );
+}
+
+//! 描画先に残した結果を捨てる
+void
+icHud::Invalidate( void )
+{
+	m_impl->Invalidate();
+}
+
+//! 描画する
+/*!
+	@return	描画先に描き直した部品数
+*/
+uint32_t
+icHud::Draw( void )
+{
+	return m_impl->Draw();
+}
+
+//! 統計情報を取得する
+/*!
+	@param[out]	pStatistics		統計情報
+*/
+void
+icHud::GetStatistics( Statistics* pStatistics )
+{
+	m_impl->GetStatistics( pStatistics );
+}
+
+//! 統計情報をクリアする
+void
+icHud::ResetStatistics( void )
+{
+	m_impl->ResetStatistics();
+}
+
+//! 入力を1つ混ぜる
+/*!
+	FNV-1aで4バイトを混ぜる。
+	@param[in]	nKey	今までの値(最初は0)
+	@param[in]	nValue	混ぜる値
+	@return	混ぜた値
+*/
+uint32_t
+icHud::Hash( uint32_t nKey, uint32_t nValue )
+{
+	uint32_t rc = nKey ? nKey : 2166136261UL;
+	for(uint32_t i = 0; i < 4; i++) {
+		rc = (rc ^ ((nValue >> (i * 8)) & 0xFF)) * 16777619UL;
+	}
+	return rc;
+}
+
+//! 文字列の入力を混ぜる
+/*!
+	@param[in]	nKey	今までの値(最初は0)
+	@param[in]	str		混ぜる文字列
+	@return	混ぜた値
+*/
+uint32_t
+icHud::Hash( uint32_t nKey, const std::string& str )
+{
+	uint32_t rc = nKey ? nKey : 2166136261UL;
+	for(std::string::const_iterator p = str.begin(); p != str.end(); ++p) {
+		rc = (rc ^ (uint8_t)*p) * 16777619UL;
+	}
+	return Hash( rc, str.size() );
+}
+
+} // namespace ic
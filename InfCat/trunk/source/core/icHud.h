@@ -0,0 +1,148 @@
+//! @file	icHud.h
+// HUD(体力ゲージ、パワーゲージ、タイマー、顔グラなど)
+
+#ifndef INCL_CLASS_icHud
+#define INCL_CLASS_icHud
+
+#include "icCore.h"
+
+namespace ic {
+
+//! HUDの部品
+/*!
+	体力ゲージなど、たくさんのスプライトでできていても、入力が変わった時にしか見た目が変わらないもの。
+*/
+class icHudElement {
+public:
+	//! デストラクタ
+	virtual ~icHudElement() {}
+
+	//! 見た目を決める入力をまとめた値を取得する
+	/*!
+		体力、ラウンド数、名前、アニメーションのコマなど、見た目を変える入力から作る。 \n
+		前に描いた時と同じ値なら描き直さない。値をまとめるにはicHud::Hash()を使うとよい。
+		@return	入力をまとめた値
+	*/
+	virtual uint32_t GetKey( void ) = 0;
+
+	//! 描画する
+	/*!
+		部品の左上が( \a x, \a y )に来るように描く。描画先に描く時は、描画先の中の位置が渡される。 \n
+		Add()で指定した大きさの外は、描画先に描く時は切り取られる。
+		@param[in]	x	左上の位置X(ドット単位)
+		@param[in]	y	左上の位置Y(ドット単位)
+	*/
+	virtual void Draw( float x, float y ) = 0;
+};
+
+//! HUD
+/*!
+	部品ごとに、Cat_RenderGetTarget()の描画先の中に場所を取って、描いた結果を残しておく。 \n
+	GetKey()の値が変わった部品だけを描画先に描き直し、画面には描画先から1枚ずつ、 \n
+	続いている部品はまとめて1回で描画する。 \n
+	描画先はCat_RenderInit()でCAT_RENDER_PARAM_TARGETを指定した時だけあるので、無い場合と \n
+	描画先に入りきらない部品は、毎フレームそのまま描画する。 \n
+	描画先のアルファはステンシルとして書くので、部品の透明な所は透明のまま残るが、半透明の所は不透明になる。 \n
+	フレームバッファがGU_PSM_5650の場合はアルファもステンシルも無く、透明な所が残せないので、描画先を使わない。 \n
+	描画先から描画する時は、画面での位置を整数に丸める。
+*/
+class icHud : boost::noncopyable {
+public:
+	//! 統計情報
+	struct Statistics {
+		uint32_t	nDrawCount;			/*!< Draw()の回数										*/
+		uint32_t	nElementCount;		/*!< 描画した部品数										*/
+		uint32_t	nRedrawCount;		/*!< 描画先に描き直した部品数							*/
+		uint32_t	nCacheCount;		/*!< 描画先から1枚で描画した部品数						*/
+		uint32_t	nDirectCount;		/*!< そのまま描画した部品数								*/
+		uint32_t	nTargetCount;		/*!< 描画先に切り替えた回数								*/
+		uint32_t	nBatchCount;		/*!< 描画先から描画したsceGuDrawArray()の回数			*/
+		uint32_t	nInvalidateCount;	/*!< 描画パケットが溢れたなどで、全て描き直した回数		*/
+	};
+
+	//! コンストラクタ
+	icHud();
+
+	//! 部品を追加する
+	/*!
+		描画先には、追加した順に左上から詰めて場所を取る。部品は破棄しないので、icHudより後に破棄すること。
+		@param[in]	pElement	部品
+		@param[in]	x			画面での左上の位置X(ドット単位)
+		@param[in]	y			画面での左上の位置Y(ドット単位)
+		@param[in]	nWidth		横幅(ドット単位)
+		@param[in]	nHeight		高さ(ドット単位)
+		@return	部品の番号
+	*/
+	uint32_t Add( icHudElement* pElement, float x, float y, uint32_t nWidth, uint32_t nHeight );
+
+	//! 部品を全て取り除く
+	void Clear( void );
+
+	//! 部品の数を取得する
+	/*!
+		@return	部品の数
+	*/
+	uint32_t GetCount( void ) const;
+
+	//! 部品の位置を変える
+	/*!
+		位置が変わっても描き直さない。
+		@param[in]	nNo		部品の番号
+		@param[in]	x		画面での左上の位置X(ドット単位)
+		@param[in]	y		画面での左上の位置Y(ドット単位)
+	*/
+	void SetPosition( uint32_t nNo, float x, float y );
+
+	//! 描画先に残すかどうかを設定する
+	/*!
+		残さない場合は、全ての部品を毎フレームそのまま描画する。比較や不具合の切り分けに使う。
+		@param[in]	fCache	残す場合はtrue
+	*/
+	void SetCache( bool fCache );
+
+	//! 描画先に残した結果を捨てる
+	/*!
+		次のDraw()で全ての部品を描き直す。Cat_RenderInit()をし直した時などに呼ぶ。
+	*/
+	void Invalidate( void );
+
+	//! 描画する
+	/*!
+		Cat_RenderBegin()とCat_RenderEnd()の間で、1フレームに1回呼ぶ。 \n
+		描き直す時はクリア色を0にする。描画先から描画する時は、ブレンドを半透明にする。
+		@return	描画先に描き直した部品数
+	*/
+	uint32_t Draw( void );
+
+	//! 統計情報を取得する
+	/*!
+		@param[out]	pStatistics		統計情報
+	*/
+	void GetStatistics( Statistics* pStatistics );
+
+	//! 統計情報をクリアする
+	void ResetStatistics( void );
+
+	//! 入力を1つ混ぜる
+	/*!
+		@param[in]	nKey	今までの値(最初は0)
+		@param[in]	nValue	混ぜる値
+		@return	混ぜた値
+	*/
+	static uint32_t Hash( uint32_t nKey, uint32_t nValue );
+
+	//! 文字列の入力を混ぜる
+	/*!
+		@param[in]	nKey	今までの値(最初は0)
+		@param[in]	str		混ぜる文字列
+		@return	混ぜた値
+	*/
+	static uint32_t Hash( uint32_t nKey, const std::string& str );
+
+private:
+	boost::shared_ptr<class icHudImpl>	m_impl;		/*!< 実装	*/
+};
+
+} // namespace ic
+
+#endif // INCL_CLASS_icHud
@@ -25,16 +25,30 @@ icSectionValue::GetValue( const std::string& strSection, const std::string& strK
 	return m_Sections[strSection][strKey][nIndex];
 }
 
+int32_t
+icSectionValue::GetSectionCount( void ) const
+{
+	return m_SectionNames.size();
+}
+
+std::string
+icSectionValue::GetSectionName( int32_t nIndex ) const
+{
+	return m_SectionNames[nIndex];
+}
+
 void
 icSectionValue::Clear( void )
 {
 	m_Sections.clear();
+	m_SectionNames.clear();
 }
 
 void
 icSectionValue::Clear( const std::string& strSection )
 {
 	m_Sections.erase( strSection );
+	m_SectionNames.erase( std::remove( m_SectionNames.begin(), m_SectionNames.end(), strSection ), m_SectionNames.end() );
 }
 
 void
@@ -51,6 +65,9 @@ icSectionValue::Clear( const std::string& strSection, const std::string& strKey
 void
 icSectionValue::Register( const std::string& strSection, const std::string& strKey, const std::string& strValue )
 {
+	if(m_Sections.find( strSection ) == m_Sections.end()) {
+		m_SectionNames.push_back( strSection );
+	}
 	m_Sections[strSection][strKey].push_back( strValue );
 }
 
@@ -15,12 +15,15 @@ protected:
 public:
 	int32_t Count( const std::string& strSection, const std::string& strKey );
 	std::string GetValue( const std::string& strSection, const std::string& strKey, int32_t nIndex );
+	int32_t GetSectionCount( void ) const;
+	std::string GetSectionName( int32_t nIndex ) const;
 	void Clear( void );
 	void Clear( const std::string& strSection );
 	void Clear( const std::string& strSection, const std::string& strKey );
 	void Register( const std::string& strSection, const std::string& strKey, const std::string& strValue );
 protected:
 	SECTION	m_Sections;
+	std::vector<std::string>	m_SectionNames;
 };
 
 } // namespace ic
@@ -10,10 +10,12 @@ enum enumPaletteType {
 	ePaletteTypeSHARED = 1,
 };
 
+//! icTextureに持たせる情報(icTexture::USER_DATA_SIZEに収まること)
 struct UserData {
 	uint32_t nPaletteInfo;
 	uint32_t fCommonPalette;
 	uint32_t nPaletteType;
+	uint32_t nImagePosition;	// 読み込み直す時のPCXの位置
 };
 
 //! テクスチャを作成する
@@ -127,6 +129,7 @@ icTextureCreatorSff::Create( icTexturePool* pTexturePool, Cat_Stream* pStream, i
 
 	// イメージの読み込み処理
 	std::vector<SffImageHeader>	pImageHeader( header.m_nCountImage );
+	std::vector<uint32_t>		nImagePosition( header.m_nCountImage, 0 );
 	for(uint32_t i = 0; i < header.m_nCountImage; i++) {
 		if(Cat_StreamRead( pStream, &pImageHeader[i], sizeof(SffImageHeader) ) != sizeof(SffImageHeader)) {
 			return false;
@@ -157,10 +160,12 @@ icTextureCreatorSff::Create( icTexturePool* pTexturePool, Cat_Stream* pStream, i
 			// イメージサイズ0は、共通イメージ
 			if((pImageHeader[i].m_nLinkIndex < i) && texture[pImageHeader[i].m_nLinkIndex]) {
 				texture.push_back( new icTexture( texture[pImageHeader[i].m_nLinkIndex], pImageHeader[i].m_nGroupNo, pImageHeader[i].m_nItemNo, pImageHeader[i].m_nDrawOffsetX, pImageHeader[i].m_nDrawOffsetY ) );
+				nImagePosition[i] = nImagePosition[pImageHeader[i].m_nLinkIndex];
 			} else {
 				texture.push_back( 0 );
 			}
 		} else {
+			nImagePosition[i] = (uint32_t)Cat_StreamTell( pStream );
 			Cat_Texture* pTexture = SffCreateTexture( pStream );
 			if(pTexture) {
 				texture.push_back( new icTexture( pTexture, pImageHeader[i].m_nGroupNo, pImageHeader[i].m_nItemNo, pImageHeader[i].m_nDrawOffsetX, pImageHeader[i].m_nDrawOffsetY ) );
@@ -188,11 +193,13 @@ icTextureCreatorSff::Create( icTexturePool* pTexturePool, Cat_Stream* pStream, i
 	const uint32_t nInvertShared = 0;
 	for(uint32_t i = 0; i < header.m_nCountImage; i++) {
 		if(texture[i]) {
-			UserData* pUserData = (UserData*)CAT_MALLOC( sizeof(UserData) );
-			pUserData->nPaletteInfo   = pImageHeader[i].m_nPaletteInfo;
-			pUserData->fCommonPalette = pImageHeader[i].m_fCommonPalette;
-			pUserData->nPaletteType   = header.m_nPaletteType;
-			texture[i]->SetUserData( pUserData );
+			UserData userData;
+			userData.nPaletteInfo   = pImageHeader[i].m_nPaletteInfo;
+			userData.fCommonPalette = pImageHeader[i].m_fCommonPalette;
+			userData.nPaletteType   = header.m_nPaletteType;
+			userData.nImagePosition = nImagePosition[i];
+			texture[i]->SetUserData( &userData, sizeof(userData) );	// テクスチャ内にコピーされる
+			const UserData* pUserData = &userData;
 
 			if(!found_1st && !fAct && (fPal256 != 2)) {
 				pPaletteD = texture[i]->GetPalette();
@@ -272,6 +279,35 @@ icTextureCreatorSff::SetAct( icTexturePool* pTexturePool, Cat_Palette* pPalette
 	}
 }
 
+//! ピクセルデータを読み込み直す
+/*!
+	@param[in]	pTexturePool	テクスチャプール
+	@param[in]	pStream			作成した時のストリーム
+	@param[in]	pTexture		読み込み直すテクスチャ
+	@return 正常終了時 true \n
+			失敗時 false
+*/
+bool
+icTextureCreatorSff::Reload( icTexturePool* pTexturePool, Cat_Stream* pStream, icTexture* pTexture )
+{
+	UserData* pUserData = (UserData*)pTexture->GetUserData();
+	if((pUserData == 0) || (pUserData->nImagePosition == 0)) {
+		return false;
+	}
+	if(Cat_StreamSeek( pStream, pUserData->nImagePosition ) < 0) {
+		return false;
+	}
+
+	// 作り直して、ピクセルデータだけを移す(パレットは差し替えられているかもしれないので残す)
+	Cat_Texture* pSource = SffCreateTexture( pStream );
+	if(pSource == 0) {
+		return false;
+	}
+	const int32_t rc = Cat_TextureReload( pTexture->GetCatTexture(), pSource );
+	Cat_TextureRelease( pSource );
+	return rc == 0;
+}
+
 
 // 変則的な PCX 読み込み ---------------------------------------------------------------------------------------
 
@@ -36,6 +36,16 @@ public:
 		@param[in]	pPalette		設定するパレット
 	*/
 	virtual void SetAct( icTexturePool* pTexturePool, Cat_Palette* pPalette );
+
+	//! ピクセルデータを読み込み直す
+	/*!
+		@param[in]	pTexturePool	テクスチャプール
+		@param[in]	pStream			作成した時のストリーム
+		@param[in]	pTexture		読み込み直すテクスチャ
+		@return 正常終了時 true \n
+				失敗時 false
+	*/
+	virtual bool Reload( icTexturePool* pTexturePool, Cat_Stream* pStream, icTexture* pTexture );
 };
 
 } // namespace ic
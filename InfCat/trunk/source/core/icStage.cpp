@@ -0,0 +1,476 @@
+//! @file	icStage.cpp
+// ステージの背景
+
+#include "icCore.h"
+#include <math.h>
+
+namespace ic {
+
+//! 文字列を小文字にする
+/*!
+	@param[in]	str	文字列
+	@return	小文字にした文字列
+*/
+static std::string
+ToLower( const std::string& str )
+{
+	std::string strLower( str );
+	for(uint32_t i = 0; i < strLower.size(); i++) {
+		if((strLower[i] >= 'A') && (strLower[i] <= 'Z')) {
+			strLower[i] = strLower[i] - 'A' + 'a';
+		}
+	}
+	return strLower;
+}
+
+//! 数値を取得する
+/*!
+	@param[in]	def			定義ファイル
+	@param[in]	strSection	セクション
+	@param[in]	pszKey		キー
+	@param[in]	nIndex		値のインデックス
+	@param[in]	fDefault	値が無い場合の値
+	@return	値
+*/
+static float
+GetFloat( icDef& def, const std::string& strSection, const char* pszKey, int32_t nIndex, float fDefault )
+{
+	if(def.Count( strSection, pszKey ) <= nIndex) {
+		return fDefault;
+	}
+	return (float)atof( def.GetValue( strSection, pszKey, nIndex ).c_str() );
+}
+
+//! alphaの重みを取得する
+/*!
+	@param[in]	def			定義ファイル
+	@param[in]	strSection	セクション
+	@param[in]	nIndex		値のインデックス(0:ソース 1:描画先)
+	@param[in]	nDefault	値が無い場合の値
+	@return	重み(0～CAT_SPRITEBATCH_ALPHA_UNIT)
+*/
+static uint32_t
+GetAlpha( icDef& def, const std::string& strSection, int32_t nIndex, uint32_t nDefault )
+{
+	const float fAlpha = GetFloat( def, strSection, "alpha", nIndex, (float)nDefault );
+	if(fAlpha <= 0.0f) {
+		return 0;
+	}
+	return (fAlpha >= (float)CAT_SPRITEBATCH_ALPHA_UNIT) ? CAT_SPRITEBATCH_ALPHA_UNIT : (uint32_t)fAlpha;
+}
+
+//! 1つの軸で、見える範囲にあるタイル番号を求める
+/*!
+	タイルkは[fOrigin + k * fPitch, fOrigin + k * fPitch + fSize)に置かれる。 \n
+	並べる数に関係なく、見える範囲の両端から割り算で求める。
+	@param[in]	fOrigin		タイル0の位置
+	@param[in]	fSize		タイルの大きさ
+	@param[in]	fPitch		タイルの間隔(大きさ+tilespacing、0より大きいこと)
+	@param[in]	nTile		tileの値(0は並べない、1は無限に並べる、2以上は並べる数)
+	@param[in]	fMin		見える範囲の始まり
+	@param[in]	fMax		見える範囲の終わり(含まない)
+	@param[out]	pnFirst		見える最初のタイル番号
+	@param[out]	pnLast		見える最後のタイル番号
+	@return	見えるタイルがあればtrue \n
+			無ければfalseを返す
+*/
+static bool
+GetTileRange( float fOrigin, float fSize, float fPitch, int32_t nTile, float fMin, float fMax, int32_t* pnFirst, int32_t* pnLast )
+{
+	// fOrigin + k * fPitch + fSize > fMin かつ fOrigin + k * fPitch < fMax になるk
+	int32_t nFirst = (int32_t)floorf( (fMin - fOrigin - fSize) / fPitch ) + 1;
+	int32_t nLast  = (int32_t)ceilf( (fMax - fOrigin) / fPitch ) - 1;
+	if(nTile != 1) {
+		const int32_t nCount = (nTile > 1) ? nTile : 1;
+		if(nFirst < 0) {
+			nFirst = 0;
+		}
+		if(nLast > nCount - 1) {
+			nLast = nCount - 1;
+		}
+	}
+	*pnFirst = nFirst;
+	*pnLast  = nLast;
+	return nFirst <= nLast;
+}
+
+//! 実装
+class icStageImpl {
+public:
+	//! 画面の大きさ
+	enum { SCREEN_WIDTH = 480, SCREEN_HEIGHT = 272 };
+
+	//! レイヤー
+	struct Layer {
+		icTexture*	pTexture;		/*!< テクスチャ									*/
+		int32_t		nLayerNo;		/*!< layerno									*/
+		uint32_t	nBlend;			/*!< ブレンドの方法(CAT_SPRITEBATCH_BLEND_xxx)	*/
+		uint32_t	nSrcAlpha;		/*!< 重み付き加算のソースの重み(0～256)			*/
+		uint32_t	nDestAlpha;		/*!< 重み付き加算の描画先の重み(0～256)			*/
+		float		fStartX;		/*!< start X(軸を引いた位置)					*/
+		float		fStartY;		/*!< start Y									*/
+		float		fDeltaX;		/*!< delta X									*/
+		float		fDeltaY;		/*!< delta Y									*/
+		int32_t		nTileX;			/*!< tile X										*/
+		int32_t		nTileY;			/*!< tile Y										*/
+		float		fWidth;			/*!< タイルの横幅								*/
+		float		fHeight;		/*!< タイルの高さ								*/
+		float		fPitchX;		/*!< タイルの横の間隔(横幅+tilespacing)			*/
+		float		fPitchY;		/*!< タイルの縦の間隔							*/
+		float		fVelocityX;		/*!< velocity X									*/
+		float		fVelocityY;		/*!< velocity Y									*/
+		float		fOffsetX;		/*!< velocityで動いた量X						*/
+		float		fOffsetY;		/*!< velocityで動いた量Y						*/
+		bool		fWindow;		/*!< windowがあるかどうか						*/
+		float		fWindowX0;		/*!< windowの左									*/
+		float		fWindowY0;		/*!< windowの上									*/
+		float		fWindowX1;		/*!< windowの右(含まない)						*/
+		float		fWindowY1;		/*!< windowの下(含まない)						*/
+		float		fWindowDeltaX;	/*!< windowdelta X								*/
+		float		fWindowDeltaY;	/*!< windowdelta Y								*/
+	};
+
+	//! コンストラクタ
+	/*!
+		@param[in]	nBatchCount	1回のCat_SpriteBatchFlush()で溜めるタイル数
+	*/
+	icStageImpl( uint32_t nBatchCount )
+		: m_pBatch( Cat_SpriteBatchCreate( nBatchCount ) )
+		, m_fCameraX( 0.0f )
+		, m_fCameraY( 0.0f )
+	{
+		ResetStatistics();
+	}
+
+	//! デストラクタ
+	~icStageImpl() {
+		if(m_pBatch) {
+			Cat_SpriteBatchDestroy( m_pBatch );
+		}
+	}
+
+	//! 背景を読み込む
+	/*!
+		@param[in]	def		ステージ定義ファイル
+		@param[in]	pool	ステージのスプライトのテクスチャプール
+		@return 成功した場合true \n
+				失敗したらfalseを返す
+	*/
+	bool Create( icDef& def, icTexturePool& pool ) {
+		Release();
+		if(m_pBatch == 0) {
+			return false;
+		}
+		for(int32_t i = 0; i < def.GetSectionCount(); i++) {
+			const std::string strSection = def.GetSectionName( i );
+			if(ToLower( strSection ).compare( 0, 3, "bg " ) != 0) {
+				continue;
+			}
+			const std::string strType = (def.Count( strSection, "type" ) > 0) ? ToLower( def.GetValue( strSection, "type", 0 ) ) : "normal";
+			if((strType != "normal") && (strType != "parallax")) {
+				continue;
+			}
+			icTexture* pTexture = pool.Search( (uint16_t)GetFloat( def, strSection, "spriteno", 0, 0.0f ),
+				(uint16_t)GetFloat( def, strSection, "spriteno", 1, 0.0f ) );
+			if(pTexture == 0) {
+				continue;
+			}
+
+			Layer layer;
+			layer.pTexture   = pTexture;
+			layer.nLayerNo   = (int32_t)GetFloat( def, strSection, "layerno", 0, 0.0f );
+			layer.nBlend     = CAT_SPRITEBATCH_BLEND_ALPHA;
+			layer.nSrcAlpha  = CAT_SPRITEBATCH_ALPHA_UNIT;
+			layer.nDestAlpha = 0;
+			if(def.Count( strSection, "trans" ) > 0) {
+				const std::string strTrans = ToLower( def.GetValue( strSection, "trans", 0 ) );
+				if(strTrans == "add") {
+					layer.nBlend = CAT_SPRITEBATCH_BLEND_ADD;
+				} else if(strTrans == "add1") {
+					// 背景を半分にして加算
+					layer.nBlend     = CAT_SPRITEBATCH_BLEND_ADDALPHA;
+					layer.nDestAlpha = CAT_SPRITEBATCH_ALPHA_UNIT / 2;
+				} else if(strTrans == "addalpha") {
+					// alpha = src, dst (省略時は256, 0)
+					layer.nBlend     = CAT_SPRITEBATCH_BLEND_ADDALPHA;
+					layer.nSrcAlpha  = GetAlpha( def, strSection, 0, CAT_SPRITEBATCH_ALPHA_UNIT );
+					layer.nDestAlpha = GetAlpha( def, strSection, 1, 0 );
+				} else if(strTrans == "sub") {
+					layer.nBlend = CAT_SPRITEBATCH_BLEND_SUB;
+				}
+			}
+			layer.fStartX    = GetFloat( def, strSection, "start", 0, 0.0f ) - (float)pTexture->GetDrawOffsetX();
+			layer.fStartY    = GetFloat( def, strSection, "start", 1, 0.0f ) - (float)pTexture->GetDrawOffsetY();
+			layer.fDeltaX    = GetFloat( def, strSection, "delta", 0, 1.0f );
+			layer.fDeltaY    = GetFloat( def, strSection, "delta", 1, 1.0f );
+			layer.nTileX     = (int32_t)GetFloat( def, strSection, "tile", 0, 0.0f );
+			layer.nTileY     = (int32_t)GetFloat( def, strSection, "tile", 1, 0.0f );
+			layer.fWidth     = (float)pTexture->GetWidth();
+			layer.fHeight    = (float)pTexture->GetHeight();
+			layer.fPitchX    = layer.fWidth + GetFloat( def, strSection, "tilespacing", 0, 0.0f );
+			layer.fPitchY    = layer.fHeight + GetFloat( def, strSection, "tilespacing", 1, 0.0f );
+			layer.fVelocityX = GetFloat( def, strSection, "velocity", 0, 0.0f );
+			layer.fVelocityY = GetFloat( def, strSection, "velocity", 1, 0.0f );
+			layer.fOffsetX   = 0.0f;
+			layer.fOffsetY   = 0.0f;
+			layer.fWindow    = def.Count( strSection, "window" ) >= 4;
+			layer.fWindowX0  = GetFloat( def, strSection, "window", 0, 0.0f );
+			layer.fWindowY0  = GetFloat( def, strSection, "window", 1, 0.0f );
+			layer.fWindowX1  = GetFloat( def, strSection, "window", 2, (float)SCREEN_WIDTH - 1.0f ) + 1.0f;
+			layer.fWindowY1  = GetFloat( def, strSection, "window", 3, (float)SCREEN_HEIGHT - 1.0f ) + 1.0f;
+			layer.fWindowDeltaX = GetFloat( def, strSection, "windowdelta", 0, 0.0f );
+			layer.fWindowDeltaY = GetFloat( def, strSection, "windowdelta", 1, 0.0f );
+			// 間隔が0以下だと並べられないので、隙間なく並べる
+			if(layer.fPitchX <= 0.0f) {
+				layer.fPitchX = (layer.fWidth > 0.0f) ? layer.fWidth : 1.0f;
+			}
+			if(layer.fPitchY <= 0.0f) {
+				layer.fPitchY = (layer.fHeight > 0.0f) ? layer.fHeight : 1.0f;
+			}
+			m_layer.push_back( layer );
+		}
+		return true;
+	}
+
+	//! 背景を破棄する
+	void Release( void ) {
+		m_layer.clear();
+	}
+
+	//! 読み込んだレイヤー数を取得する
+	/*!
+		@return	レイヤー数
+	*/
+	uint32_t GetLayerCount( void ) const {
+		return m_layer.size();
+	}
+
+	//! カメラの位置を設定する
+	/*!
+		@param[in]	x	カメラの位置X(ドット単位)
+		@param[in]	y	カメラの位置Y(ドット単位)
+	*/
+	void SetCamera( float x, float y ) {
+		m_fCameraX = x;
+		m_fCameraY = y;
+	}
+
+	//! 1フレーム進める
+	void Update( void ) {
+		for(std::vector<Layer>::iterator p = m_layer.begin(); p != m_layer.end(); ++p) {
+			p->fOffsetX += p->fVelocityX;
+			p->fOffsetY += p->fVelocityY;
+			// 無限に並べる軸は、1周したら戻して桁落ちを防ぐ
+			if(p->nTileX == 1) {
+				p->fOffsetX = fmodf( p->fOffsetX, p->fPitchX );
+			}
+			if(p->nTileY == 1) {
+				p->fOffsetY = fmodf( p->fOffsetY, p->fPitchY );
+			}
+		}
+	}
+
+	//! 背景を描画する
+	/*!
+		@param[in]	nLayerNo	layerno
+		@return	描画したタイル数
+	*/
+	uint32_t Draw( int32_t nLayerNo ) {
+		uint32_t nTotal = 0;
+		uint32_t nOrder = 0;
+
+		m_statistics.nDrawCount++;
+		if(m_pBatch == 0) {
+			return 0;
+		}
+		for(std::vector<Layer>::iterator p = m_layer.begin(); p != m_layer.end(); ++p) {
+			const Layer& layer = *p;
+			if(layer.nLayerNo != nLayerNo) {
+				continue;
+			}
+
+			// 見える範囲(画面とwindowの重なり)
+			float x0 = 0.0f;
+			float y0 = 0.0f;
+			float x1 = (float)SCREEN_WIDTH;
+			float y1 = (float)SCREEN_HEIGHT;
+			bool fScissor = false;
+			if(layer.fWindow) {
+				const float fWindowX = floorf( -m_fCameraX * layer.fWindowDeltaX );
+				const float fWindowY = floorf( -m_fCameraY * layer.fWindowDeltaY );
+				x0 = std::max( x0, layer.fWindowX0 + fWindowX );
+				y0 = std::max( y0, layer.fWindowY0 + fWindowY );
+				x1 = std::min( x1, layer.fWindowX1 + fWindowX );
+				y1 = std::min( y1, layer.fWindowY1 + fWindowY );
+				if((x0 >= x1) || (y0 >= y1)) {
+					m_statistics.nWindowCullCount++;
+					continue;
+				}
+				fScissor = (x0 > 0.0f) || (y0 > 0.0f) || (x1 < (float)SCREEN_WIDTH) || (y1 < (float)SCREEN_HEIGHT);
+			}
+
+			// タイル0の位置(継ぎ目が出ないように整数にする)
+			const float fOriginX = floorf( layer.fStartX + (float)(SCREEN_WIDTH / 2) - m_fCameraX * layer.fDeltaX + layer.fOffsetX );
+			const float fOriginY = floorf( layer.fStartY - m_fCameraY * layer.fDeltaY + layer.fOffsetY );
+			int32_t nFirstX, nLastX, nFirstY, nLastY;
+			if(!GetTileRange( fOriginX, layer.fWidth, layer.fPitchX, layer.nTileX, x0, x1, &nFirstX, &nLastX )
+				|| !GetTileRange( fOriginY, layer.fHeight, layer.fPitchY, layer.nTileY, y0, y1, &nFirstY, &nLastY )) {
+				m_statistics.nOffscreenCount++;
+				continue;
+			}
+
+			// windowで切り取るレイヤーは、シザーを設定してこのレイヤーだけで描画する
+			if(fScissor || (nOrder > CAT_SPRITEBATCH_LAYER_MAX)) {
+				Flush();
+				nOrder = 0;
+			}
+			if(fScissor) {
+				sceGuScissor( (int)x0, (int)y0, (int)(x1 - x0), (int)(y1 - y0) );
+				m_statistics.nScissorCount++;
+			}
+
+			Cat_SpriteBatchSprite sprite;
+			Cat_SpriteBatchSpriteInit( &sprite );
+			sprite.nLayer = nOrder;
+			sprite.nBlend = layer.nBlend;
+			sprite.nSrcAlpha  = layer.nSrcAlpha;
+			sprite.nDestAlpha = layer.nDestAlpha;
+			for(int32_t ty = nFirstY; ty <= nLastY; ty++) {
+				sprite.y = fOriginY + (float)ty * layer.fPitchY;
+				for(int32_t tx = nFirstX; tx <= nLastX; tx++) {
+					sprite.x = fOriginX + (float)tx * layer.fPitchX;
+					if(!layer.pTexture->Draw( m_pBatch, sprite )) {
+						// 溜められなくなったら、そこまでを描画してから追加し直す
+						Flush();
+						layer.pTexture->Draw( m_pBatch, sprite );
+					}
+				}
+			}
+			const uint32_t nTile = (uint32_t)(nLastX - nFirstX + 1) * (uint32_t)(nLastY - nFirstY + 1);
+			nTotal += nTile;
+			m_statistics.nTileCount += nTile;
+			m_statistics.nLayerCount++;
+
+			if(fScissor) {
+				Flush();
+				sceGuScissor( 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT );
+				nOrder = 0;
+			} else {
+				nOrder++;
+			}
+		}
+		Flush();
+		return nTotal;
+	}
+
+	//! 統計情報を取得する
+	/*!
+		@param[out]	pStatistics		統計情報
+	*/
+	void GetStatistics( icStage::Statistics* pStatistics ) {
+		*pStatistics = m_statistics;
+	}
+
+	//! 統計情報をクリアする
+	void ResetStatistics( void ) {
+		memset( &m_statistics, 0, sizeof(m_statistics) );
+	}
+private:
+	//! 溜めたタイルを描画する
+	void Flush( void ) {
+		m_statistics.nBatchCount += Cat_SpriteBatchFlush( m_pBatch );
+	}
+
+	Cat_SpriteBatch*	m_pBatch;			/*!< バッチ				*/
+	std::vector<Layer>	m_layer;			/*!< レイヤーの表		*/
+	float				m_fCameraX;			/*!< カメラの位置X		*/
+	float				m_fCameraY;			/*!< カメラの位置Y		*/
+	icStage::Statistics	m_statistics;		/*!< 統計情報			*/
+};
+
+//! コンストラクタ
+/*!
+	@param[in]	nBatchCount	1回のCat_SpriteBatchFlush()で溜めるタイル数
+*/
+icStage::icStage( uint32_t nBatchCount )
+	: m_impl( new icStageImpl( nBatchCount ) )
+{
+}
+
+//! 背景を読み込む
+/*!
+	@param[in]	def		ステージ定義ファイル
+	@param[in]	pool	ステージのスプライトのテクスチャプール
+	@return 成功した場合true \n
+			失敗したらfalseを返す
+*/
+bool
+icStage::Create( icDef& def, icTexturePool& pool )
+{
+	return m_impl->Create( def, pool );
+}
+
+//! 背景を破棄する
+void
+icStage::Release( void )
+{
+	m_impl->Release();
+}
+
+//! 読み込んだレイヤー数を取得する
+/*!
+	@return	レイヤー数
+*/
+uint32_t
+icStage::GetLayerCount( void ) const
+{
+	return m_impl->GetLayerCount();
+}
+
+//! カメラの位置を設定する
+/*!
+	@param[in]	x	カメラの位置X(ドット単位)
+	@param[in]	y	カメラの位置Y(ドット単位)
+*/
+void
+icStage::SetCamera( float x, float y )
+{
+	m_impl->SetCamera( x, y );
+}
+
+//! 1フレーム進める
+void
+icStage::Update( void )
+{
+	m_impl->Update();
+}
+
+//! 背景を描画する
+/*!
+	@param[in]	nLayerNo	layerno
+	@return	描画したタイル数
+*/
+uint32_t
+icStage::Draw( int32_t nLayerNo )
+{
+	return m_impl->Draw( nLayerNo );
+}
+
+//! 統計情報を取得する
+/*!
+	@param[out]	pStatistics		統計情報
+*/
+void
+icStage::GetStatistics( Statistics* pStatistics )
+{
+	m_impl->GetStatistics( pStatistics );
+}
+
+//! 統計情報をクリアする
+void
+icStage::ResetStatistics( void )
+{
+	m_impl->ResetStatistics();
+}
+
+} // namespace ic
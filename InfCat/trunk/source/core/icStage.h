@@ -0,0 +1,97 @@
+//! @file	icStage.h
+// ステージの背景
+
+#ifndef INCL_CLASS_icStage
+#define INCL_CLASS_icStage
+
+#include "icCore.h"
+
+namespace ic {
+
+//! ステージの背景
+/*!
+	ステージ定義ファイルの[BG xxx]セクションを、読み込み時に平らなレイヤーの表にしておく。 \n
+	描画時は、カメラとdeltaから見える範囲のタイル番号を計算で求めて、 \n
+	画面とwindowの外にあるタイルは追加せずに、Cat_SpriteBatchでまとめて描画する。 \n
+	tileで幾つ並べるように指定されていても、追加するスプライト数は画面に見えるタイルの数になる。 \n
+	テクスチャは参照を持たないので、テクスチャプールより先に破棄すること。
+*/
+class icStage : boost::noncopyable {
+public:
+	//! 統計情報
+	struct Statistics {
+		uint32_t	nDrawCount;			/*!< Draw()の回数									*/
+		uint32_t	nLayerCount;		/*!< 描画したレイヤー数								*/
+		uint32_t	nWindowCullCount;	/*!< windowが画面外で描画しなかったレイヤー数		*/
+		uint32_t	nOffscreenCount;	/*!< 見えるタイルが無く描画しなかったレイヤー数		*/
+		uint32_t	nTileCount;			/*!< 描画したタイル数								*/
+		uint32_t	nScissorCount;		/*!< windowのためにシザーを設定した回数				*/
+		uint32_t	nBatchCount;		/*!< sceGuDrawArray()の回数							*/
+	};
+
+	//! コンストラクタ
+	/*!
+		@param[in]	nBatchCount	1回のCat_SpriteBatchFlush()で溜めるタイル数
+	*/
+	icStage( uint32_t nBatchCount = 1024 );
+
+	//! 背景を読み込む
+	/*!
+		[BG xxx]セクションをファイルに現れた順に読み込む。 \n
+		typeがnormalとparallaxのものを描画する。parallaxは床の傾きを付けずに、normalと同じに扱う。 \n
+		animとdummy、スプライトが見つからないものは読み飛ばす。
+		@param[in]	def		ステージ定義ファイル
+		@param[in]	pool	ステージのスプライトのテクスチャプール
+		@return 成功した場合true \n
+				失敗したらfalseを返す
+	*/
+	bool Create( icDef& def, icTexturePool& pool );
+
+	//! 背景を破棄する
+	void Release( void );
+
+	//! 読み込んだレイヤー数を取得する
+	/*!
+		@return	レイヤー数
+	*/
+	uint32_t GetLayerCount( void ) const;
+
+	//! カメラの位置を設定する
+	/*!
+		カメラが(0,0)の時に、ステージの中央が画面の上端の中央に来る。
+		@param[in]	x	カメラの位置X(ドット単位)
+		@param[in]	y	カメラの位置Y(ドット単位)
+	*/
+	void SetCamera( float x, float y );
+
+	//! 1フレーム進める
+	/*!
+		velocityの分だけ背景を動かす。
+	*/
+	void Update( void );
+
+	//! 背景を描画する
+	/*!
+		Cat_RenderBegin()とCat_RenderEnd()の間で呼ぶ。 \n
+		layernoが \a nLayerNo のレイヤーを、ファイルに現れた順に描画する。
+		@param[in]	nLayerNo	layerno(0はキャラクターの後ろ、1は手前)
+		@return	描画したタイル数
+	*/
+	uint32_t Draw( int32_t nLayerNo );
+
+	//! 統計情報を取得する
+	/*!
+		@param[out]	pStatistics		統計情報
+	*/
+	void GetStatistics( Statistics* pStatistics );
+
+	//! 統計情報をクリアする
+	void ResetStatistics( void );
+
+private:
+	boost::shared_ptr<class icStageImpl>	m_impl;		/*!< 実装	*/
+};
+
+} // namespace ic
+
+#endif // INCL_CLASS_icStage
@@ -5,9 +5,43 @@
 
 namespace ic {
 
+//! icTextureのチャンクのサイズ
+#define IC_TEXTURE_SLAB_CHUNK_SIZE (4096)
+
+//! icTextureの割り当て
+static Cat_Slab* gpTextureSlab = 0;
+//! 実装の割り当て
+static Cat_Slab* gpImplSlab = 0;
+
+//! 固定サイズの割り当てから確保する
+/*!
+	@param[in,out]	ppSlab	割り当て(0なら作成する)
+	@param[in]		nSize	サイズ(バイト単位)
+	@return	確保したメモリ。失敗した場合は0が返る。
+*/
+static void*
+SlabAlloc( Cat_Slab** ppSlab, size_t nSize )
+{
+	if(*ppSlab == 0) {
+		// 最初に作る時に用意する
+		*ppSlab = Cat_SlabCreate( nSize, IC_TEXTURE_SLAB_CHUNK_SIZE );
+	}
+	return Cat_SlabAlloc( *ppSlab );
+}
+
 //! 実装
 class icTextureImpl {
 public:
+	//! メモリを確保する
+	static void* operator new( size_t nSize ) throw() {
+		return SlabAlloc( &gpImplSlab, nSize );
+	}
+
+	//! メモリを解放する
+	static void operator delete( void* pv ) {
+		Cat_SlabFree( gpImplSlab, pv );
+	}
+
 	//! コンストラクタ
 	/*!
 		@param[in]	pTexture		テクスチャ
@@ -22,8 +56,10 @@ public:
 		, m_nItemNo( nItemNo )
 		, m_nDrawOffsetX( nDrawOffsetX )
 		, m_nDrawOffsetY( nDrawOffsetY )
-		, m_pvUserData( 0 )
+		, m_pResidency( 0 )
+		, m_nRef( 0 )
 	{
+		memset( m_anUserData, 0, sizeof(m_anUserData) );
 		if(m_pTexture) {
 			Cat_TextureAddRef( m_pTexture );	// 参照カウントを加算しとく
 		}
@@ -43,8 +79,10 @@ public:
 		, m_nItemNo( nItemNo )
 		, m_nDrawOffsetX( nDrawOffsetX )
 		, m_nDrawOffsetY( nDrawOffsetY )
-		, m_pvUserData( 0 )
+		, m_pResidency( 0 )
+		, m_nRef( 0 )
 	{
+		memset( m_anUserData, 0, sizeof(m_anUserData) );
 		if(m_pTexture) {
 			Cat_TextureAddRef( m_pTexture );	// 参照カウントを加算しとく
 		}
@@ -56,8 +94,17 @@ public:
 			Cat_TextureRelease( m_pTexture );
 			m_pTexture = 0;
 		}
-		if(m_pvUserData) {
-			CAT_FREE( m_pvUserData );
+	}
+
+	//! 参照カウンタを加算する
+	void AddRef( void ) {
+		m_nRef++;
+	}
+
+	//! 参照カウンタを減算して、0になったら削除する
+	void Release( void ) {
+		if(--m_nRef == 0) {
+			delete this;
 		}
 	}
 
@@ -95,9 +142,67 @@ public:
 
 	//! テクスチャを設定する
 	void SetTexture( void ) {
+		if(m_pResidency) {
+			m_pResidency->Touch( m_pTexture );
+		}
 		Cat_TextureSetTexture( m_pTexture );
 	}
 
+	//! テクスチャを描画する
+	/*!
+		@param[in]	x	描画位置X
+		@param[in]	y	描画位置Y
+		@param[in]	w	描画する横幅
+		@param[in]	h	描画する高さ
+	*/
+	void Draw( float x, float y, float w, float h ) {
+		if(m_pResidency) {
+			m_pResidency->Touch( m_pTexture );
+		}
+		Cat_TextureDraw( m_pTexture, x, y, w, h );
+	}
+
+	//! パレットを差し替えてテクスチャを描画する
+	/*!
+		@param[in]	x		描画位置X
+		@param[in]	y		描画位置Y
+		@param[in]	w		描画する横幅
+		@param[in]	h		描画する高さ
+		@param[in]	variant	描画の種類
+	*/
+	void Draw( float x, float y, float w, float h, const icDrawVariant& variant ) {
+		if(m_pResidency) {
+			m_pResidency->Touch( m_pTexture );
+		}
+		icDrawVariant::SetBlend( variant.GetBlend() );
+		Cat_TextureDrawEffect( m_pTexture, icDrawVariant::GetCache(), &variant.GetParam(), x, y, w, h );
+		icDrawVariant::SetBlend( icDrawVariant::eBLEND_ALPHA );
+	}
+
+	//! スプライトバッチに追加する
+	/*!
+		@param[in]	pBatch	バッチ
+		@param[in]	sprite	スプライト(テクスチャはこのテクスチャになる)
+		@return 正常終了時 true \n
+				溜められる数を超えた場合 false
+	*/
+	bool Draw( Cat_SpriteBatch* pBatch, const Cat_SpriteBatchSprite& sprite ) {
+		if(m_pResidency) {
+			m_pResidency->Touch( m_pTexture );
+		}
+		Cat_SpriteBatchSprite add( sprite );
+		add.pTexture = m_pTexture;
+		return Cat_SpriteBatchAdd( pBatch, &add ) >= 0;
+	}
+
+	//! libCatのテクスチャを取得する
+	/*!
+		@return	テクスチャ
+	*/
+	Cat_Texture* GetCatTexture( void ) {
+		return m_pTexture;
+	}
+
 	//! テクスチャの横幅を取得する
 	/*!
 		@return	テクスチャの横幅
@@ -157,15 +262,30 @@ public:
 		@return ユーザーデータ
 	*/
 	void* GetUserData( void ) {
-		return m_pvUserData;
+		return m_anUserData;
 	}
 
 	//! ユーザーデータを設定
 	/*!
 		@param[in]	pvUserData	ユーザーデータ
+		@param[in]	nSize		サイズ(バイト単位)
+		@return 正常終了時 true \n
+				サイズが大きすぎる場合 false
+	*/
+	bool SetUserData( const void* pvUserData, uint32_t nSize ) {
+		if(nSize > sizeof(m_anUserData)) {
+			return false;
+		}
+		memcpy( m_anUserData, pvUserData, nSize );
+		return true;
+	}
+
+	//! 常駐管理を設定する
+	/*!
+		@param[in]	pResidency	常駐管理(0の場合は解除)
 	*/
-	void SetUserData( void* pvUserData ) {
-		m_pvUserData = pvUserData;
+	void SetResidency( icTextureResidency* pResidency ) {
+		m_pResidency = pResidency;
 	}
 
 private:
@@ -174,9 +294,51 @@ private:
 	uint16_t		m_nItemNo;			/*!< グループ内番号					*/
 	int16_t			m_nDrawOffsetX;		/*!< 表示オフセットX(ドット単位)	*/
 	int16_t			m_nDrawOffsetY;		/*!< 表示オフセットY(ドット単位)	*/
-	void*			m_pvUserData;		/*!< ユーザーデータ					*/
+	icTextureResidency*	m_pResidency;	/*!< 常駐管理						*/
+	uint32_t		m_nRef;				/*!< 参照カウンタ					*/
+	uint32_t		m_anUserData[icTexture::USER_DATA_SIZE / 4];	/*!< ユーザーデータ	*/
 };
 
+//! 参照カウンタを加算する(boost::intrusive_ptr用)
+void
+intrusive_ptr_add_ref( icTextureImpl* p )
+{
+	p->AddRef();
+}
+
+//! 参照カウンタを減算する(boost::intrusive_ptr用)
+void
+intrusive_ptr_release( icTextureImpl* p )
+{
+	p->Release();
+}
+
+//! メモリを確保する
+void*
+icTexture::operator new( size_t nSize ) throw()
+{
+	return SlabAlloc( &gpTextureSlab, nSize );
+}
+
+//! メモリを解放する
+void
+icTexture::operator delete( void* pv )
+{
+	Cat_SlabFree( gpTextureSlab, pv );
+}
+
+//! 割り当ての統計情報を取得する
+/*!
+	@param[out]	pTexture	icTextureの統計情報(0の場合は取得しない)
+	@param[out]	pImpl		実装の統計情報(0の場合は取得しない)
+*/
+void
+icTexture::GetSlabStatistics( Cat_SlabStatistics* pTexture, Cat_SlabStatistics* pImpl )
+{
+	Cat_SlabGetStatistics( gpTextureSlab, pTexture );
+	Cat_SlabGetStatistics( gpImplSlab, pImpl );
+}
+
 //! コンストラクタ
 /*!
 	@param[in]	pTexture		テクスチャ
@@ -250,6 +412,61 @@ icTexture::SetTexture( void )
 	m_impl->SetTexture();
 }
 
+//! テクスチャを描画する
+/*!
+	分割されたテクスチャも描画できる。
+	@param[in]	x	描画位置X
+	@param[in]	y	描画位置Y
+	@param[in]	w	描画する横幅
+	@param[in]	h	描画する高さ
+*/
+void
+icTexture::Draw( float x, float y, float w, float h )
+{
+	m_impl->Draw( x, y, w, h );
+}
+
+//! パレットを差し替えてテクスチャを描画する
+/*!
+	影や残像のように、同じピクセルデータを別の色で描画する。 \n
+	パレットはicDrawVariantのキャッシュから取得して、ブレンドの方法も設定する。 \n
+	描画後は、ブレンドの方法を半透明に戻す。
+	@param[in]	x		描画位置X
+	@param[in]	y		描画位置Y
+	@param[in]	w		描画する横幅
+	@param[in]	h		描画する高さ
+	@param[in]	variant	描画の種類
+*/
+void
+icTexture::Draw( float x, float y, float w, float h, const icDrawVariant& variant )
+{
+	m_impl->Draw( x, y, w, h, variant );
+}
+
+//! スプライトバッチに追加する
+/*!
+	描画はCat_SpriteBatchFlush()でまとめて行われる。
+	@param[in]	pBatch	バッチ
+	@param[in]	sprite	スプライト(テクスチャはこのテクスチャになる)
+	@return 正常終了時 true \n
+			溜められる数を超えた場合 false
+*/
+bool
+icTexture::Draw( Cat_SpriteBatch* pBatch, const Cat_SpriteBatchSprite& sprite )
+{
+	return m_impl->Draw( pBatch, sprite );
+}
+
+//! libCatのテクスチャを取得する
+/*!
+	@return	テクスチャ
+*/
+Cat_Texture*
+icTexture::GetCatTexture( void )
+{
+	return m_impl->GetCatTexture();
+}
+
 //! テクスチャの横幅を取得する
 /*!
 	@return	テクスチャの横幅
@@ -314,6 +531,7 @@ icTexture::SetPalette( Cat_Palette* pPalette )
 
 //! ユーザーデータを取得
 /*!
+	テクスチャ内にあるUSER_DATA_SIZEバイトの領域を返す。設定していなければ0で埋まっている。
 	@return ユーザーデータ
 */
 void*
@@ -324,12 +542,28 @@ icTexture::GetUserData( void )
 
 //! ユーザーデータを設定
 /*!
+	内容をテクスチャ内にコピーするので、 \a pvUserData は呼び出し後に捨ててよい。
 	@param[in]	pvUserData	ユーザーデータ
+	@param[in]	nSize		サイズ(USER_DATA_SIZE以下、バイト単位)
+	@return 正常終了時 true \n
+			サイズが大きすぎる場合 false
+*/
+bool
+icTexture::SetUserData( const void* pvUserData, uint32_t nSize )
+{
+	return m_impl->SetUserData( pvUserData, nSize );
+}
+
+//! 常駐管理を設定する
+/*!
+	設定されていると、SetTexture()とDraw()でテクスチャを使用中にする。 \n
+	通常は、icTexturePool::SetResidency()から設定される。
+	@param[in]	pResidency	常駐管理(0の場合は解除)
 */
 void
-icTexture::SetUserData( void* pvUserData )
+icTexture::SetResidency( icTextureResidency* pResidency )
 {
-	m_impl->SetUserData( pvUserData );
+	m_impl->SetResidency( pResidency );
 }
 
 //! 演算子 <
@@ -8,9 +8,37 @@
 
 namespace ic {
 
+//! 実装
+class icTextureImpl;
+
+//! 参照カウンタを加算する(boost::intrusive_ptr用)
+void intrusive_ptr_add_ref( icTextureImpl* p );
+
+//! 参照カウンタを減算する(boost::intrusive_ptr用)
+void intrusive_ptr_release( icTextureImpl* p );
+
 //! テクスチャクラス
+/*!
+	キャラクター1体で数千個作られるので、本体と実装は固定サイズの割り当てから確保する。
+*/
 class icTexture {
 public:
+	//! ユーザーデータの最大サイズ(バイト単位)
+	enum { USER_DATA_SIZE = 16 };
+
+	//! メモリを確保する
+	static void* operator new( size_t nSize ) throw();
+
+	//! メモリを解放する
+	static void operator delete( void* pv );
+
+	//! 割り当ての統計情報を取得する
+	/*!
+		@param[out]	pTexture	icTextureの統計情報(0の場合は取得しない)
+		@param[out]	pImpl		実装の統計情報(0の場合は取得しない)
+	*/
+	static void GetSlabStatistics( Cat_SlabStatistics* pTexture, Cat_SlabStatistics* pImpl );
+
 	//! コンストラクタ
 	/*!
 		@param[in]	pTexture		テクスチャ
@@ -56,8 +84,50 @@ public:
 	int16_t GetDrawOffsetY( void ) const;
 
 	//! テクスチャを設定する
+	/*!
+		分割されたテクスチャは、左上の分割テクスチャが設定される。全体はDraw()で描画すること。
+	*/
 	void SetTexture( void );
 
+	//! テクスチャを描画する
+	/*!
+		分割されたテクスチャも描画できる。
+		@param[in]	x	描画位置X
+		@param[in]	y	描画位置Y
+		@param[in]	w	描画する横幅
+		@param[in]	h	描画する高さ
+	*/
+	void Draw( float x, float y, float w, float h );
+
+	//! パレットを差し替えてテクスチャを描画する
+	/*!
+		影や残像のように、同じピクセルデータを別の色で描画する。 \n
+		パレットはicDrawVariantのキャッシュから取得して、ブレンドの方法も設定する。 \n
+		描画後は、ブレンドの方法を半透明に戻す。
+		@param[in]	x		描画位置X
+		@param[in]	y		描画位置Y
+		@param[in]	w		描画する横幅
+		@param[in]	h		描画する高さ
+		@param[in]	variant	描画の種類
+	*/
+	void Draw( float x, float y, float w, float h, const icDrawVariant& variant );
+
+	//! スプライトバッチに追加する
+	/*!
+		描画はCat_SpriteBatchFlush()でまとめて行われる。
+		@param[in]	pBatch	バッチ
+		@param[in]	sprite	スプライト(テクスチャはこのテクスチャになる)
+		@return 正常終了時 true \n
+				溜められる数を超えた場合 false
+	*/
+	bool Draw( Cat_SpriteBatch* pBatch, const Cat_SpriteBatchSprite& sprite );
+
+	//! libCatのテクスチャを取得する
+	/*!
+		@return	テクスチャ
+	*/
+	Cat_Texture* GetCatTexture( void );
+
 	//! テクスチャの横幅を取得する
 	/*!
 		@return	テクスチャの横幅
@@ -98,18 +168,31 @@ public:
 
 	//! ユーザーデータを取得
 	/*!
+		テクスチャ内にあるUSER_DATA_SIZEバイトの領域を返す。設定していなければ0で埋まっている。
 		@return ユーザーデータ
 	*/
 	void* GetUserData( void );
 
 	//! ユーザーデータを設定
 	/*!
+		内容をテクスチャ内にコピーするので、 \a pvUserData は呼び出し後に捨ててよい。
 		@param[in]	pvUserData	ユーザーデータ
+		@param[in]	nSize		サイズ(USER_DATA_SIZE以下、バイト単位)
+		@return 正常終了時 true \n
+				サイズが大きすぎる場合 false
+	*/
+	bool SetUserData( const void* pvUserData, uint32_t nSize );
+
+	//! 常駐管理を設定する
+	/*!
+		設定されていると、SetTexture()とDraw()でテクスチャを使用中にする。 \n
+		通常は、icTexturePool::SetResidency()から設定される。
+		@param[in]	pResidency	常駐管理(0の場合は解除)
 	*/
-	void SetUserData( void* pvUserData );
+	void SetResidency( class icTextureResidency* pResidency );
 
 private:
-	boost::shared_ptr<class icTextureImpl>	m_impl;		/*!< 実装	*/
+	boost::intrusive_ptr<icTextureImpl>	m_impl;		/*!< 実装	*/
 };
 
 //! 演算子 <
@@ -2,11 +2,24 @@
 // テクスチャ管理
 
 #include "icCore.h"
+#include "Cat_TextureDXT.h"
 
 namespace ic {
 
+//! ピクセルデータの領域のブロックサイズ
+#define IC_TEXTUREPOOL_ARENA_BLOCK_SIZE (128 * 1024)
+
 icTexturePool::TextureCreator	icTexturePool::m_TextureCreator;	/*!< テクスチャ作成者	*/
 
+//! コンストラクタ
+icTexturePool::icTexturePool()
+	: m_pCreator( 0 )
+	, m_pResidency( 0 )
+	, m_pArena( 0 )
+	, m_fArena( true )
+{
+}
+
 //! テクスチャ作成者を登録する
 /*!
 	@param[in]	pCreator	登録するテクスチャ作成者
@@ -24,6 +37,29 @@ icTexturePool::GetTexture( void )
 	return m_pTexture;
 }
 
+//! ピクセルデータをまとめた領域に置くかを設定する
+/*!
+	Create()の前に呼ぶ。初期値はtrue。 \n
+	まとめた領域はブロック単位でしか解放されないので、icTextureResidencyで \n
+	1枚ずつ解放するプールはfalseにして、ピクセルデータをヒープに置く。
+	@param[in]	fArena	まとめた領域に置く場合true
+*/
+void
+icTexturePool::SetArena( bool fArena )
+{
+	m_fArena = fArena;
+}
+
+//! ピクセルデータの領域を取得する
+/*!
+	@return	領域。まとめた領域を使っていなければ0を返す。
+*/
+Cat_Arena*
+icTexturePool::GetArena( void )
+{
+	return m_pArena;
+}
+
 //! 作成する
 /*!
 	@param[in]	pStream	ストリーム
@@ -37,7 +73,18 @@ icTexturePool::Create( Cat_Stream* pStream, enumCreateFlag eCreateFlag )
 	for(TextureCreatorIt p = m_TextureCreator.begin(); p != m_TextureCreator.end(); p++) {
 		m_pCreator = *p;
 		if(m_pCreator->Check( pStream )) {
-			return m_pCreator->Create( this, pStream, eCreateFlag );
+			if(!m_fArena) {
+				return m_pCreator->Create( this, pStream, eCreateFlag );
+			}
+			// 一緒に捨てるので、ピクセルデータはまとめた領域に置く
+			if(m_pArena == 0) {
+				m_pArena = Cat_ArenaCreate( IC_TEXTUREPOOL_ARENA_BLOCK_SIZE );
+			}
+			Cat_Arena* pPrevious = Cat_TextureGetArena();
+			Cat_TextureSetArena( m_pArena );
+			const bool rc = m_pCreator->Create( this, pStream, eCreateFlag );
+			Cat_TextureSetArena( pPrevious );
+			return rc;
 		}
 	}
 	m_pCreator = 0;
@@ -52,6 +99,44 @@ icTexturePool::Release( void )
 		delete *p;
 	}
 	m_pTexture.clear();
+	if(m_pArena) {
+		// 残っている参照が無ければ、ここでブロックがまとめて解放される
+		Cat_ArenaRelease( m_pArena );
+		m_pArena = 0;
+	}
+}
+
+//! ピクセルデータを読み込み直す
+/*!
+	icTextureResidencyで解放されたピクセルデータを元に戻す。
+	@param[in]	pStream		Create()に渡したストリーム
+	@param[in]	pTexture	読み込み直すテクスチャ
+	@return 正常終了時 true \n
+			失敗時 false
+*/
+bool
+icTexturePool::Reload( Cat_Stream* pStream, icTexture* pTexture )
+{
+	if((m_pCreator == 0) || (pStream == 0) || (pTexture == 0)) {
+		return false;
+	}
+	return m_pCreator->Reload( this, pStream, pTexture );
+}
+
+//! 常駐管理を設定する
+/*!
+	設定されていると、Search()とSearchFromIndex()で見つかったテクスチャを使用中にする。
+	@param[in]	pResidency	常駐管理(0の場合は解除)
+*/
+void
+icTexturePool::SetResidency( icTextureResidency* pResidency )
+{
+	m_pResidency = pResidency;
+	for(TextureIt p = m_pTexture.begin(); p != m_pTexture.end(); p++) {
+		if(*p) {
+			(*p)->SetResidency( pResidency );
+		}
+	}
 }
 
 //! 定義されているテクスチャ数を返す
@@ -75,6 +160,9 @@ icTexturePool::SearchFromIndex( uint32_t nIndex )
 	if((nIndex < 0) || (nIndex >= GetTextureCount())) {
 		return 0;
 	}
+	if(m_pResidency && m_pTexture[nIndex]) {
+		m_pResidency->Touch( m_pTexture[nIndex]->GetCatTexture() );
+	}
 	return m_pTexture[nIndex];
 }
 
@@ -90,6 +178,9 @@ icTexturePool::Search( uint16_t nGroupNo, uint16_t nItemNo )
 {
 	for(TextureIt p = m_pTexture.begin(); p != m_pTexture.end(); p++) {
 		if(((*p)->GetGroupNo() == nGroupNo) && ((*p)->GetItemNo() == nItemNo)) {
+			if(m_pResidency) {
+				m_pResidency->Touch( (*p)->GetCatTexture() );
+			}
 			return (*p);
 		}
 	}
@@ -108,4 +199,53 @@ icTexturePool::SetAct( Cat_Palette* pPalette )
 	}
 }
 
+//! 統計情報を取得する
+/*!
+	@param[out]	pStatistics	統計情報
+*/
+void
+icTexturePool::GetStatistics( Statistics* pStatistics )
+{
+	if(pStatistics == 0) {
+		return;
+	}
+	memset( pStatistics, 0, sizeof(Statistics) );
+	if(m_pArena) {
+		Cat_ArenaStatistics arena;
+		Cat_ArenaGetStatistics( m_pArena, &arena );
+		pStatistics->nArenaSize       = arena.nReservedSize;
+		pStatistics->nArenaBlockCount = arena.nBlockCount;
+	}
+
+	// 共通イメージは同じCat_Textureを指しているので、1回だけ数える
+	std::map<Cat_Texture*,bool> counted;
+	for(TextureIt p = m_pTexture.begin(); p != m_pTexture.end(); p++) {
+		if(*p == 0) {
+			continue;
+		}
+		Cat_Texture* pTexture = (*p)->GetCatTexture();
+		if((pTexture == 0) || counted[pTexture]) {
+			continue;
+		}
+		counted[pTexture] = true;
+
+		pStatistics->nImageCount++;
+		pStatistics->nDataSize  += Cat_TextureGetDataSize( pTexture );
+		pStatistics->nSavedSize += pTexture->nSavedSize;
+		if(pTexture->ppTile) {
+			// 分割テクスチャは、最初の分割テクスチャで変換されたかを調べる
+			pTexture = pTexture->ppTile[0];
+		}
+		if((pTexture->ePixelFormat == FORMAT_PIXEL_CLUT4) && pTexture->pPalette4) {
+			pStatistics->nConvert4Count++;
+		}
+		if(Cat_TextureDXTIsFormat( pTexture->ePixelFormat )) {
+			pStatistics->nConvertDXTCount++;
+		}
+		if(pTexture->ePixelFormat <= FORMAT_PIXEL_4444) {
+			pStatistics->nFormat16Count++;
+		}
+	}
+}
+
 } // namespace ic
@@ -11,6 +11,9 @@ namespace ic {
 //! テクスチャ作成者
 class icTextureCreator;
 
+//! テクスチャの常駐管理
+class icTextureResidency;
+
 //! テクスチャプール
 class icTexturePool {
 public:
@@ -19,6 +22,9 @@ public:
 	typedef std::vector<icTextureCreator*> TextureCreator;
 	typedef std::vector<icTextureCreator*>::iterator TextureCreatorIt;
 
+	//! コンストラクタ
+	icTexturePool();
+
 	//! テクスチャ作成者を登録する
 	/*!
 		@param[in]	pCreator	登録するテクスチャ作成者
@@ -35,6 +41,21 @@ public:
 		eCREATE_FLAG_THUMB_ONLY,		/*!< サムネイルのみ作成		*/
 	};
 
+	//! ピクセルデータをまとめた領域に置くかを設定する
+	/*!
+		Create()の前に呼ぶ。初期値はtrue。 \n
+		まとめた領域はブロック単位でしか解放されないので、icTextureResidencyで \n
+		1枚ずつ解放するプールはfalseにして、ピクセルデータをヒープに置く。
+		@param[in]	fArena	まとめた領域に置く場合true
+	*/
+	void SetArena( bool fArena );
+
+	//! ピクセルデータの領域を取得する
+	/*!
+		@return	領域。まとめた領域を使っていなければ0を返す。
+	*/
+	Cat_Arena* GetArena( void );
+
 	//! 作成する
 	/*!
 		@param[in]	pStream	ストリーム
@@ -45,8 +66,29 @@ public:
 	bool Create( Cat_Stream* pStream, enumCreateFlag eCreateFlag = eCREATE_FLAG_ALL );
 
 	//! 解放する
+	/*!
+		ピクセルデータとパレットデータは、Create()で作った領域ごと解放される。 \n
+		ほかで参照が残っているテクスチャがあれば、領域はそれが解放されるまで残る。
+	*/
 	void Release( void );
 
+	//! ピクセルデータを読み込み直す
+	/*!
+		icTextureResidencyで解放されたピクセルデータを元に戻す。
+		@param[in]	pStream		Create()に渡したストリーム
+		@param[in]	pTexture	読み込み直すテクスチャ
+		@return 正常終了時 true \n
+				失敗時 false
+	*/
+	bool Reload( Cat_Stream* pStream, icTexture* pTexture );
+
+	//! 常駐管理を設定する
+	/*!
+		設定されていると、Search()とSearchFromIndex()で見つかったテクスチャを使用中にする。
+		@param[in]	pResidency	常駐管理(0の場合は解除)
+	*/
+	void SetResidency( icTextureResidency* pResidency );
+
 	//! 定義されているテクスチャ数を返す
 	/*!
 		@return 定義されているテクスチャ数
@@ -80,10 +122,31 @@ public:
 		@param[in]	pAct			設定するパレット
 	*/
 	void SetAct( icAct* pAct ) { if(pAct) { SetAct( pAct->GetPalette() ); } }
+
+	//! 統計情報
+	struct Statistics {
+		uint32_t	nImageCount;		/*!< イメージ数(共通イメージは数えない)		*/
+		uint32_t	nDataSize;			/*!< ピクセルデータのサイズ(バイト単位)		*/
+		uint32_t	nConvert4Count;		/*!< 4bitに変換されたイメージ数				*/
+		uint32_t	nConvertDXTCount;	/*!< DXT圧縮されたイメージ数				*/
+		uint32_t	nFormat16Count;		/*!< 16bitのイメージ数						*/
+		uint32_t	nSavedSize;			/*!< 変換で削減されたサイズ(バイト単位)		*/
+		uint32_t	nArenaSize;			/*!< ピクセルデータの領域のサイズ(バイト単位)	*/
+		uint32_t	nArenaBlockCount;	/*!< ピクセルデータの領域のブロック数		*/
+	};
+
+	//! 統計情報を取得する
+	/*!
+		@param[out]	pStatistics	統計情報
+	*/
+	void GetStatistics( Statistics* pStatistics );
 private:
 	Texture					m_pTexture;			/*!< テクスチャ			*/
 	static TextureCreator	m_TextureCreator;	/*!< テクスチャ作成者	*/
 	icTextureCreator*		m_pCreator;			/*!< テクスチャ作成者	*/
+	icTextureResidency*		m_pResidency;		/*!< 常駐管理			*/
+	Cat_Arena*				m_pArena;			/*!< ピクセルデータの領域	*/
+	bool					m_fArena;			/*!< 領域を使うかどうか	*/
 };
 
 //! テクスチャ作成者
@@ -115,6 +178,16 @@ public:
 		@param[in]	pPalette		設定するパレット
 	*/
 	virtual void SetAct( icTexturePool* pTexturePool, Cat_Palette* pPalette ) {}
+
+	//! ピクセルデータを読み込み直す
+	/*!
+		@param[in]	pTexturePool	テクスチャプール
+		@param[in]	pStream			作成した時のストリーム
+		@param[in]	pTexture		読み込み直すテクスチャ
+		@return 正常終了時 true \n
+				失敗時 false
+	*/
+	virtual bool Reload( icTexturePool* pTexturePool, Cat_Stream* pStream, icTexture* pTexture ) { return false; }
 };
 
 
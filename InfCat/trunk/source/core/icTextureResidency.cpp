@@ -0,0 +1,269 @@
+//! @file	icTextureResidency.cpp
+// テクスチャの常駐管理
+
+#include "icCore.h"
+
+namespace ic {
+
+//! 実装
+class icTextureResidencyImpl {
+public:
+	typedef std::list<Cat_Texture*> Lru;
+	typedef std::list<Cat_Texture*>::iterator LruIt;
+
+	//! テクスチャごとの情報
+	struct Entry {
+		icTexture*	pTexture;		/*!< 読み込み直しに使うテクスチャ		*/
+		uint32_t	nSize;			/*!< ピクセルデータのサイズ				*/
+		uint32_t	nLastFrame;		/*!< 最後に使ったフレーム				*/
+		bool		fResident;		/*!< 常駐しているかどうか				*/
+		bool		fArena;			/*!< ピクセルデータがプールの領域にあるか	*/
+		LruIt		itLru;			/*!< 使用順のリストでの位置				*/
+	};
+	typedef std::map<Cat_Texture*,Entry> EntryMap;
+	typedef std::map<Cat_Texture*,Entry>::iterator EntryMapIt;
+
+	//! ピクセルデータがまとめた領域にあるかを調べる
+	/*!
+		@param[in]	pTexture	テクスチャ
+		@return	まとめた領域にある場合true
+	*/
+	static bool IsOnArena( Cat_Texture* pTexture ) {
+		if(pTexture->ppTile) {
+			// 分割テクスチャは、最初の分割テクスチャで調べる
+			pTexture = pTexture->ppTile[0];
+		}
+		return pTexture->pArena != 0;
+	}
+
+	//! コンストラクタ
+	/*!
+		@param[in]	pTexturePool	テクスチャプール(作成済みのもの)
+		@param[in]	pStream			テクスチャプールを作成したストリーム
+		@param[in]	nBudget			ピクセルデータの上限(バイト単位)
+	*/
+	icTextureResidencyImpl( icTexturePool* pTexturePool, Cat_Stream* pStream, uint32_t nBudget )
+		: m_pTexturePool( pTexturePool )
+		, m_pStream( pStream )
+		, m_nBudget( nBudget )
+		, m_nResidentBytes( 0 )
+		, m_nFrame( 1 )
+	{
+		memset( &m_statistics, 0, sizeof(m_statistics) );
+
+		// 共通イメージは同じCat_Textureを指しているので、まとめて管理する
+		icTexturePool::Texture& texture = m_pTexturePool->GetTexture();
+		for(icTexturePool::TextureIt p = texture.begin(); p != texture.end(); p++) {
+			if((*p == 0) || ((*p)->GetCatTexture() == 0)) {
+				continue;
+			}
+			Cat_Texture* pTexture = (*p)->GetCatTexture();
+			if(m_entry.find( pTexture ) != m_entry.end()) {
+				continue;
+			}
+			Entry& entry = m_entry[pTexture];
+			entry.pTexture   = *p;
+			entry.nSize      = Cat_TextureGetDataSize( pTexture );
+			entry.nLastFrame = 0;
+			entry.fResident  = Cat_TextureIsLoaded( pTexture );
+			entry.fArena     = entry.fResident && IsOnArena( pTexture );
+			if(entry.fResident) {
+				entry.itLru = m_lru.insert( m_lru.end(), pTexture );
+				if(!entry.fArena) {
+					m_nResidentBytes += entry.nSize;	// まとめた領域の分は、ブロックのサイズで数える
+				}
+			}
+		}
+	}
+
+	//! 上限を設定する
+	/*!
+		@param[in]	nBudget		ピクセルデータの上限(バイト単位)
+	*/
+	void SetBudget( uint32_t nBudget ) {
+		m_nBudget = nBudget;
+	}
+
+	//! テクスチャを使用中にする
+	/*!
+		@param[in]	pTexture	テクスチャ
+	*/
+	void Touch( Cat_Texture* pTexture ) {
+		EntryMapIt it = m_entry.find( pTexture );
+		if(it == m_entry.end()) {
+			return;
+		}
+		Entry& entry = it->second;
+		entry.nLastFrame = m_nFrame;
+		if(entry.fResident) {
+			// 使用順のリストの先頭へ
+			m_lru.splice( m_lru.begin(), m_lru, entry.itLru );
+			return;
+		}
+
+		// 解放されていたので、読み込み直すまで待つ
+		const uint64_t nStart = sceKernelGetSystemTimeWide();
+		if(m_pTexturePool->Reload( m_pStream, entry.pTexture )) {
+			entry.nSize     = Cat_TextureGetDataSize( pTexture );
+			entry.fResident = true;
+			entry.fArena    = IsOnArena( pTexture );
+			entry.itLru     = m_lru.insert( m_lru.begin(), pTexture );
+			if(!entry.fArena) {
+				m_nResidentBytes += entry.nSize;
+			}
+			m_statistics.nReloadCount++;
+		} else {
+			m_statistics.nReloadFailCount++;
+		}
+		m_statistics.nReloadTime += (uint32_t)(sceKernelGetSystemTimeWide() - nStart);
+	}
+
+	//! 常駐しているサイズを取得する
+	/*!
+		@return	ヒープに置いたピクセルデータと、まとめた領域のブロックの合計(バイト単位)
+	*/
+	uint32_t GetResidentBytes( void ) {
+		uint32_t rc = m_nResidentBytes;
+		Cat_Arena* pArena = m_pTexturePool->GetArena();
+		if(pArena) {
+			Cat_ArenaStatistics arena;
+			Cat_ArenaGetStatistics( pArena, &arena );
+			rc += arena.nReservedSize;
+		}
+		return rc;
+	}
+
+	//! フレームを進める
+	void Update( void ) {
+		uint32_t nResidentBytes = GetResidentBytes();
+		LruIt it = m_lru.end();
+		while((nResidentBytes > m_nBudget) && (it != m_lru.begin())) {
+			--it;
+			Cat_Texture* pTexture = *it;
+			Entry& entry = m_entry[pTexture];
+			if(entry.nLastFrame == m_nFrame) {
+				break;	// 残りは全部このフレームで使っている
+			}
+			if(Cat_TextureIsPinned( pTexture )) {
+				continue;	// 記録したリストが参照しているので、解放できない
+			}
+			it = m_lru.erase( it );
+			Cat_TextureUnload( pTexture );
+			entry.fResident = false;
+			if(!entry.fArena) {
+				m_nResidentBytes -= entry.nSize;
+			}
+			// まとめた領域は、ブロックが空いた時だけ減る
+			const uint32_t nPrevious = nResidentBytes;
+			nResidentBytes = GetResidentBytes();
+			m_statistics.nEvictCount++;
+			m_statistics.nEvictBytes += nPrevious - nResidentBytes;
+		}
+		if(nResidentBytes > m_nBudget) {
+			m_statistics.nOverBudgetCount++;
+		}
+		m_statistics.nFrameCount++;
+		m_nFrame++;
+	}
+
+	//! 統計情報を取得する
+	/*!
+		@param[out]	pStatistics	統計情報
+	*/
+	void GetStatistics( icTextureResidency::Statistics* pStatistics ) {
+		*pStatistics = m_statistics;
+		pStatistics->nBudget        = m_nBudget;
+		pStatistics->nResidentBytes = GetResidentBytes();
+		pStatistics->nResidentCount = m_lru.size();
+		pStatistics->nImageCount    = m_entry.size();
+	}
+
+	//! 統計情報の回数をクリアする
+	void ResetStatistics( void ) {
+		memset( &m_statistics, 0, sizeof(m_statistics) );
+	}
+
+private:
+	icTexturePool*					m_pTexturePool;		/*!< テクスチャプール			*/
+	Cat_Stream*						m_pStream;			/*!< 読み込み直すストリーム		*/
+	uint32_t						m_nBudget;			/*!< 上限						*/
+	uint32_t						m_nResidentBytes;	/*!< ヒープに常駐しているサイズ	*/
+	uint32_t						m_nFrame;			/*!< 今のフレーム				*/
+	EntryMap						m_entry;			/*!< テクスチャごとの情報		*/
+	Lru								m_lru;				/*!< 常駐しているテクスチャ(使用順)	*/
+	icTextureResidency::Statistics	m_statistics;		/*!< 統計情報					*/
+};
+
+//! コンストラクタ
+/*!
+	@param[in]	pTexturePool	テクスチャプール(icTexturePool::SetArena( false )で作成済みのもの)
+	@param[in]	pStream			テクスチャプールを作成したストリーム(破棄するまで閉じないこと)
+	@param[in]	nBudget			ピクセルデータの上限(バイト単位)
+*/
+icTextureResidency::icTextureResidency( icTexturePool* pTexturePool, Cat_Stream* pStream, uint32_t nBudget )
+	: m_impl( new icTextureResidencyImpl( pTexturePool, pStream, nBudget ) )
+	, m_pTexturePool( pTexturePool )
+{
+	m_pTexturePool->SetResidency( this );
+}
+
+//! デストラクタ
+icTextureResidency::~icTextureResidency()
+{
+	m_pTexturePool->SetResidency( 0 );
+}
+
+//! 上限を設定する
+/*!
+	@param[in]	nBudget		ピクセルデータの上限(バイト単位)
+*/
+void
+icTextureResidency::SetBudget( uint32_t nBudget )
+{
+	m_impl->SetBudget( nBudget );
+}
+
+//! テクスチャを使用中にする
+/*!
+	ピクセルデータが解放されていたら、その場で読み込み直す。
+	@param[in]	pTexture	テクスチャ
+*/
+void
+icTextureResidency::Touch( Cat_Texture* pTexture )
+{
+	m_impl->Touch( pTexture );
+}
+
+//! フレームを進める
+/*!
+	1フレームに1回、Cat_RenderScreenUpdate()の後に呼ぶ。 \n
+	上限を超えていたら、最後に使われたのが古いテクスチャから解放する。 \n
+	描画中のパケットが参照しているので、このフレームで使ったテクスチャは解放しない。 \n
+	Cat_DisplayListが記録したテクスチャ(Cat_TexturePin()で固定されたもの)も解放しない。
+*/
+void
+icTextureResidency::Update( void )
+{
+	m_impl->Update();
+}
+
+//! 統計情報を取得する
+/*!
+	@param[out]	pStatistics	統計情報
+*/
+void
+icTextureResidency::GetStatistics( Statistics* pStatistics )
+{
+	if(pStatistics) {
+		m_impl->GetStatistics( pStatistics );
+	}
+}
+
+//! 統計情報の回数をクリアする
+void
+icTextureResidency::ResetStatistics( void )
+{
+	m_impl->ResetStatistics();
+}
+
+} // namespace ic
@@ -0,0 +1,86 @@
+//! @file	icTextureResidency.h
+// テクスチャの常駐管理
+
+#ifndef INCL_CLASS_icTextureResidency
+#define INCL_CLASS_icTextureResidency
+
+#include "icTexturePool.h"
+
+namespace ic {
+
+//! テクスチャの常駐管理
+/*!
+	テクスチャプールのピクセルデータを、決められたサイズに収まるように管理する。 \n
+	上限を超えたら最後に使われたのが古いテクスチャからピクセルデータを解放して、 \n
+	次に使われた時にストリームから読み込み直す。 \n
+	サイズは実際に確保しているバイト数で数える(まとめた領域はブロックのサイズで数える)。 \n
+	まとめた領域はブロックが空くまで解放されないので、テクスチャプールは \n
+	icTexturePool::SetArena( false )にしてから作成すること。 \n
+	テクスチャプールより先に破棄すること。
+*/
+class icTextureResidency : boost::noncopyable {
+public:
+	//! コンストラクタ
+	/*!
+		@param[in]	pTexturePool	テクスチャプール(icTexturePool::SetArena( false )で作成済みのもの)
+		@param[in]	pStream			テクスチャプールを作成したストリーム(破棄するまで閉じないこと)
+		@param[in]	nBudget			ピクセルデータの上限(バイト単位)
+	*/
+	icTextureResidency( icTexturePool* pTexturePool, Cat_Stream* pStream, uint32_t nBudget );
+
+	//! デストラクタ
+	~icTextureResidency();
+
+	//! 上限を設定する
+	/*!
+		@param[in]	nBudget		ピクセルデータの上限(バイト単位)
+	*/
+	void SetBudget( uint32_t nBudget );
+
+	//! テクスチャを使用中にする
+	/*!
+		ピクセルデータが解放されていたら、その場で読み込み直す。
+		@param[in]	pTexture	テクスチャ
+	*/
+	void Touch( Cat_Texture* pTexture );
+
+	//! フレームを進める
+	/*!
+		1フレームに1回、Cat_RenderScreenUpdate()の後に呼ぶ。 \n
+		上限を超えていたら、最後に使われたのが古いテクスチャから解放する。 \n
+		描画中のパケットが参照しているので、このフレームで使ったテクスチャは解放しない。 \n
+		Cat_DisplayListが記録したテクスチャ(Cat_TexturePin()で固定されたもの)も解放しない。
+	*/
+	void Update( void );
+
+	//! 統計情報
+	struct Statistics {
+		uint32_t	nBudget;			/*!< 上限(バイト単位)							*/
+		uint32_t	nResidentBytes;		/*!< 常駐しているサイズ(バイト単位、まとめた領域はブロックのサイズ)	*/
+		uint32_t	nResidentCount;		/*!< 常駐しているイメージ数						*/
+		uint32_t	nImageCount;		/*!< 管理しているイメージ数						*/
+		uint32_t	nFrameCount;		/*!< Update()の呼び出し回数						*/
+		uint32_t	nEvictCount;		/*!< 解放した回数								*/
+		uint32_t	nEvictBytes;		/*!< 実際に解放されたサイズ(バイト単位)			*/
+		uint32_t	nReloadCount;		/*!< 読み込み直しで待った回数					*/
+		uint32_t	nReloadFailCount;	/*!< 読み込み直しに失敗した回数					*/
+		uint32_t	nReloadTime;		/*!< 読み込み直しで待った時間(マイクロ秒単位)	*/
+		uint32_t	nOverBudgetCount;	/*!< 上限に収まらなかったフレーム数				*/
+	};
+
+	//! 統計情報を取得する
+	/*!
+		@param[out]	pStatistics	統計情報
+	*/
+	void GetStatistics( Statistics* pStatistics );
+
+	//! 統計情報の回数をクリアする
+	void ResetStatistics( void );
+private:
+	boost::shared_ptr<class icTextureResidencyImpl>	m_impl;			/*!< 実装				*/
+	icTexturePool*									m_pTexturePool;	/*!< テクスチャプール	*/
+};
+
+} // namespace ic
+
+#endif // INCL_CLASS_icTextureResidency
@@ -2,7 +2,7 @@
 #include <pspthreadman.h>
 
 PSP_MODULE_INFO( "InfCat", PSP_MODULE_USER, 1, 1);
-PSP_MAIN_THREAD_ATTR(PSP_THREAD_ATTR_USER);
+PSP_MAIN_THREAD_ATTR(PSP_THREAD_ATTR_USER | PSP_THREAD_ATTR_VFPU);
 
 PSP_HEAP_SIZE_MAX();
 PSP_MAIN_THREAD_STACK_SIZE_KB(128);
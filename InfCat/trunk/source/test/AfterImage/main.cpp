@@ -0,0 +1,168 @@
+//! @file	main.cpp
+// 影と残像 - テスト用
+//
+// test.sffの先頭のイメージを左右に動かしながら、影と残像を描画する。
+// 毎フレーム、残像の位置とアルファが、記録した位置と間隔から計算したものと同じかを確認する。
+// パレットは最初の数フレームで作った後は作り直されず(GEが描画中のフレームのパレットも上書きされない)、
+// 溢れもしないことを確認する。
+
+#include "icCore.h"
+
+using namespace ic;
+
+//! 読み込むファイル名
+#define FILENAME "test.sff"
+//! 描画するフレーム数
+#define FRAME_COUNT (300)
+//! 残像の数
+#define AFTERIMAGE_COUNT (6)
+//! 残像の間隔(フレーム単位)
+#define AFTERIMAGE_INTERVAL (3)
+//! 一番新しい残像のアルファ
+#define AFTERIMAGE_ALPHA (CAT_PALETTEEFFECT_UNIT * 3 / 4)
+//! 記録しないフレームの間隔(描画しないフレームがあっても残像がずれないかを見る)
+#define SKIP_INTERVAL (50)
+
+//! 記録した位置
+struct Position {
+	bool	fRecorded;		/*!< 記録したか	*/
+	float	x;				/*!< 描画位置X	*/
+	float	y;				/*!< 描画位置Y	*/
+};
+
+//! 残像が記録どおりかを確認する
+/*!
+	@param[in]	afterImage	残像
+	@param[in]	history		フレームごとに記録した位置
+	@return	同じなら描画される残像の数 \n
+			違うなら負数を返す
+*/
+static int32_t
+CheckTrail( const icAfterImage& afterImage, const std::vector<Position>& history )
+{
+	icAfterImage::Trail trail[AFTERIMAGE_COUNT + 1];
+	const uint32_t nTrail = afterImage.GetTrail( trail, AFTERIMAGE_COUNT + 1 );
+	const uint32_t nRecorded = history.size();
+	uint32_t n = 0;
+
+	// 古いもの順に並んでいるはず
+	for(uint32_t i = AFTERIMAGE_COUNT; i > 0; i--) {
+		const uint32_t nAge = i * AFTERIMAGE_INTERVAL;
+		if((nAge >= nRecorded) || !history[nRecorded - 1 - nAge].fRecorded) {
+			continue;
+		}
+		const Position& position = history[nRecorded - 1 - nAge];
+		const uint32_t nAlpha = AFTERIMAGE_ALPHA * (AFTERIMAGE_COUNT + 1 - i) / (AFTERIMAGE_COUNT + 1);
+		if((n >= nTrail) || (trail[n].nAge != nAge) || (trail[n].nAlpha != nAlpha)
+		|| (trail[n].x != position.x) || (trail[n].y != position.y)) {
+			return -1;
+		}
+		// 新しいものほど濃い
+		if((n > 0) && (trail[n].nAlpha <= trail[n - 1].nAlpha)) {
+			return -1;
+		}
+		n++;
+	}
+	return (n == nTrail) ? (int32_t)n : -1;
+}
+
+int
+main()
+{
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	icTextureCreatorSff sff;	// SFFテクスチャ作成の登録
+
+	Cat_Stream* pStream = Cat_StreamFileReadOpen( FILENAME );
+	if(pStream == 0) {
+		TRACE(( "%s not found", FILENAME ));
+		HALT();
+	}
+	icTexturePool pool;
+	if(!pool.Create( pStream )) {
+		TRACE(( "%s load failed", FILENAME ));
+		HALT();
+	}
+	Cat_StreamClose( pStream );
+	icTexture* pTexture = pool.SearchFromIndex( 0 );
+	if(pTexture == 0) {
+		TRACE(( "no image" ));
+		HALT();
+	}
+
+	const float w = (float)pTexture->GetWidth();
+	const float h = (float)pTexture->GetHeight();
+	const icDrawVariant shadow = icDrawVariant::Solid( 0x000000, CAT_PALETTEEFFECT_UNIT / 2 );
+	uint32_t nDraw = 0;
+	uint32_t nExpectDraw = 0;
+	uint32_t nMismatch = 0;
+	uint32_t nBuildAfterWarmup = 0;
+
+	Cat_RenderInit( CAT_RENDER_DEFAULT );
+	{
+		icAfterImage afterImage( AFTERIMAGE_COUNT, AFTERIMAGE_INTERVAL );
+		afterImage.SetVariant( icDrawVariant::Tint( 0x4080FF, AFTERIMAGE_ALPHA, icDrawVariant::eBLEND_ADD ) );
+		std::vector<Position> history;
+
+		for(uint32_t nFrame = 0; nFrame < FRAME_COUNT; nFrame++) {
+			// 画面の端で折り返す
+			const uint32_t nRange = (480 - (uint32_t)w) * 2;
+			uint32_t nPos = (nFrame * 4) % nRange;
+			if(nPos > nRange / 2) {
+				nPos = nRange - nPos;
+			}
+			const float x = (float)nPos;
+			const float y = 272.0f - h - 16.0f;
+
+			const int32_t nTrail = CheckTrail( afterImage, history );
+			if(nTrail < 0) {
+				nMismatch++;
+			} else {
+				nExpectDraw += nTrail;
+			}
+
+			Cat_PaletteEffectStatistics before;
+			icDrawVariant::GetStatistics( &before );
+			Cat_RenderBegin(); {
+				// 影は足元に平たく描画する
+				pTexture->Draw( x, y + h * 0.75f, w, h / 4.0f, shadow );
+				nDraw += afterImage.Draw();
+				pTexture->Draw( x, y, w, h );
+			} Cat_RenderEnd();
+			Cat_RenderScreenUpdate();
+			Position position;
+			position.fRecorded = ((nFrame % SKIP_INTERVAL) != SKIP_INTERVAL - 1);
+			position.x = x;
+			position.y = y;
+			history.push_back( position );
+			afterImage.Record( position.fRecorded ? pTexture : 0, x, y, w, h );
+			icDrawVariant::Update();
+
+			// 残像が揃った後は、キャッシュのパレットだけで描画できるはず
+			Cat_PaletteEffectStatistics after;
+			icDrawVariant::GetStatistics( &after );
+			if(nFrame > AFTERIMAGE_COUNT * AFTERIMAGE_INTERVAL) {
+				nBuildAfterWarmup += after.nBuildCount - before.nBuildCount;
+			}
+		}
+	}
+	Cat_RenderTerm();
+
+	Cat_PaletteEffectStatistics statistics;
+	icDrawVariant::GetStatistics( &statistics );
+	pspDebugScreenInit();
+	TRACE(( "frames:%d afterimage draws:%d expected:%d mismatch:%d\n", FRAME_COUNT, (int)nDraw, (int)nExpectDraw, (int)nMismatch ));
+	TRACE(( "palette request:%d hit:%d build:%d overflow:%d used:%d\n", (int)statistics.nRequestCount,
+		(int)statistics.nHitCount, (int)statistics.nBuildCount, (int)statistics.nOverflowCount, (int)statistics.nUsedCount ));
+	TRACE(( "build after warmup:%d\n", (int)nBuildAfterWarmup ));
+	const bool fOK = (nMismatch == 0) && (nDraw == nExpectDraw) && (nDraw > 0)
+		&& (nBuildAfterWarmup == 0) && (statistics.nOverflowCount == 0);
+	TRACE(( fOK ? "OK\n" : "NG\n" ));
+	icDrawVariant::DestroyCache();
+	pool.Release();
+
+	TRACE(( "done.\n" ));
+	HALT();
+	return 0;
+}
@@ -0,0 +1,231 @@
+//! @file	main.cpp
+// 4bitへの変換 - テスト用
+//
+// 16色以下のイメージと17色以上に見えるイメージを並べたsffをメモリ上に作り、4bitに変換するオプションを付けて読み込む。
+// テクスチャプールの統計情報の、4bitに変換されたイメージ数と削減されたサイズが、テクスチャごとの値の合計になることを確認する。
+// ACTを設定した後と、ACTを更新した後に、4bitのパレットが新しいパレットを並べ替えたものになることも確認する。
+
+#include "icCore.h"
+#include "Cat_StreamMemory.h"
+
+using namespace ic;
+
+//! イメージの数(共通イメージを含む)
+#define IMAGE_COUNT (4)
+
+//! イメージの定義
+struct Image {
+	uint16_t	nGroupNo;		/*!< グループ番号						*/
+	uint16_t	nItemNo;		/*!< グループ内番号						*/
+	uint16_t	nLinkIndex;		/*!< 共通イメージの元(自分ならイメージ)	*/
+	uint32_t	nWidth;			/*!< 横幅								*/
+	uint32_t	nHeight;		/*!< 高さ								*/
+	uint32_t	nColorCount;	/*!< 使う色数							*/
+	uint32_t	nIndexMul;		/*!< 番号に掛ける値						*/
+	uint32_t	nIndexAdd;		/*!< 番号に足す値						*/
+	bool		fConvert4;		/*!< 4bitになるかどうか					*/
+};
+
+//! イメージ
+/*!
+	余白は0番で埋まるので、0番を使わない16色のイメージに余白があると、17色になって4bitにならない。
+*/
+static const Image gImage[IMAGE_COUNT] = {
+	{ 0, 0, 0, 40, 20, 10, 25, 3, true  },	// 10色と余白
+	{ 1, 0, 1, 24, 12, 16, 15, 1, false },	// 16色と余白
+	{ 1, 1, 0,  0,  0,  0,  0, 0, false },	// 0番の共通イメージ
+	{ 2, 0, 3, 32, 16, 16, 16, 0, true  },	// 0番を含む16色で余白なし
+};
+
+//! イメージのピクセルの番号を取得する
+static uint8_t
+GetIndex( const Image& image, uint32_t x, uint32_t y )
+{
+	return (uint8_t)(((x / 3 + y) % image.nColorCount) * image.nIndexMul + image.nIndexAdd);
+}
+
+//! 値を書き込む
+template <typename T>
+static void
+Write( std::vector<uint8_t>& data, uint32_t nPos, T value )
+{
+	memcpy( &data[nPos], &value, sizeof(T) );
+}
+
+//! sffを作る
+/*!
+	PCXは圧縮しない(0xC0以上の番号だけ長さ1の連続にする)。パレットは番号 * nMulの色。
+	@param[in]	nMul	パレットの色を作る時に番号に掛ける値
+	@return	sffのデータ
+*/
+static std::vector<uint8_t>
+CreateSff( uint32_t nMul )
+{
+	std::vector<uint8_t> data( 512, 0 );
+	memcpy( &data[0], "ElecbyteSpr", 12 );
+	Write<uint32_t>( data, 16, 3 );				// グループ数
+	Write<uint32_t>( data, 20, IMAGE_COUNT );	// イメージ数
+	Write<uint32_t>( data, 24, 512 );			// オフセット
+	Write<uint32_t>( data, 28, 32 );			// イメージヘッダのサイズ
+	Write<uint32_t>( data, 32, 0 );				// パレットタイプ
+
+	for(uint32_t i = 0; i < IMAGE_COUNT; i++) {
+		const Image& image = gImage[i];
+		const uint32_t nHeader = data.size();
+		data.resize( nHeader + 32, 0 );
+		Write<uint16_t>( data, nHeader + 12, image.nGroupNo );
+		Write<uint16_t>( data, nHeader + 14, image.nItemNo );
+		Write<uint16_t>( data, nHeader + 16, image.nLinkIndex );
+		if(image.nLinkIndex == i) {
+			// PCXヘッダ
+			const uint32_t nPcx = data.size();
+			data.resize( nPcx + 128, 0 );
+			data[nPcx + 0] = 0x0A;
+			data[nPcx + 1] = 5;
+			data[nPcx + 2] = 1;
+			data[nPcx + 3] = 8;
+			Write<uint16_t>( data, nPcx + 8, image.nWidth - 1 );
+			Write<uint16_t>( data, nPcx + 10, image.nHeight - 1 );
+			data[nPcx + 65] = 1;
+			Write<uint16_t>( data, nPcx + 66, image.nWidth );
+			for(uint32_t y = 0; y < image.nHeight; y++) {
+				for(uint32_t x = 0; x < image.nWidth; x++) {
+					const uint8_t nIndex = GetIndex( image, x, y );
+					if(nIndex >= 0xC0) {
+						data.push_back( 0xC1 );
+					}
+					data.push_back( nIndex );
+				}
+			}
+			data.push_back( 12 );
+			for(uint32_t n = 0; n < 256; n++) {
+				const uint32_t nColor = n * nMul;
+				data.push_back( (uint8_t)nColor );
+				data.push_back( (uint8_t)(nColor >> 8) );
+				data.push_back( (uint8_t)(nColor >> 16) );
+			}
+			Write<uint32_t>( data, nHeader + 4, data.size() - nPcx );
+		}
+		if(i + 1 < IMAGE_COUNT) {
+			Write<uint32_t>( data, nHeader, data.size() );
+		}
+	}
+	return data;
+}
+
+//! 4bitのパレットが、元のパレットを変換テーブルで並べ替えたものになっているか調べる
+/*!
+	@param[in]	pTexture	テクスチャ
+	@return	違っている色の数
+*/
+static uint32_t
+CheckPalette4( Cat_Texture* pTexture )
+{
+	if((pTexture->ePixelFormat != FORMAT_PIXEL_CLUT4) || (pTexture->pPalette4 == 0)) {
+		return 0;
+	}
+	Cat_Palette* pPalette4 = Cat_TextureGetDrawPalette( pTexture );
+	uint32_t nError = 0;
+	for(uint32_t i = 0; i < 16; i++) {
+		if(Cat_PaletteGetColor( pPalette4, i ) != Cat_PaletteGetColor( pTexture->pPalette, pTexture->tbl4to8[i] )) {
+			nError++;
+		}
+	}
+	return nError;
+}
+
+int
+main()
+{
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	icTextureCreatorSff sff;	// SFFテクスチャ作成の登録
+
+	std::vector<uint8_t> data = CreateSff( 0x010203 );
+	Cat_Stream* pStream = Cat_StreamMemoryReadOpen( &data[0], data.size(), 0 );
+	icTexturePool pool;
+	Cat_TextureSetOption( CAT_TEXTURE_OPTION_CLUT4 );
+	const bool fCreate = pStream && pool.Create( pStream );
+	Cat_TextureSetOption( CAT_TEXTURE_OPTION_DEFAULT );
+	Cat_StreamClose( pStream );
+	if(!fCreate || (pool.GetTextureCount() != IMAGE_COUNT)) {
+		TRACE(( "sff load failed\n" ));
+		HALT();
+	}
+
+	// テクスチャごとの値を、共通イメージを除いて合計する
+	uint32_t nFail = 0;
+	uint32_t nImageCount = 0;
+	uint32_t nConvert4Count = 0;
+	uint32_t nSavedSize = 0;
+	uint32_t nDataSize = 0;
+	for(uint32_t i = 0; i < IMAGE_COUNT; i++) {
+		Cat_Texture* pTexture = pool.GetTexture()[i]->GetCatTexture();
+		const bool fConvert4 = (pTexture->ePixelFormat == FORMAT_PIXEL_CLUT4);
+		TRACE(( "image%d format:%d size:%d saved:%d\n", (int)i, (int)pTexture->ePixelFormat,
+			(int)Cat_TextureGetDataSize( pTexture ), (int)pTexture->nSavedSize ));
+		if(gImage[i].nLinkIndex != i) {
+			if(pTexture != pool.GetTexture()[gImage[i].nLinkIndex]->GetCatTexture()) {
+				nFail++;
+			}
+			continue;
+		}
+		if(fConvert4 != gImage[i].fConvert4) {
+			nFail++;
+		}
+		// 8bitのピッチは16バイト、4bitのピッチは128ビット単位で、高さはどちらも8の倍数
+		const uint32_t nSize8 = ((gImage[i].nWidth + 15) & ~15) * ((gImage[i].nHeight + 7) & ~7);
+		const uint32_t nSize4 = (((gImage[i].nWidth * 4 + 127) & ~127) / 8) * ((gImage[i].nHeight + 7) & ~7);
+		if(pTexture->nSavedSize != (fConvert4 ? nSize8 - nSize4 : 0)) {
+			nFail++;
+		}
+		nImageCount++;
+		nConvert4Count += fConvert4 ? 1 : 0;
+		nSavedSize += pTexture->nSavedSize;
+		nDataSize  += Cat_TextureGetDataSize( pTexture );
+	}
+	icTexturePool::Statistics statistics;
+	pool.GetStatistics( &statistics );
+	TRACE(( "images:%d clut4:%d data:%d saved:%d\n", (int)statistics.nImageCount, (int)statistics.nConvert4Count,
+		(int)statistics.nDataSize, (int)statistics.nSavedSize ));
+	if((statistics.nImageCount != nImageCount) || (statistics.nConvert4Count != nConvert4Count)
+		|| (statistics.nSavedSize != nSavedSize) || (statistics.nDataSize != nDataSize)
+		|| (nConvert4Count != 2) || (nSavedSize == 0)) {
+		nFail++;
+	}
+
+	// ACTを設定して、ACTを更新する(0番のイメージにACTが設定される)
+	uint32_t nPaletteError = 0;
+	Cat_Palette* pAct = Cat_PaletteCreate( FORMAT_PALETTE_8888, 256, 0 );
+	if(pAct == 0) {
+		TRACE(( "Error:Cat_PaletteCreate\n" ));
+		HALT();
+	}
+	Cat_Texture* pTexture0 = pool.GetTexture()[0]->GetCatTexture();
+	for(uint32_t n = 0; n < 2; n++) {
+		for(uint32_t i = 0; i < 256; i++) {
+			((uint32_t*)pAct->pvData)[i] = 0xFF000000 | (((i * 0x030201) ^ (n ? 0x408040 : 0x808080)) & 0xFFFFFF);
+		}
+		Cat_PaletteUpdate( pAct );
+		pool.SetAct( pAct );
+		if(pTexture0->pPalette != pAct) {
+			nFail++;
+		}
+		for(uint32_t i = 0; i < IMAGE_COUNT; i++) {
+			nPaletteError += CheckPalette4( pool.GetTexture()[i]->GetCatTexture() );
+		}
+		const uint8_t nIndex = GetIndex( gImage[0], 4, 2 );
+		if(Cat_TextureGetPixel( pTexture0, 4, 2 ) != ((uint32_t*)pAct->pvData)[nIndex]) {
+			nFail++;
+		}
+	}
+	TRACE(( "palette error:%d\n", (int)nPaletteError ));
+	TRACE(( ((nFail == 0) && (nPaletteError == 0)) ? "OK\n" : "NG\n" ));
+
+	pool.Release();
+	Cat_PaletteRelease( pAct );
+
+	HALT();
+	return 0;
+}
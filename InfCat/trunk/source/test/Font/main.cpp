@@ -0,0 +1,135 @@
+//! @file	main.cpp
+// フォント - テスト用
+//
+// test.fntで、コンボの数(少しずつ変わる)とメニュー(変わらない)を1画面分描画する。
+// まとめて描画した場合、文字列ごとに描画した場合、1文字ごとに描画した場合の時間と描画回数を比べて、
+// まとめた場合は使ったバンクの数(2回)で描画できることを確認する。
+
+#include "icCore.h"
+#include <stdio.h>
+
+using namespace ic;
+
+//! 読み込むファイル名
+#define FILENAME "test.fnt"
+//! 描画するフレーム数
+#define FRAME_COUNT (120)
+//! コンボの数の表示数
+#define COUNTER_COUNT (16)
+//! メニューの行数
+#define MENU_COUNT (24)
+
+//! メニューの文字列
+static const char* gpszMenu[] = {
+	"ARCADE", "VERSUS", "TEAM ARCADE", "TEAM VERSUS", "TEAM CO-OP", "SURVIVAL",
+	"SURVIVAL CO-OP", "TRAINING", "WATCH", "OPTIONS", "EXIT", "DIFFICULTY 4",
+	"LIFE 100%", "TIME LIMIT 99", "GAME SPEED NORMAL", "WAV VOLUME 80", "MIDI VOLUME 60", "KEY CONFIG",
+	"JOYSTICK CONFIG", "DEFAULT VALUES", "RETURN TO MAIN MENU", "PLAYER 1", "PLAYER 2", "ROUND 1",
+};
+
+//! 描画の方法
+enum {
+	eMODE_BATCH,		/*!< まとめて描画する			*/
+	eMODE_TEXT,			/*!< 文字列ごとに描画する		*/
+	eMODE_GLYPH,		/*!< 1文字ごとに描画する		*/
+
+	eMODE_MAX
+};
+
+//! 文字列を描画の方法に合わせて溜める
+/*!
+	@param[in]	font	フォント
+	@param[in]	nMode	描画の方法
+	@param[in]	x		描画位置X
+	@param[in]	y		描画位置Y
+	@param[in]	str		文字列
+	@param[in]	nBank	パレットのバンク
+*/
+static void
+DrawText( icFont& font, int32_t nMode, float x, float y, const std::string& str, uint32_t nBank )
+{
+	switch(nMode) {
+		case eMODE_BATCH:
+			font.Draw( x, y, str, nBank );
+			break;
+		case eMODE_TEXT:
+			font.Draw( x, y, str, nBank );
+			font.Flush();
+			break;
+		default:
+			for(uint32_t i = 0; i < str.size(); i++) {
+				const std::string strChar( 1, str[i] );
+				font.Draw( x, y, strChar, nBank );
+				font.Flush();
+				x += (float)(font.GetTextWidth( strChar ) + 1);
+			}
+			break;
+	}
+}
+
+int
+main()
+{
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	Cat_Stream* pStream = Cat_StreamFileReadOpen( FILENAME );
+	if(pStream == 0) {
+		TRACE(( "%s not found", FILENAME ));
+		HALT();
+	}
+	icFont font;
+	if(!font.Load( pStream )) {
+		TRACE(( "%s load failed", FILENAME ));
+		HALT();
+	}
+	Cat_StreamClose( pStream );
+
+	// メニューとコンボの数は、バンクがあれば別の色にする
+	const uint32_t nCounterBank = (font.GetBankCount() > 1) ? 1 : 0;
+	const float fLine = (float)(font.GetHeight() + 2);
+	uint32_t nTime[eMODE_MAX];
+	icFont::Statistics statistics[eMODE_MAX];
+
+	Cat_RenderInit( CAT_RENDER_DEFAULT );
+	for(int32_t nMode = 0; nMode < eMODE_MAX; nMode++) {
+		font.ResetStatistics();
+		nTime[nMode] = 0;
+		for(uint32_t nFrame = 0; nFrame < FRAME_COUNT; nFrame++) {
+			const uint32_t nStart = sceKernelGetSystemTimeLow();
+			Cat_RenderBegin(); {
+				for(uint32_t i = 0; i < MENU_COUNT; i++) {
+					DrawText( font, nMode, 8.0f, 8.0f + fLine * (float)i, gpszMenu[i], 0 );
+				}
+				for(uint32_t i = 0; i < COUNTER_COUNT; i++) {
+					// 下の方ほどゆっくり増える
+					char szCounter[32];
+					snprintf( szCounter, sizeof(szCounter), "%d HITS", (int)(nFrame / (i + 1)) );
+					DrawText( font, nMode, 300.0f, 8.0f + fLine * (float)i, szCounter, nCounterBank );
+				}
+				font.Flush();
+			} Cat_RenderEnd();
+			nTime[nMode] += sceKernelGetSystemTimeLow() - nStart;
+			Cat_RenderScreenUpdate();
+		}
+		font.GetStatistics( &statistics[nMode] );
+	}
+	Cat_RenderTerm();
+
+	static const char* pszMode[eMODE_MAX] = { "batch", "text ", "glyph" };
+	pspDebugScreenInit();
+	TRACE(( "height:%d banks:%d atlas:%dx%d\n", (int)font.GetHeight(), (int)font.GetBankCount(),
+		(int)font.GetAtlas()->nTextureWidth, (int)font.GetAtlas()->nTextureHeight ));
+	for(int32_t nMode = 0; nMode < eMODE_MAX; nMode++) {
+		const icFont::Statistics& s = statistics[nMode];
+		TRACE(( "%s: %5dus/frame draws/frame:%d glyphs/frame:%d cache hit:%d miss:%d\n", pszMode[nMode],
+			(int)(nTime[nMode] / FRAME_COUNT), (int)(s.nBatchCount / FRAME_COUNT), (int)(s.nGlyphCount / FRAME_COUNT),
+			(int)s.nCacheHitCount, (int)s.nCacheMissCount ));
+	}
+	const uint32_t nBatchPerFrame = statistics[eMODE_BATCH].nBatchCount / FRAME_COUNT;
+	TRACE(( ((nBatchPerFrame <= 2) && (statistics[eMODE_BATCH].nDropCount == 0)) ? "OK\n" : "NG\n" ));
+
+	font.Release();
+	HALT();
+	return 0;
+}
@@ -0,0 +1,296 @@
+//! @file	main.cpp
+// HUD - テスト用
+//
+// 体力ゲージ、パワーゲージ、タイマー、顔グラに見立てた、たくさんのスプライトでできた部品を並べた合成HUDを描画する。
+// 部品ごとに値の変わる間隔を変えてあり、毎フレームそのまま描画した場合と、描画先に残した場合の時間とスプライト数を比べる。
+// 描画先に残した場合は、値が変わった回数だけ描き直したことと、スプライト数が減ったことを確認する。
+// フレームバッファが5650の場合は、描画先を使わずにそのまま描画することも確認する。
+
+#include "icCore.h"
+#include <stdio.h>
+
+using namespace ic;
+
+//! 描画するフレーム数
+#define FRAME_COUNT (600)
+//! 5650で描画するフレーム数
+#define FRAME_COUNT_5650 (10)
+//! 部品の数
+#define ELEMENT_COUNT (32)
+//! ゲージの高さ
+#define GAUGE_HEIGHT (10)
+//! 目盛りの横幅
+#define SEGMENT_WIDTH (2)
+//! 顔グラの大きさ
+#define FACE_SIZE (32)
+
+//! 今のフレーム番号
+static uint32_t gnFrame = 0;
+//! 部品が描画に使うバッチ
+static Cat_SpriteBatch* gpBatch = 0;
+//! ゲージの枠
+static Cat_Texture* gpFrame = 0;
+//! ゲージの目盛り
+static Cat_Texture* gpFill = 0;
+//! 顔グラ(四隅が透明)
+static Cat_Texture* gpFace = 0;
+
+//! 1色のテクスチャを作る
+/*!
+	@param[in]	nSize	大きさ
+	@param[in]	nColor	色(0xAABBGGRR)
+	@param[in]	fRound	四隅を透明にするかどうか
+	@return	テクスチャ
+*/
+static Cat_Texture*
+CreateTexture( uint32_t nSize, uint32_t nColor, bool fRound )
+{
+	uint32_t* pnImage = (uint32_t*)malloc( nSize * nSize * sizeof(uint32_t) );
+	if(pnImage == 0) {
+		return 0;
+	}
+	const int32_t nRadius = (int32_t)nSize / 2;
+	for(int32_t y = 0; y < (int32_t)nSize; y++) {
+		for(int32_t x = 0; x < (int32_t)nSize; x++) {
+			const int32_t dx = x - nRadius;
+			const int32_t dy = y - nRadius;
+			pnImage[x + y * nSize] = (fRound && (dx * dx + dy * dy > nRadius * nRadius)) ? 0 : nColor;
+		}
+	}
+	Cat_Texture* rc = Cat_TextureCreate( nSize, nSize, nSize * sizeof(uint32_t), pnImage, FORMAT_PIXEL_8888, 0 );
+	free( pnImage );
+	return rc;
+}
+
+//! ゲージ
+/*!
+	枠の上に、値の数だけ目盛りを並べる。値は \a nPeriod フレームごとに1つ減って、0の次は満タンに戻る。
+*/
+class Gauge : public icHudElement {
+public:
+	//! コンストラクタ
+	/*!
+		@param[in]	nPeriod		値が変わる間隔(フレーム数)
+		@param[in]	nSegment	目盛りの数
+	*/
+	Gauge( uint32_t nPeriod, uint32_t nSegment )
+		: m_nPeriod( nPeriod )
+		, m_nSegment( nSegment )
+	{
+	}
+
+	//! 横幅を取得する
+	uint32_t GetWidth( void ) const {
+		return m_nSegment * SEGMENT_WIDTH + 2;
+	}
+
+	//! 高さを取得する
+	uint32_t GetHeight( void ) const {
+		return GAUGE_HEIGHT;
+	}
+
+	//! 見た目を決める入力をまとめた値を取得する
+	virtual uint32_t GetKey( void ) {
+		return icHud::Hash( 0, GetValue() );
+	}
+
+	//! 描画する
+	virtual void Draw( float x, float y ) {
+		Cat_SpriteBatchSprite sprite;
+		Cat_SpriteBatchSpriteInit( &sprite );
+		sprite.pTexture = gpFrame;
+		sprite.x        = x;
+		sprite.y        = y;
+		sprite.fScaleX  = (float)GetWidth() / (float)gpFrame->nOriginalWidth;
+		sprite.fScaleY  = (float)GetHeight() / (float)gpFrame->nOriginalHeight;
+		Cat_SpriteBatchAdd( gpBatch, &sprite );
+
+		const uint32_t nValue = GetValue();
+		sprite.pTexture = gpFill;
+		sprite.y        = y + 1.0f;
+		sprite.fScaleX  = (float)SEGMENT_WIDTH / (float)gpFill->nOriginalWidth;
+		sprite.fScaleY  = (float)(GetHeight() - 2) / (float)gpFill->nOriginalHeight;
+		sprite.nLayer   = 1;
+		for(uint32_t i = 0; i < nValue; i++) {
+			sprite.x = x + 1.0f + (float)(i * SEGMENT_WIDTH);
+			Cat_SpriteBatchAdd( gpBatch, &sprite );
+		}
+		Cat_SpriteBatchFlush( gpBatch );
+	}
+
+private:
+	//! 値を取得する
+	uint32_t GetValue( void ) const {
+		return m_nSegment - (gnFrame / m_nPeriod) % (m_nSegment + 1);
+	}
+
+	uint32_t	m_nPeriod;		/*!< 値が変わる間隔		*/
+	uint32_t	m_nSegment;		/*!< 目盛りの数			*/
+};
+
+//! 顔グラ
+/*!
+	\a nPeriod フレームごとに、アニメーションのコマが進んで少し揺れる。
+*/
+class Face : public icHudElement {
+public:
+	//! コンストラクタ
+	/*!
+		@param[in]	nPeriod		コマが進む間隔(フレーム数)
+	*/
+	Face( uint32_t nPeriod )
+		: m_nPeriod( nPeriod )
+	{
+	}
+
+	//! 見た目を決める入力をまとめた値を取得する
+	virtual uint32_t GetKey( void ) {
+		return icHud::Hash( 0, GetAnimation() );
+	}
+
+	//! 描画する
+	virtual void Draw( float x, float y ) {
+		Cat_SpriteBatchSprite sprite;
+		Cat_SpriteBatchSpriteInit( &sprite );
+		sprite.pTexture = gpFace;
+		sprite.x        = x + (float)GetAnimation();
+		sprite.y        = y;
+		Cat_SpriteBatchAdd( gpBatch, &sprite );
+		Cat_SpriteBatchFlush( gpBatch );
+	}
+
+private:
+	//! アニメーションのコマを取得する
+	uint32_t GetAnimation( void ) const {
+		return (gnFrame / m_nPeriod) % 4;
+	}
+
+	uint32_t	m_nPeriod;		/*!< コマが進む間隔		*/
+};
+
+int
+main()
+{
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	gpBatch = Cat_SpriteBatchCreate( 1024 );
+	gpFrame = CreateTexture( 8, 0xFF404040, false );
+	gpFill  = CreateTexture( 8, 0xFF00C0FF, false );
+	gpFace  = CreateTexture( FACE_SIZE, 0xFFC08060, true );
+	if((gpBatch == 0) || (gpFrame == 0) || (gpFill == 0) || (gpFace == 0)) {
+		TRACE(( "create failed" ));
+		HALT();
+	}
+
+	// 上に体力ゲージと顔グラ、下にパワーゲージ、真ん中にタイマー、残りはコンボの数などに見立てた小さいゲージ
+	icHud hud;
+	std::vector<icHudElement*> element;
+	element.push_back( new Face( 8 ) );
+	hud.Add( element.back(), 4.0f, 4.0f, FACE_SIZE + 4, FACE_SIZE );
+	element.push_back( new Face( 12 ) );
+	hud.Add( element.back(), 440.0f, 4.0f, FACE_SIZE + 4, FACE_SIZE );
+	static const uint32_t anPeriod[4] = { 7, 11, 2, 3 };
+	static const float afPosition[4][2] = { { 44.0f, 8.0f }, { 314.0f, 8.0f }, { 8.0f, 256.0f }, { 412.0f, 256.0f } };
+	for(uint32_t i = 0; i < 4; i++) {
+		Gauge* pGauge = new Gauge( anPeriod[i], (i < 2) ? 60 : 30 );
+		element.push_back( pGauge );
+		hud.Add( pGauge, afPosition[i][0], afPosition[i][1], pGauge->GetWidth(), pGauge->GetHeight() );
+	}
+	{
+		Gauge* pGauge = new Gauge( 60, 10 );
+		element.push_back( pGauge );
+		hud.Add( pGauge, 229.0f, 24.0f, pGauge->GetWidth(), pGauge->GetHeight() );
+	}
+	while(element.size() < ELEMENT_COUNT) {
+		const uint32_t n = element.size();
+		Gauge* pGauge = new Gauge( 20 + (n % 5) * 15, 20 );
+		element.push_back( pGauge );
+		hud.Add( pGauge, (float)(8 + (n % 4) * 120), (float)(60 + (n / 4) * 20), pGauge->GetWidth(), pGauge->GetHeight() );
+	}
+
+	// 0:そのまま描画する 1:描画先に残す
+	uint32_t nTime[2] = { 0, 0 };
+	uint32_t nGeTime[2] = { 0, 0 };
+	uint32_t nSprite[2] = { 0, 0 };
+	uint32_t nExpect = 0;
+	icHud::Statistics statistics[2];
+	Cat_RenderInit( CAT_RENDER_DEFAULT | CAT_RENDER_PARAM_TARGET );
+	for(int32_t nMode = 0; nMode < 2; nMode++) {
+		std::vector<uint32_t> key( element.size(), 0 );
+		hud.SetCache( nMode != 0 );
+		hud.ResetStatistics();
+		Cat_SpriteBatchResetStatistics( gpBatch );
+		for(gnFrame = 0; gnFrame < FRAME_COUNT; gnFrame++) {
+			if(nMode != 0) {
+				// 描き直すはずの部品の数を数えておく
+				for(uint32_t i = 0; i < element.size(); i++) {
+					const uint32_t nKey = element[i]->GetKey();
+					if((gnFrame == 0) || (nKey != key[i])) {
+						nExpect++;
+					}
+					key[i] = nKey;
+				}
+			}
+			const uint32_t nStart = sceKernelGetSystemTimeLow();
+			Cat_RenderBegin(); {
+				hud.Draw();
+			} Cat_RenderEnd();
+			nTime[nMode] += sceKernelGetSystemTimeLow() - nStart;
+			Cat_RenderScreenUpdate();
+			// 渡したフレームをGEが描画し終わるまでの時間
+			const uint32_t nGeStart = sceKernelGetSystemTimeLow();
+			sceGuSync( 0, 0 );
+			nGeTime[nMode] += sceKernelGetSystemTimeLow() - nGeStart;
+		}
+		hud.GetStatistics( &statistics[nMode] );
+		Cat_SpriteBatchStatistics batch;
+		Cat_SpriteBatchGetStatistics( gpBatch, &batch );
+		nSprite[nMode] = batch.nSpriteCount;
+	}
+	Cat_RenderTerm();
+
+	// 5650はアルファが無いので、描画先に残す設定でもそのまま描画するはず
+	icHud::Statistics statistics5650;
+	Cat_RenderInit( CAT_RENDER_PARAM_FORMAT_RGBA5650 | CAT_RENDER_PARAM_BUFFER_DOUBLE | CAT_RENDER_PARAM_TARGET );
+	hud.SetCache( true );
+	hud.Invalidate();
+	hud.ResetStatistics();
+	for(gnFrame = 0; gnFrame < FRAME_COUNT_5650; gnFrame++) {
+		Cat_RenderBegin(); {
+			hud.Draw();
+		} Cat_RenderEnd();
+		Cat_RenderScreenUpdate();
+	}
+	hud.GetStatistics( &statistics5650 );
+	Cat_RenderTerm();
+
+	static const char* pszMode[2] = { "direct", "cached" };
+	pspDebugScreenInit();
+	TRACE(( "elements:%d frames:%d\n", (int)hud.GetCount(), FRAME_COUNT ));
+	for(int32_t nMode = 0; nMode < 2; nMode++) {
+		const icHud::Statistics& s = statistics[nMode];
+		TRACE(( "%s: cpu %5dus/frame ge %5dus/frame sprites/frame:%d redraw:%d cached:%d direct:%d target:%d batch:%d\n",
+			pszMode[nMode], (int)(nTime[nMode] / FRAME_COUNT), (int)(nGeTime[nMode] / FRAME_COUNT),
+			(int)(nSprite[nMode] / FRAME_COUNT), (int)s.nRedrawCount, (int)s.nCacheCount, (int)s.nDirectCount,
+			(int)s.nTargetCount, (int)s.nBatchCount ));
+	}
+	TRACE(( "expected redraw:%d invalidate:%d\n", (int)nExpect, (int)statistics[1].nInvalidateCount ));
+	TRACE(( "5650: target:%d cached:%d direct:%d\n", (int)statistics5650.nTargetCount, (int)statistics5650.nCacheCount,
+		(int)statistics5650.nDirectCount ));
+	const bool fOK = (statistics[1].nRedrawCount == nExpect) && (statistics[1].nDirectCount == 0)
+		&& (nSprite[1] < nSprite[0])
+		&& (statistics5650.nTargetCount == 0) && (statistics5650.nCacheCount == 0)
+		&& (statistics5650.nDirectCount == FRAME_COUNT_5650 * hud.GetCount());
+	TRACE(( fOK ? "OK\n" : "NG\n" ));
+
+	for(uint32_t i = 0; i < element.size(); i++) {
+		delete element[i];
+	}
+	Cat_TextureRelease( gpFace );
+	Cat_TextureRelease( gpFill );
+	Cat_TextureRelease( gpFrame );
+	Cat_SpriteBatchDestroy( gpBatch );
+	HALT();
+	return 0;
+}
@@ -0,0 +1,119 @@
+//! @file	main.cpp
+// テクスチャの常駐管理 - テスト用
+//
+// test.sffの全イメージを、全体の1/4の上限で順番に描画していく。
+// 上限を守れているかと、読み込み直したイメージが元と同じかを確認する。
+
+#include "icCore.h"
+
+using namespace ic;
+
+//! 読み込むファイル名
+#define FILENAME "test.sff"
+//! 1フレームで描画するイメージ数
+#define DRAW_COUNT (8)
+//! 全イメージを何周するか
+#define CYCLE_COUNT (3)
+
+//! ピクセルデータのチェックサムを計算する
+static uint32_t
+Checksum( Cat_Texture* pTexture )
+{
+	const uint32_t w = Cat_TextureGetWidth( pTexture );
+	const uint32_t h = Cat_TextureGetHeight( pTexture );
+	const uint32_t nPitch = w * Cat_TextureGetRegionPixelSize( pTexture, CAT_TEXTURE_REGION_RAW );
+	std::vector<uint8_t> buffer( nPitch * h + 1 );
+	uint32_t rc = 0;
+
+	if(Cat_TextureGetRegion( pTexture, 0, 0, w, h, &buffer[0], nPitch, CAT_TEXTURE_REGION_RAW ) < 0) {
+		return 0;
+	}
+	for(uint32_t i = 0; i < nPitch * h; i++) {
+		rc = (rc * 31) + buffer[i];
+	}
+	return rc;
+}
+
+int
+main()
+{
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	icTextureCreatorSff sff;	// SFFテクスチャ作成の登録
+
+	// 読み込み直しに使うので、最後まで閉じない
+	Cat_Stream* pStream = Cat_StreamFileReadOpen( FILENAME );
+	if(pStream == 0) {
+		TRACE(( "%s not found", FILENAME ));
+		HALT();
+	}
+	// 1枚ずつ解放するので、ピクセルデータはまとめた領域に置かない
+	icTexturePool pool;
+	pool.SetArena( false );
+	if(!pool.Create( pStream )) {
+		TRACE(( "%s load failed", FILENAME ));
+		HALT();
+	}
+
+	// 元のチェックサム
+	std::map<Cat_Texture*,uint32_t> checksum;
+	for(uint32_t i = 0; i < pool.GetTextureCount(); i++) {
+		icTexture* pTexture = pool.GetTexture()[i];
+		if(pTexture && pTexture->GetCatTexture()) {
+			checksum[pTexture->GetCatTexture()] = Checksum( pTexture->GetCatTexture() );
+		}
+	}
+	icTexturePool::Statistics poolStatistics;
+	pool.GetStatistics( &poolStatistics );
+	const uint32_t nBudget = poolStatistics.nDataSize / 4;
+
+	Cat_RenderInit( CAT_RENDER_DEFAULT );
+	{
+		icTextureResidency residency( &pool, pStream, nBudget );
+		icTextureResidency::Statistics statistics;
+		uint32_t nOverBudget = 0;
+		uint32_t nIndex = 0;
+
+		TRACE(( "images:%d data:%dKB arena:%dKB budget:%dKB\n", (int)poolStatistics.nImageCount, (int)(poolStatistics.nDataSize / 1024),
+			(int)(poolStatistics.nArenaSize / 1024), (int)(nBudget / 1024) ));
+		while(nIndex < pool.GetTextureCount() * CYCLE_COUNT) {
+			Cat_RenderBegin(); {
+				for(uint32_t i = 0; i < DRAW_COUNT; i++, nIndex++) {
+					icTexture* pTexture = pool.SearchFromIndex( nIndex % pool.GetTextureCount() );
+					if(pTexture) {
+						pTexture->Draw( (float)(i * 60), 100.0f, 60.0f, 60.0f );
+					}
+				}
+			} Cat_RenderEnd();
+			Cat_RenderScreenUpdate();
+			residency.Update();
+
+			// このフレームで描画した分しか上限を超えてはいけない
+			residency.GetStatistics( &statistics );
+			if(statistics.nResidentBytes > statistics.nBudget) {
+				nOverBudget++;
+			}
+		}
+		residency.GetStatistics( &statistics );
+		TRACE(( "frames:%d resident:%dKB(%d/%d) over budget:%d\n", (int)statistics.nFrameCount,
+			(int)(statistics.nResidentBytes / 1024), (int)statistics.nResidentCount, (int)statistics.nImageCount, (int)nOverBudget ));
+		TRACE(( "evict:%d(%dKB) reload:%d fail:%d stall:%dus\n", (int)statistics.nEvictCount, (int)(statistics.nEvictBytes / 1024),
+			(int)statistics.nReloadCount, (int)statistics.nReloadFailCount, (int)statistics.nReloadTime ));
+
+		// 読み込み直したイメージが元と同じか
+		uint32_t nError = 0;
+		for(std::map<Cat_Texture*,uint32_t>::iterator p = checksum.begin(); p != checksum.end(); p++) {
+			if(Cat_TextureIsLoaded( p->first ) && (Checksum( p->first ) != p->second)) {
+				nError++;
+			}
+		}
+		TRACE(( "checksum error:%d\n", (int)nError ));
+	}
+	Cat_StreamClose( pStream );
+	Cat_RenderTerm();
+
+	TRACE(( "done.\n" ));
+	HALT();
+	return 0;
+}
@@ -1,15 +1,26 @@
 #include "icCore.h"
 #include "icGame.h"
 #include "icGameSffViewer.h"
+#include <pspdisplay.h>
 
 namespace ic {
 
 //! ゲーム
 icGame* icGame::m_pGame = 0;
+//! パイプライン
+Cat_FramePipeline* icGame::m_pPipeline = 0;
+//! 描画するスレッドの優先度
+int32_t icGame::m_nPriority = 0;
+//! 描画するスレッドが動いているか
+bool icGame::m_fThread = false;
+//! PauseRender()した回数
+uint32_t icGame::m_nPause = 0;
 
 //! メインループ
 /*!
-	ゲームのメインループの処理を行う
+	ゲームのメインループの処理を行う \n
+	Framemove()とRender()でスナップショットを書いて、描画するスレッドへ渡す。 \n
+	描画するスレッドが動いている場合は、垂直同期を待って1フレームの間隔に合わせる。
 	@return ゲームループを継続する場合はtrue \n
 			ゲームループを終了する場合はfalseを返す
 */
@@ -17,13 +28,82 @@ bool
 icGame::MainLoop( void )
 {
 	bool rc = true;
-	if(m_pGame) {
+	if(m_pGame && m_pPipeline) {
+		Cat_FrameSnapshot* pSnapshot = Cat_FramePipelineBeginSnapshot( m_pPipeline );
 		rc = m_pGame->Framemove();
-		m_pGame->Render();
+		m_pGame->Render( pSnapshot );
+		Cat_FramePipelineSubmit( m_pPipeline );
+	}
+	if(m_fThread) {
+		sceDisplayWaitVblankStart();
+	} else if(m_pPipeline) {
+		// スレッドが無いので、今までと同じようにここで描画する
+		Cat_FramePipelineRender( m_pPipeline );
 	}
 	return rc;
 }
 
+//! 描画するスレッドを開始する
+/*!
+	Cat_RenderInit()の後に呼ぶ。スレッドを作れなかった場合は、MainLoop()の中で描画する。
+	@param[in]	nSpriteMax	1フレームのスプライト数
+	@param[in]	nPriority	描画するスレッドの優先度(ゲームの処理をするスレッドより高くする)
+	@return 正常終了時 true \n
+			失敗時 false
+*/
+bool
+icGame::StartRender( uint32_t nSpriteMax, int32_t nPriority )
+{
+	StopRender();
+	m_pPipeline = Cat_FramePipelineCreate( nSpriteMax, 0, 0 );
+	if(m_pPipeline == 0) {
+		return false;
+	}
+	m_nPriority = nPriority;
+	m_nPause    = 0;
+	m_fThread   = Cat_FramePipelineStart( m_pPipeline, m_nPriority ) >= 0;
+	return true;
+}
+
+//! 描画するスレッドを終了する
+void
+icGame::StopRender( void )
+{
+	if(m_pPipeline) {
+		Cat_FramePipelineDestroy( m_pPipeline );
+		m_pPipeline = 0;
+		sceGuSync( 0, 0 );
+	}
+	m_fThread = false;
+	m_nPause  = 0;
+}
+
+//! 描画するスレッドを一時的に止める
+/*!
+	テクスチャやパレットを作成、解放、書き換えする前に呼ぶ。GEの描画が終わるまで待つ。 \n
+	書き換えた後でResumeRender()を呼ぶこと。
+*/
+void
+icGame::PauseRender( void )
+{
+	if(m_nPause++ == 0) {
+		if(m_fThread) {
+			Cat_FramePipelineStop( m_pPipeline );
+		}
+		// 前のフレームのパケットが、まだテクスチャとパレットを参照している
+		sceGuSync( 0, 0 );
+	}
+}
+
+//! 描画するスレッドを再開する
+void
+icGame::ResumeRender( void )
+{
+	if((m_nPause > 0) && (--m_nPause == 0) && m_fThread) {
+		m_fThread = Cat_FramePipelineStart( m_pPipeline, m_nPriority ) >= 0;
+	}
+}
+
 //! ゲームモード切り替え
 /*!
 	@param[in]	eGameMode	ゲームモード
@@ -32,6 +112,8 @@ icGame::MainLoop( void )
 void
 icGame::ChangeGameMode( enumGameMode eGameMode, const void* pvInitParam )
 {
+	// テクスチャを作り直すので、描画するスレッドを止めておく
+	PauseRender();
 	if(m_pGame) {
 		m_pGame->Terminate();
 		delete m_pGame;
@@ -52,6 +134,7 @@ icGame::ChangeGameMode( enumGameMode eGameMode, const void* pvInitParam )
 			m_pGame = 0;
 		}
 	}
+	ResumeRender();
 }
 
 } // namespace ic
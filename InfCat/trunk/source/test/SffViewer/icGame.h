@@ -4,6 +4,8 @@
 #ifndef INCL_CLASS_icGame
 #define INCL_CLASS_icGame
 
+#include "Cat_FramePipeline.h"
+
 namespace ic {
 
 //! ゲームモード
@@ -26,22 +28,55 @@ public:
 	virtual bool Initialize( const void* pvInitParam ) { return true; }
 
 	//! 更新
+	/*!
+		ゲームの処理をするスレッドで呼ばれる。
+	*/
 	virtual bool Framemove( void ) { return true; };
 
 	//! 描画
-	virtual void Render( void ) {};
+	/*!
+		Framemove()の後に、ゲームの処理をするスレッドで呼ばれる。描画する内容をスナップショットに書く。 \n
+		実際の描画は描画するスレッドで行われるので、ここでは描画しないこと。
+		@param[in]	pSnapshot	書き込むスナップショット
+	*/
+	virtual void Render( Cat_FrameSnapshot* pSnapshot ) {};
 
 	//! 終了処理
 	virtual void Terminate( void ) {};
 
 	//! メインループ
 	/*!
-		ゲームのメインループの処理を行う
+		ゲームのメインループの処理を行う \n
+		Framemove()とRender()でスナップショットを書いて、描画するスレッドへ渡す。 \n
+		描画するスレッドが動いている場合は、垂直同期を待って1フレームの間隔に合わせる。
 		@return ゲームループを継続する場合はtrue \n
 				ゲームループを終了する場合はfalseを返す
 	*/
 	static bool MainLoop( void );
 
+	//! 描画するスレッドを開始する
+	/*!
+		Cat_RenderInit()の後に呼ぶ。スレッドを作れなかった場合は、MainLoop()の中で描画する。
+		@param[in]	nSpriteMax	1フレームのスプライト数
+		@param[in]	nPriority	描画するスレッドの優先度(ゲームの処理をするスレッドより高くする)
+		@return 正常終了時 true \n
+				失敗時 false
+	*/
+	static bool StartRender( uint32_t nSpriteMax, int32_t nPriority );
+
+	//! 描画するスレッドを終了する
+	static void StopRender( void );
+
+	//! 描画するスレッドを一時的に止める
+	/*!
+		テクスチャやパレットを作成、解放、書き換えする前に呼ぶ。GEの描画が終わるまで待つ。 \n
+		書き換えた後でResumeRender()を呼ぶこと。
+	*/
+	static void PauseRender( void );
+
+	//! 描画するスレッドを再開する
+	static void ResumeRender( void );
+
 	//! ゲームモード切り替え
 	/*!
 		@param[in]	eGameMode	ゲームモード
@@ -49,7 +84,11 @@ public:
 	*/
 	static void ChangeGameMode( enumGameMode eGameMode, const void* pvInitParam = 0 );
 private:
-	static icGame* m_pGame;		/*!< ゲーム */
+	static icGame*				m_pGame;		/*!< ゲーム							*/
+	static Cat_FramePipeline*	m_pPipeline;	/*!< パイプライン					*/
+	static int32_t				m_nPriority;	/*!< 描画するスレッドの優先度		*/
+	static bool					m_fThread;		/*!< 描画するスレッドが動いているか	*/
+	static uint32_t				m_nPause;		/*!< PauseRender()した回数			*/
 };
 
 } // namespace ic
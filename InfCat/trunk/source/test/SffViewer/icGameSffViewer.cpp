@@ -6,27 +6,6 @@
 
 namespace ic {
 
-//! 描画
-static void
-RenderSprite( float x, float y, float z, float w, float h, float tw, float th )
-{
-	struct vertex_format {
-		short   u,v;
-		short	x,y,z;
-	} __attribute__((packed)) * vert = (struct vertex_format*)sceGuGetMemory( 32 );
-	vert[0].u     = 0;
-	vert[0].v     = 0;
-	vert[0].x     = (short)x;
-	vert[0].y     = (short)y;
-	vert[0].z     = (short)z;
-	vert[1].u     = (short)tw;
-	vert[1].v     = (short)th;
-	vert[1].x     = (short)(x + w);
-	vert[1].y     = (short)(y + h);
-	vert[1].z     = (short)z;
-	sceGuDrawArray( GU_SPRITES, GU_TEXTURE_16BIT | GU_VERTEX_16BIT | GU_TRANSFORM_2D, 2, 0, vert );
-}
-
 //! 実装
 class icGameSffViewerImpl {
 public:
@@ -100,9 +79,12 @@ public:
 				sprintf( pszFilename, "test%02d.act", (int)m_nActIndex );
 				Cat_Stream* pStream = Cat_StreamFileReadOpen( pszFilename );
 				if(pStream) {
+					// 描画するスレッドが使っているパレットを差し替えるので、止めてから行う
+					icGame::PauseRender();
 					if(m_pAct->Create( pStream )) {
 						m_pTexturePool->SetAct( m_pAct->GetPalette() );
 					}
+					icGame::ResumeRender();
 					Cat_StreamClose( pStream );
 				} else {
 					m_nActIndex = nPreActIndex;
@@ -116,19 +98,21 @@ public:
 	}
 
 	//! 描画
-	void Render( void ) {
+	/*!
+		@param[in]	pSnapshot	書き込むスナップショット
+	*/
+	void Render( Cat_FrameSnapshot* pSnapshot ) {
 		if(m_pTexture) {
-			m_pTexture->SetTexture();
 			const float x = 240.0f;
 			const float y = 272.0f / 2.0f;
-			const float z = 0.0f;
-			const float w = (float)m_pTexture->GetWidth();
-			const float h = (float)m_pTexture->GetHeight();
-			const float tw = (float)m_pTexture->GetRealWidth();
-			const float th = (float)m_pTexture->GetRealHeight();
 			const float fOffsetX = (float)m_pTexture->GetDrawOffsetX();
 			const float fOffsetY = (float)m_pTexture->GetDrawOffsetY();
-			RenderSprite( x - fOffsetX, y - fOffsetY, z, w, h, tw, th );
+			Cat_SpriteBatchSprite sprite;
+			Cat_SpriteBatchSpriteInit( &sprite );
+			sprite.pTexture = m_pTexture->GetCatTexture();
+			sprite.x        = x - fOffsetX;
+			sprite.y        = y - fOffsetY;
+			Cat_FrameSnapshotAddSprite( pSnapshot, &sprite );
 		}
 	}
 
@@ -169,10 +153,13 @@ icGameSffViewer::Framemove( void )
 }
 
 //! 描画
+/*!
+	@param[in]	pSnapshot	書き込むスナップショット
+*/
 void
-icGameSffViewer::Render( void )
+icGameSffViewer::Render( Cat_FrameSnapshot* pSnapshot )
 {
-	m_impl->Render();
+	m_impl->Render( pSnapshot );
 }
 
 //! 終了処理
@@ -26,7 +26,10 @@ public:
 	virtual bool Framemove( void );
 
 	//! 描画
-	virtual void Render( void );
+	/*!
+		@param[in]	pSnapshot	書き込むスナップショット
+	*/
+	virtual void Render( Cat_FrameSnapshot* pSnapshot );
 
 	//! 終了処理
 	virtual void Terminate( void );
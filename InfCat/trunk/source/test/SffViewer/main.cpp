@@ -8,6 +8,10 @@ using namespace ic;
 
 //! 読み込むファイル名
 #define FILENAME "test.sff"
+//! 1フレームのスプライト数
+#define SPRITE_MAX (64)
+//! 描画するスレッドの優先度(メインスレッドより高くする)
+#define RENDER_THREAD_PRIORITY (0x10)
 
 int
 main()
@@ -17,17 +21,22 @@ main()
 
 	icTextureCreatorSff sff;	// SFFテクスチャ作成の登録
 
-	Cat_RenderInit( CAT_RENDER_DEFAULT );
+	// 16色以下のイメージは4bitにして、大きなイメージは縮小せずに分割する
+	Cat_TextureSetOption( CAT_TEXTURE_OPTION_CLUT4 | CAT_TEXTURE_OPTION_TILE | CAT_TEXTURE_OPTION_QUANTIZE | CAT_TEXTURE_OPTION_FORMAT16 | CAT_TEXTURE_OPTION_DITHER );
+
+	Cat_RenderInit( CAT_RENDER_DEFAULT | CAT_RENDER_PARAM_VRAM_TEXTURE );
 	Cat_InputInit();
 	icGame::ChangeGameMode( eGameMode_SffViewer, FILENAME );	// SffViewerにしとく
+	if(!icGame::StartRender( SPRITE_MAX, RENDER_THREAD_PRIORITY )) {	// 描画は別のスレッドで行う
+		TRACE(( "render start failed." ));
+		HALT();
+	}
 	bool fContinue = true;
 	while(fContinue) {
 		Cat_InputUpdate();					// 入力の更新
-		Cat_RenderBegin(); {				// 描画開始
-			fContinue = icGame::MainLoop();
-		} Cat_RenderEnd();					// 描画終了
-		Cat_RenderScreenUpdate();			// 画面更新
+		fContinue = icGame::MainLoop();		// 更新して、描画する内容を渡す
 	}
+	icGame::StopRender();
 	Cat_InputTerm();
 	Cat_RenderTerm();
 
@@ -0,0 +1,182 @@
+//! @file	main.cpp
+// ステージの背景 - テスト用
+//
+// test.sffの先頭のイメージを並べた、タイルの多い合成ステージを2つ作って描画する。
+// 1つは無限に並べ、もう1つは4096x4096枚並べて位置を合わせてあるので、画面は同じになる。
+// 中景は、add、add1、addalphaの合成を混ぜる。
+// どちらも描画したタイル数と描画回数が毎フレーム一致すること(tileの値に関係ないこと)を確認して、
+// 1フレームあたりの時間を計測する。
+
+#include "icCore.h"
+#include "Cat_StreamMemory.h"
+#include <stdio.h>
+
+using namespace ic;
+
+//! 読み込むファイル名
+#define FILENAME "test.sff"
+//! 描画するフレーム数
+#define FRAME_COUNT (300)
+//! 有限に並べる数
+#define TILE_COUNT (4096)
+//! 同じ設定で重ねるレイヤー数
+#define REPEAT_COUNT (4)
+
+//! 中景の合成の方法(重ねるごとに変える)
+static const char* gpszTrans[REPEAT_COUNT] = {
+	"add",
+	"add1",
+	"addalpha\r\nalpha = 192, 96",
+	"addalpha",
+};
+
+//! 合成ステージを作る
+/*!
+	@param[in]	def			読み込み先
+	@param[in]	pTexture	並べるテクスチャ
+	@param[in]	nTile		tileの値(1は無限、2以上は並べる数)
+	@return 成功した場合true \n
+			失敗したらfalseを返す
+*/
+static bool
+CreateStage( icDef& def, icTexture* pTexture, int32_t nTile )
+{
+	static char szText[16 * 1024];
+	const int32_t nGroupNo = pTexture->GetGroupNo();
+	const int32_t nItemNo  = pTexture->GetItemNo();
+	const int32_t nSpacing = 2;
+	// 有限に並べる場合は、半分だけ左上にずらして無限に並べた場合と重ねる
+	const int32_t nShiftX = (nTile > 1) ? (nTile / 2) * ((int32_t)pTexture->GetWidth() + nSpacing) : 0;
+	const int32_t nShiftY = (nTile > 1) ? (nTile / 2) * ((int32_t)pTexture->GetHeight() + nSpacing) : 0;
+	int32_t nLength = 0;
+
+	nLength += snprintf( &szText[nLength], sizeof(szText) - nLength, "[BGdef]\r\nspr = stage.sff\r\n" );
+	for(int32_t i = 0; i < REPEAT_COUNT; i++) {
+		// 一面に並べる遠景
+		nLength += snprintf( &szText[nLength], sizeof(szText) - nLength,
+			"[BG far %d]\r\ntype = normal\r\nspriteno = %d, %d\r\nstart = %d, %d\r\ndelta = 0.25, 0.25\r\n"
+			"tile = %d, %d\r\ntilespacing = %d, %d\r\nvelocity = 1, 0\r\n",
+			i, nGroupNo, nItemNo, -nShiftX, -nShiftY, nTile, nTile, nSpacing, nSpacing );
+		// 横に並べる加算の中景
+		nLength += snprintf( &szText[nLength], sizeof(szText) - nLength,
+			"[BG middle %d]\r\ntype = parallax\r\nspriteno = %d, %d\r\nstart = %d, %d\r\ndelta = 0.5, 1\r\ntrans = %s\r\n"
+			"tile = %d, 0\r\ntilespacing = %d, 0\r\n",
+			i, nGroupNo, nItemNo, -nShiftX, 120 + i * 8, gpszTrans[i], nTile, nSpacing );
+		// 画面の中央だけに見える窓
+		nLength += snprintf( &szText[nLength], sizeof(szText) - nLength,
+			"[BG window %d]\r\nspriteno = %d, %d\r\nstart = %d, %d\r\ndelta = 1, 1\r\n"
+			"tile = %d, %d\r\ntilespacing = %d, %d\r\nwindow = 160, 64, 319, 191\r\n",
+			i, nGroupNo, nItemNo, -nShiftX, -nShiftY, nTile, nTile, nSpacing, nSpacing );
+		// windowが画面外にあって見えない
+		nLength += snprintf( &szText[nLength], sizeof(szText) - nLength,
+			"[BG hidden %d]\r\nspriteno = %d, %d\r\nstart = %d, %d\r\n"
+			"tile = %d, %d\r\nwindow = -200, 0, -100, 100\r\n",
+			i, nGroupNo, nItemNo, -nShiftX, -nShiftY, nTile, nTile );
+		// 手前
+		nLength += snprintf( &szText[nLength], sizeof(szText) - nLength,
+			"[BG front %d]\r\nspriteno = %d, %d\r\nlayerno = 1\r\nstart = %d, 240\r\ndelta = 1.5, 1\r\n"
+			"tile = %d, 0\r\n",
+			i, nGroupNo, nItemNo, -nShiftX, nTile );
+	}
+
+	Cat_Stream* pStream = Cat_StreamMemoryReadOpen( szText, nLength, 0 );
+	if(pStream == 0) {
+		return false;
+	}
+	const bool fResult = def.Load( pStream );
+	Cat_StreamClose( pStream );
+	return fResult;
+}
+
+int
+main()
+{
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	icTextureCreatorSff sff;	// SFFテクスチャ作成の登録
+
+	Cat_Stream* pStream = Cat_StreamFileReadOpen( FILENAME );
+	if(pStream == 0) {
+		TRACE(( "%s not found", FILENAME ));
+		HALT();
+	}
+	icTexturePool pool;
+	if(!pool.Create( pStream )) {
+		TRACE(( "%s load failed", FILENAME ));
+		HALT();
+	}
+	Cat_StreamClose( pStream );
+	icTexture* pTexture = pool.SearchFromIndex( 0 );
+	if(pTexture == 0) {
+		TRACE(( "no image" ));
+		HALT();
+	}
+
+	// 0:無限に並べる 1:TILE_COUNT枚並べる
+	icDef def[2];
+	icStage stage[2];
+	const int32_t nTile[2] = { 1, TILE_COUNT };
+	for(int32_t i = 0; i < 2; i++) {
+		if(!CreateStage( def[i], pTexture, nTile[i] ) || !stage[i].Create( def[i], pool )) {
+			TRACE(( "stage create failed" ));
+			HALT();
+		}
+	}
+
+	uint32_t nTime[2] = { 0, 0 };
+	uint32_t nMaxTile = 0;
+	uint32_t nMismatch = 0;
+	Cat_RenderInit( CAT_RENDER_DEFAULT );
+	for(uint32_t nFrame = 0; nFrame < FRAME_COUNT; nFrame++) {
+		// カメラを左右に振りながら少し上下させる
+		const float x = (float)((int32_t)(nFrame % 200) - 100) * 4.0f;
+		const float y = (float)((int32_t)(nFrame % 60) - 30);
+		uint32_t nDraw[2];
+		uint32_t nBatch[2];
+		for(int32_t i = 0; i < 2; i++) {
+			icStage::Statistics before;
+			stage[i].GetStatistics( &before );
+			stage[i].SetCamera( x, y );
+			const uint32_t nStart = sceKernelGetSystemTimeLow();
+			Cat_RenderBegin(); {
+				nDraw[i]  = stage[i].Draw( 0 );
+				nDraw[i] += stage[i].Draw( 1 );
+			} Cat_RenderEnd();
+			nTime[i] += sceKernelGetSystemTimeLow() - nStart;
+			Cat_RenderScreenUpdate();
+			stage[i].Update();
+
+			icStage::Statistics after;
+			stage[i].GetStatistics( &after );
+			nBatch[i] = after.nBatchCount - before.nBatchCount;
+		}
+		if((nDraw[0] != nDraw[1]) || (nBatch[0] != nBatch[1])) {
+			nMismatch++;
+		}
+		nMaxTile = std::max( nMaxTile, nDraw[0] );
+	}
+	Cat_RenderTerm();
+
+	pspDebugScreenInit();
+	TRACE(( "layers:%d image:%dx%d frames:%d\n", (int)stage[0].GetLayerCount(),
+		(int)pTexture->GetWidth(), (int)pTexture->GetHeight(), FRAME_COUNT ));
+	for(int32_t i = 0; i < 2; i++) {
+		icStage::Statistics statistics;
+		stage[i].GetStatistics( &statistics );
+		TRACE(( "tile %4d: %5dus/frame tile:%d layer:%d window cull:%d offscreen:%d scissor:%d batch:%d\n",
+			(int)nTile[i], (int)(nTime[i] / FRAME_COUNT), (int)statistics.nTileCount, (int)statistics.nLayerCount,
+			(int)statistics.nWindowCullCount, (int)statistics.nOffscreenCount, (int)statistics.nScissorCount,
+			(int)statistics.nBatchCount ));
+	}
+	TRACE(( "max tiles/frame:%d mismatch frames:%d\n", (int)nMaxTile, (int)nMismatch ));
+	TRACE(( (nMismatch == 0) ? "OK\n" : "NG\n" ));
+
+	for(int32_t i = 0; i < 2; i++) {
+		stage[i].Release();
+	}
+	pool.Release();
+
+	HALT();
+	return 0;
+}
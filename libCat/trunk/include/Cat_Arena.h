@@ -0,0 +1,82 @@
+//! @file	Cat_Arena.h
+// まとめて解放するメモリ領域
+
+#ifndef INCL_Cat_Arena_h
+#define INCL_Cat_Arena_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! まとめて解放するメモリ領域
+/*!
+	大きなブロックから順に切り出して、ブロック単位で解放する。 \n
+	キャラクターのピクセルデータのように、一緒に読み込んで一緒に捨てるものに使う。 \n
+	参照カウンタを持っていて、最後の参照が無くなった時にすべてのブロックが解放される。
+*/
+typedef struct _Cat_Arena Cat_Arena;
+
+//! 統計情報
+typedef struct {
+	uint32_t	nAllocCount;		/*!< Cat_ArenaAlloc()の回数							*/
+	uint32_t	nFreeCount;			/*!< Cat_ArenaFree()の回数							*/
+	uint32_t	nUsedSize;			/*!< 切り出したサイズ(ブロックが空くまで減らない)	*/
+	uint32_t	nReservedSize;		/*!< 確保しているブロックのサイズ(バイト単位)		*/
+	uint32_t	nBlockCount;		/*!< 確保しているブロック数							*/
+	uint32_t	nHeapAllocCount;	/*!< ヒープから確保した回数							*/
+} Cat_ArenaStatistics;
+
+//! 作成する
+/*!
+	@param[in]	nBlockSize	ブロックのサイズ(バイト単位)。 \n
+							1/4を超える確保は、専用のブロックになる。
+	@return	作成された領域。失敗した場合は0が返る。
+	@see	Cat_ArenaRelease()
+*/
+extern Cat_Arena* Cat_ArenaCreate( uint32_t nBlockSize );
+
+//! 参照カウンタを加算する
+/*!
+	@param[in]	pArena	領域
+*/
+extern void Cat_ArenaAddRef( Cat_Arena* pArena );
+
+//! 解放する
+/*!
+	参照カウンタを減算して、0になったらすべてのブロックを解放する。
+	@param[in]	pArena	領域
+*/
+extern void Cat_ArenaRelease( Cat_Arena* pArena );
+
+//! メモリを確保する
+/*!
+	32バイト境界のメモリを返す。中身は初期化されない。
+	@param[in]	pArena	領域
+	@param[in]	nSize	サイズ(バイト単位)
+	@return	確保したメモリ。失敗した場合は0が返る。
+*/
+extern void* Cat_ArenaAlloc( Cat_Arena* pArena, uint32_t nSize );
+
+//! メモリを解放する
+/*!
+	ブロック内のメモリがすべて解放された時に、ブロックごと解放される。 \n
+	それまでは、解放したメモリも使われたままになる。
+	@param[in]	pArena	領域
+	@param[in]	pv		Cat_ArenaAlloc()で確保したメモリ
+*/
+extern void Cat_ArenaFree( Cat_Arena* pArena, void* pv );
+
+//! 統計情報を取得する
+/*!
+	@param[in]	pArena			領域
+	@param[out]	pStatistics		統計情報
+*/
+extern void Cat_ArenaGetStatistics( Cat_Arena* pArena, Cat_ArenaStatistics* pStatistics );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCL_Cat_Arena_h
@@ -0,0 +1,115 @@
+//! @file	Cat_Blend.h
+// MUGENの半透明をCPUで合成する
+
+#ifndef INCL_Cat_Blend_h
+#define INCL_Cat_Blend_h
+
+#include <stdint.h>
+#include "Cat_Texture.h"
+#include "Cat_Palette.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! 重みの等倍の値
+#define CAT_BLEND_UNIT (256)
+
+//! 合成の方法
+/*!
+	8bitのインデックスをパレットで色にしてから、チャンネルごとに合成する。 \n
+	インデックス0は透明で、描画先を変えない(MUGENのスプライトと同じ)。 \n
+	描画先のアルファは変えない。
+*/
+enum {
+	CAT_BLEND_NONE     = 0,		/*!< 上書き			dst = src											*/
+	CAT_BLEND_ADD      = 1,		/*!< 加算			dst = min(src + dst, 255)							*/
+	CAT_BLEND_ADD1     = 2,		/*!< 背景を半分にして加算	dst = min(src + dst / 2, 255)				*/
+	CAT_BLEND_SUB      = 3,		/*!< 減算			dst = max(dst - src, 0)								*/
+	CAT_BLEND_ADDALPHA = 4,		/*!< 重み付き加算	dst = min((src * nSrcAlpha + dst * nDestAlpha) / 256, 255)	*/
+	CAT_BLEND_SHADOW   = 5,		/*!< 影				dst = (dst * (256 - nShadowAlpha) + 影の色 * nShadowAlpha) / 256	*/
+
+	CAT_BLEND_MAX				/*!< 最大値			*/
+};
+
+//! 合成のパラメータ
+typedef struct {
+	uint32_t	nMode;			/*!< 合成の方法(CAT_BLEND_xxx)								*/
+	uint32_t	nSrcAlpha;		/*!< CAT_BLEND_ADDALPHAのソースの重み(0～256)				*/
+	uint32_t	nDestAlpha;		/*!< CAT_BLEND_ADDALPHAの描画先の重み(0～256)				*/
+	uint32_t	nShadowColor;	/*!< CAT_BLEND_SHADOWの色(0xBBGGRR)							*/
+	uint32_t	nShadowAlpha;	/*!< CAT_BLEND_SHADOWの濃さ(0～256)							*/
+} Cat_BlendParam;
+
+//! パラメータを上書きで初期化する
+/*!
+	@param[out]	pParam	パラメータ
+*/
+extern void Cat_BlendParamInit( Cat_BlendParam* pParam );
+
+//! 1ラインを合成する(RGBA8888)
+/*!
+	ホストではSSE2で4ピクセルずつ、PSPではスカラーで合成する。結果はどちらも同じになる。
+	@param[in,out]	pnDest		描画先
+	@param[in]		pbSrc		インデックス
+	@param[in]		pnPalette	パレット(RGBA8888、256色)
+	@param[in]		nCount		ピクセル数
+	@param[in]		pParam		パラメータ
+*/
+extern void Cat_BlendSpan8888( uint32_t* pnDest, const uint8_t* pbSrc, const uint32_t* pnPalette, uint32_t nCount, const Cat_BlendParam* pParam );
+
+//! 1ラインを合成する(RGBA5650)
+/*!
+	描画先をCat_ColorConvert()と同じ方法で8bitに広げて合成し、下位ビットを切り捨てて戻す。
+	@param[in,out]	pnDest		描画先
+	@param[in]		pbSrc		インデックス
+	@param[in]		pnPalette	パレット(RGBA8888、256色)
+	@param[in]		nCount		ピクセル数
+	@param[in]		pParam		パラメータ
+*/
+extern void Cat_BlendSpan5650( uint16_t* pnDest, const uint8_t* pbSrc, const uint32_t* pnPalette, uint32_t nCount, const Cat_BlendParam* pParam );
+
+//! 1ラインを1ピクセルずつ合成する(RGBA8888)
+/*!
+	Cat_BlendSpan8888()と同じ結果になる、比較用の実装。
+	@param[in,out]	pnDest		描画先
+	@param[in]		pbSrc		インデックス
+	@param[in]		pnPalette	パレット(RGBA8888、256色)
+	@param[in]		nCount		ピクセル数
+	@param[in]		pParam		パラメータ
+*/
+extern void Cat_BlendSpan8888Reference( uint32_t* pnDest, const uint8_t* pbSrc, const uint32_t* pnPalette, uint32_t nCount, const Cat_BlendParam* pParam );
+
+//! 1ラインを1ピクセルずつ合成する(RGBA5650)
+/*!
+	Cat_BlendSpan5650()と同じ結果になる、比較用の実装。
+	@param[in,out]	pnDest		描画先
+	@param[in]		pbSrc		インデックス
+	@param[in]		pnPalette	パレット(RGBA8888、256色)
+	@param[in]		nCount		ピクセル数
+	@param[in]		pParam		パラメータ
+*/
+extern void Cat_BlendSpan5650Reference( uint16_t* pnDest, const uint8_t* pbSrc, const uint32_t* pnPalette, uint32_t nCount, const Cat_BlendParam* pParam );
+
+//! 画像を合成する
+/*!
+	@param[in,out]	pvDest			描画先
+	@param[in]		nDestPitch		描画先のピッチ(バイト単位)
+	@param[in]		eDestFormat		描画先のフォーマット(FORMAT_PIXEL_8888/5650)
+	@param[in]		pbSrc			インデックス
+	@param[in]		nSrcPitch		インデックスのピッチ(バイト単位)
+	@param[in]		nWidth			横幅
+	@param[in]		nHeight			高さ
+	@param[in]		pPalette		パレット(どのフォーマットでも良い)
+	@param[in]		pParam			パラメータ
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+extern int32_t Cat_BlendImage( void* pvDest, uint32_t nDestPitch, FORMAT_PIXEL eDestFormat, const uint8_t* pbSrc, uint32_t nSrcPitch,
+	uint32_t nWidth, uint32_t nHeight, const Cat_Palette* pPalette, const Cat_BlendParam* pParam );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCL_Cat_Blend_h
@@ -0,0 +1,143 @@
+//! @file	Cat_Capture.h
+// 画面の保存(スクリーンショットと連続したフレーム)
+
+#ifndef INCL_Cat_Capture_h
+#define INCL_Cat_Capture_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! 画面の保存
+/*!
+	Cat_RenderScreenUpdate()の後で、表示しているフレームバッファをバッファにコピーするだけで戻り、 \n
+	PCX形式への変換とファイルへの書き込みは、別のスレッドで行う。 \n
+	ゲームの処理をするスレッドが払うのはコピーの時間だけで、統計情報のnCopyTimeで計れる。 \n
+	\n
+	- 書き込むスレッドはゲームの処理より優先度を低くするので、ゲームの処理をするスレッドが \n
+	  垂直同期やGEを待っている間に動く。
+	- バッファは作成した時に確保した数だけを使い回し、コピーしたものを順番に書き込む(キュー)。
+	- 空いているバッファが無い場合は、書き込みを待たずにそのフレームを保存しない(nDropCount)。 \n
+	  スクリーンショットは、次のCat_CaptureUpdate()で撮り直す。 \n
+	  リプレイなどで連続したフレームを保存する場合は、書き込みが間に合う間隔にすること。
+	- 保存するのは480x272で、アルファは保存しない。
+	- libCatをUSE_CAT_IMAGELOADER_PCXを定義してビルドした場合だけ使える。
+
+	@code
+	pCapture = Cat_CaptureCreate( 4, 0x30 );	// 書き込むスレッドは、ゲームの処理より優先度を低くする
+	Cat_CaptureStartSequence( pCapture, "ms0:/PSP/PHOTO/replay%05d.pcx", 2 );	// 2フレームごとに保存する
+	while(...) {
+		...
+		Cat_RenderScreenUpdate();
+		Cat_CaptureUpdate( pCapture );
+	}
+	Cat_CaptureStopSequence( pCapture );
+	Cat_CaptureDestroy( pCapture );	// キューに残っているものを書き込んでから破棄する
+	@endcode
+*/
+typedef struct _Cat_Capture Cat_Capture;
+
+//! ファイル名の最大長(終端を含む)
+#define CAT_CAPTURE_PATH_MAX (256)
+
+//! 統計情報
+typedef struct {
+	uint32_t	nCopyCount;			/*!< コピーしたフレーム数									*/
+	uint32_t	nDropCount;			/*!< 空いているバッファが無く、保存しなかったフレーム数		*/
+	uint32_t	nCopyTime;			/*!< コピーにかかった時間の合計(マイクロ秒単位)				*/
+	uint32_t	nCopyTimeMax;		/*!< コピーにかかった時間の最大値(マイクロ秒単位)			*/
+	uint32_t	nSaveCount;			/*!< 書き込んだファイル数									*/
+	uint32_t	nErrorCount;		/*!< 書き込めなかったファイル数								*/
+	uint32_t	nSaveTime;			/*!< 変換と書き込みにかかった時間の合計(マイクロ秒単位)		*/
+	uint32_t	nSaveTimeMax;		/*!< 変換と書き込みにかかった時間の最大値(マイクロ秒単位)	*/
+	uint32_t	nSaveSize;			/*!< 書き込んだサイズの合計(バイト単位)						*/
+	uint32_t	nQueueMax;			/*!< キューに溜まったフレーム数の最大値						*/
+} Cat_CaptureStatistics;
+
+//! 作成する
+/*!
+	書き込むスレッドも開始する。
+	@param[in]	nBufferCount	バッファの数(キューの長さ)。1つあたり480x272x4バイト確保する。
+	@param[in]	nPriority		書き込むスレッドの優先度(PSPのみ。ゲームの処理をするスレッドより低くする)
+	@return	作成されたもの。失敗した場合は0が返る。
+	@see	Cat_CaptureDestroy()
+*/
+extern Cat_Capture* Cat_CaptureCreate( uint32_t nBufferCount, int32_t nPriority );
+
+//! 破棄する
+/*!
+	キューに残っているフレームを書き込んでから、書き込むスレッドを止めて破棄する。
+	@param[in]	pCapture	画面の保存
+*/
+extern void Cat_CaptureDestroy( Cat_Capture* pCapture );
+
+//! スクリーンショットを予約する
+/*!
+	次のCat_CaptureUpdate()で表示しているフレームを保存する。
+	@param[in]	pCapture	画面の保存
+	@param[in]	pszFilename	ファイル名
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+extern int32_t Cat_CaptureShot( Cat_Capture* pCapture, const char* pszFilename );
+
+//! 連続したフレームの保存を開始する
+/*!
+	@param[in]	pCapture	画面の保存
+	@param[in]	pszFormat	ファイル名の書式(printfの書式で、0から始まる通し番号を1つ渡す)
+	@param[in]	nInterval	保存する間隔(Cat_CaptureUpdate()の回数、1で毎フレーム)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+	@see	Cat_CaptureStopSequence()
+*/
+extern int32_t Cat_CaptureStartSequence( Cat_Capture* pCapture, const char* pszFormat, uint32_t nInterval );
+
+//! 連続したフレームの保存を止める
+/*!
+	キューに残っているフレームは書き込まれる。
+	@param[in]	pCapture	画面の保存
+	@return	保存したフレーム数(保存しなかったフレームの分も通し番号は進む)
+*/
+extern uint32_t Cat_CaptureStopSequence( Cat_Capture* pCapture );
+
+//! 表示しているフレームをコピーする
+/*!
+	Cat_RenderScreenUpdate()の後に毎フレーム呼ぶ。予約したスクリーンショットか、 \n
+	連続したフレームの保存の間隔に当たる時だけ、Cat_RenderGetDisplay()をバッファにコピーしてキューに入れる。
+	@param[in]	pCapture	画面の保存
+	@return	コピーした場合は、1 \n
+			保存するフレームでない場合は、0 \n
+			空いているバッファが無いなどで保存しなかった場合は、負数が返る
+*/
+extern int32_t Cat_CaptureUpdate( Cat_Capture* pCapture );
+
+//! キューに入っているフレームを書き込み終わるまで待つ
+/*!
+	Cat_CaptureResetStatistics()した書き込み側の統計情報が、クリアされるのも待つ。
+	@param[in]	pCapture	画面の保存
+*/
+extern void Cat_CaptureFlush( Cat_Capture* pCapture );
+
+//! 統計情報を取得する
+/*!
+	書き込み側の回数と時間は書き込むスレッドが更新するので、揃った値はCat_CaptureFlush()の後で取得する。
+	@param[in]	pCapture		画面の保存
+	@param[out]	pStatistics		統計情報
+*/
+extern void Cat_CaptureGetStatistics( Cat_Capture* pCapture, Cat_CaptureStatistics* pStatistics );
+
+//! 統計情報をクリアする
+/*!
+	ゲームの処理をするスレッドから呼ぶ。コピー側の回数と時間はすぐにクリアし、 \n
+	書き込み側の回数と時間は、書き込むスレッドを起こしてクリアさせる(Cat_CaptureFlush()で終わるのを待てる)。
+	@param[in]	pCapture	画面の保存
+*/
+extern void Cat_CaptureResetStatistics( Cat_Capture* pCapture );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCL_Cat_Capture_h
@@ -0,0 +1,52 @@
+//! @file	Cat_ColorConvert.h
+// 色フォーマットの一括変換
+
+#ifndef INCL_Cat_ColorConvert_h
+#define INCL_Cat_ColorConvert_h
+
+#include <stdint.h>
+#include "Cat_Texture.h"
+#include "Cat_Palette.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! RGBA8888からRGBA5650へ変換する
+extern uint16_t Cat_ColorConvert8888To5650( uint32_t rgba8888 );
+
+//! RGBA8888からRGBA5551へ変換する
+extern uint16_t Cat_ColorConvert8888To5551( uint32_t rgba8888 );
+
+//! RGBA8888からRGBA4444へ変換する
+extern uint16_t Cat_ColorConvert8888To4444( uint32_t rgba8888 );
+
+//! 色の配列をまとめて変換する
+/*!
+	8888,5650,5551,4444の間で変換する。 \n
+	16bitから32bitへの変換は、Cat_ColorConvert5650To8888()などと同じ結果になる。 \n
+	32bitから16bitへの変換は、下位ビットを切り捨てる。 \n
+	\a pvDest と \a pvSrc が同じ場合は、16bit同士の変換のみ可能。
+	@param[out]	pvDest			変換先
+	@param[in]	eDestFormat		変換先のフォーマット(FORMAT_PIXEL_8888/5650/5551/4444)
+	@param[in]	pvSrc			変換元
+	@param[in]	eSrcFormat		変換元のフォーマット(FORMAT_PIXEL_8888/5650/5551/4444)
+	@param[in]	nCount			変換する色数
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+extern int32_t Cat_ColorConvert( void* pvDest, FORMAT_PIXEL eDestFormat, const void* pvSrc, FORMAT_PIXEL eSrcFormat, uint32_t nCount );
+
+//! パレットのフォーマットを変換した複製を作成する
+/*!
+	@param[in]	pPalette		変換元のパレット
+	@param[in]	ePaletteFormat	変換先のパレットフォーマット
+	@return	作成されたパレット。失敗した場合は0が返る。
+*/
+extern Cat_Palette* Cat_PaletteConvert( const Cat_Palette* pPalette, FORMAT_PALETTE ePaletteFormat );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCL_Cat_ColorConvert_h
@@ -0,0 +1,159 @@
+//! @file	Cat_DisplayList.h
+// 記録して繰り返し使う描画パケット
+
+#ifndef INCL_Cat_DisplayList_h
+#define INCL_Cat_DisplayList_h
+
+#include <stdint.h>
+#include "Cat_Palette.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! 記録して繰り返し使う描画パケット
+/*!
+	背景やHUDの枠のように毎フレーム同じものを描画する場合に、libCatの描画を一度だけGU_CALLのリストに記録して、 \n
+	毎フレームはsceGuCallList()を1回積むだけで描画する。 \n
+	\n
+	描画位置のずらし(オフセット)とパレットは、記録した後でも差し替えられる(パラメータの差し込み口)。 \n
+	GEは前のフレームを描画している間も記録したリストを読むので、リストは2つ記録しておき、 \n
+	前のフレームで使っていない方を書き換えてから呼ぶ。そのため、記録する関数は2回呼ばれる。 \n
+	\n
+	- 記録できるのは、Cat_TextureDraw()やCat_SpriteBatchFlush()などCat_RenderGetMemory()で頂点を確保する描画と、 \n
+	  それが積む設定だけ。オフセットは、その頂点の位置をずらす。 \n
+	  記録した時に画面外で描画しなかったものは、ずらしても描画されない。
+	- GEのアドレスは絶対アドレスなので、記録したリストは移動できない。
+	- リストはテクスチャのピクセルデータのアドレスを持ち続ける。そのため、記録する間はVRAMに置かれた \n
+	  テクスチャもメインメモリから読ませ(VRAMの配置は後で変わる)、使ったテクスチャはCat_TexturePin()で \n
+	  破棄するまで固定する。固定されたテクスチャはCat_TextureUnload()やテクスチャの常駐管理で解放されないので、 \n
+	  記録するのは毎フレーム使うテクスチャだけにすること。
+	- 差し替えた値は、次にCat_DisplayListCall()を呼んだ時に反映される。 \n
+	  同じフレームで何度も呼んだ場合は、最後に呼んだ時の値で描画される。
+
+	@code
+	static void
+	RecordFrame( Cat_DisplayList* pList, void* pvContext )
+	{
+		Cat_SpriteBatchSprite sprite;
+		Cat_SpriteBatchSpriteInit( &sprite );
+		sprite.pTexture = gpTexture;
+		sprite.pPalette = Cat_DisplayListGetPalette( pList, 0, gpPalette );
+		...
+		Cat_SpriteBatchAdd( gpBatch, &sprite );
+		Cat_SpriteBatchFlush( gpBatch );
+	}
+
+	pList = Cat_DisplayListCreate( 16 * 1024, RecordFrame, 0 );	// Cat_RenderBegin()の外で作る
+	...
+	Cat_RenderBegin(); {
+		Cat_DisplayListSetOffset( pList, x, y );
+		Cat_DisplayListCall( pList );
+	} Cat_RenderEnd();
+	@endcode
+*/
+typedef struct _Cat_DisplayList Cat_DisplayList;
+
+//! パレットの差し込み口の数
+#define CAT_DISPLAYLIST_PALETTE_MAX (4)
+
+//! 記録する関数
+/*!
+	Cat_DisplayListCreate()から2回呼ばれるので、2回とも同じように描画すること。
+	@param[in]	pList		記録しているリスト
+	@param[in]	pvContext	Cat_DisplayListCreate()で渡した値
+*/
+typedef void (*Cat_DisplayListRecordFunc)( Cat_DisplayList* pList, void* pvContext );
+
+//! 統計情報
+typedef struct {
+	uint32_t	nSize;				/*!< 記録したリストのサイズ(1つ分、バイト単位)				*/
+	uint32_t	nVertexCount;		/*!< 記録した頂点の数(1つ分)								*/
+	uint32_t	nCallCount;			/*!< Cat_DisplayListCall()の回数							*/
+	uint32_t	nPatchCount;		/*!< 差し替えた値をリストに書き込んだ回数					*/
+	uint32_t	nPatchVertexCount;	/*!< オフセットを変えるために書き換えた頂点の数				*/
+	uint32_t	nOverflowCount;		/*!< 描画パケットに空きが無く、呼べなかった回数				*/
+} Cat_DisplayListStatistics;
+
+//! 作成して記録する
+/*!
+	Cat_RenderBegin()とCat_RenderEnd()の外で呼ぶ。 \n
+	\a pfnRecord を2回呼んで、それぞれの描画をリストに記録する。
+	@param[in]	nSize		リスト1つのサイズ(バイト単位)
+	@param[in]	pfnRecord	記録する関数
+	@param[in]	pvContext	\a pfnRecord に渡す値
+	@return	作成されたリスト。失敗した場合(記録が \a nSize に収まらない場合を含む)は0が返る。
+	@see	Cat_DisplayListDestroy()
+*/
+extern Cat_DisplayList* Cat_DisplayListCreate( uint32_t nSize, Cat_DisplayListRecordFunc pfnRecord, void* pvContext );
+
+//! 破棄する
+/*!
+	GEが描画し終わってから呼ぶこと。記録したテクスチャの固定も外す。
+	@param[in]	pList	リスト
+*/
+extern void Cat_DisplayListDestroy( Cat_DisplayList* pList );
+
+//! 記録する時に、パレットの差し込み口を取得する
+/*!
+	記録する関数の中で呼び、返ったパレットで描画する(Cat_SpriteBatchSprite.pPaletteなど)。 \n
+	返るパレットはリストが持っていて、Cat_DisplayListSetPalette()で色を差し替える。
+	@param[in]	pList		記録しているリスト
+	@param[in]	nSlot		差し込み口の番号(0～CAT_DISPLAYLIST_PALETTE_MAX-1)
+	@param[in]	pPalette	最初の色(フォーマットと数もこれに合わせる)
+	@return	描画に使うパレット。失敗した場合は0が返る。
+*/
+extern Cat_Palette* Cat_DisplayListGetPalette( Cat_DisplayList* pList, uint32_t nSlot, Cat_Palette* pPalette );
+
+//! オフセットを設定する
+/*!
+	記録した位置からずらして描画する。
+	@param[in]	pList	リスト
+	@param[in]	x		横のずらし(ドット単位)
+	@param[in]	y		縦のずらし(ドット単位)
+*/
+extern void Cat_DisplayListSetOffset( Cat_DisplayList* pList, int32_t x, int32_t y );
+
+//! パレットを差し替える
+/*!
+	色をコピーするのは次のCat_DisplayListCall()なので、それまで \a pPalette は解放しないこと。 \n
+	Cat_PaletteUpdate()で更新カウンタが変わった場合も、コピーし直す。
+	@param[in]	pList		リスト
+	@param[in]	nSlot		差し込み口の番号
+	@param[in]	pPalette	パレット(Cat_DisplayListGetPalette()で渡したものとフォーマットと数が同じもの)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+extern int32_t Cat_DisplayListSetPalette( Cat_DisplayList* pList, uint32_t nSlot, Cat_Palette* pPalette );
+
+//! 記録したリストを呼ぶ
+/*!
+	Cat_RenderBegin()とCat_RenderEnd()の間で呼ぶ。 \n
+	リストが描画の設定を変えるので、呼んだ後はCat_RenderStateの記録を捨てる。 \n
+	記録した描画の回数、頂点の数、リストのサイズなどは、呼んだフレームの統計情報に加える \n
+	(ピクセル数は記録した時の見積もり)。
+	@param[in]	pList	リスト
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+extern int32_t Cat_DisplayListCall( Cat_DisplayList* pList );
+
+//! 統計情報を取得する
+/*!
+	@param[in]	pList			リスト
+	@param[out]	pStatistics		統計情報
+*/
+extern void Cat_DisplayListGetStatistics( Cat_DisplayList* pList, Cat_DisplayListStatistics* pStatistics );
+
+//! 統計情報をクリアする
+/*!
+	記録したリストのサイズと頂点の数は残る。
+	@param[in]	pList	リスト
+*/
+extern void Cat_DisplayListResetStatistics( Cat_DisplayList* pList );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCL_Cat_DisplayList_h
@@ -0,0 +1,179 @@
+//! @file	Cat_FramePipeline.h
+// ゲームの処理と描画を別のスレッドで行う
+
+#ifndef INCL_Cat_FramePipeline_h
+#define INCL_Cat_FramePipeline_h
+
+#include <stdint.h>
+#include "Cat_Palette.h"
+#include "Cat_SpriteBatch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! ゲームの処理と描画を別のスレッドで行う
+/*!
+	ゲームの処理(シミュレーション)をするスレッドは、1フレーム分の描画する内容をスナップショットに書いて渡し、 \n
+	描画するスレッドは、最新のスナップショットから描画パケットを作る。 \n
+	スナップショットは3つ(書いているもの、渡したもの、描画しているもの)を入れ替えて使い、 \n
+	入れ替えは排他を使わずに1回の交換で行うので、どちらのスレッドも相手を待たない。 \n
+	\n
+	- 描画が間に合わない場合は、描画されていないスナップショットは新しいもので上書きされる(nDropCount)。
+	- 新しいスナップショットが無い場合は、描画するスレッドは垂直同期を待つ(nIdleCount)。
+	- スナップショットのパレットは、描画する時に描画側のパレットにコピーするので、 \n
+	  GEが前のフレームを描画している間に書き換えても構わない。
+	- Cat_FramePipelineStart()している間は、描画するスレッドだけが描画すること。 \n
+	  テクスチャの作成と解放も、Cat_FramePipelineStart()の前かCat_FramePipelineStop()の後に行う。
+
+	@code
+	pPipeline = Cat_FramePipelineCreate( 1024, DrawHud, 0 );
+	Cat_FramePipelineStart( pPipeline, 0x10 );	// 描画するスレッドは、ゲームの処理より優先度を高くする
+	while(...) {
+		Cat_FrameSnapshot* pSnapshot = Cat_FramePipelineBeginSnapshot( pPipeline );
+		...	// ゲームの処理
+		Cat_FrameSnapshotAddSprite( pSnapshot, &sprite );
+		Cat_FramePipelineSubmit( pPipeline );
+	}
+	Cat_FramePipelineStop( pPipeline );
+	@endcode
+*/
+typedef struct _Cat_FramePipeline Cat_FramePipeline;
+
+//! スナップショットのパレットの数
+#define CAT_FRAMEPIPELINE_PALETTE_MAX (8)
+
+//! 1フレーム分の描画する内容
+typedef struct {
+	Cat_SpriteBatchSprite*	pSprite;									/*!< スプライト(ワールド座標)						*/
+	uint32_t				nSpriteCount;								/*!< スプライト数									*/
+	uint32_t				nSpriteMax;									/*!< 入れられるスプライト数							*/
+	float					fCameraX;									/*!< カメラの位置X(画面の左上になるワールド座標)	*/
+	float					fCameraY;									/*!< カメラの位置Y									*/
+	Cat_Palette				aPalette[CAT_FRAMEPIPELINE_PALETTE_MAX];	/*!< パレット(256色、RGBA8888)						*/
+	uint32_t				nPaletteMask;								/*!< 設定したパレットのビット						*/
+	uint32_t				nFrame;										/*!< Cat_FramePipelineSubmit()した回数				*/
+	uint32_t				nSubmitTime;								/*!< Cat_FramePipelineSubmit()した時間(マイクロ秒)	*/
+} Cat_FrameSnapshot;
+
+//! スプライトの後に描画する関数
+/*!
+	描画するスレッドから、Cat_RenderBegin()とCat_RenderEnd()の間で呼ばれる。HUDなどを描画する。
+	@param[in]	pSnapshot	描画しているスナップショット
+	@param[in]	pvContext	Cat_FramePipelineCreate()で渡した値
+*/
+typedef void (*Cat_FramePipelineDrawFunc)( const Cat_FrameSnapshot* pSnapshot, void* pvContext );
+
+//! 統計情報
+typedef struct {
+	uint32_t	nSubmitCount;		/*!< 渡したスナップショット数									*/
+	uint32_t	nDropCount;			/*!< 描画される前に、次のスナップショットで上書きされた数		*/
+	uint32_t	nRenderCount;		/*!< 描画したスナップショット数									*/
+	uint32_t	nIdleCount;			/*!< 新しいスナップショットが無く、描画しなかった回数			*/
+	uint32_t	nRenderTime;		/*!< 描画にかかった時間の合計(マイクロ秒単位、画面の更新を含む)	*/
+	uint32_t	nRenderTimeMax;		/*!< 描画にかかった時間の最大値(マイクロ秒単位)					*/
+	uint32_t	nLatency;			/*!< 渡してから画面を更新するまでの時間の合計(マイクロ秒単位)	*/
+	uint32_t	nLatencyMax;		/*!< 渡してから画面を更新するまでの時間の最大値(マイクロ秒単位)	*/
+} Cat_FramePipelineStatistics;
+
+//! 作成する
+/*!
+	Cat_RenderInit()の後に呼ぶ。
+	@param[in]	nSpriteMax	1フレームのスプライト数
+	@param[in]	pfnDraw		スプライトの後に描画する関数(0の場合は呼ばない)
+	@param[in]	pvContext	\a pfnDraw に渡す値
+	@return	作成されたパイプライン。失敗した場合は0が返る。
+	@see	Cat_FramePipelineDestroy()
+*/
+extern Cat_FramePipeline* Cat_FramePipelineCreate( uint32_t nSpriteMax, Cat_FramePipelineDrawFunc pfnDraw, void* pvContext );
+
+//! 破棄する
+/*!
+	描画するスレッドが動いている場合は、止めてから破棄する。
+	@param[in]	pPipeline	パイプライン
+*/
+extern void Cat_FramePipelineDestroy( Cat_FramePipeline* pPipeline );
+
+//! 描画するスレッドを開始する
+/*!
+	@param[in]	pPipeline	パイプライン
+	@param[in]	nPriority	スレッドの優先度(PSPのみ。ゲームの処理をするスレッドより高くする)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+	@see	Cat_FramePipelineStop()
+*/
+extern int32_t Cat_FramePipelineStart( Cat_FramePipeline* pPipeline, int32_t nPriority );
+
+//! 描画するスレッドを止める
+/*!
+	描画中のフレームを描画し終わるまで待つ。
+	@param[in]	pPipeline	パイプライン
+*/
+extern void Cat_FramePipelineStop( Cat_FramePipeline* pPipeline );
+
+//! 書き込むスナップショットを取得する
+/*!
+	ゲームの処理をするスレッドから呼ぶ。スプライトとパレットは空になり、カメラは0になる。 \n
+	Cat_FramePipelineSubmit()するまで、同じスナップショットが返る。
+	@param[in]	pPipeline	パイプライン
+	@return	スナップショット
+*/
+extern Cat_FrameSnapshot* Cat_FramePipelineBeginSnapshot( Cat_FramePipeline* pPipeline );
+
+//! 書き込んだスナップショットを渡す
+/*!
+	渡した後は、そのスナップショットに書き込まないこと。
+	@param[in]	pPipeline	パイプライン
+*/
+extern void Cat_FramePipelineSubmit( Cat_FramePipeline* pPipeline );
+
+//! 最新のスナップショットを描画する
+/*!
+	描画するスレッドの中で呼ばれる。Cat_FramePipelineStart()せずに、ゲームの処理と同じスレッドで \n
+	Cat_FramePipelineSubmit()の後に呼ぶと、今までと同じ1つのスレッドで描画する。
+	@param[in]	pPipeline	パイプライン
+	@return	描画した場合は、1 \n
+			新しいスナップショットが無い場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+extern int32_t Cat_FramePipelineRender( Cat_FramePipeline* pPipeline );
+
+//! スプライトを追加する
+/*!
+	@param[in]	pSnapshot	スナップショット
+	@param[in]	pSprite		スプライト(位置はワールド座標)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+extern int32_t Cat_FrameSnapshotAddSprite( Cat_FrameSnapshot* pSnapshot, const Cat_SpriteBatchSprite* pSprite );
+
+//! パレットを設定する
+/*!
+	色をスナップショットにコピーするので、この後で \a pPalette を書き換えても構わない。
+	@param[in]	pSnapshot	スナップショット
+	@param[in]	nSlot		パレットの番号(0～CAT_FRAMEPIPELINE_PALETTE_MAX-1)
+	@param[in]	pPalette	コピーするパレット
+	@return	スプライトに設定するパレット。失敗した場合は0が返る。
+*/
+extern Cat_Palette* Cat_FrameSnapshotSetPalette( Cat_FrameSnapshot* pSnapshot, uint32_t nSlot, const Cat_Palette* pPalette );
+
+//! 統計情報を取得する
+/*!
+	@param[in]	pPipeline		パイプライン
+	@param[out]	pStatistics		統計情報
+*/
+extern void Cat_FramePipelineGetStatistics( Cat_FramePipeline* pPipeline, Cat_FramePipelineStatistics* pStatistics );
+
+//! 統計情報をクリアする
+/*!
+	ゲームの処理をするスレッドから呼ぶ。統計情報はそれぞれを書き込むスレッドがクリアするので、 \n
+	描画するスレッドが動いている間は、描画側の回数と時間は次のCat_FramePipelineRender()でクリアされる。
+	@param[in]	pPipeline	パイプライン
+*/
+extern void Cat_FramePipelineResetStatistics( Cat_FramePipeline* pPipeline );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCL_Cat_FramePipeline_h
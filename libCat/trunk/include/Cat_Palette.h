@@ -5,6 +5,8 @@
 #define INCL_Cat_Palette_h
 
 #include <stdint.h>
+#include "Cat_Arena.h"
+#include "Cat_Slab.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,9 +28,33 @@ typedef struct {
 	uint32_t	nSize;						/*!< パレットサイズ(32バイト単位)	*/
 	uint32_t	nMask;						/*!< パレットインデックスのマスク値	*/
 	uint32_t	nRef;						/*!< 参照カウンタ					*/
+	uint32_t	nSerial;					/*!< 更新カウンタ					*/
 	void*		pvData;						/*!< パレットデータ					*/
+	Cat_Arena*	pArena;						/*!< パレットデータを確保した領域(ヒープの場合は0)	*/
 } Cat_Palette;
 
+//! パレットデータを確保する領域を設定する
+/*!
+	設定されている間に作成されたパレットは、パレットデータを \a pArena から確保して参照を持つ。 \n
+	通常は、Cat_TextureSetArena()から設定される。
+	@param[in]	pArena	領域(0の場合はヒープから確保する)
+	@see	Cat_PaletteGetArena()
+*/
+extern void Cat_PaletteSetArena( Cat_Arena* pArena );
+
+//! パレットデータを確保する領域を取得する
+/*!
+	@return	領域
+	@see	Cat_PaletteSetArena()
+*/
+extern Cat_Arena* Cat_PaletteGetArena( void );
+
+//! パレット構造体の割り当ての統計情報を取得する
+/*!
+	@param[out]	pStatistics		統計情報
+*/
+extern void Cat_PaletteGetSlabStatistics( Cat_SlabStatistics* pStatistics );
+
 //! パレットを作成する
 /*!
 	@param[in]	ePaletteFormat	パレットフォーマット(FORMAT_PALETTE_xxx)
@@ -63,6 +89,14 @@ extern void Cat_PaletteAddRef( Cat_Palette* pPalette );
 */
 extern void Cat_PaletteSetPalette( Cat_Palette* pPalette );
 
+//! パレットの内容を更新したことを通知する
+/*!
+	pvDataを直接書き換えた後に呼び出すこと。 \n
+	更新カウンタが加算され、このパレットから作られた4bitパレットなどが再構成される。
+	@param[in]	pPalette	更新したパレット
+*/
+extern void Cat_PaletteUpdate( Cat_Palette* pPalette );
+
 //! パレットの色を取得する
 /*!
 	@param[in]	pPalette	パレット
@@ -0,0 +1,132 @@
+//! @file	Cat_PaletteEffect.h
+// パレットエフェクト
+
+#ifndef INCL_Cat_PaletteEffect_h
+#define INCL_Cat_PaletteEffect_h
+
+#include <stdint.h>
+#include "Cat_Palette.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! 乗算の等倍の値
+#define CAT_PALETTEEFFECT_UNIT (256)
+
+//! 乗算の最大値
+#define CAT_PALETTEEFFECT_MUL_MAX (2047)
+
+//! 加算の範囲(-511～511)
+#define CAT_PALETTEEFFECT_ADD_MAX (511)
+
+//! パレットエフェクトのパラメータ
+/*!
+	MUGENのPalFXと同じ順で、ピクセルではなくパレットの色を変える。 \n
+	色 = (彩度を変えた色(反転する場合は反転) + 加算 + 正弦波の加算) * 乗算 / 256 \n
+	単色にする場合は、元の色の代わりに単色を使って同じ計算をする(影やシルエット用)。 \n
+	アルファ = 元のアルファ * アルファの乗算 / 256
+*/
+typedef struct {
+	int32_t		nAdd[3];		/*!< R,G,Bに加算する値								*/
+	int32_t		nMul[3];		/*!< R,G,Bに乗算する値(256で等倍)					*/
+	int32_t		nSinAdd[3];		/*!< 正弦波で加算するR,G,Bの振幅					*/
+	uint32_t	nSinPeriod;		/*!< 正弦波の周期(フレーム単位、0なら加算しない)	*/
+	uint32_t	nTime;			/*!< 経過フレーム(正弦波の位相)						*/
+	uint32_t	fInvert;		/*!< 色を反転するかどうか							*/
+	uint32_t	nColor;			/*!< 彩度(256で等倍、0で白黒)						*/
+	uint32_t	fSolid;			/*!< 単色にするかどうか								*/
+	uint32_t	nSolidColor;	/*!< 単色の色(0xBBGGRR)								*/
+	uint32_t	nAlpha;			/*!< アルファに乗算する値(256で等倍、0で透明)		*/
+} Cat_PaletteEffectParam;
+
+//! パラメータを何もしない値で初期化する
+/*!
+	@param[out]	pParam	パラメータ
+*/
+extern void Cat_PaletteEffectParamInit( Cat_PaletteEffectParam* pParam );
+
+//! パラメータが何もしない値かどうか
+/*!
+	@param[in]	pParam	パラメータ
+	@return	何もしない値なら0以外を返す
+*/
+extern int32_t Cat_PaletteEffectParamIsIdentity( const Cat_PaletteEffectParam* pParam );
+
+//! パレットにエフェクトをかける
+/*!
+	ホストではSSE2で4色ずつ、PSPではスカラーで変換する。結果はどちらも同じになる。
+	@param[out]	pDest		出力先のパレット(\a pSource と同じフォーマットと色数)
+	@param[in]	pSource		元のパレット
+	@param[in]	pParam		パラメータ
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+extern int32_t Cat_PaletteEffectApply( Cat_Palette* pDest, const Cat_Palette* pSource, const Cat_PaletteEffectParam* pParam );
+
+//! エフェクトをかけたパレットのキャッシュ
+typedef struct _Cat_PaletteEffectCache Cat_PaletteEffectCache;
+
+//! キャッシュの統計情報
+typedef struct {
+	uint32_t	nRequestCount;		/*!< Cat_PaletteEffectCacheGet()の呼び出し回数			*/
+	uint32_t	nHitCount;			/*!< キャッシュにあった回数								*/
+	uint32_t	nBuildCount;		/*!< パレットを作った回数								*/
+	uint32_t	nOverflowCount;		/*!< 上書きできる場所(前のフレームまでで使っていない)が無かった回数	*/
+	uint32_t	nUsedCount;			/*!< 使っている場所の数									*/
+} Cat_PaletteEffectStatistics;
+
+//! キャッシュを作成する
+/*!
+	@param[in]	nCount	保持するパレットの数
+	@return	作成されたキャッシュ。失敗した場合は0が返る。
+	@see	Cat_PaletteEffectCacheDestroy()
+*/
+extern Cat_PaletteEffectCache* Cat_PaletteEffectCacheCreate( uint32_t nCount );
+
+//! キャッシュを破棄する
+/*!
+	@param[in]	pCache	キャッシュ
+*/
+extern void Cat_PaletteEffectCacheDestroy( Cat_PaletteEffectCache* pCache );
+
+//! エフェクトをかけたパレットを取得する
+/*!
+	元のパレットとその更新カウンタ、正弦波を計算した後のパラメータが同じなら、前に作ったパレットを返す。 \n
+	無ければ、最後に使われたのが古い場所に作る。 \n
+	このフレームと前のフレームで使った場所は上書きしない(前のフレームのパケットは、GEが描画中で読んでいる)。 \n
+	返したパレットは、2フレーム後以降に上書きされるかもしれないので、 \n
+	続けて使う場合は毎フレーム取得し直すか、Cat_PaletteAddRef()で保持すること。
+	@param[in]	pCache		キャッシュ
+	@param[in]	pSource		元のパレット
+	@param[in]	pParam		パラメータ
+	@return	エフェクトをかけたパレット。何もしないパラメータの場合と、 \n
+			場所が足りない場合と、失敗した場合は \a pSource が返る。
+*/
+extern Cat_Palette* Cat_PaletteEffectCacheGet( Cat_PaletteEffectCache* pCache, Cat_Palette* pSource, const Cat_PaletteEffectParam* pParam );
+
+//! フレームを進める
+/*!
+	1フレームに1回、Cat_RenderScreenUpdate()の後に呼ぶ。
+	@param[in]	pCache	キャッシュ
+*/
+extern void Cat_PaletteEffectCacheUpdate( Cat_PaletteEffectCache* pCache );
+
+//! 統計情報を取得する
+/*!
+	@param[in]	pCache			キャッシュ
+	@param[out]	pStatistics		統計情報
+*/
+extern void Cat_PaletteEffectCacheGetStatistics( Cat_PaletteEffectCache* pCache, Cat_PaletteEffectStatistics* pStatistics );
+
+//! 統計情報の回数をクリアする
+/*!
+	@param[in]	pCache	キャッシュ
+*/
+extern void Cat_PaletteEffectCacheResetStatistics( Cat_PaletteEffectCache* pCache );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCL_Cat_PaletteEffect_h
@@ -0,0 +1,71 @@
+//! @file	Cat_Quantize.h
+// 32bitイメージの減色
+
+#ifndef INCL_Cat_Quantize_h
+#define INCL_Cat_Quantize_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! パレットの色数の最大値
+#define CAT_QUANTIZE_COLOR_MAX (256)
+
+//! 減色
+/*!
+	アルファが0と255だけのRGBA8888のイメージから、メディアンカットでパレットを作る。 \n
+	透明なピクセルがあれば、透明色(0x00000000)に1色を割り当てる。 \n
+	使っている色がパレットに収まる場合は、元の色をそのままパレットにする。
+*/
+typedef struct {
+	uint32_t	nColorCount;						/*!< パレットの色数							*/
+	int32_t		nTransparent;						/*!< 透明色の番号(無ければ負数)				*/
+	uint32_t	fExact;								/*!< 元の色がすべてパレットにあるかどうか	*/
+	uint64_t	nError;								/*!< 変換したピクセルのRGBの二乗誤差の合計	*/
+	uint32_t	nSample;							/*!< 誤差を集計したチャンネル数				*/
+	uint32_t	anPalette[CAT_QUANTIZE_COLOR_MAX];	/*!< パレット(RGBA8888)						*/
+	uint8_t*	pnCube;								/*!< RGB各5bitからパレット番号への表		*/
+	uint32_t*	pnCubeValid;						/*!< 表を計算済みかどうか(1bitずつ)			*/
+} Cat_Quantize;
+
+//! イメージからパレットを作る
+/*!
+	@param[in]	pvImage		イメージ(RGBA8888)
+	@param[in]	nWidth		横幅(ピクセル単位)
+	@param[in]	nHeight		高さ(ピクセル単位)
+	@param[in]	nPitch		1ラインのバイト数
+	@param[in]	nColorMax	パレットの色数の上限(CAT_QUANTIZE_COLOR_MAX以下)
+	@return	作成された減色。半透明のピクセルがある場合や、失敗した場合は0が返る。
+	@see	Cat_QuantizeRelease()
+*/
+extern Cat_Quantize* Cat_QuantizeCreate( const void* pvImage, uint32_t nWidth, uint32_t nHeight, uint32_t nPitch, uint32_t nColorMax );
+
+//! 減色を解放する
+/*!
+	@param[in]	pQuantize	減色
+*/
+extern void Cat_QuantizeRelease( Cat_Quantize* pQuantize );
+
+//! イメージをパレット番号に変換する
+/*!
+	一番近いパレットの色は、RGB各5bitの表で引く。表は使った所だけ計算する。 \n
+	元の色との誤差を nError と nSample に加算する。透明なピクセルは誤差に含めない。
+	@param[in]	pQuantize	減色
+	@param[out]	pvDest		出力先(1ピクセル1バイト)
+	@param[in]	nDestPitch	出力先の1ラインのバイト数
+	@param[in]	pvImage		イメージ(RGBA8888)
+	@param[in]	nWidth		横幅(ピクセル単位)
+	@param[in]	nHeight		高さ(ピクセル単位)
+	@param[in]	nPitch		1ラインのバイト数
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+extern int32_t Cat_QuantizeMapImage( Cat_Quantize* pQuantize, void* pvDest, uint32_t nDestPitch, const void* pvImage, uint32_t nWidth, uint32_t nHeight, uint32_t nPitch );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCL_Cat_Quantize_h
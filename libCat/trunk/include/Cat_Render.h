@@ -1,10 +1,11 @@
 //! @file	Cat_Render.h
 // 描画関連
 
-#ifndef INCL_Cat_Base64_h
-#define INCL_Cat_Base64_h
+#ifndef INCL_Cat_Render_h
+#define INCL_Cat_Render_h
 
 #include <stdint.h>
+#include "Cat_Vram.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -21,6 +22,9 @@ enum {
 	CAT_RENDER_PARAM_BUFFER_SINGLE   = (1UL << 2),			/*!< シングルバッファ		*/
 	CAT_RENDER_PARAM_BUFFER_MASK     = (1UL << 2),
 
+	CAT_RENDER_PARAM_VRAM_TEXTURE    = (1UL << 3),			/*!< 空いているVRAMにテクスチャを置く	*/
+	CAT_RENDER_PARAM_TARGET          = (1UL << 4),			/*!< 画面1枚分の描画先をVRAMに確保する	*/
+
 	CAT_RENDER_DEFAULT = (CAT_RENDER_PARAM_FORMAT_RGBA8888 | CAT_RENDER_PARAM_BUFFER_DOUBLE),	/*!< デフォルト設定			*/
 };
 
@@ -40,10 +44,245 @@ extern void Cat_RenderBegin( void );
 extern void Cat_RenderEnd( void );
 
 //! 画面を更新する
+/*!
+	CAT_RENDER_PARAM_VRAM_TEXTUREを指定している場合は、VRAMのテクスチャの配置も更新する。
+*/
 extern void Cat_RenderScreenUpdate( void );
 
+//! フレームバッファと深度バッファ(と描画先)の後ろの空いているVRAMの位置を取得する
+/*!
+	@return	VRAMの先頭からのオフセット(バイト単位)
+*/
+extern uint32_t Cat_RenderGetVramOffset( void );
+
+//! テクスチャを置くVRAMの領域管理を取得する
+/*!
+	断片化を解消する場合は、Cat_RenderScreenUpdate()の後でCat_VramDefragment()を呼ぶ。
+	@return	領域管理。CAT_RENDER_PARAM_VRAM_TEXTUREを指定していない場合は0が返る。
+*/
+extern Cat_Vram* Cat_RenderGetVram( void );
+
+//! 描画先の横幅(ドット単位)
+#define CAT_RENDER_TARGET_WIDTH (480)
+//! 描画先の高さ(ドット単位)
+#define CAT_RENDER_TARGET_HEIGHT (272)
+//! 描画先の1ラインのピクセル数
+#define CAT_RENDER_TARGET_BUFFER_WIDTH (512)
+
+//! フレームバッファのピクセルフォーマットを取得する
+/*!
+	@return	ピクセルフォーマット(GU_PSM_xxx)
+*/
+extern int32_t Cat_RenderGetFormat( void );
+
+//! 表示しているフレームバッファのアドレスを取得する
+/*!
+	Cat_RenderScreenUpdate()の後は、1つ前に渡したフレームが描き終わって表示されていて、 \n
+	次のCat_RenderScreenUpdate()まで書き換えられない(シングルバッファの場合は描画中)。 \n
+	フレームバッファは、Cat_RenderGetFormat()のフォーマットで、1ラインCAT_RENDER_TARGET_BUFFER_WIDTHピクセル。
+	@return	アドレス(キャッシュを通さない)
+*/
+extern const void* Cat_RenderGetDisplay( void );
+
+//! 描画先のアドレスを取得する
+/*!
+	描画先は、フレームバッファと同じフォーマットで、CAT_RENDER_TARGET_WIDTH x CAT_RENDER_TARGET_HEIGHTドット。 \n
+	テクスチャとして使う場合は、512x512、1ラインCAT_RENDER_TARGET_BUFFER_WIDTHピクセルとして設定する。
+	@return	アドレス(キャッシュを通す)。CAT_RENDER_PARAM_TARGETを指定していない場合は0が返る。
+*/
+extern void* Cat_RenderGetTarget( void );
+
+//! 描画先に切り替える
+/*!
+	Cat_RenderBegin()とCat_RenderEnd()の間で呼ぶ。以降の描画は、Cat_RenderEndTarget()まで描画先に描かれる。 \n
+	シザーは変えないので、描く範囲に合わせて設定すること。描画先は毎フレーム消されずに残る。 \n
+	戻す先のフレームバッファが描画パケットに書き込まれるので、Cat_DisplayListで記録するリストでは使えない。
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+extern int32_t Cat_RenderBeginTarget( void );
+
+//! 描画先からフレームバッファに戻す
+/*!
+	シザーを画面全体に戻して、描画先をテクスチャとして読めるようにテクスチャキャッシュをフラッシュする。
+*/
+extern void Cat_RenderEndTarget( void );
+
+//! 描画パケットに使うメモリの既定値(2フレーム分、バイト単位)
+#define CAT_RENDER_LIST_BUDGET (2 * 1024 * 1024)
+//! 描画パケットを分割する大きさの既定値(バイト単位)
+#define CAT_RENDER_LIST_SEGMENT_SIZE (64 * 1024)
+//! 描画パケットを分割できる数の最大値
+#define CAT_RENDER_LIST_SEGMENT_MAX (64)
+
+//! 描画パケットの統計情報
+typedef struct {
+	uint32_t	nBudget;			/*!< 描画パケットに使うメモリ(バイト単位)							*/
+	uint32_t	nSegmentSize;		/*!< 分割する大きさ(バイト単位)										*/
+	uint32_t	nFrameCount;		/*!< Cat_RenderEnd()の回数											*/
+	uint32_t	nSize;				/*!< 前のフレームで使ったサイズ(バイト単位)							*/
+	uint32_t	nSizeMax;			/*!< 1フレームで使ったサイズの最大値(バイト単位)					*/
+	uint32_t	nSegmentCount;		/*!< 前のフレームで使った分割の数									*/
+	uint32_t	nSegmentCountMax;	/*!< 1フレームで使った分割の数の最大値								*/
+	uint32_t	nMemoryCount;		/*!< 前のフレームでのCat_RenderGetMemory()の回数					*/
+	uint32_t	nMemorySize;		/*!< 前のフレームでCat_RenderGetMemory()で確保したサイズ(バイト単位)	*/
+	uint32_t	nChainCount;		/*!< 分割した描画パケットをつないだ回数								*/
+	uint32_t	nStallCount;		/*!< 空きが無く、前のフレームの描画が終わるのを待った回数			*/
+	uint32_t	nOverflowCount;		/*!< 空きが無く、確保できなかった回数(その描画は捨てられる)			*/
+} Cat_RenderListStatistics;
+
+//! 描画パケットに使うメモリを設定する
+/*!
+	Cat_RenderInit()より前に呼ぶ。 \n
+	描画パケットは \a nSegmentSize ずつに分けて確保し、1フレームで足りなくなったら次の分割をつないで続ける。 \n
+	2フレーム分(描画中と作成中)で \a nBudget に収まるので、軽い場面なら小さくできる。 \n
+	Cat_RenderGetListStatistics()の最大値を見て決めるとよい。
+	@param[in]	nBudget			描画パケットに使うメモリ(バイト単位。0の場合はCAT_RENDER_LIST_BUDGET)
+	@param[in]	nSegmentSize	分割する大きさ(バイト単位。0の場合はCAT_RENDER_LIST_SEGMENT_SIZE)
+*/
+extern void Cat_RenderSetListBudget( uint32_t nBudget, uint32_t nSegmentSize );
+
+//! 描画パケットの中にメモリを確保する
+/*!
+	sceGuGetMemory()の代わりに使う。Cat_RenderBegin()とCat_RenderEnd()の間で呼ぶ。 \n
+	今の分割に収まらない場合は、次の分割につないでから確保するので、描画パケットが溢れることはない。 \n
+	続けて積む設定とsceGuDrawArray()の分も空けておく。
+	@param[in]	nSize	サイズ(バイト単位)
+	@return	確保したメモリ。空きが無い場合は0が返るので、その描画はしないこと。
+*/
+extern void* Cat_RenderGetMemory( uint32_t nSize );
+
+//! 描画パケットにコマンドを積む空きを確保する
+/*!
+	Cat_RenderBegin()とCat_RenderEnd()の間で、Cat_RenderGetMemory()を使わずにコマンドを積む前に呼ぶ。 \n
+	今の分割に収まらない場合は、次の分割につなぐ。Cat_RenderBegin()の外では何もしない。
+	@param[in]	nSize	積むコマンドのサイズ(バイト単位)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返るので、そのコマンドは積まないこと。
+*/
+extern int32_t Cat_RenderReserve( uint32_t nSize );
+
+//! Cat_RenderBegin()の外で確保する関数
+/*!
+	@param[in]	pvContext	Cat_RenderSetMemoryFunc()で渡した値
+	@param[in]	nSize		サイズ(バイト単位)
+	@return	確保したメモリ。空きが無い場合は0を返す。
+*/
+typedef void* (*Cat_RenderMemoryFunc)( void* pvContext, uint32_t nSize );
+
+//! Cat_RenderBegin()の外でCat_RenderGetMemory()が確保する関数を設定する
+/*!
+	描画パケットを別に作る時に、溢れないように確保したり、確保した頂点を覚えたりするのに使う。 \n
+	Cat_DisplayListが記録している間に設定する。
+	@param[in]	pfnMemory	確保する関数(0の場合はsceGuGetMemory())
+	@param[in]	pvContext	\a pfnMemory に渡す値
+*/
+extern void Cat_RenderSetMemoryFunc( Cat_RenderMemoryFunc pfnMemory, void* pvContext );
+
+//! Cat_RenderScreenUpdate()した回数を取得する
+/*!
+	作成中のフレームの番号として、GEが読んでいるかもしれないデータを書き換えないように使う。 \n
+	1つ前のフレームはGEが描画中かもしれないが、それより前のフレームは描画し終わっている。
+	@return	回数
+*/
+extern uint32_t Cat_RenderGetFrame( void );
+
+//! 描画パケットの統計情報を取得する
+/*!
+	@param[out]	pStatistics		統計情報
+*/
+extern void Cat_RenderGetListStatistics( Cat_RenderListStatistics* pStatistics );
+
+//! 描画パケットの統計情報をクリアする
+/*!
+	設定と、前のフレームの値は残る。
+*/
+extern void Cat_RenderResetListStatistics( void );
+
+//! フレームの統計情報を平均と最大値に使うフレーム数
+#define CAT_RENDER_FRAME_HISTORY (60)
+
+//! フレームの統計情報の種類
+enum {
+	CAT_RENDER_FRAME_CURRENT = 0,		/*!< 作成中のフレーム							*/
+	CAT_RENDER_FRAME_LAST,				/*!< 前のフレーム								*/
+	CAT_RENDER_FRAME_AVERAGE,			/*!< 直近CAT_RENDER_FRAME_HISTORYフレームの平均	*/
+	CAT_RENDER_FRAME_MAX,				/*!< 直近CAT_RENDER_FRAME_HISTORYフレームの最大値	*/
+};
+
+//! 数える描画の設定
+enum {
+	CAT_RENDER_COUNT_TEXTURE = 0,		/*!< テクスチャの設定	*/
+	CAT_RENDER_COUNT_PALETTE,			/*!< パレットの設定		*/
+};
+
+//! フレームの統計情報
+/*!
+	Cat_RenderBegin()からCat_RenderEnd()までに積んだ描画を数える。 
+
+	Cat_RenderDrawArray()、Cat_TextureSetTexture()、Cat_PaletteSetPalette()を通ったものだけが数えられるので、 
+
+	sceGuDrawArray()を直接呼んだ描画は入らない。Cat_DisplayListで記録した描画は、呼んだフレームで数える。
+*/
+typedef struct {
+	uint32_t	nDrawCount;			/*!< Cat_RenderDrawArray()の回数									*/
+	uint32_t	nVertexCount;		/*!< 頂点の数														*/
+	uint32_t	nPixelCount;		/*!< 描画するピクセル数の見積もり(Cat_RenderEnablePixelCount()で有効)	*/
+	uint32_t	nTextureCount;		/*!< テクスチャを設定した回数										*/
+	uint32_t	nPaletteCount;		/*!< パレットを設定した回数											*/
+	uint32_t	nListSize;			/*!< GEが読むリストのサイズ(描画パケットと呼んだリスト、バイト単位)	*/
+	uint32_t	nTime;				/*!< Cat_RenderBegin()からCat_RenderEnd()までの時間(マイクロ秒単位)	*/
+} Cat_RenderFrameStatistics;
+
+//! 描画する
+/*!
+	sceGuDrawArray()の代わりに使い、描画の回数と頂点の数をフレームの統計情報に加える。 
+
+	Cat_RenderEnablePixelCount()で有効にした場合は、GU_TRANSFORM_2Dのスプライトと三角形から 
+
+	描画するピクセル数を見積もる(スプライトは画面の外を切り取る。テクスチャの透明な所も数える)。
+	@param[in]	nPrim		プリミティブ(GU_SPRITESなど)
+	@param[in]	nVertexType	頂点の種類
+	@param[in]	nCount		頂点数
+	@param[in]	pvIndex		インデックス(無い場合は0)
+	@param[in]	pvVertex	頂点
+*/
+extern void Cat_RenderDrawArray( int32_t nPrim, int32_t nVertexType, int32_t nCount, const void* pvIndex, const void* pvVertex );
+
+//! 描画の設定を数える
+/*!
+	Cat_TextureSetTexture()とCat_PaletteSetPalette()から呼ばれる。
+	@param[in]	nType	CAT_RENDER_COUNT_xxx
+*/
+extern void Cat_RenderCount( int32_t nType );
+
+//! 描画するピクセル数を見積もるかどうかを設定する
+/*!
+	見積もる時は、キャッシュを通さずに書いた頂点を読み直すので遅くなる。既定値は0。
+	@param[in]	fEnable		見積もる場合は0以外
+*/
+extern void Cat_RenderEnablePixelCount( int32_t fEnable );
+
+//! フレームの統計情報を作成中のフレームに加える
+/*!
+	Cat_DisplayListCall()が、記録した描画の分を加えるのに使う。nTimeは加えない。
+	@param[in]	pStatistics		加える値
+*/
+extern void Cat_RenderAddFrameStatistics( const Cat_RenderFrameStatistics* pStatistics );
+
+//! フレームの統計情報を取得する
+/*!
+	前のフレームと平均と最大値は、Cat_RenderEnd()で更新される。
+	@param[in]	nType			CAT_RENDER_FRAME_xxx
+	@param[out]	pStatistics		統計情報
+*/
+extern void Cat_RenderGetFrameStatistics( int32_t nType, Cat_RenderFrameStatistics* pStatistics );
+
+//! フレームの統計情報の平均と最大値をクリアする
+extern void Cat_RenderResetFrameStatistics( void );
+
 #ifdef __cplusplus
 }
 #endif
 
-#endif // INCL_Cat_Base64_h
+#endif // INCL_Cat_Render_h
@@ -0,0 +1,73 @@
+//! @file	Cat_RenderOverlay.h
+// フレームの統計情報の画面表示
+
+#ifndef INCL_Cat_RenderOverlay_h
+#define INCL_Cat_RenderOverlay_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! フレームの統計情報の画面表示
+/*!
+	Cat_RenderGetFrameStatistics()の前のフレーム、平均、最大値を、半透明の枠の中に表にして描画する。 \n
+	行ごとに、最大値に対する前のフレームの値を緑の棒で、平均を黄色の目盛りで描く。 \n
+	\n
+	- 行は、描画の回数(DRAW)、頂点の数(VERT)、ピクセル数(PIX)、テクスチャ(TEX)とパレット(PAL)の設定の回数、 \n
+	  リストのサイズ(LIST、バイト単位)、Cat_RenderBegin()からCat_RenderEnd()までの時間(TIME、マイクロ秒単位)と、 \n
+	  ピクセル数が画面何枚分か(FILL、100で1枚分)。
+	- PIXとFILLは、Cat_RenderEnablePixelCount()で見積もりを有効にした場合だけ数えられる。 \n
+	  画面1枚分を大きく超えている場面は、スプライトの透明な縁や重ねた背景で描画の手間を使っている。
+	- フォントは中に持っているので、ファイルは要らない。テクスチャ1枚で、1回のCat_RenderDrawArray()で描画する。
+	- 表示の描画も数えられるので、前のフレームの値には表示の分(描画1回、テクスチャとパレット1回ずつ)が入る。
+
+	@code
+	pOverlay = Cat_RenderOverlayCreate();
+	Cat_RenderEnablePixelCount( 1 );
+	...
+	Cat_RenderBegin(); {
+		...
+		Cat_RenderOverlayDraw( pOverlay, 4, 4 );	// 最後に描画する
+	} Cat_RenderEnd();
+	@endcode
+*/
+typedef struct _Cat_RenderOverlay Cat_RenderOverlay;
+
+//! 表示の横幅(ドット単位)
+#define CAT_RENDEROVERLAY_WIDTH (160)
+//! 表示の高さ(ドット単位)
+#define CAT_RENDEROVERLAY_HEIGHT (68)
+
+//! 作成する
+/*!
+	@return	作成されたもの。失敗した場合は0が返る。
+	@see	Cat_RenderOverlayDestroy()
+*/
+extern Cat_RenderOverlay* Cat_RenderOverlayCreate( void );
+
+//! 破棄する
+/*!
+	GEが描画し終わってから呼ぶこと。
+	@param[in]	pOverlay	画面表示
+*/
+extern void Cat_RenderOverlayDestroy( Cat_RenderOverlay* pOverlay );
+
+//! 描画する
+/*!
+	Cat_RenderBegin()とCat_RenderEnd()の間で呼ぶ。 \n
+	ブレンドを半透明にして、テクスチャのフィルタを最近傍にして描画し、フィルタは線形に戻す。
+	@param[in]	pOverlay	画面表示
+	@param[in]	x			左上の位置X(ドット単位)
+	@param[in]	y			左上の位置Y(ドット単位)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+extern int32_t Cat_RenderOverlayDraw( Cat_RenderOverlay* pOverlay, int32_t x, int32_t y );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCL_Cat_RenderOverlay_h
@@ -0,0 +1,111 @@
+//! @file	Cat_RenderState.h
+// 描画ステートのキャッシュ
+
+#ifndef INCL_Cat_RenderState_h
+#define INCL_Cat_RenderState_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! 描画ステートの種類
+typedef enum {
+	CAT_RENDERSTATE_TEXTURE_ENABLE = 0,		/*!< テクスチャの有効/無効			*/
+	CAT_RENDERSTATE_TEXTURE_MODE   = 1,		/*!< テクスチャのフォーマット		*/
+	CAT_RENDERSTATE_TEXTURE_IMAGE  = 2,		/*!< テクスチャのアドレスと大きさ	*/
+	CAT_RENDERSTATE_TEXTURE_SCALE  = 3,		/*!< テクスチャのスケール			*/
+	CAT_RENDERSTATE_CLUT_MODE      = 4,		/*!< パレットのフォーマット			*/
+	CAT_RENDERSTATE_CLUT_LOAD      = 5,		/*!< パレットの読み込み				*/
+	CAT_RENDERSTATE_BLEND          = 6,		/*!< ブレンドの方法					*/
+
+	CAT_RENDERSTATE_MAX						/*!< 最大値							*/
+} CAT_RENDERSTATE;
+
+//! 統計情報
+typedef struct {
+	uint32_t	nRequest[CAT_RENDERSTATE_MAX];	/*!< 設定を要求された回数			*/
+	uint32_t	nIssue[CAT_RENDERSTATE_MAX];	/*!< 実際にGEへ命令を出した回数		*/
+} Cat_RenderStateStatistics;
+
+//! キャッシュを使うかどうかを設定する
+/*!
+	使わない場合は、要求されるたびに命令を出す。比較や不具合の切り分けに使う。
+	@param[in]	fEnable		使う場合は0以外
+*/
+extern void Cat_RenderStateSetEnable( int32_t fEnable );
+
+//! 覚えている描画ステートを捨てる
+/*!
+	描画パケットの先頭では、Cat_RenderBegin()から呼ばれる。 \n
+	sceGuTexImage()などを直接呼んだ場合も、その後に呼ぶこと。
+*/
+extern void Cat_RenderStateInvalidate( void );
+
+//! テクスチャを有効/無効にする
+/*!
+	@param[in]	fEnable		有効にする場合は0以外
+*/
+extern void Cat_RenderStateEnableTexture( int32_t fEnable );
+
+//! テクスチャのフォーマットを設定する
+/*!
+	@param[in]	nFormat		ピクセルフォーマット(GU_PSM_xxx)
+	@param[in]	nSwizzle	入れ替えているかどうか
+*/
+extern void Cat_RenderStateTexMode( int32_t nFormat, int32_t nSwizzle );
+
+//! テクスチャのアドレスと大きさを設定する
+/*!
+	変わった場合は、テクスチャキャッシュもフラッシュする。
+	@param[in]	nWidth		横幅(2の乗数)
+	@param[in]	nHeight		高さ(2の乗数)
+	@param[in]	nBufferWidth	1ラインのピクセル数
+	@param[in]	pvData		ピクセルデータ
+*/
+extern void Cat_RenderStateTexImage( int32_t nWidth, int32_t nHeight, int32_t nBufferWidth, const void* pvData );
+
+//! テクスチャのスケールを設定する
+/*!
+	@param[in]	u	横のスケール
+	@param[in]	v	縦のスケール
+*/
+extern void Cat_RenderStateTexScale( float u, float v );
+
+//! パレットを設定する
+/*!
+	同じデータでも、更新カウンタが変わっていれば読み込み直す。
+	@param[in]	nFormat		パレットフォーマット(GU_PSM_xxx)
+	@param[in]	nMask		パレットインデックスのマスク値
+	@param[in]	nSize		パレットサイズ(32バイト単位)
+	@param[in]	pvData		パレットデータ
+	@param[in]	nSerial		パレットの更新カウンタ
+*/
+extern void Cat_RenderStateClut( int32_t nFormat, uint32_t nMask, uint32_t nSize, const void* pvData, uint32_t nSerial );
+
+//! ブレンドの方法を設定する
+/*!
+	引数はsceGuBlendFunc()と同じ。
+	@param[in]	nOp		演算(GU_ADDなど)
+	@param[in]	nSrc	描画する色の係数
+	@param[in]	nDest	描画先の色の係数
+	@param[in]	nFixA	固定値A
+	@param[in]	nFixB	固定値B
+*/
+extern void Cat_RenderStateBlendFunc( int32_t nOp, int32_t nSrc, int32_t nDest, uint32_t nFixA, uint32_t nFixB );
+
+//! 統計情報を取得する
+/*!
+	@param[out]	pStatistics		統計情報
+*/
+extern void Cat_RenderStateGetStatistics( Cat_RenderStateStatistics* pStatistics );
+
+//! 統計情報をクリアする
+extern void Cat_RenderStateResetStatistics( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCL_Cat_RenderState_h
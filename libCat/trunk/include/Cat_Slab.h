@@ -0,0 +1,74 @@
+//! @file	Cat_Slab.h
+// 固定サイズのオブジェクトの割り当て
+
+#ifndef INCL_Cat_Slab_h
+#define INCL_Cat_Slab_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! 固定サイズのオブジェクトの割り当て
+/*!
+	同じ大きさのオブジェクトを、まとめて確保したチャンクから切り出す。 \n
+	チャンクはチャンクサイズ境界に置くので、オブジェクトのアドレスからチャンクが分かる。 \n
+	CAT_SLAB_NO_POOLを定義してビルドすると、1個ずつヒープから確保する(比較用)。
+*/
+typedef struct _Cat_Slab Cat_Slab;
+
+//! 統計情報
+typedef struct {
+	uint32_t	nObjectSize;		/*!< オブジェクトのサイズ(バイト単位)		*/
+	uint32_t	nUsedCount;			/*!< 使用中のオブジェクト数					*/
+	uint32_t	nChunkCount;		/*!< 確保しているチャンク数					*/
+	uint32_t	nAllocCount;		/*!< Cat_SlabAlloc()の回数					*/
+	uint32_t	nFreeCount;			/*!< Cat_SlabFree()の回数					*/
+	uint32_t	nHeapAllocCount;	/*!< ヒープから確保した回数					*/
+} Cat_SlabStatistics;
+
+//! 作成する
+/*!
+	@param[in]	nObjectSize		オブジェクトのサイズ(バイト単位)
+	@param[in]	nChunkSize		チャンクのサイズ(2の乗数、バイト単位)
+	@return	作成された割り当て。失敗した場合は0が返る。
+	@see	Cat_SlabDestroy()
+*/
+extern Cat_Slab* Cat_SlabCreate( uint32_t nObjectSize, uint32_t nChunkSize );
+
+//! 破棄する
+/*!
+	使用中のオブジェクトがあっても、チャンクはすべて解放される。
+	@param[in]	pSlab	割り当て
+*/
+extern void Cat_SlabDestroy( Cat_Slab* pSlab );
+
+//! オブジェクトを確保する
+/*!
+	16バイト境界のメモリを返す。中身は初期化されない。
+	@param[in]	pSlab	割り当て
+	@return	確保したメモリ。失敗した場合は0が返る。
+*/
+extern void* Cat_SlabAlloc( Cat_Slab* pSlab );
+
+//! オブジェクトを解放する
+/*!
+	チャンクが空になった場合は、1つだけ予備に残して解放する。
+	@param[in]	pSlab	割り当て
+	@param[in]	pv		Cat_SlabAlloc()で確保したメモリ
+*/
+extern void Cat_SlabFree( Cat_Slab* pSlab, void* pv );
+
+//! 統計情報を取得する
+/*!
+	@param[in]	pSlab			割り当て
+	@param[out]	pStatistics		統計情報
+*/
+extern void Cat_SlabGetStatistics( Cat_Slab* pSlab, Cat_SlabStatistics* pStatistics );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCL_Cat_Slab_h
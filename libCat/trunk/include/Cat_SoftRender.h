@@ -0,0 +1,148 @@
+//! @file	Cat_SoftRender.h
+// ソフトウェア描画(Linuxでのテスト用)
+
+#ifndef INCL_Cat_SoftRender_h
+#define INCL_Cat_SoftRender_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! ソフトウェア描画
+/*!
+	libCatが使っているsceGu*()をソフトウェアで実装して、実機やGPUが無くても描画できるようにする。 \n
+	Cat_Render、Cat_Texture、Cat_Palette、Cat_SpriteBatchなどは変更せずに、そのまま使える。 \n
+	\n
+	USE_CAT_SOFTRENDERを定義した時だけ有効になる(PSP向けのビルドでは空になる)。 \n
+	Linuxでは、USE_CAT_SOFTRENDERを定義し、PSPSDKのヘッダを参照して、libCatの描画関連のソースと一緒に \n
+	ビルドして、-lpthreadをリンクする。sceGu*()の他に、描画関連が使っている \n
+	sceGeEdram*()、sceDisplayWaitVblankStart*()、sceKernelDcache*()、sceKernelGetSystemTimeLow()、 \n
+	sceKernelDelayThread()も実装する。test/host/Makefileが、描画関連のテストをこの形でビルドして実行する例になる。 \n
+	\n
+	- VRAMは、実機と同じ0x04000000とキャッシュを通さない0x44000000に同じメモリを割り当てるので、 \n
+	  アドレスをuint32_tにキャストしているコードもそのまま動く。
+	- GU_CALLのリストは記録するだけで、GU_DIRECTのリストをsceGuFinish()した時に実行する。 \n
+	  描画はsceGuSync()を待たずに終わっているが、実機と同じタイミングで読めば結果は同じになる。
+	- 実行する時は、画面をCAT_SOFTRENDER_TILE_SIZE四方のタイルに分けて、スプライトをタイルに振り分け、 \n
+	  タイルごとにスレッドで描画する。1つのタイルの中では積んだ順番で描画するので、結果はスレッド数によらない。
+	- 描画できるのは、GU_SPRITESとGU_TRIANGLESで、GU_TEXTURE_16BIT | GU_VERTEX_16BIT | GU_TRANSFORM_2D \n
+	  (GU_COLOR_8888は有っても無くてもよい)の頂点だけ。GU_TRIANGLESは8bitと16bitのインデックスも使えるが、 \n
+	  色は補間しないので、3つの頂点の色が同じ三角形だけを描画する。
+	- テクスチャは、5650、5551、4444、8888、CLUT4、CLUT8と、それぞれの入れ替え(スウィズル)済みの並び。 \n
+	  DXTは描画しない。フィルタは常に最近傍で、深度は無視する。
+	- フレームバッファのアルファは、実機と同じくステンシルとして扱い、クリアとステンシルの操作でだけ書き換える。 \n
+	  深度バッファは無いので、ステンシルの操作はテストに通った時(zpass)のものを使う。
+	- sceGuDrawBufferList()で切り替えた描画先にも描画できる。リストの先頭ではsceGuDrawBuffer()の描画先に戻る。
+	- Cat_SoftRenderEnableOverdraw()で、画面のピクセルごとに描画した回数(重ね描き)を数えられる。 \n
+	  スプライトの透明な縁や重ねた背景が、どれだけ描画の手間を使っているかを見るのに使う。
+
+	@code
+	Cat_SoftRenderInit( 0 );	// Cat_RenderInit()より前に呼ぶ(呼ばなければ、CPUの数で初期化される)
+	Cat_RenderInit( CAT_RENDER_PARAM_FORMAT_RGBA8888 | CAT_RENDER_PARAM_BUFFER_SINGLE );
+	Cat_RenderBegin(); {
+		...
+	} Cat_RenderEnd();
+	Cat_RenderScreenUpdate();
+	Cat_SoftRenderReadPixels( anPixel );	// 今描画した画面
+	Cat_RenderTerm();
+	Cat_SoftRenderTerm();
+	@endcode
+*/
+
+//! タイルの大きさ(ドット単位)
+#define CAT_SOFTRENDER_TILE_SIZE (32)
+//! スレッド数の最大値
+#define CAT_SOFTRENDER_THREAD_MAX (64)
+
+//! 統計情報
+typedef struct {
+	uint32_t	nThreadCount;		/*!< 描画するスレッド数(呼び出したスレッドを含む)		*/
+	uint32_t	nListCount;			/*!< 実行したGU_DIRECTのリストの数						*/
+	uint32_t	nDrawCount;			/*!< sceGuDrawArray()の回数								*/
+	uint32_t	nSpriteCount;		/*!< 描画したスプライト数(クリアを含む)					*/
+	uint32_t	nPixelCount;		/*!< 書き込んだピクセル数								*/
+	uint32_t	nUnsupportedCount;	/*!< 対応していない頂点やテクスチャで描画しなかった回数	*/
+	uint32_t	nTime;				/*!< 描画にかかった時間(マイクロ秒単位)					*/
+} Cat_SoftRenderStatistics;
+
+//! 重ね描きの統計情報
+typedef struct {
+	uint32_t	nFragmentCount;		/*!< 画面に描画したピクセル数(クリアを除き、アルファテストで捨てたものを含む)	*/
+	uint32_t	nTransparentCount;	/*!< そのうち、色のアルファが0だったピクセル数(描画しても見た目が変わらない)	*/
+	uint32_t	nCoveredCount;		/*!< 1回以上描画された画面のピクセル数											*/
+	uint32_t	nMax;				/*!< 1つのピクセルに描画した回数の最大値										*/
+} Cat_SoftRenderOverdraw;
+
+//! 初期化する
+/*!
+	VRAMを割り当てて、描画するスレッドを作る。Cat_RenderInit()より前に呼ぶ。 \n
+	既に初期化されている場合は、何もしない。
+	@param[in]	nThreadCount	描画するスレッド数(呼び出したスレッドを含む。0の場合はCPUの数)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+	@see	Cat_SoftRenderTerm()
+*/
+extern int32_t Cat_SoftRenderInit( uint32_t nThreadCount );
+
+//! 終了処理をする
+/*!
+	スレッドを終了して、VRAMを解放する。Cat_RenderTerm()の後に呼ぶ。
+*/
+extern void Cat_SoftRenderTerm( void );
+
+//! 垂直同期の周波数を設定する
+/*!
+	0以外を設定すると、sceDisplayWaitVblankStart*()が次の区切り(1/周波数秒ごと)まで待つ。 \n
+	スレッドを分けた描画など、実機と同じ間隔で待たないと計測できない場合に使う。既定値は0。
+	@param[in]	nRefreshRate	周波数(Hz単位。0の場合は待たない)
+*/
+extern void Cat_SoftRenderSetRefreshRate( uint32_t nRefreshRate );
+
+//! 最後に描画した画面を読み出す
+/*!
+	最後に実行したリストの描画先から、480x272ドットを0xAABBGGRRの32bitに変換して読み出す。 \n
+	Cat_RenderScreenUpdate()でリストが実行されるので、その後に呼ぶ。
+	@param[out]	pnDest	読み出し先(480*272個)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+extern int32_t Cat_SoftRenderReadPixels( uint32_t* pnDest );
+
+//! 統計情報を取得する
+/*!
+	@param[out]	pStatistics		統計情報
+*/
+extern void Cat_SoftRenderGetStatistics( Cat_SoftRenderStatistics* pStatistics );
+
+//! 統計情報をクリアする
+extern void Cat_SoftRenderResetStatistics( void );
+
+//! 重ね描きを数えるかどうかを設定する
+/*!
+	数える場合は、画面(sceGuDrawBuffer()の描画先)のピクセルごとに、クリア以外で描画した回数を数える。 \n
+	sceGuDrawBufferList()で切り替えた描画先への描画は数えない。既定値は0。
+	@param[in]	fEnable		数える場合は0以外
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+extern int32_t Cat_SoftRenderEnableOverdraw( int32_t fEnable );
+
+//! 重ね描きを読み出してクリアする
+/*!
+	前に読み出してから実行したリストの分が読み出される。Cat_RenderScreenUpdate()の後に、毎フレーム呼ぶ。 \n
+	ヒートマップの色は、描画した回数が0回は黒、1回は青、2回は緑、3回は黄、4回は橙、5～7回は赤、8回以上は白。
+	@param[out]	pnCount		ピクセルごとに描画した回数(480*272個。要らない場合は0)
+	@param[out]	pnHeatmap	ヒートマップ(480*272個、0xAABBGGRR。要らない場合は0)
+	@param[out]	pOverdraw	重ね描きの統計情報(要らない場合は0)
+	@return	成功した場合は、0 \n
+			数えていない場合は、負数が返る
+*/
+extern int32_t Cat_SoftRenderReadOverdraw( uint16_t* pnCount, uint32_t* pnHeatmap, Cat_SoftRenderOverdraw* pOverdraw );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCL_Cat_SoftRender_h
@@ -0,0 +1,129 @@
+//! @file	Cat_SpriteBatch.h
+// スプライトをまとめて描画する
+
+#ifndef INCL_Cat_SpriteBatch_h
+#define INCL_Cat_SpriteBatch_h
+
+#include <stdint.h>
+#include "Cat_Texture.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! スプライトをまとめて描画する
+/*!
+	1フレーム分のスプライトを溜めておき、レイヤー、ブレンド、テクスチャとパレットの順に並べ替えて、 \n
+	頂点をまとめて書き出し、設定が同じ間は1回のsceGuDrawArray()で描画する。 \n
+	同じレイヤーの中では、描画の順番は保証しない(同じテクスチャとパレットの中では追加した順)。
+*/
+typedef struct _Cat_SpriteBatch Cat_SpriteBatch;
+
+//! 左右反転
+#define CAT_SPRITEBATCH_FLIP_X (1UL << 0)
+//! 上下反転
+#define CAT_SPRITEBATCH_FLIP_Y (1UL << 1)
+
+//! レイヤーの最大値
+#define CAT_SPRITEBATCH_LAYER_MAX (255)
+//! 重みの等倍の値
+#define CAT_SPRITEBATCH_ALPHA_UNIT (256)
+
+//! ブレンドの方法
+enum {
+	CAT_SPRITEBATCH_BLEND_ALPHA = 0,	/*!< 半透明	*/
+	CAT_SPRITEBATCH_BLEND_ADD   = 1,	/*!< 加算	*/
+	CAT_SPRITEBATCH_BLEND_SUB   = 2,	/*!< 減算	*/
+	CAT_SPRITEBATCH_BLEND_ADDALPHA = 3,	/*!< 重み付き加算(nSrcAlphaとnDestAlpha)	*/
+
+	CAT_SPRITEBATCH_BLEND_MAX			/*!< 最大値	*/
+};
+
+//! スプライト
+typedef struct {
+	Cat_Texture*	pTexture;		/*!< テクスチャ												*/
+	Cat_Palette*	pPalette;		/*!< パレット(0の場合はテクスチャのパレット)				*/
+	float			x;				/*!< 描画位置X(ドット単位)									*/
+	float			y;				/*!< 描画位置Y(ドット単位)									*/
+	float			fScaleX;		/*!< 横の拡大率(1で等倍)									*/
+	float			fScaleY;		/*!< 縦の拡大率(1で等倍)									*/
+	uint32_t		nFlags;			/*!< CAT_SPRITEBATCH_FLIP_xxxの論理和						*/
+	uint32_t		nLayer;			/*!< レイヤー(0～CAT_SPRITEBATCH_LAYER_MAX、小さい方が奥)	*/
+	uint32_t		nBlend;			/*!< ブレンドの方法(CAT_SPRITEBATCH_BLEND_xxx)				*/
+	uint32_t		nSrcAlpha;		/*!< CAT_SPRITEBATCH_BLEND_ADDALPHAのソースの重み(0～256)		*/
+	uint32_t		nDestAlpha;		/*!< CAT_SPRITEBATCH_BLEND_ADDALPHAの描画先の重み(0～256)		*/
+} Cat_SpriteBatchSprite;
+
+//! 統計情報
+typedef struct {
+	uint32_t	nFlushCount;		/*!< Cat_SpriteBatchFlush()の回数						*/
+	uint32_t	nSpriteCount;		/*!< 描画したスプライト数(分割テクスチャは分割後の数)	*/
+	uint32_t	nCullCount;			/*!< 画面外で描画しなかったスプライト数					*/
+	uint32_t	nBatchCount;		/*!< sceGuDrawArray()の回数								*/
+	uint32_t	nStateCount;		/*!< テクスチャかパレットかブレンドを切り替えた回数		*/
+	uint32_t	nVertexSize;		/*!< 書き出した頂点のサイズ(バイト単位)					*/
+	uint32_t	nOverflowCount;		/*!< 溜められる数を超えて追加できなかった回数			*/
+	uint32_t	nDropCount;			/*!< 描画パケットに空きが無く描画しなかったスプライト数	*/
+} Cat_SpriteBatchStatistics;
+
+//! スプライトを初期値で初期化する
+/*!
+	等倍、反転なし、レイヤー0、半透明になる。重み付き加算の重みは、ソースが等倍、描画先が0になる。
+	@param[out]	pSprite	スプライト
+*/
+extern void Cat_SpriteBatchSpriteInit( Cat_SpriteBatchSprite* pSprite );
+
+//! 作成する
+/*!
+	@param[in]	nCount	1フレームで溜められるスプライト数(分割テクスチャは分割後の数)
+	@return	作成されたバッチ。失敗した場合は0が返る。
+	@see	Cat_SpriteBatchDestroy()
+*/
+extern Cat_SpriteBatch* Cat_SpriteBatchCreate( uint32_t nCount );
+
+//! 破棄する
+/*!
+	@param[in]	pBatch	バッチ
+*/
+extern void Cat_SpriteBatchDestroy( Cat_SpriteBatch* pBatch );
+
+//! スプライトを追加する
+/*!
+	テクスチャとパレットの参照は持たないので、Cat_SpriteBatchFlush()まで解放しないこと。 \n
+	CAT_SPRITEBATCH_BLEND_ADDALPHAは、GU_FIXの重みで合成して、アルファが0のテクセルはアルファテストで捨てる。 \n
+	テクスチャのアルファは透明かどうかにだけ使うので、MUGENのスプライトと同じく透明と不透明だけのテクスチャに使う。 \n
+	重みは並べ替えのキーに入らないので、同じレイヤーで重みの違うスプライトを混ぜると、設定の切り替えが増える。
+	@param[in]	pBatch	バッチ
+	@param[in]	pSprite	スプライト
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+extern int32_t Cat_SpriteBatchAdd( Cat_SpriteBatch* pBatch, const Cat_SpriteBatchSprite* pSprite );
+
+//! 溜めたスプライトを描画する
+/*!
+	Cat_RenderBegin()とCat_RenderEnd()の間で呼ぶ。溜めたスプライトは空になる。 \n
+	描画後は、ブレンドの方法を半透明に戻す(重み付き加算で有効にしたアルファテストも無効に戻す)。
+	@param[in]	pBatch	バッチ
+	@return	sceGuDrawArray()の回数
+*/
+extern uint32_t Cat_SpriteBatchFlush( Cat_SpriteBatch* pBatch );
+
+//! 統計情報を取得する
+/*!
+	@param[in]	pBatch			バッチ
+	@param[out]	pStatistics		統計情報
+*/
+extern void Cat_SpriteBatchGetStatistics( Cat_SpriteBatch* pBatch, Cat_SpriteBatchStatistics* pStatistics );
+
+//! 統計情報をクリアする
+/*!
+	@param[in]	pBatch	バッチ
+*/
+extern void Cat_SpriteBatchResetStatistics( Cat_SpriteBatch* pBatch );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCL_Cat_SpriteBatch_h
@@ -0,0 +1,116 @@
+//! @file	Cat_SpriteTransform.h
+// スプライトの頂点をまとめて計算する
+
+#ifndef INCL_Cat_SpriteTransform_h
+#define INCL_Cat_SpriteTransform_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! 左右反転
+#define CAT_SPRITETRANSFORM_FLIP_X (1UL << 0)
+//! 上下反転
+#define CAT_SPRITETRANSFORM_FLIP_Y (1UL << 1)
+
+//! 1回のsceGuDrawArray()で描画するスプライト数
+#define CAT_SPRITETRANSFORM_CHUNK (1024)
+
+//! スプライト
+/*!
+	切り出した範囲を、軸を中心に拡大、反転、回転して、軸が描画位置に来るように置く。 \n
+	反転も軸を中心に行う(MUGENのFacing、VFacingと同じ)。
+*/
+typedef struct {
+	float		x;				/*!< 描画位置X(軸が来る位置、ドット単位)			*/
+	float		y;				/*!< 描画位置Y										*/
+	float		fAxisX;			/*!< 軸X(切り出した範囲の左上から、ドット単位)		*/
+	float		fAxisY;			/*!< 軸Y											*/
+	float		fScaleX;		/*!< 横の拡大率(1で等倍)							*/
+	float		fScaleY;		/*!< 縦の拡大率(1で等倍)							*/
+	float		fAngle;			/*!< 回転角度(度、画面上で反時計回り)				*/
+	uint32_t	nFlags;			/*!< CAT_SPRITETRANSFORM_FLIP_xxxの論理和			*/
+	int16_t		u;				/*!< 切り出す範囲の左上X(テクセル単位)				*/
+	int16_t		v;				/*!< 切り出す範囲の左上Y							*/
+	int16_t		nWidth;			/*!< 切り出す範囲の横幅								*/
+	int16_t		nHeight;		/*!< 切り出す範囲の高さ								*/
+} Cat_SpriteInstance;
+
+//! 頂点(GU_TEXTURE_16BIT | GU_VERTEX_16BIT | GU_TRANSFORM_2D)
+typedef struct {
+	int16_t		u, v;
+	int16_t		x, y, z;
+} __attribute__((packed)) Cat_SpriteVertex16;
+
+//! 頂点(GU_TEXTURE_32BITF | GU_VERTEX_32BITF | GU_TRANSFORM_2D)
+typedef struct {
+	float		u, v;
+	float		x, y, z;
+} Cat_SpriteVertexFloat;
+
+//! 頂点をまとめて計算する(16bit)
+/*!
+	1つのスプライトにつき、左上、右上、左下、右下(切り出した範囲での位置)の4頂点を書き出す。 \n
+	位置は最も近い整数に丸める(ちょうど半分の場合は偶数)。 \n
+	ホストではSSE2かNEONで4つの角をまとめて計算する。結果は比較用の実装と同じになる。 \n
+	PSPのVFPU版は実機で確かめるまで、libCatをUSE_CAT_SPRITETRANSFORM_VFPUを定義してビルドした場合だけ使う。 \n
+	その場合は、呼び出すスレッドにPSP_THREAD_ATTR_VFPUが必要。
+	@param[in]	pInstance	スプライト
+	@param[in]	nCount		スプライト数
+	@param[out]	pVertex		頂点(nCount * 4個)
+*/
+extern void Cat_SpriteTransform16( const Cat_SpriteInstance* pInstance, uint32_t nCount, Cat_SpriteVertex16* pVertex );
+
+//! 頂点をまとめて計算する(float)
+/*!
+	頂点の並びはCat_SpriteTransform16()と同じ。
+	@param[in]	pInstance	スプライト
+	@param[in]	nCount		スプライト数
+	@param[out]	pVertex		頂点(nCount * 4個)
+*/
+extern void Cat_SpriteTransformFloat( const Cat_SpriteInstance* pInstance, uint32_t nCount, Cat_SpriteVertexFloat* pVertex );
+
+//! 頂点を1つずつ計算する(16bit)
+/*!
+	Cat_SpriteTransform16()と同じ結果になる、比較用の実装。
+	@param[in]	pInstance	スプライト
+	@param[in]	nCount		スプライト数
+	@param[out]	pVertex		頂点(nCount * 4個)
+*/
+extern void Cat_SpriteTransform16Reference( const Cat_SpriteInstance* pInstance, uint32_t nCount, Cat_SpriteVertex16* pVertex );
+
+//! 頂点を1つずつ計算する(float)
+/*!
+	Cat_SpriteTransformFloat()と同じ結果になる、比較用の実装。
+	@param[in]	pInstance	スプライト
+	@param[in]	nCount		スプライト数
+	@param[out]	pVertex		頂点(nCount * 4個)
+*/
+extern void Cat_SpriteTransformFloatReference( const Cat_SpriteInstance* pInstance, uint32_t nCount, Cat_SpriteVertexFloat* pVertex );
+
+//! 頂点の並びに合わせたインデックスを作る
+/*!
+	スプライト1つにつき、GU_TRIANGLESの三角形2つ分(6個)のインデックスを書き出す。
+	@param[in]	nCount		スプライト数(16384以下)
+	@param[out]	pnIndex		インデックス(nCount * 6個)
+*/
+extern void Cat_SpriteTransformIndex( uint32_t nCount, uint16_t* pnIndex );
+
+//! まとめて描画する
+/*!
+	Cat_RenderBegin()とCat_RenderEnd()の間で呼ぶ。 \n
+	テクスチャとブレンドは設定しないので、先にCat_TextureSetTexturePalette()などで設定しておく。 \n
+	頂点は描画パケットに書き出し、CAT_SPRITETRANSFORM_CHUNK枚ずつGU_TRIANGLESで描画する。
+	@param[in]	pInstance	スプライト
+	@param[in]	nCount		スプライト数
+	@return	描画したスプライト数
+*/
+extern uint32_t Cat_SpriteTransformDraw( const Cat_SpriteInstance* pInstance, uint32_t nCount );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCL_Cat_SpriteTransform_h
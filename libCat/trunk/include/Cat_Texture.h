@@ -6,6 +6,8 @@
 
 #include <stdint.h>
 #include "Cat_Palette.h"
+#include "Cat_PaletteEffect.h"
+#include "Cat_Vram.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,12 +21,15 @@ typedef enum {
 	FORMAT_PIXEL_8888 = 3,		/*!< 32bit RGBA8888	*/
 	FORMAT_PIXEL_CLUT4 = 4,		/*!< 4bit Clut		*/
 	FORMAT_PIXEL_CLUT8 = 5,		/*!< 8bit Clut		*/
+	FORMAT_PIXEL_DXT1 = 8,		/*!< DXT1(4bit)		*/
+	FORMAT_PIXEL_DXT3 = 9,		/*!< DXT3(8bit)		*/
+	FORMAT_PIXEL_DXT5 = 10,		/*!< DXT5(8bit)		*/
 
 	FORMAT_PIXEL_MAX			/*!< 最大値			*/
 } FORMAT_PIXEL;
 
 //! テクスチャ構造体
-typedef struct {
+typedef struct _Cat_Texture {
 	uint32_t		nOriginalWidth;		/*!< オリジナルの横幅				*/
 	uint32_t		nOriginalHeight;	/*!< オリジナルの高さ				*/
 	uint32_t		nTextureWidth;		/*!< 変換後のテクスチャの横幅		*/
@@ -40,16 +45,168 @@ typedef struct {
 	uint32_t		nHeight2;			/*!< 縦幅2の乗数					*/
 	uint32_t		nWidth16;			/*!< 縦幅16バイト単位				*/
 	void*			pvData;				/*!< ピクセルデータ					*/
+	Cat_Arena*		pArena;				/*!< ピクセルデータを確保した領域(ヒープの場合は0)	*/
 	float			fScaleWidth;		/*!< 横スケール						*/
 	float			fScaleHeight;		/*!< 縦スケール						*/
 	Cat_Palette*	pPalette;			/*!< パレット						*/
 	int32_t			tbl4to8[16];		/*!< 変換テーブル					*/
 	Cat_Palette*	pPalette4;			/*!< 4bitパレット					*/
+	Cat_Palette*	pPalette4Source;	/*!< 4bitパレットの作成元			*/
+	uint32_t		nPalette4Serial;	/*!< 4bitパレット作成時の更新カウンタ	*/
+	struct _Cat_TexturePalette4*	pPalette4List;	/*!< 設定されたパレットから作った4bitパレット	*/
+	uint32_t		nSavedSize;			/*!< 変換で削減したサイズ(バイト単位)	*/
+	uint32_t		nTileCountX;		/*!< 横の分割数(分割していなければ0)	*/
+	uint32_t		nTileCountY;		/*!< 縦の分割数(分割していなければ0)	*/
+	struct _Cat_Texture**	ppTile;		/*!< 分割されたテクスチャ			*/
+	Cat_VramResource	vram;			/*!< VRAMへの配置					*/
+	uint32_t		nPinCount;			/*!< 固定されている数(0でなければ解放しない)	*/
 } Cat_Texture;
 
+//! 分割テクスチャのサイズ
+#define CAT_TEXTURE_TILE_SIZE (256)
+
+//! テクスチャ作成オプション
+enum {
+	CAT_TEXTURE_OPTION_CLUT4 = (1UL << 0),	/*!< 16色以下の8bitテクスチャを4bitに変換する	*/
+	CAT_TEXTURE_OPTION_TILE  = (1UL << 1),	/*!< 512を超えるテクスチャを縮小せずに分割する	*/
+	CAT_TEXTURE_OPTION_DXT   = (1UL << 2),	/*!< 32bitテクスチャをDXT1/DXT5に圧縮する		*/
+	CAT_TEXTURE_OPTION_FORMAT16 = (1UL << 3),	/*!< 32bitテクスチャを画質が保てる16bitにする	*/
+	CAT_TEXTURE_OPTION_DITHER   = (1UL << 4),	/*!< 16bitにする時にディザをかける				*/
+	CAT_TEXTURE_OPTION_QUANTIZE = (1UL << 5),	/*!< 32bitテクスチャを画質が保てれば8bitにする	*/
+
+	CAT_TEXTURE_OPTION_DEFAULT = 0,			/*!< デフォルト設定								*/
+};
+
+//! テクスチャ作成オプションを設定する
+/*!
+	以降に作成されるテクスチャに適用される。
+	@param[in]	nOption		CAT_TEXTURE_OPTION_xxxの論理和
+	@see	Cat_TextureGetOption()
+*/
+extern void Cat_TextureSetOption( uint32_t nOption );
+
+//! テクスチャ作成オプションを取得する
+/*!
+	@return	CAT_TEXTURE_OPTION_xxxの論理和
+	@see	Cat_TextureSetOption()
+*/
+extern uint32_t Cat_TextureGetOption( void );
+
+//! 変換の画質のデフォルト値(PSNR、dB単位)
+#define CAT_TEXTURE_QUALITY_DEFAULT (36)
+
+//! 変換の画質の下限を設定する
+/*!
+	CAT_TEXTURE_OPTION_FORMAT16とCAT_TEXTURE_OPTION_QUANTIZEで、 \n
+	元のイメージとの誤差がこれより大きくなる場合は変換しない。
+	@param[in]	nPSNR	PSNR(dB単位)。0の場合は常に変換する。
+	@see	Cat_TextureGetQuality()
+*/
+extern void Cat_TextureSetQuality( uint32_t nPSNR );
+
+//! 変換の画質の下限を取得する
+/*!
+	@return	PSNR(dB単位)
+	@see	Cat_TextureSetQuality()
+*/
+extern uint32_t Cat_TextureGetQuality( void );
+
+//! 16bit変換の統計情報
+typedef struct {
+	uint32_t	nAnalyzeCount;		/*!< 調べた32bitイメージ数						*/
+	uint32_t	n5650Count;			/*!< RGBA5650にしたイメージ数(アルファなし)		*/
+	uint32_t	n5551Count;			/*!< RGBA5551にしたイメージ数(1bitアルファ)		*/
+	uint32_t	n4444Count;			/*!< RGBA4444にしたイメージ数(階調アルファ)		*/
+	uint32_t	nRejectCount;		/*!< 画質が足りずに32bitのままにしたイメージ数	*/
+	uint32_t	nSavedSize;			/*!< 削減したサイズ(バイト単位)					*/
+	uint32_t	nTime;				/*!< かかった時間(マイクロ秒単位)				*/
+} Cat_TextureFormat16Statistics;
+
+//! 16bit変換の統計情報を取得する
+/*!
+	@param[out]	pStatistics		統計情報
+*/
+extern void Cat_TextureGetFormat16Statistics( Cat_TextureFormat16Statistics* pStatistics );
+
+//! 16bit変換の統計情報をクリアする
+extern void Cat_TextureResetFormat16Statistics( void );
+
+//! 8bit変換の統計情報
+typedef struct {
+	uint32_t	nAnalyzeCount;		/*!< 調べた32bitイメージ数(半透明があるものは除く)	*/
+	uint32_t	nConvertCount;		/*!< 8bitにしたイメージ数							*/
+	uint32_t	nExactCount;		/*!< そのうち、元の色がすべてパレットに入ったもの	*/
+	uint32_t	nRejectCount;		/*!< 画質が足りずに32bitのままにしたイメージ数		*/
+	uint32_t	nPixelCount;		/*!< 調べたピクセル数								*/
+	uint32_t	nSavedSize;			/*!< 削減したサイズ(バイト単位)						*/
+	uint32_t	nTime;				/*!< かかった時間(マイクロ秒単位)					*/
+} Cat_TextureQuantizeStatistics;
+
+//! 8bit変換の統計情報を取得する
+/*!
+	処理速度は nPixelCount / nTime でメガピクセル毎秒になる。
+	@param[out]	pStatistics		統計情報
+*/
+extern void Cat_TextureGetQuantizeStatistics( Cat_TextureQuantizeStatistics* pStatistics );
+
+//! 8bit変換の統計情報をクリアする
+extern void Cat_TextureResetQuantizeStatistics( void );
+
+//! テクスチャを置くVRAMの領域管理を設定する
+/*!
+	設定されている場合、Cat_TextureSetTexture()で使用回数を数えて、 \n
+	VRAMに置かれているテクスチャはVRAMから読ませる。 \n
+	通常は、Cat_RenderInit()でCAT_RENDER_PARAM_VRAM_TEXTUREを指定すると設定される。
+	@param[in]	pVram	領域管理(0の場合はVRAMを使わない)
+*/
+extern void Cat_TextureSetVram( Cat_Vram* pVram );
+
+//! 描画に使ったテクスチャを知らせる関数
+/*!
+	@param[in]	pvContext	Cat_TextureSetRecordFunc()に渡した値
+	@param[in]	pTexture	設定したテクスチャ(分割されたテクスチャは、分割テクスチャ)
+*/
+typedef void (*Cat_TextureRecordFunc)( void* pvContext, Cat_Texture* pTexture );
+
+//! リストに記録している間に、描画に使ったテクスチャを知らせる関数を設定する
+/*!
+	設定されている間は、テクスチャを設定するたびに \a pfnRecord が呼ばれる。 \n
+	VRAMの配置は後で変わるので、VRAMに置かれているテクスチャもメインメモリのアドレスを積む。 \n
+	Cat_DisplayListが記録する間に使う。
+	@param[in]	pfnRecord	知らせる関数(0の場合は元に戻す)
+	@param[in]	pvContext	\a pfnRecord に渡す値
+*/
+extern void Cat_TextureSetRecordFunc( Cat_TextureRecordFunc pfnRecord, void* pvContext );
+
+//! ピクセルデータを確保する領域を設定する
+/*!
+	設定されている間に作成されたテクスチャは、変換が終わったピクセルデータを \n
+	\a pArena へ移して参照を持つ。パレットも同じ領域から確保される。 \n
+	一緒に読み込んで一緒に捨てるイメージ(キャラクターのSFFなど)を読み込む間だけ設定する。
+	@param[in]	pArena	領域(0の場合はヒープから確保する)
+	@see	Cat_TextureGetArena()
+*/
+extern void Cat_TextureSetArena( Cat_Arena* pArena );
+
+//! ピクセルデータを確保する領域を取得する
+/*!
+	@return	領域
+	@see	Cat_TextureSetArena()
+*/
+extern Cat_Arena* Cat_TextureGetArena( void );
+
+//! テクスチャ構造体の割り当ての統計情報を取得する
+/*!
+	分割テクスチャも1つずつ数える。
+	@param[out]	pStatistics		統計情報
+*/
+extern void Cat_TextureGetSlabStatistics( Cat_SlabStatistics* pStatistics );
+
 //! テクスチャ作成
 /*!
 	\a pvImage は、mallocで確保したメモリを渡すこと。 \n
+	DXT圧縮済みのデータを渡す場合、 \a nPitch はブロック1列(4ライン)のバイト数の1/4を指定する。 \n
+	DXT圧縮済みのデータは、512を超える大きさにはできない。
 
 	@param[in]	nWidth			テクスチャの横幅(ピクセル単位)
 	@param[in]	nHeight			テクスチャの高さ(ピクセル単位)
@@ -69,6 +226,25 @@ extern Cat_Texture* Cat_TextureCreate( uint32_t nWidth, uint32_t nHeight, uint32
 */
 extern void Cat_TextureAddRef( Cat_Texture* pTexture );
 
+//! テクスチャが分割されているかどうか
+/*!
+	分割されたテクスチャは、Cat_TextureSetTexture()では左上の分割テクスチャしか設定されないので、 \n
+	Cat_TextureDraw()で描画すること。
+	@param[in]	pTexture	テクスチャ
+	@return	分割されていれば0以外を返す
+*/
+extern int32_t Cat_TextureIsTiled( Cat_Texture* pTexture );
+
+//! 分割テクスチャを取得する
+/*!
+	パレットは元のテクスチャに合わせてから返す。
+	@param[in]	pTexture	分割されたテクスチャ
+	@param[in]	tx			横の番号
+	@param[in]	ty			縦の番号
+	@return	分割テクスチャ。分割されていない場合と、範囲外の場合は0が返る。
+*/
+extern Cat_Texture* Cat_TextureGetTile( Cat_Texture* pTexture, uint32_t tx, uint32_t ty );
+
 //! テクスチャ解放
 /*!
 	@param[in]	pTexture	解放するテクスチャ
@@ -76,13 +252,131 @@ extern void Cat_TextureAddRef( Cat_Texture* pTexture );
 */
 extern void Cat_TextureRelease( Cat_Texture* pTexture );
 
+//! テクスチャを固定する
+/*!
+	記録したリストのように、後の描画でもピクセルデータのアドレスを参照するものが使う。 \n
+	固定されている間は、参照を持ち、Cat_TextureUnload()でピクセルデータを解放しない。
+	@param[in]	pTexture	テクスチャ
+	@see	Cat_TextureUnpin()
+*/
+extern void Cat_TexturePin( Cat_Texture* pTexture );
+
+//! テクスチャの固定を外す
+/*!
+	@param[in]	pTexture	Cat_TexturePin()したテクスチャ
+*/
+extern void Cat_TextureUnpin( Cat_Texture* pTexture );
+
+//! テクスチャが固定されているかどうか
+/*!
+	@param[in]	pTexture	テクスチャ
+	@return	固定されていれば0以外を返す
+*/
+extern int32_t Cat_TextureIsPinned( Cat_Texture* pTexture );
+
+//! ピクセルデータを解放する
+/*!
+	大きさやパレットは残るので、Cat_TextureReload()で元に戻せる。 \n
+	解放されている間は、Cat_TextureSetTexture()でテクスチャが無効になる。 \n
+	描画中のパケットが参照しているテクスチャは解放しないこと。 \n
+	Cat_TexturePin()で固定されている場合は、何もせずに0を返す。
+	@param[in]	pTexture	テクスチャ
+	@return	解放したサイズ(バイト単位)
+	@see	Cat_TextureReload()
+*/
+extern uint32_t Cat_TextureUnload( Cat_Texture* pTexture );
+
+//! ピクセルデータがあるかどうか
+/*!
+	@param[in]	pTexture	テクスチャ
+	@return	ピクセルデータがあれば0以外を返す
+*/
+extern int32_t Cat_TextureIsLoaded( Cat_Texture* pTexture );
+
+//! ピクセルデータを入れ直す
+/*!
+	\a pSource のピクセルデータを \a pTexture へ移す。パレットは \a pTexture のものを残す。 \n
+	\a pTexture がパレットを持っていない場合は、 \a pSource のパレット(減色で作られたものなど)を移す。 \n
+	\a pSource は、ピクセルデータを持たないテクスチャになる。 \n
+	\a pTexture がCat_TexturePin()で固定されている場合は失敗する。
+	@param[in,out]	pTexture	入れ直すテクスチャ
+	@param[in,out]	pSource		同じイメージから作り直したテクスチャ
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+	@see	Cat_TextureUnload()
+*/
+extern int32_t Cat_TextureReload( Cat_Texture* pTexture, Cat_Texture* pSource );
+
 //! テクスチャ設定
 /*!
-	パレットがある場合は、パレットも設定される。
+	パレットがある場合は、パレットも設定される。 \n
+	分割されたテクスチャは、左上の分割テクスチャが設定される。 \n
+	テクスチャ座標はその分割テクスチャの中になるので、全体を描く場合はCat_TextureDraw()を使うこと。
 	@param[in]	pTexture	設定するテクスチャ
+	@see	Cat_TextureIsTiled()
 */
 extern void Cat_TextureSetTexture( Cat_Texture* pTexture );
 
+//! テクスチャと別のパレットを設定する
+/*!
+	\a pPalette は変換前のピクセルの番号で引くパレットを渡す。 \n
+	4bitに変換されたテクスチャは、\a pPalette から16色のパレットを作って設定する。 \n
+	作ったパレットはパレットごとに持っておき、\a pPalette の更新カウンタが変わった時だけ作り直す。
+	@param[in]	pTexture	設定するテクスチャ
+	@param[in]	pPalette	設定するパレット(0の場合はテクスチャのパレット)
+	@see	Cat_TextureGetDrawPalette()
+*/
+extern void Cat_TextureSetTexturePalette( Cat_Texture* pTexture, Cat_Palette* pPalette );
+
+//! 描画の時に設定されるパレットを取得する
+/*!
+	4bitに変換されたテクスチャは、元のパレットから再構成した16色のパレットが返る。
+	@param[in]	pTexture	テクスチャ
+	@return	パレット。パレットを持たないテクスチャは0が返る。
+*/
+extern Cat_Palette* Cat_TextureGetDrawPalette( Cat_Texture* pTexture );
+
+//! 設定されたパレットから作った4bitパレットを作り直す
+/*!
+	Cat_TextureSetTexturePalette()で設定したことのあるパレットを更新した時に、 \n
+	積み直さずに使う描画パケット(Cat_DisplayListなど)へ色を反映するために呼ぶ。 \n
+	作ったパレットが無い場合と、更新カウンタが変わっていない場合は何もしない。 \n
+	作ったパレットは同じアドレスで書き換えるので、GEが読んでいない間に呼ぶこと。
+	@param[in]	pTexture	テクスチャ(分割されたテクスチャは、分割テクスチャ)
+	@param[in]	pPalette	更新したパレット
+*/
+extern void Cat_TextureRefreshPalette( Cat_Texture* pTexture, Cat_Palette* pPalette );
+
+//! テクスチャを描画する
+/*!
+	テクスチャを設定して、スプライトとして描画する。 \n
+	分割されたテクスチャは、画面に入る分割テクスチャだけを描画する。
+	@param[in]	pTexture	描画するテクスチャ
+	@param[in]	x			描画位置X(ドット単位)
+	@param[in]	y			描画位置Y(ドット単位)
+	@param[in]	w			描画する横幅(ドット単位)
+	@param[in]	h			描画する高さ(ドット単位)
+	@return	描画したスプライト数
+*/
+extern uint32_t Cat_TextureDraw( Cat_Texture* pTexture, float x, float y, float w, float h );
+
+//! パレットにエフェクトをかけてテクスチャを描画する
+/*!
+	ピクセルデータはそのままで、キャッシュから取得したパレットを設定して描画する。 \n
+	影や残像のために、色を変えたテクスチャを作る必要が無い。 \n
+	パレットを持たないテクスチャは、そのまま描画される。
+	@param[in]	pTexture	描画するテクスチャ
+	@param[in]	pCache		エフェクトをかけたパレットのキャッシュ
+	@param[in]	pParam		パレットエフェクトのパラメータ
+	@param[in]	x			描画位置X(ドット単位)
+	@param[in]	y			描画位置Y(ドット単位)
+	@param[in]	w			描画する横幅(ドット単位)
+	@param[in]	h			描画する高さ(ドット単位)
+	@return	描画したスプライト数
+	@see	Cat_PaletteEffectCacheGet()
+*/
+extern uint32_t Cat_TextureDrawEffect( Cat_Texture* pTexture, Cat_PaletteEffectCache* pCache, const Cat_PaletteEffectParam* pParam, float x, float y, float w, float h );
+
 //! 横幅を取得
 /*!
 	@param[in]	pTexture	テクスチャ
@@ -104,6 +398,13 @@ extern uint32_t Cat_TextureGetHeight( Cat_Texture* pTexture );
 */
 extern uint32_t Cat_TextureGetPitch( Cat_Texture* pTexture );
 
+//! ピクセルデータのサイズを取得する
+/*!
+	@param[in]	pTexture	テクスチャ
+	@return	ピクセルデータのサイズ(バイト単位)
+*/
+extern uint32_t Cat_TextureGetDataSize( Cat_Texture* pTexture );
+
 //! テクスチャからテクセルを取得する
 /*!
 	@param[in]	pTexture	テクスチャ
@@ -122,6 +423,39 @@ extern uint32_t Cat_TextureGetPixel( Cat_Texture* pTexture, uint32_t x, uint32_t
 */
 extern uint32_t Cat_TextureGetPixelRaw( Cat_Texture* pTexture, uint32_t x, uint32_t y );
 
+//! 領域取得の出力形式
+typedef enum {
+	CAT_TEXTURE_REGION_8888 = 0,	/*!< RGBA8888に変換する(1ピクセル4バイト)						*/
+	CAT_TEXTURE_REGION_RAW  = 1,	/*!< 変換しない(32bitは4バイト、16bitは2バイト、Clutは1バイト)	*/
+} CAT_TEXTURE_REGION;
+
+//! 領域取得の1ピクセルのバイト数を取得する
+/*!
+	@param[in]	pTexture	テクスチャ
+	@param[in]	eMode		出力形式
+	@return	1ピクセルのバイト数
+*/
+extern uint32_t Cat_TextureGetRegionPixelSize( Cat_Texture* pTexture, CAT_TEXTURE_REGION eMode );
+
+//! テクスチャの矩形領域を取得する
+/*!
+	Cat_TextureGetPixel()を1ピクセルずつ呼ぶ代わりに使う。 \n
+	入れ替え済みのテクスチャは16バイト×8ラインのブロック単位で読み出す。 \n
+	Clutのテクスチャを RAW で取得した場合は、8bitのパレット番号になる。
+	@param[in]	pTexture	テクスチャ
+	@param[in]	x			取得する領域の左端
+	@param[in]	y			取得する領域の上端
+	@param[in]	w			取得する領域の横幅
+	@param[in]	h			取得する領域の高さ
+	@param[out]	pvDest		出力先
+	@param[in]	nDestPitch	出力先の1ラインのバイト数
+	@param[in]	eMode		出力形式
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+	@see	Cat_TextureGetRegionPixelSize()
+*/
+extern int32_t Cat_TextureGetRegion( Cat_Texture* pTexture, uint32_t x, uint32_t y, uint32_t w, uint32_t h, void* pvDest, uint32_t nDestPitch, CAT_TEXTURE_REGION eMode );
+
 //! RGBA4444からRGBA8888へ変換する
 extern uint32_t Cat_ColorConvert4444To8888( uint16_t rgba4444 );
 
@@ -0,0 +1,88 @@
+//! @file	Cat_TextureDXT.h
+// DXT圧縮テクスチャ関連
+
+#ifndef INCL_Cat_TextureDXT_h
+#define INCL_Cat_TextureDXT_h
+
+#include <stdint.h>
+#include "Cat_Texture.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! DXT圧縮の統計情報
+typedef struct {
+	uint32_t	nEncodeCount;		/*!< 圧縮したイメージ数					*/
+	uint32_t	nDXT1Count;			/*!< DXT1で圧縮したイメージ数			*/
+	uint32_t	nDXT3Count;			/*!< DXT3で圧縮したイメージ数			*/
+	uint32_t	nDXT5Count;			/*!< DXT5で圧縮したイメージ数			*/
+	uint32_t	nPixelCount;		/*!< 圧縮したピクセル数					*/
+	uint32_t	nSourceSize;		/*!< 圧縮前のサイズ(バイト単位)			*/
+	uint32_t	nEncodedSize;		/*!< 圧縮後のサイズ(バイト単位)			*/
+	uint32_t	nEncodeTime;		/*!< 圧縮にかかった時間(マイクロ秒単位)	*/
+} Cat_TextureDXTStatistics;
+
+//! DXT圧縮されたフォーマットかどうか
+/*!
+	@param[in]	ePixelFormat	ピクセルフォーマット
+	@return	DXT1/DXT3/DXT5の場合は0以外を返す
+*/
+extern int32_t Cat_TextureDXTIsFormat( FORMAT_PIXEL ePixelFormat );
+
+//! 1ブロック(4x4ピクセル)のバイト数を取得する
+/*!
+	@param[in]	ePixelFormat	ピクセルフォーマット(FORMAT_PIXEL_DXTx)
+	@return	1ブロックのバイト数。DXTでない場合は0を返す
+*/
+extern uint32_t Cat_TextureDXTGetBlockSize( FORMAT_PIXEL ePixelFormat );
+
+//! イメージに合ったDXTのフォーマットを選ぶ
+/*!
+	アルファが0と255だけならDXT1、それ以外はDXT5を選ぶ。
+	@param[in]	pvImage		RGBA8888のイメージ
+	@param[in]	nWidth		横幅(ピクセル単位)
+	@param[in]	nHeight		高さ(ピクセル単位)
+	@param[in]	nPitch		1ラインのバイト数
+	@return	FORMAT_PIXEL_DXT1 または FORMAT_PIXEL_DXT5
+*/
+extern FORMAT_PIXEL Cat_TextureDXTSelectFormat( const void* pvImage, uint32_t nWidth, uint32_t nHeight, uint32_t nPitch );
+
+//! RGBA8888のイメージをDXT圧縮する
+/*!
+	ブロックの並びはPSPのGEの形式(色のブロックが先、アルファが後)。 \n
+	イメージの外側にはみ出したピクセルは、透明な黒として扱う。
+	@param[in]	pvImage			RGBA8888のイメージ
+	@param[in]	nWidth			横幅(ピクセル単位)
+	@param[in]	nHeight			高さ(ピクセル単位)
+	@param[in]	nPitch			1ラインのバイト数
+	@param[out]	pvDest			出力先
+	@param[in]	nDestPitch		出力先のピッチ(ブロック1列のバイト数の1/4。Cat_TextureのnPitchと同じ)
+	@param[in]	ePixelFormat	圧縮するフォーマット(FORMAT_PIXEL_DXTx)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+extern int32_t Cat_TextureDXTEncode( const void* pvImage, uint32_t nWidth, uint32_t nHeight, uint32_t nPitch, void* pvDest, uint32_t nDestPitch, FORMAT_PIXEL ePixelFormat );
+
+//! 1ブロックを展開する
+/*!
+	@param[in]	pvBlock			ブロック
+	@param[in]	ePixelFormat	フォーマット(FORMAT_PIXEL_DXTx)
+	@param[out]	pnDest			RGBA8888で16ピクセル(左上から横方向の順)
+*/
+extern void Cat_TextureDXTDecodeBlock( const void* pvBlock, FORMAT_PIXEL ePixelFormat, uint32_t* pnDest );
+
+//! 統計情報を取得する
+/*!
+	@param[out]	pStatistics		統計情報
+*/
+extern void Cat_TextureDXTGetStatistics( Cat_TextureDXTStatistics* pStatistics );
+
+//! 統計情報をクリアする
+extern void Cat_TextureDXTResetStatistics( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCL_Cat_TextureDXT_h
@@ -0,0 +1,214 @@
+//! @file	Cat_Vram.h
+// VRAMの領域管理
+
+#ifndef INCL_Cat_Vram_h
+#define INCL_Cat_Vram_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! VRAMに置くデータのアライメント(バイト単位)
+#define CAT_VRAM_ALIGN (16)
+
+//! 解放待ちの領域を保持できる数
+/*!
+	追い出しは作成途中のパケットの間にも起きるので、描画の終わりを待って解放することはできない。 \n
+	常駐数と解放待ちの数の合計がこれを超えないように置くので、常駐できるリソース数の上限にもなる。
+*/
+#define CAT_VRAM_PENDING_MAX (128)
+
+//! VRAMの領域管理
+typedef struct _Cat_Vram Cat_Vram;
+
+//! VRAMの確保済み領域
+/*!
+	アドレス順に並べて管理する。 \n
+	確保元が0の領域は、解放済みでGEの描画が終わるのを待っている領域。
+*/
+typedef struct _Cat_VramBlock {
+	struct _Cat_VramBlock*		pNext;		/*!< 次の領域(アドレス順)				*/
+	struct _Cat_VramResource*	pResource;	/*!< 確保元(解放待ちの場合は0)			*/
+	uint32_t					nOffset;	/*!< 先頭からのオフセット(バイト単位)	*/
+	uint32_t					nSize;		/*!< サイズ(バイト単位)					*/
+} Cat_VramBlock;
+
+//! VRAMに置くリソース
+/*!
+	テクスチャなどに埋め込んで使う。 \n
+	Cat_VramTouch()で使われた回数を数えて、よく使われるものからVRAMに置かれる。
+*/
+typedef struct _Cat_VramResource {
+	Cat_Vram*					pVram;		/*!< 登録先(登録されていなければ0)		*/
+	struct _Cat_VramResource*	pPrev;		/*!< 前のリソース						*/
+	struct _Cat_VramResource*	pNext;		/*!< 次のリソース						*/
+	const void*					pvSource;	/*!< メインメモリのデータ				*/
+	uint32_t					nSize;		/*!< サイズ(バイト単位)					*/
+	uint32_t					nUseCount;	/*!< 前回の更新からの使用回数			*/
+	uint32_t					nScore;		/*!< 使用頻度							*/
+	uint32_t					fResident;	/*!< VRAMに置かれているかどうか			*/
+	uint32_t					nEvictUpdate;	/*!< 最後に追い出された更新の番号	*/
+	Cat_VramBlock				block;		/*!< VRAMの領域(常駐している時だけ有効)	*/
+} Cat_VramResource;
+
+//! VRAMの操作
+/*!
+	実機のVRAMと、ホストでの確認用の擬似VRAMを切り替えるためのもの。
+*/
+typedef struct {
+	//! メインメモリからVRAMへ転送する
+	/*!
+		@param[in]	pvContext	コンテキスト
+		@param[in]	nOffset		転送先のオフセット(バイト単位)
+		@param[in]	pvSource	転送元
+		@param[in]	nSize		転送するサイズ(バイト単位)
+	*/
+	void (*Upload)( void* pvContext, uint32_t nOffset, const void* pvSource, uint32_t nSize );
+
+	//! VRAM内で移動する
+	/*!
+		移動先は、常に移動元より前(アドレスが小さい方)になる。
+		@param[in]	pvContext	コンテキスト
+		@param[in]	nDest		移動先のオフセット(バイト単位)
+		@param[in]	nSrc		移動元のオフセット(バイト単位)
+		@param[in]	nSize		移動するサイズ(バイト単位)
+	*/
+	void (*Move)( void* pvContext, uint32_t nDest, uint32_t nSrc, uint32_t nSize );
+
+	//! オフセットをGEに渡すアドレスにする
+	void* (*GetAddress)( void* pvContext, uint32_t nOffset );
+
+	//! GEの描画が終わるのを待つ
+	void (*Sync)( void* pvContext );
+
+	//! 閉じる(0でもよい)
+	void (*Close)( void* pvContext );
+
+	void* pvContext;	/*!< コンテキスト */
+} Cat_VramBackend;
+
+//! 統計情報
+typedef struct {
+	uint32_t	nSize;				/*!< 管理しているサイズ(バイト単位)				*/
+	uint32_t	nBudget;			/*!< 常駐させる上限(バイト単位)					*/
+	uint32_t	nResidentBytes;		/*!< 常駐しているサイズ(バイト単位)				*/
+	uint32_t	nResidentCount;		/*!< 常駐しているリソース数						*/
+	uint32_t	nPendingBytes;		/*!< 解放待ちのサイズ(バイト単位)				*/
+	uint32_t	nFreeBytes;			/*!< 空いているサイズ(バイト単位)				*/
+	uint32_t	nLargestFree;		/*!< 一番大きな空き領域(バイト単位)				*/
+	uint32_t	nRegisteredCount;	/*!< 登録されているリソース数					*/
+	uint32_t	nUpdateCount;		/*!< Cat_VramUpdate()の呼び出し回数				*/
+	uint32_t	nTouchCount;		/*!< Cat_VramTouch()の呼び出し回数				*/
+	uint32_t	nHitCount;			/*!< Cat_VramTouch()で常駐していた回数			*/
+	uint32_t	nPromoteCount;		/*!< VRAMに置いた回数							*/
+	uint32_t	nEvictCount;		/*!< VRAMから追い出した回数						*/
+	uint32_t	nUploadBytes;		/*!< VRAMへ転送したサイズ(バイト単位)			*/
+	uint32_t	nFragmentCount;		/*!< 空きはあるのに断片化で置けなかった回数		*/
+	uint32_t	nDefragmentCount;	/*!< Cat_VramDefragment()の呼び出し回数			*/
+	uint32_t	nDefragmentBytes;	/*!< 断片化解消で移動したサイズ(バイト単位)		*/
+} Cat_VramStatistics;
+
+//! VRAMの領域管理を作成する
+/*!
+	@param[in]	nSize		管理するサイズ(バイト単位)
+	@param[in]	pBackend	VRAMの操作(複製して保持する)
+	@return	作成された領域管理。失敗した場合は0が返る。
+	@see	Cat_VramDestroy()
+*/
+extern Cat_Vram* Cat_VramCreate( uint32_t nSize, const Cat_VramBackend* pBackend );
+
+//! メインメモリを擬似VRAMにした領域管理を作成する
+/*!
+	PSPに依存しないので、ホストで配置の方針や統計情報を確認するのに使う。
+	@param[in]	nSize		管理するサイズ(バイト単位)
+	@return	作成された領域管理。失敗した場合は0が返る。
+	@see	Cat_VramDestroy()
+*/
+extern Cat_Vram* Cat_VramCreateSimulator( uint32_t nSize );
+
+//! VRAMの領域管理を破棄する
+/*!
+	登録されているリソースは、すべて登録が解除される。
+	@param[in]	pVram	領域管理
+*/
+extern void Cat_VramDestroy( Cat_Vram* pVram );
+
+//! 常駐させる上限を設定する
+/*!
+	@param[in]	pVram		領域管理
+	@param[in]	nBudget		上限(バイト単位)。管理しているサイズを超える場合は、管理しているサイズになる。
+*/
+extern void Cat_VramSetBudget( Cat_Vram* pVram, uint32_t nBudget );
+
+//! 1回の更新で転送する上限を設定する
+/*!
+	@param[in]	pVram		領域管理
+	@param[in]	nLimit		上限(バイト単位)。0の場合は制限しない。
+*/
+extern void Cat_VramSetUploadLimit( Cat_Vram* pVram, uint32_t nLimit );
+
+//! リソースを初期化する
+/*!
+	データを差し替える場合は、Cat_VramResourceRemove()してから呼ぶこと。
+	@param[out]	pResource	リソース
+	@param[in]	pvSource	メインメモリのデータ
+	@param[in]	nSize		サイズ(バイト単位)
+*/
+extern void Cat_VramResourceInit( Cat_VramResource* pResource, const void* pvSource, uint32_t nSize );
+
+//! リソースの登録を解除する
+/*!
+	VRAMに置かれていた領域は、次のCat_VramUpdate()まで解放されない。
+	@param[in]	pResource	リソース
+*/
+extern void Cat_VramResourceRemove( Cat_VramResource* pResource );
+
+//! リソースを使う
+/*!
+	使用回数を数える。登録されていなければ登録する。
+	@param[in]	pVram		領域管理
+	@param[in]	pResource	リソース
+	@return	VRAMに置かれている場合は、GEに渡すアドレス。置かれていない場合は0が返る。
+*/
+extern void* Cat_VramTouch( Cat_Vram* pVram, Cat_VramResource* pResource );
+
+//! 配置を更新する
+/*!
+	1フレームに1回、描画パケットをGEに渡した後に呼ぶ。 \n
+	前回追い出した領域を解放してから、使用頻度の高いリソースを上限までVRAMに置く。 \n
+	空きが足りない場合は、使用頻度の低いリソースを追い出す。 \n
+	追い出した領域は、描画中のパケットが参照しているかもしれないので次回まで解放しない。 \n
+	常駐数と解放待ちの数の合計がCAT_VRAM_PENDING_MAXに達している場合は、次回まで置かない。
+	@param[in]	pVram	領域管理
+*/
+extern void Cat_VramUpdate( Cat_Vram* pVram );
+
+//! 断片化を解消する
+/*!
+	GEの描画が終わるのを待ってから、常駐しているリソースを前に詰める。 \n
+	作成途中の描画パケットがあると、移動前のアドレスを参照してしまうので \n
+	ラウンドの切り替えなど、Cat_RenderScreenUpdate()の後で次のCat_RenderBegin()の前に呼ぶこと。
+	@param[in]	pVram	領域管理
+*/
+extern void Cat_VramDefragment( Cat_Vram* pVram );
+
+//! 統計情報を取得する
+/*!
+	@param[in]	pVram			領域管理
+	@param[out]	pStatistics		統計情報
+*/
+extern void Cat_VramGetStatistics( Cat_Vram* pVram, Cat_VramStatistics* pStatistics );
+
+//! 統計情報の回数をクリアする
+/*!
+	@param[in]	pVram	領域管理
+*/
+extern void Cat_VramResetStatistics( Cat_Vram* pVram );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCL_Cat_Vram_h
@@ -0,0 +1,239 @@
+//! @file	Cat_Arena.c
+// まとめて解放するメモリ領域
+//
+// 切り出すだけで個別の管理情報を持たないので、1回の確保はポインタを進めるだけで済む。
+// 解放はブロックごとの使用数を減らすだけで、0になったブロックを丸ごと返す。
+
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>	// for memalign
+#include "Cat_Arena.h"
+
+#ifndef CAT_MALLOC
+//! メモリ確保マクロ
+#define CAT_MALLOC(x) memalign( 32, (x) )
+#endif // CAT_MALLOC
+
+#ifndef CAT_FREE
+//! メモリ解放マクロ
+#define CAT_FREE(x) free( x )
+#endif // CAT_FREE
+
+//! 確保するメモリのアライメント(バイト単位)
+#define CAT_ARENA_ALIGN (32)
+
+//! ブロック
+/*!
+	ブロックの先頭に置かれ、CAT_ARENA_ALIGNに揃えた後ろから切り出す。
+*/
+typedef struct _Block {
+	struct _Block*	pNext;			/*!< 次のブロック					*/
+	uint32_t		nSize;			/*!< 切り出せるサイズ				*/
+	uint32_t		nOffset;		/*!< 次に切り出す位置				*/
+	uint32_t		nLive;			/*!< 解放されていない確保の数		*/
+} Block;
+
+//! ブロックの管理情報のサイズ
+#define CAT_ARENA_HEADER_SIZE ((sizeof(Block) + CAT_ARENA_ALIGN - 1) & ~(CAT_ARENA_ALIGN - 1))
+
+//! まとめて解放するメモリ領域
+struct _Cat_Arena {
+	uint32_t			nBlockSize;		/*!< ブロックのサイズ				*/
+	uint32_t			nRef;			/*!< 参照カウンタ					*/
+	Block*				pBlock;			/*!< ブロック(先頭が切り出し中)		*/
+	Cat_ArenaStatistics	statistics;		/*!< 統計情報						*/
+};
+
+//! ブロックを作る
+/*!
+	@param[in,out]	pArena	領域
+	@param[in]		nSize	切り出せるサイズ
+	@return	作ったブロック。失敗した場合は0が返る。
+*/
+static Block*
+CreateBlock( Cat_Arena* pArena, uint32_t nSize )
+{
+	Block* rc = (Block*)CAT_MALLOC( CAT_ARENA_HEADER_SIZE + nSize );
+	if(rc == 0) {
+		return 0;
+	}
+	rc->pNext   = 0;
+	rc->nSize   = nSize;
+	rc->nOffset = 0;
+	rc->nLive   = 0;
+	pArena->statistics.nHeapAllocCount++;
+	pArena->statistics.nBlockCount++;
+	pArena->statistics.nReservedSize += nSize;
+	return rc;
+}
+
+//! 作成する
+/*!
+	@param[in]	nBlockSize	ブロックのサイズ(バイト単位)。 \n
+							1/4を超える確保は、専用のブロックになる。
+	@return	作成された領域。失敗した場合は0が返る。
+	@see	Cat_ArenaRelease()
+*/
+Cat_Arena*
+Cat_ArenaCreate( uint32_t nBlockSize )
+{
+	Cat_Arena* rc;
+
+	if(nBlockSize < CAT_ARENA_ALIGN * 4) {
+		return 0;
+	}
+	rc = (Cat_Arena*)CAT_MALLOC( sizeof(Cat_Arena) );
+	if(rc == 0) {
+		return 0;
+	}
+	memset( rc, 0, sizeof(Cat_Arena) );
+	rc->nBlockSize = (nBlockSize + CAT_ARENA_ALIGN - 1) & ~(CAT_ARENA_ALIGN - 1);
+	rc->nRef       = 1;
+	return rc;
+}
+
+//! 参照カウンタを加算する
+/*!
+	@param[in]	pArena	領域
+*/
+void
+Cat_ArenaAddRef( Cat_Arena* pArena )
+{
+	if(pArena == 0) {
+		return;
+	}
+	pArena->nRef++;
+}
+
+//! 解放する
+/*!
+	参照カウンタを減算して、0になったらすべてのブロックを解放する。
+	@param[in]	pArena	領域
+*/
+void
+Cat_ArenaRelease( Cat_Arena* pArena )
+{
+	Block* pBlock;
+
+	if(pArena == 0) {
+		return;
+	}
+	if(--pArena->nRef > 0) {
+		return;
+	}
+	pBlock = pArena->pBlock;
+	while(pBlock) {
+		Block* pNext = pBlock->pNext;
+		CAT_FREE( pBlock );
+		pBlock = pNext;
+	}
+	CAT_FREE( pArena );
+}
+
+//! メモリを確保する
+/*!
+	32バイト境界のメモリを返す。中身は初期化されない。
+	@param[in]	pArena	領域
+	@param[in]	nSize	サイズ(バイト単位)
+	@return	確保したメモリ。失敗した場合は0が返る。
+*/
+void*
+Cat_ArenaAlloc( Cat_Arena* pArena, uint32_t nSize )
+{
+	Block* pBlock;
+	void* rc;
+
+	if((pArena == 0) || (nSize == 0)) {
+		return 0;
+	}
+	nSize = (nSize + CAT_ARENA_ALIGN - 1) & ~(CAT_ARENA_ALIGN - 1);
+
+	if(nSize > pArena->nBlockSize / 4) {
+		// 大きいものは専用のブロックにして、切り出し中のブロックの後ろにつなぐ
+		pBlock = CreateBlock( pArena, nSize );
+		if(pBlock == 0) {
+			return 0;
+		}
+		if(pArena->pBlock) {
+			pBlock->pNext = pArena->pBlock->pNext;
+			pArena->pBlock->pNext = pBlock;
+		} else {
+			pArena->pBlock = pBlock;
+		}
+	} else {
+		pBlock = pArena->pBlock;
+		if((pBlock == 0) || (pBlock->nOffset + nSize > pBlock->nSize)) {
+			// 足りないので、新しいブロックから切り出す
+			pBlock = CreateBlock( pArena, pArena->nBlockSize );
+			if(pBlock == 0) {
+				return 0;
+			}
+			pBlock->pNext  = pArena->pBlock;
+			pArena->pBlock = pBlock;
+		}
+	}
+	rc = (uint8_t*)pBlock + CAT_ARENA_HEADER_SIZE + pBlock->nOffset;
+	pBlock->nOffset += nSize;
+	pBlock->nLive++;
+	pArena->statistics.nAllocCount++;
+	pArena->statistics.nUsedSize += nSize;
+	return rc;
+}
+
+//! メモリを解放する
+/*!
+	ブロック内のメモリがすべて解放された時に、ブロックごと解放される。 \n
+	それまでは、解放したメモリも使われたままになる。
+	@param[in]	pArena	領域
+	@param[in]	pv		Cat_ArenaAlloc()で確保したメモリ
+*/
+void
+Cat_ArenaFree( Cat_Arena* pArena, void* pv )
+{
+	Block** ppBlock;
+
+	if((pArena == 0) || (pv == 0)) {
+		return;
+	}
+	// 解放は読み込み直しなどでしか起きないので、ブロックは順に探す
+	for(ppBlock = &pArena->pBlock; *ppBlock; ppBlock = &(*ppBlock)->pNext) {
+		Block* pBlock = *ppBlock;
+		const uint8_t* pbData = (const uint8_t*)pBlock + CAT_ARENA_HEADER_SIZE;
+		if(((const uint8_t*)pv < pbData) || ((const uint8_t*)pv >= pbData + pBlock->nSize)) {
+			continue;
+		}
+		pArena->statistics.nFreeCount++;
+		if(--pBlock->nLive > 0) {
+			return;
+		}
+		pArena->statistics.nUsedSize -= pBlock->nOffset;
+		if(pBlock == pArena->pBlock) {
+			// 切り出し中のブロックは、最初から使い直す
+			pBlock->nOffset = 0;
+		} else {
+			*ppBlock = pBlock->pNext;
+			pArena->statistics.nBlockCount--;
+			pArena->statistics.nReservedSize -= pBlock->nSize;
+			CAT_FREE( pBlock );
+		}
+		return;
+	}
+}
+
+//! 統計情報を取得する
+/*!
+	@param[in]	pArena			領域
+	@param[out]	pStatistics		統計情報
+*/
+void
+Cat_ArenaGetStatistics( Cat_Arena* pArena, Cat_ArenaStatistics* pStatistics )
+{
+	if(pStatistics == 0) {
+		return;
+	}
+	if(pArena == 0) {
+		memset( pStatistics, 0, sizeof(Cat_ArenaStatistics) );
+		return;
+	}
+	*pStatistics = pArena->statistics;
+}
@@ -0,0 +1,382 @@
+//! @file	Cat_Blend.c
+// MUGENの半透明をCPUで合成する
+
+// SSE2が使える環境(ホストでのツールやテスト)では、4ピクセルずつまとめて合成する。
+// パレットを引くのは1ピクセルずつだが、加算と減算は飽和演算、重み付きの合成は_mm_madd_epi16()で
+// ソースと描画先を1命令で掛けて足すので、合成そのものに分岐は無い。
+// CAT_BLEND_NO_SIMDを定義すると、常にスカラー版を使う。
+
+#include "Cat_Blend.h"
+#include "Cat_ColorConvert.h"
+#include <string.h>
+
+#if !defined(CAT_BLEND_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define USE_CAT_BLEND_SSE2
+#endif
+
+//! 一時バッファのピクセル数
+#define CAT_BLEND_WORK (256)
+
+//! nビットのチャンネルを8bitに広げる(Cat_ColorConvert()と同じく、0以外は下位ビットを1で埋める)
+#define EXPAND(v, shift, bits)															\
+	((((v) >> (shift)) & ((1U << (bits)) - 1))											\
+		? (((((v) >> (shift)) & ((1U << (bits)) - 1)) << (8 - (bits))) | ((1U << (8 - (bits))) - 1))	\
+		: 0)
+
+//! 範囲を確かめた後のパラメータ
+typedef struct {
+	uint32_t	nMode;			/*!< 合成の方法						*/
+	uint32_t	nSrcAlpha;		/*!< ソースの重み(0～256)			*/
+	uint32_t	nDestAlpha;		/*!< 描画先の重み(0～256)			*/
+	uint32_t	nShadowColor;	/*!< 影の色(0xBBGGRR)				*/
+	uint32_t	nShadowAlpha;	/*!< 影の濃さ(0～256)				*/
+} Key;
+
+//! パラメータの範囲を確かめる
+/*!
+	@param[out]	pKey	範囲を確かめた後のパラメータ
+	@param[in]	pParam	パラメータ
+*/
+static void
+MakeKey( Key* pKey, const Cat_BlendParam* pParam )
+{
+	pKey->nMode        = (pParam->nMode < CAT_BLEND_MAX) ? pParam->nMode : CAT_BLEND_NONE;
+	pKey->nSrcAlpha    = (pParam->nSrcAlpha < CAT_BLEND_UNIT) ? pParam->nSrcAlpha : CAT_BLEND_UNIT;
+	pKey->nDestAlpha   = (pParam->nDestAlpha < CAT_BLEND_UNIT) ? pParam->nDestAlpha : CAT_BLEND_UNIT;
+	pKey->nShadowColor = pParam->nShadowColor & 0xFFFFFF;
+	pKey->nShadowAlpha = (pParam->nShadowAlpha < CAT_BLEND_UNIT) ? pParam->nShadowAlpha : CAT_BLEND_UNIT;
+}
+
+//! 1チャンネルを合成する
+/*!
+	@param[in]	s		ソース(0～255)
+	@param[in]	d		描画先(0～255)
+	@param[in]	c		影の色(0～255)
+	@param[in]	pKey	パラメータ
+	@return	合成した値(0～255)
+*/
+static inline uint32_t
+BlendChannel( uint32_t s, uint32_t d, uint32_t c, const Key* pKey )
+{
+	uint32_t rc;
+
+	switch(pKey->nMode) {
+		case CAT_BLEND_ADD:
+			rc = s + d;
+			break;
+		case CAT_BLEND_ADD1:
+			rc = s + (d >> 1);
+			break;
+		case CAT_BLEND_SUB:
+			return (d > s) ? d - s : 0;
+		case CAT_BLEND_ADDALPHA:
+			rc = (s * pKey->nSrcAlpha + d * pKey->nDestAlpha) >> 8;
+			break;
+		case CAT_BLEND_SHADOW:
+			return (d * (CAT_BLEND_UNIT - pKey->nShadowAlpha) + c * pKey->nShadowAlpha) >> 8;
+		case CAT_BLEND_NONE:
+		default:
+			return s;
+	}
+	return (rc > 255) ? 255 : rc;
+}
+
+//! 1ピクセルを合成する
+/*!
+	@param[in]	nSrc	ソース(0xAABBGGRR)
+	@param[in]	nDest	描画先(0xAABBGGRR)
+	@param[in]	pKey	パラメータ
+	@return	合成した色(アルファは描画先のまま)
+*/
+static inline uint32_t
+BlendPixel( uint32_t nSrc, uint32_t nDest, const Key* pKey )
+{
+	uint32_t rc = nDest & 0xFF000000;
+	uint32_t nShift;
+
+	for(nShift = 0; nShift < 24; nShift += 8) {
+		rc |= BlendChannel( (nSrc >> nShift) & 0xFF, (nDest >> nShift) & 0xFF, (pKey->nShadowColor >> nShift) & 0xFF, pKey ) << nShift;
+	}
+	return rc;
+}
+
+//! 1ラインを1ピクセルずつ合成する(RGBA8888)
+/*!
+	@param[in,out]	pnDest		描画先
+	@param[in]		pbSrc		インデックス
+	@param[in]		pnPalette	パレット(RGBA8888、256色)
+	@param[in]		nCount		ピクセル数
+	@param[in]		pKey		パラメータ
+*/
+static void
+Blend8888( uint32_t* pnDest, const uint8_t* pbSrc, const uint32_t* pnPalette, uint32_t nCount, const Key* pKey )
+{
+	uint32_t i;
+
+	for(i = 0; i < nCount; i++) {
+		if(pbSrc[i]) {
+			pnDest[i] = BlendPixel( pnPalette[pbSrc[i]], pnDest[i], pKey );
+		}
+	}
+}
+
+#if defined(USE_CAT_BLEND_SSE2)
+//! 重み付きで合成する(SSE2版)
+/*!
+	ソースと描画先を16bitで交互に並べて、_mm_madd_epi16()で (s * ws + d * wd) を32bitで求める。
+	@param[in]	s		ソース(4ピクセル)
+	@param[in]	d		描画先(4ピクセル)
+	@param[in]	weight	重み(下位16bitがソース、上位16bitが描画先)
+	@return	合成した色(255で飽和する)
+*/
+static inline __m128i
+BlendWeightSSE2( __m128i s, __m128i d, __m128i weight )
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i slo  = _mm_unpacklo_epi8( s, zero );
+	const __m128i shi  = _mm_unpackhi_epi8( s, zero );
+	const __m128i dlo  = _mm_unpacklo_epi8( d, zero );
+	const __m128i dhi  = _mm_unpackhi_epi8( d, zero );
+	const __m128i p0   = _mm_srli_epi32( _mm_madd_epi16( _mm_unpacklo_epi16( slo, dlo ), weight ), 8 );
+	const __m128i p1   = _mm_srli_epi32( _mm_madd_epi16( _mm_unpackhi_epi16( slo, dlo ), weight ), 8 );
+	const __m128i p2   = _mm_srli_epi32( _mm_madd_epi16( _mm_unpacklo_epi16( shi, dhi ), weight ), 8 );
+	const __m128i p3   = _mm_srli_epi32( _mm_madd_epi16( _mm_unpackhi_epi16( shi, dhi ), weight ), 8 );
+
+	// 最大でも510なので、16bitへは飽和せずに詰められる
+	return _mm_packus_epi16( _mm_packs_epi32( p0, p1 ), _mm_packs_epi32( p2, p3 ) );
+}
+
+//! 1ラインを合成する(RGBA8888、SSE2版)
+/*!
+	@param[in,out]	pnDest		描画先
+	@param[in]		pbSrc		インデックス
+	@param[in]		pnPalette	パレット(RGBA8888、256色)
+	@param[in]		nCount		ピクセル数
+	@param[in]		pKey		パラメータ
+	@return	合成したピクセル数(4の倍数)
+*/
+static uint32_t
+Blend8888SSE2( uint32_t* pnDest, const uint8_t* pbSrc, const uint32_t* pnPalette, uint32_t nCount, const Key* pKey )
+{
+	const __m128i zero   = _mm_setzero_si128();
+	const __m128i alpha  = _mm_set1_epi32( (int32_t)0xFF000000 );
+	const __m128i half   = _mm_set1_epi8( 0x7F );
+	const __m128i shadow = _mm_set1_epi32( (int32_t)pKey->nShadowColor );
+	const __m128i weight = (pKey->nMode == CAT_BLEND_SHADOW)
+		? _mm_set1_epi32( (int32_t)(pKey->nShadowAlpha | ((CAT_BLEND_UNIT - pKey->nShadowAlpha) << 16)) )
+		: _mm_set1_epi32( (int32_t)(pKey->nSrcAlpha | (pKey->nDestAlpha << 16)) );
+	uint32_t i;
+
+	for(i = 0; i + 4 <= nCount; i += 4) {
+		uint32_t nIndex;
+		__m128i keep;
+		__m128i s;
+		__m128i d;
+		__m128i rc;
+
+		memcpy( &nIndex, &pbSrc[i], sizeof(nIndex) );
+		if(nIndex == 0) {
+			// 4ピクセルとも透明
+			continue;
+		}
+		// パレットを引くのは1ピクセルずつ
+		s = _mm_setr_epi32( (int32_t)pnPalette[pbSrc[i]], (int32_t)pnPalette[pbSrc[i + 1]],
+			(int32_t)pnPalette[pbSrc[i + 2]], (int32_t)pnPalette[pbSrc[i + 3]] );
+		d = _mm_loadu_si128( (const __m128i*)(pnDest + i) );
+		switch(pKey->nMode) {
+			case CAT_BLEND_ADD:
+				rc = _mm_adds_epu8( s, d );
+				break;
+			case CAT_BLEND_ADD1:
+				rc = _mm_adds_epu8( s, _mm_and_si128( _mm_srli_epi16( d, 1 ), half ) );
+				break;
+			case CAT_BLEND_SUB:
+				rc = _mm_subs_epu8( d, s );
+				break;
+			case CAT_BLEND_ADDALPHA:
+				rc = BlendWeightSSE2( s, d, weight );
+				break;
+			case CAT_BLEND_SHADOW:
+				rc = BlendWeightSSE2( shadow, d, weight );
+				break;
+			case CAT_BLEND_NONE:
+			default:
+				rc = s;
+				break;
+		}
+		// アルファは描画先のまま、インデックス0のピクセルは描画先を残す
+		keep = _mm_unpacklo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( (int32_t)nIndex ), zero ), zero );
+		keep = _mm_cmpeq_epi32( keep, zero );
+		rc = _mm_or_si128( _mm_andnot_si128( alpha, rc ), _mm_and_si128( alpha, d ) );
+		rc = _mm_or_si128( _mm_andnot_si128( keep, rc ), _mm_and_si128( keep, d ) );
+		_mm_storeu_si128( (__m128i*)(pnDest + i), rc );
+	}
+	return i;
+}
+#endif
+
+//! パラメータを上書きで初期化する
+/*!
+	@param[out]	pParam	パラメータ
+*/
+void
+Cat_BlendParamInit( Cat_BlendParam* pParam )
+{
+	if(pParam == 0) {
+		return;
+	}
+	memset( pParam, 0, sizeof(Cat_BlendParam) );
+	pParam->nMode        = CAT_BLEND_NONE;
+	pParam->nSrcAlpha    = CAT_BLEND_UNIT;
+	pParam->nShadowAlpha = CAT_BLEND_UNIT / 2;
+}
+
+//! 1ラインを合成する(RGBA8888)
+/*!
+	ホストではSSE2で4ピクセルずつ、PSPではスカラーで合成する。結果はどちらも同じになる。
+	@param[in,out]	pnDest		描画先
+	@param[in]		pbSrc		インデックス
+	@param[in]		pnPalette	パレット(RGBA8888、256色)
+	@param[in]		nCount		ピクセル数
+	@param[in]		pParam		パラメータ
+*/
+void
+Cat_BlendSpan8888( uint32_t* pnDest, const uint8_t* pbSrc, const uint32_t* pnPalette, uint32_t nCount, const Cat_BlendParam* pParam )
+{
+	uint32_t i = 0;
+	Key key;
+
+	if((pnDest == 0) || (pbSrc == 0) || (pnPalette == 0) || (pParam == 0)) {
+		return;
+	}
+	MakeKey( &key, pParam );
+#if defined(USE_CAT_BLEND_SSE2)
+	i = Blend8888SSE2( pnDest, pbSrc, pnPalette, nCount, &key );
+#endif
+	Blend8888( pnDest + i, pbSrc + i, pnPalette, nCount - i, &key );
+}
+
+//! 1ラインを合成する(RGBA5650)
+/*!
+	描画先をCat_ColorConvert()と同じ方法で8bitに広げて合成し、下位ビットを切り捨てて戻す。
+	@param[in,out]	pnDest		描画先
+	@param[in]		pbSrc		インデックス
+	@param[in]		pnPalette	パレット(RGBA8888、256色)
+	@param[in]		nCount		ピクセル数
+	@param[in]		pParam		パラメータ
+*/
+void
+Cat_BlendSpan5650( uint16_t* pnDest, const uint8_t* pbSrc, const uint32_t* pnPalette, uint32_t nCount, const Cat_BlendParam* pParam )
+{
+	uint32_t anWork[CAT_BLEND_WORK];
+	uint32_t i;
+
+	if((pnDest == 0) || (pbSrc == 0) || (pnPalette == 0) || (pParam == 0)) {
+		return;
+	}
+	// 広げるのと戻すのは、Cat_ColorConvert()でまとめて行う
+	for(i = 0; i < nCount; i += CAT_BLEND_WORK) {
+		const uint32_t n = (nCount - i < CAT_BLEND_WORK) ? nCount - i : CAT_BLEND_WORK;
+		Cat_ColorConvert( anWork, FORMAT_PIXEL_8888, pnDest + i, FORMAT_PIXEL_5650, n );
+		Cat_BlendSpan8888( anWork, pbSrc + i, pnPalette, n, pParam );
+		Cat_ColorConvert( pnDest + i, FORMAT_PIXEL_5650, anWork, FORMAT_PIXEL_8888, n );
+	}
+}
+
+//! 1ラインを1ピクセルずつ合成する(RGBA8888)
+/*!
+	Cat_BlendSpan8888()と同じ結果になる、比較用の実装。
+	@param[in,out]	pnDest		描画先
+	@param[in]		pbSrc		インデックス
+	@param[in]		pnPalette	パレット(RGBA8888、256色)
+	@param[in]		nCount		ピクセル数
+	@param[in]		pParam		パラメータ
+*/
+void
+Cat_BlendSpan8888Reference( uint32_t* pnDest, const uint8_t* pbSrc, const uint32_t* pnPalette, uint32_t nCount, const Cat_BlendParam* pParam )
+{
+	Key key;
+
+	if((pnDest == 0) || (pbSrc == 0) || (pnPalette == 0) || (pParam == 0)) {
+		return;
+	}
+	MakeKey( &key, pParam );
+	Blend8888( pnDest, pbSrc, pnPalette, nCount, &key );
+}
+
+//! 1ラインを1ピクセルずつ合成する(RGBA5650)
+/*!
+	Cat_BlendSpan5650()と同じ結果になる、比較用の実装。
+	@param[in,out]	pnDest		描画先
+	@param[in]		pbSrc		インデックス
+	@param[in]		pnPalette	パレット(RGBA8888、256色)
+	@param[in]		nCount		ピクセル数
+	@param[in]		pParam		パラメータ
+*/
+void
+Cat_BlendSpan5650Reference( uint16_t* pnDest, const uint8_t* pbSrc, const uint32_t* pnPalette, uint32_t nCount, const Cat_BlendParam* pParam )
+{
+	uint32_t i;
+	Key key;
+
+	if((pnDest == 0) || (pbSrc == 0) || (pnPalette == 0) || (pParam == 0)) {
+		return;
+	}
+	MakeKey( &key, pParam );
+	for(i = 0; i < nCount; i++) {
+		const uint32_t v = pnDest[i];
+		uint32_t nColor;
+
+		if(pbSrc[i] == 0) {
+			continue;
+		}
+		nColor = EXPAND( v, 0, 5 ) | (EXPAND( v, 5, 6 ) << 8) | (EXPAND( v, 11, 5 ) << 16);
+		nColor = BlendPixel( pnPalette[pbSrc[i]], nColor, &key );
+		pnDest[i] = (uint16_t)(((nColor & 0xFF) >> 3) | (((nColor >> 8) & 0xFF) >> 2 << 5) | (((nColor >> 16) & 0xFF) >> 3 << 11));
+	}
+}
+
+//! 画像を合成する
+/*!
+	@param[in,out]	pvDest			描画先
+	@param[in]		nDestPitch		描画先のピッチ(バイト単位)
+	@param[in]		eDestFormat		描画先のフォーマット(FORMAT_PIXEL_8888/5650)
+	@param[in]		pbSrc			インデックス
+	@param[in]		nSrcPitch		インデックスのピッチ(バイト単位)
+	@param[in]		nWidth			横幅
+	@param[in]		nHeight			高さ
+	@param[in]		pPalette		パレット(どのフォーマットでも良い)
+	@param[in]		pParam			パラメータ
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+int32_t
+Cat_BlendImage( void* pvDest, uint32_t nDestPitch, FORMAT_PIXEL eDestFormat, const uint8_t* pbSrc, uint32_t nSrcPitch,
+	uint32_t nWidth, uint32_t nHeight, const Cat_Palette* pPalette, const Cat_BlendParam* pParam )
+{
+	uint32_t anPalette[256];
+	uint8_t* pbDest = (uint8_t*)pvDest;
+	uint32_t i;
+
+	if((pvDest == 0) || (pbSrc == 0) || (pPalette == 0) || (pPalette->pvData == 0) || (pParam == 0)) {
+		return -1;
+	}
+	if((eDestFormat != FORMAT_PIXEL_8888) && (eDestFormat != FORMAT_PIXEL_5650)) {
+		return -1;
+	}
+	// パレットは一度RGBA8888の256色に広げる(16色のパレットはGEと同じくマスクする)
+	for(i = 0; i < 256; i++) {
+		anPalette[i] = Cat_PaletteGetColor( pPalette, i & pPalette->nMask );
+	}
+	for(i = 0; i < nHeight; i++) {
+		if(eDestFormat == FORMAT_PIXEL_8888) {
+			Cat_BlendSpan8888( (uint32_t*)pbDest, pbSrc, anPalette, nWidth, pParam );
+		} else {
+			Cat_BlendSpan5650( (uint16_t*)pbDest, pbSrc, anPalette, nWidth, pParam );
+		}
+		pbDest += nDestPitch;
+		pbSrc  += nSrcPitch;
+	}
+	return 0;
+}
@@ -0,0 +1,612 @@
+//! @file	Cat_Capture.c
+// 画面の保存(スクリーンショットと連続したフレーム)
+
+#include "Cat_Capture.h"
+#include "Cat_Render.h"
+#include "Cat_Texture.h"
+#include "Cat_StreamFile.h"
+#include <pspkernel.h>
+#include <pspgu.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>	// for memalign
+#ifdef __psp__
+#include <pspintrman.h>
+#else
+#include <pthread.h>
+#endif
+
+#ifdef USE_CAT_IMAGELOADER_PCX
+#include "Cat_ImageLoaderPCX.h"
+#endif // USE_CAT_IMAGELOADER_PCX
+
+#ifndef CAT_MALLOC
+//! メモリ確保マクロ
+#define CAT_MALLOC(x) memalign( 64, (x) )
+#endif // CAT_MALLOC
+
+#ifndef CAT_FREE
+//! メモリ解放マクロ
+#define CAT_FREE(x) free( x )
+#endif // CAT_FREE
+
+//! 保存する横幅
+#define CAT_CAPTURE_WIDTH (CAT_RENDER_TARGET_WIDTH)
+//! 保存する高さ
+#define CAT_CAPTURE_HEIGHT (CAT_RENDER_TARGET_HEIGHT)
+//! バッファの数の最大値
+#define CAT_CAPTURE_BUFFER_MAX (16)
+//! 書き込むスレッドのスタックサイズ
+#define CAT_CAPTURE_STACK_SIZE (64 * 1024)
+//! キューが空くのを待つ間隔(マイクロ秒単位)
+#define CAT_CAPTURE_FLUSH_WAIT (1000)
+
+//! バッファ
+typedef struct {
+	void*				pvImage;							/*!< コピーしたフレームバッファ(480x272、詰めて並べる)	*/
+	int32_t				nFormat;							/*!< ピクセルフォーマット(GU_PSM_xxx)					*/
+	char				szFilename[CAT_CAPTURE_PATH_MAX];	/*!< ファイル名											*/
+	volatile uint32_t	nQueued;							/*!< キューに入っているかどうか							*/
+} Slot;
+
+//! 画面の保存
+struct _Cat_Capture {
+	Slot					aSlot[CAT_CAPTURE_BUFFER_MAX];		/*!< バッファ							*/
+	uint32_t				nSlotCount;							/*!< バッファの数						*/
+	uint32_t				nWrite;								/*!< 次にコピーするバッファの番号		*/
+	uint32_t				nRead;								/*!< 次に書き込むバッファの番号			*/
+	uint32_t				anLine[CAT_CAPTURE_WIDTH];			/*!< RGBA8888に変換した1ライン			*/
+	char					szShot[CAT_CAPTURE_PATH_MAX];		/*!< 予約したスクリーンショット			*/
+	char					szFormat[CAT_CAPTURE_PATH_MAX];		/*!< 連続したフレームのファイル名の書式	*/
+	uint32_t				nInterval;							/*!< 連続したフレームを保存する間隔		*/
+	uint32_t				nCounter;							/*!< 次に保存するまでの回数				*/
+	uint32_t				nSequence;							/*!< 連続したフレームの通し番号			*/
+	uint32_t				nSequenceCount;						/*!< 連続したフレームを保存した数		*/
+	volatile uint32_t		nQuit;								/*!< 書き込むスレッドを止めるかどうか	*/
+	volatile uint32_t		nResetRequest;						/*!< 書き込み側の統計情報をクリアするかどうか	*/
+	int						fThread;							/*!< 書き込むスレッドが動いているか		*/
+#ifdef __psp__
+	SceUID					thid;								/*!< 書き込むスレッド					*/
+	SceUID					sema;								/*!< キューに入れた数					*/
+#else
+	pthread_t				thread;								/*!< 書き込むスレッド					*/
+	pthread_mutex_t			mutex;								/*!< nSignalの排他						*/
+	pthread_cond_t			cond;								/*!< nSignalが増えたことの通知			*/
+	uint32_t				nSignal;							/*!< キューに入れた数					*/
+#endif
+	Cat_CaptureStatistics	statistics;							/*!< 統計情報							*/
+};
+
+//! 値を不可分に入れ替える
+/*!
+	@param[in,out]	pn	入れ替える場所
+	@param[in]		n	新しい値
+	@return	前の値
+*/
+static uint32_t
+Exchange( volatile uint32_t* pn, uint32_t n )
+{
+#ifdef __psp__
+	const int nIntr = sceKernelCpuSuspendIntr();
+	const uint32_t rc = *pn;
+	*pn = n;
+	sceKernelCpuResumeIntr( nIntr );
+	return rc;
+#else
+	return __atomic_exchange_n( pn, n, __ATOMIC_ACQ_REL );
+#endif
+}
+
+//! 値を読む
+/*!
+	@param[in]	pn	読む場所
+	@return	値
+*/
+static uint32_t
+Load( volatile uint32_t* pn )
+{
+#ifdef __psp__
+	return *pn;
+#else
+	return __atomic_load_n( pn, __ATOMIC_ACQUIRE );
+#endif
+}
+
+//! 書き込むスレッドを起こす
+/*!
+	@param[in]	pCapture	画面の保存
+*/
+static void
+Signal( Cat_Capture* pCapture )
+{
+#ifdef __psp__
+	sceKernelSignalSema( pCapture->sema, 1 );
+#else
+	pthread_mutex_lock( &pCapture->mutex );
+	pCapture->nSignal++;
+	pthread_cond_signal( &pCapture->cond );
+	pthread_mutex_unlock( &pCapture->mutex );
+#endif
+}
+
+//! 起こされるまで待つ
+/*!
+	@param[in]	pCapture	画面の保存
+*/
+static void
+Wait( Cat_Capture* pCapture )
+{
+#ifdef __psp__
+	sceKernelWaitSema( pCapture->sema, 1, 0 );
+#else
+	pthread_mutex_lock( &pCapture->mutex );
+	while(pCapture->nSignal == 0) {
+		pthread_cond_wait( &pCapture->cond, &pCapture->mutex );
+	}
+	pCapture->nSignal--;
+	pthread_mutex_unlock( &pCapture->mutex );
+#endif
+}
+
+//! バッファの1ラインをRGBA8888に変換する
+/*!
+	Cat_ImageLoaderSavePCX8888()から呼ばれる。
+	@param[in]	y			ライン
+	@param[in]	pvContext	画面の保存
+	@return	1ライン分のRGBA8888
+*/
+static const uint32_t*
+GetLine( uint32_t y, void* pvContext )
+{
+	Cat_Capture* pCapture = (Cat_Capture*)pvContext;
+	const Slot* pSlot = &pCapture->aSlot[pCapture->nRead];
+	uint32_t* pnDest = pCapture->anLine;
+	uint32_t x;
+
+	if(pSlot->nFormat == GU_PSM_8888) {
+		return (const uint32_t*)pSlot->pvImage + y * CAT_CAPTURE_WIDTH;
+	} else {
+		const uint16_t* pnSrc = (const uint16_t*)pSlot->pvImage + y * CAT_CAPTURE_WIDTH;
+		switch(pSlot->nFormat) {
+			case GU_PSM_5551:
+				for(x = 0; x < CAT_CAPTURE_WIDTH; x++) {
+					pnDest[x] = Cat_ColorConvert5551To8888( pnSrc[x] );
+				}
+				break;
+			case GU_PSM_4444:
+				for(x = 0; x < CAT_CAPTURE_WIDTH; x++) {
+					pnDest[x] = Cat_ColorConvert4444To8888( pnSrc[x] );
+				}
+				break;
+			case GU_PSM_5650:
+			default:
+				for(x = 0; x < CAT_CAPTURE_WIDTH; x++) {
+					pnDest[x] = Cat_ColorConvert5650To8888( pnSrc[x] );
+				}
+				break;
+		}
+	}
+	return pnDest;
+}
+
+//! 書き込み側の統計情報をクリアする
+/*!
+	書き込むスレッドが書き込む回数と時間だけをクリアする。書き込むスレッドから呼ぶ。
+	@param[in,out]	pCapture	画面の保存
+*/
+static void
+ResetSaveStatistics( Cat_Capture* pCapture )
+{
+	pCapture->statistics.nSaveCount   = 0;
+	pCapture->statistics.nErrorCount  = 0;
+	pCapture->statistics.nSaveTime    = 0;
+	pCapture->statistics.nSaveTimeMax = 0;
+	pCapture->statistics.nSaveSize    = 0;
+}
+
+//! キューの先頭のバッファを書き込む
+/*!
+	@param[in]	pCapture	画面の保存
+*/
+static void
+Save( Cat_Capture* pCapture )
+{
+	Slot* pSlot = &pCapture->aSlot[pCapture->nRead];
+	const uint32_t nStart = sceKernelGetSystemTimeLow();
+	Cat_CaptureStatistics* pStatistics = &pCapture->statistics;
+	Cat_Stream* pStream;
+	int32_t rc = -1;
+	uint32_t nTime;
+
+	pStream = Cat_StreamFileWriteOpen( pSlot->szFilename );
+	if(pStream) {
+#ifdef USE_CAT_IMAGELOADER_PCX
+		rc = Cat_ImageLoaderSavePCX8888( pStream, CAT_CAPTURE_WIDTH, CAT_CAPTURE_HEIGHT, GetLine, pCapture );
+#endif // USE_CAT_IMAGELOADER_PCX
+		if(rc == 0) {
+			pStatistics->nSaveSize += (uint32_t)Cat_StreamTell( pStream );
+		}
+		Cat_StreamClose( pStream );
+	}
+	nTime = sceKernelGetSystemTimeLow() - nStart;
+	if(rc == 0) {
+		pStatistics->nSaveCount++;
+	} else {
+		pStatistics->nErrorCount++;
+	}
+	pStatistics->nSaveTime += nTime;
+	if(pStatistics->nSaveTimeMax < nTime) {
+		pStatistics->nSaveTimeMax = nTime;
+	}
+
+	// 書き込み終わったバッファを空ける
+	Exchange( &pSlot->nQueued, 0 );
+	pCapture->nRead = (pCapture->nRead + 1) % pCapture->nSlotCount;
+}
+
+//! 書き込むスレッドの処理
+/*!
+	止める時も、キューに残っているものは書き込む。
+	@param[in]	pCapture	画面の保存
+*/
+static void
+SaveLoop( Cat_Capture* pCapture )
+{
+	for(;;) {
+		Wait( pCapture );
+		if(Load( &pCapture->nResetRequest ) && Exchange( &pCapture->nResetRequest, 0 )) {
+			ResetSaveStatistics( pCapture );
+		}
+		while(Load( &pCapture->aSlot[pCapture->nRead].nQueued )) {
+			Save( pCapture );
+		}
+		if(Load( &pCapture->nQuit )) {
+			break;
+		}
+	}
+}
+
+#ifdef __psp__
+//! 書き込むスレッド
+/*!
+	@param[in]	nArgs	引数のサイズ
+	@param[in]	pvArgs	画面の保存のアドレス
+	@return	0
+*/
+static int
+SaveThread( SceSize nArgs, void* pvArgs )
+{
+	SaveLoop( *(Cat_Capture**)pvArgs );
+	return 0;
+}
+#else
+//! 書き込むスレッド
+/*!
+	@param[in]	pv	画面の保存
+	@return	0
+*/
+static void*
+SaveThread( void* pv )
+{
+	SaveLoop( (Cat_Capture*)pv );
+	return 0;
+}
+#endif
+
+//! 作成する
+/*!
+	書き込むスレッドも開始する。
+	@param[in]	nBufferCount	バッファの数(キューの長さ)。1つあたり480x272x4バイト確保する。
+	@param[in]	nPriority		書き込むスレッドの優先度(PSPのみ。ゲームの処理をするスレッドより低くする)
+	@return	作成されたもの。失敗した場合は0が返る。
+	@see	Cat_CaptureDestroy()
+*/
+Cat_Capture*
+Cat_CaptureCreate( uint32_t nBufferCount, int32_t nPriority )
+{
+	Cat_Capture* rc;
+	uint32_t i;
+
+#ifndef USE_CAT_IMAGELOADER_PCX
+	return 0;
+#endif // USE_CAT_IMAGELOADER_PCX
+	if((nBufferCount == 0) || (nBufferCount > CAT_CAPTURE_BUFFER_MAX)) {
+		return 0;
+	}
+	rc = (Cat_Capture*)malloc( sizeof(Cat_Capture) );
+	if(rc == 0) {
+		return 0;
+	}
+	memset( rc, 0, sizeof(Cat_Capture) );
+	rc->nSlotCount = nBufferCount;
+	for(i = 0; i < nBufferCount; i++) {
+		rc->aSlot[i].pvImage = CAT_MALLOC( CAT_CAPTURE_WIDTH * CAT_CAPTURE_HEIGHT * 4 );
+		if(rc->aSlot[i].pvImage == 0) {
+			Cat_CaptureDestroy( rc );
+			return 0;
+		}
+	}
+
+#ifdef __psp__
+	rc->sema = sceKernelCreateSema( "Cat_Capture", 0, 0, CAT_CAPTURE_BUFFER_MAX + 1, 0 );
+	if(rc->sema < 0) {
+		Cat_CaptureDestroy( rc );
+		return 0;
+	}
+	rc->thid = sceKernelCreateThread( "Cat_Capture", SaveThread, nPriority, CAT_CAPTURE_STACK_SIZE,
+		PSP_THREAD_ATTR_USER, 0 );
+	if(rc->thid < 0) {
+		Cat_CaptureDestroy( rc );
+		return 0;
+	}
+	if(sceKernelStartThread( rc->thid, sizeof(rc), &rc ) < 0) {
+		sceKernelDeleteThread( rc->thid );
+		Cat_CaptureDestroy( rc );
+		return 0;
+	}
+#else
+	pthread_mutex_init( &rc->mutex, 0 );
+	pthread_cond_init( &rc->cond, 0 );
+	if(pthread_create( &rc->thread, 0, SaveThread, rc ) != 0) {
+		pthread_cond_destroy( &rc->cond );
+		pthread_mutex_destroy( &rc->mutex );
+		Cat_CaptureDestroy( rc );
+		return 0;
+	}
+#endif
+	rc->fThread = 1;
+	return rc;
+}
+
+//! 破棄する
+/*!
+	キューに残っているフレームを書き込んでから、書き込むスレッドを止めて破棄する。
+	@param[in]	pCapture	画面の保存
+*/
+void
+Cat_CaptureDestroy( Cat_Capture* pCapture )
+{
+	uint32_t i;
+
+	if(pCapture == 0) {
+		return;
+	}
+	if(pCapture->fThread) {
+		Exchange( &pCapture->nQuit, 1 );
+		Signal( pCapture );
+#ifdef __psp__
+		sceKernelWaitThreadEnd( pCapture->thid, 0 );
+		sceKernelDeleteThread( pCapture->thid );
+#else
+		pthread_join( pCapture->thread, 0 );
+		pthread_cond_destroy( &pCapture->cond );
+		pthread_mutex_destroy( &pCapture->mutex );
+#endif
+	}
+#ifdef __psp__
+	if(pCapture->sema > 0) {
+		sceKernelDeleteSema( pCapture->sema );
+	}
+#endif
+	for(i = 0; i < pCapture->nSlotCount; i++) {
+		if(pCapture->aSlot[i].pvImage) {
+			CAT_FREE( pCapture->aSlot[i].pvImage );
+		}
+	}
+	free( pCapture );
+}
+
+//! スクリーンショットを予約する
+/*!
+	次のCat_CaptureUpdate()で表示しているフレームを保存する。
+	@param[in]	pCapture	画面の保存
+	@param[in]	pszFilename	ファイル名
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+int32_t
+Cat_CaptureShot( Cat_Capture* pCapture, const char* pszFilename )
+{
+	if((pCapture == 0) || (pszFilename == 0) || (strlen( pszFilename ) >= CAT_CAPTURE_PATH_MAX)) {
+		return -1;
+	}
+	strcpy( pCapture->szShot, pszFilename );
+	return 0;
+}
+
+//! 連続したフレームの保存を開始する
+/*!
+	@param[in]	pCapture	画面の保存
+	@param[in]	pszFormat	ファイル名の書式(printfの書式で、0から始まる通し番号を1つ渡す)
+	@param[in]	nInterval	保存する間隔(Cat_CaptureUpdate()の回数、1で毎フレーム)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+	@see	Cat_CaptureStopSequence()
+*/
+int32_t
+Cat_CaptureStartSequence( Cat_Capture* pCapture, const char* pszFormat, uint32_t nInterval )
+{
+	if((pCapture == 0) || (pszFormat == 0) || (nInterval == 0) || (strlen( pszFormat ) >= CAT_CAPTURE_PATH_MAX)) {
+		return -1;
+	}
+	strcpy( pCapture->szFormat, pszFormat );
+	pCapture->nInterval      = nInterval;
+	pCapture->nCounter       = 0;
+	pCapture->nSequence      = 0;
+	pCapture->nSequenceCount = 0;
+	return 0;
+}
+
+//! 連続したフレームの保存を止める
+/*!
+	キューに残っているフレームは書き込まれる。
+	@param[in]	pCapture	画面の保存
+	@return	保存したフレーム数(保存しなかったフレームの分も通し番号は進む)
+*/
+uint32_t
+Cat_CaptureStopSequence( Cat_Capture* pCapture )
+{
+	if(pCapture == 0) {
+		return 0;
+	}
+	pCapture->nInterval = 0;
+	return pCapture->nSequenceCount;
+}
+
+//! 表示しているフレームをコピーする
+/*!
+	Cat_RenderScreenUpdate()の後に毎フレーム呼ぶ。予約したスクリーンショットか、 \n
+	連続したフレームの保存の間隔に当たる時だけ、Cat_RenderGetDisplay()をバッファにコピーしてキューに入れる。
+	@param[in]	pCapture	画面の保存
+	@return	コピーした場合は、1 \n
+			保存するフレームでない場合は、0 \n
+			空いているバッファが無いなどで保存しなかった場合は、負数が返る
+*/
+int32_t
+Cat_CaptureUpdate( Cat_Capture* pCapture )
+{
+	Cat_CaptureStatistics* pStatistics;
+	char szFilename[CAT_CAPTURE_PATH_MAX];
+	const uint8_t* pbSrc;
+	uint8_t* pbDest;
+	Slot* pSlot;
+	uint32_t nStart;
+	uint32_t nTime;
+	uint32_t nLineSize;
+	uint32_t nQueued;
+	uint32_t i;
+	int fSequence = 0;
+
+	if(pCapture == 0) {
+		return -1;
+	}
+	pStatistics = &pCapture->statistics;
+
+	// 保存するフレームかどうか(スクリーンショットを優先して、通し番号は進める)
+	if(pCapture->nInterval) {
+		if(pCapture->nCounter == 0) {
+			fSequence = 1;
+			pCapture->nCounter = pCapture->nInterval;
+		}
+		pCapture->nCounter--;
+	}
+	if(pCapture->szShot[0]) {
+		strcpy( szFilename, pCapture->szShot );
+	} else if(fSequence) {
+		snprintf( szFilename, sizeof(szFilename), pCapture->szFormat, (int)pCapture->nSequence );
+	} else {
+		return 0;
+	}
+	if(fSequence) {
+		pCapture->nSequence++;
+		if(pCapture->szShot[0]) {
+			fSequence = 0;
+		}
+	}
+
+	pSlot = &pCapture->aSlot[pCapture->nWrite];
+	if(Load( &pSlot->nQueued )) {
+		// 書き込みが間に合っていないので、待たずに捨てる(スクリーンショットは次のフレームで撮り直す)
+		pStatistics->nDropCount++;
+		return -1;
+	}
+	if(strcmp( szFilename, pCapture->szShot ) == 0) {
+		pCapture->szShot[0] = '\0';
+	}
+
+	// 表示しているフレームは、次のCat_RenderScreenUpdate()まで書き換えられない
+	nStart = sceKernelGetSystemTimeLow();
+	pSlot->nFormat = Cat_RenderGetFormat();
+	nLineSize = CAT_CAPTURE_WIDTH * ((pSlot->nFormat == GU_PSM_8888) ? 4 : 2);
+	pbSrc  = (const uint8_t*)Cat_RenderGetDisplay();
+	pbDest = (uint8_t*)pSlot->pvImage;
+	for(i = 0; i < CAT_CAPTURE_HEIGHT; i++) {
+		memcpy( pbDest, pbSrc, nLineSize );
+		pbSrc  += nLineSize / CAT_CAPTURE_WIDTH * CAT_RENDER_TARGET_BUFFER_WIDTH;
+		pbDest += nLineSize;
+	}
+	strcpy( pSlot->szFilename, szFilename );
+	nTime = sceKernelGetSystemTimeLow() - nStart;
+
+	Exchange( &pSlot->nQueued, 1 );
+	pCapture->nWrite = (pCapture->nWrite + 1) % pCapture->nSlotCount;
+	Signal( pCapture );
+
+	pStatistics->nCopyCount++;
+	pStatistics->nCopyTime += nTime;
+	if(pStatistics->nCopyTimeMax < nTime) {
+		pStatistics->nCopyTimeMax = nTime;
+	}
+	nQueued = 0;
+	for(i = 0; i < pCapture->nSlotCount; i++) {
+		nQueued += Load( &pCapture->aSlot[i].nQueued );
+	}
+	if(pStatistics->nQueueMax < nQueued) {
+		pStatistics->nQueueMax = nQueued;
+	}
+	if(fSequence) {
+		pCapture->nSequenceCount++;
+	}
+	return 1;
+}
+
+//! キューに入っているフレームを書き込み終わるまで待つ
+/*!
+	Cat_CaptureResetStatistics()した書き込み側の統計情報が、クリアされるのも待つ。
+	@param[in]	pCapture	画面の保存
+*/
+void
+Cat_CaptureFlush( Cat_Capture* pCapture )
+{
+	uint32_t i;
+
+	if(pCapture == 0) {
+		return;
+	}
+	for(i = 0; i < pCapture->nSlotCount; i++) {
+		// 書き込むスレッドは優先度が低いので、待つ間は眠る
+		while(Load( &pCapture->aSlot[i].nQueued )) {
+			sceKernelDelayThread( CAT_CAPTURE_FLUSH_WAIT );
+		}
+	}
+	while(Load( &pCapture->nResetRequest )) {
+		sceKernelDelayThread( CAT_CAPTURE_FLUSH_WAIT );
+	}
+}
+
+//! 統計情報を取得する
+/*!
+	書き込み側の回数と時間は書き込むスレッドが更新するので、揃った値はCat_CaptureFlush()の後で取得する。
+	@param[in]	pCapture		画面の保存
+	@param[out]	pStatistics		統計情報
+*/
+void
+Cat_CaptureGetStatistics( Cat_Capture* pCapture, Cat_CaptureStatistics* pStatistics )
+{
+	if((pCapture == 0) || (pStatistics == 0)) {
+		return;
+	}
+	*pStatistics = pCapture->statistics;
+}
+
+//! 統計情報をクリアする
+/*!
+	ゲームの処理をするスレッドから呼ぶ。コピー側の回数と時間はすぐにクリアし、 \n
+	書き込み側の回数と時間は、書き込むスレッドを起こしてクリアさせる(Cat_CaptureFlush()で終わるのを待てる)。
+	@param[in]	pCapture	画面の保存
+*/
+void
+Cat_CaptureResetStatistics( Cat_Capture* pCapture )
+{
+	if(pCapture == 0) {
+		return;
+	}
+	pCapture->statistics.nCopyCount   = 0;
+	pCapture->statistics.nDropCount   = 0;
+	pCapture->statistics.nCopyTime    = 0;
+	pCapture->statistics.nCopyTimeMax = 0;
+	pCapture->statistics.nQueueMax    = 0;
+	Exchange( &pCapture->nResetRequest, 1 );
+	Signal( pCapture );
+}
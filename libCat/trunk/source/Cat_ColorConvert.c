@@ -0,0 +1,424 @@
+//! @file	Cat_ColorConvert.c
+// 色フォーマットの一括変換
+
+// SSE2かNEONが使える環境(ホストでのツールやテスト)では、8ピクセルずつまとめて変換する。
+// PSPでは分岐のないスカラー版を使う。
+// CAT_COLORCONVERT_NO_SIMDを定義すると、常にスカラー版を使う。
+
+#include "Cat_ColorConvert.h"
+#include <string.h>
+
+#if !defined(CAT_COLORCONVERT_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define USE_CAT_COLORCONVERT_SSE2
+#elif !defined(CAT_COLORCONVERT_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define USE_CAT_COLORCONVERT_NEON
+#endif
+
+//! 16bitフォーマットの並び
+typedef struct {
+	uint32_t	nShift[4];			/*!< R,G,B,Aの位置					*/
+	uint32_t	nBits[4];			/*!< R,G,B,Aのビット数(0はなし)		*/
+} Layout;
+
+//! RGBA5650の並び
+static const Layout layout5650 = { {  0,  5, 11,  0 }, { 5, 6, 5, 0 } };
+//! RGBA5551の並び
+static const Layout layout5551 = { {  0,  5, 10, 15 }, { 5, 5, 5, 1 } };
+//! RGBA4444の並び
+static const Layout layout4444 = { {  0,  4,  8, 12 }, { 4, 4, 4, 4 } };
+
+//! 一時バッファの色数
+#define CAT_COLORCONVERT_WORK (256)
+
+//! nビットのチャンネルを8bitに広げる(0以外は下位ビットを1で埋める)
+#define EXPAND(v, shift, bits)															\
+	((((v) >> (shift)) & ((1U << (bits)) - 1))											\
+		? (((((v) >> (shift)) & ((1U << (bits)) - 1)) << (8 - (bits))) | ((1U << (8 - (bits))) - 1))	\
+		: 0)
+
+//! 8bitのチャンネルをnビットに縮める
+#define COMPRESS(v, pos, shift, bits)	(((((v) >> (pos)) & 0xFF) >> (8 - (bits))) << (shift))
+
+//! 16bitから32bitへ変換する関数を定義する
+#define DEFINE_EXPAND_FUNC(name, RS, RB, GS, GB, BS, BB, AS, AB)						\
+static void																				\
+name( uint32_t* pnDest, const uint16_t* pnSrc, uint32_t nCount )						\
+{																						\
+	uint32_t i;																			\
+	for(i = 0; i < nCount; i++) {														\
+		const uint32_t v = pnSrc[i];													\
+		pnDest[i] = EXPAND( v, RS, RB )													\
+			| (EXPAND( v, GS, GB ) << 8)												\
+			| (EXPAND( v, BS, BB ) << 16)												\
+			| ((AB) ? (EXPAND( v, AS, AB ) << 24) : 0xFF000000);						\
+	}																					\
+}
+
+//! 32bitから16bitへ変換する関数を定義する
+#define DEFINE_COMPRESS_FUNC(name, RS, RB, GS, GB, BS, BB, AS, AB)						\
+static void																				\
+name( uint16_t* pnDest, const uint32_t* pnSrc, uint32_t nCount )						\
+{																						\
+	uint32_t i;																			\
+	for(i = 0; i < nCount; i++) {														\
+		const uint32_t v = pnSrc[i];													\
+		pnDest[i] = (uint16_t)(COMPRESS( v, 0, RS, RB )									\
+			| COMPRESS( v,  8, GS, GB )													\
+			| COMPRESS( v, 16, BS, BB )													\
+			| ((AB) ? COMPRESS( v, 24, AS, AB ) : 0));									\
+	}																					\
+}
+
+DEFINE_EXPAND_FUNC( Expand5650,     0, 5,  5, 6, 11, 5,  0, 0 )
+DEFINE_EXPAND_FUNC( Expand5551,     0, 5,  5, 5, 10, 5, 15, 1 )
+DEFINE_EXPAND_FUNC( Expand4444,     0, 4,  4, 4,  8, 4, 12, 4 )
+DEFINE_COMPRESS_FUNC( Compress5650, 0, 5,  5, 6, 11, 5,  0, 0 )
+DEFINE_COMPRESS_FUNC( Compress5551, 0, 5,  5, 5, 10, 5, 15, 1 )
+DEFINE_COMPRESS_FUNC( Compress4444, 0, 4,  4, 4,  8, 4, 12, 4 )
+
+#if defined(USE_CAT_COLORCONVERT_SSE2)
+
+//! 1チャンネルを8bitに広げる(SSE2)
+static __m128i
+ExpandChannelSSE2( __m128i v, uint32_t nShift, uint32_t nBits, uint32_t nPos )
+{
+	const __m128i c  = _mm_and_si128( _mm_srl_epi32( v, _mm_cvtsi32_si128( nShift ) ), _mm_set1_epi32( (1 << nBits) - 1 ) );
+	const __m128i nz = _mm_cmpgt_epi32( c, _mm_setzero_si128() );
+	const __m128i r  = _mm_or_si128( _mm_sll_epi32( c, _mm_cvtsi32_si128( 8 - nBits ) ),
+		_mm_and_si128( nz, _mm_set1_epi32( (1 << (8 - nBits)) - 1 ) ) );
+	return _mm_sll_epi32( r, _mm_cvtsi32_si128( nPos ) );
+}
+
+//! 4ピクセルを32bitに広げる(SSE2)
+static __m128i
+Expand4SSE2( __m128i v, const Layout* pLayout )
+{
+	__m128i r = ExpandChannelSSE2( v, pLayout->nShift[0], pLayout->nBits[0], 0 );
+	r = _mm_or_si128( r, ExpandChannelSSE2( v, pLayout->nShift[1], pLayout->nBits[1], 8 ) );
+	r = _mm_or_si128( r, ExpandChannelSSE2( v, pLayout->nShift[2], pLayout->nBits[2], 16 ) );
+	if(pLayout->nBits[3]) {
+		r = _mm_or_si128( r, ExpandChannelSSE2( v, pLayout->nShift[3], pLayout->nBits[3], 24 ) );
+	} else {
+		r = _mm_or_si128( r, _mm_set1_epi32( (int)0xFF000000 ) );
+	}
+	return r;
+}
+
+//! 16bitから32bitへ変換する(SSE2)
+/*!
+	@return	変換した色数(8の倍数)
+*/
+static uint32_t
+ExpandSIMD( uint32_t* pnDest, const uint16_t* pnSrc, uint32_t nCount, const Layout* pLayout )
+{
+	const __m128i zero = _mm_setzero_si128();
+	uint32_t i;
+
+	for(i = 0; i + 8 <= nCount; i += 8) {
+		const __m128i v = _mm_loadu_si128( (const __m128i*)(pnSrc + i) );
+		_mm_storeu_si128( (__m128i*)(pnDest + i),     Expand4SSE2( _mm_unpacklo_epi16( v, zero ), pLayout ) );
+		_mm_storeu_si128( (__m128i*)(pnDest + i + 4), Expand4SSE2( _mm_unpackhi_epi16( v, zero ), pLayout ) );
+	}
+	return i;
+}
+
+//! 4ピクセルを16bitに縮める(SSE2)
+static __m128i
+Compress4SSE2( __m128i v, const Layout* pLayout )
+{
+	__m128i r = _mm_setzero_si128();
+	uint32_t k;
+
+	for(k = 0; k < 4; k++) {
+		if(pLayout->nBits[k]) {
+			const __m128i c = _mm_and_si128( _mm_srl_epi32( v, _mm_cvtsi32_si128( k * 8 + 8 - pLayout->nBits[k] ) ),
+				_mm_set1_epi32( (1 << pLayout->nBits[k]) - 1 ) );
+			r = _mm_or_si128( r, _mm_sll_epi32( c, _mm_cvtsi32_si128( pLayout->nShift[k] ) ) );
+		}
+	}
+	return r;
+}
+
+//! 32bitから16bitへ変換する(SSE2)
+/*!
+	@return	変換した色数(8の倍数)
+*/
+static uint32_t
+CompressSIMD( uint16_t* pnDest, const uint32_t* pnSrc, uint32_t nCount, const Layout* pLayout )
+{
+	const __m128i bias32 = _mm_set1_epi32( 0x8000 );
+	const __m128i bias16 = _mm_set1_epi16( (short)0x8000 );
+	uint32_t i;
+
+	for(i = 0; i + 8 <= nCount; i += 8) {
+		// SSE2には符号なしのパックがないので、符号付きの範囲にずらしてパックする
+		const __m128i lo = _mm_sub_epi32( Compress4SSE2( _mm_loadu_si128( (const __m128i*)(pnSrc + i) ),     pLayout ), bias32 );
+		const __m128i hi = _mm_sub_epi32( Compress4SSE2( _mm_loadu_si128( (const __m128i*)(pnSrc + i + 4) ), pLayout ), bias32 );
+		_mm_storeu_si128( (__m128i*)(pnDest + i), _mm_add_epi16( _mm_packs_epi32( lo, hi ), bias16 ) );
+	}
+	return i;
+}
+
+#elif defined(USE_CAT_COLORCONVERT_NEON)
+
+//! 1チャンネルを8bitに広げる(NEON)
+static uint32x4_t
+ExpandChannelNEON( uint32x4_t v, uint32_t nShift, uint32_t nBits, uint32_t nPos )
+{
+	const uint32x4_t c  = vandq_u32( vshlq_u32( v, vdupq_n_s32( -(int32_t)nShift ) ), vdupq_n_u32( (1U << nBits) - 1 ) );
+	const uint32x4_t nz = vcgtq_u32( c, vdupq_n_u32( 0 ) );
+	const uint32x4_t r  = vorrq_u32( vshlq_u32( c, vdupq_n_s32( (int32_t)(8 - nBits) ) ),
+		vandq_u32( nz, vdupq_n_u32( (1U << (8 - nBits)) - 1 ) ) );
+	return vshlq_u32( r, vdupq_n_s32( (int32_t)nPos ) );
+}
+
+//! 4ピクセルを32bitに広げる(NEON)
+static uint32x4_t
+Expand4NEON( uint32x4_t v, const Layout* pLayout )
+{
+	uint32x4_t r = ExpandChannelNEON( v, pLayout->nShift[0], pLayout->nBits[0], 0 );
+	r = vorrq_u32( r, ExpandChannelNEON( v, pLayout->nShift[1], pLayout->nBits[1], 8 ) );
+	r = vorrq_u32( r, ExpandChannelNEON( v, pLayout->nShift[2], pLayout->nBits[2], 16 ) );
+	if(pLayout->nBits[3]) {
+		r = vorrq_u32( r, ExpandChannelNEON( v, pLayout->nShift[3], pLayout->nBits[3], 24 ) );
+	} else {
+		r = vorrq_u32( r, vdupq_n_u32( 0xFF000000 ) );
+	}
+	return r;
+}
+
+//! 16bitから32bitへ変換する(NEON)
+/*!
+	@return	変換した色数(8の倍数)
+*/
+static uint32_t
+ExpandSIMD( uint32_t* pnDest, const uint16_t* pnSrc, uint32_t nCount, const Layout* pLayout )
+{
+	uint32_t i;
+
+	for(i = 0; i + 8 <= nCount; i += 8) {
+		const uint16x8_t v = vld1q_u16( pnSrc + i );
+		vst1q_u32( pnDest + i,     Expand4NEON( vmovl_u16( vget_low_u16( v ) ),  pLayout ) );
+		vst1q_u32( pnDest + i + 4, Expand4NEON( vmovl_u16( vget_high_u16( v ) ), pLayout ) );
+	}
+	return i;
+}
+
+//! 4ピクセルを16bitに縮める(NEON)
+static uint16x4_t
+Compress4NEON( uint32x4_t v, const Layout* pLayout )
+{
+	uint32x4_t r = vdupq_n_u32( 0 );
+	uint32_t k;
+
+	for(k = 0; k < 4; k++) {
+		if(pLayout->nBits[k]) {
+			const uint32x4_t c = vandq_u32( vshlq_u32( v, vdupq_n_s32( -(int32_t)(k * 8 + 8 - pLayout->nBits[k]) ) ),
+				vdupq_n_u32( (1U << pLayout->nBits[k]) - 1 ) );
+			r = vorrq_u32( r, vshlq_u32( c, vdupq_n_s32( (int32_t)pLayout->nShift[k] ) ) );
+		}
+	}
+	return vmovn_u32( r );
+}
+
+//! 32bitから16bitへ変換する(NEON)
+/*!
+	@return	変換した色数(8の倍数)
+*/
+static uint32_t
+CompressSIMD( uint16_t* pnDest, const uint32_t* pnSrc, uint32_t nCount, const Layout* pLayout )
+{
+	uint32_t i;
+
+	for(i = 0; i + 8 <= nCount; i += 8) {
+		const uint16x4_t lo = Compress4NEON( vld1q_u32( pnSrc + i ),     pLayout );
+		const uint16x4_t hi = Compress4NEON( vld1q_u32( pnSrc + i + 4 ), pLayout );
+		vst1q_u16( pnDest + i, vcombine_u16( lo, hi ) );
+	}
+	return i;
+}
+
+#else
+
+//! 16bitから32bitへ変換する(SIMDなし)
+static uint32_t
+ExpandSIMD( uint32_t* pnDest, const uint16_t* pnSrc, uint32_t nCount, const Layout* pLayout )
+{
+	(void)pnDest;
+	(void)pnSrc;
+	(void)nCount;
+	(void)pLayout;
+	return 0;
+}
+
+//! 32bitから16bitへ変換する(SIMDなし)
+static uint32_t
+CompressSIMD( uint16_t* pnDest, const uint32_t* pnSrc, uint32_t nCount, const Layout* pLayout )
+{
+	(void)pnDest;
+	(void)pnSrc;
+	(void)nCount;
+	(void)pLayout;
+	return 0;
+}
+
+#endif
+
+//! 16bitから32bitへ変換する
+/*!
+	SIMDで変換できなかった端数をスカラー版で変換する。
+*/
+static void
+Expand( uint32_t* pnDest, const uint16_t* pnSrc, uint32_t nCount, FORMAT_PIXEL eSrcFormat )
+{
+	uint32_t i;
+
+	switch(eSrcFormat) {
+		case FORMAT_PIXEL_5650:
+			i = ExpandSIMD( pnDest, pnSrc, nCount, &layout5650 );
+			Expand5650( pnDest + i, pnSrc + i, nCount - i );
+			break;
+		case FORMAT_PIXEL_5551:
+			i = ExpandSIMD( pnDest, pnSrc, nCount, &layout5551 );
+			Expand5551( pnDest + i, pnSrc + i, nCount - i );
+			break;
+		case FORMAT_PIXEL_4444:
+		default:
+			i = ExpandSIMD( pnDest, pnSrc, nCount, &layout4444 );
+			Expand4444( pnDest + i, pnSrc + i, nCount - i );
+			break;
+	}
+}
+
+//! 32bitから16bitへ変換する
+/*!
+	SIMDで変換できなかった端数をスカラー版で変換する。
+*/
+static void
+Compress( uint16_t* pnDest, const uint32_t* pnSrc, uint32_t nCount, FORMAT_PIXEL eDestFormat )
+{
+	uint32_t i;
+
+	switch(eDestFormat) {
+		case FORMAT_PIXEL_5650:
+			i = CompressSIMD( pnDest, pnSrc, nCount, &layout5650 );
+			Compress5650( pnDest + i, pnSrc + i, nCount - i );
+			break;
+		case FORMAT_PIXEL_5551:
+			i = CompressSIMD( pnDest, pnSrc, nCount, &layout5551 );
+			Compress5551( pnDest + i, pnSrc + i, nCount - i );
+			break;
+		case FORMAT_PIXEL_4444:
+		default:
+			i = CompressSIMD( pnDest, pnSrc, nCount, &layout4444 );
+			Compress4444( pnDest + i, pnSrc + i, nCount - i );
+			break;
+	}
+}
+
+//! RGBA8888からRGBA5650へ変換する
+uint16_t
+Cat_ColorConvert8888To5650( uint32_t rgba8888 )
+{
+	uint16_t rc;
+	Compress5650( &rc, &rgba8888, 1 );
+	return rc;
+}
+
+//! RGBA8888からRGBA5551へ変換する
+uint16_t
+Cat_ColorConvert8888To5551( uint32_t rgba8888 )
+{
+	uint16_t rc;
+	Compress5551( &rc, &rgba8888, 1 );
+	return rc;
+}
+
+//! RGBA8888からRGBA4444へ変換する
+uint16_t
+Cat_ColorConvert8888To4444( uint32_t rgba8888 )
+{
+	uint16_t rc;
+	Compress4444( &rc, &rgba8888, 1 );
+	return rc;
+}
+
+//! 色の配列をまとめて変換する
+/*!
+	8888,5650,5551,4444の間で変換する。 \n
+	16bitから32bitへの変換は、Cat_ColorConvert5650To8888()などと同じ結果になる。 \n
+	32bitから16bitへの変換は、下位ビットを切り捨てる。 \n
+	\a pvDest と \a pvSrc が同じ場合は、16bit同士の変換のみ可能。
+	@param[out]	pvDest			変換先
+	@param[in]	eDestFormat		変換先のフォーマット(FORMAT_PIXEL_8888/5650/5551/4444)
+	@param[in]	pvSrc			変換元
+	@param[in]	eSrcFormat		変換元のフォーマット(FORMAT_PIXEL_8888/5650/5551/4444)
+	@param[in]	nCount			変換する色数
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+int32_t
+Cat_ColorConvert( void* pvDest, FORMAT_PIXEL eDestFormat, const void* pvSrc, FORMAT_PIXEL eSrcFormat, uint32_t nCount )
+{
+	if((pvDest == 0) || (pvSrc == 0)) {
+		return -1;
+	}
+	if((eDestFormat > FORMAT_PIXEL_8888) || (eSrcFormat > FORMAT_PIXEL_8888)) {
+		return -1;	// 対応していないフォーマット
+	}
+
+	if(eDestFormat == eSrcFormat) {
+		// 同じフォーマット
+		if(pvDest != pvSrc) {
+			memmove( pvDest, pvSrc, nCount * ((eSrcFormat == FORMAT_PIXEL_8888) ? 4 : 2) );
+		}
+	} else if(eDestFormat == FORMAT_PIXEL_8888) {
+		Expand( (uint32_t*)pvDest, (const uint16_t*)pvSrc, nCount, eSrcFormat );
+	} else if(eSrcFormat == FORMAT_PIXEL_8888) {
+		Compress( (uint16_t*)pvDest, (const uint32_t*)pvSrc, nCount, eDestFormat );
+	} else {
+		// 16bit同士は、32bitを経由する
+		uint32_t nWork[CAT_COLORCONVERT_WORK];
+		const uint16_t* pnSrc = (const uint16_t*)pvSrc;
+		uint16_t* pnDest = (uint16_t*)pvDest;
+		while(nCount) {
+			const uint32_t n = (nCount < CAT_COLORCONVERT_WORK) ? nCount : CAT_COLORCONVERT_WORK;
+			Expand( nWork, pnSrc, n, eSrcFormat );
+			Compress( pnDest, nWork, n, eDestFormat );
+			pnSrc  += n;
+			pnDest += n;
+			nCount -= n;
+		}
+	}
+	return 0;
+}
+
+//! パレットのフォーマットを変換した複製を作成する
+/*!
+	@param[in]	pPalette		変換元のパレット
+	@param[in]	ePaletteFormat	変換先のパレットフォーマット
+	@return	作成されたパレット。失敗した場合は0が返る。
+*/
+Cat_Palette*
+Cat_PaletteConvert( const Cat_Palette* pPalette, FORMAT_PALETTE ePaletteFormat )
+{
+	Cat_Palette* rc;
+
+	if(pPalette == 0) {
+		return 0;
+	}
+	rc = Cat_PaletteCreate( ePaletteFormat, pPalette->nMask + 1, 0 );
+	if(rc == 0) {
+		return 0;
+	}
+	// パレットフォーマットとピクセルフォーマットは同じ値
+	if(Cat_ColorConvert( rc->pvData, (FORMAT_PIXEL)ePaletteFormat,
+			pPalette->pvData, (FORMAT_PIXEL)pPalette->ePaletteFormat, pPalette->nMask + 1 ) < 0) {
+		Cat_PaletteRelease( rc );
+		return 0;
+	}
+	Cat_PaletteUpdate( rc );
+	return rc;
+}
@@ -0,0 +1,509 @@
+//! @file	Cat_DisplayList.c
+// 記録して繰り返し使う描画パケット
+
+#include "Cat_DisplayList.h"
+#include "Cat_Render.h"
+#include "Cat_RenderState.h"
+#include "Cat_Texture.h"
+#include <pspgu.h>
+#include <psputils.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>	// for memalign
+
+#ifndef CAT_MALLOC
+//! メモリ確保マクロ
+#define CAT_MALLOC(x) memalign( 64, (x) )
+#endif // CAT_MALLOC
+
+#ifndef CAT_FREE
+//! メモリ解放マクロ
+#define CAT_FREE(x) free( x )
+#endif // CAT_FREE
+
+//! 記録するリストの数(GEが読んでいる方と書き換える方)
+#define CAT_DISPLAYLIST_COPY (2)
+//! リストの後ろに空けておくサイズ(確保の後に積む設定とsceGuDrawArray()、sceGuFinish()の分)
+#define CAT_DISPLAYLIST_MARGIN (1024)
+//! sceGuCallList()で積むサイズ(ベースアドレスとコールの分)
+#define CAT_DISPLAYLIST_CALL_SIZE (8)
+
+//! 頂点(Cat_TextureとCat_SpriteBatchが確保するもの)
+typedef struct {
+	short	u,v;
+	short	x,y,z;
+} __attribute__((packed)) Vertex;
+
+//! 確保した頂点の塊
+typedef struct {
+	Vertex*		pVertex;		/*!< 頂点(リストの中)		*/
+	uint32_t	nCount;			/*!< 頂点の数				*/
+} VertexBlock;
+
+//! 記録したリスト1つ分
+typedef struct {
+	uint8_t*		pbList;									/*!< リストのメモリ								*/
+	VertexBlock*	pBlock;									/*!< 確保した頂点の塊							*/
+	uint32_t		nBlock;									/*!< 頂点の塊の数								*/
+	uint32_t		nBlockMax;								/*!< 確保した頂点の塊の数						*/
+	int16_t*		pnBase;									/*!< 記録した時の頂点の位置(x,yの順)			*/
+	uint32_t		nVertex;								/*!< 頂点の数									*/
+	int32_t			nOffsetX;								/*!< 書き込んであるオフセットX					*/
+	int32_t			nOffsetY;								/*!< 書き込んであるオフセットY					*/
+	Cat_Palette*	apPalette[CAT_DISPLAYLIST_PALETTE_MAX];	/*!< パレットの差し込み口						*/
+	Cat_Palette*	apSource[CAT_DISPLAYLIST_PALETTE_MAX];	/*!< 差し込み口にコピーしてあるパレット			*/
+	uint32_t		anSerial[CAT_DISPLAYLIST_PALETTE_MAX];	/*!< コピーした時のパレットの更新カウンタ		*/
+	uint32_t		nCallFrame;								/*!< 最後に呼んだフレーム						*/
+	int				fCalled;								/*!< 呼んだことがあるかどうか					*/
+} Copy;
+
+//! 記録して繰り返し使う描画パケット
+struct _Cat_DisplayList {
+	uint8_t*					pbBuffer;									/*!< リストのメモリ(全部)			*/
+	uint32_t					nSize;										/*!< リスト1つのサイズ				*/
+	Copy						copy[CAT_DISPLAYLIST_COPY];					/*!< 記録したリスト					*/
+	uint32_t					nRecord;									/*!< 記録しているリストの番号		*/
+	int							fFail;										/*!< 記録に失敗したかどうか			*/
+	uint32_t					nCopy;										/*!< 最後に呼んだリストの番号		*/
+	int32_t						nOffsetX;									/*!< 設定されたオフセットX			*/
+	int32_t						nOffsetY;									/*!< 設定されたオフセットY			*/
+	Cat_Palette*				apPalette[CAT_DISPLAYLIST_PALETTE_MAX];		/*!< 設定されたパレット				*/
+	Cat_Texture**				ppTexture;									/*!< 記録したテクスチャ(固定している)	*/
+	uint32_t					nTexture;									/*!< 記録したテクスチャの数			*/
+	uint32_t					nTextureMax;								/*!< 確保したテクスチャの数			*/
+	Cat_DisplayListStatistics	statistics;									/*!< 統計情報						*/
+	Cat_RenderFrameStatistics	frame;										/*!< 呼んだフレームに加える描画		*/
+};
+
+//! 配列を広げる
+/*!
+	@param[in,out]	ppv		配列
+	@param[in,out]	pnMax	確保している数
+	@param[in]		nCount	必要な数
+	@param[in]		nSize	要素のサイズ
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+static int32_t
+Reserve( void** ppv, uint32_t* pnMax, uint32_t nCount, uint32_t nSize )
+{
+	uint32_t nMax;
+	void* pv;
+
+	if(nCount <= *pnMax) {
+		return 0;
+	}
+	nMax = *pnMax ? *pnMax * 2 : 64;
+	while(nMax < nCount) {
+		nMax *= 2;
+	}
+	pv = realloc( *ppv, nMax * nSize );
+	if(pv == 0) {
+		return -1;
+	}
+	*ppv   = pv;
+	*pnMax = nMax;
+	return 0;
+}
+
+//! 記録している間にCat_RenderGetMemory()から呼ばれて、リストの中に頂点を確保する
+/*!
+	@param[in]	pvContext	リスト
+	@param[in]	nSize		サイズ(バイト単位)
+	@return	確保したメモリ。リストに収まらない場合は0が返る。
+*/
+static void*
+GetMemory( void* pvContext, uint32_t nSize )
+{
+	Cat_DisplayList* pList = (Cat_DisplayList*)pvContext;
+	Copy* pCopy = &pList->copy[pList->nRecord];
+	const uint32_t nNeed = ((nSize + 3) & ~3) + 8 + CAT_DISPLAYLIST_MARGIN;	// 8は、データを飛び越すジャンプの分
+	VertexBlock* pBlock;
+	void* rc;
+
+	if(pList->fFail || ((uint32_t)sceGuCheckList() + nNeed > pList->nSize)) {
+		pList->fFail = 1;
+		return 0;
+	}
+	if(Reserve( (void**)&pCopy->pBlock, &pCopy->nBlockMax, pCopy->nBlock + 1, sizeof(VertexBlock) ) < 0) {
+		pList->fFail = 1;
+		return 0;
+	}
+	rc = sceGuGetMemory( (int)nSize );
+	pBlock = &pCopy->pBlock[pCopy->nBlock++];
+	pBlock->pVertex = (Vertex*)rc;
+	pBlock->nCount  = nSize / sizeof(Vertex);
+	pCopy->nVertex += pBlock->nCount;
+	return rc;
+}
+
+//! 記録している間にCat_Textureから呼ばれて、使ったテクスチャを固定する
+/*!
+	リストはピクセルデータのアドレスを持ち続けるので、破棄するまで解放されないようにする。
+	@param[in]	pvContext	リスト
+	@param[in]	pTexture	設定したテクスチャ
+*/
+static void
+RecordTexture( void* pvContext, Cat_Texture* pTexture )
+{
+	Cat_DisplayList* pList = (Cat_DisplayList*)pvContext;
+	uint32_t i;
+
+	for(i = 0; i < pList->nTexture; i++) {
+		if(pList->ppTexture[i] == pTexture) {
+			return;
+		}
+	}
+	if(Reserve( (void**)&pList->ppTexture, &pList->nTextureMax, pList->nTexture + 1, sizeof(Cat_Texture*) ) < 0) {
+		pList->fFail = 1;
+		return;
+	}
+	Cat_TexturePin( pTexture );
+	pList->ppTexture[pList->nTexture++] = pTexture;
+}
+
+//! 記録した頂点の位置を覚えておく
+/*!
+	@param[in,out]	pCopy	記録したリスト
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+static int32_t
+SaveBase( Copy* pCopy )
+{
+	int16_t* pn;
+	uint32_t i;
+	uint32_t j;
+
+	if(pCopy->nVertex == 0) {
+		return 0;
+	}
+	pCopy->pnBase = (int16_t*)malloc( pCopy->nVertex * 2 * sizeof(int16_t) );
+	if(pCopy->pnBase == 0) {
+		return -1;
+	}
+	pn = pCopy->pnBase;
+	for(i = 0; i < pCopy->nBlock; i++) {
+		const Vertex* pVertex = pCopy->pBlock[i].pVertex;
+		for(j = 0; j < pCopy->pBlock[i].nCount; j++) {
+			*pn++ = pVertex[j].x;
+			*pn++ = pVertex[j].y;
+		}
+	}
+	return 0;
+}
+
+//! リストを1つ記録する
+/*!
+	@param[in]	pList		リスト
+	@param[in]	nRecord		記録するリストの番号
+	@param[in]	pfnRecord	記録する関数
+	@param[in]	pvContext	\a pfnRecord に渡す値
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+static int32_t
+Record( Cat_DisplayList* pList, uint32_t nRecord, Cat_DisplayListRecordFunc pfnRecord, void* pvContext )
+{
+	Copy* pCopy = &pList->copy[nRecord];
+	Cat_RenderFrameStatistics before;
+	Cat_RenderFrameStatistics after;
+	uint32_t nSize;
+
+	pList->nRecord = nRecord;
+	pList->fFail   = 0;
+	// 1つのリストだけで描画できるように、設定は全部積む
+	Cat_RenderStateInvalidate();
+	Cat_RenderSetMemoryFunc( GetMemory, pList );
+	Cat_TextureSetRecordFunc( RecordTexture, pList );
+	Cat_RenderGetFrameStatistics( CAT_RENDER_FRAME_CURRENT, &before );
+	sceGuStart( GU_CALL, (void*)((uintptr_t)pCopy->pbList | 0x40000000) ); {
+		pfnRecord( pList, pvContext );
+	} nSize = (uint32_t)sceGuFinish();
+	Cat_RenderGetFrameStatistics( CAT_RENDER_FRAME_CURRENT, &after );
+	Cat_TextureSetRecordFunc( 0, 0 );
+	Cat_RenderSetMemoryFunc( 0, 0 );
+	Cat_RenderStateInvalidate();
+
+	if(pList->fFail || (nSize > pList->nSize)) {
+		return -1;
+	}
+	pList->statistics.nSize        = nSize;
+	pList->statistics.nVertexCount = pCopy->nVertex;
+	// 記録した描画は、呼んだフレームで数える(Cat_RenderBegin()の外なので、作成中のフレームは次で消される)
+	pList->frame.nDrawCount    = after.nDrawCount - before.nDrawCount;
+	pList->frame.nVertexCount  = after.nVertexCount - before.nVertexCount;
+	pList->frame.nPixelCount   = after.nPixelCount - before.nPixelCount;
+	pList->frame.nTextureCount = after.nTextureCount - before.nTextureCount;
+	pList->frame.nPaletteCount = after.nPaletteCount - before.nPaletteCount;
+	pList->frame.nListSize     = nSize;
+	return SaveBase( pCopy );
+}
+
+//! 作成して記録する
+/*!
+	Cat_RenderBegin()とCat_RenderEnd()の外で呼ぶ。 \n
+	\a pfnRecord を2回呼んで、それぞれの描画をリストに記録する。
+	@param[in]	nSize		リスト1つのサイズ(バイト単位)
+	@param[in]	pfnRecord	記録する関数
+	@param[in]	pvContext	\a pfnRecord に渡す値
+	@return	作成されたリスト。失敗した場合(記録が \a nSize に収まらない場合を含む)は0が返る。
+	@see	Cat_DisplayListDestroy()
+*/
+Cat_DisplayList*
+Cat_DisplayListCreate( uint32_t nSize, Cat_DisplayListRecordFunc pfnRecord, void* pvContext )
+{
+	Cat_DisplayList* rc;
+	uint32_t nStride;
+	uint32_t i;
+
+	if((pfnRecord == 0) || (nSize < CAT_DISPLAYLIST_MARGIN * 2)) {
+		return 0;
+	}
+	rc = (Cat_DisplayList*)malloc( sizeof(Cat_DisplayList) );
+	if(rc == 0) {
+		return 0;
+	}
+	memset( rc, 0, sizeof(Cat_DisplayList) );
+	// 後ろの余白は、最後の確保の後に積まれた分が溢れても壊さないように取っておく
+	nStride = (nSize + CAT_DISPLAYLIST_MARGIN + 63) & ~63;
+	rc->nSize    = nSize;
+	rc->pbBuffer = (uint8_t*)CAT_MALLOC( nStride * CAT_DISPLAYLIST_COPY );
+	if(rc->pbBuffer == 0) {
+		free( rc );
+		return 0;
+	}
+	// リストはキャッシュを通さずに書くので、キャッシュに残っている分を捨てておく
+	sceKernelDcacheWritebackInvalidateRange( rc->pbBuffer, nStride * CAT_DISPLAYLIST_COPY );
+	for(i = 0; i < CAT_DISPLAYLIST_COPY; i++) {
+		rc->copy[i].pbList = rc->pbBuffer + nStride * i;
+		if(Record( rc, i, pfnRecord, pvContext ) < 0) {
+			Cat_DisplayListDestroy( rc );
+			return 0;
+		}
+	}
+	// 呼び出す時は、まだ設定されていない差し込み口も記録した時のパレットを使う
+	for(i = 0; i < CAT_DISPLAYLIST_PALETTE_MAX; i++) {
+		rc->apPalette[i] = rc->copy[0].apSource[i];
+	}
+	return rc;
+}
+
+//! 破棄する
+/*!
+	GEが描画し終わってから呼ぶこと。記録したテクスチャの固定も外す。
+	@param[in]	pList	リスト
+*/
+void
+Cat_DisplayListDestroy( Cat_DisplayList* pList )
+{
+	uint32_t i;
+	uint32_t j;
+
+	if(pList == 0) {
+		return;
+	}
+	for(i = 0; i < CAT_DISPLAYLIST_COPY; i++) {
+		Copy* pCopy = &pList->copy[i];
+		for(j = 0; j < CAT_DISPLAYLIST_PALETTE_MAX; j++) {
+			Cat_PaletteRelease( pCopy->apPalette[j] );
+		}
+		free( pCopy->pBlock );
+		free( pCopy->pnBase );
+	}
+	for(i = 0; i < pList->nTexture; i++) {
+		Cat_TextureUnpin( pList->ppTexture[i] );
+	}
+	free( pList->ppTexture );
+	CAT_FREE( pList->pbBuffer );
+	free( pList );
+}
+
+//! 記録する時に、パレットの差し込み口を取得する
+/*!
+	記録する関数の中で呼び、返ったパレットで描画する(Cat_SpriteBatchSprite.pPaletteなど)。 \n
+	返るパレットはリストが持っていて、Cat_DisplayListSetPalette()で色を差し替える。
+	@param[in]	pList		記録しているリスト
+	@param[in]	nSlot		差し込み口の番号(0～CAT_DISPLAYLIST_PALETTE_MAX-1)
+	@param[in]	pPalette	最初の色(フォーマットと数もこれに合わせる)
+	@return	描画に使うパレット。失敗した場合は0が返る。
+*/
+Cat_Palette*
+Cat_DisplayListGetPalette( Cat_DisplayList* pList, uint32_t nSlot, Cat_Palette* pPalette )
+{
+	Copy* pCopy;
+
+	if((pList == 0) || (nSlot >= CAT_DISPLAYLIST_PALETTE_MAX) || (pPalette == 0)) {
+		return 0;
+	}
+	pCopy = &pList->copy[pList->nRecord];
+	if(pCopy->apPalette[nSlot] == 0) {
+		pCopy->apPalette[nSlot] = Cat_PaletteDuplicate( pPalette );
+		if(pCopy->apPalette[nSlot] == 0) {
+			pList->fFail = 1;
+			return 0;
+		}
+		Cat_PaletteUpdate( pCopy->apPalette[nSlot] );
+		pCopy->apSource[nSlot] = pPalette;
+		pCopy->anSerial[nSlot] = pPalette->nSerial;
+	}
+	return pCopy->apPalette[nSlot];
+}
+
+//! オフセットを設定する
+/*!
+	記録した位置からずらして描画する。
+	@param[in]	pList	リスト
+	@param[in]	x		横のずらし(ドット単位)
+	@param[in]	y		縦のずらし(ドット単位)
+*/
+void
+Cat_DisplayListSetOffset( Cat_DisplayList* pList, int32_t x, int32_t y )
+{
+	if(pList == 0) {
+		return;
+	}
+	pList->nOffsetX = x;
+	pList->nOffsetY = y;
+}
+
+//! パレットを差し替える
+/*!
+	色をコピーするのは次のCat_DisplayListCall()なので、それまで \a pPalette は解放しないこと。 \n
+	Cat_PaletteUpdate()で更新カウンタが変わった場合も、コピーし直す。
+	@param[in]	pList		リスト
+	@param[in]	nSlot		差し込み口の番号
+	@param[in]	pPalette	パレット(Cat_DisplayListGetPalette()で渡したものとフォーマットと数が同じもの)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+int32_t
+Cat_DisplayListSetPalette( Cat_DisplayList* pList, uint32_t nSlot, Cat_Palette* pPalette )
+{
+	const Cat_Palette* pSlot;
+
+	if((pList == 0) || (nSlot >= CAT_DISPLAYLIST_PALETTE_MAX) || (pPalette == 0)) {
+		return -1;
+	}
+	pSlot = pList->copy[0].apPalette[nSlot];
+	if((pSlot == 0) || (pSlot->ePaletteFormat != pPalette->ePaletteFormat) || (pSlot->nSize != pPalette->nSize)) {
+		return -1;
+	}
+	pList->apPalette[nSlot] = pPalette;
+	return 0;
+}
+
+//! 設定された値をリストに書き込む
+/*!
+	@param[in]	pList	リスト
+	@param[in]	pCopy	書き込むリスト(GEが読んでいないもの)
+*/
+static void
+Patch( Cat_DisplayList* pList, Copy* pCopy )
+{
+	uint32_t i;
+	uint32_t j;
+
+	if((pCopy->nOffsetX != pList->nOffsetX) || (pCopy->nOffsetY != pList->nOffsetY)) {
+		// 頂点はキャッシュを通さないので、読まずに記録した時の位置から書く
+		const int16_t* pn = pCopy->pnBase;
+		const int32_t x = pList->nOffsetX;
+		const int32_t y = pList->nOffsetY;
+
+		for(i = 0; i < pCopy->nBlock; i++) {
+			Vertex* pVertex = pCopy->pBlock[i].pVertex;
+			for(j = 0; j < pCopy->pBlock[i].nCount; j++) {
+				pVertex[j].x = (short)(pn[0] + x);
+				pVertex[j].y = (short)(pn[1] + y);
+				pn += 2;
+			}
+		}
+		pCopy->nOffsetX = x;
+		pCopy->nOffsetY = y;
+		pList->statistics.nPatchCount++;
+		pList->statistics.nPatchVertexCount += pCopy->nVertex;
+	}
+	for(i = 0; i < CAT_DISPLAYLIST_PALETTE_MAX; i++) {
+		Cat_Palette* pSource = pList->apPalette[i];
+		if((pSource == 0) || ((pCopy->apSource[i] == pSource) && (pCopy->anSerial[i] == pSource->nSerial))) {
+			continue;
+		}
+		memcpy( pCopy->apPalette[i]->pvData, pSource->pvData, pSource->nSize * 32 );
+		Cat_PaletteUpdate( pCopy->apPalette[i] );
+		// 4bitに変換されたテクスチャは、差し込み口から作った16色のパレットを引いているので作り直す
+		for(j = 0; j < pList->nTexture; j++) {
+			Cat_TextureRefreshPalette( pList->ppTexture[j], pCopy->apPalette[i] );
+		}
+		pCopy->apSource[i] = pSource;
+		pCopy->anSerial[i] = pSource->nSerial;
+		pList->statistics.nPatchCount++;
+	}
+}
+
+//! 記録したリストを呼ぶ
+/*!
+	Cat_RenderBegin()とCat_RenderEnd()の間で呼ぶ。 \n
+	リストが描画の設定を変えるので、呼んだ後はCat_RenderStateの記録を捨てる。
+	@param[in]	pList	リスト
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+int32_t
+Cat_DisplayListCall( Cat_DisplayList* pList )
+{
+	const uint32_t nFrame = Cat_RenderGetFrame();
+	Copy* pCopy;
+
+	if(pList == 0) {
+		return -1;
+	}
+	if(Cat_RenderReserve( CAT_DISPLAYLIST_CALL_SIZE ) < 0) {
+		pList->statistics.nOverflowCount++;
+		return -1;
+	}
+	// 同じフレームで呼んだリストは、まだGEに渡していないのでそのまま使う。
+	// 前のフレームで呼んだリストはGEが読んでいるかもしれないので、もう1つの方を書き換えて使う。
+	pCopy = &pList->copy[pList->nCopy];
+	if(!pCopy->fCalled || (pCopy->nCallFrame != nFrame)) {
+		pList->nCopy ^= 1;
+		pCopy = &pList->copy[pList->nCopy];
+	}
+	Patch( pList, pCopy );
+	pCopy->nCallFrame = nFrame;
+	pCopy->fCalled    = 1;
+
+	sceGuCallList( (void*)((uintptr_t)pCopy->pbList | 0x40000000) );
+	Cat_RenderStateInvalidate();
+	Cat_RenderAddFrameStatistics( &pList->frame );
+	pList->statistics.nCallCount++;
+	return 0;
+}
+
+//! 統計情報を取得する
+/*!
+	@param[in]	pList			リスト
+	@param[out]	pStatistics		統計情報
+*/
+void
+Cat_DisplayListGetStatistics( Cat_DisplayList* pList, Cat_DisplayListStatistics* pStatistics )
+{
+	if(pList && pStatistics) {
+		*pStatistics = pList->statistics;
+	}
+}
+
+//! 統計情報をクリアする
+/*!
+	記録したリストのサイズと頂点の数は残る。
+	@param[in]	pList	リスト
+*/
+void
+Cat_DisplayListResetStatistics( Cat_DisplayList* pList )
+{
+	if(pList) {
+		pList->statistics.nCallCount        = 0;
+		pList->statistics.nPatchCount       = 0;
+		pList->statistics.nPatchVertexCount = 0;
+		pList->statistics.nOverflowCount    = 0;
+	}
+}
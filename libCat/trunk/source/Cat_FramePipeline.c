@@ -0,0 +1,535 @@
+//! @file	Cat_FramePipeline.c
+// ゲームの処理と描画を別のスレッドで行う
+
+#include "Cat_FramePipeline.h"
+#include "Cat_Render.h"
+#include <pspkernel.h>
+#include <pspdisplay.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>	// for memalign
+#ifdef __psp__
+#include <pspintrman.h>
+#else
+#include <pthread.h>
+#endif
+
+#ifndef CAT_MALLOC
+//! メモリ確保マクロ
+#define CAT_MALLOC(x) memalign( 64, (x) )
+#endif // CAT_MALLOC
+
+#ifndef CAT_FREE
+//! メモリ解放マクロ
+#define CAT_FREE(x) free( x )
+#endif // CAT_FREE
+
+//! スナップショットの数(書いているもの、渡したもの、描画しているもの)
+#define CAT_FRAMEPIPELINE_SNAPSHOT_COUNT (3)
+//! 渡したスナップショットの番号のマスク
+#define CAT_FRAMEPIPELINE_STATE_INDEX (0x3)
+//! 渡したスナップショットがまだ描画されていない
+#define CAT_FRAMEPIPELINE_STATE_FRESH (0x4)
+//! パレットの色数
+#define CAT_FRAMEPIPELINE_PALETTE_COLOR (256)
+//! 描画するスレッドのスタックサイズ
+#define CAT_FRAMEPIPELINE_STACK_SIZE (64 * 1024)
+
+//! ゲームの処理と描画を別のスレッドで行う
+struct _Cat_FramePipeline {
+	Cat_FrameSnapshot			aSnapshot[CAT_FRAMEPIPELINE_SNAPSHOT_COUNT];	/*!< スナップショット						*/
+	uint32_t*					pnPaletteData;									/*!< パレットのデータ(全部)					*/
+	Cat_Palette					aPalette[2][CAT_FRAMEPIPELINE_PALETTE_MAX];		/*!< 描画に使うパレット(フレームの偶奇)		*/
+	Cat_SpriteBatch*			pBatch;											/*!< バッチ									*/
+	Cat_FramePipelineDrawFunc	pfnDraw;										/*!< スプライトの後に描画する関数			*/
+	void*						pvContext;										/*!< pfnDrawに渡す値						*/
+	volatile uint32_t			nState;											/*!< 渡したスナップショットの番号と状態		*/
+	uint32_t					nBack;											/*!< 書いているスナップショットの番号		*/
+	uint32_t					nFront;											/*!< 描画しているスナップショットの番号		*/
+	int							fWriting;										/*!< 書いている途中かどうか					*/
+	uint32_t					nSubmitCount;									/*!< Cat_FramePipelineSubmit()した回数		*/
+	volatile uint32_t			nQuit;											/*!< 描画するスレッドを止めるかどうか		*/
+	volatile uint32_t			nResetRequest;									/*!< 描画側の統計情報をクリアするかどうか	*/
+	int							fThread;										/*!< 描画するスレッドが動いているかどうか	*/
+#ifdef __psp__
+	SceUID						thid;											/*!< 描画するスレッド						*/
+#else
+	pthread_t					thread;											/*!< 描画するスレッド						*/
+#endif
+	Cat_FramePipelineStatistics	statistics;										/*!< 統計情報								*/
+};
+
+//! 値を不可分に入れ替える
+/*!
+	@param[in,out]	pn	入れ替える場所
+	@param[in]		n	新しい値
+	@return	前の値
+*/
+static uint32_t
+Exchange( volatile uint32_t* pn, uint32_t n )
+{
+#ifdef __psp__
+	// CPUは1つなので、割り込みを止めている間に入れ替えれば、他のスレッドから途中の値は見えない
+	const int nIntr = sceKernelCpuSuspendIntr();
+	const uint32_t rc = *pn;
+	*pn = n;
+	sceKernelCpuResumeIntr( nIntr );
+	return rc;
+#else
+	return __atomic_exchange_n( pn, n, __ATOMIC_ACQ_REL );
+#endif
+}
+
+//! 値を読む
+/*!
+	@param[in]	pn	読む場所
+	@return	値
+*/
+static uint32_t
+Load( volatile uint32_t* pn )
+{
+#ifdef __psp__
+	return *pn;
+#else
+	return __atomic_load_n( pn, __ATOMIC_ACQUIRE );
+#endif
+}
+
+//! 描画側の統計情報をクリアする
+/*!
+	描画するスレッドが書き込む回数と時間だけをクリアする。描画するスレッドから呼ぶ。
+	@param[in,out]	pPipeline	パイプライン
+*/
+static void
+ResetRenderStatistics( Cat_FramePipeline* pPipeline )
+{
+	pPipeline->statistics.nRenderCount   = 0;
+	pPipeline->statistics.nIdleCount     = 0;
+	pPipeline->statistics.nRenderTime    = 0;
+	pPipeline->statistics.nRenderTimeMax = 0;
+	pPipeline->statistics.nLatency       = 0;
+	pPipeline->statistics.nLatencyMax    = 0;
+}
+
+//! 256色、RGBA8888のパレットとして初期化する
+/*!
+	パレットデータはパイプラインが持つので、Cat_PaletteRelease()しない。
+	@param[out]	pPalette	パレット
+	@param[in]	pnData		パレットデータ
+*/
+static void
+InitPalette( Cat_Palette* pPalette, uint32_t* pnData )
+{
+	memset( pPalette, 0, sizeof(Cat_Palette) );
+	pPalette->ePaletteFormat = FORMAT_PALETTE_8888;
+	pPalette->nSize  = CAT_FRAMEPIPELINE_PALETTE_COLOR * 4 / 32;
+	pPalette->nMask  = CAT_FRAMEPIPELINE_PALETTE_COLOR - 1;
+	pPalette->nRef   = 1;
+	pPalette->pvData = pnData;
+}
+
+//! 作成する
+/*!
+	Cat_RenderInit()の後に呼ぶ。
+	@param[in]	nSpriteMax	1フレームのスプライト数
+	@param[in]	pfnDraw		スプライトの後に描画する関数(0の場合は呼ばない)
+	@param[in]	pvContext	\a pfnDraw に渡す値
+	@return	作成されたパイプライン。失敗した場合は0が返る。
+	@see	Cat_FramePipelineDestroy()
+*/
+Cat_FramePipeline*
+Cat_FramePipelineCreate( uint32_t nSpriteMax, Cat_FramePipelineDrawFunc pfnDraw, void* pvContext )
+{
+	Cat_FramePipeline* rc;
+	uint32_t* pnData;
+	uint32_t i;
+	uint32_t j;
+
+	if(nSpriteMax == 0) {
+		return 0;
+	}
+	rc = (Cat_FramePipeline*)malloc( sizeof(Cat_FramePipeline) );
+	if(rc == 0) {
+		return 0;
+	}
+	memset( rc, 0, sizeof(Cat_FramePipeline) );
+	rc->pfnDraw   = pfnDraw;
+	rc->pvContext = pvContext;
+	rc->nBack     = 0;
+	rc->nState    = 1;
+	rc->nFront    = 2;
+
+	// パレットはスナップショットの分と描画に使う分(2フレーム)
+	rc->pnPaletteData = (uint32_t*)CAT_MALLOC( (CAT_FRAMEPIPELINE_SNAPSHOT_COUNT + 2) * CAT_FRAMEPIPELINE_PALETTE_MAX
+		* CAT_FRAMEPIPELINE_PALETTE_COLOR * sizeof(uint32_t) );
+	rc->pBatch = Cat_SpriteBatchCreate( nSpriteMax );
+	if((rc->pnPaletteData == 0) || (rc->pBatch == 0)) {
+		Cat_FramePipelineDestroy( rc );
+		return 0;
+	}
+	pnData = rc->pnPaletteData;
+	for(i = 0; i < CAT_FRAMEPIPELINE_SNAPSHOT_COUNT; i++) {
+		Cat_FrameSnapshot* pSnapshot = &rc->aSnapshot[i];
+		pSnapshot->pSprite = (Cat_SpriteBatchSprite*)malloc( nSpriteMax * sizeof(Cat_SpriteBatchSprite) );
+		if(pSnapshot->pSprite == 0) {
+			Cat_FramePipelineDestroy( rc );
+			return 0;
+		}
+		pSnapshot->nSpriteMax = nSpriteMax;
+		for(j = 0; j < CAT_FRAMEPIPELINE_PALETTE_MAX; j++) {
+			InitPalette( &pSnapshot->aPalette[j], pnData );
+			pnData += CAT_FRAMEPIPELINE_PALETTE_COLOR;
+		}
+	}
+	for(i = 0; i < 2; i++) {
+		for(j = 0; j < CAT_FRAMEPIPELINE_PALETTE_MAX; j++) {
+			InitPalette( &rc->aPalette[i][j], pnData );
+			pnData += CAT_FRAMEPIPELINE_PALETTE_COLOR;
+		}
+	}
+	return rc;
+}
+
+//! 破棄する
+/*!
+	描画するスレッドが動いている場合は、止めてから破棄する。
+	@param[in]	pPipeline	パイプライン
+*/
+void
+Cat_FramePipelineDestroy( Cat_FramePipeline* pPipeline )
+{
+	uint32_t i;
+
+	if(pPipeline == 0) {
+		return;
+	}
+	Cat_FramePipelineStop( pPipeline );
+	for(i = 0; i < CAT_FRAMEPIPELINE_SNAPSHOT_COUNT; i++) {
+		free( pPipeline->aSnapshot[i].pSprite );
+	}
+	Cat_SpriteBatchDestroy( pPipeline->pBatch );
+	if(pPipeline->pnPaletteData) {
+		CAT_FREE( pPipeline->pnPaletteData );
+	}
+	free( pPipeline );
+}
+
+//! 描画するスレッドの処理
+/*!
+	@param[in]	pPipeline	パイプライン
+*/
+static void
+RenderLoop( Cat_FramePipeline* pPipeline )
+{
+	while(!Load( &pPipeline->nQuit )) {
+		if(Cat_FramePipelineRender( pPipeline ) == 0) {
+			// 新しいスナップショットが来るまで、1フレームずつ待つ
+			sceDisplayWaitVblankStart();
+		}
+	}
+}
+
+#ifdef __psp__
+//! 描画するスレッド
+/*!
+	@param[in]	nArgs	引数のサイズ
+	@param[in]	pvArgs	パイプラインのアドレス
+	@return	0
+*/
+static int
+RenderThread( SceSize nArgs, void* pvArgs )
+{
+	RenderLoop( *(Cat_FramePipeline**)pvArgs );
+	return 0;
+}
+#else
+//! 描画するスレッド
+/*!
+	@param[in]	pv	パイプライン
+	@return	0
+*/
+static void*
+RenderThread( void* pv )
+{
+	RenderLoop( (Cat_FramePipeline*)pv );
+	return 0;
+}
+#endif
+
+//! 描画するスレッドを開始する
+/*!
+	@param[in]	pPipeline	パイプライン
+	@param[in]	nPriority	スレッドの優先度(PSPのみ。ゲームの処理をするスレッドより高くする)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+	@see	Cat_FramePipelineStop()
+*/
+int32_t
+Cat_FramePipelineStart( Cat_FramePipeline* pPipeline, int32_t nPriority )
+{
+	if(pPipeline == 0) {
+		return -1;
+	}
+	if(pPipeline->fThread) {
+		return 0;
+	}
+	Exchange( &pPipeline->nQuit, 0 );
+#ifdef __psp__
+	pPipeline->thid = sceKernelCreateThread( "Cat_FramePipeline", RenderThread, nPriority, CAT_FRAMEPIPELINE_STACK_SIZE,
+		PSP_THREAD_ATTR_USER | PSP_THREAD_ATTR_VFPU, 0 );
+	if(pPipeline->thid < 0) {
+		return -1;
+	}
+	if(sceKernelStartThread( pPipeline->thid, sizeof(pPipeline), &pPipeline ) < 0) {
+		sceKernelDeleteThread( pPipeline->thid );
+		return -1;
+	}
+#else
+	if(pthread_create( &pPipeline->thread, 0, RenderThread, pPipeline ) != 0) {
+		return -1;
+	}
+#endif
+	pPipeline->fThread = 1;
+	return 0;
+}
+
+//! 描画するスレッドを止める
+/*!
+	描画中のフレームを描画し終わるまで待つ。
+	@param[in]	pPipeline	パイプライン
+*/
+void
+Cat_FramePipelineStop( Cat_FramePipeline* pPipeline )
+{
+	if((pPipeline == 0) || !pPipeline->fThread) {
+		return;
+	}
+	Exchange( &pPipeline->nQuit, 1 );
+#ifdef __psp__
+	sceKernelWaitThreadEnd( pPipeline->thid, 0 );
+	sceKernelDeleteThread( pPipeline->thid );
+#else
+	pthread_join( pPipeline->thread, 0 );
+#endif
+	pPipeline->fThread = 0;
+	// 描画するスレッドがクリアする前に止まった
+	if(Exchange( &pPipeline->nResetRequest, 0 )) {
+		ResetRenderStatistics( pPipeline );
+	}
+}
+
+//! 書き込むスナップショットを取得する
+/*!
+	ゲームの処理をするスレッドから呼ぶ。スプライトとパレットは空になり、カメラは0になる。 \n
+	Cat_FramePipelineSubmit()するまで、同じスナップショットが返る。
+	@param[in]	pPipeline	パイプライン
+	@return	スナップショット
+*/
+Cat_FrameSnapshot*
+Cat_FramePipelineBeginSnapshot( Cat_FramePipeline* pPipeline )
+{
+	Cat_FrameSnapshot* rc;
+
+	if(pPipeline == 0) {
+		return 0;
+	}
+	rc = &pPipeline->aSnapshot[pPipeline->nBack];
+	if(!pPipeline->fWriting) {
+		rc->nSpriteCount = 0;
+		rc->fCameraX     = 0.0f;
+		rc->fCameraY     = 0.0f;
+		rc->nPaletteMask = 0;
+		pPipeline->fWriting = 1;
+	}
+	return rc;
+}
+
+//! 書き込んだスナップショットを渡す
+/*!
+	渡した後は、そのスナップショットに書き込まないこと。
+	@param[in]	pPipeline	パイプライン
+*/
+void
+Cat_FramePipelineSubmit( Cat_FramePipeline* pPipeline )
+{
+	Cat_FrameSnapshot* pSnapshot;
+	uint32_t nOld;
+
+	if(pPipeline == 0) {
+		return;
+	}
+	pSnapshot = Cat_FramePipelineBeginSnapshot( pPipeline );
+	pSnapshot->nFrame      = ++pPipeline->nSubmitCount;
+	pSnapshot->nSubmitTime = sceKernelGetSystemTimeLow();
+	// 書いたものを渡したものにして、前に渡したものを次に書く
+	nOld = Exchange( &pPipeline->nState, pPipeline->nBack | CAT_FRAMEPIPELINE_STATE_FRESH );
+	pPipeline->nBack    = nOld & CAT_FRAMEPIPELINE_STATE_INDEX;
+	pPipeline->fWriting = 0;
+	pPipeline->statistics.nSubmitCount++;
+	if(nOld & CAT_FRAMEPIPELINE_STATE_FRESH) {
+		pPipeline->statistics.nDropCount++;
+	}
+}
+
+//! 最新のスナップショットを描画する
+/*!
+	描画するスレッドの中で呼ばれる。Cat_FramePipelineStart()せずに、ゲームの処理と同じスレッドで \n
+	Cat_FramePipelineSubmit()の後に呼ぶと、今までと同じ1つのスレッドで描画する。
+	@param[in]	pPipeline	パイプライン
+	@return	描画した場合は、1 \n
+			新しいスナップショットが無い場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+int32_t
+Cat_FramePipelineRender( Cat_FramePipeline* pPipeline )
+{
+	const Cat_FrameSnapshot* pSnapshot;
+	Cat_Palette* pPalette;
+	uint32_t nStart;
+	uint32_t nTime;
+	uint32_t nLatency;
+	uint32_t i;
+
+	if(pPipeline == 0) {
+		return -1;
+	}
+	if(Load( &pPipeline->nResetRequest ) && Exchange( &pPipeline->nResetRequest, 0 )) {
+		ResetRenderStatistics( pPipeline );
+	}
+	if(!(Load( &pPipeline->nState ) & CAT_FRAMEPIPELINE_STATE_FRESH)) {
+		pPipeline->statistics.nIdleCount++;
+		return 0;
+	}
+	// 描画し終わったものを渡したものにして、渡したものを描画する
+	pPipeline->nFront = Exchange( &pPipeline->nState, pPipeline->nFront ) & CAT_FRAMEPIPELINE_STATE_INDEX;
+	pSnapshot = &pPipeline->aSnapshot[pPipeline->nFront];
+	nStart = sceKernelGetSystemTimeLow();
+
+	// スナップショットは次に書き換えられるので、GEが読むパレットはフレームの偶奇で分けて持つ
+	pPalette = pPipeline->aPalette[Cat_RenderGetFrame() & 1];
+	for(i = 0; i < CAT_FRAMEPIPELINE_PALETTE_MAX; i++) {
+		if(pSnapshot->nPaletteMask & (1UL << i)) {
+			memcpy( pPalette[i].pvData, pSnapshot->aPalette[i].pvData, CAT_FRAMEPIPELINE_PALETTE_COLOR * sizeof(uint32_t) );
+			Cat_PaletteUpdate( &pPalette[i] );
+		}
+	}
+
+	Cat_RenderBegin(); {
+		for(i = 0; i < pSnapshot->nSpriteCount; i++) {
+			Cat_SpriteBatchSprite sprite = pSnapshot->pSprite[i];
+			const uint32_t nSlot = (uint32_t)(sprite.pPalette - pSnapshot->aPalette);
+			if(nSlot < CAT_FRAMEPIPELINE_PALETTE_MAX) {
+				sprite.pPalette = &pPalette[nSlot];
+			}
+			sprite.x -= pSnapshot->fCameraX;
+			sprite.y -= pSnapshot->fCameraY;
+			Cat_SpriteBatchAdd( pPipeline->pBatch, &sprite );
+		}
+		Cat_SpriteBatchFlush( pPipeline->pBatch );
+		if(pPipeline->pfnDraw) {
+			pPipeline->pfnDraw( pSnapshot, pPipeline->pvContext );
+		}
+	} Cat_RenderEnd();
+	Cat_RenderScreenUpdate();
+
+	nTime    = sceKernelGetSystemTimeLow();
+	nLatency = nTime - pSnapshot->nSubmitTime;
+	nTime   -= nStart;
+	pPipeline->statistics.nRenderCount++;
+	pPipeline->statistics.nRenderTime += nTime;
+	pPipeline->statistics.nLatency    += nLatency;
+	if(pPipeline->statistics.nRenderTimeMax < nTime) {
+		pPipeline->statistics.nRenderTimeMax = nTime;
+	}
+	if(pPipeline->statistics.nLatencyMax < nLatency) {
+		pPipeline->statistics.nLatencyMax = nLatency;
+	}
+	return 1;
+}
+
+//! スプライトを追加する
+/*!
+	@param[in]	pSnapshot	スナップショット
+	@param[in]	pSprite		スプライト(位置はワールド座標)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+int32_t
+Cat_FrameSnapshotAddSprite( Cat_FrameSnapshot* pSnapshot, const Cat_SpriteBatchSprite* pSprite )
+{
+	if((pSnapshot == 0) || (pSprite == 0) || (pSnapshot->nSpriteCount >= pSnapshot->nSpriteMax)) {
+		return -1;
+	}
+	pSnapshot->pSprite[pSnapshot->nSpriteCount++] = *pSprite;
+	return 0;
+}
+
+//! パレットを設定する
+/*!
+	色をスナップショットにコピーするので、この後で \a pPalette を書き換えても構わない。
+	@param[in]	pSnapshot	スナップショット
+	@param[in]	nSlot		パレットの番号(0～CAT_FRAMEPIPELINE_PALETTE_MAX-1)
+	@param[in]	pPalette	コピーするパレット
+	@return	スプライトに設定するパレット。失敗した場合は0が返る。
+*/
+Cat_Palette*
+Cat_FrameSnapshotSetPalette( Cat_FrameSnapshot* pSnapshot, uint32_t nSlot, const Cat_Palette* pPalette )
+{
+	Cat_Palette* rc;
+	uint32_t* pnData;
+	uint32_t i;
+
+	if((pSnapshot == 0) || (nSlot >= CAT_FRAMEPIPELINE_PALETTE_MAX) || (pPalette == 0)) {
+		return 0;
+	}
+	rc = &pSnapshot->aPalette[nSlot];
+	pnData = (uint32_t*)rc->pvData;
+	if(pPalette->ePaletteFormat == FORMAT_PALETTE_8888) {
+		memcpy( pnData, pPalette->pvData, (pPalette->nMask + 1) * sizeof(uint32_t) );
+		i = pPalette->nMask + 1;
+	} else {
+		for(i = 0; i <= pPalette->nMask; i++) {
+			pnData[i] = Cat_PaletteGetColor( pPalette, i );
+		}
+	}
+	// 16色のパレットは、残りを透明にしておく
+	if(i < CAT_FRAMEPIPELINE_PALETTE_COLOR) {
+		memset( &pnData[i], 0, (CAT_FRAMEPIPELINE_PALETTE_COLOR - i) * sizeof(uint32_t) );
+	}
+	pSnapshot->nPaletteMask |= 1UL << nSlot;
+	return rc;
+}
+
+//! 統計情報を取得する
+/*!
+	@param[in]	pPipeline		パイプライン
+	@param[out]	pStatistics		統計情報
+*/
+void
+Cat_FramePipelineGetStatistics( Cat_FramePipeline* pPipeline, Cat_FramePipelineStatistics* pStatistics )
+{
+	if(pPipeline && pStatistics) {
+		*pStatistics = pPipeline->statistics;
+	}
+}
+
+//! 統計情報をクリアする
+/*!
+	ゲームの処理をするスレッドから呼ぶ。統計情報はそれぞれを書き込むスレッドがクリアするので、 \n
+	描画するスレッドが動いている間は、描画側の回数と時間は次のCat_FramePipelineRender()でクリアされる。
+	@param[in]	pPipeline	パイプライン
+*/
+void
+Cat_FramePipelineResetStatistics( Cat_FramePipeline* pPipeline )
+{
+	if(pPipeline == 0) {
+		return;
+	}
+	pPipeline->statistics.nSubmitCount = 0;
+	pPipeline->statistics.nDropCount   = 0;
+	if(pPipeline->fThread) {
+		Exchange( &pPipeline->nResetRequest, 1 );
+	} else {
+		ResetRenderStatistics( pPipeline );
+	}
+}
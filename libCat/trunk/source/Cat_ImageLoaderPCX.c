@@ -7,6 +7,7 @@
 #include <string.h>
 #include "Cat_Texture.h"
 #include "Cat_Stream.h"
+#include "Cat_ImageLoaderPCX.h"
 
 #ifndef CAT_MALLOC
 //! メモリ確保マクロ
@@ -296,30 +297,139 @@ Cat_ImageLoaderLoadPCX( Cat_Stream* pStream )
 	return rc;
 }
 
+//! ランレングスの長さの最大値
+#define RUN_LENGTH_MAX (0x3f)
+
+//! 1ライン分をランレングスで圧縮する
+/*!
+	同じ値が続く所は、0xc0に長さ(1～63)を足した値と、値の2バイトにする。 \n
+	0xc0以上の値は、続いていなくても長さ1を付ける。
+	@param[out]	pbDest	圧縮したデータ(最大で \a nSize の2倍)
+	@param[in]	pbSrc	圧縮するデータ
+	@param[in]	nSize	圧縮するデータのサイズ
+	@return	圧縮したデータのサイズ
+*/
+static uint32_t
+RunLengthEncode( uint8_t* pbDest, const uint8_t* pbSrc, uint32_t nSize )
+{
+	uint8_t* pbStart = pbDest;
+	uint32_t i = 0;
+
+	while(i < nSize) {
+		const uint8_t nData = pbSrc[i];
+		uint32_t nLength = 1;
+		while((i + nLength < nSize) && (nLength < RUN_LENGTH_MAX) && (pbSrc[i + nLength] == nData)) {
+			nLength++;
+		}
+		if((nLength > 1) || (nData >= 0xc0)) {
+			*pbDest++ = (uint8_t)(0xc0 | nLength);
+		}
+		*pbDest++ = nData;
+		i += nLength;
+	}
+	return (uint32_t)(pbDest - pbStart);
+}
+
+//! ランレングスで圧縮して書き出す
+/*!
+	ランは1ライン(プレーンごと)をまたがないように区切る。
+	@param[in]	pStream		ストリーム
+	@param[in]	pvData		書き出すデータ
+	@param[in]	nDataSize	書き出すデータのサイズ
+	@param[in]	nLineSize	1ラインのサイズ
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
 static int32_t
-RunLengthWrite( Cat_Stream* pStream, void* pvData, int32_t nDataSize )
+RunLengthWrite( Cat_Stream* pStream, const void* pvData, uint32_t nDataSize, uint32_t nLineSize )
 {
-	uint8_t* pbData = (uint8_t*)pvData;
+	const uint8_t* pbData = (const uint8_t*)pvData;
+	uint8_t* pbWork;
+	int32_t rc = 0;
 
-	// 何もかんがえずに、書き出す
+	pbWork = (uint8_t*)CAT_MALLOC( nLineSize * 2 );
+	if(pbWork == 0) {
+		return -1;
+	}
 	while(nDataSize > 0) {
-		if(*pbData < 0xc0) {
-			if(Cat_StreamWrite( pStream, pbData, 1 ) != 1) {
-				return -1;
-			}
-			pbData++;
-			nDataSize--;
-		} else {
-			uint8_t nLength = 0xc1;
-			if(Cat_StreamWrite( pStream, &nLength, 1 ) != 1) {
-				return -1;
-			}
-			if(Cat_StreamWrite( pStream, pbData, 1 ) != 1) {
-				return -1;
-			}
-			pbData++;
-			nDataSize--;
+		const uint32_t nSize = (nDataSize < nLineSize) ? nDataSize : nLineSize;
+		const uint32_t nWrite = RunLengthEncode( pbWork, pbData, nSize );
+		if(Cat_StreamWrite( pStream, pbWork, nWrite ) != nWrite) {
+			rc = -1;
+			break;
 		}
+		pbData    += nSize;
+		nDataSize -= nSize;
+	}
+	CAT_FREE( pbWork );
+	return rc;
+}
+
+//! ヘッダを書き込む
+/*!
+	@param[in]	pStream		ストリーム
+	@param[out]	pHeader		書き込んだヘッダ
+	@param[in]	nWidth		横幅
+	@param[in]	nHeight		高さ
+	@param[in]	nPlaneCount	プレーン数(1:8bit 3:24bit)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+static int32_t
+WriteHeader( Cat_Stream* pStream, PCXHeader* pHeader, uint32_t nWidth, uint32_t nHeight, uint8_t nPlaneCount )
+{
+	memset( pHeader, 0, sizeof(PCXHeader) );
+	pHeader->nFlag         = MAGIC_NUMBER;
+	pHeader->nVersion      = 5;
+	pHeader->nEncoding     = 1;
+	pHeader->nBitPerPixcel = 8;
+	pHeader->nPlaneCount   = nPlaneCount;
+	pHeader->nPitch = (nWidth + 1) & ~1;	// 偶数に
+	pHeader->nMinX = 0;
+	pHeader->nMaxX = nWidth - 1;
+	pHeader->nMinY = 0;
+	pHeader->nMaxY = nHeight - 1;
+	pHeader->nDotPerInchWidth  = 0x48;
+	pHeader->nDotPerInchHeight = 0x48;
+	pHeader->nPaletteFormat = 1;
+	pHeader->nScreenWidth  = 480;
+	pHeader->nScreenHeight = 272;
+
+	if(Cat_StreamWrite( pStream, pHeader, sizeof(PCXHeader) ) != sizeof(PCXHeader)) {
+		return -1;
+	}
+	return 0;
+}
+
+//! RGBA8888の1ラインを、プレーンに分けて書き込む
+/*!
+	@param[in]	pStream		ストリーム
+	@param[in]	pHeader		ヘッダ
+	@param[in]	pnSrc		1ライン分のRGBA8888
+	@param[out]	pbPlane		プレーンに分けたデータ(nPitch * 3バイト)
+	@param[out]	pbWork		圧縮したデータ(nPitch * 6バイト)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+static int32_t
+WriteLine8888( Cat_Stream* pStream, const PCXHeader* pHeader, const uint32_t* pnSrc, uint8_t* pbPlane, uint8_t* pbWork )
+{
+	const uint32_t nWidth = pHeader->nMaxX + 1;
+	const uint32_t nPitch = pHeader->nPitch;
+	uint32_t nWrite;
+	uint32_t x;
+
+	for(x = 0; x < nWidth; x++) {
+		const uint32_t nColor = pnSrc[x];
+		pbPlane[x           ] = (uint8_t)(nColor      );
+		pbPlane[x + nPitch*1] = (uint8_t)(nColor >>  8);
+		pbPlane[x + nPitch*2] = (uint8_t)(nColor >> 16);
+	}
+	nWrite  = RunLengthEncode( pbWork, pbPlane, nPitch );
+	nWrite += RunLengthEncode( pbWork + nWrite, pbPlane + nPitch*1, nPitch );
+	nWrite += RunLengthEncode( pbWork + nWrite, pbPlane + nPitch*2, nPitch );
+	if(Cat_StreamWrite( pStream, pbWork, nWrite ) != nWrite) {
+		return -1;
 	}
 	return 0;
 }
@@ -343,132 +453,45 @@ Cat_ImageLoaderSavePCX( Cat_Stream* pStream, Cat_Texture* pTexture )
 		return -1;
 	}
 
-	memset( &header, 0, sizeof(header) );
-
-	// ヘッダ設定
-	header.nFlag         = MAGIC_NUMBER;
-	header.nVersion      = 5;
-	header.nEncoding     = 1;
 	nWidth  = pTexture->nTextureWidth;
 	nHeight = pTexture->nTextureHeight;
 	switch(pTexture->ePixelFormat) {
 		case FORMAT_PIXEL_CLUT4:
 		case FORMAT_PIXEL_CLUT8:
-			header.nBitPerPixcel = 8;
-			header.nPlaneCount   = 1;
-			break;
-		case FORMAT_PIXEL_8888:
-		case FORMAT_PIXEL_5650:
-		case FORMAT_PIXEL_5551:
-		default:
-			header.nBitPerPixcel = 8;
-			header.nPlaneCount   = 3;
-			break;
-	}
-	header.nPitch = (nWidth + 1) & ~1;	// 偶数に
-	header.nMinX = 0;
-	header.nMaxX = nWidth - 1;
-	header.nMinY = 0;
-	header.nMaxY = nHeight - 1;
-	header.nDotPerInchWidth  = 0x48;
-	header.nDotPerInchHeight = 0x48;
-	header.nPaletteFormat = 1;
-	header.nScreenWidth  = 480;
-	header.nScreenHeight = 272;
-
-	// ヘッダ書き込み
-	if(Cat_StreamWrite( pStream, &header, sizeof(header) ) != sizeof(header)) {
-		return -1;
-	}
-
-	nImageSize = header.nPitch * nHeight * header.nPlaneCount;
-	uint8_t* pbImage = (uint8_t*)CAT_MALLOC( nImageSize );
-	memset( pbImage, 0, nImageSize );
-	// イメージ書き込み
-	switch(pTexture->ePixelFormat) {
-		case FORMAT_PIXEL_CLUT4:
 			{
-				uint8_t* pbSrc = pbImage;
-				uint32_t x;
-				uint32_t y;
 				uint32_t i;
 				uint8_t nData;
-				for(y = 0; y < nHeight; y++) {
-					for(x = 0; x < nWidth; x++) {
-						*pbSrc++ = Cat_TextureGetPixelRaw( pTexture, x, y );
-					}
-					if(nWidth & 1) {
-						pbSrc++;
-					}
+				uint8_t* pbImage;
+
+				// ヘッダ書き込み
+				if(WriteHeader( pStream, &header, nWidth, nHeight, 1 ) < 0) {
+					return -1;
 				}
-				if(RunLengthWrite( pStream, pbImage, nImageSize ) < 0) {
-					CAT_FREE( pbImage );
+				nImageSize = header.nPitch * nHeight;
+				pbImage = (uint8_t*)CAT_MALLOC( nImageSize );
+				if(pbImage == 0) {
 					return -1;
 				}
-
-				// パレット
-				nData = 12;
-				if(Cat_StreamWrite( pStream, &nData, sizeof(nData) ) != sizeof(nData)) {
+				memset( pbImage, 0, nImageSize );
+				// 4bitに変換されたテクスチャは、8bitのパレット番号で取得される
+				if(Cat_TextureGetRegion( pTexture, 0, 0, nWidth, nHeight, pbImage, header.nPitch, CAT_TEXTURE_REGION_RAW ) < 0) {
 					CAT_FREE( pbImage );
 					return -1;
 				}
-				if(pTexture->pPalette4 == 0) {
-					for(i = 0; i < 16; i++) {
-						uint32_t nColor = Cat_PaletteGetColor( pTexture->pPalette, i );
-						if(Cat_StreamWrite( pStream, &nColor, 3 ) != 3) {
-							CAT_FREE( pbImage );
-							return -1;
-						}
-					}
-				} else {
-					for(i = 0; i < 16; i++) {
-						uint32_t nColor = Cat_PaletteGetColor( pTexture->pPalette, pTexture->tbl4to8[i] );
-						if(Cat_StreamWrite( pStream, &nColor, 3 ) != 3) {
-							CAT_FREE( pbImage );
-							return -1;
-						}
-					}
-				}
-				for(;i < 256; i++) {
-					uint32_t nColor = 0;
-					if(Cat_StreamWrite( pStream, &nColor, 3 ) != 3) {
-						CAT_FREE( pbImage );
-						return -1;
-					}
-				}
-			}
-			break;
-
-		case FORMAT_PIXEL_CLUT8:
-			{
-				uint8_t* pbSrc = pbImage;
-				uint32_t x;
-				uint32_t y;
-				uint32_t i;
-				uint8_t nData;
-				for(y = 0; y < nHeight; y++) {
-					for(x = 0; x < nWidth; x++) {
-						*pbSrc++ = Cat_TextureGetPixelRaw( pTexture, x, y );
-					}
-					if(nWidth & 1) {
-						pbSrc++;
-					}
-				}
-				if(RunLengthWrite( pStream, pbImage, nImageSize ) < 0) {
+				if(RunLengthWrite( pStream, pbImage, nImageSize, header.nPitch ) < 0) {
 					CAT_FREE( pbImage );
 					return -1;
 				}
+				CAT_FREE( pbImage );
 
 				// パレット
 				nData = 12;
 				if(Cat_StreamWrite( pStream, &nData, sizeof(nData) ) != sizeof(nData)) {
-					CAT_FREE( pbImage );
 					return -1;
 				}
 				for(i = 0; i < 256; i++) {
-					uint32_t nColor = Cat_PaletteGetColor( pTexture->pPalette, i );
+					uint32_t nColor = Cat_PaletteGetColor( pTexture->pPalette, i );	// 範囲外は0が返る
 					if(Cat_StreamWrite( pStream, &nColor, 3 ) != 3) {
-						CAT_FREE( pbImage );
 						return -1;
 					}
 				}
@@ -478,31 +501,99 @@ Cat_ImageLoaderSavePCX( Cat_Stream* pStream, Cat_Texture* pTexture )
 		case FORMAT_PIXEL_5551:
 		case FORMAT_PIXEL_5650:
 		case FORMAT_PIXEL_8888:
+		case FORMAT_PIXEL_DXT1:
+		case FORMAT_PIXEL_DXT3:
+		case FORMAT_PIXEL_DXT5:
+		default:
 			{
-				uint8_t* pbSrc = pbImage;
-				uint32_t x;
+				uint32_t* pnLine;
+				uint8_t* pbPlane;
 				uint32_t y;
-				for(y = 0; y < nHeight; y++) {
-					for(x = 0; x < nWidth; x++) {
-						uint32_t nColor = Cat_TextureGetPixel( pTexture, x, y );
-						pbSrc[x                  ] = *((uint8_t*)&nColor + 0);
-						pbSrc[x + header.nPitch*1] = *((uint8_t*)&nColor + 1);
-						pbSrc[x + header.nPitch*2] = *((uint8_t*)&nColor + 2);
+				uint32_t yy;
+				uint32_t h;
+
+				// ヘッダ書き込み
+				if(WriteHeader( pStream, &header, nWidth, nHeight, 3 ) < 0) {
+					return -1;
+				}
+				// 8ラインずつRGBA8888で取り出して、1ラインずつプレーンに分けて書き込む
+				pnLine  = (uint32_t*)CAT_MALLOC( nWidth * 4 * 8 );
+				pbPlane = (uint8_t*)CAT_MALLOC( header.nPitch * 3 * 3 );
+				if((pnLine == 0) || (pbPlane == 0)) {
+					if(pnLine) {
+						CAT_FREE( pnLine );
+					}
+					if(pbPlane) {
+						CAT_FREE( pbPlane );
+					}
+					return -1;
+				}
+				memset( pbPlane, 0, header.nPitch * 3 );
+				for(y = 0; y < nHeight; y += 8) {
+					h = ((nHeight - y) < 8) ? (nHeight - y) : 8;
+					if(Cat_TextureGetRegion( pTexture, 0, y, nWidth, h, pnLine, nWidth * 4, CAT_TEXTURE_REGION_8888 ) < 0) {
+						break;
+					}
+					for(yy = 0; yy < h; yy++) {
+						if(WriteLine8888( pStream, &header, pnLine + yy * nWidth, pbPlane, pbPlane + header.nPitch * 3 ) < 0) {
+							break;
+						}
+					}
+					if(yy < h) {
+						break;
 					}
-					pbSrc += header.nPitch * 3;
 				}
-				if(RunLengthWrite( pStream, pbImage, nImageSize ) < 0) {
-					CAT_FREE( pbImage );
+				CAT_FREE( pbPlane );
+				CAT_FREE( pnLine );
+				if(y < nHeight) {
 					return -1;
 				}
 			}
 			break;
-		default:
-			break;
 	}
-	CAT_FREE( pbImage );
 
 	return 0;
 }
 
+//! 1ラインずつ取得したRGBA8888のイメージを、24bitのPCX形式で保存する
+/*!
+	@param[in]	pStream		ストリーム
+	@param[in]	nWidth		横幅
+	@param[in]	nHeight		高さ
+	@param[in]	pfnLine		1ライン分のRGBA8888を取得する関数
+	@param[in]	pvContext	\a pfnLine に渡す値
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+int32_t
+Cat_ImageLoaderSavePCX8888( Cat_Stream* pStream, uint32_t nWidth, uint32_t nHeight, Cat_ImageLoaderLineFunc pfnLine, void* pvContext )
+{
+	PCXHeader header;
+	uint8_t* pbPlane;
+	uint32_t y;
+
+	if((pStream == 0) || (nWidth == 0) || (nHeight == 0) || (pfnLine == 0)) {
+		return -1;
+	}
+	if(WriteHeader( pStream, &header, nWidth, nHeight, 3 ) < 0) {
+		return -1;
+	}
+	pbPlane = (uint8_t*)CAT_MALLOC( header.nPitch * 3 * 3 );
+	if(pbPlane == 0) {
+		return -1;
+	}
+	memset( pbPlane, 0, header.nPitch * 3 );
+	for(y = 0; y < nHeight; y++) {
+		const uint32_t* pnSrc = pfnLine( y, pvContext );
+		if((pnSrc == 0) || (WriteLine8888( pStream, &header, pnSrc, pbPlane, pbPlane + header.nPitch * 3 ) < 0)) {
+			break;
+		}
+	}
+	CAT_FREE( pbPlane );
+	if(y < nHeight) {
+		return -1;
+	}
+	return 0;
+}
+
 #endif	// USE_CAT_IMAGELOADER_PCX
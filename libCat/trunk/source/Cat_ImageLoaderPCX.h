@@ -39,6 +39,28 @@ extern Cat_Texture* Cat_ImageLoaderLoadPCX( Cat_Stream* pStream );
 */
 extern int32_t Cat_ImageLoaderSavePCX( Cat_Stream* pStream, Cat_Texture* pTexture );
 
+//! 1ライン分のRGBA8888を取得する関数
+/*!
+	@param[in]	y			ライン
+	@param[in]	pvContext	Cat_ImageLoaderSavePCX8888()に渡した値
+	@return	1ライン分のRGBA8888 \n
+			失敗した場合は、0を返す
+*/
+typedef const uint32_t* (*Cat_ImageLoaderLineFunc)( uint32_t y, void* pvContext );
+
+//! 1ラインずつ取得したRGBA8888のイメージを、24bitのPCX形式で保存する
+/*!
+	テクスチャを作らずに、フレームバッファなどを保存する時に使う。アルファは保存しない。
+	@param[in]	pStream		ストリーム
+	@param[in]	nWidth		横幅
+	@param[in]	nHeight		高さ
+	@param[in]	pfnLine		1ライン分のRGBA8888を取得する関数(上から順に呼ばれる)
+	@param[in]	pvContext	\a pfnLine に渡す値
+	@return	成功した場合は0 \n
+			失敗した場合は、負数を返す
+*/
+extern int32_t Cat_ImageLoaderSavePCX8888( Cat_Stream* pStream, uint32_t nWidth, uint32_t nHeight, Cat_ImageLoaderLineFunc pfnLine, void* pvContext );
+
 #ifdef __cplusplus
 }
 #endif
@@ -3,7 +3,10 @@
 
 #include "Cat_Palette.h"
 #include "Cat_Texture.h"
+#include "Cat_RenderState.h"
+#include "Cat_Render.h"
 #include <pspgu.h>
+#include <psputils.h>
 #include <malloc.h>	// for memalign
 #include <string.h>
 
@@ -17,6 +20,48 @@
 #define CAT_FREE(x) free( x )
 #endif // CAT_FREE
 
+//! パレット構造体のチャンクのサイズ
+#define CAT_PALETTE_SLAB_CHUNK_SIZE (2048)
+
+//! パレット構造体の割り当て
+static Cat_Slab* gpSlab = 0;
+//! パレットデータを確保する領域
+static Cat_Arena* gpArena = 0;
+
+//! パレットデータを確保する領域を設定する
+/*!
+	設定されている間に作成されたパレットは、パレットデータを \a pArena から確保して参照を持つ。 \n
+	通常は、Cat_TextureSetArena()から設定される。
+	@param[in]	pArena	領域(0の場合はヒープから確保する)
+	@see	Cat_PaletteGetArena()
+*/
+void
+Cat_PaletteSetArena( Cat_Arena* pArena )
+{
+	gpArena = pArena;
+}
+
+//! パレットデータを確保する領域を取得する
+/*!
+	@return	領域
+	@see	Cat_PaletteSetArena()
+*/
+Cat_Arena*
+Cat_PaletteGetArena( void )
+{
+	return gpArena;
+}
+
+//! パレット構造体の割り当ての統計情報を取得する
+/*!
+	@param[out]	pStatistics		統計情報
+*/
+void
+Cat_PaletteGetSlabStatistics( Cat_SlabStatistics* pStatistics )
+{
+	Cat_SlabGetStatistics( gpSlab, pStatistics );
+}
+
 //! パレットを作成する
 /*!
 	@param[in]	ePaletteFormat	パレットフォーマット(FORMAT_PALETTE_xxx)
@@ -36,7 +81,11 @@ Cat_PaletteCreate( FORMAT_PALETTE ePaletteFormat, uint32_t nSize, const void* pv
 		return 0;
 	}
 
-	rc = (Cat_Palette*)CAT_MALLOC( sizeof(Cat_Palette) );
+	if(gpSlab == 0) {
+		// 最初に作る時に用意する
+		gpSlab = Cat_SlabCreate( sizeof(Cat_Palette), CAT_PALETTE_SLAB_CHUNK_SIZE );
+	}
+	rc = (Cat_Palette*)Cat_SlabAlloc( gpSlab );
 	if(rc) {
 		memset( rc, 0, sizeof(Cat_Palette) );
 		rc->ePaletteFormat = ePaletteFormat;
@@ -50,7 +99,16 @@ Cat_PaletteCreate( FORMAT_PALETTE ePaletteFormat, uint32_t nSize, const void* pv
 		} else {
 			rc->nMask = 0xF;
 		}
-		rc->pvData = (void*)CAT_MALLOC( rc->nSize * 32 );
+		if(gpArena) {
+			// 一緒に捨てるものは、まとめて確保する
+			rc->pvData = Cat_ArenaAlloc( gpArena, rc->nSize * 32 );
+			if(rc->pvData) {
+				rc->pArena = gpArena;
+				Cat_ArenaAddRef( gpArena );
+			}
+		} else {
+			rc->pvData = (void*)CAT_MALLOC( rc->nSize * 32 );
+		}
 		if(rc->pvData) {
 			if(pvColorMap) {
 				// 初期化
@@ -60,7 +118,7 @@ Cat_PaletteCreate( FORMAT_PALETTE ePaletteFormat, uint32_t nSize, const void* pv
 			rc->nRef = 1;
 		} else {
 			/* メモリ確保失敗 */
-			CAT_FREE( rc );
+			Cat_SlabFree( gpSlab, rc );
 			rc = 0;
 		}
 	}
@@ -79,11 +137,14 @@ Cat_PaletteRelease( Cat_Palette* pPalette )
 	}
 	// 参照が無くなったら解放する
 	if(--pPalette->nRef == 0) {
-		if(pPalette->pvData) {
+		if(pPalette->pArena) {
+			Cat_ArenaFree( pPalette->pArena, pPalette->pvData );
+			Cat_ArenaRelease( pPalette->pArena );
+		} else if(pPalette->pvData) {
 			CAT_FREE( pPalette->pvData );
 		}
 		memset( pPalette, 0, sizeof(Cat_Palette) );
-		CAT_FREE( pPalette );
+		Cat_SlabFree( gpSlab, pPalette );
 	}
 }
 
@@ -124,8 +185,25 @@ Cat_PaletteSetPalette( Cat_Palette* pPalette )
 	if(pPalette == 0) {
 		return;
 	}
-	sceGuClutMode( (int)pPalette->ePaletteFormat, 0, pPalette->nMask, 0 );
-	sceGuClutLoad( pPalette->nSize, pPalette->pvData );
+	Cat_RenderCount( CAT_RENDER_COUNT_PALETTE );
+	Cat_RenderStateClut( (int)pPalette->ePaletteFormat, pPalette->nMask, pPalette->nSize, pPalette->pvData, pPalette->nSerial );
+}
+
+//! パレットの内容を更新したことを通知する
+/*!
+	pvDataを直接書き換えた後に呼び出すこと。 \n
+	更新カウンタが加算され、このパレットから作られた4bitパレットなどが再構成される。
+	@param[in]	pPalette	更新したパレット
+*/
+void
+Cat_PaletteUpdate( Cat_Palette* pPalette )
+{
+	if(pPalette == 0) {
+		return;
+	}
+	pPalette->nSerial++;
+	// GEはメモリから直接読むので、キャッシュを吐き出しておく
+	sceKernelDcacheWritebackRange( pPalette->pvData, pPalette->nSize * 32 );
 }
 
 //! パレットの色を取得する
@@ -0,0 +1,485 @@
+//! @file	Cat_PaletteEffect.c
+// パレットエフェクト
+
+// SSE2が使える環境(ホストでのツールやテスト)では、4色ずつまとめて変換する。
+// PSPではスカラー版を使う。どちらも同じ結果になるように、整数の演算の順番を揃えている。
+// CAT_PALETTEEFFECT_NO_SIMDを定義すると、常にスカラー版を使う。
+
+#include "Cat_PaletteEffect.h"
+#include "Cat_ColorConvert.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <malloc.h>	// for memalign
+
+#if !defined(CAT_PALETTEEFFECT_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define USE_CAT_PALETTEEFFECT_SSE2
+#endif
+
+#ifndef CAT_MALLOC
+//! メモリ確保マクロ
+#define CAT_MALLOC(x) memalign( 32, (x) )
+#endif // CAT_MALLOC
+
+#ifndef CAT_FREE
+//! メモリ解放マクロ
+#define CAT_FREE(x) free( x )
+#endif // CAT_FREE
+
+//! 円周率
+#define CAT_PALETTEEFFECT_PI (3.14159265f)
+
+//! 使った場所を上書きしないフレーム数(作成中のフレームと、GEが描画している前のフレーム)
+#define CAT_PALETTEEFFECT_KEEP_FRAME (2)
+
+//! 正弦波を計算した後のパラメータ(キャッシュのキーにもなる)
+typedef struct {
+	int32_t		nAdd[3];		/*!< R,G,Bに加算する値(正弦波を含む)	*/
+	int32_t		nMul[3];		/*!< R,G,Bに乗算する値					*/
+	uint32_t	fInvert;		/*!< 色を反転するかどうか				*/
+	uint32_t	nColor;			/*!< 彩度								*/
+	uint32_t	fSolid;			/*!< 単色にするかどうか					*/
+	uint32_t	nSolidColor;	/*!< 単色の色(単色にしない場合は0)		*/
+	uint32_t	nAlpha;			/*!< アルファに乗算する値				*/
+} Key;
+
+//! キャッシュの場所
+typedef struct {
+	Cat_Palette*	pSource;		/*!< 元のパレット(参照を持っている)	*/
+	uint32_t		nSerial;		/*!< 元のパレットの更新カウンタ		*/
+	Key				key;			/*!< パラメータ						*/
+	Cat_Palette*	pPalette;		/*!< エフェクトをかけたパレット		*/
+	uint32_t		nLastFrame;		/*!< 最後に使ったフレーム			*/
+	uint32_t		nLastUse;		/*!< 最後に使った順番				*/
+} Entry;
+
+//! エフェクトをかけたパレットのキャッシュ
+struct _Cat_PaletteEffectCache {
+	Entry*							pEntry;			/*!< 場所				*/
+	uint32_t						nCount;			/*!< 場所の数			*/
+	uint32_t						nFrame;			/*!< 今のフレーム		*/
+	uint32_t						nClock;			/*!< 使った順番			*/
+	Cat_PaletteEffectStatistics		statistics;		/*!< 統計情報			*/
+};
+
+//! 値を範囲に収める
+static inline int32_t
+Clamp( int32_t nValue, int32_t nMin, int32_t nMax )
+{
+	return (nValue < nMin) ? nMin : ((nValue > nMax) ? nMax : nValue);
+}
+
+//! パラメータの正弦波を計算して、範囲に収める
+/*!
+	@param[out]	pKey	正弦波を計算した後のパラメータ
+	@param[in]	pParam	パラメータ
+*/
+static void
+MakeKey( Key* pKey, const Cat_PaletteEffectParam* pParam )
+{
+	float fSin = 0.0f;
+	uint32_t i;
+
+	memset( pKey, 0, sizeof(Key) );
+	if(pParam->nSinPeriod) {
+		fSin = sinf( 2.0f * CAT_PALETTEEFFECT_PI * (float)(pParam->nTime % pParam->nSinPeriod) / (float)pParam->nSinPeriod );
+	}
+	for(i = 0; i < 3; i++) {
+		const int32_t nSin = (int32_t)floorf( (float)pParam->nSinAdd[i] * fSin + 0.5f );
+		pKey->nAdd[i] = Clamp( pParam->nAdd[i] + nSin, -CAT_PALETTEEFFECT_ADD_MAX, CAT_PALETTEEFFECT_ADD_MAX );
+		pKey->nMul[i] = Clamp( pParam->nMul[i], 0, CAT_PALETTEEFFECT_MUL_MAX );
+	}
+	pKey->fInvert = pParam->fInvert ? 1 : 0;
+	pKey->nColor  = (pParam->nColor > CAT_PALETTEEFFECT_UNIT) ? CAT_PALETTEEFFECT_UNIT : pParam->nColor;
+	pKey->fSolid  = pParam->fSolid ? 1 : 0;
+	pKey->nSolidColor = pParam->fSolid ? (pParam->nSolidColor & 0xFFFFFF) : 0;
+	pKey->nAlpha  = (pParam->nAlpha > CAT_PALETTEEFFECT_UNIT) ? CAT_PALETTEEFFECT_UNIT : pParam->nAlpha;
+}
+
+//! 何もしないパラメータかどうか
+static int32_t
+IsIdentity( const Key* pKey )
+{
+	uint32_t i;
+
+	for(i = 0; i < 3; i++) {
+		if((pKey->nAdd[i] != 0) || (pKey->nMul[i] != CAT_PALETTEEFFECT_UNIT)) {
+			return 0;
+		}
+	}
+	return !pKey->fInvert && !pKey->fSolid && (pKey->nColor == CAT_PALETTEEFFECT_UNIT)
+		&& (pKey->nAlpha == CAT_PALETTEEFFECT_UNIT);
+}
+
+//! RGBA8888の色にエフェクトをかける(スカラー版)
+/*!
+	@param[out]	pnDest	出力先
+	@param[in]	pnSrc	元の色
+	@param[in]	nCount	色数
+	@param[in]	pKey	パラメータ
+*/
+static void
+Apply8888( uint32_t* pnDest, const uint32_t* pnSrc, uint32_t nCount, const Key* pKey )
+{
+	uint32_t i;
+
+	for(i = 0; i < nCount; i++) {
+		const uint32_t c = pKey->fSolid ? ((pnSrc[i] & 0xFF000000) | pKey->nSolidColor) : pnSrc[i];
+		const uint32_t a = ((c >> 24) * pKey->nAlpha) >> 8;
+		int32_t v[3];
+		int32_t nLum;
+		uint32_t j;
+
+		v[0] = c & 0xFF;
+		v[1] = (c >> 8) & 0xFF;
+		v[2] = (c >> 16) & 0xFF;
+		nLum = (v[0] * 77 + v[1] * 150 + v[2] * 29) >> 8;
+		for(j = 0; j < 3; j++) {
+			v[j] = nLum + (((v[j] - nLum) * (int32_t)pKey->nColor) >> 8);
+			if(pKey->fInvert) {
+				v[j] = 255 - v[j];
+			}
+			v[j] = ((v[j] + pKey->nAdd[j]) * pKey->nMul[j]) >> 8;
+			v[j] = Clamp( v[j], 0, 255 );
+		}
+		pnDest[i] = (a << 24) | v[0] | (v[1] << 8) | (v[2] << 16);
+	}
+}
+
+#if defined(USE_CAT_PALETTEEFFECT_SSE2)
+//! RGBA8888の色にエフェクトをかける(SSE2版)
+/*!
+	16bitに広げた2色ずつ計算する。 \n
+	(x * y) >> 8 は、16倍した値同士の_mm_mulhi_epi16()で求める。
+	@param[out]	pnDest	出力先
+	@param[in]	pnSrc	元の色
+	@param[in]	nCount	色数
+	@param[in]	pKey	パラメータ
+	@return	変換した色数(4の倍数)
+*/
+static uint32_t
+Apply8888SSE2( uint32_t* pnDest, const uint32_t* pnSrc, uint32_t nCount, const Key* pKey )
+{
+	const __m128i zero   = _mm_setzero_si128();
+	const __m128i weight = _mm_setr_epi16( 77, 150, 29, 0, 77, 150, 29, 0 );
+	const __m128i color  = _mm_set1_epi16( (int16_t)(pKey->nColor << 4) );
+	const __m128i invert = _mm_set1_epi16( pKey->fInvert ? -1 : 0 );
+	const __m128i invadd = _mm_set1_epi16( pKey->fInvert ? 256 : 0 );
+	const __m128i add    = _mm_setr_epi16( (int16_t)pKey->nAdd[0], (int16_t)pKey->nAdd[1], (int16_t)pKey->nAdd[2], 0,
+		(int16_t)pKey->nAdd[0], (int16_t)pKey->nAdd[1], (int16_t)pKey->nAdd[2], 0 );
+	const __m128i mul    = _mm_setr_epi16( (int16_t)(pKey->nMul[0] << 4), (int16_t)(pKey->nMul[1] << 4), (int16_t)(pKey->nMul[2] << 4), 0,
+		(int16_t)(pKey->nMul[0] << 4), (int16_t)(pKey->nMul[1] << 4), (int16_t)(pKey->nMul[2] << 4), 0 );
+	const __m128i alpha  = _mm_set1_epi32( (int32_t)0xFF000000 );
+	const __m128i solid  = _mm_set1_epi32( (int32_t)pKey->nSolidColor );
+	const __m128i keep   = _mm_set1_epi32( pKey->fSolid ? (int32_t)0xFF000000 : -1 );
+	const __m128i amul   = _mm_set1_epi32( (int32_t)pKey->nAlpha );
+	uint32_t i;
+
+	for(i = 0; i + 4 <= nCount; i += 4) {
+		// 単色にする場合は、アルファだけ残して色を入れ替える
+		const __m128i src = _mm_or_si128( _mm_and_si128( _mm_loadu_si128( (const __m128i*)(pnSrc + i) ), keep ), solid );
+		__m128i v[2];
+		__m128i a;
+		__m128i rc;
+		uint32_t j;
+
+		v[0] = _mm_unpacklo_epi8( src, zero );
+		v[1] = _mm_unpackhi_epi8( src, zero );
+		for(j = 0; j < 2; j++) {
+			// 輝度を各チャンネルに並べる
+			__m128i lum = _mm_madd_epi16( v[j], weight );
+			lum = _mm_add_epi32( lum, _mm_shuffle_epi32( lum, _MM_SHUFFLE(2, 3, 0, 1) ) );
+			lum = _mm_srai_epi32( lum, 8 );
+			lum = _mm_or_si128( lum, _mm_slli_epi32( lum, 16 ) );
+			// 彩度
+			v[j] = _mm_add_epi16( lum, _mm_mulhi_epi16( _mm_slli_epi16( _mm_sub_epi16( v[j], lum ), 4 ), color ) );
+			// 反転(255 - v = ~v + 256)
+			v[j] = _mm_add_epi16( _mm_xor_si128( v[j], invert ), invadd );
+			// 加算と乗算
+			v[j] = _mm_mulhi_epi16( _mm_slli_epi16( _mm_add_epi16( v[j], add ), 4 ), mul );
+		}
+		rc = _mm_packus_epi16( v[0], v[1] );
+		// アルファは32bitのまま乗算する(255 * 256でも16bitに収まる)
+		a = _mm_srli_epi32( _mm_mullo_epi16( _mm_srli_epi32( src, 24 ), amul ), 8 );
+		rc = _mm_or_si128( _mm_andnot_si128( alpha, rc ), _mm_slli_epi32( a, 24 ) );
+		_mm_storeu_si128( (__m128i*)(pnDest + i), rc );
+	}
+	return i;
+}
+#endif
+
+//! パラメータを何もしない値で初期化する
+/*!
+	@param[out]	pParam	パラメータ
+*/
+void
+Cat_PaletteEffectParamInit( Cat_PaletteEffectParam* pParam )
+{
+	uint32_t i;
+
+	if(pParam == 0) {
+		return;
+	}
+	memset( pParam, 0, sizeof(Cat_PaletteEffectParam) );
+	for(i = 0; i < 3; i++) {
+		pParam->nMul[i] = CAT_PALETTEEFFECT_UNIT;
+	}
+	pParam->nColor = CAT_PALETTEEFFECT_UNIT;
+	pParam->nAlpha = CAT_PALETTEEFFECT_UNIT;
+}
+
+//! パラメータが何もしない値かどうか
+/*!
+	@param[in]	pParam	パラメータ
+	@return	何もしない値なら0以外を返す
+*/
+int32_t
+Cat_PaletteEffectParamIsIdentity( const Cat_PaletteEffectParam* pParam )
+{
+	Key key;
+
+	if(pParam == 0) {
+		return 1;
+	}
+	MakeKey( &key, pParam );
+	return IsIdentity( &key );
+}
+
+//! 正弦波を計算した後のパラメータでエフェクトをかける
+static int32_t
+ApplyKey( Cat_Palette* pDest, const Cat_Palette* pSource, const Key* pKey )
+{
+	const uint32_t nCount = pSource->nMask + 1;
+	uint32_t anWork[256];
+	const uint32_t* pnSrc;
+	uint32_t* pnDest;
+	uint32_t i = 0;
+
+	if((pDest->ePaletteFormat != pSource->ePaletteFormat) || (pDest->nMask != pSource->nMask)) {
+		return -1;
+	}
+	if((pDest->pvData == 0) || (pSource->pvData == 0) || (nCount > 256)) {
+		return -1;
+	}
+
+	if(pSource->ePaletteFormat == FORMAT_PALETTE_8888) {
+		pnSrc  = (const uint32_t*)pSource->pvData;
+		pnDest = (uint32_t*)pDest->pvData;
+	} else {
+		// 16bitのパレットは、一度32bitに広げる
+		Cat_ColorConvert( anWork, FORMAT_PIXEL_8888, pSource->pvData, (FORMAT_PIXEL)pSource->ePaletteFormat, nCount );
+		pnSrc  = anWork;
+		pnDest = anWork;
+	}
+#if defined(USE_CAT_PALETTEEFFECT_SSE2)
+	i = Apply8888SSE2( pnDest, pnSrc, nCount, pKey );
+#endif
+	Apply8888( pnDest + i, pnSrc + i, nCount - i, pKey );
+	if(pSource->ePaletteFormat != FORMAT_PALETTE_8888) {
+		Cat_ColorConvert( pDest->pvData, (FORMAT_PIXEL)pDest->ePaletteFormat, anWork, FORMAT_PIXEL_8888, nCount );
+	}
+	Cat_PaletteUpdate( pDest );
+	return 0;
+}
+
+//! パレットにエフェクトをかける
+/*!
+	ホストではSSE2で4色ずつ、PSPではスカラーで変換する。結果はどちらも同じになる。
+	@param[out]	pDest		出力先のパレット(\a pSource と同じフォーマットと色数)
+	@param[in]	pSource		元のパレット
+	@param[in]	pParam		パラメータ
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+int32_t
+Cat_PaletteEffectApply( Cat_Palette* pDest, const Cat_Palette* pSource, const Cat_PaletteEffectParam* pParam )
+{
+	Key key;
+
+	if((pDest == 0) || (pSource == 0) || (pParam == 0)) {
+		return -1;
+	}
+	MakeKey( &key, pParam );
+	return ApplyKey( pDest, pSource, &key );
+}
+
+//! キャッシュを作成する
+/*!
+	@param[in]	nCount	保持するパレットの数
+	@return	作成されたキャッシュ。失敗した場合は0が返る。
+	@see	Cat_PaletteEffectCacheDestroy()
+*/
+Cat_PaletteEffectCache*
+Cat_PaletteEffectCacheCreate( uint32_t nCount )
+{
+	Cat_PaletteEffectCache* rc;
+
+	if(nCount == 0) {
+		return 0;
+	}
+	rc = (Cat_PaletteEffectCache*)CAT_MALLOC( sizeof(Cat_PaletteEffectCache) );
+	if(rc == 0) {
+		return 0;
+	}
+	memset( rc, 0, sizeof(Cat_PaletteEffectCache) );
+	rc->pEntry = (Entry*)CAT_MALLOC( sizeof(Entry) * nCount );
+	if(rc->pEntry == 0) {
+		CAT_FREE( rc );
+		return 0;
+	}
+	memset( rc->pEntry, 0, sizeof(Entry) * nCount );
+	rc->nCount = nCount;
+	rc->nFrame = 1;
+	return rc;
+}
+
+//! キャッシュを破棄する
+/*!
+	@param[in]	pCache	キャッシュ
+*/
+void
+Cat_PaletteEffectCacheDestroy( Cat_PaletteEffectCache* pCache )
+{
+	uint32_t i;
+
+	if(pCache == 0) {
+		return;
+	}
+	for(i = 0; i < pCache->nCount; i++) {
+		Cat_PaletteRelease( pCache->pEntry[i].pPalette );
+		Cat_PaletteRelease( pCache->pEntry[i].pSource );
+	}
+	CAT_FREE( pCache->pEntry );
+	CAT_FREE( pCache );
+}
+
+//! エフェクトをかけたパレットを取得する
+/*!
+	元のパレットとその更新カウンタ、正弦波を計算した後のパラメータが同じなら、前に作ったパレットを返す。 \n
+	無ければ、最後に使われたのが古い場所に作る。 \n
+	このフレームと前のフレームで使った場所は上書きしない(前のフレームのパケットは、GEが描画中で読んでいる)。 \n
+	返したパレットは、2フレーム後以降に上書きされるかもしれないので、 \n
+	続けて使う場合は毎フレーム取得し直すか、Cat_PaletteAddRef()で保持すること。
+	@param[in]	pCache		キャッシュ
+	@param[in]	pSource		元のパレット
+	@param[in]	pParam		パラメータ
+	@return	エフェクトをかけたパレット。何もしないパラメータの場合と、 \n
+			場所が足りない場合と、失敗した場合は \a pSource が返る。
+*/
+Cat_Palette*
+Cat_PaletteEffectCacheGet( Cat_PaletteEffectCache* pCache, Cat_Palette* pSource, const Cat_PaletteEffectParam* pParam )
+{
+	Entry* pVictim = 0;
+	Key key;
+	uint32_t i;
+
+	if((pCache == 0) || (pSource == 0) || (pParam == 0)) {
+		return pSource;
+	}
+	MakeKey( &key, pParam );
+	if(IsIdentity( &key )) {
+		return pSource;
+	}
+	pCache->statistics.nRequestCount++;
+	pCache->nClock++;
+
+	for(i = 0; i < pCache->nCount; i++) {
+		Entry* pEntry = &pCache->pEntry[i];
+		if((pEntry->pSource == pSource) && (pEntry->nSerial == pSource->nSerial)
+			&& (memcmp( &pEntry->key, &key, sizeof(Key) ) == 0)) {
+			pEntry->nLastFrame = pCache->nFrame;
+			pEntry->nLastUse   = pCache->nClock;
+			pCache->statistics.nHitCount++;
+			return pEntry->pPalette;
+		}
+		// 空いている場所か、このフレームと前のフレームで使っていない一番古い場所に作る
+		if(pEntry->pPalette == 0) {
+			if((pVictim == 0) || pVictim->pPalette) {
+				pVictim = pEntry;
+			}
+		} else if((pCache->nFrame - pEntry->nLastFrame >= CAT_PALETTEEFFECT_KEEP_FRAME)
+			&& ((pVictim == 0) || (pVictim->pPalette && (pEntry->nLastUse < pVictim->nLastUse)))) {
+			pVictim = pEntry;
+		}
+	}
+	if(pVictim == 0) {
+		pCache->statistics.nOverflowCount++;
+		return pSource;
+	}
+
+	// 誰も使っていなくて形が同じなら、パレットを作り直さずに上書きする
+	if(pVictim->pPalette
+		&& ((pVictim->pPalette->nRef != 1)
+			|| (pVictim->pPalette->ePaletteFormat != pSource->ePaletteFormat)
+			|| (pVictim->pPalette->nMask != pSource->nMask))) {
+		Cat_PaletteRelease( pVictim->pPalette );
+		pVictim->pPalette = 0;
+	}
+	if(pVictim->pPalette == 0) {
+		pVictim->pPalette = Cat_PaletteCreate( pSource->ePaletteFormat, pSource->nMask + 1, 0 );
+	}
+	Cat_PaletteAddRef( pSource );
+	Cat_PaletteRelease( pVictim->pSource );
+	pVictim->pSource = pSource;
+	if((pVictim->pPalette == 0) || (ApplyKey( pVictim->pPalette, pSource, &key ) < 0)) {
+		Cat_PaletteRelease( pVictim->pPalette );
+		Cat_PaletteRelease( pVictim->pSource );
+		pVictim->pPalette = 0;
+		pVictim->pSource  = 0;
+		return pSource;
+	}
+	pVictim->nSerial    = pSource->nSerial;
+	pVictim->key        = key;
+	pVictim->nLastFrame = pCache->nFrame;
+	pVictim->nLastUse   = pCache->nClock;
+	pCache->statistics.nBuildCount++;
+	return pVictim->pPalette;
+}
+
+//! フレームを進める
+/*!
+	1フレームに1回、Cat_RenderScreenUpdate()の後に呼ぶ。
+	@param[in]	pCache	キャッシュ
+*/
+void
+Cat_PaletteEffectCacheUpdate( Cat_PaletteEffectCache* pCache )
+{
+	if(pCache) {
+		pCache->nFrame++;
+	}
+}
+
+//! 統計情報を取得する
+/*!
+	@param[in]	pCache			キャッシュ
+	@param[out]	pStatistics		統計情報
+*/
+void
+Cat_PaletteEffectCacheGetStatistics( Cat_PaletteEffectCache* pCache, Cat_PaletteEffectStatistics* pStatistics )
+{
+	uint32_t i;
+
+	if((pCache == 0) || (pStatistics == 0)) {
+		return;
+	}
+	*pStatistics = pCache->statistics;
+	pStatistics->nUsedCount = 0;
+	for(i = 0; i < pCache->nCount; i++) {
+		if(pCache->pEntry[i].pPalette) {
+			pStatistics->nUsedCount++;
+		}
+	}
+}
+
+//! 統計情報の回数をクリアする
+/*!
+	@param[in]	pCache	キャッシュ
+*/
+void
+Cat_PaletteEffectCacheResetStatistics( Cat_PaletteEffectCache* pCache )
+{
+	if(pCache) {
+		memset( &pCache->statistics, 0, sizeof(pCache->statistics) );
+	}
+}
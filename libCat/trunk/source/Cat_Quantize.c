@@ -0,0 +1,481 @@
+//! @file	Cat_Quantize.c
+// 32bitイメージの減色
+//
+// RGB各5bitのヒストグラムをメディアンカットで分割してパレットを作る。
+// 近い色を探す表も同じRGB各5bitの立方体で、変換するイメージが使う所だけ計算する。
+
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>	// for memalign
+#include "Cat_Quantize.h"
+
+#ifndef CAT_MALLOC
+//! メモリ確保マクロ
+#define CAT_MALLOC(x) memalign( 32, (x) )
+#endif // CAT_MALLOC
+
+#ifndef CAT_FREE
+//! メモリ解放マクロ
+#define CAT_FREE(x) free( x )
+#endif // CAT_FREE
+
+//! ヒストグラムの1辺の大きさ
+#define CAT_QUANTIZE_SIDE (32)
+//! ヒストグラムの升目の数
+#define CAT_QUANTIZE_CELL (CAT_QUANTIZE_SIDE * CAT_QUANTIZE_SIDE * CAT_QUANTIZE_SIDE)
+//! 元の色を数えるハッシュの大きさ(2の乗数)
+#define CAT_QUANTIZE_HASH (1024)
+
+//! 色から升目の番号にする
+#define CELL(c)	((((c) >> 3) & 0x1F) | (((c) >> 6) & 0x3E0) | (((c) >> 9) & 0x7C00))
+//! 色からハッシュの位置にする
+#define HASH(c)	((((c) * 0x9E3779B1U) >> 22) & (CAT_QUANTIZE_HASH - 1))
+
+//! ヒストグラム
+typedef struct {
+	uint32_t	nCount[CAT_QUANTIZE_CELL];		/*!< ピクセル数			*/
+	uint32_t	nSum[CAT_QUANTIZE_CELL][3];		/*!< R,G,Bの合計		*/
+} Histogram;
+
+//! メディアンカットの箱
+typedef struct {
+	uint32_t	lo[3];		/*!< R,G,Bの下限(5bit)	*/
+	uint32_t	hi[3];		/*!< R,G,Bの上限(5bit)	*/
+	uint32_t	nCount;		/*!< ピクセル数			*/
+} Box;
+
+//! 升目の番号
+static inline uint32_t
+CellIndex( uint32_t r, uint32_t g, uint32_t b )
+{
+	return r | (g << 5) | (b << 10);
+}
+
+//! 箱を中身のある範囲に縮めて、ピクセル数を数える
+/*!
+	@param[in]		pHistogram	ヒストグラム
+	@param[in,out]	pBox		箱
+*/
+static void
+ShrinkBox( const Histogram* pHistogram, Box* pBox )
+{
+	uint32_t lo[3] = { CAT_QUANTIZE_SIDE, CAT_QUANTIZE_SIDE, CAT_QUANTIZE_SIDE };
+	uint32_t hi[3] = { 0, 0, 0 };
+	uint32_t nCount = 0;
+	uint32_t r;
+	uint32_t g;
+	uint32_t b;
+
+	for(b = pBox->lo[2]; b <= pBox->hi[2]; b++) {
+		for(g = pBox->lo[1]; g <= pBox->hi[1]; g++) {
+			for(r = pBox->lo[0]; r <= pBox->hi[0]; r++) {
+				const uint32_t n = pHistogram->nCount[CellIndex( r, g, b )];
+				if(n == 0) {
+					continue;
+				}
+				nCount += n;
+				if(r < lo[0]) { lo[0] = r; }
+				if(r > hi[0]) { hi[0] = r; }
+				if(g < lo[1]) { lo[1] = g; }
+				if(g > hi[1]) { hi[1] = g; }
+				if(b < lo[2]) { lo[2] = b; }
+				if(b > hi[2]) { hi[2] = b; }
+			}
+		}
+	}
+	if(nCount) {
+		memcpy( pBox->lo, lo, sizeof(lo) );
+		memcpy( pBox->hi, hi, sizeof(hi) );
+	}
+	pBox->nCount = nCount;
+}
+
+//! 箱を一番長い辺の中央値で2つに分ける
+/*!
+	@param[in]		pHistogram	ヒストグラム
+	@param[in,out]	pBox		分ける箱(前半になる)
+	@param[out]		pNew		後半の箱
+*/
+static void
+SplitBox( const Histogram* pHistogram, Box* pBox, Box* pNew )
+{
+	uint32_t nSlice[CAT_QUANTIZE_SIDE];
+	uint32_t nAxis = 0;
+	uint32_t nSum = 0;
+	uint32_t c[3];
+	uint32_t i;
+	uint32_t s;
+
+	for(i = 1; i < 3; i++) {
+		if(pBox->hi[i] - pBox->lo[i] > pBox->hi[nAxis] - pBox->lo[nAxis]) {
+			nAxis = i;
+		}
+	}
+
+	// 分ける軸に沿ってピクセル数を数える
+	memset( nSlice, 0, sizeof(nSlice) );
+	for(c[2] = pBox->lo[2]; c[2] <= pBox->hi[2]; c[2]++) {
+		for(c[1] = pBox->lo[1]; c[1] <= pBox->hi[1]; c[1]++) {
+			for(c[0] = pBox->lo[0]; c[0] <= pBox->hi[0]; c[0]++) {
+				nSlice[c[nAxis]] += pHistogram->nCount[CellIndex( c[0], c[1], c[2] )];
+			}
+		}
+	}
+	for(s = pBox->lo[nAxis]; s < pBox->hi[nAxis]; s++) {
+		nSum += nSlice[s];
+		if(nSum * 2 >= pBox->nCount) {
+			break;
+		}
+	}
+	if(s >= pBox->hi[nAxis]) {
+		s = pBox->hi[nAxis] - 1;
+	}
+
+	*pNew = *pBox;
+	pBox->hi[nAxis] = s;
+	pNew->lo[nAxis] = s + 1;
+	ShrinkBox( pHistogram, pBox );
+	ShrinkBox( pHistogram, pNew );
+}
+
+//! メディアンカットでパレットを作る
+/*!
+	@param[in]		pHistogram	ヒストグラム
+	@param[out]		pnPalette	パレット
+	@param[in]		nColorMax	色数の上限
+	@return	作った色数
+*/
+static uint32_t
+MedianCut( const Histogram* pHistogram, uint32_t* pnPalette, uint32_t nColorMax )
+{
+	Box box[CAT_QUANTIZE_COLOR_MAX];
+	uint32_t nBox = 1;
+	uint32_t i;
+
+	box[0].lo[0] = box[0].lo[1] = box[0].lo[2] = 0;
+	box[0].hi[0] = box[0].hi[1] = box[0].hi[2] = CAT_QUANTIZE_SIDE - 1;
+	ShrinkBox( pHistogram, &box[0] );
+	if(box[0].nCount == 0) {
+		return 0;
+	}
+
+	while(nBox < nColorMax) {
+		// ピクセル数と大きさが一番大きい箱を分ける
+		uint32_t nBest = 0;
+		uint32_t nTarget = nBox;
+		for(i = 0; i < nBox; i++) {
+			uint32_t nLength = 0;
+			uint32_t j;
+			for(j = 0; j < 3; j++) {
+				if(box[i].hi[j] - box[i].lo[j] > nLength) {
+					nLength = box[i].hi[j] - box[i].lo[j];
+				}
+			}
+			if(nLength && (box[i].nCount * nLength > nBest)) {
+				nBest = box[i].nCount * nLength;
+				nTarget = i;
+			}
+		}
+		if(nTarget == nBox) {
+			break;	// これ以上分けられない
+		}
+		SplitBox( pHistogram, &box[nTarget], &box[nBox] );
+		nBox++;
+	}
+
+	// 箱の中の色の平均をパレットにする
+	for(i = 0; i < nBox; i++) {
+		uint32_t nSum[3] = { 0, 0, 0 };
+		uint32_t r;
+		uint32_t g;
+		uint32_t b;
+		for(b = box[i].lo[2]; b <= box[i].hi[2]; b++) {
+			for(g = box[i].lo[1]; g <= box[i].hi[1]; g++) {
+				for(r = box[i].lo[0]; r <= box[i].hi[0]; r++) {
+					const uint32_t n = CellIndex( r, g, b );
+					nSum[0] += pHistogram->nSum[n][0];
+					nSum[1] += pHistogram->nSum[n][1];
+					nSum[2] += pHistogram->nSum[n][2];
+				}
+			}
+		}
+		pnPalette[i] = 0xFF000000
+			| ((nSum[0] + box[i].nCount / 2) / box[i].nCount)
+			| (((nSum[1] + box[i].nCount / 2) / box[i].nCount) << 8)
+			| (((nSum[2] + box[i].nCount / 2) / box[i].nCount) << 16);
+	}
+	return nBox;
+}
+
+//! 一番近いパレットの色を探す
+/*!
+	@param[in]	pQuantize	減色
+	@param[in]	nColor		色(RGBA8888)
+	@return	パレット番号
+*/
+static uint32_t
+FindNearest( const Cat_Quantize* pQuantize, uint32_t nColor )
+{
+	const int32_t r = nColor & 0xFF;
+	const int32_t g = (nColor >> 8) & 0xFF;
+	const int32_t b = (nColor >> 16) & 0xFF;
+	uint32_t nBest = 0xFFFFFFFF;
+	uint32_t rc = 0;
+	uint32_t i;
+
+	for(i = 0; i < pQuantize->nColorCount; i++) {
+		const uint32_t p = pQuantize->anPalette[i];
+		int32_t d;
+		uint32_t nDistance;
+		if((int32_t)i == pQuantize->nTransparent) {
+			continue;
+		}
+		d = r - (int32_t)(p & 0xFF);
+		nDistance = d * d;
+		d = g - (int32_t)((p >> 8) & 0xFF);
+		nDistance += d * d;
+		d = b - (int32_t)((p >> 16) & 0xFF);
+		nDistance += d * d;
+		if(nDistance < nBest) {
+			nBest = nDistance;
+			rc = i;
+		}
+	}
+	return rc;
+}
+
+//! イメージからパレットを作る
+/*!
+	@param[in]	pvImage		イメージ(RGBA8888)
+	@param[in]	nWidth		横幅(ピクセル単位)
+	@param[in]	nHeight		高さ(ピクセル単位)
+	@param[in]	nPitch		1ラインのバイト数
+	@param[in]	nColorMax	パレットの色数の上限(CAT_QUANTIZE_COLOR_MAX以下)
+	@return	作成された減色。半透明のピクセルがある場合や、失敗した場合は0が返る。
+	@see	Cat_QuantizeRelease()
+*/
+Cat_Quantize*
+Cat_QuantizeCreate( const void* pvImage, uint32_t nWidth, uint32_t nHeight, uint32_t nPitch, uint32_t nColorMax )
+{
+	Cat_Quantize* rc;
+	Histogram* pHistogram;
+	uint32_t* pnHash;
+	uint32_t nUnique = 0;
+	uint32_t fTransparent = 0;
+	uint32_t x;
+	uint32_t y;
+
+	if((pvImage == 0) || (nColorMax < 2) || (nColorMax > CAT_QUANTIZE_COLOR_MAX)) {
+		return 0;
+	}
+
+	rc = (Cat_Quantize*)CAT_MALLOC( sizeof(Cat_Quantize) );
+	pHistogram = (Histogram*)CAT_MALLOC( sizeof(Histogram) );
+	pnHash = (uint32_t*)CAT_MALLOC( sizeof(uint32_t) * CAT_QUANTIZE_HASH );
+	if((rc == 0) || (pHistogram == 0) || (pnHash == 0)) {
+		goto error;
+	}
+	memset( rc, 0, sizeof(Cat_Quantize) );
+	memset( pHistogram, 0, sizeof(Histogram) );
+	memset( pnHash, 0, sizeof(uint32_t) * CAT_QUANTIZE_HASH );
+	rc->nTransparent = -1;
+
+	// ヒストグラムを作りながら、元の色をパレットに収まるまで数える
+	for(y = 0; y < nHeight; y++) {
+		const uint32_t* pnSrc = (const uint32_t*)((const uint8_t*)pvImage + nPitch * y);
+		uint32_t nLast = 0;
+		for(x = 0; x < nWidth; x++) {
+			const uint32_t c = pnSrc[x];
+			const uint32_t a = c >> 24;
+			uint32_t n;
+			if(a == 0) {
+				fTransparent = 1;
+				continue;
+			} else if(a != 0xFF) {
+				goto error;		// 半透明はパレットにできない
+			}
+			n = CELL( c );
+			pHistogram->nCount[n]++;
+			pHistogram->nSum[n][0] += c & 0xFF;
+			pHistogram->nSum[n][1] += (c >> 8) & 0xFF;
+			pHistogram->nSum[n][2] += (c >> 16) & 0xFF;
+
+			if((c == nLast) || (nUnique > nColorMax)) {
+				continue;
+			}
+			nLast = c;
+			for(n = HASH( c ); pnHash[n] && (pnHash[n] != c); n = (n + 1) & (CAT_QUANTIZE_HASH - 1)) {
+			}
+			if(pnHash[n] == 0) {
+				pnHash[n] = c;
+				nUnique++;
+			}
+		}
+	}
+
+	if(fTransparent) {
+		rc->nTransparent = 0;
+		rc->anPalette[0] = 0;
+		rc->nColorCount  = 1;
+	}
+	if(nUnique + rc->nColorCount <= nColorMax) {
+		// 元の色がそのままパレットに収まる
+		for(x = 0; x < CAT_QUANTIZE_HASH; x++) {
+			if(pnHash[x]) {
+				rc->anPalette[rc->nColorCount++] = pnHash[x];
+			}
+		}
+		rc->fExact = 1;
+	} else {
+		rc->nColorCount += MedianCut( pHistogram, rc->anPalette + rc->nColorCount, nColorMax - rc->nColorCount );
+	}
+	CAT_FREE( pnHash );
+	CAT_FREE( pHistogram );
+	return rc;
+
+error:
+	if(pnHash) {
+		CAT_FREE( pnHash );
+	}
+	if(pHistogram) {
+		CAT_FREE( pHistogram );
+	}
+	if(rc) {
+		CAT_FREE( rc );
+	}
+	return 0;
+}
+
+//! 減色を解放する
+/*!
+	@param[in]	pQuantize	減色
+*/
+void
+Cat_QuantizeRelease( Cat_Quantize* pQuantize )
+{
+	if(pQuantize == 0) {
+		return;
+	}
+	if(pQuantize->pnCube) {
+		CAT_FREE( pQuantize->pnCube );
+	}
+	if(pQuantize->pnCubeValid) {
+		CAT_FREE( pQuantize->pnCubeValid );
+	}
+	CAT_FREE( pQuantize );
+}
+
+//! イメージをパレット番号に変換する
+/*!
+	一番近いパレットの色は、RGB各5bitの表で引く。表は使った所だけ計算する。 \n
+	元の色との誤差を nError と nSample に加算する。透明なピクセルは誤差に含めない。
+	@param[in]	pQuantize	減色
+	@param[out]	pvDest		出力先(1ピクセル1バイト)
+	@param[in]	nDestPitch	出力先の1ラインのバイト数
+	@param[in]	pvImage		イメージ(RGBA8888)
+	@param[in]	nWidth		横幅(ピクセル単位)
+	@param[in]	nHeight		高さ(ピクセル単位)
+	@param[in]	nPitch		1ラインのバイト数
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+int32_t
+Cat_QuantizeMapImage( Cat_Quantize* pQuantize, void* pvDest, uint32_t nDestPitch, const void* pvImage, uint32_t nWidth, uint32_t nHeight, uint32_t nPitch )
+{
+	uint32_t nHashColor[CAT_QUANTIZE_HASH];
+	uint8_t nHashIndex[CAT_QUANTIZE_HASH];
+	uint64_t nError = 0;
+	uint32_t nSample = 0;
+	uint32_t x;
+	uint32_t y;
+
+	if((pQuantize == 0) || (pvDest == 0) || (pvImage == 0) || (pQuantize->nColorCount == 0)) {
+		return -1;
+	}
+	if(pQuantize->pnCube == 0) {
+		pQuantize->pnCube = (uint8_t*)CAT_MALLOC( CAT_QUANTIZE_CELL );
+		pQuantize->pnCubeValid = (uint32_t*)CAT_MALLOC( CAT_QUANTIZE_CELL / 8 );
+		if((pQuantize->pnCube == 0) || (pQuantize->pnCubeValid == 0)) {
+			return -1;
+		}
+		memset( pQuantize->pnCubeValid, 0, CAT_QUANTIZE_CELL / 8 );
+	}
+
+	// 元の色がパレットにあれば、表を使わずにそのまま引く
+	memset( nHashColor, 0, sizeof(nHashColor) );
+	if(pQuantize->fExact) {
+		for(x = 0; x < pQuantize->nColorCount; x++) {
+			const uint32_t c = pQuantize->anPalette[x];
+			uint32_t n;
+			if((int32_t)x == pQuantize->nTransparent) {
+				continue;
+			}
+			for(n = HASH( c ); nHashColor[n]; n = (n + 1) & (CAT_QUANTIZE_HASH - 1)) {
+			}
+			nHashColor[n] = c;
+			nHashIndex[n] = (uint8_t)x;
+		}
+	}
+
+	for(y = 0; y < nHeight; y++) {
+		const uint32_t* pnSrc = (const uint32_t*)((const uint8_t*)pvImage + nPitch * y);
+		uint8_t* pnDest = (uint8_t*)pvDest + nDestPitch * y;
+		uint32_t nLast = 0;
+		uint32_t nLastIndex = (pQuantize->nTransparent >= 0) ? (uint32_t)pQuantize->nTransparent : 0;
+		uint32_t nLastError = 0;
+		for(x = 0; x < nWidth; x++) {
+			const uint32_t c = pnSrc[x];
+			uint32_t nIndex;
+			uint32_t n;
+			if((c >> 24) == 0) {
+				if(pQuantize->nTransparent >= 0) {
+					pnDest[x] = (uint8_t)pQuantize->nTransparent;
+					continue;
+				}
+			} else {
+				nSample += 3;
+			}
+			if(c == nLast) {
+				pnDest[x] = (uint8_t)nLastIndex;
+				nError += nLastError;
+				continue;
+			}
+
+			nIndex = CAT_QUANTIZE_COLOR_MAX;
+			if(pQuantize->fExact) {
+				for(n = HASH( c ); nHashColor[n]; n = (n + 1) & (CAT_QUANTIZE_HASH - 1)) {
+					if(nHashColor[n] == c) {
+						nIndex = nHashIndex[n];
+						break;
+					}
+				}
+			}
+			if(nIndex == CAT_QUANTIZE_COLOR_MAX) {
+				// 升目の中心に一番近い色を使う
+				n = CELL( c );
+				if(!(pQuantize->pnCubeValid[n >> 5] & (1UL << (n & 31)))) {
+					pQuantize->pnCube[n] = (uint8_t)FindNearest( pQuantize, (c & 0xF8F8F8) | 0x040404 );
+					pQuantize->pnCubeValid[n >> 5] |= 1UL << (n & 31);
+				}
+				nIndex = pQuantize->pnCube[n];
+			}
+
+			nLastError = 0;
+			if(c >> 24) {
+				const uint32_t p = pQuantize->anPalette[nIndex];
+				uint32_t i;
+				for(i = 0; i < 24; i += 8) {
+					const int32_t d = (int32_t)((c >> i) & 0xFF) - (int32_t)((p >> i) & 0xFF);
+					nLastError += d * d;
+				}
+			}
+			nError += nLastError;
+			nLast = c;
+			nLastIndex = nIndex;
+			pnDest[x] = (uint8_t)nIndex;
+		}
+	}
+	pQuantize->nError  += nError;
+	pQuantize->nSample += nSample;
+	return 0;
+}
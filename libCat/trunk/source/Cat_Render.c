@@ -4,28 +4,231 @@
 //! @todo シングルバッファの時の処理
 
 #include <pspgu.h>
+#include <pspge.h>
 #include <pspdisplay.h>
+#include <psputils.h>
+#include <pspthreadman.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>	// for memalign
 #include "Cat_Render.h"
+#include "Cat_Texture.h"
+#include "Cat_RenderState.h"
 
 //! 実スクリーンサイズ 横幅
 #define CAT_SCREEN_WIDTH  (480)
 //! 実スクリーンサイズ 縦幅
 #define CAT_SCREEN_HEIGHT (272)
 
-//! 描画パケットサイズ(バイト単位。4の倍数であること)
-#define PACKETSIZE (1024*1024)
+#ifndef CAT_MALLOC
+//! メモリ確保マクロ
+#define CAT_MALLOC(x) memalign( 64, (x) )
+#endif // CAT_MALLOC
 
-//! 描画パケットバッファ0
-static uint32_t __attribute__((aligned(64))) disp_list0[PACKETSIZE/4];
-//! 描画パケットバッファ1
-static uint32_t __attribute__((aligned(64))) disp_list1[PACKETSIZE/4];
+#ifndef CAT_FREE
+//! メモリ解放マクロ
+#define CAT_FREE(x) free( x )
+#endif // CAT_FREE
+
+//! 分割の後ろに空けておくサイズ(確保の後に積む設定とsceGuDrawArray()、sceGuFinish()の分)
+#define CAT_RENDER_LIST_MARGIN (1024)
+
+//! 1フレーム分の描画パケット
+typedef struct {
+	uint32_t	nSegment;									/*!< 使っている分割の数			*/
+	uint32_t	anSegment[CAT_RENDER_LIST_SEGMENT_MAX];		/*!< 使っている分割の番号		*/
+} Frame;
+
+//! 描画パケットのメモリ
+static uint8_t* gpbList = 0;
+//! 描画パケットに使うメモリ
+static uint32_t gnListBudget = CAT_RENDER_LIST_BUDGET;
+//! 分割する大きさ
+static uint32_t gnSegmentSize = CAT_RENDER_LIST_SEGMENT_SIZE;
+//! 分割の数
+static uint32_t gnSegmentCount = 0;
+//! 空いている分割の番号
+static uint32_t gnFreeSegment[CAT_RENDER_LIST_SEGMENT_MAX];
+//! 空いている分割の数
+static uint32_t gnFreeCount = 0;
+//! 描画パケット(作成中と描画中)
+static Frame gFrame[2];
+//! 今のフレームで確保できなくなったかどうか
+static int gfListFull = 0;
+//! 今のフレームで閉じた分割のサイズの合計
+static uint32_t gnListSize = 0;
+//! 描画パケットの統計情報
+static Cat_RenderListStatistics gListStatistics;
 //! 作業用パケットバッファ
 static uint32_t __attribute__((aligned(64))) disp_list[1024];
+//! 確保できなくなった後の設定を受け流すパケットバッファ(GEには渡さない)
+static uint32_t __attribute__((aligned(64))) disp_sink[CAT_RENDER_LIST_MARGIN * 2 / 4];
+
+//! Cat_RenderBegin()の外で確保する関数
+static Cat_RenderMemoryFunc gpfnMemory = 0;
+//! Cat_RenderBegin()の外で確保する関数に渡す値
+static void* gpvMemoryContext = 0;
+//! Cat_RenderScreenUpdate()した回数
+static uint32_t gnFrame = 0;
 
 //! 描画パケット切り替え
 static int fSW = 0;
 //! パケットネストカウンタ
 static int nEnter = 0;
+//! 空いているVRAMの位置
+static uint32_t gnVramOffset = 0;
+//! テクスチャを置くVRAMの領域管理
+static Cat_Vram* gpVram = 0;
+//! フレームバッファのピクセルフォーマット(GU_PSM_xxx)
+static int32_t gnFormat = GU_PSM_8888;
+//! フレームバッファ1枚のサイズ(ダブルバッファの2枚目の位置、シングルバッファの場合は0)
+static uint32_t gnBackOffset = 0;
+//! 描画先の位置(確保していない場合は0)
+static uint32_t gnTargetOffset = 0;
+//! 描画先に切り替えているかどうか
+static int gfTarget = 0;
+
+//! 作成中のフレームの統計情報
+static Cat_RenderFrameStatistics gFrameCurrent;
+//! 終わったフレームの統計情報(リングバッファ)
+static Cat_RenderFrameStatistics gFrameHistory[CAT_RENDER_FRAME_HISTORY];
+//! 次に書き込むフレームの統計情報の位置
+static uint32_t gnFrameHistory = 0;
+//! 書き込んだフレームの統計情報の数(CAT_RENDER_FRAME_HISTORYまで)
+static uint32_t gnFrameHistoryCount = 0;
+//! Cat_RenderBegin()した時間
+static uint32_t gnFrameStart = 0;
+//! 描画するピクセル数を見積もるかどうか
+static int gfPixelCount = 0;
+
+//! 分割のアドレスを取得する
+/*!
+	@param[in]	nSegment	分割の番号
+	@return	アドレス
+*/
+static void*
+GetSegment( uint32_t nSegment )
+{
+	return gpbList + nSegment * gnSegmentSize;
+}
+
+//! フレームが使っている分割を空きに戻す
+/*!
+	GEがそのフレームを描画し終わっていること。
+	@param[in]	pFrame	フレーム
+*/
+static void
+ReleaseFrame( Frame* pFrame )
+{
+	uint32_t i;
+
+	for(i = 0; i < pFrame->nSegment; i++) {
+		gnFreeSegment[gnFreeCount++] = pFrame->anSegment[i];
+	}
+	pFrame->nSegment = 0;
+}
+
+//! 作成中のフレームに分割を足して、描画パケットを始める
+/*!
+	空きが無い場合は、描画中のフレームが終わるのを待って、その分割を使う。
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+static int32_t
+StartSegment( void )
+{
+	Frame* pFrame = &gFrame[fSW];
+	uint32_t nSegment;
+
+	if((gnFreeCount == 0) && gFrame[fSW ^ 1].nSegment) {
+		sceGuSync( 0, 0 );
+		ReleaseFrame( &gFrame[fSW ^ 1] );
+		gListStatistics.nStallCount++;
+	}
+	if((gnFreeCount == 0) || (pFrame->nSegment >= CAT_RENDER_LIST_SEGMENT_MAX)) {
+		return -1;
+	}
+	nSegment = gnFreeSegment[--gnFreeCount];
+	pFrame->anSegment[pFrame->nSegment++] = nSegment;
+	sceGuStart( GU_CALL, (void*)((uintptr_t)GetSegment( nSegment ) | 0x40000000) );
+	return 0;
+}
+
+//! 確保できなくなった後の設定を、捨てるパケットに積むようにする
+/*!
+	閉じたパケットの後ろに積まれて溢れないように、描画しないパケットを開いておく。 \n
+	Cat_RenderGetMemory()のたびに先頭から積み直すので、間に積まれる設定の分だけあれば足りる。
+*/
+static void
+StartSink( void )
+{
+	sceGuStart( GU_CALL, (void*)((uintptr_t)disp_sink | 0x40000000) );
+	gfListFull = 1;
+}
+
+//! 今の分割に空きを確保する
+/*!
+	収まらない場合は、sceGuFinish()して次の分割につなぐ。
+	@param[in]	nNeed	空けておくサイズ(バイト単位)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+static int32_t
+Reserve( uint32_t nNeed )
+{
+	if(gfListFull) {
+		StartSink();	// 捨てるパケットを先頭から積み直す
+		return -1;
+	}
+	if(nNeed > gnSegmentSize) {
+		return -1;
+	}
+	if((uint32_t)sceGuCheckList() + nNeed > gnSegmentSize) {
+		gnListSize += (uint32_t)sceGuCheckList();
+		sceGuFinish();
+		if(StartSegment() < 0) {
+			StartSink();
+			return -1;
+		}
+		gListStatistics.nChainCount++;
+	}
+	return 0;
+}
+
+//! VRAMのアドレスを取得する(キャッシュを通さない)
+static void*
+Vram_GetUncached( uint32_t nOffset )
+{
+	return (void*)(((uintptr_t)sceGeEdramGetAddr() + gnVramOffset + nOffset) | 0x40000000);
+}
+
+//! VRAMへ転送する
+static void
+Vram_Upload( void* pvContext, uint32_t nOffset, const void* pvSource, uint32_t nSize )
+{
+	memcpy( Vram_GetUncached( nOffset ), pvSource, nSize );
+}
+
+//! VRAM内で移動する
+static void
+Vram_Move( void* pvContext, uint32_t nDest, uint32_t nSrc, uint32_t nSize )
+{
+	memmove( Vram_GetUncached( nDest ), Vram_GetUncached( nSrc ), nSize );
+}
+
+//! GEに渡すアドレスを取得する
+static void*
+Vram_GetAddress( void* pvContext, uint32_t nOffset )
+{
+	return (void*)((uintptr_t)sceGeEdramGetAddr() + gnVramOffset + nOffset);
+}
+
+//! GEの描画が終わるのを待つ
+static void
+Vram_Sync( void* pvContext )
+{
+	sceGuSync( 0, 0 );
+}
 
 //! 描画関連を初期化する
 /*!
@@ -34,6 +237,8 @@ static int nEnter = 0;
 void
 Cat_RenderInit( uint32_t nParam )
 {
+	uint32_t nFrameSize;
+
 	sceGuInit();
 	sceDisplayWaitVblankStart();
 	sceGuStart( GU_DIRECT, disp_list ); {
@@ -48,6 +253,7 @@ Cat_RenderInit( uint32_t nParam )
 					sceGuDrawBuffer( GU_PSM_8888, (void*)(512*4*272*1), 512 );
 				}
 				sceGuDepthBuffer( (void*)(512*4*272*2), 512 );	// シングルでもダブルでも深度バッファの位置は変えない
+				nFrameSize = 512*4*272;
 				break;
 			case CAT_RENDER_PARAM_FORMAT_RGBA5551:
 			case CAT_RENDER_PARAM_FORMAT_RGBA5650:
@@ -61,6 +267,7 @@ Cat_RenderInit( uint32_t nParam )
 					sceGuDrawBuffer( nParam & CAT_RENDER_PARAM_FORMAT_MASK, (void*)(512*2*272*1), 512 );
 				}
 				sceGuDepthBuffer( (void*)(512*2*272*2), 512 );	// シングルでもダブルでも深度バッファの位置は変えない
+				nFrameSize = 512*2*272;
 				break;
 		}
 
@@ -87,6 +294,54 @@ Cat_RenderInit( uint32_t nParam )
 
 	fSW = 0;
 	nEnter = 0;
+
+	// 描画パケットを、予算から分割の大きさずつ確保する
+	gnSegmentCount = gnListBudget / gnSegmentSize;
+	if(gnSegmentCount > CAT_RENDER_LIST_SEGMENT_MAX) {
+		gnSegmentCount = CAT_RENDER_LIST_SEGMENT_MAX;
+	}
+	gpbList = (uint8_t*)CAT_MALLOC( gnSegmentCount * gnSegmentSize );
+	if(gpbList == 0) {
+		gnSegmentCount = 0;
+	} else {
+		// キャッシュを通さずに書くので、キャッシュに残っている分を捨てておく
+		sceKernelDcacheWritebackInvalidateRange( gpbList, gnSegmentCount * gnSegmentSize );
+	}
+	for(gnFreeCount = 0; gnFreeCount < gnSegmentCount; gnFreeCount++) {
+		gnFreeSegment[gnFreeCount] = gnSegmentCount - 1 - gnFreeCount;
+	}
+	gFrame[0].nSegment = 0;
+	gFrame[1].nSegment = 0;
+	gfListFull = 0;
+	memset( &gListStatistics, 0, sizeof(gListStatistics) );
+	gListStatistics.nBudget      = gnSegmentCount * gnSegmentSize;
+	gListStatistics.nSegmentSize = gnSegmentSize;
+	memset( &gFrameCurrent, 0, sizeof(gFrameCurrent) );
+	Cat_RenderResetFrameStatistics();
+
+	gnFormat     = (int32_t)(nParam & CAT_RENDER_PARAM_FORMAT_MASK);	// sceGuDrawBuffer()に渡したものと同じ
+	gnBackOffset = (nParam & CAT_RENDER_PARAM_BUFFER_MASK) ? 0 : nFrameSize;
+	gfTarget     = 0;
+
+	// 深度バッファ(16bit)の後ろが空いている
+	gnVramOffset = nFrameSize * 2 + 512*2*272;
+	gnTargetOffset = 0;
+	if(nParam & CAT_RENDER_PARAM_TARGET) {
+		// 描画先はフレームバッファと同じ大きさなので、8KB境界に揃ったまま
+		gnTargetOffset = gnVramOffset;
+		gnVramOffset  += nFrameSize;
+	}
+	if(nParam & CAT_RENDER_PARAM_VRAM_TEXTURE) {
+		Cat_VramBackend backend;
+		backend.Upload     = Vram_Upload;
+		backend.Move       = Vram_Move;
+		backend.GetAddress = Vram_GetAddress;
+		backend.Sync       = Vram_Sync;
+		backend.Close      = 0;
+		backend.pvContext  = 0;
+		gpVram = Cat_VramCreate( sceGeEdramGetSize() - gnVramOffset, &backend );
+		Cat_TextureSetVram( gpVram );
+	}
 }
 
 //! 描画関連の終了処理をする
@@ -94,7 +349,20 @@ void
 Cat_RenderTerm( void )
 {
 	sceGuSync( 0, 0 );
+	if(gpVram) {
+		Cat_TextureSetVram( 0 );
+		Cat_VramDestroy( gpVram );
+		gpVram = 0;
+	}
 	sceGuTerm();
+	if(gpbList) {
+		CAT_FREE( gpbList );
+		gpbList = 0;
+	}
+	gnSegmentCount = 0;
+	gnFreeCount    = 0;
+	gnTargetOffset = 0;
+	gfTarget       = 0;
 }
 
 //! 描画パケットの開始
@@ -102,11 +370,19 @@ static void
 BeginPacket( void )
 {
 	if(!nEnter) {
-		if(fSW == 0) {
-			sceGuStart( GU_CALL, (void*)((u32)disp_list0 | 0x40000000) );
-		} else {
-			sceGuStart( GU_CALL, (void*)((u32)disp_list1 | 0x40000000) );
+		// 同じフレームで描画し直す場合は、作りかけの描画パケットを捨てる
+		ReleaseFrame( &gFrame[fSW] );
+		gListStatistics.nMemoryCount = 0;
+		gListStatistics.nMemorySize  = 0;
+		gnListSize = 0;
+		gfListFull = 0;
+		memset( &gFrameCurrent, 0, sizeof(gFrameCurrent) );
+		gnFrameStart = sceKernelGetSystemTimeLow();
+		if(StartSegment() < 0) {
+			StartSink();
 		}
+		// 新しいパケットなので、前のパケットで積んだ設定は当てにしない
+		Cat_RenderStateInvalidate();
 	}
 	nEnter++;
 }
@@ -116,7 +392,30 @@ static void
 EndPacket( void )
 {
 	if(--nEnter == 0) {
+		const Frame* pFrame = &gFrame[fSW];
+
+		if(!gfListFull) {
+			gnListSize += (uint32_t)sceGuCheckList();
+		}
 		sceGuFinish();
+		gListStatistics.nFrameCount++;
+		gListStatistics.nSize         = gnListSize;
+		gListStatistics.nSegmentCount = pFrame->nSegment;
+		if(gListStatistics.nSizeMax < gnListSize) {
+			gListStatistics.nSizeMax = gnListSize;
+		}
+		if(gListStatistics.nSegmentCountMax < pFrame->nSegment) {
+			gListStatistics.nSegmentCountMax = pFrame->nSegment;
+		}
+
+		// 呼んだリストの分は、Cat_RenderAddFrameStatistics()で加えてある
+		gFrameCurrent.nListSize += gnListSize;
+		gFrameCurrent.nTime      = sceKernelGetSystemTimeLow() - gnFrameStart;
+		gFrameHistory[gnFrameHistory] = gFrameCurrent;
+		gnFrameHistory = (gnFrameHistory + 1) % CAT_RENDER_FRAME_HISTORY;
+		if(gnFrameHistoryCount < CAT_RENDER_FRAME_HISTORY) {
+			gnFrameHistoryCount++;
+		}
 	}
 }
 
@@ -140,16 +439,531 @@ Cat_RenderEnd( void )
 void
 Cat_RenderScreenUpdate( void )
 {
+	uint32_t i;
+
 	sceGuSync( 0, 0 );
+	// 前に渡したフレームは描画し終わったので、分割を空きに戻す
+	ReleaseFrame( &gFrame[fSW ^ 1] );
 	sceDisplayWaitVblankStartCB();
 	sceGuSwapBuffers();
 
 	sceGuStart( GU_DIRECT, disp_list );
-	if(fSW == 0) {
-		sceGuCallList( disp_list0 );
-	} else {
-		sceGuCallList( disp_list1 );
+	for(i = 0; i < gFrame[fSW].nSegment; i++) {
+		sceGuCallList( GetSegment( gFrame[fSW].anSegment[i] ) );
 	}
 	sceGuFinish();
 	fSW ^= 1;
+	gnFrame++;
+
+	// 渡したパケットが参照していない領域だけを入れ替える
+	Cat_VramUpdate( gpVram );
+}
+
+//! フレームバッファと深度バッファ(と描画先)の後ろの空いているVRAMの位置を取得する
+/*!
+	@return	VRAMの先頭からのオフセット(バイト単位)
+*/
+uint32_t
+Cat_RenderGetVramOffset( void )
+{
+	return gnVramOffset;
+}
+
+//! テクスチャを置くVRAMの領域管理を取得する
+/*!
+	断片化を解消する場合は、Cat_RenderScreenUpdate()の後でCat_VramDefragment()を呼ぶ。
+	@return	領域管理。CAT_RENDER_PARAM_VRAM_TEXTUREを指定していない場合は0が返る。
+*/
+Cat_Vram*
+Cat_RenderGetVram( void )
+{
+	return gpVram;
+}
+
+//! フレームバッファのピクセルフォーマットを取得する
+/*!
+	@return	ピクセルフォーマット(GU_PSM_xxx)
+*/
+int32_t
+Cat_RenderGetFormat( void )
+{
+	return gnFormat;
+}
+
+//! 表示しているフレームバッファのアドレスを取得する
+/*!
+	@return	アドレス(キャッシュを通さない)
+*/
+const void*
+Cat_RenderGetDisplay( void )
+{
+	// Cat_RenderScreenUpdate()で渡したフレームは、Cat_RenderEndTarget()と同じく偶数番目が1枚目に描かれて、
+	// 次のCat_RenderScreenUpdate()で表示される。
+	const uint32_t nOffset = (gnFrame & 1) ? gnBackOffset : 0;
+	return (const void*)(((uintptr_t)sceGeEdramGetAddr() + nOffset) | 0x40000000);
+}
+
+//! 描画先のアドレスを取得する
+/*!
+	@return	アドレス(キャッシュを通す)。CAT_RENDER_PARAM_TARGETを指定していない場合は0が返る。
+*/
+void*
+Cat_RenderGetTarget( void )
+{
+	if(gnTargetOffset == 0) {
+		return 0;
+	}
+	return (void*)((uintptr_t)sceGeEdramGetAddr() + gnTargetOffset);
+}
+
+//! 描画先に切り替える
+/*!
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+int32_t
+Cat_RenderBeginTarget( void )
+{
+	if((gnTargetOffset == 0) || (nEnter == 0) || gfTarget) {
+		return -1;
+	}
+	sceGuDrawBufferList( gnFormat, (void*)(uintptr_t)gnTargetOffset, CAT_RENDER_TARGET_BUFFER_WIDTH );
+	gfTarget = 1;
+	return 0;
+}
+
+//! 描画先からフレームバッファに戻す
+void
+Cat_RenderEndTarget( void )
+{
+	uint32_t nOffset;
+
+	if(!gfTarget) {
+		return;
+	}
+	// 作成中のパケットは、次のCat_RenderScreenUpdate()でバッファを入れ替えた後に実行される。
+	// 最初の描画先は2枚目なので、偶数番目のフレームは1枚目に描かれる。
+	nOffset = (gnFrame & 1) ? gnBackOffset : 0;
+	sceGuDrawBufferList( gnFormat, (void*)(uintptr_t)nOffset, 512 );
+	sceGuScissor( 0, 0, CAT_SCREEN_WIDTH, CAT_SCREEN_HEIGHT );
+	sceGuTexFlush();
+	gfTarget = 0;
+}
+
+//! 描画パケットに使うメモリを設定する
+/*!
+	Cat_RenderInit()より前に呼ぶ。
+	@param[in]	nBudget			描画パケットに使うメモリ(バイト単位。0の場合はCAT_RENDER_LIST_BUDGET)
+	@param[in]	nSegmentSize	分割する大きさ(バイト単位。0の場合はCAT_RENDER_LIST_SEGMENT_SIZE)
+*/
+void
+Cat_RenderSetListBudget( uint32_t nBudget, uint32_t nSegmentSize )
+{
+	gnListBudget  = nBudget ? nBudget : CAT_RENDER_LIST_BUDGET;
+	gnSegmentSize = nSegmentSize ? ((nSegmentSize + 63) & ~63) : CAT_RENDER_LIST_SEGMENT_SIZE;
+	if(gnSegmentSize < CAT_RENDER_LIST_MARGIN * 4) {
+		gnSegmentSize = CAT_RENDER_LIST_MARGIN * 4;
+	}
+}
+
+//! 描画パケットの中にメモリを確保する
+/*!
+	今の分割に収まらない場合は、sceGuFinish()して次の分割につなぐ。 \n
+	GEの設定は分割をまたいでも続くので、Cat_RenderStateの記録はそのまま使える。
+	@param[in]	nSize	サイズ(バイト単位)
+	@return	確保したメモリ。空きが無い場合は0が返る。
+*/
+void*
+Cat_RenderGetMemory( uint32_t nSize )
+{
+	const uint32_t nNeed = ((nSize + 3) & ~3) + 8 + CAT_RENDER_LIST_MARGIN;	// 8は、データを飛び越すジャンプの分
+
+	if(nEnter == 0) {
+		// Cat_RenderBegin()の外では、呼び出し側の描画パケットから確保する
+		if(gpfnMemory) {
+			return gpfnMemory( gpvMemoryContext, nSize );
+		}
+		return sceGuGetMemory( (int)nSize );
+	}
+	if(Reserve( nNeed ) < 0) {
+		gListStatistics.nOverflowCount++;
+		return 0;
+	}
+	gListStatistics.nMemoryCount++;
+	gListStatistics.nMemorySize += nSize;
+	return sceGuGetMemory( (int)nSize );
+}
+
+//! 描画パケットにコマンドを積む空きを確保する
+/*!
+	@param[in]	nSize	サイズ(バイト単位)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+int32_t
+Cat_RenderReserve( uint32_t nSize )
+{
+	if(nEnter == 0) {
+		return 0;
+	}
+	if(Reserve( ((nSize + 3) & ~3) + CAT_RENDER_LIST_MARGIN ) < 0) {
+		gListStatistics.nOverflowCount++;
+		return -1;
+	}
+	return 0;
+}
+
+//! Cat_RenderBegin()の外でCat_RenderGetMemory()が確保する関数を設定する
+/*!
+	@param[in]	pfnMemory	確保する関数(0の場合はsceGuGetMemory())
+	@param[in]	pvContext	\a pfnMemory に渡す値
+*/
+void
+Cat_RenderSetMemoryFunc( Cat_RenderMemoryFunc pfnMemory, void* pvContext )
+{
+	gpfnMemory       = pfnMemory;
+	gpvMemoryContext = pvContext;
+}
+
+//! Cat_RenderScreenUpdate()した回数を取得する
+/*!
+	@return	回数
+*/
+uint32_t
+Cat_RenderGetFrame( void )
+{
+	return gnFrame;
+}
+
+//! 描画パケットの統計情報を取得する
+/*!
+	@param[out]	pStatistics		統計情報
+*/
+void
+Cat_RenderGetListStatistics( Cat_RenderListStatistics* pStatistics )
+{
+	if(pStatistics) {
+		*pStatistics = gListStatistics;
+	}
+}
+
+//! 描画パケットの統計情報をクリアする
+void
+Cat_RenderResetListStatistics( void )
+{
+	gListStatistics.nFrameCount      = 0;
+	gListStatistics.nSizeMax         = gListStatistics.nSize;
+	gListStatistics.nSegmentCountMax = gListStatistics.nSegmentCount;
+	gListStatistics.nChainCount      = 0;
+	gListStatistics.nStallCount      = 0;
+	gListStatistics.nOverflowCount   = 0;
+}
+
+//! 頂点の並び
+typedef struct {
+	uint32_t	nStride;		/*!< 頂点のサイズ(バイト単位)			*/
+	uint32_t	nPosition;		/*!< 位置のオフセット(バイト単位)		*/
+	uint32_t	nPositionSize;	/*!< 位置の要素のサイズ(バイト単位)		*/
+} VertexLayout;
+
+//! 頂点の並びを調べる
+/*!
+	頂点は、重み、テクスチャ座標、色、法線、位置の順で、それぞれ要素の大きさに揃えて並ぶ。 \n
+	頂点のサイズは、一番大きな要素の大きさに揃える。
+	@param[in]	nVertexType	頂点の種類
+	@param[out]	pLayout		頂点の並び
+	@return	成功した場合は、0 \n
+			見積もれない頂点(GU_TRANSFORM_3Dやモーフィング)の場合は、負数が返る
+*/
+static int32_t
+GetVertexLayout( int32_t nVertexType, VertexLayout* pLayout )
+{
+	static const uint8_t anSize[4] = { 0, 1, 2, 4 };
+	static const uint8_t anColorSize[8] = { 0, 0, 0, 0, 2, 2, 2, 4 };
+	const uint32_t nWeight   = anSize[(nVertexType & GU_WEIGHT_BITS) >> 9];
+	const uint32_t nTexture  = anSize[nVertexType & GU_TEXTURE_BITS];
+	const uint32_t nColor    = anColorSize[(nVertexType & GU_COLOR_BITS) >> 2];
+	const uint32_t nNormal   = anSize[(nVertexType & GU_NORMAL_BITS) >> 5];
+	const uint32_t nPosition = anSize[(nVertexType & GU_VERTEX_BITS) >> 7];
+	uint32_t nAlign = 1;
+	uint32_t nOffset = 0;
+
+	if(((nVertexType & GU_TRANSFORM_BITS) != GU_TRANSFORM_2D) || (nVertexType & GU_VERTICES_BITS) || (nPosition == 0)) {
+		return -1;
+	}
+	if(nWeight) {
+		nOffset += nWeight * ((((uint32_t)nVertexType & GU_WEIGHTS_BITS) >> 14) + 1);
+		nAlign = nWeight;
+	}
+	if(nTexture) {
+		nOffset = ((nOffset + nTexture - 1) & ~(nTexture - 1)) + nTexture * 2;
+		nAlign = (nAlign > nTexture) ? nAlign : nTexture;
+	}
+	if(nColor) {
+		nOffset = ((nOffset + nColor - 1) & ~(nColor - 1)) + nColor;
+		nAlign = (nAlign > nColor) ? nAlign : nColor;
+	}
+	if(nNormal) {
+		nOffset = ((nOffset + nNormal - 1) & ~(nNormal - 1)) + nNormal * 3;
+		nAlign = (nAlign > nNormal) ? nAlign : nNormal;
+	}
+	nOffset = (nOffset + nPosition - 1) & ~(nPosition - 1);
+	nAlign  = (nAlign > nPosition) ? nAlign : nPosition;
+	pLayout->nPosition     = nOffset;
+	pLayout->nPositionSize = nPosition;
+	pLayout->nStride       = (nOffset + nPosition * 3 + nAlign - 1) & ~(nAlign - 1);
+	return 0;
+}
+
+//! 頂点の位置を取得する
+/*!
+	@param[in]	pLayout		頂点の並び
+	@param[in]	nVertexType	頂点の種類
+	@param[in]	pvIndex		インデックス(無い場合は0)
+	@param[in]	pvVertex	頂点
+	@param[in]	nNo			頂点の番号
+	@param[out]	pfX			位置X
+	@param[out]	pfY			位置Y
+*/
+static void
+GetVertexPosition( const VertexLayout* pLayout, int32_t nVertexType, const void* pvIndex, const void* pvVertex, uint32_t nNo, float* pfX, float* pfY )
+{
+	const uint8_t* pb;
+
+	if(pvIndex) {
+		if((nVertexType & GU_INDEX_BITS) == GU_INDEX_8BIT) {
+			nNo = ((const uint8_t*)pvIndex)[nNo];
+		} else {
+			nNo = ((const uint16_t*)pvIndex)[nNo];
+		}
+	}
+	pb = (const uint8_t*)pvVertex + nNo * pLayout->nStride + pLayout->nPosition;
+	switch(pLayout->nPositionSize) {
+		case 1:
+			*pfX = (float)((const int8_t*)pb)[0];
+			*pfY = (float)((const int8_t*)pb)[1];
+			break;
+		case 2:
+			*pfX = (float)((const int16_t*)pb)[0];
+			*pfY = (float)((const int16_t*)pb)[1];
+			break;
+		default:
+			*pfX = ((const float*)pb)[0];
+			*pfY = ((const float*)pb)[1];
+			break;
+	}
+}
+
+//! 三角形の面積を取得する
+/*!
+	@param[in]	pf	頂点の位置(x,yの順に3つ)
+	@return	面積(ピクセル数)
+*/
+static float
+GetTriangleArea( const float* pf )
+{
+	const float f = (pf[2] - pf[0]) * (pf[5] - pf[1]) - (pf[4] - pf[0]) * (pf[3] - pf[1]);
+	return (f < 0.0f) ? (f * -0.5f) : (f * 0.5f);
+}
+
+//! 描画するピクセル数を見積もる
+/*!
+	スプライトは画面で切り取る。三角形は切り取らずに面積を足す。
+	@param[in]	nPrim		プリミティブ
+	@param[in]	nVertexType	頂点の種類
+	@param[in]	nCount		頂点数
+	@param[in]	pvIndex		インデックス(無い場合は0)
+	@param[in]	pvVertex	頂点
+	@return	ピクセル数
+*/
+static uint32_t
+EstimatePixelCount( int32_t nPrim, int32_t nVertexType, int32_t nCount, const void* pvIndex, const void* pvVertex )
+{
+	VertexLayout layout;
+	float afPos[6];
+	float fArea = 0.0f;
+	int32_t i;
+
+	if((pvVertex == 0) || (GetVertexLayout( nVertexType, &layout ) < 0)) {
+		return 0;
+	}
+	switch(nPrim) {
+		case GU_SPRITES:
+			for(i = 0; i + 1 < nCount; i += 2) {
+				float x0, y0, x1, y1;
+				GetVertexPosition( &layout, nVertexType, pvIndex, pvVertex, (uint32_t)i, &afPos[0], &afPos[1] );
+				GetVertexPosition( &layout, nVertexType, pvIndex, pvVertex, (uint32_t)i + 1, &afPos[2], &afPos[3] );
+				x0 = (afPos[0] < afPos[2]) ? afPos[0] : afPos[2];
+				x1 = (afPos[0] < afPos[2]) ? afPos[2] : afPos[0];
+				y0 = (afPos[1] < afPos[3]) ? afPos[1] : afPos[3];
+				y1 = (afPos[1] < afPos[3]) ? afPos[3] : afPos[1];
+				if(x0 < 0.0f) x0 = 0.0f;
+				if(y0 < 0.0f) y0 = 0.0f;
+				if(x1 > (float)CAT_SCREEN_WIDTH) x1 = (float)CAT_SCREEN_WIDTH;
+				if(y1 > (float)CAT_SCREEN_HEIGHT) y1 = (float)CAT_SCREEN_HEIGHT;
+				if((x0 < x1) && (y0 < y1)) {
+					fArea += (x1 - x0) * (y1 - y0);
+				}
+			}
+			break;
+		case GU_TRIANGLES:
+			for(i = 0; i + 2 < nCount; i += 3) {
+				GetVertexPosition( &layout, nVertexType, pvIndex, pvVertex, (uint32_t)i, &afPos[0], &afPos[1] );
+				GetVertexPosition( &layout, nVertexType, pvIndex, pvVertex, (uint32_t)i + 1, &afPos[2], &afPos[3] );
+				GetVertexPosition( &layout, nVertexType, pvIndex, pvVertex, (uint32_t)i + 2, &afPos[4], &afPos[5] );
+				fArea += GetTriangleArea( afPos );
+			}
+			break;
+		case GU_TRIANGLE_STRIP:
+		case GU_TRIANGLE_FAN:
+			if(nCount < 3) {
+				break;
+			}
+			GetVertexPosition( &layout, nVertexType, pvIndex, pvVertex, 0, &afPos[0], &afPos[1] );
+			GetVertexPosition( &layout, nVertexType, pvIndex, pvVertex, 1, &afPos[2], &afPos[3] );
+			for(i = 2; i < nCount; i++) {
+				GetVertexPosition( &layout, nVertexType, pvIndex, pvVertex, (uint32_t)i, &afPos[4], &afPos[5] );
+				fArea += GetTriangleArea( afPos );
+				if(nPrim == GU_TRIANGLE_STRIP) {
+					// 古い頂点を捨てる
+					afPos[0] = afPos[2];
+					afPos[1] = afPos[3];
+				}
+				// 扇形は最初の頂点を残す
+				afPos[2] = afPos[4];
+				afPos[3] = afPos[5];
+			}
+			break;
+		default:
+			// 点と線は数えない
+			break;
+	}
+	return (uint32_t)(fArea + 0.5f);
+}
+
+//! 描画する
+/*!
+	@param[in]	nPrim		プリミティブ(GU_SPRITESなど)
+	@param[in]	nVertexType	頂点の種類
+	@param[in]	nCount		頂点数
+	@param[in]	pvIndex		インデックス(無い場合は0)
+	@param[in]	pvVertex	頂点
+*/
+void
+Cat_RenderDrawArray( int32_t nPrim, int32_t nVertexType, int32_t nCount, const void* pvIndex, const void* pvVertex )
+{
+	gFrameCurrent.nDrawCount++;
+	gFrameCurrent.nVertexCount += (uint32_t)nCount;
+	if(gfPixelCount) {
+		gFrameCurrent.nPixelCount += EstimatePixelCount( nPrim, nVertexType, nCount, pvIndex, pvVertex );
+	}
+	sceGuDrawArray( nPrim, nVertexType, nCount, pvIndex, pvVertex );
+}
+
+//! 描画の設定を数える
+/*!
+	@param[in]	nType	CAT_RENDER_COUNT_xxx
+*/
+void
+Cat_RenderCount( int32_t nType )
+{
+	switch(nType) {
+		case CAT_RENDER_COUNT_TEXTURE:
+			gFrameCurrent.nTextureCount++;
+			break;
+		case CAT_RENDER_COUNT_PALETTE:
+			gFrameCurrent.nPaletteCount++;
+			break;
+		default:
+			break;
+	}
+}
+
+//! 描画するピクセル数を見積もるかどうかを設定する
+/*!
+	@param[in]	fEnable		見積もる場合は0以外
+*/
+void
+Cat_RenderEnablePixelCount( int32_t fEnable )
+{
+	gfPixelCount = fEnable;
+}
+
+//! フレームの統計情報を作成中のフレームに加える
+/*!
+	@param[in]	pStatistics		加える値
+*/
+void
+Cat_RenderAddFrameStatistics( const Cat_RenderFrameStatistics* pStatistics )
+{
+	if(pStatistics) {
+		gFrameCurrent.nDrawCount    += pStatistics->nDrawCount;
+		gFrameCurrent.nVertexCount  += pStatistics->nVertexCount;
+		gFrameCurrent.nPixelCount   += pStatistics->nPixelCount;
+		gFrameCurrent.nTextureCount += pStatistics->nTextureCount;
+		gFrameCurrent.nPaletteCount += pStatistics->nPaletteCount;
+		gFrameCurrent.nListSize     += pStatistics->nListSize;
+	}
+}
+
+//! フレームの統計情報を取得する
+/*!
+	@param[in]	nType			CAT_RENDER_FRAME_xxx
+	@param[out]	pStatistics		統計情報
+*/
+void
+Cat_RenderGetFrameStatistics( int32_t nType, Cat_RenderFrameStatistics* pStatistics )
+{
+	// 全部uint32_tなので、配列として足したり比べたりする
+	const uint32_t nField = sizeof(Cat_RenderFrameStatistics) / sizeof(uint32_t);
+	uint32_t* pnDest = (uint32_t*)pStatistics;
+	uint32_t i;
+	uint32_t j;
+
+	if(pStatistics == 0) {
+		return;
+	}
+	memset( pStatistics, 0, sizeof(Cat_RenderFrameStatistics) );
+	switch(nType) {
+		case CAT_RENDER_FRAME_CURRENT:
+			*pStatistics = gFrameCurrent;
+			break;
+		case CAT_RENDER_FRAME_LAST:
+			if(gnFrameHistoryCount) {
+				*pStatistics = gFrameHistory[(gnFrameHistory + CAT_RENDER_FRAME_HISTORY - 1) % CAT_RENDER_FRAME_HISTORY];
+			}
+			break;
+		case CAT_RENDER_FRAME_AVERAGE:
+			if(gnFrameHistoryCount) {
+				for(j = 0; j < nField; j++) {
+					uint64_t nSum = 0;
+					for(i = 0; i < gnFrameHistoryCount; i++) {
+						nSum += ((const uint32_t*)&gFrameHistory[i])[j];
+					}
+					pnDest[j] = (uint32_t)((nSum + gnFrameHistoryCount / 2) / gnFrameHistoryCount);
+				}
+			}
+			break;
+		case CAT_RENDER_FRAME_MAX:
+			for(i = 0; i < gnFrameHistoryCount; i++) {
+				const uint32_t* pnSrc = (const uint32_t*)&gFrameHistory[i];
+				for(j = 0; j < nField; j++) {
+					if(pnDest[j] < pnSrc[j]) {
+						pnDest[j] = pnSrc[j];
+					}
+				}
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+//! フレームの統計情報の平均と最大値をクリアする
+void
+Cat_RenderResetFrameStatistics( void )
+{
+	memset( gFrameHistory, 0, sizeof(gFrameHistory) );
+	gnFrameHistory      = 0;
+	gnFrameHistoryCount = 0;
 }
@@ -0,0 +1,345 @@
+//! @file	Cat_RenderOverlay.c
+// フレームの統計情報の画面表示
+//
+// 3x5ドットの文字と、枠と棒に使う塗りつぶしの升を、256x8のCLUT8のテクスチャに並べて持つ。
+// 文字も枠も棒も同じテクスチャのスプライトなので、頂点を全部書いてから1回で描画する。
+
+#include <pspgu.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>	// for memalign
+#include "Cat_RenderOverlay.h"
+#include "Cat_Render.h"
+#include "Cat_RenderState.h"
+#include "Cat_Texture.h"
+#include "Cat_Palette.h"
+
+#ifndef CAT_MALLOC
+//! メモリ確保マクロ
+#define CAT_MALLOC(x) memalign( 32, (x) )
+#endif // CAT_MALLOC
+
+#ifndef CAT_FREE
+//! メモリ解放マクロ
+#define CAT_FREE(x) free( x )
+#endif // CAT_FREE
+
+//! テクスチャの横幅
+#define CAT_RENDEROVERLAY_TEXTURE_WIDTH (256)
+//! テクスチャの高さ
+#define CAT_RENDEROVERLAY_TEXTURE_HEIGHT (8)
+//! 升の横幅(文字の横幅と間隔)
+#define CAT_RENDEROVERLAY_CELL_WIDTH (4)
+//! 文字の高さ
+#define CAT_RENDEROVERLAY_CHAR_HEIGHT (6)
+//! 行の高さ
+#define CAT_RENDEROVERLAY_LINE_HEIGHT (7)
+//! 数値の列の横幅(文字数)
+#define CAT_RENDEROVERLAY_COLUMN (7)
+//! 項目名の横幅(文字数)
+#define CAT_RENDEROVERLAY_LABEL (5)
+//! 棒の左端
+#define CAT_RENDEROVERLAY_BAR_X (110)
+//! 棒の横幅
+#define CAT_RENDEROVERLAY_BAR_WIDTH (46)
+//! スプライトの最大数
+#define CAT_RENDEROVERLAY_SPRITE_MAX (256)
+
+//! 持っている文字(並びがテクスチャの升の番号)
+static const char gszGlyph[] = "0123456789ADEFGIKLMNOPRSTUVWX.-";
+
+//! 文字の形(1行3bitを上から5行、左が上位)
+static const uint16_t ganGlyph[] = {
+	075557, 026227, 071747, 071717, 055711, 074717, 074757, 071122, 075757, 075717,	// 0～9
+	025755, 065556, 074647, 074644, 034553, 072227, 055655, 044447, 057755, 065555,	// A D E F G I K L M N
+	025552, 065644, 065655, 034216, 072222, 055557, 055552, 055775, 055255, 000002,	// O P R S T U V W X .
+	000700,																			// -
+};
+
+//! 色の番号
+enum {
+	COLOR_CLEAR = 0,			/*!< 透明		*/
+	COLOR_TEXT,					/*!< 文字		*/
+	COLOR_BACK,					/*!< 枠			*/
+	COLOR_BAR,					/*!< 棒			*/
+	COLOR_AVERAGE,				/*!< 平均の目盛り	*/
+	COLOR_COUNT
+};
+
+//! 色(0xAABBGGRR)
+static const uint32_t ganColor[COLOR_COUNT] = {
+	0x00000000, 0xFFFFFFFF, 0xB0000000, 0xFF40C040, 0xFF00E0FF,
+};
+
+//! 頂点
+typedef struct {
+	short	u,v;
+	short	x,y,z;
+} __attribute__((packed)) Vertex;
+
+//! 行
+typedef struct {
+	const char*	pszLabel;		/*!< 項目名								*/
+	uint32_t	nOffset;		/*!< Cat_RenderFrameStatisticsの中の位置	*/
+} Row;
+
+//! 行の数
+#define CAT_RENDEROVERLAY_ROW_COUNT (8)
+
+//! 行(FILLはPIXから計算する)
+static const Row gRow[CAT_RENDEROVERLAY_ROW_COUNT] = {
+	{ "DRAW", offsetof( Cat_RenderFrameStatistics, nDrawCount )    },
+	{ "VERT", offsetof( Cat_RenderFrameStatistics, nVertexCount )  },
+	{ "PIX",  offsetof( Cat_RenderFrameStatistics, nPixelCount )   },
+	{ "TEX",  offsetof( Cat_RenderFrameStatistics, nTextureCount ) },
+	{ "PAL",  offsetof( Cat_RenderFrameStatistics, nPaletteCount ) },
+	{ "LIST", offsetof( Cat_RenderFrameStatistics, nListSize )     },
+	{ "TIME", offsetof( Cat_RenderFrameStatistics, nTime )         },
+	{ "FILL", offsetof( Cat_RenderFrameStatistics, nPixelCount )   },
+};
+
+//! フレームの統計情報の画面表示
+struct _Cat_RenderOverlay {
+	Cat_Texture*	pTexture;									/*!< 文字と升のテクスチャ			*/
+	Vertex			aVertex[CAT_RENDEROVERLAY_SPRITE_MAX * 2];	/*!< 書いている頂点					*/
+	uint32_t		nSprite;									/*!< 書いたスプライト数				*/
+};
+
+//! 塗りつぶしの升の番号を取得する
+/*!
+	@param[in]	nColor	色の番号
+	@return	升の番号(文字の後ろに並ぶ)
+*/
+static uint32_t
+GetFillCell( uint32_t nColor )
+{
+	return sizeof(gszGlyph) - 1 + nColor - COLOR_BACK;
+}
+
+//! 作成する
+/*!
+	@return	作成されたもの。失敗した場合は0が返る。
+*/
+Cat_RenderOverlay*
+Cat_RenderOverlayCreate( void )
+{
+	uint32_t anColor[256];
+	Cat_RenderOverlay* rc;
+	Cat_Palette* pPalette;
+	uint8_t* pbImage;
+	uint32_t i;
+	uint32_t x;
+	uint32_t y;
+
+	rc = (Cat_RenderOverlay*)malloc( sizeof(Cat_RenderOverlay) );
+	if(rc == 0) {
+		return 0;
+	}
+	memset( rc, 0, sizeof(Cat_RenderOverlay) );
+
+	memset( anColor, 0, sizeof(anColor) );
+	memcpy( anColor, ganColor, sizeof(ganColor) );
+	pPalette = Cat_PaletteCreate( FORMAT_PALETTE_8888, 256, anColor );
+	pbImage  = (uint8_t*)CAT_MALLOC( CAT_RENDEROVERLAY_TEXTURE_WIDTH * CAT_RENDEROVERLAY_TEXTURE_HEIGHT );
+	if(pPalette && pbImage) {
+		memset( pbImage, COLOR_CLEAR, CAT_RENDEROVERLAY_TEXTURE_WIDTH * CAT_RENDEROVERLAY_TEXTURE_HEIGHT );
+		for(i = 0; i < sizeof(gszGlyph) - 1; i++) {
+			for(y = 0; y < 5; y++) {
+				for(x = 0; x < 3; x++) {
+					if(ganGlyph[i] & (1 << ((4 - y) * 3 + (2 - x)))) {
+						pbImage[i * CAT_RENDEROVERLAY_CELL_WIDTH + x + y * CAT_RENDEROVERLAY_TEXTURE_WIDTH] = COLOR_TEXT;
+					}
+				}
+			}
+		}
+		for(i = COLOR_BACK; i < COLOR_COUNT; i++) {
+			for(y = 0; y < CAT_RENDEROVERLAY_TEXTURE_HEIGHT; y++) {
+				memset( &pbImage[GetFillCell( i ) * CAT_RENDEROVERLAY_CELL_WIDTH + y * CAT_RENDEROVERLAY_TEXTURE_WIDTH], (int)i, CAT_RENDEROVERLAY_CELL_WIDTH );
+			}
+		}
+		rc->pTexture = Cat_TextureCreate( CAT_RENDEROVERLAY_TEXTURE_WIDTH, CAT_RENDEROVERLAY_TEXTURE_HEIGHT,
+			CAT_RENDEROVERLAY_TEXTURE_WIDTH, pbImage, FORMAT_PIXEL_CLUT8, pPalette );
+	}
+	if(pbImage) {
+		CAT_FREE( pbImage );
+	}
+	if(pPalette) {
+		Cat_PaletteRelease( pPalette );	// テクスチャが参照を持つ
+	}
+	if(rc->pTexture == 0) {
+		free( rc );
+		return 0;
+	}
+	return rc;
+}
+
+//! 破棄する
+/*!
+	@param[in]	pOverlay	画面表示
+*/
+void
+Cat_RenderOverlayDestroy( Cat_RenderOverlay* pOverlay )
+{
+	if(pOverlay == 0) {
+		return;
+	}
+	Cat_TextureRelease( pOverlay->pTexture );
+	free( pOverlay );
+}
+
+//! スプライトを1枚書く
+/*!
+	@param[in]	pOverlay	画面表示
+	@param[in]	nCell		升の番号
+	@param[in]	x			左上の位置X
+	@param[in]	y			左上の位置Y
+	@param[in]	w			横幅
+	@param[in]	h			高さ
+*/
+static void
+AddSprite( Cat_RenderOverlay* pOverlay, uint32_t nCell, int32_t x, int32_t y, int32_t w, int32_t h )
+{
+	Vertex* pVertex = &pOverlay->aVertex[pOverlay->nSprite * 2];
+	int32_t u0 = (int32_t)(nCell * CAT_RENDEROVERLAY_CELL_WIDTH);
+	int32_t v0 = 0;
+	int32_t u1 = u0 + w;
+	int32_t v1 = h;
+
+	if((pOverlay->nSprite >= CAT_RENDEROVERLAY_SPRITE_MAX) || (w <= 0) || (h <= 0)) {
+		return;
+	}
+	if(nCell >= GetFillCell( COLOR_BACK )) {
+		// 塗りつぶしは、升の内側の1テクセルを引き伸ばす
+		u0 += 1;
+		v0  = 1;
+		u1  = u0 + 1;
+		v1  = 2;
+	}
+	pVertex[0].u = (short)u0;
+	pVertex[0].v = (short)v0;
+	pVertex[0].x = (short)x;
+	pVertex[0].y = (short)y;
+	pVertex[0].z = 0;
+	pVertex[1].u = (short)u1;
+	pVertex[1].v = (short)v1;
+	pVertex[1].x = (short)(x + w);
+	pVertex[1].y = (short)(y + h);
+	pVertex[1].z = 0;
+	pOverlay->nSprite++;
+}
+
+//! 文字列を書く
+/*!
+	持っていない文字は空白になる。
+	@param[in]	pOverlay	画面表示
+	@param[in]	psz			文字列
+	@param[in]	x			左上の位置X
+	@param[in]	y			左上の位置Y
+*/
+static void
+AddText( Cat_RenderOverlay* pOverlay, const char* psz, int32_t x, int32_t y )
+{
+	for(; *psz; psz++, x += CAT_RENDEROVERLAY_CELL_WIDTH) {
+		const char* pszFound = strchr( gszGlyph, *psz );
+		if(pszFound) {
+			AddSprite( pOverlay, (uint32_t)(pszFound - gszGlyph), x, y, CAT_RENDEROVERLAY_CELL_WIDTH, CAT_RENDEROVERLAY_CHAR_HEIGHT );
+		}
+	}
+}
+
+//! 数値を列の右に揃えて書く
+/*!
+	6桁を超える場合は、1000で割ってKを付ける。
+	@param[in]	pOverlay	画面表示
+	@param[in]	n			数値
+	@param[in]	x			列の右端の位置X
+	@param[in]	y			左上の位置Y
+*/
+static void
+AddNumber( Cat_RenderOverlay* pOverlay, uint32_t n, int32_t x, int32_t y )
+{
+	char sz[16];
+
+	if(n > 999999) {
+		snprintf( sz, sizeof(sz), "%uK", (unsigned int)(n / 1000) );
+	} else {
+		snprintf( sz, sizeof(sz), "%u", (unsigned int)n );
+	}
+	AddText( pOverlay, sz, x - (int32_t)(strlen( sz ) * CAT_RENDEROVERLAY_CELL_WIDTH), y );
+}
+
+//! 描画する
+/*!
+	@param[in]	pOverlay	画面表示
+	@param[in]	x			左上の位置X(ドット単位)
+	@param[in]	y			左上の位置Y(ドット単位)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+int32_t
+Cat_RenderOverlayDraw( Cat_RenderOverlay* pOverlay, int32_t x, int32_t y )
+{
+	static const char* apszColumn[3] = { "LAST", "AVG", "MAX" };
+	Cat_RenderFrameStatistics statistics[3];
+	const int32_t nLeft = x + 2;
+	Vertex* pVertex;
+	uint32_t i;
+	uint32_t j;
+
+	if(pOverlay == 0) {
+		return -1;
+	}
+	Cat_RenderGetFrameStatistics( CAT_RENDER_FRAME_LAST, &statistics[0] );
+	Cat_RenderGetFrameStatistics( CAT_RENDER_FRAME_AVERAGE, &statistics[1] );
+	Cat_RenderGetFrameStatistics( CAT_RENDER_FRAME_MAX, &statistics[2] );
+
+	pOverlay->nSprite = 0;
+	AddSprite( pOverlay, GetFillCell( COLOR_BACK ), x, y, CAT_RENDEROVERLAY_WIDTH, CAT_RENDEROVERLAY_HEIGHT );
+	y += 2;
+	for(j = 0; j < 3; j++) {
+		const int32_t nRight = nLeft + (int32_t)((CAT_RENDEROVERLAY_LABEL + CAT_RENDEROVERLAY_COLUMN * (j + 1) - 1) * CAT_RENDEROVERLAY_CELL_WIDTH);
+		AddText( pOverlay, apszColumn[j], nRight - (int32_t)(strlen( apszColumn[j] ) * CAT_RENDEROVERLAY_CELL_WIDTH), y );
+	}
+	y += CAT_RENDEROVERLAY_LINE_HEIGHT;
+
+	for(i = 0; i < CAT_RENDEROVERLAY_ROW_COUNT; i++, y += CAT_RENDEROVERLAY_LINE_HEIGHT) {
+		const Row* pRow = &gRow[i];
+		uint32_t anValue[3];
+
+		for(j = 0; j < 3; j++) {
+			anValue[j] = *(const uint32_t*)((const uint8_t*)&statistics[j] + pRow->nOffset);
+			if(i == CAT_RENDEROVERLAY_ROW_COUNT - 1) {
+				// 画面1枚分を100にする
+				anValue[j] = (uint32_t)(((uint64_t)anValue[j] * 100 + CAT_RENDER_TARGET_WIDTH * CAT_RENDER_TARGET_HEIGHT / 2)
+					/ (CAT_RENDER_TARGET_WIDTH * CAT_RENDER_TARGET_HEIGHT));
+			}
+		}
+		AddText( pOverlay, pRow->pszLabel, nLeft, y );
+		for(j = 0; j < 3; j++) {
+			AddNumber( pOverlay, anValue[j], nLeft + (int32_t)((CAT_RENDEROVERLAY_LABEL + CAT_RENDEROVERLAY_COLUMN * (j + 1) - 1) * CAT_RENDEROVERLAY_CELL_WIDTH), y );
+		}
+		// 最大値に対する前のフレームの棒と、平均の目盛り
+		if(anValue[2]) {
+			const int32_t nBar     = (int32_t)((uint64_t)anValue[0] * CAT_RENDEROVERLAY_BAR_WIDTH / anValue[2]);
+			const int32_t nAverage = (int32_t)((uint64_t)anValue[1] * CAT_RENDEROVERLAY_BAR_WIDTH / anValue[2]);
+			AddSprite( pOverlay, GetFillCell( COLOR_BAR ), x + CAT_RENDEROVERLAY_BAR_X, y, nBar, CAT_RENDEROVERLAY_CHAR_HEIGHT - 1 );
+			AddSprite( pOverlay, GetFillCell( COLOR_AVERAGE ), x + CAT_RENDEROVERLAY_BAR_X + ((nAverage > 0) ? nAverage - 1 : 0), y, 1, CAT_RENDEROVERLAY_CHAR_HEIGHT - 1 );
+		}
+	}
+
+	// 頂点を描画パケットに写して、1回で描画する
+	pVertex = (Vertex*)Cat_RenderGetMemory( pOverlay->nSprite * 2 * sizeof(Vertex) );
+	if(pVertex == 0) {
+		return -1;
+	}
+	memcpy( pVertex, pOverlay->aVertex, pOverlay->nSprite * 2 * sizeof(Vertex) );
+	Cat_TextureSetTexture( pOverlay->pTexture );
+	Cat_RenderStateBlendFunc( GU_ADD, GU_SRC_ALPHA, GU_ONE_MINUS_SRC_ALPHA, 0, 0 );
+	sceGuColor( 0xFFFFFFFF );
+	sceGuTexFilter( GU_NEAREST, GU_NEAREST );
+	Cat_RenderDrawArray( GU_SPRITES, GU_TEXTURE_16BIT | GU_VERTEX_16BIT | GU_TRANSFORM_2D, (int32_t)pOverlay->nSprite * 2, 0, pVertex );
+	sceGuTexFilter( GU_LINEAR, GU_LINEAR );
+	return 0;
+}
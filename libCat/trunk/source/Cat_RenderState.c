@@ -0,0 +1,220 @@
+//! @file	Cat_RenderState.c
+// 描画ステートのキャッシュ
+//
+// 描画パケットに最後に積んだ値を覚えておいて、変わった時だけGEの命令を出す。
+
+#include <pspgu.h>
+#include <string.h>
+#include "Cat_RenderState.h"
+
+//! 覚えている描画ステート
+typedef struct {
+	uint32_t	nValid;				/*!< 覚えているステート(1 << CAT_RENDERSTATE_xxx)	*/
+	int32_t		fTexture;			/*!< テクスチャの有効/無効							*/
+	int32_t		nTexFormat;			/*!< テクスチャのフォーマット						*/
+	int32_t		nTexSwizzle;		/*!< テクスチャを入れ替えているかどうか				*/
+	int32_t		nTexWidth;			/*!< テクスチャの横幅								*/
+	int32_t		nTexHeight;			/*!< テクスチャの高さ								*/
+	int32_t		nTexBufferWidth;	/*!< テクスチャの1ラインのピクセル数				*/
+	const void*	pvTexData;			/*!< テクスチャのピクセルデータ						*/
+	float		fScaleU;			/*!< テクスチャの横のスケール						*/
+	float		fScaleV;			/*!< テクスチャの縦のスケール						*/
+	int32_t		nClutFormat;		/*!< パレットのフォーマット							*/
+	uint32_t	nClutMask;			/*!< パレットインデックスのマスク値					*/
+	uint32_t	nClutSize;			/*!< パレットサイズ									*/
+	const void*	pvClutData;			/*!< パレットデータ									*/
+	uint32_t	nClutSerial;		/*!< パレットの更新カウンタ							*/
+	int32_t		nBlendOp;			/*!< ブレンドの演算									*/
+	int32_t		nBlendSrc;			/*!< 描画する色の係数								*/
+	int32_t		nBlendDest;			/*!< 描画先の色の係数								*/
+	uint32_t	nBlendFixA;			/*!< 固定値A										*/
+	uint32_t	nBlendFixB;			/*!< 固定値B										*/
+} State;
+
+//! 覚えている描画ステート
+static State gState;
+//! キャッシュを使うかどうか
+static int32_t gfEnable = 1;
+//! 統計情報
+static Cat_RenderStateStatistics gStatistics;
+
+//! 要求を数えて、命令を出す必要があるかどうかを返す
+/*!
+	@param[in]	eState	描画ステートの種類
+	@param[in]	fSame	覚えている値と同じかどうか
+	@return	命令を出す必要があれば0以外
+*/
+static inline int32_t
+Request( CAT_RENDERSTATE eState, int32_t fSame )
+{
+	gStatistics.nRequest[eState]++;
+	if(gfEnable && fSame && (gState.nValid & (1UL << eState))) {
+		return 0;
+	}
+	gState.nValid |= 1UL << eState;
+	gStatistics.nIssue[eState]++;
+	return 1;
+}
+
+//! キャッシュを使うかどうかを設定する
+/*!
+	使わない場合は、要求されるたびに命令を出す。比較や不具合の切り分けに使う。
+	@param[in]	fEnable		使う場合は0以外
+*/
+void
+Cat_RenderStateSetEnable( int32_t fEnable )
+{
+	gfEnable = fEnable;
+	gState.nValid = 0;
+}
+
+//! 覚えている描画ステートを捨てる
+/*!
+	描画パケットの先頭では、Cat_RenderBegin()から呼ばれる。 \n
+	sceGuTexImage()などを直接呼んだ場合も、その後に呼ぶこと。
+*/
+void
+Cat_RenderStateInvalidate( void )
+{
+	gState.nValid = 0;
+}
+
+//! テクスチャを有効/無効にする
+/*!
+	@param[in]	fEnable		有効にする場合は0以外
+*/
+void
+Cat_RenderStateEnableTexture( int32_t fEnable )
+{
+	fEnable = fEnable ? 1 : 0;
+	if(Request( CAT_RENDERSTATE_TEXTURE_ENABLE, gState.fTexture == fEnable )) {
+		gState.fTexture = fEnable;
+		if(fEnable) {
+			sceGuEnable( GU_TEXTURE_2D );
+		} else {
+			sceGuDisable( GU_TEXTURE_2D );
+		}
+	}
+}
+
+//! テクスチャのフォーマットを設定する
+/*!
+	@param[in]	nFormat		ピクセルフォーマット(GU_PSM_xxx)
+	@param[in]	nSwizzle	入れ替えているかどうか
+*/
+void
+Cat_RenderStateTexMode( int32_t nFormat, int32_t nSwizzle )
+{
+	if(Request( CAT_RENDERSTATE_TEXTURE_MODE, (gState.nTexFormat == nFormat) && (gState.nTexSwizzle == nSwizzle) )) {
+		gState.nTexFormat  = nFormat;
+		gState.nTexSwizzle = nSwizzle;
+		sceGuTexMode( nFormat, 0, 0, nSwizzle );
+	}
+}
+
+//! テクスチャのアドレスと大きさを設定する
+/*!
+	変わった場合は、テクスチャキャッシュもフラッシュする。
+	@param[in]	nWidth		横幅(2の乗数)
+	@param[in]	nHeight		高さ(2の乗数)
+	@param[in]	nBufferWidth	1ラインのピクセル数
+	@param[in]	pvData		ピクセルデータ
+*/
+void
+Cat_RenderStateTexImage( int32_t nWidth, int32_t nHeight, int32_t nBufferWidth, const void* pvData )
+{
+	if(Request( CAT_RENDERSTATE_TEXTURE_IMAGE,
+		(gState.pvTexData == pvData) && (gState.nTexWidth == nWidth)
+		&& (gState.nTexHeight == nHeight) && (gState.nTexBufferWidth == nBufferWidth) )) {
+		gState.nTexWidth       = nWidth;
+		gState.nTexHeight      = nHeight;
+		gState.nTexBufferWidth = nBufferWidth;
+		gState.pvTexData       = pvData;
+		sceGuTexImage( 0, nWidth, nHeight, nBufferWidth, pvData );
+		sceGuTexFlush();
+	}
+}
+
+//! テクスチャのスケールを設定する
+/*!
+	@param[in]	u	横のスケール
+	@param[in]	v	縦のスケール
+*/
+void
+Cat_RenderStateTexScale( float u, float v )
+{
+	if(Request( CAT_RENDERSTATE_TEXTURE_SCALE, (gState.fScaleU == u) && (gState.fScaleV == v) )) {
+		gState.fScaleU = u;
+		gState.fScaleV = v;
+		sceGuTexScale( u, v );
+	}
+}
+
+//! パレットを設定する
+/*!
+	同じデータでも、更新カウンタが変わっていれば読み込み直す。
+	@param[in]	nFormat		パレットフォーマット(GU_PSM_xxx)
+	@param[in]	nMask		パレットインデックスのマスク値
+	@param[in]	nSize		パレットサイズ(32バイト単位)
+	@param[in]	pvData		パレットデータ
+	@param[in]	nSerial		パレットの更新カウンタ
+*/
+void
+Cat_RenderStateClut( int32_t nFormat, uint32_t nMask, uint32_t nSize, const void* pvData, uint32_t nSerial )
+{
+	if(Request( CAT_RENDERSTATE_CLUT_MODE, (gState.nClutFormat == nFormat) && (gState.nClutMask == nMask) )) {
+		gState.nClutFormat = nFormat;
+		gState.nClutMask   = nMask;
+		sceGuClutMode( nFormat, 0, nMask, 0 );
+	}
+	if(Request( CAT_RENDERSTATE_CLUT_LOAD,
+		(gState.pvClutData == pvData) && (gState.nClutSize == nSize) && (gState.nClutSerial == nSerial) )) {
+		gState.nClutSize   = nSize;
+		gState.pvClutData  = pvData;
+		gState.nClutSerial = nSerial;
+		sceGuClutLoad( nSize, pvData );
+	}
+}
+
+//! ブレンドの方法を設定する
+/*!
+	引数はsceGuBlendFunc()と同じ。
+	@param[in]	nOp		演算(GU_ADDなど)
+	@param[in]	nSrc	描画する色の係数
+	@param[in]	nDest	描画先の色の係数
+	@param[in]	nFixA	固定値A
+	@param[in]	nFixB	固定値B
+*/
+void
+Cat_RenderStateBlendFunc( int32_t nOp, int32_t nSrc, int32_t nDest, uint32_t nFixA, uint32_t nFixB )
+{
+	if(Request( CAT_RENDERSTATE_BLEND,
+		(gState.nBlendOp == nOp) && (gState.nBlendSrc == nSrc) && (gState.nBlendDest == nDest)
+		&& (gState.nBlendFixA == nFixA) && (gState.nBlendFixB == nFixB) )) {
+		gState.nBlendOp   = nOp;
+		gState.nBlendSrc  = nSrc;
+		gState.nBlendDest = nDest;
+		gState.nBlendFixA = nFixA;
+		gState.nBlendFixB = nFixB;
+		sceGuBlendFunc( nOp, nSrc, nDest, nFixA, nFixB );
+	}
+}
+
+//! 統計情報を取得する
+/*!
+	@param[out]	pStatistics		統計情報
+*/
+void
+Cat_RenderStateGetStatistics( Cat_RenderStateStatistics* pStatistics )
+{
+	if(pStatistics) {
+		*pStatistics = gStatistics;
+	}
+}
+
+//! 統計情報をクリアする
+void
+Cat_RenderStateResetStatistics( void )
+{
+	memset( &gStatistics, 0, sizeof(gStatistics) );
+}
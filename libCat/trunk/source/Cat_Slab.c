@@ -0,0 +1,268 @@
+//! @file	Cat_Slab.c
+// 固定サイズのオブジェクトの割り当て
+//
+// テクスチャやパレットの構造体のような小さいオブジェクトを1個ずつmemalignすると、
+// 数千個のキャラクターでヒープが細かく分断されるので、チャンク単位でまとめて確保する。
+
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>	// for memalign
+#include "Cat_Slab.h"
+
+#ifndef CAT_MALLOC
+//! メモリ確保マクロ
+#define CAT_MALLOC(x) memalign( 32, (x) )
+#endif // CAT_MALLOC
+
+#ifndef CAT_FREE
+//! メモリ解放マクロ
+#define CAT_FREE(x) free( x )
+#endif // CAT_FREE
+
+//! オブジェクトのアライメント(バイト単位)
+#define CAT_SLAB_ALIGN (16)
+//! チャンクの先頭に置く管理情報のサイズ(バイト単位)
+#define CAT_SLAB_HEADER_SIZE (32)
+
+//! チャンク
+/*!
+	チャンクの先頭に置かれ、後ろにオブジェクトが並ぶ。
+*/
+typedef struct _Chunk {
+	struct _Chunk*	pPrev;			/*!< 前のチャンク					*/
+	struct _Chunk*	pNext;			/*!< 次のチャンク					*/
+	void*			pvFree;			/*!< 解放されたオブジェクトのリスト	*/
+	uint32_t		nUsed;			/*!< 使用中のオブジェクト数			*/
+	uint32_t		nBump;			/*!< まだ使っていない先頭の番号		*/
+} Chunk;
+
+//! 固定サイズのオブジェクトの割り当て
+struct _Cat_Slab {
+	uint32_t			nObjectSize;	/*!< オブジェクトのサイズ(アライメント済み)	*/
+	uint32_t			nChunkSize;		/*!< チャンクのサイズ						*/
+	uint32_t			nObjectCount;	/*!< 1チャンクに入るオブジェクト数			*/
+	Chunk*				pPartial;		/*!< 空きがあるチャンク						*/
+	Chunk*				pFull;			/*!< 空きが無いチャンク						*/
+	Chunk*				pSpare;			/*!< 予備の空のチャンク						*/
+	Cat_SlabStatistics	statistics;		/*!< 統計情報								*/
+};
+
+//! チャンクをリストにつなぐ
+/*!
+	@param[in,out]	ppList	リストの先頭
+	@param[in]		pChunk	つなぐチャンク
+*/
+static void
+Link( Chunk** ppList, Chunk* pChunk )
+{
+	pChunk->pPrev = 0;
+	pChunk->pNext = *ppList;
+	if(*ppList) {
+		(*ppList)->pPrev = pChunk;
+	}
+	*ppList = pChunk;
+}
+
+//! チャンクをリストから外す
+/*!
+	@param[in,out]	ppList	リストの先頭
+	@param[in]		pChunk	外すチャンク
+*/
+static void
+Unlink( Chunk** ppList, Chunk* pChunk )
+{
+	if(pChunk->pPrev) {
+		pChunk->pPrev->pNext = pChunk->pNext;
+	} else {
+		*ppList = pChunk->pNext;
+	}
+	if(pChunk->pNext) {
+		pChunk->pNext->pPrev = pChunk->pPrev;
+	}
+	pChunk->pPrev = 0;
+	pChunk->pNext = 0;
+}
+
+//! リストのチャンクをすべて解放する
+/*!
+	@param[in]	pChunk	リストの先頭
+*/
+static void
+FreeList( Chunk* pChunk )
+{
+	while(pChunk) {
+		Chunk* pNext = pChunk->pNext;
+		CAT_FREE( pChunk );
+		pChunk = pNext;
+	}
+}
+
+//! 作成する
+/*!
+	@param[in]	nObjectSize		オブジェクトのサイズ(バイト単位)
+	@param[in]	nChunkSize		チャンクのサイズ(2の乗数、バイト単位)
+	@return	作成された割り当て。失敗した場合は0が返る。
+	@see	Cat_SlabDestroy()
+*/
+Cat_Slab*
+Cat_SlabCreate( uint32_t nObjectSize, uint32_t nChunkSize )
+{
+	Cat_Slab* rc;
+
+	if((nObjectSize == 0) || (nChunkSize & (nChunkSize - 1))) {
+		return 0;
+	}
+	nObjectSize = (nObjectSize + CAT_SLAB_ALIGN - 1) & ~(CAT_SLAB_ALIGN - 1);
+	if(nChunkSize < CAT_SLAB_HEADER_SIZE + nObjectSize * 2) {
+		return 0;	// 1チャンクに2個も入らないなら、まとめる意味がない
+	}
+
+	rc = (Cat_Slab*)CAT_MALLOC( sizeof(Cat_Slab) );
+	if(rc == 0) {
+		return 0;
+	}
+	memset( rc, 0, sizeof(Cat_Slab) );
+	rc->nObjectSize  = nObjectSize;
+	rc->nChunkSize   = nChunkSize;
+	rc->nObjectCount = (nChunkSize - CAT_SLAB_HEADER_SIZE) / nObjectSize;
+	rc->statistics.nObjectSize = nObjectSize;
+	return rc;
+}
+
+//! 破棄する
+/*!
+	使用中のオブジェクトがあっても、チャンクはすべて解放される。
+	@param[in]	pSlab	割り当て
+*/
+void
+Cat_SlabDestroy( Cat_Slab* pSlab )
+{
+	if(pSlab == 0) {
+		return;
+	}
+	FreeList( pSlab->pPartial );
+	FreeList( pSlab->pFull );
+	FreeList( pSlab->pSpare );
+	CAT_FREE( pSlab );
+}
+
+//! オブジェクトを確保する
+/*!
+	16バイト境界のメモリを返す。中身は初期化されない。
+	@param[in]	pSlab	割り当て
+	@return	確保したメモリ。失敗した場合は0が返る。
+*/
+void*
+Cat_SlabAlloc( Cat_Slab* pSlab )
+{
+	Chunk* pChunk;
+	void* rc;
+
+	if(pSlab == 0) {
+		return 0;
+	}
+#ifdef CAT_SLAB_NO_POOL
+	(void)pChunk;
+	rc = CAT_MALLOC( pSlab->nObjectSize );
+	if(rc) {
+		pSlab->statistics.nAllocCount++;
+		pSlab->statistics.nHeapAllocCount++;
+		pSlab->statistics.nUsedCount++;
+	}
+	return rc;
+#else
+	pChunk = pSlab->pPartial;
+	if(pChunk == 0) {
+		if(pSlab->pSpare) {
+			pChunk = pSlab->pSpare;
+			pSlab->pSpare = 0;
+		} else {
+			pChunk = (Chunk*)memalign( pSlab->nChunkSize, pSlab->nChunkSize );
+			if(pChunk == 0) {
+				return 0;
+			}
+			pSlab->statistics.nHeapAllocCount++;
+			pSlab->statistics.nChunkCount++;
+		}
+		pChunk->pvFree = 0;
+		pChunk->nUsed  = 0;
+		pChunk->nBump  = 0;
+		Link( &pSlab->pPartial, pChunk );
+	}
+
+	if(pChunk->pvFree) {
+		// 解放されたものを使い回す
+		rc = pChunk->pvFree;
+		pChunk->pvFree = *(void**)rc;
+	} else {
+		rc = (uint8_t*)pChunk + CAT_SLAB_HEADER_SIZE + pChunk->nBump * pSlab->nObjectSize;
+		pChunk->nBump++;
+	}
+	if(++pChunk->nUsed == pSlab->nObjectCount) {
+		Unlink( &pSlab->pPartial, pChunk );
+		Link( &pSlab->pFull, pChunk );
+	}
+	pSlab->statistics.nAllocCount++;
+	pSlab->statistics.nUsedCount++;
+	return rc;
+#endif // CAT_SLAB_NO_POOL
+}
+
+//! オブジェクトを解放する
+/*!
+	チャンクが空になった場合は、1つだけ予備に残して解放する。
+	@param[in]	pSlab	割り当て
+	@param[in]	pv		Cat_SlabAlloc()で確保したメモリ
+*/
+void
+Cat_SlabFree( Cat_Slab* pSlab, void* pv )
+{
+	Chunk* pChunk;
+
+	if((pSlab == 0) || (pv == 0)) {
+		return;
+	}
+	pSlab->statistics.nFreeCount++;
+	pSlab->statistics.nUsedCount--;
+#ifdef CAT_SLAB_NO_POOL
+	(void)pChunk;
+	CAT_FREE( pv );
+#else
+	pChunk = (Chunk*)((uintptr_t)pv & ~(uintptr_t)(pSlab->nChunkSize - 1));
+	*(void**)pv = pChunk->pvFree;
+	pChunk->pvFree = pv;
+	if(pChunk->nUsed-- == pSlab->nObjectCount) {
+		// 空きができたので、確保できるチャンクに戻す
+		Unlink( &pSlab->pFull, pChunk );
+		Link( &pSlab->pPartial, pChunk );
+	}
+	if(pChunk->nUsed == 0) {
+		Unlink( &pSlab->pPartial, pChunk );
+		if(pSlab->pSpare == 0) {
+			// 確保と解放を繰り返した時に、毎回チャンクを作り直さないように残しておく
+			pSlab->pSpare = pChunk;
+		} else {
+			CAT_FREE( pChunk );
+			pSlab->statistics.nChunkCount--;
+		}
+	}
+#endif // CAT_SLAB_NO_POOL
+}
+
+//! 統計情報を取得する
+/*!
+	@param[in]	pSlab			割り当て
+	@param[out]	pStatistics		統計情報
+*/
+void
+Cat_SlabGetStatistics( Cat_Slab* pSlab, Cat_SlabStatistics* pStatistics )
+{
+	if(pStatistics == 0) {
+		return;
+	}
+	if(pSlab == 0) {
+		memset( pStatistics, 0, sizeof(Cat_SlabStatistics) );
+		return;
+	}
+	*pStatistics = pSlab->statistics;
+}
@@ -0,0 +1,2295 @@
+//! @file	Cat_SoftRender.c
+// ソフトウェア描画(Linuxでのテスト用)
+//
+// sceGu*()は、呼ばれた順にコマンドとしてリストに記録する。sceGuGetMemory()で渡したメモリもリストが持つ。
+// GU_DIRECTのリストをsceGuFinish()した時に、GEの代わりにコマンドを順に実行して、
+// スプライトと三角形を設定の写しと一緒に並べる。並べたスプライトは、重なるタイルに振り分けてから、
+// 空いているスレッドがタイルを1つずつ取って描画する。タイル同士は重ならないので、排他は要らない。
+
+#ifdef USE_CAT_SOFTRENDER
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE		// for memfd_create
+#endif
+
+#include <pspgu.h>
+#include <pspge.h>
+#include <pspdisplay.h>
+#include <psputils.h>
+#include <pspthreadman.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <malloc.h>	// for memalign
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "Cat_SoftRender.h"
+#include "Cat_Render.h"
+
+#ifndef CAT_MALLOC
+//! メモリ確保マクロ
+#define CAT_MALLOC(x) memalign( 32, (x) )
+#endif // CAT_MALLOC
+
+#ifndef CAT_FREE
+//! メモリ解放マクロ
+#define CAT_FREE(x) free( x )
+#endif // CAT_FREE
+
+//! 実スクリーンサイズ 横幅
+#define CAT_SCREEN_WIDTH  (480)
+//! 実スクリーンサイズ 縦幅
+#define CAT_SCREEN_HEIGHT (272)
+
+//! VRAMのアドレス(実機と同じ)
+#define CAT_SOFTRENDER_VRAM_ADDR (0x04000000UL)
+//! キャッシュを通さないVRAMのアドレス
+#define CAT_SOFTRENDER_VRAM_UNCACHED (0x44000000UL)
+//! VRAMのサイズ
+#define CAT_SOFTRENDER_VRAM_SIZE (2 * 1024 * 1024)
+
+//! 横に並ぶタイルの数
+#define CAT_SOFTRENDER_TILE_X ((CAT_SCREEN_WIDTH + CAT_SOFTRENDER_TILE_SIZE - 1) / CAT_SOFTRENDER_TILE_SIZE)
+//! 縦に並ぶタイルの数
+#define CAT_SOFTRENDER_TILE_Y ((CAT_SCREEN_HEIGHT + CAT_SOFTRENDER_TILE_SIZE - 1) / CAT_SOFTRENDER_TILE_SIZE)
+//! タイルの数
+#define CAT_SOFTRENDER_TILE_COUNT (CAT_SOFTRENDER_TILE_X * CAT_SOFTRENDER_TILE_Y)
+
+//! 記録できるリストの数(Cat_Renderが2フレーム分に分割した描画パケットと、GU_DIRECTのリスト)
+#define CAT_SOFTRENDER_LIST_MAX (CAT_RENDER_LIST_SEGMENT_MAX * 2 + 8)
+//! sceGuCallList()の入れ子の最大
+#define CAT_SOFTRENDER_CALL_DEPTH (8)
+//! sceGuGetMemory()で渡すメモリのブロックの大きさ
+#define CAT_SOFTRENDER_BLOCK_SIZE (256 * 1024)
+//! CLUTの色数
+#define CAT_SOFTRENDER_CLUT_SIZE (256)
+
+//! CLUTを読み込んでいない
+#define CAT_SOFTRENDER_CLUT_NONE (0xFFFFFFFF)
+//! 三角形ではない(スプライトかクリア)
+#define CAT_SOFTRENDER_TRIANGLE_NONE (0xFFFFFFFF)
+
+//! 固定小数点の小数部のビット数
+#define CAT_SOFTRENDER_FIX (16)
+
+//! コマンド
+enum {
+	CMD_ENABLE,			/*!< sceGuEnable()		*/
+	CMD_DISABLE,		/*!< sceGuDisable()		*/
+	CMD_SCISSOR,		/*!< sceGuScissor()		*/
+	CMD_COLOR,			/*!< sceGuColor()		*/
+	CMD_CLEAR_COLOR,	/*!< sceGuClearColor()	*/
+	CMD_CLEAR,			/*!< sceGuClear()		*/
+	CMD_TEX_MODE,		/*!< sceGuTexMode()		*/
+	CMD_TEX_IMAGE,		/*!< sceGuTexImage()	*/
+	CMD_TEX_FUNC,		/*!< sceGuTexFunc()		*/
+	CMD_TEX_WRAP,		/*!< sceGuTexWrap()		*/
+	CMD_CLUT_MODE,		/*!< sceGuClutMode()	*/
+	CMD_CLUT_LOAD,		/*!< sceGuClutLoad()	*/
+	CMD_BLEND_FUNC,		/*!< sceGuBlendFunc()	*/
+	CMD_DRAW_ARRAY,		/*!< sceGuDrawArray()	*/
+	CMD_CALL,			/*!< sceGuCallList()	*/
+	CMD_DRAW_BUFFER,	/*!< sceGuDrawBufferList()	*/
+	CMD_ALPHA_FUNC,		/*!< sceGuAlphaFunc()	*/
+	CMD_STENCIL_FUNC,	/*!< sceGuStencilFunc()	*/
+	CMD_STENCIL_OP,		/*!< sceGuStencilOp()	*/
+	CMD_CLEAR_STENCIL,	/*!< sceGuClearStencil()	*/
+};
+
+//! 記録したコマンド
+typedef struct {
+	uint32_t	nType;			/*!< コマンド(CMD_xxx)	*/
+	uint32_t	an[5];			/*!< 引数				*/
+	const void*	pv;				/*!< アドレスの引数		*/
+	const void*	pvIndex;		/*!< インデックスの引数(sceGuDrawArray()だけ)	*/
+} Command;
+
+//! sceGuGetMemory()で渡すメモリのブロック
+typedef struct _Block {
+	struct _Block*	pNext;		/*!< 次のブロック		*/
+	uint32_t		nSize;		/*!< データのサイズ		*/
+	uint32_t		nUsed;		/*!< 使ったサイズ		*/
+	uint8_t*		pbData;		/*!< データ				*/
+} Block;
+
+//! 記録したリスト
+typedef struct {
+	uintptr_t	nKey;			/*!< リストのアドレス(0なら空き)			*/
+	Command*	pCommand;		/*!< コマンド								*/
+	uint32_t	nCommand;		/*!< コマンドの数							*/
+	uint32_t	nCommandMax;	/*!< 確保したコマンドの数					*/
+	Block*		pBlock;			/*!< メモリのブロック(先頭から使う)			*/
+	Block*		pCurrent;		/*!< 使っているブロック						*/
+	uint32_t	nPacketSize;	/*!< 実機でのパケットサイズの見積もり		*/
+} List;
+
+//! 描画する時の設定の写し
+typedef struct {
+	uint32_t		fTexture;		/*!< テクスチャを使うかどうか			*/
+	uint32_t		fBlend;			/*!< ブレンドするかどうか				*/
+	uint32_t		nTexFormat;		/*!< テクスチャのフォーマット			*/
+	uint32_t		fSwizzle;		/*!< 入れ替え済みかどうか				*/
+	uint32_t		nTexWidth;		/*!< テクスチャの横幅					*/
+	uint32_t		nTexHeight;		/*!< テクスチャの高さ					*/
+	uint32_t		nTexBits;		/*!< 1ピクセルのビット数(0なら描画しない)	*/
+	uint32_t		nTexBufferWidth;/*!< テクスチャのバッファの横幅			*/
+	uint32_t		nTexPitch;		/*!< テクスチャのピッチ(バイト単位)		*/
+	const uint8_t*	pbTexture;		/*!< テクスチャのデータ					*/
+	uint32_t		fRepeat;		/*!< 繰り返すかどうか					*/
+	uint32_t		nTexFunc;		/*!< テクスチャ関数						*/
+	uint32_t		nClut;			/*!< 読み込んだCLUTの番号				*/
+	uint32_t		nClutShift;		/*!< インデックスのシフト				*/
+	uint32_t		nClutMask;		/*!< インデックスのマスク				*/
+	uint32_t		nClutOffset;	/*!< インデックスのオフセット			*/
+	uint32_t		nBlendOp;		/*!< ブレンドの演算						*/
+	uint32_t		nBlendSrc;		/*!< ソースの係数						*/
+	uint32_t		nBlendDest;		/*!< デスティネーションの係数			*/
+	uint32_t		nFixA;			/*!< ソースの固定値						*/
+	uint32_t		nFixB;			/*!< デスティネーションの固定値			*/
+	int32_t			nScissor[4];	/*!< シザー(左、上、右、下。右下は含まない)	*/
+	uint32_t		fAlphaTest;		/*!< アルファテストをするかどうか		*/
+	uint32_t		nAlphaFunc;		/*!< アルファテストの比較(GU_NEVER～GU_GEQUAL)	*/
+	uint32_t		nAlphaRef;		/*!< アルファテストの参照値(マスク済み)	*/
+	uint32_t		nAlphaMask;		/*!< アルファテストのマスク				*/
+	uint32_t		fStencil;		/*!< ステンシルテストをするかどうか		*/
+	uint32_t		nStencilFunc;	/*!< ステンシルテストの比較				*/
+	uint32_t		nStencilRef;	/*!< ステンシルの参照値					*/
+	uint32_t		nStencilMask;	/*!< ステンシルのマスク					*/
+	uint32_t		nStencilOp;		/*!< テストに通った時の操作(zpass、深度は無いので常に通る)	*/
+} State;
+
+//! 並べたスプライト
+typedef struct {
+	int16_t		x0, y0;			/*!< 描画位置 左上(含む)				*/
+	int16_t		x1, y1;			/*!< 描画位置 右下(含まない)			*/
+	int32_t		u0, v0;			/*!< 左上のピクセルの中心のテクスチャ座標(固定小数点)	*/
+	int32_t		du, dv;			/*!< 1ピクセルあたりのテクスチャ座標の増分(固定小数点)	*/
+	uint32_t	nColor;			/*!< 色(クリアの時はクリア色)			*/
+	uint32_t	fClear;			/*!< クリアかどうか						*/
+	uint32_t	nState;			/*!< 設定の写しの番号					*/
+	uint32_t	nTriangle;		/*!< 三角形の番号(CAT_SOFTRENDER_TRIANGLE_NONEならスプライト)	*/
+} Item;
+
+//! 並べた三角形(描画位置は、並べたスプライトに外接する矩形として持つ)
+/*!
+	ピクセル(x,y)の中心は、全ての辺で anEdge[i][0] * x + anEdge[i][1] * y + anEdge[i][2] >= 0 の時に内側になる。 \n
+	テクスチャ座標(固定小数点)は、afU[0] * x + afU[1] * y + afU[2] で求める。
+*/
+typedef struct {
+	int64_t		anEdge[3][3];	/*!< 辺の式の係数					*/
+	double		afU[3];			/*!< テクスチャ座標Uの式の係数		*/
+	double		afV[3];			/*!< テクスチャ座標Vの式の係数		*/
+} Triangle;
+
+//! フレームバッファ
+typedef struct {
+	uint32_t	nFormat;		/*!< フォーマット(GU_PSM_xxx)			*/
+	uint32_t	nOffset;		/*!< VRAMの先頭からのオフセット			*/
+	uint32_t	nWidth;			/*!< 横幅(ピクセル単位)					*/
+} FrameBuffer;
+
+//! 描画するスレッド
+typedef struct {
+	pthread_t	thread;			/*!< スレッド							*/
+	uint32_t	nGeneration;	/*!< 描画した世代						*/
+	uint32_t	nPixelCount;	/*!< 書き込んだピクセル数				*/
+	uint32_t	nFragmentCount;		/*!< 重ね描きを数えたピクセル数			*/
+	uint32_t	nTransparentCount;	/*!< そのうち透明だったピクセル数		*/
+} Worker;
+
+//! 初期化したかどうか
+static int gfInit = 0;
+//! VRAM(キャッシュを通すアドレス)
+static uint8_t* gpbVram = 0;
+//! VRAMの実体
+static int gnVramFd = -1;
+
+//! 記録したリスト
+static List gList[CAT_SOFTRENDER_LIST_MAX];
+//! 記録しているリスト
+static List* gpRecord = 0;
+//! 記録しているリストの種類(GU_DIRECT/GU_CALL)
+static int gnRecordCid = GU_DIRECT;
+
+//! 描画先
+static FrameBuffer gDraw;
+//! 表示するバッファのオフセット
+static uint32_t gnDispOffset = 0;
+//! リストの実行中の描画先(sceGuDrawBufferList()で切り替わる)
+static FrameBuffer gExec;
+//! 描画しているバッファ
+static FrameBuffer gTarget;
+//! 最後に描画したバッファ
+static FrameBuffer gLast;
+//! 最後に描画したかどうか
+static int gfLast = 0;
+
+//! 実行中の設定
+static State gState;
+//! 頂点の色
+static uint32_t gnColor = 0xFFFFFFFF;
+//! クリア色
+static uint32_t gnClearColor = 0;
+//! ステンシルのクリア値
+static uint32_t gnClearStencil = 0;
+//! CLUTのフォーマット
+static uint32_t gnClutFormat = GU_PSM_8888;
+//! 設定が変わったかどうか(変わったら写しを増やす)
+static int gfStateDirty = 1;
+
+//! 設定の写し
+static State* gpState = 0;
+//! 設定の写しの数
+static uint32_t gnState = 0;
+//! 確保した設定の写しの数
+static uint32_t gnStateMax = 0;
+//! 読み込んだCLUT
+static uint32_t* gpnClut = 0;
+//! 読み込んだCLUTの数
+static uint32_t gnClut = 0;
+//! 確保したCLUTの数
+static uint32_t gnClutMax = 0;
+//! 並べたスプライト
+static Item* gpItem = 0;
+//! 並べたスプライトの数
+static uint32_t gnItem = 0;
+//! 確保したスプライトの数
+static uint32_t gnItemMax = 0;
+//! 並べた三角形
+static Triangle* gpTriangle = 0;
+//! 並べた三角形の数
+static uint32_t gnTriangle = 0;
+//! 確保した三角形の数
+static uint32_t gnTriangleMax = 0;
+
+//! タイルごとのスプライトの数(振り分けた後は先頭の位置)
+static uint32_t gnBinStart[CAT_SOFTRENDER_TILE_COUNT + 1];
+//! タイルに振り分けたスプライトの番号
+static uint32_t* gpnBin = 0;
+//! 確保した振り分けの数
+static uint32_t gnBinMax = 0;
+
+//! 描画するスレッド(0番は呼び出したスレッドが使う)
+static Worker gWorker[CAT_SOFTRENDER_THREAD_MAX];
+//! 描画するスレッド数
+static uint32_t gnThreadCount = 0;
+//! スレッドへの指示を守る
+static pthread_mutex_t gMutex = PTHREAD_MUTEX_INITIALIZER;
+//! 描画の開始を知らせる
+static pthread_cond_t gCondStart = PTHREAD_COND_INITIALIZER;
+//! 描画の終了を知らせる
+static pthread_cond_t gCondDone = PTHREAD_COND_INITIALIZER;
+//! 描画の世代(変わったら描画を始める)
+static uint32_t gnGeneration = 0;
+//! 描画を終えたスレッド数
+static uint32_t gnDoneCount = 0;
+//! スレッドを終了するかどうか
+static int gfQuit = 0;
+//! 次に描画するタイル
+static uint32_t gnNextTile = 0;
+
+//! 統計情報
+static Cat_SoftRenderStatistics gStatistics;
+//! 画面のピクセルごとに描画した回数(重ね描きを数えない場合は0)
+static uint16_t* gpnOverdraw = 0;
+//! 垂直同期の周波数(0の場合は待たない)
+static uint32_t gnRefreshRate = 0;
+
+//! 時間を取得する
+/*!
+	@return	マイクロ秒単位の時間
+*/
+static uint64_t
+GetTimeWide( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+//! 時間を取得する
+/*!
+	@return	マイクロ秒単位の時間(下位32bit)
+*/
+static uint32_t
+GetTime( void )
+{
+	return (uint32_t)GetTimeWide();
+}
+
+//! 次の垂直同期まで待つ
+static void
+WaitVblank( void )
+{
+	uint64_t nPeriod;
+	uint64_t nNow;
+
+	if(gnRefreshRate == 0) {
+		return;
+	}
+	nPeriod = 1000000 / gnRefreshRate;
+	nNow    = GetTimeWide();
+	usleep( (useconds_t)(nPeriod - nNow % nPeriod) );
+}
+
+//! 配列を広げる
+/*!
+	@param[in,out]	ppv			配列
+	@param[in,out]	pnMax		確保した数
+	@param[in]		nCount		必要な数
+	@param[in]		nSize		1つのサイズ
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+static int32_t
+Reserve( void** ppv, uint32_t* pnMax, uint32_t nCount, uint32_t nSize )
+{
+	uint32_t nMax;
+	void* pv;
+
+	if(nCount <= *pnMax) {
+		return 0;
+	}
+	nMax = (*pnMax) ? *pnMax : 256;
+	while(nMax < nCount) {
+		nMax *= 2;
+	}
+	pv = realloc( *ppv, (size_t)nMax * nSize );
+	if(pv == 0) {
+		return -1;
+	}
+	*ppv    = pv;
+	*pnMax  = nMax;
+	return 0;
+}
+
+//! VRAMのアドレスを取得する
+/*!
+	sceGu*()に渡されたアドレスは、VRAMの先頭からのオフセットか、キャッシュを通さないアドレスの場合がある。
+	@param[in]	pv	アドレス
+	@return	VRAMの先頭からのオフセット
+*/
+static uint32_t
+GetVramOffset( const void* pv )
+{
+	return ((uint32_t)(uintptr_t)pv & ~0x40000000UL) & ~CAT_SOFTRENDER_VRAM_ADDR & (CAT_SOFTRENDER_VRAM_SIZE - 1);
+}
+
+//! リストのキーを取得する
+/*!
+	PSPのコードは、リストのアドレスにキャッシュを通さないビットを立てることがあるので、 \n
+	そのビットを落とした値をキーにする。64bitのホストでも上位のビットを捨てないように、uintptr_tのまま扱う。
+	@param[in]	pv	リストのアドレス
+	@return	キー
+*/
+static uintptr_t
+GetListKey( const void* pv )
+{
+	return ((uintptr_t)pv & ~(uintptr_t)0x40000000) | 1;
+}
+
+//! 16bitの色を0xAABBGGRRに変換する
+/*!
+	@param[in]	nFormat		フォーマット(GU_PSM_5650/5551/4444)
+	@param[in]	c			色
+	@return	変換した色
+*/
+static inline uint32_t
+Expand16( uint32_t nFormat, uint32_t c )
+{
+	uint32_t r;
+	uint32_t g;
+	uint32_t b;
+	uint32_t a;
+
+	switch(nFormat) {
+		case GU_PSM_5650:
+			r = c & 0x1F;
+			g = (c >> 5) & 0x3F;
+			b = (c >> 11) & 0x1F;
+			r = (r << 3) | (r >> 2);
+			g = (g << 2) | (g >> 4);
+			b = (b << 3) | (b >> 2);
+			a = 0xFF;
+			break;
+		case GU_PSM_5551:
+			r = c & 0x1F;
+			g = (c >> 5) & 0x1F;
+			b = (c >> 10) & 0x1F;
+			r = (r << 3) | (r >> 2);
+			g = (g << 3) | (g >> 2);
+			b = (b << 3) | (b >> 2);
+			a = (c & 0x8000) ? 0xFF : 0;
+			break;
+		case GU_PSM_4444:
+		default:
+			r = (c & 0xF) * 0x11;
+			g = ((c >> 4) & 0xF) * 0x11;
+			b = ((c >> 8) & 0xF) * 0x11;
+			a = ((c >> 12) & 0xF) * 0x11;
+			break;
+	}
+	return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+//! 0xAABBGGRRを16bitの色に変換する
+/*!
+	@param[in]	nFormat		フォーマット(GU_PSM_5650/5551/4444)
+	@param[in]	c			色
+	@return	変換した色
+*/
+static inline uint32_t
+Pack16( uint32_t nFormat, uint32_t c )
+{
+	const uint32_t r = c & 0xFF;
+	const uint32_t g = (c >> 8) & 0xFF;
+	const uint32_t b = (c >> 16) & 0xFF;
+	const uint32_t a = c >> 24;
+
+	switch(nFormat) {
+		case GU_PSM_5650:
+			return (r >> 3) | ((g >> 2) << 5) | ((b >> 3) << 11);
+		case GU_PSM_5551:
+			return (r >> 3) | ((g >> 3) << 5) | ((b >> 3) << 10) | ((a >> 7) << 15);
+		case GU_PSM_4444:
+		default:
+			return (r >> 4) | ((g >> 4) << 4) | ((b >> 4) << 8) | ((a >> 4) << 12);
+	}
+}
+
+//! 状態を初期値に戻す
+static void
+ResetState( void )
+{
+	memset( &gState, 0, sizeof(gState) );
+	gState.nTexFormat  = GU_PSM_8888;
+	gState.nTexBits    = 32;
+	gState.nTexFunc    = GU_TFX_MODULATE;
+	gState.nClut       = CAT_SOFTRENDER_CLUT_NONE;
+	gState.nClutMask   = 0xFF;
+	gState.nBlendOp    = GU_ADD;
+	gState.nBlendSrc   = GU_SRC_ALPHA;
+	gState.nBlendDest  = GU_ONE_MINUS_SRC_ALPHA;
+	gState.nScissor[2] = CAT_SCREEN_WIDTH;
+	gState.nScissor[3] = CAT_SCREEN_HEIGHT;
+	gnColor      = 0xFFFFFFFF;
+	gState.nAlphaFunc   = GU_ALWAYS;
+	gState.nAlphaMask   = 0xFF;
+	gState.nStencilFunc = GU_ALWAYS;
+	gState.nStencilMask = 0xFF;
+	gState.nStencilOp   = GU_KEEP;
+	gnClearColor   = 0;
+	gnClearStencil = 0;
+	gnClutFormat = GU_PSM_8888;
+	gfStateDirty = 1;
+}
+
+//! 今の設定の写しを取得する
+/*!
+	設定が変わっていなければ、前の写しをそのまま使う。
+	@return	写しの番号。失敗した場合は負数が返る。
+*/
+static int32_t
+GetStateIndex( void )
+{
+	if(gfStateDirty || (gnState == 0)) {
+		if(Reserve( (void**)&gpState, &gnStateMax, gnState + 1, sizeof(State) ) < 0) {
+			return -1;
+		}
+		gState.nTexPitch = gState.nTexBufferWidth * gState.nTexBits / 8;
+		gpState[gnState++] = gState;
+		gfStateDirty = 0;
+	}
+	return (int32_t)gnState - 1;
+}
+
+//! 並べるスプライトを1つ確保する
+/*!
+	@return	確保したスプライト(今の設定の写しを指す)。失敗した場合は0が返る。
+*/
+static Item*
+AddItem( void )
+{
+	const int32_t nState = GetStateIndex();
+	Item* rc;
+
+	if((nState < 0) || (Reserve( (void**)&gpItem, &gnItemMax, gnItem + 1, sizeof(Item) ) < 0)) {
+		return 0;
+	}
+	rc = &gpItem[gnItem++];
+	memset( rc, 0, sizeof(Item) );
+	rc->nState    = (uint32_t)nState;
+	rc->nTriangle = CAT_SOFTRENDER_TRIANGLE_NONE;
+	return rc;
+}
+
+//! CLUTを読み込む
+/*!
+	実機と同じく、読み込んだ時点の内容を写して使う。
+	@param[in]	nBlocks		ブロック数(1ブロックは32バイト)
+	@param[in]	pv			CLUTのデータ
+*/
+static void
+LoadClut( uint32_t nBlocks, const void* pv )
+{
+	const uint32_t nBytes = (gnClutFormat == GU_PSM_8888) ? 4 : 2;
+	uint32_t nCount = nBlocks * 32 / nBytes;
+	uint32_t* pnDest;
+	uint32_t i;
+
+	if((pv == 0) || (Reserve( (void**)&gpnClut, &gnClutMax, (gnClut + 1) * CAT_SOFTRENDER_CLUT_SIZE, sizeof(uint32_t) ) < 0)) {
+		return;
+	}
+	if(nCount > CAT_SOFTRENDER_CLUT_SIZE) {
+		nCount = CAT_SOFTRENDER_CLUT_SIZE;
+	}
+	pnDest = &gpnClut[gnClut * CAT_SOFTRENDER_CLUT_SIZE];
+	memset( pnDest, 0, CAT_SOFTRENDER_CLUT_SIZE * sizeof(uint32_t) );
+	for(i = 0; i < nCount; i++) {
+		if(nBytes == 4) {
+			pnDest[i] = ((const uint32_t*)pv)[i];
+		} else {
+			pnDest[i] = Expand16( gnClutFormat, ((const uint16_t*)pv)[i] );
+		}
+	}
+	gState.nClut = gnClut++;
+	gfStateDirty = 1;
+}
+
+//! クリアを並べる
+/*!
+	@param[in]	nFlags	GU_xxx_BUFFER_BITの論理和
+*/
+static void
+AddClear( uint32_t nFlags )
+{
+	Item* pItem;
+
+	if((nFlags & GU_COLOR_BUFFER_BIT) == 0) {
+		return;
+	}
+	pItem = AddItem();
+	if(pItem) {
+		pItem->x0     = (int16_t)gState.nScissor[0];
+		pItem->y0     = (int16_t)gState.nScissor[1];
+		pItem->x1     = (int16_t)gState.nScissor[2];
+		pItem->y1     = (int16_t)gState.nScissor[3];
+		pItem->nColor = gnClearColor;
+		if(nFlags & GU_STENCIL_BUFFER_BIT) {
+			// ステンシルはフレームバッファのアルファに入っている
+			pItem->nColor = (gnClearColor & 0xFFFFFF) | (gnClearStencil << 24);
+		}
+		pItem->fClear = 1;
+	}
+}
+
+//! テクスチャ座標の始まりと増分を求める
+/*!
+	ピクセルの中心でサンプリングするので、始まりは増分の半分だけずらす。
+	@param[in]	t0		始まりのテクスチャ座標
+	@param[in]	t1		終わりのテクスチャ座標
+	@param[in]	nLength	描画する長さ(ドット単位)
+	@param[out]	pnStart	始まり(固定小数点)
+	@param[out]	pnStep	増分(固定小数点)
+*/
+static void
+GetTexStep( int32_t t0, int32_t t1, int32_t nLength, int32_t* pnStart, int32_t* pnStep )
+{
+	const int32_t nStep = (int32_t)((int64_t)(t1 - t0) * (1 << CAT_SOFTRENDER_FIX) / nLength);
+
+	*pnStart = (int32_t)((uint32_t)t0 << CAT_SOFTRENDER_FIX) + nStep / 2;
+	*pnStep  = nStep;
+}
+
+//! 頂点の並びを取得する
+/*!
+	頂点の並びは、テクスチャ座標、色、位置の順で、それぞれ自分の大きさに揃える。 \n
+	描画できるのは、GU_TEXTURE_16BIT(無くてもよい)、GU_COLOR_8888(無くてもよい)、GU_VERTEX_16BIT、GU_TRANSFORM_2Dの頂点だけ。
+	@param[in]	nVertexType		頂点の種類(インデックスの種類を除く)
+	@param[out]	pnColorOffset	色の位置
+	@param[out]	pnVertexOffset	位置の位置
+	@return	頂点の大きさ。描画できない頂点の場合は0が返る。
+*/
+static uint32_t
+GetVertexLayout( uint32_t nVertexType, uint32_t* pnColorOffset, uint32_t* pnVertexOffset )
+{
+	const uint32_t nTexture = nVertexType & GU_TEXTURE_BITS;
+	const uint32_t nColor   = nVertexType & GU_COLOR_BITS;
+	const uint32_t nOther   = nVertexType & ~(GU_TEXTURE_BITS | GU_COLOR_BITS | GU_VERTEX_BITS | GU_TRANSFORM_BITS);
+
+	if(nOther || ((nVertexType & GU_TRANSFORM_BITS) != GU_TRANSFORM_2D) || ((nVertexType & GU_VERTEX_BITS) != GU_VERTEX_16BIT)
+		|| ((nTexture != 0) && (nTexture != GU_TEXTURE_16BIT)) || ((nColor != 0) && (nColor != GU_COLOR_8888))) {
+		return 0;
+	}
+	if(gState.fTexture && ((gState.nTexBits == 0) || (gState.pbTexture == 0) || (nTexture == 0))) {
+		return 0;
+	}
+	*pnColorOffset  = 0;
+	*pnVertexOffset = 0;
+	if(nTexture) {
+		*pnColorOffset  = 4;
+		*pnVertexOffset = 4;
+	}
+	if(nColor) {
+		*pnVertexOffset = *pnColorOffset + 4;
+	}
+	return (*pnVertexOffset + 6 + (nColor ? 3 : 1)) & ~(nColor ? 3 : 1);
+}
+
+//! スプライトを並べる
+/*!
+	@param[in]	nPrim		プリミティブ
+	@param[in]	nVertexType	頂点の種類
+	@param[in]	nCount		頂点数
+	@param[in]	fIndex		インデックスを使うかどうか
+	@param[in]	pvVertex	頂点
+*/
+static void
+AddSprites( uint32_t nPrim, uint32_t nVertexType, uint32_t nCount, uint32_t fIndex, const void* pvVertex )
+{
+	const uint32_t nTexture = nVertexType & GU_TEXTURE_BITS;
+	const uint32_t nColor   = nVertexType & GU_COLOR_BITS;
+	uint32_t nColorOffset;
+	uint32_t nVertexOffset;
+	uint32_t nStride;
+	uint32_t i;
+
+	gStatistics.nDrawCount++;
+	nStride = GetVertexLayout( nVertexType, &nColorOffset, &nVertexOffset );
+	if((nPrim != GU_SPRITES) || fIndex || (pvVertex == 0) || (nStride == 0)) {
+		gStatistics.nUnsupportedCount++;
+		return;
+	}
+
+	for(i = 0; i + 1 < nCount; i += 2) {
+		const uint8_t* pbVertex = (const uint8_t*)pvVertex + i * nStride;
+		const int16_t* pnTex0 = (const int16_t*)pbVertex;
+		const int16_t* pnTex1 = (const int16_t*)(pbVertex + nStride);
+		const int16_t* pnPos0 = (const int16_t*)(pbVertex + nVertexOffset);
+		const int16_t* pnPos1 = (const int16_t*)(pbVertex + nStride + nVertexOffset);
+		int32_t x0 = pnPos0[0];
+		int32_t y0 = pnPos0[1];
+		int32_t x1 = pnPos1[0];
+		int32_t y1 = pnPos1[1];
+		int32_t u0 = nTexture ? pnTex0[0] : 0;
+		int32_t v0 = nTexture ? pnTex0[1] : 0;
+		int32_t u1 = nTexture ? pnTex1[0] : 0;
+		int32_t v1 = nTexture ? pnTex1[1] : 0;
+		Item* pItem;
+		int32_t t;
+
+		// 右下から左上に向かう頂点は、テクスチャ座標と一緒に入れ替える
+		if(x1 < x0) {
+			t = x0; x0 = x1; x1 = t;
+			t = u0; u0 = u1; u1 = t;
+		}
+		if(y1 < y0) {
+			t = y0; y0 = y1; y1 = t;
+			t = v0; v0 = v1; v1 = t;
+		}
+		if((x0 == x1) || (y0 == y1)) {
+			continue;
+		}
+		pItem = AddItem();
+		if(pItem == 0) {
+			return;
+		}
+		pItem->x0 = (int16_t)x0;
+		pItem->y0 = (int16_t)y0;
+		pItem->x1 = (int16_t)x1;
+		pItem->y1 = (int16_t)y1;
+		GetTexStep( u0, u1, x1 - x0, &pItem->u0, &pItem->du );
+		GetTexStep( v0, v1, y1 - y0, &pItem->v0, &pItem->dv );
+		// スプライトの色は、2つ目の頂点の色
+		pItem->nColor = nColor ? *(const uint32_t*)(pbVertex + nStride + nColorOffset) : gnColor;
+	}
+}
+
+//! 三角形を1つ並べる
+/*!
+	辺の上にあるピクセルは、辺の向きで決まる片側の三角形だけが描画するので、 \n
+	辺を共有する2つの三角形(スプライトを分けた2つなど)は、隙間も重なりも無く描画される。
+	@param[in]	pnPos		位置(3頂点のX,Y)
+	@param[in]	pnTex		テクスチャ座標(3頂点のU,V)
+	@param[in]	nColor		色
+*/
+static void
+AddTriangle( const int32_t* pnPos, const int32_t* pnTex, uint32_t nColor )
+{
+	int32_t anPos[6];
+	int32_t anTex[6];
+	int64_t nArea;
+	Triangle* pTriangle;
+	Item* pItem;
+	double a;
+	double b;
+	uint32_t i;
+
+	memcpy( anPos, pnPos, sizeof(anPos) );
+	memcpy( anTex, pnTex, sizeof(anTex) );
+	nArea = (int64_t)(anPos[2] - anPos[0]) * (anPos[5] - anPos[1]) - (int64_t)(anPos[3] - anPos[1]) * (anPos[4] - anPos[0]);
+	if(nArea == 0) {
+		return;
+	}
+	if(nArea < 0) {
+		// 面積が正になる向きに揃える(裏向きでも描画する)
+		for(i = 0; i < 2; i++) {
+			int32_t t;
+			t = anPos[2 + i]; anPos[2 + i] = anPos[4 + i]; anPos[4 + i] = t;
+			t = anTex[2 + i]; anTex[2 + i] = anTex[4 + i]; anTex[4 + i] = t;
+		}
+		nArea = -nArea;
+	}
+	if(Reserve( (void**)&gpTriangle, &gnTriangleMax, gnTriangle + 1, sizeof(Triangle) ) < 0) {
+		return;
+	}
+	pItem = AddItem();
+	if(pItem == 0) {
+		return;
+	}
+	pTriangle = &gpTriangle[gnTriangle];
+	pItem->nTriangle = gnTriangle++;
+	pItem->nColor    = nColor;
+	pItem->x0 = pItem->x1 = (int16_t)anPos[0];
+	pItem->y0 = pItem->y1 = (int16_t)anPos[1];
+	for(i = 0; i < 3; i++) {
+		const int32_t ax = anPos[i * 2];
+		const int32_t ay = anPos[i * 2 + 1];
+		const int64_t dx = anPos[((i + 1) % 3) * 2] - ax;
+		const int64_t dy = anPos[((i + 1) % 3) * 2 + 1] - ay;
+
+		// ピクセルの中心(x + 0.5, y + 0.5)で辺の式を2倍した値
+		pTriangle->anEdge[i][0] = -2 * dy;
+		pTriangle->anEdge[i][1] = 2 * dx;
+		pTriangle->anEdge[i][2] = dx * (1 - 2 * (int64_t)ay) - dy * (1 - 2 * (int64_t)ax);
+		if(!((dy > 0) || ((dy == 0) && (dx < 0)))) {
+			pTriangle->anEdge[i][2]--;	// 辺の上は含まない
+		}
+		if(ax < pItem->x0) pItem->x0 = (int16_t)ax;
+		if(ay < pItem->y0) pItem->y0 = (int16_t)ay;
+		if(ax > pItem->x1) pItem->x1 = (int16_t)ax;
+		if(ay > pItem->y1) pItem->y1 = (int16_t)ay;
+	}
+
+	// テクスチャ座標は、3つの頂点を通る平面で補間する
+	for(i = 0; i < 2; i++) {
+		const double t0 = anTex[i];
+		const double t1 = anTex[2 + i];
+		const double t2 = anTex[4 + i];
+		double* pf = i ? pTriangle->afV : pTriangle->afU;
+
+		a = ((t1 - t0) * (anPos[5] - anPos[1]) - (t2 - t0) * (anPos[3] - anPos[1])) / (double)nArea;
+		b = ((t2 - t0) * (anPos[2] - anPos[0]) - (t1 - t0) * (anPos[4] - anPos[0])) / (double)nArea;
+		pf[0] = a * (1 << CAT_SOFTRENDER_FIX);
+		pf[1] = b * (1 << CAT_SOFTRENDER_FIX);
+		pf[2] = (t0 + a * (0.5 - anPos[0]) + b * (0.5 - anPos[1])) * (1 << CAT_SOFTRENDER_FIX);
+	}
+}
+
+//! 三角形を並べる
+/*!
+	色は頂点ごとに補間しないので、3つの頂点の色が違う三角形は描画しない。
+	@param[in]	nVertexType	頂点の種類
+	@param[in]	nCount		頂点数
+	@param[in]	pvIndex		インデックス(0の場合は頂点の順番)
+	@param[in]	pvVertex	頂点
+*/
+static void
+AddTriangles( uint32_t nVertexType, uint32_t nCount, const void* pvIndex, const void* pvVertex )
+{
+	const uint32_t nIndexType = nVertexType & GU_INDEX_BITS;
+	const uint32_t nTexture   = nVertexType & GU_TEXTURE_BITS;
+	const uint32_t nColor     = nVertexType & GU_COLOR_BITS;
+	uint32_t nColorOffset;
+	uint32_t nVertexOffset;
+	uint32_t nStride;
+	uint32_t i;
+	uint32_t j;
+
+	gStatistics.nDrawCount++;
+	nStride = GetVertexLayout( nVertexType & ~GU_INDEX_BITS, &nColorOffset, &nVertexOffset );
+	if((pvVertex == 0) || (nStride == 0) || ((nIndexType != 0) && (pvIndex == 0))
+		|| ((nIndexType != 0) && (nIndexType != GU_INDEX_8BIT) && (nIndexType != GU_INDEX_16BIT))) {
+		gStatistics.nUnsupportedCount++;
+		return;
+	}
+
+	for(i = 0; i + 2 < nCount; i += 3) {
+		int32_t anPos[6];
+		int32_t anTex[6];
+		uint32_t anColor[3];
+
+		for(j = 0; j < 3; j++) {
+			uint32_t nIndex = i + j;
+			const uint8_t* pbVertex;
+			const int16_t* pn;
+			if(nIndexType == GU_INDEX_8BIT) {
+				nIndex = ((const uint8_t*)pvIndex)[nIndex];
+			} else if(nIndexType == GU_INDEX_16BIT) {
+				nIndex = ((const uint16_t*)pvIndex)[nIndex];
+			}
+			pbVertex = (const uint8_t*)pvVertex + nIndex * nStride;
+			pn = (const int16_t*)(pbVertex + nVertexOffset);
+			anPos[j * 2]     = pn[0];
+			anPos[j * 2 + 1] = pn[1];
+			pn = (const int16_t*)pbVertex;
+			anTex[j * 2]     = nTexture ? pn[0] : 0;
+			anTex[j * 2 + 1] = nTexture ? pn[1] : 0;
+			anColor[j] = nColor ? *(const uint32_t*)(pbVertex + nColorOffset) : gnColor;
+		}
+		if((anColor[0] != anColor[1]) || (anColor[0] != anColor[2])) {
+			gStatistics.nUnsupportedCount++;
+			continue;
+		}
+		AddTriangle( anPos, anTex, anColor[0] );
+	}
+}
+
+//! テクセルを取得する
+/*!
+	@param[in]	pState	設定
+	@param[in]	pnClut	CLUT
+	@param[in]	x		X座標(テクスチャの中にあること)
+	@param[in]	y		Y座標(テクスチャの中にあること)
+	@return	0xAABBGGRRの色
+*/
+static inline uint32_t
+FetchTexel( const State* pState, const uint32_t* pnClut, uint32_t x, uint32_t y )
+{
+	const uint32_t nByte = x * pState->nTexBits / 8;
+	const uint8_t* pb;
+	uint32_t nIndex;
+
+	if(pState->fSwizzle) {
+		// 16バイトx8ラインのブロックが、横に並んでいる
+		pb = pState->pbTexture + ((y >> 3) * (pState->nTexPitch >> 4) + (nByte >> 4)) * 128 + (y & 7) * 16 + (nByte & 15);
+	} else {
+		pb = pState->pbTexture + y * pState->nTexPitch + nByte;
+	}
+	switch(pState->nTexFormat) {
+		case GU_PSM_5650:
+		case GU_PSM_5551:
+		case GU_PSM_4444:
+			return Expand16( pState->nTexFormat, *(const uint16_t*)pb );
+		case GU_PSM_8888:
+			return *(const uint32_t*)pb;
+		case GU_PSM_T4:
+			nIndex = (*pb >> ((x & 1) * 4)) & 0xF;
+			break;
+		case GU_PSM_T8:
+		default:
+			nIndex = *pb;
+			break;
+	}
+	if(pnClut == 0) {
+		return 0;
+	}
+	return pnClut[(((nIndex >> pState->nClutShift) & pState->nClutMask) | (pState->nClutOffset << 4)) & (CAT_SOFTRENDER_CLUT_SIZE - 1)];
+}
+
+//! 色を乗算する
+/*!
+	@param[in]	a	色
+	@param[in]	b	色
+	@return	乗算した色
+*/
+static inline uint32_t
+Modulate( uint32_t a, uint32_t b )
+{
+	uint32_t rc = 0;
+	uint32_t nShift;
+
+	for(nShift = 0; nShift < 32; nShift += 8) {
+		rc |= ((((a >> nShift) & 0xFF) * ((b >> nShift) & 0xFF) + 127) / 255) << nShift;
+	}
+	return rc;
+}
+
+//! ブレンドの係数を取得する
+/*!
+	アルファと固定値の係数は、1ピクセルにつき1回だけ求める。
+	@param[in]	nFactor		係数(GU_xxx)
+	@param[in]	nOther		0と1の時に使う色(ソース側ならデスティネーションの色、デスティネーション側ならソースの色)
+	@param[in]	sa			ソースのアルファ
+	@param[in]	da			デスティネーションのアルファ
+	@param[in]	nFix		固定値
+	@param[out]	pnFactor	R,G,Bの係数(0～255)
+*/
+static inline void
+GetBlendFactor( uint32_t nFactor, uint32_t nOther, uint32_t sa, uint32_t da, uint32_t nFix, int32_t* pnFactor )
+{
+	uint32_t n;
+
+	switch(nFactor) {
+		case 0:		// GU_SRC_COLOR/GU_DST_COLOR
+			pnFactor[0] = (int32_t)(nOther & 0xFF);
+			pnFactor[1] = (int32_t)((nOther >> 8) & 0xFF);
+			pnFactor[2] = (int32_t)((nOther >> 16) & 0xFF);
+			return;
+		case 1:		// GU_ONE_MINUS_SRC_COLOR/GU_ONE_MINUS_DST_COLOR
+			pnFactor[0] = 255 - (int32_t)(nOther & 0xFF);
+			pnFactor[1] = 255 - (int32_t)((nOther >> 8) & 0xFF);
+			pnFactor[2] = 255 - (int32_t)((nOther >> 16) & 0xFF);
+			return;
+		case 2:		n = sa;								break;	// GU_SRC_ALPHA
+		case 3:		n = 255 - sa;						break;	// GU_ONE_MINUS_SRC_ALPHA
+		case 4:		n = da;								break;	// GU_DST_ALPHA
+		case 5:		n = 255 - da;						break;	// GU_ONE_MINUS_DST_ALPHA
+		case 6:		n = (sa < 128) ? sa * 2 : 255;		break;	// 2 * ソースのアルファ
+		case 7:		n = (sa < 128) ? 255 - sa * 2 : 0;	break;
+		case 8:		n = (da < 128) ? da * 2 : 255;		break;	// 2 * デスティネーションのアルファ
+		case 9:		n = (da < 128) ? 255 - da * 2 : 0;	break;
+		case GU_FIX:
+		default:
+			pnFactor[0] = (int32_t)(nFix & 0xFF);
+			pnFactor[1] = (int32_t)((nFix >> 8) & 0xFF);
+			pnFactor[2] = (int32_t)((nFix >> 16) & 0xFF);
+			return;
+	}
+	pnFactor[0] = pnFactor[1] = pnFactor[2] = (int32_t)n;
+}
+
+//! アルファテストとステンシルテストの比較をする
+/*!
+	@param[in]	nFunc	比較(GU_NEVER～GU_GEQUAL)
+	@param[in]	a		比べる値
+	@param[in]	b		参照値
+	@return	通った場合は0以外
+*/
+static inline int
+Compare( uint32_t nFunc, uint32_t a, uint32_t b )
+{
+	switch(nFunc) {
+		case GU_NEVER:		return 0;
+		case GU_EQUAL:		return a == b;
+		case GU_NOTEQUAL:	return a != b;
+		case GU_LESS:		return a < b;
+		case GU_LEQUAL:		return a <= b;
+		case GU_GREATER:	return a > b;
+		case GU_GEQUAL:		return a >= b;
+		case GU_ALWAYS:
+		default:			return 1;
+	}
+}
+
+//! ステンシルの操作をする
+/*!
+	@param[in]	pState	設定
+	@param[in]	nDest	デスティネーションのステンシル
+	@return	書き込むステンシル
+*/
+static inline uint32_t
+StencilOp( const State* pState, uint32_t nDest )
+{
+	switch(pState->nStencilOp) {
+		case GU_ZERO:		return 0;
+		case GU_REPLACE:	return pState->nStencilRef;
+		case GU_INVERT:		return ~nDest & 0xFF;
+		case GU_INCR:		return (nDest < 0xFF) ? nDest + 1 : 0xFF;
+		case GU_DECR:		return (nDest > 0) ? nDest - 1 : 0;
+		case GU_KEEP:
+		default:			return nDest;
+	}
+}
+
+//! ブレンドする
+/*!
+	@param[in]	pState	設定
+	@param[in]	nSrc	ソースの色
+	@param[in]	nDest	デスティネーションの色
+	@return	ブレンドした色(アルファはデスティネーションのまま)
+*/
+static inline uint32_t
+Blend( const State* pState, uint32_t nSrc, uint32_t nDest )
+{
+	const uint32_t sa = nSrc >> 24;
+	uint32_t rc = nDest & 0xFF000000;
+	int32_t fa[3];
+	int32_t fb[3];
+	uint32_t i;
+
+	// 通常の半透明は、不透明と透明を先に片付ける
+	if((pState->nBlendOp == GU_ADD) && (pState->nBlendSrc == GU_SRC_ALPHA) && (pState->nBlendDest == GU_ONE_MINUS_SRC_ALPHA)) {
+		if(sa == 0xFF) {
+			return (nSrc & 0xFFFFFF) | rc;
+		} else if(sa == 0) {
+			return nDest;
+		}
+	}
+	GetBlendFactor( pState->nBlendSrc, nDest, sa, nDest >> 24, pState->nFixA, fa );
+	GetBlendFactor( pState->nBlendDest, nSrc, sa, nDest >> 24, pState->nFixB, fb );
+	for(i = 0; i < 3; i++) {
+		const int32_t s = (int32_t)((nSrc >> (i * 8)) & 0xFF);
+		const int32_t d = (int32_t)((nDest >> (i * 8)) & 0xFF);
+		int32_t c;
+
+		switch(pState->nBlendOp) {
+			case GU_SUBTRACT:			c = (s * fa[i] - d * fb[i] + 127) / 255;	break;
+			case GU_REVERSE_SUBTRACT:	c = (d * fb[i] - s * fa[i] + 127) / 255;	break;
+			case GU_MIN:				c = (s < d) ? s : d;						break;
+			case GU_MAX:				c = (s > d) ? s : d;						break;
+			case GU_ABS:				c = (s > d) ? s - d : d - s;				break;
+			case GU_ADD:
+			default:					c = (s * fa[i] + d * fb[i] + 127) / 255;	break;
+		}
+		if(c < 0) {
+			c = 0;
+		} else if(c > 255) {
+			c = 255;
+		}
+		rc |= (uint32_t)c << (i * 8);
+	}
+	return rc;
+}
+
+//! テクスチャ座標をテクスチャの中に収める
+/*!
+	@param[in]	t		テクスチャ座標(固定小数点)
+	@param[in]	nSize	テクスチャの大きさ(2の乗数)
+	@param[in]	fRepeat	繰り返すかどうか
+	@return	テクセルの位置
+*/
+static inline uint32_t
+WrapTexCoord( int32_t t, uint32_t nSize, uint32_t fRepeat )
+{
+	t >>= CAT_SOFTRENDER_FIX;
+	if(fRepeat) {
+		return (uint32_t)t & (nSize - 1);
+	} else if(t < 0) {
+		return 0;
+	} else if((uint32_t)t >= nSize) {
+		return nSize - 1;
+	}
+	return (uint32_t)t;
+}
+
+//! ピクセルを1つ描画する
+/*!
+	@param[in]	pState		設定の写し
+	@param[in]	pnClut		CLUT(使わない場合は0)
+	@param[in]	pItem		スプライト
+	@param[in]	tx			テクセルの横の位置
+	@param[in]	ty			テクセルの縦の位置
+	@param[in]	fModulate	頂点の色を掛けるかどうか
+	@param[out]	pvPixel		描画先のピクセル
+	@param[out]	pnCount		重ね描きの回数(数えない場合は0)
+	@param[out]	pnFragment		重ね描きに数えたピクセル数
+	@param[out]	pnTransparent	重ね描きに数えた透明なピクセル数
+*/
+static inline void
+DrawPixel( const State* pState, const uint32_t* pnClut, const Item* pItem, uint32_t tx, uint32_t ty, int fModulate,
+	void* pvPixel, uint16_t* pnCount, uint32_t* pnFragment, uint32_t* pnTransparent )
+{
+	const uint32_t nFormat = gTarget.nFormat;
+	uint32_t nSrc = pItem->nColor;
+	uint32_t nDest;
+
+	if(pItem->fClear) {
+		if(nFormat == GU_PSM_8888) {
+			*(uint32_t*)pvPixel = nSrc;
+		} else {
+			*(uint16_t*)pvPixel = (uint16_t)Pack16( nFormat, nSrc );
+		}
+		return;
+	}
+	if(pState->fTexture) {
+		nSrc = FetchTexel( pState, pnClut, tx, ty );
+		if(fModulate) {
+			nSrc = Modulate( nSrc, pItem->nColor );
+		}
+	}
+	if(pnCount) {
+		// アルファテストで捨てるピクセルも、テクセルを読むところまでは描画の手間がかかる
+		(*pnCount)++;
+		(*pnFragment)++;
+		if((nSrc >> 24) == 0) {
+			(*pnTransparent)++;
+		}
+	}
+	if(pState->fAlphaTest && !Compare( pState->nAlphaFunc, (nSrc >> 24) & pState->nAlphaMask, pState->nAlphaRef )) {
+		return;
+	}
+	nDest = (nFormat == GU_PSM_8888) ? *(uint32_t*)pvPixel : Expand16( nFormat, *(uint16_t*)pvPixel );
+	if(pState->fStencil && !Compare( pState->nStencilFunc, pState->nStencilRef & pState->nStencilMask, (nDest >> 24) & pState->nStencilMask )) {
+		return;
+	}
+	if(pState->fBlend) {
+		nSrc = Blend( pState, nSrc, nDest );
+	} else {
+		nSrc = (nSrc & 0xFFFFFF) | (nDest & 0xFF000000);
+	}
+	if(pState->fStencil) {
+		nSrc = (nSrc & 0xFFFFFF) | (StencilOp( pState, nDest >> 24 ) << 24);
+	}
+	if(nFormat == GU_PSM_8888) {
+		*(uint32_t*)pvPixel = nSrc;
+	} else {
+		*(uint16_t*)pvPixel = (uint16_t)Pack16( nFormat, nSrc );
+	}
+}
+
+//! タイルを1つ描画する
+/*!
+	@param[in]	nTile		タイルの番号
+	@param[in]	pWorker		描画するスレッド
+*/
+static void
+RasterizeTile( uint32_t nTile, Worker* pWorker )
+{
+	const int32_t tx0 = (int32_t)(nTile % CAT_SOFTRENDER_TILE_X) * CAT_SOFTRENDER_TILE_SIZE;
+	const int32_t ty0 = (int32_t)(nTile / CAT_SOFTRENDER_TILE_X) * CAT_SOFTRENDER_TILE_SIZE;
+	const uint32_t nFormat = gTarget.nFormat;
+	const uint32_t nWidth  = gTarget.nWidth;
+	uint8_t* pbFrame = gpbVram + gTarget.nOffset;
+	// 画面以外の描画先への描画は、重ね描きに数えない
+	uint16_t* pnOverdraw = (gTarget.nOffset == gDraw.nOffset) ? gpnOverdraw : 0;
+	uint32_t nPixel = 0;
+	uint32_t nFragment = 0;
+	uint32_t nTransparent = 0;
+	uint32_t i;
+
+	for(i = gnBinStart[nTile]; i < gnBinStart[nTile + 1]; i++) {
+		const Item* pItem   = &gpItem[gpnBin[i]];
+		const State* pState = &gpState[pItem->nState];
+		const uint32_t* pnClut = (pState->nClut != CAT_SOFTRENDER_CLUT_NONE) ? &gpnClut[pState->nClut * CAT_SOFTRENDER_CLUT_SIZE] : 0;
+		const int fModulate = (pState->nTexFunc != GU_TFX_REPLACE) && (pItem->nColor != 0xFFFFFFFF);
+		int32_t x0 = pItem->x0;
+		int32_t y0 = pItem->y0;
+		int32_t x1 = pItem->x1;
+		int32_t y1 = pItem->y1;
+		int32_t x;
+		int32_t y;
+
+		// タイルとシザーで切り取る
+		if(x0 < tx0) x0 = tx0;
+		if(y0 < ty0) y0 = ty0;
+		if(x1 > tx0 + CAT_SOFTRENDER_TILE_SIZE) x1 = tx0 + CAT_SOFTRENDER_TILE_SIZE;
+		if(y1 > ty0 + CAT_SOFTRENDER_TILE_SIZE) y1 = ty0 + CAT_SOFTRENDER_TILE_SIZE;
+		if(x0 < pState->nScissor[0]) x0 = pState->nScissor[0];
+		if(y0 < pState->nScissor[1]) y0 = pState->nScissor[1];
+		if(x1 > pState->nScissor[2]) x1 = pState->nScissor[2];
+		if(y1 > pState->nScissor[3]) y1 = pState->nScissor[3];
+		if((x0 >= x1) || (y0 >= y1)) {
+			continue;
+		}
+
+		if(pItem->nTriangle != CAT_SOFTRENDER_TRIANGLE_NONE) {
+			// 三角形は、3つの辺の内側にあるピクセルだけを描画する
+			const Triangle* pTriangle = &gpTriangle[pItem->nTriangle];
+			for(y = y0; y < y1; y++) {
+				uint16_t* pnCount = (pnOverdraw && (y < CAT_SCREEN_HEIGHT)) ? pnOverdraw + y * CAT_SCREEN_WIDTH : 0;
+				for(x = x0; x < x1; x++) {
+					uint32_t tx = 0;
+					uint32_t ty = 0;
+					if((pTriangle->anEdge[0][0] * x + pTriangle->anEdge[0][1] * y + pTriangle->anEdge[0][2] < 0)
+						|| (pTriangle->anEdge[1][0] * x + pTriangle->anEdge[1][1] * y + pTriangle->anEdge[1][2] < 0)
+						|| (pTriangle->anEdge[2][0] * x + pTriangle->anEdge[2][1] * y + pTriangle->anEdge[2][2] < 0)) {
+						continue;
+					}
+					if(pState->fTexture) {
+						tx = WrapTexCoord( (int32_t)floor( pTriangle->afU[0] * x + pTriangle->afU[1] * y + pTriangle->afU[2] ), pState->nTexWidth, pState->fRepeat );
+						ty = WrapTexCoord( (int32_t)floor( pTriangle->afV[0] * x + pTriangle->afV[1] * y + pTriangle->afV[2] ), pState->nTexHeight, pState->fRepeat );
+					}
+					nPixel++;
+					DrawPixel( pState, pnClut, pItem, tx, ty, fModulate,
+						(nFormat == GU_PSM_8888) ? (void*)((uint32_t*)pbFrame + y * nWidth + x) : (void*)((uint16_t*)pbFrame + y * nWidth + x),
+						pnCount ? &pnCount[x] : 0, &nFragment, &nTransparent );
+				}
+			}
+			continue;
+		}
+
+		nPixel += (uint32_t)((x1 - x0) * (y1 - y0));
+		for(y = y0; y < y1; y++) {
+			const uint32_t ty = pState->fTexture ? WrapTexCoord( pItem->v0 + pItem->dv * (y - pItem->y0), pState->nTexHeight, pState->fRepeat ) : 0;
+			int32_t u = pItem->u0 + pItem->du * (x0 - pItem->x0);
+			uint32_t* pn32 = (uint32_t*)pbFrame + y * nWidth;
+			uint16_t* pn16 = (uint16_t*)pbFrame + y * nWidth;
+			uint16_t* pnCount = (pnOverdraw && !pItem->fClear && (y < CAT_SCREEN_HEIGHT)) ? pnOverdraw + y * CAT_SCREEN_WIDTH : 0;
+
+			for(x = x0; x < x1; x++, u += pItem->du) {
+				const uint32_t tx = pState->fTexture ? WrapTexCoord( u, pState->nTexWidth, pState->fRepeat ) : 0;
+				DrawPixel( pState, pnClut, pItem, tx, ty, fModulate,
+					(nFormat == GU_PSM_8888) ? (void*)&pn32[x] : (void*)&pn16[x],
+					pnCount ? &pnCount[x] : 0, &nFragment, &nTransparent );
+			}
+		}
+	}
+	pWorker->nPixelCount += nPixel;
+	pWorker->nFragmentCount += nFragment;
+	pWorker->nTransparentCount += nTransparent;
+}
+
+//! 空いているタイルを取って描画する
+/*!
+	@param[in]	pWorker		描画するスレッド
+*/
+static void
+RasterizeTiles( Worker* pWorker )
+{
+	uint32_t nTile;
+
+	while((nTile = __sync_fetch_and_add( &gnNextTile, 1 )) < CAT_SOFTRENDER_TILE_COUNT) {
+		if(gnBinStart[nTile] != gnBinStart[nTile + 1]) {
+			RasterizeTile( nTile, pWorker );
+		}
+	}
+}
+
+//! 描画するスレッド
+/*!
+	@param[in]	pv	Worker
+	@return	0
+*/
+static void*
+WorkerMain( void* pv )
+{
+	Worker* pWorker = (Worker*)pv;
+
+	pthread_mutex_lock( &gMutex );
+	for(;;) {
+		while(!gfQuit && (pWorker->nGeneration == gnGeneration)) {
+			pthread_cond_wait( &gCondStart, &gMutex );
+		}
+		if(gfQuit) {
+			break;
+		}
+		pWorker->nGeneration = gnGeneration;
+		pthread_mutex_unlock( &gMutex );
+
+		RasterizeTiles( pWorker );
+
+		pthread_mutex_lock( &gMutex );
+		gnDoneCount++;
+		pthread_cond_signal( &gCondDone );
+	}
+	pthread_mutex_unlock( &gMutex );
+	return 0;
+}
+
+//! スプライトの重なるタイルの範囲を取得する
+/*!
+	@param[in]	pItem	スプライト
+	@param[out]	pnRange	左、上、右、下のタイル(右下を含む)
+	@return	画面に入る場合は1、入らない場合は0
+*/
+static int
+GetTileRange( const Item* pItem, int32_t* pnRange )
+{
+	const State* pState = &gpState[pItem->nState];
+	int32_t x0 = (pItem->x0 > pState->nScissor[0]) ? pItem->x0 : pState->nScissor[0];
+	int32_t y0 = (pItem->y0 > pState->nScissor[1]) ? pItem->y0 : pState->nScissor[1];
+	int32_t x1 = (pItem->x1 < pState->nScissor[2]) ? pItem->x1 : pState->nScissor[2];
+	int32_t y1 = (pItem->y1 < pState->nScissor[3]) ? pItem->y1 : pState->nScissor[3];
+
+	if(x0 < 0) x0 = 0;
+	if(y0 < 0) y0 = 0;
+	if(x1 > CAT_SCREEN_WIDTH) x1 = CAT_SCREEN_WIDTH;
+	if(y1 > CAT_SCREEN_HEIGHT) y1 = CAT_SCREEN_HEIGHT;
+	if((x0 >= x1) || (y0 >= y1)) {
+		return 0;
+	}
+	pnRange[0] = x0 / CAT_SOFTRENDER_TILE_SIZE;
+	pnRange[1] = y0 / CAT_SOFTRENDER_TILE_SIZE;
+	pnRange[2] = (x1 - 1) / CAT_SOFTRENDER_TILE_SIZE;
+	pnRange[3] = (y1 - 1) / CAT_SOFTRENDER_TILE_SIZE;
+	return 1;
+}
+
+//! 並べたスプライトを描画する
+/*!
+	スプライトをタイルに振り分けてから、全てのスレッドでタイルを描画する。
+*/
+static void
+Flush( void )
+{
+	uint32_t anCursor[CAT_SOFTRENDER_TILE_COUNT];
+	int32_t anRange[4];
+	uint32_t nTotal = 0;
+	uint32_t i;
+	int32_t x;
+	int32_t y;
+
+	if(gnItem == 0) {
+		return;
+	}
+
+	// タイルごとの数を数えて、先頭の位置を決めてから振り分ける
+	memset( gnBinStart, 0, sizeof(gnBinStart) );
+	for(i = 0; i < gnItem; i++) {
+		if(GetTileRange( &gpItem[i], anRange )) {
+			for(y = anRange[1]; y <= anRange[3]; y++) {
+				for(x = anRange[0]; x <= anRange[2]; x++) {
+					gnBinStart[x + y * CAT_SOFTRENDER_TILE_X]++;
+				}
+			}
+		}
+	}
+	for(i = 0; i < CAT_SOFTRENDER_TILE_COUNT; i++) {
+		const uint32_t n = gnBinStart[i];
+		gnBinStart[i] = nTotal;
+		anCursor[i]   = nTotal;
+		nTotal += n;
+	}
+	gnBinStart[CAT_SOFTRENDER_TILE_COUNT] = nTotal;
+	if(Reserve( (void**)&gpnBin, &gnBinMax, nTotal, sizeof(uint32_t) ) < 0) {
+		gnItem = 0;
+		gnTriangle = 0;
+		return;
+	}
+	for(i = 0; i < gnItem; i++) {
+		if(GetTileRange( &gpItem[i], anRange )) {
+			for(y = anRange[1]; y <= anRange[3]; y++) {
+				for(x = anRange[0]; x <= anRange[2]; x++) {
+					gpnBin[anCursor[x + y * CAT_SOFTRENDER_TILE_X]++] = i;
+				}
+			}
+		}
+	}
+
+	// 全てのスレッドで描画して、終わるのを待つ
+	gTarget = gExec;
+	gnNextTile = 0;
+	pthread_mutex_lock( &gMutex );
+	gnDoneCount = 0;
+	gnGeneration++;
+	pthread_cond_broadcast( &gCondStart );
+	pthread_mutex_unlock( &gMutex );
+
+	RasterizeTiles( &gWorker[0] );
+
+	pthread_mutex_lock( &gMutex );
+	while(gnDoneCount < gnThreadCount - 1) {
+		pthread_cond_wait( &gCondDone, &gMutex );
+	}
+	pthread_mutex_unlock( &gMutex );
+
+	gStatistics.nSpriteCount += gnItem;
+	if(gTarget.nOffset == gDraw.nOffset) {
+		// 画面以外の描画先は、読み出す画面にしない
+		gLast  = gTarget;
+		gfLast = 1;
+	}
+	gnItem = 0;
+	gnTriangle = 0;
+
+	// 設定の写しとCLUTは、今の設定が使っている分だけ残す
+	if(gState.nClut != CAT_SOFTRENDER_CLUT_NONE) {
+		memmove( gpnClut, &gpnClut[gState.nClut * CAT_SOFTRENDER_CLUT_SIZE], CAT_SOFTRENDER_CLUT_SIZE * sizeof(uint32_t) );
+		gState.nClut = 0;
+		gnClut = 1;
+	} else {
+		gnClut = 0;
+	}
+	gnState = 0;
+	gfStateDirty = 1;
+}
+
+//! 記録したリストを探す
+/*!
+	@param[in]	nKey	キー
+	@return	リスト。見つからない場合は0が返る。
+*/
+static const List*
+FindList( uintptr_t nKey )
+{
+	uint32_t i;
+
+	for(i = 0; i < CAT_SOFTRENDER_LIST_MAX; i++) {
+		if(gList[i].nKey == nKey) {
+			return &gList[i];
+		}
+	}
+	return 0;
+}
+
+//! 有効と無効を切り替える
+/*!
+	@param[in]	nState	GU_xxx
+	@param[in]	fEnable	有効にするかどうか
+*/
+static void
+SetEnable( uint32_t nState, uint32_t fEnable )
+{
+	switch(nState) {
+		case GU_TEXTURE_2D:
+			gState.fTexture = fEnable;
+			break;
+		case GU_BLEND:
+			gState.fBlend = fEnable;
+			break;
+		case GU_ALPHA_TEST:
+			gState.fAlphaTest = fEnable;
+			break;
+		case GU_STENCIL_TEST:
+			gState.fStencil = fEnable;
+			break;
+		default:
+			return;
+	}
+	gfStateDirty = 1;
+}
+
+//! 記録したリストのコマンドを順に実行する
+/*!
+	@param[in]	pList	リスト
+	@param[in]	nDepth	sceGuCallList()の入れ子の深さ
+*/
+static void
+ExecuteList( const List* pList, uint32_t nDepth )
+{
+	uint32_t i;
+
+	for(i = 0; i < pList->nCommand; i++) {
+		const Command* pCommand = &pList->pCommand[i];
+		const uint32_t* an = pCommand->an;
+
+		switch(pCommand->nType) {
+			case CMD_ENABLE:
+				SetEnable( an[0], 1 );
+				break;
+			case CMD_DISABLE:
+				SetEnable( an[0], 0 );
+				break;
+			case CMD_SCISSOR:
+				gState.nScissor[0] = (int32_t)an[0];
+				gState.nScissor[1] = (int32_t)an[1];
+				gState.nScissor[2] = (int32_t)(an[0] + an[2]);
+				gState.nScissor[3] = (int32_t)(an[1] + an[3]);
+				gfStateDirty = 1;
+				break;
+			case CMD_COLOR:
+				gnColor = an[0];
+				break;
+			case CMD_CLEAR_COLOR:
+				gnClearColor = an[0];
+				break;
+			case CMD_CLEAR:
+				AddClear( an[0] );
+				break;
+			case CMD_TEX_MODE:
+				gState.nTexFormat = an[0];
+				gState.fSwizzle   = an[1];
+				switch(an[0]) {
+					case GU_PSM_5650:
+					case GU_PSM_5551:
+					case GU_PSM_4444:	gState.nTexBits = 16;	break;
+					case GU_PSM_8888:	gState.nTexBits = 32;	break;
+					case GU_PSM_T4:		gState.nTexBits = 4;	break;
+					case GU_PSM_T8:		gState.nTexBits = 8;	break;
+					default:			gState.nTexBits = 0;	break;	// DXTなど
+				}
+				gfStateDirty = 1;
+				break;
+			case CMD_TEX_IMAGE:
+				gState.nTexWidth       = an[0];
+				gState.nTexHeight      = an[1];
+				gState.nTexBufferWidth = an[2];
+				gState.pbTexture       = (const uint8_t*)pCommand->pv;
+				gfStateDirty = 1;
+				break;
+			case CMD_TEX_FUNC:
+				gState.nTexFunc = an[0];
+				gfStateDirty = 1;
+				break;
+			case CMD_TEX_WRAP:
+				gState.fRepeat = (an[0] == GU_REPEAT);
+				gfStateDirty = 1;
+				break;
+			case CMD_CLUT_MODE:
+				gnClutFormat       = an[0];
+				gState.nClutShift  = an[1];
+				gState.nClutMask   = an[2];
+				gState.nClutOffset = an[3];
+				gfStateDirty = 1;
+				break;
+			case CMD_CLUT_LOAD:
+				LoadClut( an[0], pCommand->pv );
+				break;
+			case CMD_BLEND_FUNC:
+				gState.nBlendOp   = an[0];
+				gState.nBlendSrc  = an[1];
+				gState.nBlendDest = an[2];
+				gState.nFixA      = an[3];
+				gState.nFixB      = an[4];
+				gfStateDirty = 1;
+				break;
+			case CMD_DRAW_ARRAY:
+				if(an[0] == GU_TRIANGLES) {
+					AddTriangles( an[1], an[2], pCommand->pvIndex, pCommand->pv );
+				} else {
+					AddSprites( an[0], an[1], an[2], an[3], pCommand->pv );
+				}
+				break;
+			case CMD_DRAW_BUFFER:
+				// 前の描画先に並べた分を描いてから切り替える
+				Flush();
+				gExec.nFormat = an[0];
+				gExec.nOffset = an[1];
+				gExec.nWidth  = an[2];
+				break;
+			case CMD_ALPHA_FUNC:
+				gState.nAlphaFunc = an[0];
+				gState.nAlphaRef  = an[1] & an[2];
+				gState.nAlphaMask = an[2];
+				gfStateDirty = 1;
+				break;
+			case CMD_STENCIL_FUNC:
+				gState.nStencilFunc = an[0];
+				gState.nStencilRef  = an[1] & 0xFF;
+				gState.nStencilMask = an[2];
+				gfStateDirty = 1;
+				break;
+			case CMD_STENCIL_OP:
+				gState.nStencilOp = an[2];
+				gfStateDirty = 1;
+				break;
+			case CMD_CLEAR_STENCIL:
+				gnClearStencil = an[0] & 0xFF;
+				break;
+			case CMD_CALL:
+				if(nDepth < CAT_SOFTRENDER_CALL_DEPTH) {
+					const List* pCall = FindList( GetListKey( pCommand->pv ) );
+					if(pCall) {
+						ExecuteList( pCall, nDepth + 1 );
+					}
+				}
+				break;
+		}
+	}
+}
+
+//! GU_DIRECTのリストを実行する
+/*!
+	@param[in]	pList	リスト
+*/
+static void
+Execute( const List* pList )
+{
+	const uint32_t nStart = GetTime();
+
+	// 実機のsceGuStart()と同じく、リストの先頭でsceGuDrawBuffer()の描画先に戻す
+	gExec = gDraw;
+	ExecuteList( pList, 0 );
+	Flush();
+	gStatistics.nListCount++;
+	gStatistics.nTime += GetTime() - nStart;
+}
+
+/*
+	Host implementation of sceGu
+*/
+
+//! コマンドを記録する
+/*!
+	@param[in]	nType		コマンド(CMD_xxx)
+	@param[in]	n0			引数
+	@param[in]	n1			引数
+	@param[in]	n2			引数
+	@param[in]	n3			引数
+	@param[in]	n4			引数
+	@param[in]	pv			アドレスの引数
+	@param[in]	nWords		実機で積まれるコマンドの数(パケットサイズの見積もり用)
+	@return	記録したコマンド。失敗した場合は0が返る。
+*/
+static Command*
+Record( uint32_t nType, uint32_t n0, uint32_t n1, uint32_t n2, uint32_t n3, uint32_t n4, const void* pv, uint32_t nWords )
+{
+	List* pList = gpRecord;
+	Command* pCommand;
+
+	if(pList == 0) {
+		return 0;
+	}
+	if(Reserve( (void**)&pList->pCommand, &pList->nCommandMax, pList->nCommand + 1, sizeof(Command) ) < 0) {
+		return 0;
+	}
+	pCommand = &pList->pCommand[pList->nCommand++];
+	pCommand->nType = nType;
+	pCommand->an[0] = n0;
+	pCommand->an[1] = n1;
+	pCommand->an[2] = n2;
+	pCommand->an[3] = n3;
+	pCommand->an[4] = n4;
+	pCommand->pv    = pv;
+	pCommand->pvIndex = 0;
+	pList->nPacketSize += nWords * 4;
+	return pCommand;
+}
+
+void
+sceGuInit( void )
+{
+	Cat_SoftRenderInit( 0 );
+}
+
+void
+sceGuTerm( void )
+{
+}
+
+void
+sceGuStart( int cid, void* list )
+{
+	const uintptr_t nKey = GetListKey( list );
+	List* pList = 0;
+	Block* pBlock;
+	uint32_t i;
+
+	// 同じアドレスのリストは、作り直す
+	for(i = 0; i < CAT_SOFTRENDER_LIST_MAX; i++) {
+		if(gList[i].nKey == nKey) {
+			pList = &gList[i];
+			break;
+		}
+		if((pList == 0) && (gList[i].nKey == 0)) {
+			pList = &gList[i];
+		}
+	}
+	gpRecord    = pList;
+	gnRecordCid = cid;
+	if(pList == 0) {
+		return;
+	}
+	pList->nKey        = nKey;
+	pList->nCommand    = 0;
+	pList->nPacketSize = 0;
+	for(pBlock = pList->pBlock; pBlock; pBlock = pBlock->pNext) {
+		pBlock->nUsed = 0;
+	}
+	pList->pCurrent = pList->pBlock;
+}
+
+int
+sceGuFinish( void )
+{
+	List* pList = gpRecord;
+	int rc;
+
+	if(pList == 0) {
+		return 0;
+	}
+	rc = (int)pList->nPacketSize;
+	gpRecord = 0;
+	if(gnRecordCid == GU_DIRECT) {
+		Execute( pList );
+	}
+	return rc;
+}
+
+int
+sceGuSync( int mode, int what )
+{
+	// リストはsceGuFinish()の中で実行し終わっている
+	return 0;
+}
+
+int
+sceGuCheckList( void )
+{
+	return gpRecord ? (int)gpRecord->nPacketSize : 0;
+}
+
+void*
+sceGuGetMemory( int size )
+{
+	List* pList = gpRecord;
+	Block* pBlock;
+	void* rc;
+
+	if((pList == 0) || (size < 0)) {
+		return 0;
+	}
+	size = (size + 15) & ~15;
+
+	// 空きのあるブロックを探す。無ければ足す
+	pBlock = pList->pCurrent;
+	while(pBlock && (pBlock->nUsed + (uint32_t)size > pBlock->nSize)) {
+		pBlock = pBlock->pNext;
+	}
+	if(pBlock == 0) {
+		const uint32_t nSize = ((uint32_t)size > CAT_SOFTRENDER_BLOCK_SIZE) ? (uint32_t)size : CAT_SOFTRENDER_BLOCK_SIZE;
+		Block** ppLast = &pList->pBlock;
+		pBlock = (Block*)CAT_MALLOC( sizeof(Block) + nSize );
+		if(pBlock == 0) {
+			return 0;
+		}
+		pBlock->pNext  = 0;
+		pBlock->nSize  = nSize;
+		pBlock->nUsed  = 0;
+		pBlock->pbData = (uint8_t*)(pBlock + 1);
+		while(*ppLast) {
+			ppLast = &(*ppLast)->pNext;
+		}
+		*ppLast = pBlock;
+	}
+	pList->pCurrent = pBlock;
+	rc = pBlock->pbData + pBlock->nUsed;
+	pBlock->nUsed += (uint32_t)size;
+	pList->nPacketSize += (uint32_t)size + 8;	// 実機では、データを飛び越すジャンプが積まれる
+	return rc;
+}
+
+void
+sceGuCallList( const void* list )
+{
+	Record( CMD_CALL, 0, 0, 0, 0, 0, list, 2 );
+}
+
+void*
+sceGuSwapBuffers( void )
+{
+	const uint32_t nOffset = gDraw.nOffset;
+
+	gDraw.nOffset = gnDispOffset;
+	gnDispOffset  = nOffset;
+	return (void*)(uintptr_t)gDraw.nOffset;
+}
+
+int
+sceGuDisplay( int state )
+{
+	return state;
+}
+
+void
+sceGuDispBuffer( int width, int height, void* dispbp, int dispbw )
+{
+	gnDispOffset = GetVramOffset( dispbp );
+}
+
+void
+sceGuDrawBuffer( int psm, void* fbp, int fbw )
+{
+	gDraw.nFormat = (uint32_t)psm;
+	gDraw.nOffset = GetVramOffset( fbp );
+	gDraw.nWidth  = (uint32_t)fbw;
+}
+
+void
+sceGuDrawBufferList( int psm, void* fbp, int fbw )
+{
+	Record( CMD_DRAW_BUFFER, (uint32_t)psm, GetVramOffset( fbp ), (uint32_t)fbw, 0, 0, 0, 3 );
+}
+
+void
+sceGuDepthBuffer( void* zbp, int zbw )
+{
+}
+
+void
+sceGuDepthMask( int mask )
+{
+}
+
+void
+sceGuScissor( int x, int y, int w, int h )
+{
+	Record( CMD_SCISSOR, (uint32_t)x, (uint32_t)y, (uint32_t)w, (uint32_t)h, 0, 0, 2 );
+}
+
+void
+sceGuEnable( int state )
+{
+	Record( CMD_ENABLE, (uint32_t)state, 0, 0, 0, 0, 0, 1 );
+}
+
+void
+sceGuDisable( int state )
+{
+	Record( CMD_DISABLE, (uint32_t)state, 0, 0, 0, 0, 0, 1 );
+}
+
+void
+sceGuColor( unsigned int color )
+{
+	Record( CMD_COLOR, color, 0, 0, 0, 0, 0, 2 );
+}
+
+void
+sceGuClearColor( unsigned int color )
+{
+	Record( CMD_CLEAR_COLOR, color, 0, 0, 0, 0, 0, 0 );
+}
+
+void
+sceGuClear( int flags )
+{
+	Record( CMD_CLEAR, (uint32_t)flags, 0, 0, 0, 0, 0, 14 );
+}
+
+void
+sceGuAlphaFunc( int a0, int a1, int a2 )
+{
+	Record( CMD_ALPHA_FUNC, (uint32_t)a0, (uint32_t)a1, (uint32_t)a2, 0, 0, 0, 1 );
+}
+
+void
+sceGuStencilFunc( int func, int ref, int mask )
+{
+	Record( CMD_STENCIL_FUNC, (uint32_t)func, (uint32_t)ref, (uint32_t)mask, 0, 0, 0, 1 );
+}
+
+void
+sceGuStencilOp( int fail, int zfail, int zpass )
+{
+	Record( CMD_STENCIL_OP, (uint32_t)fail, (uint32_t)zfail, (uint32_t)zpass, 0, 0, 0, 1 );
+}
+
+void
+sceGuClearStencil( unsigned int stencil )
+{
+	Record( CMD_CLEAR_STENCIL, stencil, 0, 0, 0, 0, 0, 0 );
+}
+
+void
+sceGuTexMode( int tpsm, int maxmips, int a2, int swizzle )
+{
+	Record( CMD_TEX_MODE, (uint32_t)tpsm, (uint32_t)swizzle, 0, 0, 0, 0, 3 );
+}
+
+void
+sceGuTexImage( int mipmap, int width, int height, int tbw, const void* tbp )
+{
+	if(mipmap == 0) {
+		Record( CMD_TEX_IMAGE, (uint32_t)width, (uint32_t)height, (uint32_t)tbw, 0, 0, tbp, 4 );
+	}
+}
+
+void
+sceGuTexFunc( int tfx, int tcc )
+{
+	Record( CMD_TEX_FUNC, (uint32_t)tfx, (uint32_t)tcc, 0, 0, 0, 0, 1 );
+}
+
+void
+sceGuTexWrap( int u, int v )
+{
+	Record( CMD_TEX_WRAP, (uint32_t)u, (uint32_t)v, 0, 0, 0, 0, 1 );
+}
+
+void
+sceGuTexFilter( int min, int mag )
+{
+	// 常に最近傍
+}
+
+void
+sceGuTexFlush( void )
+{
+}
+
+void
+sceGuTexScale( float u, float v )
+{
+	// 2Dの頂点(GU_TRANSFORM_2D)では使われない
+}
+
+void
+sceGuTexOffset( float u, float v )
+{
+}
+
+void
+sceGuClutMode( unsigned int cpsm, unsigned int shift, unsigned int mask, unsigned int a3 )
+{
+	Record( CMD_CLUT_MODE, cpsm, shift, mask, a3, 0, 0, 1 );
+}
+
+void
+sceGuClutLoad( int num_blocks, const void* cbp )
+{
+	Record( CMD_CLUT_LOAD, (uint32_t)num_blocks, 0, 0, 0, 0, cbp, 3 );
+}
+
+void
+sceGuBlendFunc( int op, int src, int dest, unsigned int srcfix, unsigned int destfix )
+{
+	Record( CMD_BLEND_FUNC, (uint32_t)op, (uint32_t)src, (uint32_t)dest, srcfix, destfix, 0, 3 );
+}
+
+void
+sceGuDrawArray( int prim, int vtype, int count, const void* indices, const void* vertices )
+{
+	Command* pCommand = Record( CMD_DRAW_ARRAY, (uint32_t)prim, (uint32_t)vtype, (uint32_t)count, (indices != 0), 0, vertices, 3 );
+	if(pCommand) {
+		pCommand->pvIndex = indices;
+	}
+}
+
+void*
+sceGeEdramGetAddr( void )
+{
+	Cat_SoftRenderInit( 0 );
+	return (void*)CAT_SOFTRENDER_VRAM_ADDR;
+}
+
+unsigned int
+sceGeEdramGetSize( void )
+{
+	return CAT_SOFTRENDER_VRAM_SIZE;
+}
+
+int
+sceDisplayWaitVblankStart( void )
+{
+	WaitVblank();
+	return 0;
+}
+
+int
+sceDisplayWaitVblankStartCB( void )
+{
+	WaitVblank();
+	return 0;
+}
+
+void
+sceKernelDcacheWritebackRange( const void* p, unsigned int size )
+{
+}
+
+void
+sceKernelDcacheWritebackInvalidateRange( const void* p, unsigned int size )
+{
+}
+
+SceUInt32
+sceKernelGetSystemTimeLow( void )
+{
+	return GetTime();
+}
+
+int
+sceKernelDelayThread( SceUInt delay )
+{
+	usleep( (useconds_t)delay );
+	return 0;
+}
+
+/*
+	Cat_SoftRender
+*/
+
+//! VRAMを割り当てる
+/*!
+	同じメモリを、実機と同じアドレスとキャッシュを通さないアドレスの2か所に割り当てる。
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+static int32_t
+MapVram( void )
+{
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+	void* pv;
+
+	gnVramFd = memfd_create( "Cat_SoftRender", 0 );
+	if(gnVramFd < 0) {
+		return -1;
+	}
+	if(ftruncate( gnVramFd, CAT_SOFTRENDER_VRAM_SIZE ) < 0) {
+		close( gnVramFd );
+		gnVramFd = -1;
+		return -1;
+	}
+	// 古いカーネルはMAP_FIXED_NOREPLACEを知らずにヒントとして扱うので、アドレスを確かめる
+	pv = mmap( (void*)CAT_SOFTRENDER_VRAM_ADDR, CAT_SOFTRENDER_VRAM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED_NOREPLACE, gnVramFd, 0 );
+	if(pv != (void*)CAT_SOFTRENDER_VRAM_ADDR) {
+		if(pv != MAP_FAILED) {
+			munmap( pv, CAT_SOFTRENDER_VRAM_SIZE );
+		}
+		close( gnVramFd );
+		gnVramFd = -1;
+		return -1;
+	}
+	pv = mmap( (void*)CAT_SOFTRENDER_VRAM_UNCACHED, CAT_SOFTRENDER_VRAM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED_NOREPLACE, gnVramFd, 0 );
+	if(pv != (void*)CAT_SOFTRENDER_VRAM_UNCACHED) {
+		if(pv != MAP_FAILED) {
+			munmap( pv, CAT_SOFTRENDER_VRAM_SIZE );
+		}
+		munmap( (void*)CAT_SOFTRENDER_VRAM_ADDR, CAT_SOFTRENDER_VRAM_SIZE );
+		close( gnVramFd );
+		gnVramFd = -1;
+		return -1;
+	}
+	gpbVram = (uint8_t*)CAT_SOFTRENDER_VRAM_ADDR;
+	return 0;
+}
+
+//! 初期化する
+/*!
+	VRAMを割り当てて、描画するスレッドを作る。Cat_RenderInit()より前に呼ぶ。 \n
+	既に初期化されている場合は、何もしない。
+	@param[in]	nThreadCount	描画するスレッド数(呼び出したスレッドを含む。0の場合はCPUの数)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+	@see	Cat_SoftRenderTerm()
+*/
+int32_t
+Cat_SoftRenderInit( uint32_t nThreadCount )
+{
+	uint32_t i;
+
+	if(gfInit) {
+		return 0;
+	}
+	if(MapVram() < 0) {
+		return -1;
+	}
+
+	if(nThreadCount == 0) {
+		const long nCpu = sysconf( _SC_NPROCESSORS_ONLN );
+		nThreadCount = (nCpu > 0) ? (uint32_t)nCpu : 1;
+	}
+	if(nThreadCount > CAT_SOFTRENDER_THREAD_MAX) {
+		nThreadCount = CAT_SOFTRENDER_THREAD_MAX;
+	}
+	memset( gWorker, 0, sizeof(gWorker) );
+	gfQuit = 0;
+	gnThreadCount = 1;
+	for(i = 1; i < nThreadCount; i++) {
+		gWorker[i].nGeneration = gnGeneration;
+		if(pthread_create( &gWorker[i].thread, 0, WorkerMain, &gWorker[i] ) != 0) {
+			break;	// 作れた分だけで描画する
+		}
+		gnThreadCount++;
+	}
+
+	memset( gList, 0, sizeof(gList) );
+	gpRecord = 0;
+	gDraw.nFormat = GU_PSM_8888;
+	gDraw.nOffset = 0;
+	gDraw.nWidth  = 512;
+	gnDispOffset  = 0;
+	gfLast = 0;
+	ResetState();
+	memset( &gStatistics, 0, sizeof(gStatistics) );
+	gfInit = 1;
+	return 0;
+}
+
+//! 終了処理をする
+/*!
+	スレッドを終了して、VRAMを解放する。Cat_RenderTerm()の後に呼ぶ。
+*/
+void
+Cat_SoftRenderTerm( void )
+{
+	uint32_t i;
+
+	if(!gfInit) {
+		return;
+	}
+	pthread_mutex_lock( &gMutex );
+	gfQuit = 1;
+	pthread_cond_broadcast( &gCondStart );
+	pthread_mutex_unlock( &gMutex );
+	for(i = 1; i < gnThreadCount; i++) {
+		pthread_join( gWorker[i].thread, 0 );
+	}
+	gnThreadCount = 0;
+
+	for(i = 0; i < CAT_SOFTRENDER_LIST_MAX; i++) {
+		Block* pBlock = gList[i].pBlock;
+		while(pBlock) {
+			Block* pNext = pBlock->pNext;
+			CAT_FREE( pBlock );
+			pBlock = pNext;
+		}
+		free( gList[i].pCommand );
+	}
+	memset( gList, 0, sizeof(gList) );
+	gpRecord = 0;
+	free( gpState );
+	free( gpnClut );
+	free( gpItem );
+	free( gpTriangle );
+	free( gpnBin );
+	gpState = 0;
+	gpnClut = 0;
+	gpItem  = 0;
+	gpTriangle = 0;
+	gpnBin  = 0;
+	gnState = gnStateMax = 0;
+	gnClut  = gnClutMax  = 0;
+	gnItem  = gnItemMax  = 0;
+	gnTriangle = gnTriangleMax = 0;
+	gnBinMax = 0;
+	free( gpnOverdraw );
+	gpnOverdraw = 0;
+
+	munmap( (void*)CAT_SOFTRENDER_VRAM_UNCACHED, CAT_SOFTRENDER_VRAM_SIZE );
+	munmap( (void*)CAT_SOFTRENDER_VRAM_ADDR, CAT_SOFTRENDER_VRAM_SIZE );
+	close( gnVramFd );
+	gnVramFd = -1;
+	gpbVram  = 0;
+	gfInit   = 0;
+}
+
+//! 垂直同期の周波数を設定する
+/*!
+	@param[in]	nRefreshRate	周波数(Hz単位。0の場合は待たない)
+*/
+void
+Cat_SoftRenderSetRefreshRate( uint32_t nRefreshRate )
+{
+	gnRefreshRate = nRefreshRate;
+}
+
+//! 最後に描画した画面を読み出す
+/*!
+	最後に実行したリストの描画先から、480x272ドットを0xAABBGGRRの32bitに変換して読み出す。 \n
+	Cat_RenderScreenUpdate()でリストが実行されるので、その後に呼ぶ。
+	@param[out]	pnDest	読み出し先(480*272個)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+int32_t
+Cat_SoftRenderReadPixels( uint32_t* pnDest )
+{
+	const FrameBuffer* pFrame = gfLast ? &gLast : &gDraw;
+	uint32_t x;
+	uint32_t y;
+
+	if(!gfInit || (pnDest == 0)) {
+		return -1;
+	}
+	for(y = 0; y < CAT_SCREEN_HEIGHT; y++) {
+		if(pFrame->nFormat == GU_PSM_8888) {
+			memcpy( pnDest, (const uint32_t*)(gpbVram + pFrame->nOffset) + y * pFrame->nWidth, CAT_SCREEN_WIDTH * sizeof(uint32_t) );
+		} else {
+			const uint16_t* pn16 = (const uint16_t*)(gpbVram + pFrame->nOffset) + y * pFrame->nWidth;
+			for(x = 0; x < CAT_SCREEN_WIDTH; x++) {
+				pnDest[x] = Expand16( pFrame->nFormat, pn16[x] );
+			}
+		}
+		pnDest += CAT_SCREEN_WIDTH;
+	}
+	return 0;
+}
+
+//! 統計情報を取得する
+/*!
+	@param[out]	pStatistics		統計情報
+*/
+void
+Cat_SoftRenderGetStatistics( Cat_SoftRenderStatistics* pStatistics )
+{
+	uint32_t i;
+
+	if(pStatistics) {
+		*pStatistics = gStatistics;
+		pStatistics->nThreadCount = gnThreadCount;
+		for(i = 0; i < gnThreadCount; i++) {
+			pStatistics->nPixelCount += gWorker[i].nPixelCount;
+		}
+	}
+}
+
+//! 統計情報をクリアする
+void
+Cat_SoftRenderResetStatistics( void )
+{
+	uint32_t i;
+
+	memset( &gStatistics, 0, sizeof(gStatistics) );
+	for(i = 0; i < CAT_SOFTRENDER_THREAD_MAX; i++) {
+		gWorker[i].nPixelCount = 0;
+	}
+}
+
+//! 重ね描きを数えるかどうかを設定する
+/*!
+	@param[in]	fEnable		数える場合は0以外
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+int32_t
+Cat_SoftRenderEnableOverdraw( int32_t fEnable )
+{
+	uint32_t i;
+
+	if(!fEnable) {
+		free( gpnOverdraw );
+		gpnOverdraw = 0;
+		return 0;
+	}
+	if(gpnOverdraw == 0) {
+		gpnOverdraw = (uint16_t*)calloc( CAT_SCREEN_WIDTH * CAT_SCREEN_HEIGHT, sizeof(uint16_t) );
+		if(gpnOverdraw == 0) {
+			return -1;
+		}
+		for(i = 0; i < CAT_SOFTRENDER_THREAD_MAX; i++) {
+			gWorker[i].nFragmentCount    = 0;
+			gWorker[i].nTransparentCount = 0;
+		}
+	}
+	return 0;
+}
+
+//! 描画した回数をヒートマップの色にする
+/*!
+	@param[in]	nCount	描画した回数
+	@return	0xAABBGGRRの色
+*/
+static uint32_t
+GetHeatColor( uint32_t nCount )
+{
+	// 無し:黒 1回:青 2回:緑 3回:黄 4回:橙 5～7回:赤 8回以上:白
+	static const uint32_t anColor[9] = {
+		0xFF000000, 0xFFFF4000, 0xFF00C000, 0xFF00FFFF, 0xFF0080FF, 0xFF0000FF, 0xFF0000FF, 0xFF0000FF, 0xFFFFFFFF,
+	};
+	return anColor[(nCount < 8) ? nCount : 8];
+}
+
+//! 重ね描きを読み出してクリアする
+/*!
+	@param[out]	pnCount		ピクセルごとに描画した回数(480*272個。要らない場合は0)
+	@param[out]	pnHeatmap	ヒートマップ(480*272個、0xAABBGGRR。要らない場合は0)
+	@param[out]	pOverdraw	重ね描きの統計情報(要らない場合は0)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+int32_t
+Cat_SoftRenderReadOverdraw( uint16_t* pnCount, uint32_t* pnHeatmap, Cat_SoftRenderOverdraw* pOverdraw )
+{
+	Cat_SoftRenderOverdraw overdraw;
+	uint32_t i;
+
+	if(gpnOverdraw == 0) {
+		return -1;
+	}
+	memset( &overdraw, 0, sizeof(overdraw) );
+	for(i = 0; i < CAT_SOFTRENDER_THREAD_MAX; i++) {
+		overdraw.nFragmentCount    += gWorker[i].nFragmentCount;
+		overdraw.nTransparentCount += gWorker[i].nTransparentCount;
+		gWorker[i].nFragmentCount    = 0;
+		gWorker[i].nTransparentCount = 0;
+	}
+	for(i = 0; i < CAT_SCREEN_WIDTH * CAT_SCREEN_HEIGHT; i++) {
+		const uint32_t n = gpnOverdraw[i];
+		if(n) {
+			overdraw.nCoveredCount++;
+		}
+		if(overdraw.nMax < n) {
+			overdraw.nMax = n;
+		}
+		if(pnHeatmap) {
+			pnHeatmap[i] = GetHeatColor( n );
+		}
+	}
+	if(pnCount) {
+		memcpy( pnCount, gpnOverdraw, CAT_SCREEN_WIDTH * CAT_SCREEN_HEIGHT * sizeof(uint16_t) );
+	}
+	memset( gpnOverdraw, 0, CAT_SCREEN_WIDTH * CAT_SCREEN_HEIGHT * sizeof(uint16_t) );
+	if(pOverdraw) {
+		*pOverdraw = overdraw;
+	}
+	return 0;
+}
+
+#endif	// USE_CAT_SOFTRENDER
@@ -0,0 +1,536 @@
+//! @file	Cat_SpriteBatch.c
+// スプライトをまとめて描画する
+//
+// 追加する時に、テクスチャとパレットの組にフレーム内の番号を振って、
+// レイヤー(8bit)、ブレンド(4bit)、番号(20bit)を32bitのキーにする。
+// キーを8bitずつ基数ソートするので、比較ソートと違って数千枚でも一定の手間で並ぶ。
+
+#include <pspgu.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>	// for memalign
+#include "Cat_SpriteBatch.h"
+#include "Cat_RenderState.h"
+#include "Cat_Render.h"
+
+#ifndef CAT_MALLOC
+//! メモリ確保マクロ
+#define CAT_MALLOC(x) memalign( 32, (x) )
+#endif // CAT_MALLOC
+
+#ifndef CAT_FREE
+//! メモリ解放マクロ
+#define CAT_FREE(x) free( x )
+#endif // CAT_FREE
+
+//! 実スクリーンサイズ 横幅
+#define CAT_SCREEN_WIDTH  (480)
+//! 実スクリーンサイズ 縦幅
+#define CAT_SCREEN_HEIGHT (272)
+
+//! キーのレイヤーの位置
+#define CAT_SPRITEBATCH_KEY_LAYER_SHIFT (24)
+//! キーのブレンドの位置
+#define CAT_SPRITEBATCH_KEY_BLEND_SHIFT (20)
+//! キーの設定(ブレンド、テクスチャ、パレット)の部分
+#define CAT_SPRITEBATCH_KEY_STATE_MASK ((1UL << CAT_SPRITEBATCH_KEY_LAYER_SHIFT) - 1)
+//! 溜められるスプライト数の最大値(番号が20bitに収まる数)
+#define CAT_SPRITEBATCH_COUNT_MAX (1UL << CAT_SPRITEBATCH_KEY_BLEND_SHIFT)
+
+//! 1回で確保する頂点の数(スプライト数。描画パケットの分割に収まり、sceGuDrawArray()の頂点数の上限も超えない)
+#define CAT_SPRITEBATCH_CHUNK (1024)
+
+//! 頂点
+typedef struct {
+	short	u,v;
+	short	x,y,z;
+} __attribute__((packed)) Vertex;
+
+//! 溜めたスプライト
+typedef struct {
+	Cat_Texture*	pTexture;		/*!< 設定するテクスチャ(分割テクスチャは分割後)	*/
+	Cat_Palette*	pPalette;		/*!< 設定するパレット(0ならテクスチャのもの)	*/
+	short			x0, y0;			/*!< 描画位置 左上								*/
+	short			x1, y1;			/*!< 描画位置 右下								*/
+	short			u0, v0;			/*!< テクスチャ座標 左上						*/
+	short			u1, v1;			/*!< テクスチャ座標 右下						*/
+	uint32_t		nBlend;			/*!< ブレンドの方法								*/
+	uint32_t		nFixA;			/*!< 重み付き加算のソースの固定値				*/
+	uint32_t		nFixB;			/*!< 重み付き加算の描画先の固定値				*/
+} Sprite;
+
+//! テクスチャとパレットの組の番号
+typedef struct {
+	Cat_Texture*	pTexture;		/*!< テクスチャ						*/
+	Cat_Palette*	pPalette;		/*!< パレット						*/
+	uint32_t		nStamp;			/*!< 使ったフレーム(違えば空き)		*/
+	uint32_t		nId;			/*!< 番号							*/
+} State;
+
+//! スプライトをまとめて描画する
+struct _Cat_SpriteBatch {
+	uint32_t					nCount;			/*!< 溜められるスプライト数			*/
+	uint32_t					nUsed;			/*!< 溜めたスプライト数				*/
+	Sprite*						pSprite;		/*!< 溜めたスプライト				*/
+	uint32_t*					pnKey;			/*!< ソートのキー					*/
+	uint32_t*					pnIndex;		/*!< ソートした順番					*/
+	uint32_t*					pnWork;			/*!< ソートの作業領域(キーと順番)	*/
+	State*						pState;			/*!< 番号のハッシュ表				*/
+	uint32_t					nStateMask;		/*!< ハッシュ表の大きさ - 1			*/
+	uint32_t					nStateCount;	/*!< このフレームで振った番号の数	*/
+	uint32_t					nStamp;			/*!< フレームの番号					*/
+	Cat_SpriteBatchStatistics	statistics;		/*!< 統計情報						*/
+};
+
+//! テクスチャとパレットの組の番号を取得する
+/*!
+	このフレームで初めて出てきた組には、新しい番号を振る。
+	@param[in,out]	pBatch		バッチ
+	@param[in]		pTexture	テクスチャ
+	@param[in]		pPalette	パレット
+	@return	番号
+*/
+static uint32_t
+GetStateId( Cat_SpriteBatch* pBatch, Cat_Texture* pTexture, Cat_Palette* pPalette )
+{
+	uint32_t nHash = (uint32_t)(((uintptr_t)pTexture >> 4) * 2654435761U) ^ (uint32_t)((uintptr_t)pPalette >> 4);
+
+	for(;;) {
+		State* pState = &pBatch->pState[nHash & pBatch->nStateMask];
+		if(pState->nStamp != pBatch->nStamp) {
+			pState->pTexture = pTexture;
+			pState->pPalette = pPalette;
+			pState->nStamp   = pBatch->nStamp;
+			pState->nId      = pBatch->nStateCount++;
+			return pState->nId;
+		}
+		if((pState->pTexture == pTexture) && (pState->pPalette == pPalette)) {
+			return pState->nId;
+		}
+		nHash++;	// 表はスプライト数の2倍以上あるので、必ず空きが見つかる
+	}
+}
+
+//! 重みをGU_FIXの値にする
+/*!
+	@param[in]	nAlpha	重み(0～CAT_SPRITEBATCH_ALPHA_UNIT)
+	@return	GU_FIXの値(0xBBGGRR)
+*/
+static uint32_t
+GetFix( uint32_t nAlpha )
+{
+	return ((nAlpha * 255 + CAT_SPRITEBATCH_ALPHA_UNIT / 2) / CAT_SPRITEBATCH_ALPHA_UNIT) * 0x010101;
+}
+
+//! 1枚分を溜める
+/*!
+	@param[in,out]	pBatch		バッチ
+	@param[in]		pTexture	設定するテクスチャ
+	@param[in]		pSprite		スプライト
+	@param[in]		x0			描画位置 左
+	@param[in]		y0			描画位置 上
+	@param[in]		x1			描画位置 右
+	@param[in]		y1			描画位置 下
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+static int32_t
+Push( Cat_SpriteBatch* pBatch, Cat_Texture* pTexture, const Cat_SpriteBatchSprite* pSprite, int32_t x0, int32_t y0, int32_t x1, int32_t y1 )
+{
+	Sprite* pDest;
+	uint32_t nId;
+
+	if((x1 <= 0) || (x0 >= CAT_SCREEN_WIDTH) || (y1 <= 0) || (y0 >= CAT_SCREEN_HEIGHT)) {
+		pBatch->statistics.nCullCount++;
+		return 0;	// 画面外
+	}
+	if(pBatch->nUsed >= pBatch->nCount) {
+		pBatch->statistics.nOverflowCount++;
+		return -1;
+	}
+	nId = GetStateId( pBatch, pTexture, pSprite->pPalette );
+	pDest = &pBatch->pSprite[pBatch->nUsed];
+	pDest->pTexture = pTexture;
+	pDest->pPalette = pSprite->pPalette;
+	pDest->x0 = (short)x0;
+	pDest->y0 = (short)y0;
+	pDest->x1 = (short)x1;
+	pDest->y1 = (short)y1;
+	if(pSprite->nFlags & CAT_SPRITEBATCH_FLIP_X) {
+		pDest->u0 = (short)pTexture->nTextureWidth;
+		pDest->u1 = 0;
+	} else {
+		pDest->u0 = 0;
+		pDest->u1 = (short)pTexture->nTextureWidth;
+	}
+	if(pSprite->nFlags & CAT_SPRITEBATCH_FLIP_Y) {
+		pDest->v0 = (short)pTexture->nTextureHeight;
+		pDest->v1 = 0;
+	} else {
+		pDest->v0 = 0;
+		pDest->v1 = (short)pTexture->nTextureHeight;
+	}
+	pDest->nBlend = pSprite->nBlend;
+	pDest->nFixA  = (pSprite->nBlend == CAT_SPRITEBATCH_BLEND_ADDALPHA) ? GetFix( pSprite->nSrcAlpha ) : 0;
+	pDest->nFixB  = (pSprite->nBlend == CAT_SPRITEBATCH_BLEND_ADDALPHA) ? GetFix( pSprite->nDestAlpha ) : 0;
+	pBatch->pnKey[pBatch->nUsed] = (pSprite->nLayer << CAT_SPRITEBATCH_KEY_LAYER_SHIFT)
+		| (pSprite->nBlend << CAT_SPRITEBATCH_KEY_BLEND_SHIFT) | nId;
+	pBatch->nUsed++;
+	return 0;
+}
+
+//! キーを基数ソートする
+/*!
+	8bitずつ4回に分けて、下の桁から安定に並べる。 \n
+	全部が同じ値の桁は飛ばすので、レイヤーやブレンドを使わなければ回数が減る。
+	@param[in,out]	pBatch	バッチ(pnIndexに並べた順番が入る)
+*/
+static void
+RadixSort( Cat_SpriteBatch* pBatch )
+{
+	const uint32_t nCount = pBatch->nUsed;
+	uint32_t* pnKey   = pBatch->pnKey;
+	uint32_t* pnIndex = pBatch->pnIndex;
+	uint32_t* pnKeyWork   = pBatch->pnWork;
+	uint32_t* pnIndexWork = pBatch->pnWork + pBatch->nCount;
+	uint32_t nShift;
+	uint32_t i;
+
+	for(i = 0; i < nCount; i++) {
+		pnIndex[i] = i;
+	}
+	for(nShift = 0; nShift < 32; nShift += 8) {
+		uint32_t anOffset[256];
+		uint32_t nTotal = 0;
+		uint32_t* pnSwap;
+
+		memset( anOffset, 0, sizeof(anOffset) );
+		for(i = 0; i < nCount; i++) {
+			anOffset[(pnKey[i] >> nShift) & 0xFF]++;
+		}
+		if(anOffset[(pnKey[0] >> nShift) & 0xFF] == nCount) {
+			continue;	// この桁は全部同じ
+		}
+		for(i = 0; i < 256; i++) {
+			const uint32_t n = anOffset[i];
+			anOffset[i] = nTotal;
+			nTotal += n;
+		}
+		for(i = 0; i < nCount; i++) {
+			const uint32_t nDest = anOffset[(pnKey[i] >> nShift) & 0xFF]++;
+			pnKeyWork[nDest]   = pnKey[i];
+			pnIndexWork[nDest] = pnIndex[i];
+		}
+		pnSwap = pnKey;   pnKey   = pnKeyWork;   pnKeyWork   = pnSwap;
+		pnSwap = pnIndex; pnIndex = pnIndexWork; pnIndexWork = pnSwap;
+	}
+	if(pnIndex != pBatch->pnIndex) {
+		// 奇数回入れ替えたので、結果は作業領域にある
+		memcpy( pBatch->pnIndex, pnIndex, sizeof(uint32_t) * nCount );
+		memcpy( pBatch->pnKey, pnKey, sizeof(uint32_t) * nCount );
+	}
+}
+
+//! ブレンドの方法を設定する
+/*!
+	重み付き加算の時だけアルファテストを有効にする。
+	@param[in]	nBlend			ブレンドの方法(CAT_SPRITEBATCH_BLEND_xxx)
+	@param[in]	nFixA			重み付き加算のソースの固定値
+	@param[in]	nFixB			重み付き加算の描画先の固定値
+	@param[in,out]	pfAlphaTest	アルファテストが有効かどうか
+*/
+static void
+SetBlend( uint32_t nBlend, uint32_t nFixA, uint32_t nFixB, int* pfAlphaTest )
+{
+	const int fAlphaTest = (nBlend == CAT_SPRITEBATCH_BLEND_ADDALPHA);
+
+	if(fAlphaTest != *pfAlphaTest) {
+		// 透明なテクセルで描画先の重みが掛からないように捨てる
+		if(fAlphaTest) {
+			sceGuAlphaFunc( GU_GREATER, 0, 0xFF );
+			sceGuEnable( GU_ALPHA_TEST );
+		} else {
+			sceGuDisable( GU_ALPHA_TEST );
+		}
+		*pfAlphaTest = fAlphaTest;
+	}
+	switch(nBlend) {
+	case CAT_SPRITEBATCH_BLEND_ADDALPHA:
+		Cat_RenderStateBlendFunc( GU_ADD, GU_FIX, GU_FIX, nFixA, nFixB );
+		break;
+	case CAT_SPRITEBATCH_BLEND_ADD:
+		Cat_RenderStateBlendFunc( GU_ADD, GU_SRC_ALPHA, GU_FIX, 0, 0xFFFFFF );
+		break;
+	case CAT_SPRITEBATCH_BLEND_SUB:
+		Cat_RenderStateBlendFunc( GU_REVERSE_SUBTRACT, GU_SRC_ALPHA, GU_FIX, 0, 0xFFFFFF );
+		break;
+	default:
+		Cat_RenderStateBlendFunc( GU_ADD, GU_SRC_ALPHA, GU_ONE_MINUS_SRC_ALPHA, 0, 0 );
+		break;
+	}
+}
+
+//! スプライトを初期値で初期化する
+/*!
+	等倍、反転なし、レイヤー0、半透明になる。
+	@param[out]	pSprite	スプライト
+*/
+void
+Cat_SpriteBatchSpriteInit( Cat_SpriteBatchSprite* pSprite )
+{
+	if(pSprite == 0) {
+		return;
+	}
+	memset( pSprite, 0, sizeof(Cat_SpriteBatchSprite) );
+	pSprite->fScaleX = 1.0f;
+	pSprite->fScaleY = 1.0f;
+	pSprite->nBlend  = CAT_SPRITEBATCH_BLEND_ALPHA;
+	pSprite->nSrcAlpha  = CAT_SPRITEBATCH_ALPHA_UNIT;
+	pSprite->nDestAlpha = 0;
+}
+
+//! 作成する
+/*!
+	@param[in]	nCount	1フレームで溜められるスプライト数(分割テクスチャは分割後の数)
+	@return	作成されたバッチ。失敗した場合は0が返る。
+	@see	Cat_SpriteBatchDestroy()
+*/
+Cat_SpriteBatch*
+Cat_SpriteBatchCreate( uint32_t nCount )
+{
+	Cat_SpriteBatch* rc;
+	uint32_t nStateSize = 16;
+
+	if((nCount == 0) || (nCount > CAT_SPRITEBATCH_COUNT_MAX)) {
+		return 0;
+	}
+	while(nStateSize < nCount * 2) {
+		nStateSize <<= 1;
+	}
+
+	rc = (Cat_SpriteBatch*)CAT_MALLOC( sizeof(Cat_SpriteBatch) );
+	if(rc == 0) {
+		return 0;
+	}
+	memset( rc, 0, sizeof(Cat_SpriteBatch) );
+	rc->nCount     = nCount;
+	rc->nStateMask = nStateSize - 1;
+	rc->nStamp     = 1;
+	rc->pSprite = (Sprite*)CAT_MALLOC( sizeof(Sprite) * nCount );
+	rc->pnKey   = (uint32_t*)CAT_MALLOC( sizeof(uint32_t) * nCount );
+	rc->pnIndex = (uint32_t*)CAT_MALLOC( sizeof(uint32_t) * nCount );
+	rc->pnWork  = (uint32_t*)CAT_MALLOC( sizeof(uint32_t) * nCount * 2 );
+	rc->pState  = (State*)CAT_MALLOC( sizeof(State) * nStateSize );
+	if((rc->pSprite == 0) || (rc->pnKey == 0) || (rc->pnIndex == 0) || (rc->pnWork == 0) || (rc->pState == 0)) {
+		Cat_SpriteBatchDestroy( rc );
+		return 0;
+	}
+	memset( rc->pState, 0, sizeof(State) * nStateSize );
+	return rc;
+}
+
+//! 破棄する
+/*!
+	@param[in]	pBatch	バッチ
+*/
+void
+Cat_SpriteBatchDestroy( Cat_SpriteBatch* pBatch )
+{
+	if(pBatch == 0) {
+		return;
+	}
+	CAT_FREE( pBatch->pSprite );
+	CAT_FREE( pBatch->pnKey );
+	CAT_FREE( pBatch->pnIndex );
+	CAT_FREE( pBatch->pnWork );
+	CAT_FREE( pBatch->pState );
+	CAT_FREE( pBatch );
+}
+
+//! スプライトを追加する
+/*!
+	テクスチャとパレットの参照は持たないので、Cat_SpriteBatchFlush()まで解放しないこと。
+	@param[in]	pBatch	バッチ
+	@param[in]	pSprite	スプライト
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+int32_t
+Cat_SpriteBatchAdd( Cat_SpriteBatch* pBatch, const Cat_SpriteBatchSprite* pSprite )
+{
+	Cat_Texture* pTexture;
+	float x;
+	float y;
+	float w;
+	float h;
+	float sx;
+	float sy;
+	uint32_t tx;
+	uint32_t ty;
+
+	if((pBatch == 0) || (pSprite == 0) || (pSprite->pTexture == 0)) {
+		return -1;
+	}
+	if((pSprite->nLayer > CAT_SPRITEBATCH_LAYER_MAX) || (pSprite->nBlend >= CAT_SPRITEBATCH_BLEND_MAX)) {
+		return -1;
+	}
+	if((pSprite->nBlend == CAT_SPRITEBATCH_BLEND_ADDALPHA)
+		&& ((pSprite->nSrcAlpha > CAT_SPRITEBATCH_ALPHA_UNIT) || (pSprite->nDestAlpha > CAT_SPRITEBATCH_ALPHA_UNIT))) {
+		return -1;
+	}
+	pTexture = pSprite->pTexture;
+	x = pSprite->x;
+	y = pSprite->y;
+	w = (float)Cat_TextureGetWidth( pTexture ) * pSprite->fScaleX;
+	h = (float)Cat_TextureGetHeight( pTexture ) * pSprite->fScaleY;
+	if(pTexture->ppTile == 0) {
+		return Push( pBatch, pTexture, pSprite, (int32_t)x, (int32_t)y, (int32_t)(x + w), (int32_t)(y + h) );
+	}
+
+	// 分割テクスチャは、Cat_TextureDraw()と同じ計算で1枚ずつ溜める
+	sx = w / (float)pTexture->nTextureWidth;
+	sy = h / (float)pTexture->nTextureHeight;
+	for(ty = 0; ty < pTexture->nTileCountY; ty++) {
+		for(tx = 0; tx < pTexture->nTileCountX; tx++) {
+			Cat_Texture* pTile = Cat_TextureGetTile( pTexture, tx, ty );
+			int32_t x0 = (int32_t)(x + (float)(tx * CAT_TEXTURE_TILE_SIZE) * sx);
+			int32_t x1 = (int32_t)(x + (float)(tx * CAT_TEXTURE_TILE_SIZE + pTile->nTextureWidth) * sx);
+			int32_t y0 = (int32_t)(y + (float)(ty * CAT_TEXTURE_TILE_SIZE) * sy);
+			int32_t y1 = (int32_t)(y + (float)(ty * CAT_TEXTURE_TILE_SIZE + pTile->nTextureHeight) * sy);
+			if(pSprite->nFlags & CAT_SPRITEBATCH_FLIP_X) {
+				// 反転した時は、分割テクスチャの並びも反対にする
+				const int32_t nRight = (int32_t)x + (int32_t)(x + w);
+				const int32_t x0Flip = nRight - x1;
+				x1 = nRight - x0;
+				x0 = x0Flip;
+			}
+			if(pSprite->nFlags & CAT_SPRITEBATCH_FLIP_Y) {
+				const int32_t nBottom = (int32_t)y + (int32_t)(y + h);
+				const int32_t y0Flip = nBottom - y1;
+				y1 = nBottom - y0;
+				y0 = y0Flip;
+			}
+			if(Push( pBatch, pTile, pSprite, x0, y0, x1, y1 ) < 0) {
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
+//! 溜めたスプライトを描画する
+/*!
+	Cat_RenderBegin()とCat_RenderEnd()の間で呼ぶ。溜めたスプライトは空になる。 \n
+	描画後は、ブレンドの方法を半透明に戻す(重み付き加算で有効にしたアルファテストも無効に戻す)。
+	@param[in]	pBatch	バッチ
+	@return	sceGuDrawArray()の回数
+*/
+uint32_t
+Cat_SpriteBatchFlush( Cat_SpriteBatch* pBatch )
+{
+	const int nVertexType = GU_TEXTURE_16BIT | GU_VERTEX_16BIT | GU_TRANSFORM_2D;
+	Vertex* pVertex = 0;
+	uint32_t nChunk = 0;
+	uint32_t nStart = 0;
+	uint32_t rc = 0;
+	int fAlphaTest = 0;
+	uint32_t i;
+
+	if(pBatch == 0) {
+		return 0;
+	}
+	pBatch->statistics.nFlushCount++;
+	if(pBatch->nUsed == 0) {
+		return 0;
+	}
+	RadixSort( pBatch );
+
+	// 頂点は、描画パケットの分割に収まるようにCAT_SPRITEBATCH_CHUNK枚ずつ確保する
+	for(i = 0; i < pBatch->nUsed; i++) {
+		const Sprite* pSprite = &pBatch->pSprite[pBatch->pnIndex[i]];
+		const Sprite* pPrev = (i == 0) ? 0 : &pBatch->pSprite[pBatch->pnIndex[i - 1]];
+		// 重みはキーに入らないので、重みが変わった時も設定を切り替える
+		const int fState = (pPrev == 0) || ((pBatch->pnKey[i] ^ pBatch->pnKey[i - 1]) & CAT_SPRITEBATCH_KEY_STATE_MASK)
+			|| (pSprite->nFixA != pPrev->nFixA) || (pSprite->nFixB != pPrev->nFixB);
+		Vertex* pDest;
+
+		if(fState || (i - nChunk == CAT_SPRITEBATCH_CHUNK)) {
+			// 設定が変わったか頂点を使い切ったので、ここまでを描画する
+			// レイヤーだけが変わった時は、続けて描画できる
+			if(i > nStart) {
+				Cat_RenderDrawArray( GU_SPRITES, nVertexType, (i - nStart) * 2, 0, &pVertex[(nStart - nChunk) * 2] );
+				rc++;
+			}
+			nStart = i;
+			if(fState) {
+				SetBlend( pSprite->nBlend, pSprite->nFixA, pSprite->nFixB, &fAlphaTest );
+				Cat_TextureSetTexturePalette( pSprite->pTexture, pSprite->pPalette );
+				pBatch->statistics.nStateCount++;
+			}
+			if((pVertex == 0) || (i - nChunk == CAT_SPRITEBATCH_CHUNK)) {
+				const uint32_t nCount = (pBatch->nUsed - i < CAT_SPRITEBATCH_CHUNK) ? pBatch->nUsed - i : CAT_SPRITEBATCH_CHUNK;
+				pVertex = (Vertex*)Cat_RenderGetMemory( sizeof(Vertex) * 2 * nCount );
+				nChunk = i;
+				if(pVertex == 0) {
+					// 描画パケットに空きが無いので、残りは描画しない
+					pBatch->statistics.nDropCount += pBatch->nUsed - i;
+					break;
+				}
+			}
+		}
+		pDest = &pVertex[(i - nChunk) * 2];
+		pDest[0].u = pSprite->u0;
+		pDest[0].v = pSprite->v0;
+		pDest[0].x = pSprite->x0;
+		pDest[0].y = pSprite->y0;
+		pDest[0].z = 0;
+		pDest[1].u = pSprite->u1;
+		pDest[1].v = pSprite->v1;
+		pDest[1].x = pSprite->x1;
+		pDest[1].y = pSprite->y1;
+		pDest[1].z = 0;
+	}
+	if(pVertex && (i > nStart)) {
+		Cat_RenderDrawArray( GU_SPRITES, nVertexType, (i - nStart) * 2, 0, &pVertex[(nStart - nChunk) * 2] );
+		rc++;
+	}
+	SetBlend( CAT_SPRITEBATCH_BLEND_ALPHA, 0, 0, &fAlphaTest );
+
+	pBatch->statistics.nSpriteCount += i;
+	pBatch->statistics.nBatchCount  += rc;
+	pBatch->statistics.nVertexSize  += sizeof(Vertex) * 2 * i;
+	pBatch->nUsed       = 0;
+	pBatch->nStateCount = 0;
+	pBatch->nStamp++;	// ハッシュ表は、フレームの番号を変えるだけで空になる
+	return rc;
+}
+
+//! 統計情報を取得する
+/*!
+	@param[in]	pBatch			バッチ
+	@param[out]	pStatistics		統計情報
+*/
+void
+Cat_SpriteBatchGetStatistics( Cat_SpriteBatch* pBatch, Cat_SpriteBatchStatistics* pStatistics )
+{
+	if(pStatistics == 0) {
+		return;
+	}
+	if(pBatch == 0) {
+		memset( pStatistics, 0, sizeof(Cat_SpriteBatchStatistics) );
+		return;
+	}
+	*pStatistics = pBatch->statistics;
+}
+
+//! 統計情報をクリアする
+/*!
+	@param[in]	pBatch	バッチ
+*/
+void
+Cat_SpriteBatchResetStatistics( Cat_SpriteBatch* pBatch )
+{
+	if(pBatch) {
+		memset( &pBatch->statistics, 0, sizeof(pBatch->statistics) );
+	}
+}
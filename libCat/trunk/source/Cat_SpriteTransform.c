@@ -0,0 +1,630 @@
+//! @file	Cat_SpriteTransform.c
+// スプライトの頂点をまとめて計算する
+
+// SSE2かNEONが使える環境(ホストでのツールやテスト)では、スプライト1つの4つの角を1つのベクトルで計算する。
+// PSPのVFPU版は実機で確かめるまで、USE_CAT_SPRITETRANSFORM_VFPUを定義してビルドした場合だけ使う
+// (定義しなければ比較用の実装になる)。
+// CAT_SPRITETRANSFORM_NO_SIMDを定義すると、常に1頂点ずつ計算する比較用の実装を使う。
+// どちらも同じ演算を同じ順番で行うので、結果はビット単位で一致する
+// (積和演算にまとめられると丸めが変わるので、-ffp-contract=fastでFMAを使うホストでは一致しない場合がある。
+// VFPUは非正規化数を0として扱うので、角の位置の途中の積が非正規化数になる場合も一致しない)。
+
+#include <pspgu.h>
+#include <pspkernel.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "Cat_SpriteTransform.h"
+#include "Cat_Render.h"
+
+#if !defined(CAT_SPRITETRANSFORM_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define USE_CAT_SPRITETRANSFORM_SSE2
+#elif !defined(CAT_SPRITETRANSFORM_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define USE_CAT_SPRITETRANSFORM_NEON
+#elif defined(CAT_SPRITETRANSFORM_NO_SIMD) || !defined(__psp__)
+#undef USE_CAT_SPRITETRANSFORM_VFPU
+#endif
+
+//! 円周率
+#define CAT_SPRITETRANSFORM_PI (3.14159265358979323846f)
+//! 足すと仮数部の下位が整数に丸めた値になる値(1.5 * 2^23)
+#define CAT_SPRITETRANSFORM_ROUND (12582912.0f)
+//! CAT_SPRITETRANSFORM_ROUNDのビット列
+#define CAT_SPRITETRANSFORM_ROUND_BITS (0x4B400000)
+
+//! 1つのスプライトの計算に使う値
+typedef struct {
+	float	fLeft;			/*!< 軸から左端まで(拡大前)		*/
+	float	fRight;			/*!< 軸から右端まで				*/
+	float	fTop;			/*!< 軸から上端まで				*/
+	float	fBottom;		/*!< 軸から下端まで				*/
+	float	fScaleX;		/*!< 横の拡大率(反転を含む)		*/
+	float	fScaleY;		/*!< 縦の拡大率(反転を含む)		*/
+	float	fSin;			/*!< 回転角度のsin				*/
+	float	fCos;			/*!< 回転角度のcos				*/
+} Setup;
+
+//! 前に計算した回転角度
+typedef struct {
+	float	fAngle;			/*!< 回転角度					*/
+	float	fSin;			/*!< sin						*/
+	float	fCos;			/*!< cos						*/
+} Rotation;
+
+#if defined(USE_CAT_SPRITETRANSFORM_VFPU)
+//! VFPUに読み込む値(lv.qで読むので16バイト境界に置く)
+typedef struct {
+	float	afLeft[4];		/*!< 角ごとの軸から横の端まで(左上、右上、左下、右下)	*/
+	float	afTop[4];		/*!< 角ごとの軸から縦の端まで							*/
+	float	afParam[4];		/*!< 横の拡大率、縦の拡大率、sin、cos					*/
+	float	afX[4];			/*!< 描画位置X(4つとも同じ値)							*/
+	float	afY[4];			/*!< 描画位置Y(4つとも同じ値)							*/
+} __attribute__((aligned(16))) VfpuInput;
+
+//! VFPUから書き出す値
+typedef struct {
+	float	afX[4];			/*!< 位置X(左上、右上、左下、右下)	*/
+	float	afY[4];			/*!< 位置Y							*/
+} __attribute__((aligned(16))) VfpuOutput;
+#endif
+
+//! インデックス(GEが読むので、書いた後でキャッシュを書き戻す)
+static uint16_t gnIndex[CAT_SPRITETRANSFORM_CHUNK * 6] __attribute__((aligned(64)));
+//! インデックスを作ったかどうか
+static int gfIndex = 0;
+
+//! 計算に使う値を求める
+/*!
+	sinとcosは重いので、回転しない場合と、前と同じ角度の場合は計算しない。
+	@param[in]		pInstance	スプライト
+	@param[in,out]	pRotation	前に計算した回転角度
+	@param[out]		pSetup		計算に使う値
+*/
+static inline void
+GetSetup( const Cat_SpriteInstance* pInstance, Rotation* pRotation, Setup* pSetup )
+{
+	pSetup->fLeft   = -pInstance->fAxisX;
+	pSetup->fRight  = (float)pInstance->nWidth - pInstance->fAxisX;
+	pSetup->fTop    = -pInstance->fAxisY;
+	pSetup->fBottom = (float)pInstance->nHeight - pInstance->fAxisY;
+	pSetup->fScaleX = (pInstance->nFlags & CAT_SPRITETRANSFORM_FLIP_X) ? -pInstance->fScaleX : pInstance->fScaleX;
+	pSetup->fScaleY = (pInstance->nFlags & CAT_SPRITETRANSFORM_FLIP_Y) ? -pInstance->fScaleY : pInstance->fScaleY;
+	if(pInstance->fAngle == 0.0f) {
+		pSetup->fSin = 0.0f;
+		pSetup->fCos = 1.0f;
+		return;
+	}
+	if(pInstance->fAngle != pRotation->fAngle) {
+		const float fRadian = pInstance->fAngle * (CAT_SPRITETRANSFORM_PI / 180.0f);
+		pRotation->fAngle = pInstance->fAngle;
+		pRotation->fSin   = sinf( fRadian );
+		pRotation->fCos   = cosf( fRadian );
+	}
+	pSetup->fSin = pRotation->fSin;
+	pSetup->fCos = pRotation->fCos;
+}
+
+//! 最も近い整数に丸める
+/*!
+	@param[in]	f	値(-2^22～2^22)
+	@return	丸めた値
+*/
+static int16_t
+RoundReference( float f )
+{
+	union {
+		float	f;
+		int32_t	n;
+	} t;
+
+	t.f = f + CAT_SPRITETRANSFORM_ROUND;
+	return (int16_t)(t.n - CAT_SPRITETRANSFORM_ROUND_BITS);
+}
+
+#if defined(USE_CAT_SPRITETRANSFORM_SSE2)
+//! 4つの角の位置を計算する(SSE2版)
+/*!
+	TransformCornerReference()を4つの角についてまとめて行う。
+	@param[in]	pInstance	スプライト
+	@param[in]	pSetup		計算に使う値
+	@param[out]	pX			位置X(左上、右上、左下、右下)
+	@param[out]	pY			位置Y
+*/
+static inline void
+TransformCornerSSE2( const Cat_SpriteInstance* pInstance, const Setup* pSetup, __m128* pX, __m128* pY )
+{
+	const __m128 vSin = _mm_set1_ps( pSetup->fSin );
+	const __m128 vCos = _mm_set1_ps( pSetup->fCos );
+	const __m128 vLX  = _mm_mul_ps( _mm_setr_ps( pSetup->fLeft, pSetup->fRight, pSetup->fLeft, pSetup->fRight ), _mm_set1_ps( pSetup->fScaleX ) );
+	const __m128 vLY  = _mm_mul_ps( _mm_setr_ps( pSetup->fTop, pSetup->fTop, pSetup->fBottom, pSetup->fBottom ), _mm_set1_ps( pSetup->fScaleY ) );
+
+	*pX = _mm_add_ps( _mm_set1_ps( pInstance->x ), _mm_add_ps( _mm_mul_ps( vLX, vCos ), _mm_mul_ps( vLY, vSin ) ) );
+	*pY = _mm_add_ps( _mm_set1_ps( pInstance->y ), _mm_sub_ps( _mm_mul_ps( vLY, vCos ), _mm_mul_ps( vLX, vSin ) ) );
+}
+
+//! 頂点をまとめて計算する(16bit、SSE2版)
+/*!
+	足した結果のビット列から引けば、floatから整数への変換を使わずに丸めた値になる。
+	@param[in]	pInstance	スプライト
+	@param[in]	nCount		スプライト数
+	@param[out]	pVertex		頂点(nCount * 4個)
+*/
+static void
+Transform16SSE2( const Cat_SpriteInstance* pInstance, uint32_t nCount, Cat_SpriteVertex16* pVertex )
+{
+	const __m128 vRound      = _mm_set1_ps( CAT_SPRITETRANSFORM_ROUND );
+	const __m128i vRoundBits = _mm_set1_epi32( CAT_SPRITETRANSFORM_ROUND_BITS );
+	Rotation rotation = { 0.0f, 0.0f, 1.0f };
+	int32_t anX[4];
+	int32_t anY[4];
+	uint32_t i;
+	uint32_t j;
+
+	for(i = 0; i < nCount; i++, pInstance++, pVertex += 4) {
+		const int16_t u0 = pInstance->u;
+		const int16_t v0 = pInstance->v;
+		const int16_t u1 = (int16_t)(pInstance->u + pInstance->nWidth);
+		const int16_t v1 = (int16_t)(pInstance->v + pInstance->nHeight);
+		__m128 x;
+		__m128 y;
+		Setup setup;
+
+		GetSetup( pInstance, &rotation, &setup );
+		TransformCornerSSE2( pInstance, &setup, &x, &y );
+		_mm_storeu_si128( (__m128i*)anX, _mm_sub_epi32( _mm_castps_si128( _mm_add_ps( x, vRound ) ), vRoundBits ) );
+		_mm_storeu_si128( (__m128i*)anY, _mm_sub_epi32( _mm_castps_si128( _mm_add_ps( y, vRound ) ), vRoundBits ) );
+		for(j = 0; j < 4; j++) {
+			pVertex[j].u = (j & 1) ? u1 : u0;
+			pVertex[j].v = (j & 2) ? v1 : v0;
+			pVertex[j].x = (int16_t)anX[j];
+			pVertex[j].y = (int16_t)anY[j];
+			pVertex[j].z = 0;
+		}
+	}
+}
+
+//! 頂点をまとめて計算する(float、SSE2版)
+/*!
+	@param[in]	pInstance	スプライト
+	@param[in]	nCount		スプライト数
+	@param[out]	pVertex		頂点(nCount * 4個)
+*/
+static void
+TransformFloatSSE2( const Cat_SpriteInstance* pInstance, uint32_t nCount, Cat_SpriteVertexFloat* pVertex )
+{
+	Rotation rotation = { 0.0f, 0.0f, 1.0f };
+	float afX[4];
+	float afY[4];
+	uint32_t i;
+	uint32_t j;
+
+	for(i = 0; i < nCount; i++, pInstance++, pVertex += 4) {
+		const float u0 = (float)pInstance->u;
+		const float v0 = (float)pInstance->v;
+		const float u1 = (float)(pInstance->u + pInstance->nWidth);
+		const float v1 = (float)(pInstance->v + pInstance->nHeight);
+		__m128 x;
+		__m128 y;
+		Setup setup;
+
+		GetSetup( pInstance, &rotation, &setup );
+		TransformCornerSSE2( pInstance, &setup, &x, &y );
+		_mm_storeu_ps( afX, x );
+		_mm_storeu_ps( afY, y );
+		for(j = 0; j < 4; j++) {
+			pVertex[j].u = (j & 1) ? u1 : u0;
+			pVertex[j].v = (j & 2) ? v1 : v0;
+			pVertex[j].x = afX[j];
+			pVertex[j].y = afY[j];
+			pVertex[j].z = 0.0f;
+		}
+	}
+}
+#elif defined(USE_CAT_SPRITETRANSFORM_NEON)
+//! 4つの角の位置を計算する(NEON版)
+/*!
+	TransformCornerReference()を4つの角についてまとめて行う。 \n
+	丸めを合わせるため、積和命令(vmlaq_f32)は使わない。
+	@param[in]	pInstance	スプライト
+	@param[in]	pSetup		計算に使う値
+	@param[out]	pX			位置X(左上、右上、左下、右下)
+	@param[out]	pY			位置Y
+*/
+static inline void
+TransformCornerNEON( const Cat_SpriteInstance* pInstance, const Setup* pSetup, float32x4_t* pX, float32x4_t* pY )
+{
+	const float afLeft[4] = { pSetup->fLeft, pSetup->fRight, pSetup->fLeft, pSetup->fRight };
+	const float afTop[4]  = { pSetup->fTop, pSetup->fTop, pSetup->fBottom, pSetup->fBottom };
+	const float32x4_t vSin = vdupq_n_f32( pSetup->fSin );
+	const float32x4_t vCos = vdupq_n_f32( pSetup->fCos );
+	const float32x4_t vLX  = vmulq_f32( vld1q_f32( afLeft ), vdupq_n_f32( pSetup->fScaleX ) );
+	const float32x4_t vLY  = vmulq_f32( vld1q_f32( afTop ), vdupq_n_f32( pSetup->fScaleY ) );
+
+	*pX = vaddq_f32( vdupq_n_f32( pInstance->x ), vaddq_f32( vmulq_f32( vLX, vCos ), vmulq_f32( vLY, vSin ) ) );
+	*pY = vaddq_f32( vdupq_n_f32( pInstance->y ), vsubq_f32( vmulq_f32( vLY, vCos ), vmulq_f32( vLX, vSin ) ) );
+}
+
+//! 頂点をまとめて計算する(16bit、NEON版)
+/*!
+	足した結果のビット列から引けば、floatから整数への変換を使わずに丸めた値になる。
+	@param[in]	pInstance	スプライト
+	@param[in]	nCount		スプライト数
+	@param[out]	pVertex		頂点(nCount * 4個)
+*/
+static void
+Transform16NEON( const Cat_SpriteInstance* pInstance, uint32_t nCount, Cat_SpriteVertex16* pVertex )
+{
+	const float32x4_t vRound    = vdupq_n_f32( CAT_SPRITETRANSFORM_ROUND );
+	const int32x4_t vRoundBits  = vdupq_n_s32( CAT_SPRITETRANSFORM_ROUND_BITS );
+	Rotation rotation = { 0.0f, 0.0f, 1.0f };
+	int32_t anX[4];
+	int32_t anY[4];
+	uint32_t i;
+	uint32_t j;
+
+	for(i = 0; i < nCount; i++, pInstance++, pVertex += 4) {
+		const int16_t u0 = pInstance->u;
+		const int16_t v0 = pInstance->v;
+		const int16_t u1 = (int16_t)(pInstance->u + pInstance->nWidth);
+		const int16_t v1 = (int16_t)(pInstance->v + pInstance->nHeight);
+		float32x4_t x;
+		float32x4_t y;
+		Setup setup;
+
+		GetSetup( pInstance, &rotation, &setup );
+		TransformCornerNEON( pInstance, &setup, &x, &y );
+		vst1q_s32( anX, vsubq_s32( vreinterpretq_s32_f32( vaddq_f32( x, vRound ) ), vRoundBits ) );
+		vst1q_s32( anY, vsubq_s32( vreinterpretq_s32_f32( vaddq_f32( y, vRound ) ), vRoundBits ) );
+		for(j = 0; j < 4; j++) {
+			pVertex[j].u = (j & 1) ? u1 : u0;
+			pVertex[j].v = (j & 2) ? v1 : v0;
+			pVertex[j].x = (int16_t)anX[j];
+			pVertex[j].y = (int16_t)anY[j];
+			pVertex[j].z = 0;
+		}
+	}
+}
+
+//! 頂点をまとめて計算する(float、NEON版)
+/*!
+	@param[in]	pInstance	スプライト
+	@param[in]	nCount		スプライト数
+	@param[out]	pVertex		頂点(nCount * 4個)
+*/
+static void
+TransformFloatNEON( const Cat_SpriteInstance* pInstance, uint32_t nCount, Cat_SpriteVertexFloat* pVertex )
+{
+	Rotation rotation = { 0.0f, 0.0f, 1.0f };
+	float afX[4];
+	float afY[4];
+	uint32_t i;
+	uint32_t j;
+
+	for(i = 0; i < nCount; i++, pInstance++, pVertex += 4) {
+		const float u0 = (float)pInstance->u;
+		const float v0 = (float)pInstance->v;
+		const float u1 = (float)(pInstance->u + pInstance->nWidth);
+		const float v1 = (float)(pInstance->v + pInstance->nHeight);
+		float32x4_t x;
+		float32x4_t y;
+		Setup setup;
+
+		GetSetup( pInstance, &rotation, &setup );
+		TransformCornerNEON( pInstance, &setup, &x, &y );
+		vst1q_f32( afX, x );
+		vst1q_f32( afY, y );
+		for(j = 0; j < 4; j++) {
+			pVertex[j].u = (j & 1) ? u1 : u0;
+			pVertex[j].v = (j & 2) ? v1 : v0;
+			pVertex[j].x = afX[j];
+			pVertex[j].y = afY[j];
+			pVertex[j].z = 0.0f;
+		}
+	}
+}
+#elif defined(USE_CAT_SPRITETRANSFORM_VFPU)
+//! 4つの角の位置を計算する(VFPU版)
+/*!
+	TransformCornerReference()を4つの角についてまとめて行う。 \n
+	丸めを合わせるため、積和になる命令(vdotなど)は使わずに、積と和を分けて計算する。 \n
+	呼び出すスレッドには、PSP_THREAD_ATTR_VFPUが必要。
+	@param[in]	pInstance	スプライト
+	@param[in]	pSetup		計算に使う値
+	@param[out]	pOutput		位置(左上、右上、左下、右下)
+*/
+static inline void
+TransformCornerVFPU( const Cat_SpriteInstance* pInstance, const Setup* pSetup, VfpuOutput* pOutput )
+{
+	VfpuInput input;
+
+	input.afLeft[0]  = pSetup->fLeft;
+	input.afLeft[1]  = pSetup->fRight;
+	input.afLeft[2]  = pSetup->fLeft;
+	input.afLeft[3]  = pSetup->fRight;
+	input.afTop[0]   = pSetup->fTop;
+	input.afTop[1]   = pSetup->fTop;
+	input.afTop[2]   = pSetup->fBottom;
+	input.afTop[3]   = pSetup->fBottom;
+	input.afParam[0] = pSetup->fScaleX;
+	input.afParam[1] = pSetup->fScaleY;
+	input.afParam[2] = pSetup->fSin;
+	input.afParam[3] = pSetup->fCos;
+	input.afX[0] = input.afX[1] = input.afX[2] = input.afX[3] = pInstance->x;
+	input.afY[0] = input.afY[1] = input.afY[2] = input.afY[3] = pInstance->y;
+
+	// S020:横の拡大率 S021:縦の拡大率 S022:sin S023:cos
+	__asm__ volatile (
+		"lv.q    C000,  0(%1)\n"			// C000 = 左右の端
+		"lv.q    C010, 16(%1)\n"			// C010 = 上下の端
+		"lv.q    C020, 32(%1)\n"
+		"lv.q    C030, 48(%1)\n"			// C030 = 描画位置X
+		"lv.q    C200, 64(%1)\n"			// C200 = 描画位置Y
+		"vscl.q  C000, C000, S020\n"		// lx = 端 * 横の拡大率
+		"vscl.q  C010, C010, S021\n"		// ly = 端 * 縦の拡大率
+		"vscl.q  C100, C000, S023\n"		// lx * cos
+		"vscl.q  C110, C010, S022\n"		// ly * sin
+		"vadd.q  C100, C100, C110\n"
+		"vadd.q  C100, C030, C100\n"		// X = x + (lx * cos + ly * sin)
+		"vscl.q  C120, C010, S023\n"		// ly * cos
+		"vscl.q  C130, C000, S022\n"		// lx * sin
+		"vsub.q  C120, C120, C130\n"
+		"vadd.q  C120, C200, C120\n"		// Y = y + (ly * cos - lx * sin)
+		"sv.q    C100,  0(%0)\n"
+		"sv.q    C120, 16(%0)\n"
+		:
+		: "r"( pOutput ), "r"( &input )
+		: "memory" );
+}
+
+//! 頂点をまとめて計算する(16bit、VFPU版)
+/*!
+	丸めは比較用の実装と同じく、足した結果のビット列から引いて求める。
+	@param[in]	pInstance	スプライト
+	@param[in]	nCount		スプライト数
+	@param[out]	pVertex		頂点(nCount * 4個)
+*/
+static void
+Transform16VFPU( const Cat_SpriteInstance* pInstance, uint32_t nCount, Cat_SpriteVertex16* pVertex )
+{
+	Rotation rotation = { 0.0f, 0.0f, 1.0f };
+	VfpuOutput output;
+	uint32_t i;
+	uint32_t j;
+
+	for(i = 0; i < nCount; i++, pInstance++, pVertex += 4) {
+		const int16_t u0 = pInstance->u;
+		const int16_t v0 = pInstance->v;
+		const int16_t u1 = (int16_t)(pInstance->u + pInstance->nWidth);
+		const int16_t v1 = (int16_t)(pInstance->v + pInstance->nHeight);
+		Setup setup;
+
+		GetSetup( pInstance, &rotation, &setup );
+		TransformCornerVFPU( pInstance, &setup, &output );
+		for(j = 0; j < 4; j++) {
+			pVertex[j].u = (j & 1) ? u1 : u0;
+			pVertex[j].v = (j & 2) ? v1 : v0;
+			pVertex[j].x = RoundReference( output.afX[j] );
+			pVertex[j].y = RoundReference( output.afY[j] );
+			pVertex[j].z = 0;
+		}
+	}
+}
+
+//! 頂点をまとめて計算する(float、VFPU版)
+/*!
+	@param[in]	pInstance	スプライト
+	@param[in]	nCount		スプライト数
+	@param[out]	pVertex		頂点(nCount * 4個)
+*/
+static void
+TransformFloatVFPU( const Cat_SpriteInstance* pInstance, uint32_t nCount, Cat_SpriteVertexFloat* pVertex )
+{
+	Rotation rotation = { 0.0f, 0.0f, 1.0f };
+	VfpuOutput output;
+	uint32_t i;
+	uint32_t j;
+
+	for(i = 0; i < nCount; i++, pInstance++, pVertex += 4) {
+		const float u0 = (float)pInstance->u;
+		const float v0 = (float)pInstance->v;
+		const float u1 = (float)(pInstance->u + pInstance->nWidth);
+		const float v1 = (float)(pInstance->v + pInstance->nHeight);
+		Setup setup;
+
+		GetSetup( pInstance, &rotation, &setup );
+		TransformCornerVFPU( pInstance, &setup, &output );
+		for(j = 0; j < 4; j++) {
+			pVertex[j].u = (j & 1) ? u1 : u0;
+			pVertex[j].v = (j & 2) ? v1 : v0;
+			pVertex[j].x = output.afX[j];
+			pVertex[j].y = output.afY[j];
+			pVertex[j].z = 0.0f;
+		}
+	}
+}
+#endif
+
+//! 頂点をまとめて計算する(16bit)
+/*!
+	1つのスプライトにつき、左上、右上、左下、右下(切り出した範囲での位置)の4頂点を書き出す。 \n
+	位置は最も近い整数に丸める(ちょうど半分の場合は偶数)。 \n
+	ホストではSSE2かNEON、PSPではUSE_CAT_SPRITETRANSFORM_VFPUを定義した場合だけVFPUで4つの角をまとめて計算する。 \n
+	結果は比較用の実装と同じになる。
+	@param[in]	pInstance	スプライト
+	@param[in]	nCount		スプライト数
+	@param[out]	pVertex		頂点(nCount * 4個)
+*/
+void
+Cat_SpriteTransform16( const Cat_SpriteInstance* pInstance, uint32_t nCount, Cat_SpriteVertex16* pVertex )
+{
+#if defined(USE_CAT_SPRITETRANSFORM_SSE2)
+	Transform16SSE2( pInstance, nCount, pVertex );
+#elif defined(USE_CAT_SPRITETRANSFORM_NEON)
+	Transform16NEON( pInstance, nCount, pVertex );
+#elif defined(USE_CAT_SPRITETRANSFORM_VFPU)
+	Transform16VFPU( pInstance, nCount, pVertex );
+#else
+	Cat_SpriteTransform16Reference( pInstance, nCount, pVertex );
+#endif
+}
+
+//! 頂点をまとめて計算する(float)
+/*!
+	頂点の並びはCat_SpriteTransform16()と同じ。
+	@param[in]	pInstance	スプライト
+	@param[in]	nCount		スプライト数
+	@param[out]	pVertex		頂点(nCount * 4個)
+*/
+void
+Cat_SpriteTransformFloat( const Cat_SpriteInstance* pInstance, uint32_t nCount, Cat_SpriteVertexFloat* pVertex )
+{
+#if defined(USE_CAT_SPRITETRANSFORM_SSE2)
+	TransformFloatSSE2( pInstance, nCount, pVertex );
+#elif defined(USE_CAT_SPRITETRANSFORM_NEON)
+	TransformFloatNEON( pInstance, nCount, pVertex );
+#elif defined(USE_CAT_SPRITETRANSFORM_VFPU)
+	TransformFloatVFPU( pInstance, nCount, pVertex );
+#else
+	Cat_SpriteTransformFloatReference( pInstance, nCount, pVertex );
+#endif
+}
+
+//! 1つの角の位置を計算する
+/*!
+	画面はYが下向きなので、反時計回りに回すと X = x + (lx * cos + ly * sin)、Y = y + (ly * cos - lx * sin) になる。
+	@param[in]	pInstance	スプライト
+	@param[in]	pSetup		計算に使う値
+	@param[in]	nCorner		角(0:左上、1:右上、2:左下、3:右下)
+	@param[out]	pfX			位置X
+	@param[out]	pfY			位置Y
+*/
+static void
+TransformCornerReference( const Cat_SpriteInstance* pInstance, const Setup* pSetup, uint32_t nCorner, float* pfX, float* pfY )
+{
+	const float lx = ((nCorner & 1) ? pSetup->fRight : pSetup->fLeft) * pSetup->fScaleX;
+	const float ly = ((nCorner & 2) ? pSetup->fBottom : pSetup->fTop) * pSetup->fScaleY;
+
+	*pfX = pInstance->x + (lx * pSetup->fCos + ly * pSetup->fSin);
+	*pfY = pInstance->y + (ly * pSetup->fCos - lx * pSetup->fSin);
+}
+
+//! 頂点を1つずつ計算する(16bit)
+/*!
+	Cat_SpriteTransform16()と同じ結果になる、比較用の実装。
+	@param[in]	pInstance	スプライト
+	@param[in]	nCount		スプライト数
+	@param[out]	pVertex		頂点(nCount * 4個)
+*/
+void
+Cat_SpriteTransform16Reference( const Cat_SpriteInstance* pInstance, uint32_t nCount, Cat_SpriteVertex16* pVertex )
+{
+	Rotation rotation = { 0.0f, 0.0f, 1.0f };
+	uint32_t i;
+	uint32_t j;
+
+	for(i = 0; i < nCount; i++, pInstance++) {
+		Setup setup;
+
+		GetSetup( pInstance, &rotation, &setup );
+		for(j = 0; j < 4; j++, pVertex++) {
+			float x;
+			float y;
+			TransformCornerReference( pInstance, &setup, j, &x, &y );
+			pVertex->u = (int16_t)(pInstance->u + ((j & 1) ? pInstance->nWidth : 0));
+			pVertex->v = (int16_t)(pInstance->v + ((j & 2) ? pInstance->nHeight : 0));
+			pVertex->x = RoundReference( x );
+			pVertex->y = RoundReference( y );
+			pVertex->z = 0;
+		}
+	}
+}
+
+//! 頂点を1つずつ計算する(float)
+/*!
+	Cat_SpriteTransformFloat()と同じ結果になる、比較用の実装。
+	@param[in]	pInstance	スプライト
+	@param[in]	nCount		スプライト数
+	@param[out]	pVertex		頂点(nCount * 4個)
+*/
+void
+Cat_SpriteTransformFloatReference( const Cat_SpriteInstance* pInstance, uint32_t nCount, Cat_SpriteVertexFloat* pVertex )
+{
+	Rotation rotation = { 0.0f, 0.0f, 1.0f };
+	uint32_t i;
+	uint32_t j;
+
+	for(i = 0; i < nCount; i++, pInstance++) {
+		Setup setup;
+
+		GetSetup( pInstance, &rotation, &setup );
+		for(j = 0; j < 4; j++, pVertex++) {
+			TransformCornerReference( pInstance, &setup, j, &pVertex->x, &pVertex->y );
+			pVertex->u = (float)(pInstance->u + ((j & 1) ? pInstance->nWidth : 0));
+			pVertex->v = (float)(pInstance->v + ((j & 2) ? pInstance->nHeight : 0));
+			pVertex->z = 0.0f;
+		}
+	}
+}
+
+//! 頂点の並びに合わせたインデックスを作る
+/*!
+	スプライト1つにつき、GU_TRIANGLESの三角形2つ分(6個)のインデックスを書き出す。
+	@param[in]	nCount		スプライト数(16384以下)
+	@param[out]	pnIndex		インデックス(nCount * 6個)
+*/
+void
+Cat_SpriteTransformIndex( uint32_t nCount, uint16_t* pnIndex )
+{
+	uint32_t i;
+
+	for(i = 0; i < nCount; i++, pnIndex += 6) {
+		const uint16_t n = (uint16_t)(i * 4);
+		// 左上、右上、左下と、左下、右上、右下
+		pnIndex[0] = n;
+		pnIndex[1] = n + 1;
+		pnIndex[2] = n + 2;
+		pnIndex[3] = n + 2;
+		pnIndex[4] = n + 1;
+		pnIndex[5] = n + 3;
+	}
+}
+
+//! まとめて描画する
+/*!
+	Cat_RenderBegin()とCat_RenderEnd()の間で呼ぶ。 \n
+	テクスチャとブレンドは設定しないので、先にCat_TextureSetTexturePalette()などで設定しておく。 \n
+	頂点は描画パケットに書き出し、CAT_SPRITETRANSFORM_CHUNK枚ずつGU_TRIANGLESで描画する。
+	@param[in]	pInstance	スプライト
+	@param[in]	nCount		スプライト数
+	@return	描画したスプライト数
+*/
+uint32_t
+Cat_SpriteTransformDraw( const Cat_SpriteInstance* pInstance, uint32_t nCount )
+{
+	const int nVertexType = GU_TEXTURE_16BIT | GU_VERTEX_16BIT | GU_INDEX_16BIT | GU_TRANSFORM_2D;
+	uint32_t rc = 0;
+
+	if(pInstance == 0) {
+		return 0;
+	}
+	if(!gfIndex) {
+		// インデックスは毎回同じなので、一度だけ作る
+		Cat_SpriteTransformIndex( CAT_SPRITETRANSFORM_CHUNK, gnIndex );
+		sceKernelDcacheWritebackRange( gnIndex, sizeof(gnIndex) );
+		gfIndex = 1;
+	}
+	while(rc < nCount) {
+		const uint32_t n = (nCount - rc < CAT_SPRITETRANSFORM_CHUNK) ? nCount - rc : CAT_SPRITETRANSFORM_CHUNK;
+		Cat_SpriteVertex16* pVertex = (Cat_SpriteVertex16*)Cat_RenderGetMemory( sizeof(Cat_SpriteVertex16) * 4 * n );
+		if(pVertex == 0) {
+			// 描画パケットに空きが無いので、残りは描画しない
+			break;
+		}
+		Cat_SpriteTransform16( &pInstance[rc], n, pVertex );
+		Cat_RenderDrawArray( GU_TRIANGLES, nVertexType, n * 6, gnIndex, pVertex );
+		rc += n;
+	}
+	return rc;
+}
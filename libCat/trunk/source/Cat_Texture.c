@@ -3,9 +3,17 @@
 
 #include <pspgu.h>
 #include <psputils.h>
+#include <pspthreadman.h>
 #include <string.h>
+#include <math.h>
 #include <malloc.h>	// for memalign
 #include "Cat_Texture.h"
+#include "Cat_TextureDXT.h"
+#include "Cat_ColorConvert.h"
+#include "Cat_Quantize.h"
+#include "Cat_RenderState.h"
+#include "Cat_Render.h"
+#include "Cat_PaletteEffect.h"
 
 #ifndef CAT_MALLOC
 //! メモリ確保マクロ
@@ -22,13 +30,74 @@
 //! テクスチャのモード入れ替えあり
 #define CAT_TEXMODE_SWAP   (1)
 
+//! ハードウェアで扱えるテクスチャの最大サイズ
+#define CAT_TEXTURE_SIZE_MAX (512)
+//! テクスチャ構造体のチャンクのサイズ
+#define CAT_TEXTURE_SLAB_CHUNK_SIZE (8192)
 
+//! 実スクリーンサイズ 横幅
+#define CAT_SCREEN_WIDTH  (480)
+//! 実スクリーンサイズ 縦幅
+#define CAT_SCREEN_HEIGHT (272)
+
+//! 設定されたパレットから作った4bitパレット
+typedef struct _Cat_TexturePalette4 {
+	struct _Cat_TexturePalette4*	pNext;	/*!< 次の4bitパレット					*/
+	Cat_Palette*	pPalette4;				/*!< 4bitパレット						*/
+	Cat_Palette*	pSource;				/*!< 作成元のパレット(参照を持つ)		*/
+	uint32_t		nSerial;				/*!< 作成時の更新カウンタ				*/
+} Cat_TexturePalette4;
+
+//! テクスチャ作成オプション
+static uint32_t gnOption = CAT_TEXTURE_OPTION_DEFAULT;
+//! テクスチャを置くVRAMの領域管理
+static Cat_Vram* gpVram = 0;
+//! テクスチャ構造体の割り当て
+static Cat_Slab* gpSlab = 0;
+//! ピクセルデータを確保する領域
+static Cat_Arena* gpArena = 0;
+//! 描画に使ったテクスチャを知らせる関数
+static Cat_TextureRecordFunc gpfnRecord = 0;
+//! 知らせる関数に渡す値
+static void* gpvRecordContext = 0;
+//! 変換の画質の下限(PSNR)
+static uint32_t gnQuality = CAT_TEXTURE_QUALITY_DEFAULT;
+//! 16bit変換の統計情報
+static Cat_TextureFormat16Statistics gFormat16Statistics;
+//! 8bit変換の統計情報
+static Cat_TextureQuantizeStatistics gQuantizeStatistics;
+
+//! テクスチャ作成
+static Cat_Texture* TextureCreate( uint32_t nWidth, uint32_t nHeight, uint32_t nPitch, const void* pvImage, uint32_t nSrcPitch, FORMAT_PIXEL ePixelFormat, Cat_Palette* pPalette, uint32_t nOption );
+//! 分割テクスチャ作成
+static Cat_Texture* TextureCreateTile( uint32_t nWidth, uint32_t nHeight, uint32_t nPitch, const void* pvImage, FORMAT_PIXEL ePixelFormat, Cat_Palette* pPalette );
 //! サイズを調整する
 static int32_t ConvertSize( Cat_Texture* pTexture );
 //! テクスチャ内を入れ替えて、高速で描画できるように変換
 static void ConvertImageSwap( Cat_Texture* pTexture );
 //! 使っている色を調べて16色以下なら4bitにする
 static void Convert4( Cat_Texture* pTexture );
+//! DXT圧縮する
+static void ConvertDXT( Cat_Texture* pTexture );
+//! 画質が保てる16bitにする
+static void Convert16( Cat_Texture* pTexture );
+//! 画質が保てる8bitにする
+static void ConvertQuantize( Cat_Texture* pTexture );
+//! 32bitのイメージを画質が保てる8bitのイメージにする
+static int32_t QuantizeImage( const void* pvImage, uint32_t nWidth, uint32_t nHeight, uint32_t nPitch, uint32_t nDestPitch, uint32_t nDestHeight,
+	void** ppvDest, Cat_Palette** ppPalette );
+//! 4bitパレットを元のパレットから再構成する
+static void UpdatePalette4( Cat_Texture* pTexture );
+//! 変換テーブルで16色のパレットを作る
+static int32_t RemapPalette4( const Cat_Texture* pTexture, Cat_Palette** ppDest, const Cat_Palette* pSource );
+//! 設定されたパレットから作った4bitパレットを取得する
+static Cat_Palette* GetListPalette4( Cat_Texture* pTexture, Cat_Palette* pPalette, int fCreate );
+//! 設定されたパレットから作った4bitパレットを全部解放する
+static void FreeListPalette4( Cat_Texture* pTexture );
+//! テクスチャとパレットを設定する
+static void SetTexture( Cat_Texture* pTexture, Cat_Palette* pPalette );
+//! テクスチャを描画する
+static uint32_t TextureDraw( Cat_Texture* pTexture, Cat_PaletteEffectCache* pCache, const Cat_PaletteEffectParam* pParam, float x, float y, float w, float h );
 
 //! 最小の2の乗数に切り上げる
 /*!
@@ -75,6 +144,218 @@ inline uint32_t up2( uint32_t x )
 	return 1024*128;
 }
 
+//! テクスチャ作成オプションを設定する
+/*!
+	以降に作成されるテクスチャに適用される。
+	@param[in]	nOption		CAT_TEXTURE_OPTION_xxxの論理和
+	@see	Cat_TextureGetOption()
+*/
+void
+Cat_TextureSetOption( uint32_t nOption )
+{
+	gnOption = nOption;
+}
+
+//! テクスチャ作成オプションを取得する
+/*!
+	@return	CAT_TEXTURE_OPTION_xxxの論理和
+	@see	Cat_TextureSetOption()
+*/
+uint32_t
+Cat_TextureGetOption( void )
+{
+	return gnOption;
+}
+
+//! 変換の画質の下限を設定する
+/*!
+	CAT_TEXTURE_OPTION_FORMAT16で、元のイメージとの誤差がこれより大きくなる場合は変換しない。
+	@param[in]	nPSNR	PSNR(dB単位)。0の場合は常に変換する。
+	@see	Cat_TextureGetQuality()
+*/
+void
+Cat_TextureSetQuality( uint32_t nPSNR )
+{
+	gnQuality = nPSNR;
+}
+
+//! 変換の画質の下限を取得する
+/*!
+	@return	PSNR(dB単位)
+	@see	Cat_TextureSetQuality()
+*/
+uint32_t
+Cat_TextureGetQuality( void )
+{
+	return gnQuality;
+}
+
+//! 16bit変換の統計情報を取得する
+/*!
+	@param[out]	pStatistics		統計情報
+*/
+void
+Cat_TextureGetFormat16Statistics( Cat_TextureFormat16Statistics* pStatistics )
+{
+	if(pStatistics) {
+		*pStatistics = gFormat16Statistics;
+	}
+}
+
+//! 16bit変換の統計情報をクリアする
+void
+Cat_TextureResetFormat16Statistics( void )
+{
+	memset( &gFormat16Statistics, 0, sizeof(gFormat16Statistics) );
+}
+
+//! 8bit変換の統計情報を取得する
+/*!
+	処理速度は nPixelCount / nTime でメガピクセル毎秒になる。
+	@param[out]	pStatistics		統計情報
+*/
+void
+Cat_TextureGetQuantizeStatistics( Cat_TextureQuantizeStatistics* pStatistics )
+{
+	if(pStatistics) {
+		*pStatistics = gQuantizeStatistics;
+	}
+}
+
+//! 8bit変換の統計情報をクリアする
+void
+Cat_TextureResetQuantizeStatistics( void )
+{
+	memset( &gQuantizeStatistics, 0, sizeof(gQuantizeStatistics) );
+}
+
+//! テクスチャを置くVRAMの領域管理を設定する
+/*!
+	設定されている場合、Cat_TextureSetTexture()で使用回数を数えて、 \n
+	VRAMに置かれているテクスチャはVRAMから読ませる。 \n
+	通常は、Cat_RenderInit()でCAT_RENDER_PARAM_VRAM_TEXTUREを指定すると設定される。
+	@param[in]	pVram	領域管理(0の場合はVRAMを使わない)
+*/
+void
+Cat_TextureSetVram( Cat_Vram* pVram )
+{
+	gpVram = pVram;
+}
+
+//! リストに記録している間に、描画に使ったテクスチャを知らせる関数を設定する
+/*!
+	設定されている間は、テクスチャを設定するたびに \a pfnRecord が呼ばれる。 \n
+	VRAMの配置は後で変わるので、VRAMに置かれているテクスチャもメインメモリのアドレスを積む。 \n
+	Cat_DisplayListが記録する間に使う。
+	@param[in]	pfnRecord	知らせる関数(0の場合は元に戻す)
+	@param[in]	pvContext	\a pfnRecord に渡す値
+*/
+void
+Cat_TextureSetRecordFunc( Cat_TextureRecordFunc pfnRecord, void* pvContext )
+{
+	gpfnRecord       = pfnRecord;
+	gpvRecordContext = pvContext;
+}
+
+//! ピクセルデータを確保する領域を設定する
+/*!
+	設定されている間に作成されたテクスチャは、変換が終わったピクセルデータを \n
+	\a pArena へ移して参照を持つ。パレットも同じ領域から確保される。 \n
+	一緒に読み込んで一緒に捨てるイメージ(キャラクターのSFFなど)を読み込む間だけ設定する。
+	@param[in]	pArena	領域(0の場合はヒープから確保する)
+	@see	Cat_TextureGetArena()
+*/
+void
+Cat_TextureSetArena( Cat_Arena* pArena )
+{
+	gpArena = pArena;
+	Cat_PaletteSetArena( pArena );
+}
+
+//! ピクセルデータを確保する領域を取得する
+/*!
+	@return	領域
+	@see	Cat_TextureSetArena()
+*/
+Cat_Arena*
+Cat_TextureGetArena( void )
+{
+	return gpArena;
+}
+
+//! テクスチャ構造体の割り当ての統計情報を取得する
+/*!
+	分割テクスチャも1つずつ数える。
+	@param[out]	pStatistics		統計情報
+*/
+void
+Cat_TextureGetSlabStatistics( Cat_SlabStatistics* pStatistics )
+{
+	Cat_SlabGetStatistics( gpSlab, pStatistics );
+}
+
+//! テクスチャ構造体を確保する
+/*!
+	@return	確保した構造体(0で初期化済み)。失敗した場合は0が返る。
+*/
+static Cat_Texture*
+AllocTexture( void )
+{
+	Cat_Texture* rc;
+
+	if(gpSlab == 0) {
+		// 最初に作る時に用意する
+		gpSlab = Cat_SlabCreate( sizeof(Cat_Texture), CAT_TEXTURE_SLAB_CHUNK_SIZE );
+	}
+	rc = (Cat_Texture*)Cat_SlabAlloc( gpSlab );
+	if(rc) {
+		memset( rc, 0, sizeof(Cat_Texture) );
+	}
+	return rc;
+}
+
+//! ピクセルデータを解放する
+/*!
+	@param[in,out]	pTexture	テクスチャ
+*/
+static void
+FreeData( Cat_Texture* pTexture )
+{
+	if(pTexture->pArena) {
+		Cat_ArenaFree( pTexture->pArena, pTexture->pvData );
+		Cat_ArenaRelease( pTexture->pArena );
+		pTexture->pArena = 0;
+	} else if(pTexture->pvData) {
+		CAT_FREE( pTexture->pvData );
+	}
+	pTexture->pvData = 0;
+}
+
+//! 変換が終わったピクセルデータを領域へ移す
+/*!
+	変換の途中では何度も確保し直すので、最後の大きさが決まってから移す。
+	@param[in,out]	pTexture	テクスチャ
+*/
+static void
+MoveToArena( Cat_Texture* pTexture )
+{
+	const uint32_t nSize = pTexture->nHeight * pTexture->nPitch;
+	void* pvData;
+
+	if((gpArena == 0) || (pTexture->pvData == 0) || (pTexture->pArena != 0)) {
+		return;
+	}
+	pvData = Cat_ArenaAlloc( gpArena, nSize );
+	if(pvData == 0) {
+		return;		// ヒープのまま使う
+	}
+	memcpy( pvData, pTexture->pvData, nSize );
+	CAT_FREE( pTexture->pvData );
+	pTexture->pvData = pvData;
+	pTexture->pArena = gpArena;
+	Cat_ArenaAddRef( gpArena );
+}
+
 //! テクスチャ作成
 /*!
 	\a pvImage は、mallocで確保したメモリを渡すこと。 \n
@@ -90,10 +371,59 @@ inline uint32_t up2( uint32_t x )
 */
 Cat_Texture*
 Cat_TextureCreate( uint32_t nWidth, uint32_t nHeight, uint32_t nPitch, void* pvImage, FORMAT_PIXEL ePixelFormat, Cat_Palette* pPalette )
+{
+	if((gnOption & CAT_TEXTURE_OPTION_TILE) && !Cat_TextureDXTIsFormat( ePixelFormat )
+		&& ((nWidth > CAT_TEXTURE_SIZE_MAX) || (nHeight > CAT_TEXTURE_SIZE_MAX))) {
+		// 縮小せずに分割する
+		return TextureCreateTile( nWidth, nHeight, nPitch, pvImage, ePixelFormat, pPalette );
+	}
+	return TextureCreate( nWidth, nHeight, nPitch, pvImage, nPitch, ePixelFormat, pPalette, gnOption );
+}
+
+//! 1ピクセルのビット数を取得する
+/*!
+	@param[in]	ePixelFormat	ピクセルフォーマット
+	@return	1ピクセルのビット数
+*/
+static uint32_t
+GetPixelBits( FORMAT_PIXEL ePixelFormat )
+{
+	switch(ePixelFormat) {
+		case FORMAT_PIXEL_8888:
+			return 32;
+		case FORMAT_PIXEL_5650:
+		case FORMAT_PIXEL_5551:
+		case FORMAT_PIXEL_4444:
+			return 16;
+		case FORMAT_PIXEL_CLUT4:
+		case FORMAT_PIXEL_DXT1:
+			return 4;
+		case FORMAT_PIXEL_CLUT8:
+		case FORMAT_PIXEL_DXT3:
+		case FORMAT_PIXEL_DXT5:
+		default:
+			return 8;
+	}
+}
+
+//! テクスチャ作成
+/*!
+	@param[in]	nWidth			テクスチャの横幅(ピクセル単位)
+	@param[in]	nHeight			テクスチャの高さ(ピクセル単位)
+	@param[in]	nPitch			テクスチャの横幅のピッチ(バイト単位)
+	@param[in]	pvImage			テクスチャのデータ
+	@param[in]	nSrcPitch		\a pvImage の1ラインのバイト数
+	@param[in]	ePixelFormat	ピクセルフォーマット
+	@param[in]	pPalette		パレット
+	@param[in]	nOption			CAT_TEXTURE_OPTION_xxxの論理和
+	@return	作成されたテクスチャ。失敗した場合は0が返る。
+*/
+static Cat_Texture*
+TextureCreate( uint32_t nWidth, uint32_t nHeight, uint32_t nPitch, const void* pvImage, uint32_t nSrcPitch, FORMAT_PIXEL ePixelFormat, Cat_Palette* pPalette, uint32_t nOption )
 {
 	Cat_Texture* rc;
 
-	rc = CAT_MALLOC( sizeof(Cat_Texture) );
+	rc = AllocTexture();
 	if(rc) {
 		uint32_t i;
 		rc->ePixelFormat = ePixelFormat;
@@ -105,7 +435,14 @@ Cat_TextureCreate( uint32_t nWidth, uint32_t nHeight, uint32_t nPitch, void* pvI
 		rc->nWidth2         = up2( nWidth );
 		rc->pPalette        = pPalette;
 		rc->pPalette4       = 0;
+		rc->pPalette4Source = 0;
+		rc->nPalette4Serial = 0;
+		rc->nSavedSize      = 0;
+		rc->nTileCountX     = 0;
+		rc->nTileCountY     = 0;
+		rc->ppTile          = 0;
 		rc->nTexMode        = CAT_TEXMODE_NORMAL;
+		Cat_VramResourceInit( &rc->vram, 0, 0 );
 		rc->nRefCounter     = 1;
 		if(rc->pPalette) {
 			rc->pPalette->nRef++;
@@ -122,8 +459,15 @@ Cat_TextureCreate( uint32_t nWidth, uint32_t nHeight, uint32_t nPitch, void* pvI
 			return 0;
 		}
 		memset( rc->pvData, 0, rc->nPitch * rc->nHeight );
-		for(i = 0; i < nHeight; i++) {
-			memcpy( (uint8_t*)rc->pvData + rc->nPitch * i, (uint8_t*)pvImage + nPitch * i, nPitch );
+		if(Cat_TextureDXTIsFormat( ePixelFormat )) {
+			// DXTは4ラインで1ブロック列
+			for(i = 0; i < nHeight; i += 4) {
+				memcpy( (uint8_t*)rc->pvData + rc->nPitch * i, (const uint8_t*)pvImage + nSrcPitch * i, nPitch * 4 );
+			}
+		} else {
+			for(i = 0; i < nHeight; i++) {
+				memcpy( (uint8_t*)rc->pvData + rc->nPitch * i, (const uint8_t*)pvImage + nSrcPitch * i, nPitch );
+			}
 		}
 
 		// テクスチャサイズが大きかったら小さくする
@@ -135,10 +479,25 @@ Cat_TextureCreate( uint32_t nWidth, uint32_t nHeight, uint32_t nPitch, void* pvI
 			}
 		}
 
-#if 0
-		// 使っている色を調べて16色以下なら4bitにする
-		Convert4( rc );
-#endif
+		if(nOption & CAT_TEXTURE_OPTION_QUANTIZE) {
+			// 32bitのテクスチャは、画質が保てるなら8bitにする
+			ConvertQuantize( rc );
+		}
+
+		if(nOption & CAT_TEXTURE_OPTION_CLUT4) {
+			// 使っている色を調べて16色以下なら4bitにする
+			Convert4( rc );
+		}
+
+		if(nOption & CAT_TEXTURE_OPTION_DXT) {
+			// 32bitのテクスチャはDXT圧縮する
+			ConvertDXT( rc );
+		}
+
+		if(nOption & CAT_TEXTURE_OPTION_FORMAT16) {
+			// 残った32bitのテクスチャは、画質が保てるなら16bitにする
+			Convert16( rc );
+		}
 
 		// テクスチャスケーリング
 		rc->fScaleWidth  = (float)rc->nWidth  / (float)rc->nWidth2;
@@ -154,23 +513,180 @@ Cat_TextureCreate( uint32_t nWidth, uint32_t nHeight, uint32_t nPitch, void* pvI
 				rc->nWidth16 = rc->nPitch / 2;
 				break;
 			case FORMAT_PIXEL_CLUT8:
+			case FORMAT_PIXEL_DXT3:
+			case FORMAT_PIXEL_DXT5:
 			default:
 				rc->nWidth16 = rc->nPitch;
 				break;
 			case FORMAT_PIXEL_CLUT4:
+			case FORMAT_PIXEL_DXT1:
 				rc->nWidth16 = rc->nPitch * 2;
 				break;
 		}
 		// イメージスワップ
 		ConvertImageSwap( rc );
 
+		// 一緒に捨てるテクスチャは、まとめた領域に置く
+		MoveToArena( rc );
+
 		// キャッシュを吐き出して、イメージデータ部分のキャッシュを無効に
 		// テクスチャは、基本的に作ったら変更しないので
 		sceKernelDcacheWritebackInvalidateRange( rc->pvData, rc->nHeight * rc->nPitch );
+
+		// 変換が終わったデータをVRAMに置けるようにする
+		Cat_VramResourceInit( &rc->vram, rc->pvData, rc->nHeight * rc->nPitch );
+	}
+	return rc;
+}
+
+//! 分割テクスチャ作成
+/*!
+	ハードウェアの制限を超える大きさのイメージを、CAT_TEXTURE_TILE_SIZE単位の \n
+	テクスチャに分割する。分割されたテクスチャは、それぞれ個別に入れ替えなどの変換が行われる。 \n
+	パレットは元のテクスチャのものを共有するので、8bitへの変換だけは分割する前にイメージ全体で行う。
+	@param[in]	nWidth			テクスチャの横幅(ピクセル単位)
+	@param[in]	nHeight			テクスチャの高さ(ピクセル単位)
+	@param[in]	nPitch			テクスチャの横幅のピッチ(バイト単位)
+	@param[in]	pvImage			テクスチャのデータ
+	@param[in]	ePixelFormat	ピクセルフォーマット
+	@param[in]	pPalette		パレット
+	@return	作成されたテクスチャ。失敗した場合は0が返る。
+*/
+static Cat_Texture*
+TextureCreateTile( uint32_t nWidth, uint32_t nHeight, uint32_t nPitch, const void* pvImage, FORMAT_PIXEL ePixelFormat, Cat_Palette* pPalette )
+{
+	Cat_Palette* pQuantizePalette = 0;
+	void* pvQuantize = 0;
+	uint32_t nSavedSize = 0;
+	uint32_t nBits;
+	Cat_Texture* rc;
+	uint32_t tx;
+	uint32_t ty;
+
+	rc = AllocTexture();
+	if(rc == 0) {
+		return 0;
+	}
+	if((gnOption & CAT_TEXTURE_OPTION_QUANTIZE) && (ePixelFormat == FORMAT_PIXEL_8888)) {
+		// 分割テクスチャごとに減色するとパレットがばらばらになるので、全体で1つのパレットにする
+		const uint32_t nQuantizePitch = (nWidth + 15) & ~15;	/* 16バイトの倍数に */
+		if(QuantizeImage( pvImage, nWidth, nHeight, nPitch, nQuantizePitch, nHeight, &pvQuantize, &pQuantizePalette ) == 0) {
+			nSavedSize   = nPitch * nHeight - nQuantizePitch * nHeight;
+			gQuantizeStatistics.nSavedSize += nSavedSize;
+			pvImage      = pvQuantize;
+			nPitch       = nQuantizePitch;
+			ePixelFormat = FORMAT_PIXEL_CLUT8;
+			pPalette     = pQuantizePalette;
+		}
+	}
+	nBits = GetPixelBits( ePixelFormat );
+	rc->ePixelFormat    = ePixelFormat;
+	rc->nOriginalWidth  = nWidth;
+	rc->nOriginalHeight = nHeight;
+	rc->nTextureWidth   = nWidth;
+	rc->nTextureHeight  = nHeight;
+	rc->nWidth          = nWidth;
+	rc->nHeight         = nHeight;
+	rc->nWidth2         = up2( nWidth );
+	rc->nHeight2        = up2( nHeight );
+	rc->nRefCounter     = 1;
+	rc->nSavedSize      = nSavedSize;
+	rc->pPalette        = pPalette;
+	if(pQuantizePalette) {
+		pQuantizePalette = 0;	// 作成した時の参照をそのまま渡す
+	} else if(rc->pPalette) {
+		rc->pPalette->nRef++;
+	}
+
+	rc->nTileCountX = (nWidth  + CAT_TEXTURE_TILE_SIZE - 1) / CAT_TEXTURE_TILE_SIZE;
+	rc->nTileCountY = (nHeight + CAT_TEXTURE_TILE_SIZE - 1) / CAT_TEXTURE_TILE_SIZE;
+	rc->ppTile = (Cat_Texture**)CAT_MALLOC( sizeof(Cat_Texture*) * rc->nTileCountX * rc->nTileCountY );
+	if(rc->ppTile == 0) {
+		Cat_TextureRelease( rc );
+		rc = 0;
+		goto cleanup;
+	}
+	memset( rc->ppTile, 0, sizeof(Cat_Texture*) * rc->nTileCountX * rc->nTileCountY );
+
+	for(ty = 0; ty < rc->nTileCountY; ty++) {
+		const uint32_t y = ty * CAT_TEXTURE_TILE_SIZE;
+		const uint32_t h = ((nHeight - y) < CAT_TEXTURE_TILE_SIZE) ? (nHeight - y) : CAT_TEXTURE_TILE_SIZE;
+		for(tx = 0; tx < rc->nTileCountX; tx++) {
+			const uint32_t x = tx * CAT_TEXTURE_TILE_SIZE;
+			const uint32_t w = ((nWidth - x) < CAT_TEXTURE_TILE_SIZE) ? (nWidth - x) : CAT_TEXTURE_TILE_SIZE;
+			const uint32_t nOffset = x * nBits / 8;
+			uint32_t nLine = (w * nBits + 7) / 8;
+			Cat_Texture* pTile;
+			if(nOffset + nLine > nPitch) {
+				nLine = nPitch - nOffset;	// ピッチを超えて読まないように
+			}
+			// 減色は済んでいるか、全体で駄目だったので、分割テクスチャではしない
+			pTile = TextureCreate( w, h, nLine, (const uint8_t*)pvImage + y * nPitch + nOffset, nPitch, ePixelFormat, pPalette,
+				gnOption & ~CAT_TEXTURE_OPTION_QUANTIZE );
+			if(pTile == 0) {
+				// 駄目だった
+				Cat_TextureRelease( rc );
+				rc = 0;
+				goto cleanup;
+			}
+			rc->ppTile[tx + ty * rc->nTileCountX] = pTile;
+			rc->nSavedSize += pTile->nSavedSize;
+		}
+	}
+
+cleanup:
+	if(pvQuantize) {
+		CAT_FREE( pvQuantize );
+	}
+	if(pQuantizePalette) {
+		Cat_PaletteRelease( pQuantizePalette );
 	}
 	return rc;
 }
 
+//! 分割テクスチャのパレットを元のテクスチャに合わせる
+/*!
+	パレットの差し替えは元のテクスチャにだけ行われるので、使う前に合わせておく。
+	@param[in]		pTexture	元のテクスチャ
+	@param[in,out]	pTile		分割テクスチャ
+*/
+static void
+SyncTilePalette( Cat_Texture* pTexture, Cat_Texture* pTile )
+{
+	if(pTile->pPalette != pTexture->pPalette) {
+		Cat_PaletteAddRef( pTexture->pPalette );
+		Cat_PaletteRelease( pTile->pPalette );
+		pTile->pPalette = pTexture->pPalette;
+	}
+}
+
+//! 座標を含む分割テクスチャを取得する
+/*!
+	@param[in]		pTexture	分割されたテクスチャ
+	@param[in,out]	px			x座標。分割テクスチャ内の座標に変換される
+	@param[in,out]	py			y座標。分割テクスチャ内の座標に変換される
+	@return	分割テクスチャ
+*/
+static Cat_Texture*
+GetTile( Cat_Texture* pTexture, uint32_t* px, uint32_t* py )
+{
+	uint32_t tx = *px / CAT_TEXTURE_TILE_SIZE;
+	uint32_t ty = *py / CAT_TEXTURE_TILE_SIZE;
+	Cat_Texture* pTile;
+
+	if(tx >= pTexture->nTileCountX) {
+		tx = pTexture->nTileCountX - 1;
+	}
+	if(ty >= pTexture->nTileCountY) {
+		ty = pTexture->nTileCountY - 1;
+	}
+	*px -= tx * CAT_TEXTURE_TILE_SIZE;
+	*py -= ty * CAT_TEXTURE_TILE_SIZE;
+	pTile = pTexture->ppTile[tx + ty * pTexture->nTileCountX];
+	SyncTilePalette( pTexture, pTile );
+	return pTile;
+}
+
 //! 参照カウンタを加算する
 /*!
 	@param[in]	pTexture	解放するテクスチャ
@@ -185,6 +701,40 @@ Cat_TextureAddRef( Cat_Texture* pTexture )
 	pTexture->nRefCounter++;
 }
 
+//! テクスチャが分割されているかどうか
+/*!
+	分割されたテクスチャは、Cat_TextureSetTexture()では左上の分割テクスチャしか設定されないので、 \n
+	Cat_TextureDraw()で描画すること。
+	@param[in]	pTexture	テクスチャ
+	@return	分割されていれば0以外を返す
+*/
+int32_t
+Cat_TextureIsTiled( Cat_Texture* pTexture )
+{
+	return (pTexture && pTexture->ppTile) ? 1 : 0;
+}
+
+//! 分割テクスチャを取得する
+/*!
+	パレットは元のテクスチャに合わせてから返す。
+	@param[in]	pTexture	分割されたテクスチャ
+	@param[in]	tx			横の番号
+	@param[in]	ty			縦の番号
+	@return	分割テクスチャ。分割されていない場合と、範囲外の場合は0が返る。
+*/
+Cat_Texture*
+Cat_TextureGetTile( Cat_Texture* pTexture, uint32_t tx, uint32_t ty )
+{
+	Cat_Texture* rc;
+
+	if((pTexture == 0) || (pTexture->ppTile == 0) || (tx >= pTexture->nTileCountX) || (ty >= pTexture->nTileCountY)) {
+		return 0;
+	}
+	rc = pTexture->ppTile[tx + ty * pTexture->nTileCountX];
+	SyncTilePalette( pTexture, rc );
+	return rc;
+}
+
 //! テクスチャ解放
 /*!
 	@param[in]	pTexture	解放するテクスチャ
@@ -203,67 +753,588 @@ Cat_TextureRelease( Cat_Texture* pTexture )
 			Cat_PaletteRelease( pTexture->pPalette );
 			pTexture->pPalette = 0;
 		}
-		if(pTexture->pPalette4) {
-			// パレット解放
-			Cat_PaletteRelease( pTexture->pPalette4 );
-			pTexture->pPalette4 = 0;
-		}
-		if(pTexture->pvData) {
-			// イメージ解放
-			CAT_FREE( pTexture->pvData );
-			pTexture->pvData = 0;
-		}
+		// イメージ解放
+		Cat_TextureUnload( pTexture );
 		pTexture->nRefCounter = 0;
-		CAT_FREE( pTexture );
+		Cat_SlabFree( gpSlab, pTexture );
 	} else {
 		pTexture->nRefCounter--;
 	}
 }
 
+//! テクスチャを固定する
+/*!
+	記録したリストのように、後の描画でもピクセルデータのアドレスを参照するものが使う。 \n
+	固定されている間は、参照を持ち、Cat_TextureUnload()でピクセルデータを解放しない。
+	@param[in]	pTexture	テクスチャ
+	@see	Cat_TextureUnpin()
+*/
+void
+Cat_TexturePin( Cat_Texture* pTexture )
+{
+	if(pTexture) {
+		Cat_TextureAddRef( pTexture );
+		pTexture->nPinCount++;
+	}
+}
+
+//! テクスチャの固定を外す
+/*!
+	@param[in]	pTexture	Cat_TexturePin()したテクスチャ
+*/
+void
+Cat_TextureUnpin( Cat_Texture* pTexture )
+{
+	if(pTexture && pTexture->nPinCount) {
+		pTexture->nPinCount--;
+		Cat_TextureRelease( pTexture );
+	}
+}
+
+//! テクスチャが固定されているかどうか
+/*!
+	@param[in]	pTexture	テクスチャ
+	@return	固定されていれば0以外を返す
+*/
+int32_t
+Cat_TextureIsPinned( Cat_Texture* pTexture )
+{
+	return (pTexture && pTexture->nPinCount) ? 1 : 0;
+}
+
+//! ピクセルデータを解放する
+/*!
+	大きさやパレットは残るので、Cat_TextureReload()で元に戻せる。 \n
+	解放されている間は、Cat_TextureSetTexture()でテクスチャが無効になる。 \n
+	描画中のパケットが参照しているテクスチャは解放しないこと。 \n
+	Cat_TexturePin()で固定されている場合は、何もせずに0を返す。
+	@param[in]	pTexture	テクスチャ
+	@return	解放したサイズ(バイト単位)
+	@see	Cat_TextureReload()
+*/
+uint32_t
+Cat_TextureUnload( Cat_Texture* pTexture )
+{
+	uint32_t rc;
+
+	if((pTexture == 0) || pTexture->nPinCount) {
+		return 0;
+	}
+	rc = Cat_TextureGetDataSize( pTexture );
+
+	if(pTexture->pPalette4) {
+		// パレット解放
+		Cat_PaletteRelease( pTexture->pPalette4 );
+		pTexture->pPalette4 = 0;
+	}
+	if(pTexture->pPalette4Source) {
+		// 4bitパレットの作成元を解放
+		Cat_PaletteRelease( pTexture->pPalette4Source );
+		pTexture->pPalette4Source = 0;
+	}
+	pTexture->nPalette4Serial = 0;
+	FreeListPalette4( pTexture );
+	// VRAMから外す
+	Cat_VramResourceRemove( &pTexture->vram );
+	Cat_VramResourceInit( &pTexture->vram, 0, 0 );
+	if(pTexture->pvData) {
+		// イメージ解放
+		FreeData( pTexture );
+	}
+	if(pTexture->ppTile) {
+		// 分割テクスチャ解放
+		uint32_t i;
+		for(i = 0; i < pTexture->nTileCountX * pTexture->nTileCountY; i++) {
+			Cat_TextureRelease( pTexture->ppTile[i] );
+		}
+		CAT_FREE( pTexture->ppTile );
+		pTexture->ppTile = 0;
+	}
+	pTexture->nTileCountX = 0;
+	pTexture->nTileCountY = 0;
+	return rc;
+}
+
+//! ピクセルデータがあるかどうか
+/*!
+	@param[in]	pTexture	テクスチャ
+	@return	ピクセルデータがあれば0以外を返す
+*/
+int32_t
+Cat_TextureIsLoaded( Cat_Texture* pTexture )
+{
+	return pTexture && (pTexture->pvData || pTexture->ppTile);
+}
+
+//! ピクセルデータを入れ直す
+/*!
+	\a pSource のピクセルデータを \a pTexture へ移す。パレットは \a pTexture のものを残す。 \n
+	\a pTexture がパレットを持っていない場合は、 \a pSource のパレット(減色で作られたものなど)を移す。 \n
+	\a pSource は、ピクセルデータを持たないテクスチャになる。 \n
+	\a pTexture がCat_TexturePin()で固定されている場合は失敗する。
+	@param[in,out]	pTexture	入れ直すテクスチャ
+	@param[in,out]	pSource		同じイメージから作り直したテクスチャ
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+	@see	Cat_TextureUnload()
+*/
+int32_t
+Cat_TextureReload( Cat_Texture* pTexture, Cat_Texture* pSource )
+{
+	if((pTexture == 0) || (pSource == 0) || (pTexture == pSource)) {
+		return -1;
+	}
+	if(pTexture->nPinCount) {
+		return -1;	// 固定されているので、ピクセルデータを差し替えられない
+	}
+	if((pTexture->nOriginalWidth != pSource->nOriginalWidth)
+		|| (pTexture->nOriginalHeight != pSource->nOriginalHeight)) {
+		return -1;	// 違うイメージ
+	}
+	Cat_TextureUnload( pTexture );
+	Cat_VramResourceRemove( &pSource->vram );
+
+	// パレット以外を移す
+	pTexture->nTextureWidth   = pSource->nTextureWidth;
+	pTexture->nTextureHeight  = pSource->nTextureHeight;
+	pTexture->nWidth          = pSource->nWidth;
+	pTexture->nHeight         = pSource->nHeight;
+	pTexture->nPitch          = pSource->nPitch;
+	pTexture->ePixelFormat    = pSource->ePixelFormat;
+	pTexture->nTexMode        = pSource->nTexMode;
+	pTexture->nWidth2         = pSource->nWidth2;
+	pTexture->nHeight2        = pSource->nHeight2;
+	pTexture->nWidth16        = pSource->nWidth16;
+	pTexture->pvData          = pSource->pvData;
+	pTexture->pArena          = pSource->pArena;
+	pTexture->fScaleWidth     = pSource->fScaleWidth;
+	pTexture->fScaleHeight    = pSource->fScaleHeight;
+	memcpy( pTexture->tbl4to8, pSource->tbl4to8, sizeof(pTexture->tbl4to8) );
+	pTexture->pPalette4       = pSource->pPalette4;			// 元のパレットと違えば、設定する時に作り直される
+	pTexture->pPalette4Source = pSource->pPalette4Source;
+	pTexture->nPalette4Serial = pSource->nPalette4Serial;
+	pTexture->pPalette4List   = pSource->pPalette4List;		// 変換テーブルと一緒に移す
+	pTexture->nSavedSize      = pSource->nSavedSize;
+	pTexture->nTileCountX     = pSource->nTileCountX;
+	pTexture->nTileCountY     = pSource->nTileCountY;
+	pTexture->ppTile          = pSource->ppTile;
+	Cat_VramResourceInit( &pTexture->vram, pTexture->pvData, pTexture->nHeight * pTexture->nPitch );
+	if(pTexture->pPalette == 0) {
+		pTexture->pPalette = pSource->pPalette;
+		pSource->pPalette  = 0;
+	}
+
+	pSource->pvData          = 0;
+	pSource->pArena          = 0;
+	pSource->pPalette4       = 0;
+	pSource->pPalette4Source = 0;
+	pSource->pPalette4List   = 0;
+	pSource->nTileCountX     = 0;
+	pSource->nTileCountY     = 0;
+	pSource->ppTile          = 0;
+	return 0;
+}
+
 //! テクスチャ設定
 /*!
-	パレットがある場合は、パレットも設定される。
+	パレットがある場合は、パレットも設定される。 \n
+	分割されたテクスチャは、左上の分割テクスチャが設定される。
 	@param[in]	pTexture	設定するテクスチャ
 */
 void
 Cat_TextureSetTexture( Cat_Texture* pTexture )
 {
+	SetTexture( pTexture, 0 );
+}
+
+//! テクスチャと別のパレットを設定する
+/*!
+	@param[in]	pTexture	設定するテクスチャ
+	@param[in]	pPalette	設定するパレット(0の場合はテクスチャのパレット)
+	@see	Cat_TextureGetDrawPalette()
+*/
+void
+Cat_TextureSetTexturePalette( Cat_Texture* pTexture, Cat_Palette* pPalette )
+{
+	// 分割されたテクスチャは、設定される左上の分割テクスチャの変換テーブルを使う
+	Cat_Texture* pTarget = (pTexture && pTexture->ppTile) ? pTexture->ppTile[0] : pTexture;
+
+	SetTexture( pTexture, GetListPalette4( pTarget, pPalette, 1 ) );
+}
+
+//! 描画の時に設定されるパレットを取得する
+/*!
+	4bitに変換されたテクスチャは、元のパレットから再構成した16色のパレットが返る。
+	@param[in]	pTexture	テクスチャ
+	@return	パレット。パレットを持たないテクスチャは0が返る。
+*/
+Cat_Palette*
+Cat_TextureGetDrawPalette( Cat_Texture* pTexture )
+{
+	if((pTexture == 0) || (pTexture->pPalette == 0)) {
+		return 0;
+	}
+	if(pTexture->pPalette4 == 0) {
+		return pTexture->pPalette;
+	}
+	// 8bitから4ビットへ変換されているテクスチャ
+	// 元のパレットが差し替えられたか更新された時だけ再構成する
+	if((pTexture->pPalette4Source != pTexture->pPalette)
+		|| (pTexture->nPalette4Serial != pTexture->pPalette->nSerial)) {
+		UpdatePalette4( pTexture );
+	}
+	return pTexture->pPalette4;
+}
+
+//! 設定されたパレットから作った4bitパレットを作り直す
+/*!
+	@param[in]	pTexture	テクスチャ(分割されたテクスチャは、分割テクスチャ)
+	@param[in]	pPalette	更新したパレット
+*/
+void
+Cat_TextureRefreshPalette( Cat_Texture* pTexture, Cat_Palette* pPalette )
+{
+	GetListPalette4( pTexture, pPalette, 0 );
+}
+
+//! テクスチャとパレットを設定する
+/*!
+	@param[in]	pTexture	設定するテクスチャ
+	@param[in]	pPalette	設定するパレット(0の場合はテクスチャのパレット)。 \n
+							4bitに変換されたテクスチャは、変換後の番号で引く16色のパレットを渡す。
+*/
+static void
+SetTexture( Cat_Texture* pTexture, Cat_Palette* pPalette )
+{
+	if(pTexture && pTexture->ppTile) {
+		// 分割されたテクスチャは、ピクセルデータを持っていないので左上の分割テクスチャにする
+		SyncTilePalette( pTexture, pTexture->ppTile[0] );
+		pTexture = pTexture->ppTile[0];
+	}
 	if(pTexture && pTexture->pvData) {
+		const void* pvData = pTexture->pvData;
+		if(gpfnRecord) {
+			// 記録しているリストに知らせる(VRAMのアドレスは後で変わるので使わない)
+			gpfnRecord( gpvRecordContext, pTexture );
+		} else if(gpVram) {
+			// VRAMに置かれていれば、そちらを使う
+			const void* pvVram = Cat_VramTouch( gpVram, &pTexture->vram );
+			if(pvVram) {
+				pvData = pvVram;
+			}
+		}
+
+		Cat_RenderCount( CAT_RENDER_COUNT_TEXTURE );
+
 		/* テクスチャ有効 */
-		sceGuEnable( GU_TEXTURE_2D );
+		/* 同じアトラスやキャラクターが続く時は、変わった設定だけが積まれる */
+		Cat_RenderStateEnableTexture( 1 );
 
 		/* テクスチャ設定 */
-		sceGuTexMode( (int)pTexture->ePixelFormat, 0, 0, pTexture->nTexMode );
-		sceGuTexImage( 0, pTexture->nWidth2, pTexture->nHeight2, pTexture->nWidth16, pTexture->pvData );
-		sceGuTexFlush();
+		Cat_RenderStateTexMode( (int)pTexture->ePixelFormat, pTexture->nTexMode );
+		Cat_RenderStateTexImage( pTexture->nWidth2, pTexture->nHeight2, pTexture->nWidth16, pvData );
 
 		/* 2の乗数じゃないとき用の処理 */
-		sceGuTexScale( pTexture->fScaleWidth, pTexture->fScaleHeight );
+		Cat_RenderStateTexScale( pTexture->fScaleWidth, pTexture->fScaleHeight );
 		/* sceGuTexOffset( 0.0f, 0.0f ); */
 
 		/* パレット設定 */
-		if(pTexture->pPalette) {
-			if(pTexture->pPalette4) {
-				// 8bitから4ビットへ変換されているテクスチャ
-				// 元のパレットから再構成する
-				int i;
-				if(pTexture->pPalette->ePaletteFormat == FORMAT_PALETTE_8888) {
-					for(i = 0; i < 16; i++) {
-						((uint32_t*)pTexture->pPalette4->pvData)[i] = ((uint32_t*)pTexture->pPalette->pvData)[pTexture->tbl4to8[i]];
-					}
-				} else {
-					for(i = 0; i < 16; i++) {
-						((uint16_t*)pTexture->pPalette4->pvData)[i] = ((uint16_t*)pTexture->pPalette->pvData)[pTexture->tbl4to8[i]];
-					}
-				}
-				Cat_PaletteSetPalette( pTexture->pPalette4 );
-			} else {
-				Cat_PaletteSetPalette( pTexture->pPalette );
+		if(pPalette == 0) {
+			pPalette = Cat_TextureGetDrawPalette( pTexture );
+		}
+		if(pPalette) {
+			Cat_PaletteSetPalette( pPalette );
+		}
+	} else {
+		Cat_RenderStateEnableTexture( 0 );	/* テクスチャ無効 */
+	}
+}
+
+//! スプライトを1枚描画する
+/*!
+	@param[in]	x0	描画位置 左
+	@param[in]	y0	描画位置 上
+	@param[in]	x1	描画位置 右
+	@param[in]	y1	描画位置 下
+	@param[in]	tw	テクスチャの横幅(テクセル単位)
+	@param[in]	th	テクスチャの高さ(テクセル単位)
+	@return	描画したスプライト数(描画パケットに空きが無い場合は0)
+*/
+static uint32_t
+DrawSprite( int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t tw, uint32_t th )
+{
+	struct vertex_format {
+		short	u,v;
+		short	x,y,z;
+	} __attribute__((packed)) * vert = (struct vertex_format*)Cat_RenderGetMemory( 2 * sizeof(struct vertex_format) );
+	if(vert == 0) {
+		return 0;
+	}
+	vert[0].u = 0;
+	vert[0].v = 0;
+	vert[0].x = (short)x0;
+	vert[0].y = (short)y0;
+	vert[0].z = 0;
+	vert[1].u = (short)tw;
+	vert[1].v = (short)th;
+	vert[1].x = (short)x1;
+	vert[1].y = (short)y1;
+	vert[1].z = 0;
+	Cat_RenderDrawArray( GU_SPRITES, GU_TEXTURE_16BIT | GU_VERTEX_16BIT | GU_TRANSFORM_2D, 2, 0, vert );
+	return 1;
+}
+
+//! テクスチャを描画する
+/*!
+	テクスチャを設定して、スプライトとして描画する。 \n
+	分割されたテクスチャは、画面に入る分割テクスチャだけを描画する。
+	@param[in]	pTexture	描画するテクスチャ
+	@param[in]	x			描画位置X(ドット単位)
+	@param[in]	y			描画位置Y(ドット単位)
+	@param[in]	w			描画する横幅(ドット単位)
+	@param[in]	h			描画する高さ(ドット単位)
+	@return	描画したスプライト数
+*/
+uint32_t
+Cat_TextureDraw( Cat_Texture* pTexture, float x, float y, float w, float h )
+{
+	return TextureDraw( pTexture, 0, 0, x, y, w, h );
+}
+
+//! パレットにエフェクトをかけてテクスチャを描画する
+/*!
+	ピクセルデータはそのままで、キャッシュから取得したパレットを設定して描画する。 \n
+	影や残像のために、色を変えたテクスチャを作る必要が無い。 \n
+	パレットを持たないテクスチャは、そのまま描画される。
+	@param[in]	pTexture	描画するテクスチャ
+	@param[in]	pCache		エフェクトをかけたパレットのキャッシュ
+	@param[in]	pParam		パレットエフェクトのパラメータ
+	@param[in]	x			描画位置X(ドット単位)
+	@param[in]	y			描画位置Y(ドット単位)
+	@param[in]	w			描画する横幅(ドット単位)
+	@param[in]	h			描画する高さ(ドット単位)
+	@return	描画したスプライト数
+*/
+uint32_t
+Cat_TextureDrawEffect( Cat_Texture* pTexture, Cat_PaletteEffectCache* pCache, const Cat_PaletteEffectParam* pParam, float x, float y, float w, float h )
+{
+	if((pCache == 0) || (pParam == 0)) {
+		return TextureDraw( pTexture, 0, 0, x, y, w, h );
+	}
+	return TextureDraw( pTexture, pCache, pParam, x, y, w, h );
+}
+
+//! エフェクトをかけたパレットを取得する
+/*!
+	エフェクトは色ごとなので、4bitのパレットにかけても結果は同じになる。
+	@param[in]	pTexture	テクスチャ
+	@param[in]	pCache		エフェクトをかけたパレットのキャッシュ(0の場合は取得しない)
+	@param[in]	pParam		パレットエフェクトのパラメータ
+	@return	パレット。キャッシュが0の場合と、パレットを持たないテクスチャは0が返る。
+*/
+static Cat_Palette*
+GetEffectPalette( Cat_Texture* pTexture, Cat_PaletteEffectCache* pCache, const Cat_PaletteEffectParam* pParam )
+{
+	if((pCache == 0) || (pTexture->pvData == 0)) {
+		return 0;
+	}
+	return Cat_PaletteEffectCacheGet( pCache, Cat_TextureGetDrawPalette( pTexture ), pParam );
+}
+
+//! テクスチャを描画する
+/*!
+	@param[in]	pTexture	描画するテクスチャ
+	@param[in]	pCache		エフェクトをかけたパレットのキャッシュ(0の場合は元のパレット)
+	@param[in]	pParam		パレットエフェクトのパラメータ
+	@param[in]	x			描画位置X(ドット単位)
+	@param[in]	y			描画位置Y(ドット単位)
+	@param[in]	w			描画する横幅(ドット単位)
+	@param[in]	h			描画する高さ(ドット単位)
+	@return	描画したスプライト数
+*/
+static uint32_t
+TextureDraw( Cat_Texture* pTexture, Cat_PaletteEffectCache* pCache, const Cat_PaletteEffectParam* pParam, float x, float y, float w, float h )
+{
+	float sx;
+	float sy;
+	uint32_t tx;
+	uint32_t ty;
+	uint32_t rc = 0;
+
+	if(pTexture == 0) {
+		return 0;
+	}
+	if(pTexture->ppTile == 0) {
+		SetTexture( pTexture, GetEffectPalette( pTexture, pCache, pParam ) );
+		return DrawSprite( (int32_t)x, (int32_t)y, (int32_t)(x + w), (int32_t)(y + h), pTexture->nTextureWidth, pTexture->nTextureHeight );
+	}
+
+	// 分割テクスチャの境目は、隣同士で同じ計算をして隙間ができないようにする
+	sx = w / (float)pTexture->nTextureWidth;
+	sy = h / (float)pTexture->nTextureHeight;
+	for(ty = 0; ty < pTexture->nTileCountY; ty++) {
+		const int32_t y0 = (int32_t)(y + (float)(ty * CAT_TEXTURE_TILE_SIZE) * sy);
+		const int32_t y1 = (int32_t)(y + (float)(ty * CAT_TEXTURE_TILE_SIZE + pTexture->ppTile[ty * pTexture->nTileCountX]->nTextureHeight) * sy);
+		// 反転して描く場合(高さが負)は、y1の方が上になる
+		if((((y0 < y1) ? y1 : y0) <= 0) || (((y0 < y1) ? y0 : y1) >= CAT_SCREEN_HEIGHT)) {
+			continue;	// 画面外
+		}
+		for(tx = 0; tx < pTexture->nTileCountX; tx++) {
+			Cat_Texture* pTile = pTexture->ppTile[tx + ty * pTexture->nTileCountX];
+			const int32_t x0 = (int32_t)(x + (float)(tx * CAT_TEXTURE_TILE_SIZE) * sx);
+			const int32_t x1 = (int32_t)(x + (float)(tx * CAT_TEXTURE_TILE_SIZE + pTile->nTextureWidth) * sx);
+			if((((x0 < x1) ? x1 : x0) <= 0) || (((x0 < x1) ? x0 : x1) >= CAT_SCREEN_WIDTH)) {
+				continue;	// 画面外
 			}
+			SyncTilePalette( pTexture, pTile );
+			SetTexture( pTile, GetEffectPalette( pTile, pCache, pParam ) );
+			rc += DrawSprite( x0, y0, x1, y1, pTile->nTextureWidth, pTile->nTextureHeight );
+		}
+	}
+	return rc;
+}
+
+//! 4bitパレットを元のパレットから再構成する
+/*!
+	作成元のパレットは参照を保持しておき、同じアドレスに別のパレットが \n
+	作成されても取り違えないようにしている。
+	@param[in,out]	pTexture	テクスチャ
+*/
+static void
+UpdatePalette4( Cat_Texture* pTexture )
+{
+	Cat_Palette* pSource = pTexture->pPalette;
+
+	if(RemapPalette4( pTexture, &pTexture->pPalette4, pSource ) < 0) {
+		return;	// 駄目だったので前のパレットのまま
+	}
+	if(pTexture->pPalette4Source != pSource) {
+		Cat_PaletteAddRef( pSource );
+		Cat_PaletteRelease( pTexture->pPalette4Source );
+		pTexture->pPalette4Source = pSource;
+	}
+	pTexture->nPalette4Serial = pSource->nSerial;
+}
+
+//! 変換テーブルで16色のパレットを作る
+/*!
+	@param[in]		pTexture	4bitに変換されたテクスチャ
+	@param[in,out]	ppDest		作るパレット(0か、フォーマットが違う場合は作成し直す)
+	@param[in]		pSource		変換前の番号で引くパレット
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+static int32_t
+RemapPalette4( const Cat_Texture* pTexture, Cat_Palette** ppDest, const Cat_Palette* pSource )
+{
+	Cat_Palette* pDest = *ppDest;
+	int i;
+
+	if((pDest == 0) || (pDest->ePaletteFormat != pSource->ePaletteFormat)) {
+		// フォーマットの違うパレットに差し替えられた
+		Cat_Palette* pNew = Cat_PaletteCreate( pSource->ePaletteFormat, 16, 0 );
+		if(pNew == 0) {
+			return -1;
+		}
+		Cat_PaletteRelease( pDest );
+		*ppDest = pDest = pNew;
+	}
+	if(pSource->ePaletteFormat == FORMAT_PALETTE_8888) {
+		for(i = 0; i < 16; i++) {
+			((uint32_t*)pDest->pvData)[i] = ((uint32_t*)pSource->pvData)[pTexture->tbl4to8[i] & pSource->nMask];
 		}
 	} else {
-		sceGuDisable( GU_TEXTURE_2D );	/* テクスチャ無効 */
+		for(i = 0; i < 16; i++) {
+			((uint16_t*)pDest->pvData)[i] = ((uint16_t*)pSource->pvData)[pTexture->tbl4to8[i] & pSource->nMask];
+		}
 	}
+	Cat_PaletteUpdate( pDest );
+	return 0;
+}
+
+//! 設定されたパレットから作った4bitパレットを取得する
+/*!
+	4bitのピクセルで変換前のパレットを引くと違う色になるので、変換テーブルで並べ替えたパレットを作る。 \n
+	ACTの差し替えのように1フレームで何種類も使われるので、作成元のパレットごとに持っておく。 \n
+	同じパレットは作成元の更新カウンタが変わった時だけ書き換えるので、作成元と同じ間だけGEが読める。 \n
+	作成元の参照がこちらだけになったもの(他で解放されたもの)は、探す途中で解放する。
+	@param[in]	pTexture	テクスチャ(分割されたテクスチャは、分割テクスチャ)
+	@param[in]	pPalette	変換前の番号で引くパレット
+	@param[in]	fCreate		無い場合に作るかどうか
+	@return	設定するパレット。4bitに変換されていないテクスチャと、作れなかった場合は \a pPalette が返る。
+*/
+static Cat_Palette*
+GetListPalette4( Cat_Texture* pTexture, Cat_Palette* pPalette, int fCreate )
+{
+	Cat_TexturePalette4** ppEntry;
+	Cat_TexturePalette4* pEntry;
+
+	if((pTexture == 0) || (pPalette == 0) || (pTexture->pPalette4 == 0)) {
+		return pPalette;
+	}
+	if(pPalette == pTexture->pPalette) {
+		// テクスチャのパレットは、いつもの4bitパレット
+		return Cat_TextureGetDrawPalette( pTexture );
+	}
+	ppEntry = &pTexture->pPalette4List;
+	while((pEntry = *ppEntry) != 0) {
+		if(pEntry->pSource == pPalette) {
+			break;
+		}
+		if(pEntry->pSource->nRef == 1) {
+			*ppEntry = pEntry->pNext;
+			Cat_PaletteRelease( pEntry->pPalette4 );
+			Cat_PaletteRelease( pEntry->pSource );
+			free( pEntry );
+			continue;
+		}
+		ppEntry = &pEntry->pNext;
+	}
+	if(pEntry == 0) {
+		if(!fCreate) {
+			return pPalette;
+		}
+		pEntry = (Cat_TexturePalette4*)malloc( sizeof(Cat_TexturePalette4) );
+		if(pEntry == 0) {
+			return pPalette;
+		}
+		pEntry->pPalette4 = 0;
+		if(RemapPalette4( pTexture, &pEntry->pPalette4, pPalette ) < 0) {
+			free( pEntry );
+			return pPalette;
+		}
+		Cat_PaletteAddRef( pPalette );
+		pEntry->pSource = pPalette;
+		pEntry->nSerial = pPalette->nSerial;
+		pEntry->pNext   = pTexture->pPalette4List;
+		pTexture->pPalette4List = pEntry;
+	} else if(pEntry->nSerial != pPalette->nSerial) {
+		// 作成元が更新された
+		if(RemapPalette4( pTexture, &pEntry->pPalette4, pPalette ) == 0) {
+			pEntry->nSerial = pPalette->nSerial;
+		}
+	}
+	return pEntry->pPalette4;
+}
+
+//! 設定されたパレットから作った4bitパレットを全部解放する
+/*!
+	変換テーブルが変わる時(ピクセルデータを解放する時)に呼ぶ。
+	@param[in,out]	pTexture	テクスチャ
+*/
+static void
+FreeListPalette4( Cat_Texture* pTexture )
+{
+	Cat_TexturePalette4* pEntry = pTexture->pPalette4List;
+
+	while(pEntry) {
+		Cat_TexturePalette4* pNext = pEntry->pNext;
+		Cat_PaletteRelease( pEntry->pPalette4 );
+		Cat_PaletteRelease( pEntry->pSource );
+		free( pEntry );
+		pEntry = pNext;
+	}
+	pTexture->pPalette4List = 0;
 }
 
 //! 横幅を取得
@@ -299,6 +1370,31 @@ Cat_TextureGetPitch( Cat_Texture* pTexture )
 	return pTexture->nPitch;
 }
 
+//! ピクセルデータのサイズを取得する
+/*!
+	@param[in]	pTexture	テクスチャ
+	@return	ピクセルデータのサイズ(バイト単位)
+*/
+uint32_t
+Cat_TextureGetDataSize( Cat_Texture* pTexture )
+{
+	if(pTexture == 0) {
+		return 0;
+	}
+	if(pTexture->ppTile) {
+		uint32_t rc = 0;
+		uint32_t i;
+		for(i = 0; i < pTexture->nTileCountX * pTexture->nTileCountY; i++) {
+			rc += Cat_TextureGetDataSize( pTexture->ppTile[i] );
+		}
+		return rc;
+	}
+	if(pTexture->pvData == 0) {
+		return 0;
+	}
+	return pTexture->nPitch * pTexture->nHeight;
+}
+
 //! サイズを調整する
 static int32_t
 ConvertSize( Cat_Texture* pTexture )
@@ -320,6 +1416,9 @@ ConvertSize( Cat_Texture* pTexture )
 	if(pTexture == 0) {
 		return 0;
 	}
+	if(Cat_TextureDXTIsFormat( pTexture->ePixelFormat )) {
+		return 0;	/* 圧縮済みのデータは縮小できない */
+	}
 
 	nWidth2  = up2( pTexture->nWidth );
 	nHeight2 = up2( pTexture->nHeight );
@@ -462,7 +1561,7 @@ static void
 ConvertImageSwap( Cat_Texture* pTexture )
 {
 	if(pTexture->pvData && (pTexture->nTexMode == CAT_TEXMODE_NORMAL)
-		&& ((pTexture->nHeight & 7) == 0)) {
+		&& ((pTexture->nHeight & 7) == 0) && !Cat_TextureDXTIsFormat( pTexture->ePixelFormat )) {
 		uint8_t* work = (uint8_t*)CAT_MALLOC( pTexture->nPitch * 8 );
 		if(work) {
 			uint32_t h = pTexture->nHeight;
@@ -487,6 +1586,91 @@ ConvertImageSwap( Cat_Texture* pTexture )
 	}
 }
 
+//! 使っている色を調べる
+/*!
+	4ピクセルを1ワードとして読み込み、前のワードと同じなら読み飛ばす。 \n
+	スプライトは同じ色が続くことが多いので、ほとんどのワードは比較1回で済む。
+	@param[in]	pTexture	テクスチャ(CLUT8で入れ替え前であること)
+	@param[out]	pnUsed		使っている色のビットマップ(256ビット)
+	@param[in]	nLimit		この色数を超えたら調べるのをやめる
+	@return	使っている色数。 \a nLimit を超えた場合は \a nLimit + 1 を返す
+*/
+static uint32_t
+CountColor( const Cat_Texture* pTexture, uint32_t* pnUsed, uint32_t nLimit )
+{
+	const uint32_t nWidth  = pTexture->nTextureWidth;
+	const uint32_t nHeight = pTexture->nTextureHeight;
+	const uint32_t nWords  = nWidth / 4;
+	uint32_t nCount = 0;
+	uint32_t x;
+	uint32_t y;
+	uint32_t i;
+
+	memset( pnUsed, 0, sizeof(uint32_t) * 8 );
+	for(y = 0; y < nHeight; y++) {
+		const uint8_t* pbLine = (const uint8_t*)pTexture->pvData + y * pTexture->nPitch;
+		const uint32_t* pnLine = (const uint32_t*)pbLine;	// 行頭は16バイト境界
+		uint32_t nPrev = pnLine[0] ^ 1;						// 最初のワードは必ず調べる
+		for(x = 0; x < nWords; x++) {
+			uint32_t n = pnLine[x];
+			if(n == nPrev) {
+				continue;
+			}
+			nPrev = n;
+			if((n ^ (n >> 8)) & 0x00FFFFFF) {
+				// 違う色が混じっている
+				pnUsed[(n >>  5) & 7] |= 1UL << ( n        & 31);
+				pnUsed[(n >> 13) & 7] |= 1UL << ((n >>  8) & 31);
+				pnUsed[(n >> 21) & 7] |= 1UL << ((n >> 16) & 31);
+				pnUsed[(n >> 29) & 7] |= 1UL << ((n >> 24) & 31);
+			} else {
+				// 4ピクセルとも同じ色
+				pnUsed[(n >> 5) & 7] |= 1UL << (n & 31);
+			}
+		}
+		for(x = nWords * 4; x < nWidth; x++) {
+			pnUsed[pbLine[x] >> 5] |= 1UL << (pbLine[x] & 31);
+		}
+
+		// 1行ごとに色数を確認して、超えていたら打ち切る
+		nCount = 0;
+		for(i = 0; i < 8; i++) {
+			nCount += __builtin_popcount( pnUsed[i] );
+		}
+		if(nCount > nLimit) {
+			return nLimit + 1;
+		}
+	}
+	return nCount;
+}
+
+//! 余白を埋める色の番号を調べる
+/*!
+	8bitのイメージの余白にある番号を使う。作成時に透明色で埋めているので、4bitにしても同じ色が見える。 \n
+	余白が無い場合は、パレットで最初に見つかった透明な色を使う。透明な色も無ければ0番にする。
+	@param[in]	pTexture	テクスチャ(CLUT8で入れ替え前であること)
+	@return	余白の色の番号
+*/
+static uint32_t
+GetPaddingIndex( const Cat_Texture* pTexture )
+{
+	const uint8_t* pbData = (const uint8_t*)pTexture->pvData;
+	uint32_t i;
+
+	if(pTexture->nTextureWidth < pTexture->nPitch) {
+		return pbData[pTexture->nTextureWidth];
+	}
+	if(pTexture->nTextureHeight < pTexture->nHeight) {
+		return pbData[pTexture->nTextureHeight * pTexture->nPitch];
+	}
+	for(i = 0; i <= pTexture->pPalette->nMask; i++) {
+		if((Cat_PaletteGetColor( pTexture->pPalette, i ) >> 24) == 0) {
+			return i;
+		}
+	}
+	return 0;
+}
+
 //! 使っている色を調べて16色以下なら4bitにする
 /*!
 	@param[in,out]	pTexture	テクスチャ
@@ -494,10 +1678,14 @@ ConvertImageSwap( Cat_Texture* pTexture )
 static void
 Convert4( Cat_Texture* pTexture )
 {
+	uint32_t nUsed[8];
 	uint8_t his[256];
 	uint32_t x;
 	uint32_t y;
 	uint32_t count;
+	uint32_t h;
+	uint32_t pitch;
+	uint32_t nPad;
 	uint8_t* work;
 
 	if((pTexture == 0) || (pTexture->pvData == 0) || (pTexture->pPalette == 0)) {
@@ -508,21 +1696,19 @@ Convert4( Cat_Texture* pTexture )
 		return;
 	}
 
-	memset( his, 32, 256 );
+	count = CountColor( pTexture, nUsed, 16 );
+	if(count > 16) {
+		/* 色つかいすぎなので駄目です。 */
+		return;
+	}
 
-	count = 0;
-	for(y = 0; y < pTexture->nHeight; y++) {
-		for(x = 0; x < pTexture->nWidth; x++) {
-			unsigned char c = *((uint8_t*)pTexture->pvData + x + y * pTexture->nPitch);
-			if(his[c] == 32) {
-				his[c] = count;
-				count++;
-				if(count > 16) {
-					/* 色つかいすぎなので駄目です。 */
-					return;
-				}
-			}
+	/* 余白の色も16色に入れておく */
+	nPad = GetPaddingIndex( pTexture );
+	if(!(nUsed[nPad >> 5] & (1UL << (nPad & 31)))) {
+		if(count == 16) {
+			return;	/* 余白の色が入らない */
 		}
+		nUsed[nPad >> 5] |= 1UL << (nPad & 31);
 	}
 
 	if(pTexture->pPalette4) {
@@ -534,9 +1720,12 @@ Convert4( Cat_Texture* pTexture )
 	}
 
 	/* パレット変換テーブル作成 */
+	/* 使っていない番号は0番に割り当てておく */
+	memset( his, 0, sizeof(his) );
+	memset( pTexture->tbl4to8, 0, sizeof(pTexture->tbl4to8) );
 	count = 0;
 	for(x = 0; x < 256; x++) {
-		if(his[x] < 16) {
+		if(nUsed[x >> 5] & (1UL << (x & 31))) {
 			his[x] = count;
 			pTexture->tbl4to8[count] = x;	/* 変換テーブル */
 			count++;
@@ -544,25 +1733,29 @@ Convert4( Cat_Texture* pTexture )
 	}
 
 	/* 16色に変換する */
-	int h = ((pTexture->nHeight + 7) & ~7);						/* 8の倍数に */
-	int pitch = ((pTexture->nWidth * 4 + 127) & ~127) / 8;		/* 16バイトの倍数に */
+	h = ((pTexture->nHeight + 7) & ~7);							/* 8の倍数に */
+	pitch = ((pTexture->nWidth * 4 + 127) & ~127) / 8;			/* 16バイトの倍数に */
 	work = (uint8_t*)CAT_MALLOC( pitch * h );
 	if(work) {
-		memset( work, 0, pitch * h );
-		for(y = 0; y < pTexture->nHeight; y++) {
-			for(x = 0; x < pTexture->nWidth; x++) {
-				uint8_t c = *((uint8_t*)pTexture->pvData + x + y * pTexture->nPitch);
-				if((x & 1) == 0) {
-					work[(x / 2) + y * pitch] = his[c];
-				} else {
-					work[(x / 2) + y * pitch] |= his[c] << 4;
-				}
+		/* 余白は0番ではなく、余白の色で埋める(0番は使っている最初の色) */
+		memset( work, his[nPad] | (his[nPad] << 4), pitch * h );
+		for(y = 0; y < pTexture->nTextureHeight; y++) {
+			const uint8_t* pbSrc = (const uint8_t*)pTexture->pvData + y * pTexture->nPitch;
+			uint8_t* pbDest = work + y * pitch;
+			for(x = 0; x + 1 < pTexture->nTextureWidth; x += 2) {
+				*pbDest++ = his[pbSrc[x]] | (his[pbSrc[x + 1]] << 4);
+			}
+			if(x < pTexture->nTextureWidth) {
+				*pbDest = his[pbSrc[x]] | (his[nPad] << 4);
 			}
 		}
+		pTexture->nSavedSize  += pTexture->nPitch * pTexture->nHeight - pitch * h;
 		CAT_FREE( pTexture->pvData );
 		pTexture->pvData       = (void*)work;
 		pTexture->nPitch       = pitch;
+		pTexture->nHeight      = h;
 		pTexture->ePixelFormat = FORMAT_PIXEL_CLUT4;
+		UpdatePalette4( pTexture );
 	} else {
 		if(pTexture->pPalette4) {
 			Cat_PaletteRelease( pTexture->pPalette4 );
@@ -571,6 +1764,347 @@ Convert4( Cat_Texture* pTexture )
 	}
 }
 
+//! 1ピクセルにディザをかける
+/*!
+	各チャンネルに、切り捨てられる幅の中でしきい値を足す。
+	@param[in]	nColor		RGBA8888の色
+	@param[in]	nThreshold	ディザのしきい値(0～15)
+	@param[in]	pnBits		変換先の各チャンネルのビット数(R,G,B,A)
+	@return	ディザをかけたRGBA8888の色
+*/
+static uint32_t
+DitherPixel( uint32_t nColor, uint32_t nThreshold, const uint8_t* pnBits )
+{
+	uint32_t rc = 0;
+	uint32_t i;
+
+	for(i = 0; i < 4; i++) {
+		uint32_t c = (nColor >> (i * 8)) & 0xFF;
+		c += (nThreshold << (8 - pnBits[i])) >> 4;
+		rc |= ((c > 0xFF) ? 0xFF : c) << (i * 8);
+	}
+	return rc;
+}
+
+//! 32bitのテクスチャを画質が保てる16bitにする
+/*!
+	アルファが無ければRGBA5650、0と255だけならRGBA5551、半透明があればRGBA4444を選ぶ。 \n
+	変換して戻した色と元の色の誤差(PSNR)が、Cat_TextureSetQuality()の値に届かなければ変換しない。 \n
+	透明なピクセルの色は、誤差に含めない。
+	@param[in,out]	pTexture	テクスチャ(入れ替え前であること)
+*/
+static void
+Convert16( Cat_Texture* pTexture )
+{
+	//! 4x4の組織的ディザのしきい値
+	static const uint8_t tblBayer[4][4] = {
+		{  0,  8,  2, 10 },
+		{ 12,  4, 14,  6 },
+		{  3, 11,  1,  9 },
+		{ 15,  7, 13,  5 },
+	};
+	//! 各チャンネルのビット数(アルファを持たないチャンネルは8でディザをかけない)
+	static const uint8_t tblBits[3][4] = {
+		{ 5, 6, 5, 8 },		// 5650
+		{ 5, 5, 5, 8 },		// 5551
+		{ 4, 4, 4, 4 },		// 4444
+	};
+	const uint32_t nStart = sceKernelGetSystemTimeLow();
+	FORMAT_PIXEL eFormat = FORMAT_PIXEL_5650;
+	uint32_t nAlpha = 0;		// 0:なし 1:1bit 2:階調あり
+	uint64_t nError = 0;
+	uint32_t nSample = 0;
+	uint32_t* pnWork;
+	uint8_t* work;
+	uint32_t pitch;
+	uint32_t w;
+	uint32_t h;
+	uint32_t x;
+	uint32_t y;
+
+	if((pTexture == 0) || (pTexture->pvData == 0)) {
+		return;
+	}
+	if(pTexture->ePixelFormat != FORMAT_PIXEL_8888) {
+		return;
+	}
+	gFormat16Statistics.nAnalyzeCount++;
+	w = pTexture->nTextureWidth;
+	h = pTexture->nTextureHeight;
+
+	// アルファの使い方を調べる
+	for(y = 0; (y < h) && (nAlpha < 2); y++) {
+		const uint32_t* pnSrc = (const uint32_t*)((const uint8_t*)pTexture->pvData + pTexture->nPitch * y);
+		for(x = 0; x < w; x++) {
+			const uint32_t a = pnSrc[x] >> 24;
+			if(a == 0) {
+				nAlpha = 1;
+			} else if(a != 0xFF) {
+				nAlpha = 2;
+				break;
+			}
+		}
+	}
+	if(nAlpha == 1) {
+		eFormat = FORMAT_PIXEL_5551;
+	} else if(nAlpha == 2) {
+		eFormat = FORMAT_PIXEL_4444;
+	}
+
+	pitch = (pTexture->nPitch / 4 * 2 + 15) & ~15;	/* 16バイトの倍数に */
+	work = (uint8_t*)CAT_MALLOC( pitch * pTexture->nHeight );
+	pnWork = (uint32_t*)CAT_MALLOC( w * 4 * 2 + 4 );
+	if((work == 0) || (pnWork == 0)) {
+		if(work) {
+			CAT_FREE( work );
+		}
+		if(pnWork) {
+			CAT_FREE( pnWork );
+		}
+		return;
+	}
+	memset( work, 0, pitch * pTexture->nHeight );
+
+	// 1ラインずつ変換して、戻した色との誤差を集計する
+	// ディザは誤差を散らすだけなので、誤差はディザなしで変換した色で測る
+	for(y = 0; y < h; y++) {
+		const uint32_t* pnSrc = (const uint32_t*)((const uint8_t*)pTexture->pvData + pTexture->nPitch * y);
+		uint16_t* pnDest = (uint16_t*)(work + pitch * y);
+		uint32_t* pnBack = pnWork + w;
+		Cat_ColorConvert( pnDest, eFormat, pnSrc, FORMAT_PIXEL_8888, w );
+		Cat_ColorConvert( pnBack, FORMAT_PIXEL_8888, pnDest, eFormat, w );
+		if(gnOption & CAT_TEXTURE_OPTION_DITHER) {
+			for(x = 0; x < w; x++) {
+				pnWork[x] = DitherPixel( pnSrc[x], tblBayer[y & 3][x & 3], tblBits[eFormat - FORMAT_PIXEL_5650] );
+			}
+			Cat_ColorConvert( pnDest, eFormat, pnWork, FORMAT_PIXEL_8888, w );
+		}
+		for(x = 0; x < w; x++) {
+			const uint32_t nChannel = (eFormat == FORMAT_PIXEL_5650) ? 3 : 4;
+			uint32_t i;
+			if((pnSrc[x] >> 24) == 0) {
+				continue;	// 透明なら色は見えない
+			}
+			for(i = 0; i < nChannel; i++) {
+				const int32_t d = (int32_t)((pnSrc[x] >> (i * 8)) & 0xFF) - (int32_t)((pnBack[x] >> (i * 8)) & 0xFF);
+				nError += d * d;
+			}
+			nSample += nChannel;
+		}
+	}
+	CAT_FREE( pnWork );
+
+	if(gnQuality && nSample) {
+		// 平均二乗誤差が 255^2 / 10^(PSNR/10) 以下ならよい
+		const float fLimit = 65025.0f / powf( 10.0f, (float)gnQuality / 10.0f );
+		if((float)nError > fLimit * (float)nSample) {
+			CAT_FREE( work );
+			gFormat16Statistics.nRejectCount++;
+			gFormat16Statistics.nTime += sceKernelGetSystemTimeLow() - nStart;
+			return;
+		}
+	}
+
+	switch(eFormat) {
+		case FORMAT_PIXEL_5650:
+			gFormat16Statistics.n5650Count++;
+			break;
+		case FORMAT_PIXEL_5551:
+			gFormat16Statistics.n5551Count++;
+			break;
+		default:
+			gFormat16Statistics.n4444Count++;
+			break;
+	}
+	gFormat16Statistics.nSavedSize += pTexture->nPitch * pTexture->nHeight - pitch * pTexture->nHeight;
+	pTexture->nSavedSize += pTexture->nPitch * pTexture->nHeight - pitch * pTexture->nHeight;
+	CAT_FREE( pTexture->pvData );
+	pTexture->pvData       = (void*)work;
+	pTexture->nPitch       = pitch;
+	pTexture->ePixelFormat = eFormat;
+	gFormat16Statistics.nTime += sceKernelGetSystemTimeLow() - nStart;
+}
+
+//! 32bitのイメージを画質が保てる8bitのイメージにする
+/*!
+	半透明が無ければ、メディアンカットで作ったパレットのCLUT8にする。 \n
+	使っている色が256色以下なら、元の色のままパレットにする。 \n
+	元の色との誤差(PSNR)が、Cat_TextureSetQuality()の値に届かなければ変換しない。 \n
+	余白は透明色で埋める。
+	@param[in]	pvImage		イメージ(RGBA8888)
+	@param[in]	nWidth		横幅(ピクセル単位)
+	@param[in]	nHeight		高さ(ピクセル単位)
+	@param[in]	nPitch		1ラインのバイト数
+	@param[in]	nDestPitch	変換先の1ラインのバイト数
+	@param[in]	nDestHeight	変換先の高さ(余白を含む)
+	@param[out]	ppvDest		変換したイメージ(CAT_MALLOCで確保される)
+	@param[out]	ppPalette	作成したパレット
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+static int32_t
+QuantizeImage( const void* pvImage, uint32_t nWidth, uint32_t nHeight, uint32_t nPitch, uint32_t nDestPitch, uint32_t nDestHeight,
+	void** ppvDest, Cat_Palette** ppPalette )
+{
+	const uint32_t nStart = sceKernelGetSystemTimeLow();
+	Cat_Quantize* pQuantize;
+	Cat_Palette* pPalette;
+	uint8_t* work;
+	int32_t rc = -1;
+
+	pQuantize = Cat_QuantizeCreate( pvImage, nWidth, nHeight, nPitch, CAT_QUANTIZE_COLOR_MAX );
+	if(pQuantize == 0) {
+		return -1;	// 半透明がある
+	}
+	gQuantizeStatistics.nAnalyzeCount++;
+	gQuantizeStatistics.nPixelCount += nWidth * nHeight;
+
+	work = (uint8_t*)CAT_MALLOC( nDestPitch * nDestHeight );
+	pPalette = Cat_PaletteCreate( FORMAT_PALETTE_8888, 256, pQuantize->anPalette );
+	if((work == 0) || (pPalette == 0)) {
+		goto cleanup;
+	}
+	// 余白は透明色で埋める
+	memset( work, (pQuantize->nTransparent >= 0) ? pQuantize->nTransparent : 0, nDestPitch * nDestHeight );
+	if(Cat_QuantizeMapImage( pQuantize, work, nDestPitch, pvImage, nWidth, nHeight, nPitch ) < 0) {
+		goto cleanup;
+	}
+
+	if(gnQuality && pQuantize->nSample) {
+		// 平均二乗誤差が 255^2 / 10^(PSNR/10) 以下ならよい
+		const float fLimit = 65025.0f / powf( 10.0f, (float)gnQuality / 10.0f );
+		if((float)pQuantize->nError > fLimit * (float)pQuantize->nSample) {
+			gQuantizeStatistics.nRejectCount++;
+			goto cleanup;
+		}
+	}
+
+	gQuantizeStatistics.nConvertCount++;
+	if(pQuantize->fExact) {
+		gQuantizeStatistics.nExactCount++;
+	}
+	*ppvDest   = (void*)work;
+	*ppPalette = pPalette;
+	work = 0;
+	pPalette = 0;
+	rc = 0;
+
+cleanup:
+	if(work) {
+		CAT_FREE( work );
+	}
+	if(pPalette) {
+		Cat_PaletteRelease( pPalette );
+	}
+	Cat_QuantizeRelease( pQuantize );
+	gQuantizeStatistics.nTime += sceKernelGetSystemTimeLow() - nStart;
+	return rc;
+}
+
+//! 32bitのテクスチャを画質が保てる8bitにする
+/*!
+	@param[in,out]	pTexture	テクスチャ(入れ替え前であること)
+	@see	QuantizeImage()
+*/
+static void
+ConvertQuantize( Cat_Texture* pTexture )
+{
+	Cat_Palette* pPalette;
+	void* work;
+	uint32_t pitch;
+
+	if((pTexture == 0) || (pTexture->pvData == 0)) {
+		return;
+	}
+	if(pTexture->ePixelFormat != FORMAT_PIXEL_8888) {
+		return;
+	}
+
+	pitch = (pTexture->nPitch / 4 + 15) & ~15;	/* 16バイトの倍数に */
+	if(QuantizeImage( pTexture->pvData, pTexture->nTextureWidth, pTexture->nTextureHeight, pTexture->nPitch,
+		pitch, pTexture->nHeight, &work, &pPalette ) < 0) {
+		return;
+	}
+
+	gQuantizeStatistics.nSavedSize += pTexture->nPitch * pTexture->nHeight - pitch * pTexture->nHeight;
+	pTexture->nSavedSize += pTexture->nPitch * pTexture->nHeight - pitch * pTexture->nHeight;
+	CAT_FREE( pTexture->pvData );
+	pTexture->pvData       = work;
+	pTexture->nPitch       = pitch;
+	pTexture->ePixelFormat = FORMAT_PIXEL_CLUT8;
+	if(pTexture->pPalette) {
+		Cat_PaletteRelease( pTexture->pPalette );
+	}
+	pTexture->pPalette = pPalette;
+}
+
+//! 32bitのテクスチャをDXT圧縮する
+/*!
+	アルファが0と255だけならDXT1、半透明があればDXT5にする。
+	@param[in,out]	pTexture	テクスチャ(入れ替え前であること)
+*/
+static void
+ConvertDXT( Cat_Texture* pTexture )
+{
+	FORMAT_PIXEL eFormat;
+	uint32_t nBlockSize;
+	uint32_t pitch;
+	uint32_t i;
+	uint8_t* work;
+
+	if((pTexture == 0) || (pTexture->pvData == 0)) {
+		return;
+	}
+	if(pTexture->ePixelFormat != FORMAT_PIXEL_8888) {
+		return;
+	}
+
+	eFormat = Cat_TextureDXTSelectFormat( pTexture->pvData, pTexture->nTextureWidth, pTexture->nTextureHeight, pTexture->nPitch );
+	nBlockSize = Cat_TextureDXTGetBlockSize( eFormat );
+	pitch = (pTexture->nPitch / 4 * GetPixelBits( eFormat ) / 8 + 15) & ~15;	/* 16バイトの倍数に */
+	work = (uint8_t*)CAT_MALLOC( pitch * pTexture->nHeight );
+	if(work == 0) {
+		return;
+	}
+	if(eFormat == FORMAT_PIXEL_DXT1) {
+		/* 余白は透明のブロックで埋める */
+		static const uint32_t nEmpty[2] = { 0xFFFFFFFF, 0 };
+		for(i = 0; i < pitch * pTexture->nHeight; i += nBlockSize) {
+			memcpy( work + i, nEmpty, nBlockSize );
+		}
+	} else {
+		memset( work, 0, pitch * pTexture->nHeight );
+	}
+	if(Cat_TextureDXTEncode( pTexture->pvData, pTexture->nTextureWidth, pTexture->nTextureHeight, pTexture->nPitch,
+			work, pitch, eFormat ) < 0) {
+		CAT_FREE( work );
+		return;
+	}
+	pTexture->nSavedSize  += pTexture->nPitch * pTexture->nHeight - pitch * pTexture->nHeight;
+	CAT_FREE( pTexture->pvData );
+	pTexture->pvData       = (void*)work;
+	pTexture->nPitch       = pitch;
+	pTexture->ePixelFormat = eFormat;
+}
+
+//! DXT圧縮されたテクスチャからテクセルを取得する
+/*!
+	@param[in]	pTexture	テクスチャ
+	@param[in]	x			x座標
+	@param[in]	y			y座標
+	@return	RGBA8888形式のピクセル値
+*/
+static uint32_t
+Cat_TextureGetPixelDXT( Cat_Texture* pTexture, uint32_t x, uint32_t y )
+{
+	uint32_t nBlock[16];
+	uint32_t nOffset =
+		(y / 4) * (pTexture->nPitch * 4)
+		+ (x / 4) * Cat_TextureDXTGetBlockSize( pTexture->ePixelFormat );
+	Cat_TextureDXTDecodeBlock( (uint8_t*)pTexture->pvData + nOffset, pTexture->ePixelFormat, nBlock );
+	return nBlock[(x & 3) + (y & 3) * 4];
+}
+
 //! 32bit(RGBA8888)のテクスチャからテクセルを取得する
 /*!
 	@param[in]	pTexture	テクスチャ
@@ -677,6 +2211,9 @@ Cat_TextureGetPixel4( Cat_Texture* pTexture, uint32_t x, uint32_t y )
 uint32_t
 Cat_TextureGetPixel( Cat_Texture* pTexture, uint32_t x, uint32_t y )
 {
+	if(pTexture->ppTile) {
+		pTexture = GetTile( pTexture, &x, &y );
+	}
 	switch(pTexture->ePixelFormat) {
 		case FORMAT_PIXEL_5650:
 			return Cat_ColorConvert5650To8888( Cat_TextureGetPixel16( pTexture, x, y ) );
@@ -694,6 +2231,10 @@ Cat_TextureGetPixel( Cat_Texture* pTexture, uint32_t x, uint32_t y )
 			} else {
 				return Cat_PaletteGetColor( pTexture->pPalette, Cat_TextureGetPixel4( pTexture, x, y ) );
 			}
+		case FORMAT_PIXEL_DXT1:
+		case FORMAT_PIXEL_DXT3:
+		case FORMAT_PIXEL_DXT5:
+			return Cat_TextureGetPixelDXT( pTexture, x, y );
 		default:
 			return 0;
 	}
@@ -709,6 +2250,9 @@ Cat_TextureGetPixel( Cat_Texture* pTexture, uint32_t x, uint32_t y )
 uint32_t
 Cat_TextureGetPixelRaw( Cat_Texture* pTexture, uint32_t x, uint32_t y )
 {
+	if(pTexture->ppTile) {
+		pTexture = GetTile( pTexture, &x, &y );
+	}
 	switch(pTexture->ePixelFormat) {
 		case FORMAT_PIXEL_5650:
 			return Cat_TextureGetPixel16( pTexture, x, y );
@@ -726,11 +2270,309 @@ Cat_TextureGetPixelRaw( Cat_Texture* pTexture, uint32_t x, uint32_t y )
 			} else {
 				return Cat_TextureGetPixel4( pTexture, x, y );
 			}
+		case FORMAT_PIXEL_DXT1:
+		case FORMAT_PIXEL_DXT3:
+		case FORMAT_PIXEL_DXT5:
+			// 圧縮されているのでRGBA8888で返す
+			return Cat_TextureGetPixelDXT( pTexture, x, y );
 		default:
 			return 0;
 	}
 }
 
+//! 16バイトの中のn番目のピクセルを読む(32bit)
+#define REGION_READ32(pb, n)	(((const uint32_t*)(pb))[n])
+//! 16バイトの中のn番目のピクセルを読む(16bit)
+#define REGION_READ16(pb, n)	(((const uint16_t*)(pb))[n])
+//! 16バイトの中のn番目のピクセルを読む(8bit)
+#define REGION_READ8(pb, n)		((pb)[n])
+//! 16バイトの中のn番目のピクセルを読む(4bit)
+#define REGION_READ4(pb, n)		(((pb)[(n) >> 1] >> (((n) & 1) * 4)) & 0xF)
+
+//! 変換しない
+#define REGION_CONV_NONE(v)		(v)
+//! テーブルで変換する
+#define REGION_CONV_TABLE(v)	(pnTable[v])
+//! RGBA5650からRGBA8888へ変換する
+#define REGION_CONV_5650(v)		Cat_ColorConvert5650To8888( v )
+//! RGBA5551からRGBA8888へ変換する
+#define REGION_CONV_5551(v)		Cat_ColorConvert5551To8888( v )
+//! RGBA4444からRGBA8888へ変換する
+#define REGION_CONV_4444(v)		Cat_ColorConvert4444To8888( v )
+
+//! 領域取得の関数を定義する
+/*!
+	入れ替え済みのテクスチャは、16バイト×8ラインのブロックごとに読み出す。 \n
+	ブロックに丸ごと含まれる部分は、ループ回数が定数になるので展開される。
+	@param	name	関数名
+	@param	PPB		16バイトに含まれるピクセル数
+	@param	READ	ピクセルを読むマクロ
+	@param	DEST	出力先の型
+	@param	CONV	変換するマクロ
+*/
+#define DEFINE_REGION_FUNC(name, PPB, READ, DEST, CONV)								\
+static void																			\
+name( const Cat_Texture* pTexture, uint32_t x, uint32_t y, uint32_t w, uint32_t h,	\
+	uint8_t* pbDest, uint32_t nDestPitch, const uint32_t* pnTable )				\
+{																					\
+	const uint8_t* pbData = (const uint8_t*)pTexture->pvData;						\
+	const uint32_t nPitch = pTexture->nPitch;										\
+	const uint32_t x1 = x + w;														\
+	const uint32_t y1 = y + h;														\
+	uint32_t i;																		\
+	uint32_t j;																		\
+	(void)pnTable;																	\
+	if(pTexture->nTexMode == CAT_TEXMODE_SWAP) {									\
+		uint32_t bx;																\
+		uint32_t by;																\
+		for(by = y & ~7; by < y1; by += 8) {										\
+			const uint32_t yy0 = (by < y) ? y : by;									\
+			const uint32_t yy1 = (by + 8 > y1) ? y1 : by + 8;						\
+			const uint8_t* pbBlockLine = pbData + by * nPitch;						\
+			for(bx = x & ~(PPB - 1); bx < x1; bx += PPB) {							\
+				const uint32_t xx0 = (bx < x) ? x : bx;								\
+				const uint32_t xx1 = (bx + PPB > x1) ? x1 : bx + PPB;				\
+				const uint8_t* pbBlock = pbBlockLine + (bx / PPB) * (16*8);			\
+				for(j = yy0; j < yy1; j++) {										\
+					const uint8_t* pbSrc = pbBlock + (j & 7) * 16;					\
+					DEST* pDest = (DEST*)(pbDest + (j - y) * nDestPitch) + (xx0 - x);	\
+					if((xx0 == bx) && (xx1 == bx + PPB)) {							\
+						for(i = 0; i < PPB; i++) {									\
+							pDest[i] = (DEST)CONV( READ( pbSrc, i ) );				\
+						}															\
+					} else {														\
+						for(i = xx0 - bx; i < xx1 - bx; i++) {						\
+							*pDest++ = (DEST)CONV( READ( pbSrc, i ) );				\
+						}															\
+					}																\
+				}																	\
+			}																		\
+		}																			\
+	} else {																		\
+		for(j = y; j < y1; j++) {													\
+			const uint8_t* pbSrc = pbData + j * nPitch;								\
+			DEST* pDest = (DEST*)(pbDest + (j - y) * nDestPitch);					\
+			for(i = x; i < x1; i++) {												\
+				*pDest++ = (DEST)CONV( READ( pbSrc, i ) );							\
+			}																		\
+		}																			\
+	}																				\
+}
+
+DEFINE_REGION_FUNC( GetRegion32,      4, REGION_READ32, uint32_t, REGION_CONV_NONE  )
+DEFINE_REGION_FUNC( GetRegion16,      8, REGION_READ16, uint16_t, REGION_CONV_NONE  )
+DEFINE_REGION_FUNC( GetRegion5650,    8, REGION_READ16, uint32_t, REGION_CONV_5650  )
+DEFINE_REGION_FUNC( GetRegion5551,    8, REGION_READ16, uint32_t, REGION_CONV_5551  )
+DEFINE_REGION_FUNC( GetRegion4444,    8, REGION_READ16, uint32_t, REGION_CONV_4444  )
+DEFINE_REGION_FUNC( GetRegion8,      16, REGION_READ8,  uint8_t,  REGION_CONV_NONE  )
+DEFINE_REGION_FUNC( GetRegion8Table, 16, REGION_READ8,  uint32_t, REGION_CONV_TABLE )
+DEFINE_REGION_FUNC( GetRegion4Index, 32, REGION_READ4,  uint8_t,  REGION_CONV_TABLE )
+DEFINE_REGION_FUNC( GetRegion4Table, 32, REGION_READ4,  uint32_t, REGION_CONV_TABLE )
+
+//! DXT圧縮されたテクスチャの領域を取得する
+/*!
+	4x4ピクセルのブロックごとに展開する。
+*/
+static void
+GetRegionDXT( const Cat_Texture* pTexture, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t* pbDest, uint32_t nDestPitch )
+{
+	const uint32_t nBlockSize = Cat_TextureDXTGetBlockSize( pTexture->ePixelFormat );
+	const uint32_t x1 = x + w;
+	const uint32_t y1 = y + h;
+	uint32_t nBlock[16];
+	uint32_t bx;
+	uint32_t by;
+	uint32_t i;
+	uint32_t j;
+
+	for(by = y & ~3; by < y1; by += 4) {
+		const uint32_t yy0 = (by < y) ? y : by;
+		const uint32_t yy1 = (by + 4 > y1) ? y1 : by + 4;
+		const uint8_t* pbBlock = (const uint8_t*)pTexture->pvData + by * pTexture->nPitch + (x / 4) * nBlockSize;
+		for(bx = x & ~3; bx < x1; bx += 4) {
+			const uint32_t xx0 = (bx < x) ? x : bx;
+			const uint32_t xx1 = (bx + 4 > x1) ? x1 : bx + 4;
+			Cat_TextureDXTDecodeBlock( pbBlock, pTexture->ePixelFormat, nBlock );
+			for(j = yy0; j < yy1; j++) {
+				uint32_t* pnDest = (uint32_t*)(pbDest + (j - y) * nDestPitch) + (xx0 - x);
+				for(i = xx0; i < xx1; i++) {
+					*pnDest++ = nBlock[(i - bx) + (j - by) * 4];
+				}
+			}
+			pbBlock += nBlockSize;
+		}
+	}
+}
+
+//! パレットをRGBA8888のテーブルに展開する
+/*!
+	@param[in]	pPalette	パレット
+	@param[out]	pnTable		256色分のテーブル(パレットにない色は0になる)
+*/
+static void
+ExpandPalette( const Cat_Palette* pPalette, uint32_t* pnTable )
+{
+	memset( pnTable, 0, sizeof(uint32_t) * 256 );
+	if(pPalette) {
+		// パレットフォーマットとピクセルフォーマットは同じ値
+		Cat_ColorConvert( pnTable, FORMAT_PIXEL_8888, pPalette->pvData, (FORMAT_PIXEL)pPalette->ePaletteFormat, pPalette->nMask + 1 );
+	}
+}
+
+//! 領域取得の1ピクセルのバイト数を取得する
+/*!
+	@param[in]	pTexture	テクスチャ
+	@param[in]	eMode		出力形式
+	@return	1ピクセルのバイト数
+*/
+uint32_t
+Cat_TextureGetRegionPixelSize( Cat_Texture* pTexture, CAT_TEXTURE_REGION eMode )
+{
+	if(pTexture == 0) {
+		return 0;
+	}
+	if(eMode == CAT_TEXTURE_REGION_8888) {
+		return 4;
+	}
+	switch(pTexture->ePixelFormat) {
+		case FORMAT_PIXEL_8888:
+		case FORMAT_PIXEL_DXT1:
+		case FORMAT_PIXEL_DXT3:
+		case FORMAT_PIXEL_DXT5:
+			return 4;	// DXTは常にRGBA8888
+		case FORMAT_PIXEL_5650:
+		case FORMAT_PIXEL_5551:
+		case FORMAT_PIXEL_4444:
+			return 2;
+		case FORMAT_PIXEL_CLUT4:
+		case FORMAT_PIXEL_CLUT8:
+		default:
+			return 1;
+	}
+}
+
+//! テクスチャの矩形領域を取得する
+/*!
+	Cat_TextureGetPixel()を1ピクセルずつ呼ぶ代わりに使う。 \n
+	入れ替え済みのテクスチャは16バイト×8ラインのブロック単位で読み出す。 \n
+	Clutのテクスチャを RAW で取得した場合は、8bitのパレット番号になる。
+	@param[in]	pTexture	テクスチャ
+	@param[in]	x			取得する領域の左端
+	@param[in]	y			取得する領域の上端
+	@param[in]	w			取得する領域の横幅
+	@param[in]	h			取得する領域の高さ
+	@param[out]	pvDest		出力先
+	@param[in]	nDestPitch	出力先の1ラインのバイト数
+	@param[in]	eMode		出力形式
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+	@see	Cat_TextureGetRegionPixelSize()
+*/
+int32_t
+Cat_TextureGetRegion( Cat_Texture* pTexture, uint32_t x, uint32_t y, uint32_t w, uint32_t h, void* pvDest, uint32_t nDestPitch, CAT_TEXTURE_REGION eMode )
+{
+	uint32_t nTable[256];
+	uint32_t nColor[256];
+	uint32_t i;
+
+	if((pTexture == 0) || (pvDest == 0)) {
+		return -1;
+	}
+	if((x + w > pTexture->nTextureWidth) || (y + h > pTexture->nTextureHeight)) {
+		return -1;	// はみ出している
+	}
+	if((w == 0) || (h == 0)) {
+		return 0;
+	}
+
+	if(pTexture->ppTile) {
+		// 分割テクスチャは、重なっている分割テクスチャごとに取得する
+		const uint32_t nSize = Cat_TextureGetRegionPixelSize( pTexture, eMode );
+		uint32_t tx;
+		uint32_t ty;
+		for(ty = y / CAT_TEXTURE_TILE_SIZE; ty * CAT_TEXTURE_TILE_SIZE < y + h; ty++) {
+			const uint32_t ty0 = ty * CAT_TEXTURE_TILE_SIZE;
+			const uint32_t y0 = (ty0 < y) ? y : ty0;
+			const uint32_t y1 = ((ty0 + CAT_TEXTURE_TILE_SIZE) < (y + h)) ? (ty0 + CAT_TEXTURE_TILE_SIZE) : (y + h);
+			for(tx = x / CAT_TEXTURE_TILE_SIZE; tx * CAT_TEXTURE_TILE_SIZE < x + w; tx++) {
+				const uint32_t tx0 = tx * CAT_TEXTURE_TILE_SIZE;
+				const uint32_t x0 = (tx0 < x) ? x : tx0;
+				const uint32_t x1 = ((tx0 + CAT_TEXTURE_TILE_SIZE) < (x + w)) ? (tx0 + CAT_TEXTURE_TILE_SIZE) : (x + w);
+				Cat_Texture* pTile = pTexture->ppTile[tx + ty * pTexture->nTileCountX];
+				SyncTilePalette( pTexture, pTile );
+				if(Cat_TextureGetRegion( pTile, x0 - tx0, y0 - ty0, x1 - x0, y1 - y0,
+						(uint8_t*)pvDest + (y0 - y) * nDestPitch + (x0 - x) * nSize, nDestPitch, eMode ) < 0) {
+					return -1;
+				}
+			}
+		}
+		return 0;
+	}
+
+	if(pTexture->pvData == 0) {
+		return -1;
+	}
+
+	switch(pTexture->ePixelFormat) {
+		case FORMAT_PIXEL_8888:
+			GetRegion32( pTexture, x, y, w, h, (uint8_t*)pvDest, nDestPitch, 0 );
+			break;
+		case FORMAT_PIXEL_5650:
+			if(eMode == CAT_TEXTURE_REGION_8888) {
+				GetRegion5650( pTexture, x, y, w, h, (uint8_t*)pvDest, nDestPitch, 0 );
+			} else {
+				GetRegion16( pTexture, x, y, w, h, (uint8_t*)pvDest, nDestPitch, 0 );
+			}
+			break;
+		case FORMAT_PIXEL_5551:
+			if(eMode == CAT_TEXTURE_REGION_8888) {
+				GetRegion5551( pTexture, x, y, w, h, (uint8_t*)pvDest, nDestPitch, 0 );
+			} else {
+				GetRegion16( pTexture, x, y, w, h, (uint8_t*)pvDest, nDestPitch, 0 );
+			}
+			break;
+		case FORMAT_PIXEL_4444:
+			if(eMode == CAT_TEXTURE_REGION_8888) {
+				GetRegion4444( pTexture, x, y, w, h, (uint8_t*)pvDest, nDestPitch, 0 );
+			} else {
+				GetRegion16( pTexture, x, y, w, h, (uint8_t*)pvDest, nDestPitch, 0 );
+			}
+			break;
+		case FORMAT_PIXEL_CLUT8:
+			if(eMode == CAT_TEXTURE_REGION_8888) {
+				// パレットは1回だけ展開しておく
+				ExpandPalette( pTexture->pPalette, nTable );
+				GetRegion8Table( pTexture, x, y, w, h, (uint8_t*)pvDest, nDestPitch, nTable );
+			} else {
+				GetRegion8( pTexture, x, y, w, h, (uint8_t*)pvDest, nDestPitch, 0 );
+			}
+			break;
+		case FORMAT_PIXEL_CLUT4:
+			// 4bitに変換されたテクスチャは、元の8bitのパレット番号に戻す
+			for(i = 0; i < 16; i++) {
+				nTable[i] = pTexture->pPalette4 ? (uint32_t)pTexture->tbl4to8[i] : i;
+			}
+			if(eMode == CAT_TEXTURE_REGION_8888) {
+				ExpandPalette( pTexture->pPalette, nColor );
+				for(i = 0; i < 16; i++) {
+					nTable[i] = nColor[nTable[i]];
+				}
+				GetRegion4Table( pTexture, x, y, w, h, (uint8_t*)pvDest, nDestPitch, nTable );
+			} else {
+				GetRegion4Index( pTexture, x, y, w, h, (uint8_t*)pvDest, nDestPitch, nTable );
+			}
+			break;
+		case FORMAT_PIXEL_DXT1:
+		case FORMAT_PIXEL_DXT3:
+		case FORMAT_PIXEL_DXT5:
+			GetRegionDXT( pTexture, x, y, w, h, (uint8_t*)pvDest, nDestPitch );
+			break;
+		default:
+			return -1;
+	}
+	return 0;
+}
+
 //! RGBA4444からRGBA8888へ変換する
 uint32_t
 Cat_ColorConvert4444To8888( uint16_t rgba4444 )
@@ -769,7 +2611,7 @@ Cat_ColorConvert5551To8888( uint16_t rgba5551 )
 {
 	uint32_t r = ( (uint32_t)rgba5551        & 0x1F) << 3;
 	uint32_t g = (((uint32_t)rgba5551 >>  5) & 0x1F) << (3+8);
-	uint32_t b = (((uint32_t)rgba5551 >> 11) & 0x1F) << (3+16);
+	uint32_t b = (((uint32_t)rgba5551 >> 10) & 0x1F) << (3+16);
 	uint32_t a = (((uint32_t)rgba5551 >> 15) & 0x01) << (7+24);
 
 	if(r) r |= 0x7;
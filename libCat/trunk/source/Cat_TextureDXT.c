@@ -0,0 +1,469 @@
+//! @file	Cat_TextureDXT.c
+// DXT圧縮テクスチャ関連
+
+// 圧縮はブロックごとの色の範囲(バウンディングボックス)から端点を決める簡易な方式。
+// 品質よりも読み込み時に使える速度を優先している。
+
+#include "Cat_TextureDXT.h"
+#include <pspthreadman.h>
+#include <string.h>
+
+//! 色のブロック(DXT1/DXT3/DXT5共通)
+/*!
+	PSPのGEでは、インデックスが色より前にある。
+*/
+typedef struct {
+	uint32_t	nIndex;				/*!< インデックス(2bit×16ピクセル)	*/
+	uint16_t	nColor0;			/*!< 端点の色0(RGB565)				*/
+	uint16_t	nColor1;			/*!< 端点の色1(RGB565)				*/
+} BlockColor;
+
+//! DXT3のブロック
+typedef struct {
+	BlockColor	color;				/*!< 色							*/
+	uint16_t	nAlpha[4];			/*!< アルファ(4bit×4ピクセル×4ライン)	*/
+} BlockDXT3;
+
+//! DXT5のブロック
+typedef struct {
+	BlockColor	color;				/*!< 色								*/
+	uint32_t	nAlphaIndexLow;		/*!< アルファのインデックス(下位32bit)	*/
+	uint16_t	nAlphaIndexHigh;	/*!< アルファのインデックス(上位16bit)	*/
+	uint8_t		nAlpha0;			/*!< 端点のアルファ0					*/
+	uint8_t		nAlpha1;			/*!< 端点のアルファ1					*/
+} BlockDXT5;
+
+//! 統計情報
+static Cat_TextureDXTStatistics gStatistics;
+
+//! DXT圧縮されたフォーマットかどうか
+/*!
+	@param[in]	ePixelFormat	ピクセルフォーマット
+	@return	DXT1/DXT3/DXT5の場合は0以外を返す
+*/
+int32_t
+Cat_TextureDXTIsFormat( FORMAT_PIXEL ePixelFormat )
+{
+	return Cat_TextureDXTGetBlockSize( ePixelFormat ) ? 1 : 0;
+}
+
+//! 1ブロック(4x4ピクセル)のバイト数を取得する
+/*!
+	@param[in]	ePixelFormat	ピクセルフォーマット(FORMAT_PIXEL_DXTx)
+	@return	1ブロックのバイト数。DXTでない場合は0を返す
+*/
+uint32_t
+Cat_TextureDXTGetBlockSize( FORMAT_PIXEL ePixelFormat )
+{
+	switch(ePixelFormat) {
+		case FORMAT_PIXEL_DXT1:
+			return sizeof(BlockColor);
+		case FORMAT_PIXEL_DXT3:
+			return sizeof(BlockDXT3);
+		case FORMAT_PIXEL_DXT5:
+			return sizeof(BlockDXT5);
+		default:
+			return 0;
+	}
+}
+
+//! イメージに合ったDXTのフォーマットを選ぶ
+/*!
+	アルファが0と255だけならDXT1、それ以外はDXT5を選ぶ。
+	@param[in]	pvImage		RGBA8888のイメージ
+	@param[in]	nWidth		横幅(ピクセル単位)
+	@param[in]	nHeight		高さ(ピクセル単位)
+	@param[in]	nPitch		1ラインのバイト数
+	@return	FORMAT_PIXEL_DXT1 または FORMAT_PIXEL_DXT5
+*/
+FORMAT_PIXEL
+Cat_TextureDXTSelectFormat( const void* pvImage, uint32_t nWidth, uint32_t nHeight, uint32_t nPitch )
+{
+	uint32_t x;
+	uint32_t y;
+
+	if(pvImage == 0) {
+		return FORMAT_PIXEL_DXT1;
+	}
+	for(y = 0; y < nHeight; y++) {
+		const uint32_t* pnLine = (const uint32_t*)((const uint8_t*)pvImage + y * nPitch);
+		for(x = 0; x < nWidth; x++) {
+			const uint32_t a = pnLine[x] >> 24;
+			if((a != 0) && (a != 0xFF)) {
+				// 半透明がある
+				return FORMAT_PIXEL_DXT5;
+			}
+		}
+	}
+	return FORMAT_PIXEL_DXT1;
+}
+
+//! RGB888からRGB565へ変換する
+static uint16_t
+To565( uint32_t r, uint32_t g, uint32_t b )
+{
+	return (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+}
+
+//! RGB565からRGB888へ変換する
+/*!
+	@param[in]	nColor	RGB565の色
+	@param[out]	pnRGB	R,G,Bの順に格納される
+*/
+static void
+From565( uint16_t nColor, uint32_t* pnRGB )
+{
+	const uint32_t r = (nColor >> 11) & 0x1F;
+	const uint32_t g = (nColor >>  5) & 0x3F;
+	const uint32_t b =  nColor        & 0x1F;
+	pnRGB[0] = (r << 3) | (r >> 2);
+	pnRGB[1] = (g << 2) | (g >> 4);
+	pnRGB[2] = (b << 3) | (b >> 2);
+}
+
+//! 端点から色のテーブルを作る
+/*!
+	@param[in]	pBlock		色のブロック
+	@param[in]	bFourColor	0以外の場合は、常に4色モードとして扱う
+	@param[out]	pnTable		R,G,Bが4色分格納される
+	@return	3色+透明モードの場合は0以外を返す
+*/
+static int32_t
+MakeColorTable( const BlockColor* pBlock, int32_t bFourColor, uint32_t* pnTable )
+{
+	uint32_t i;
+
+	From565( pBlock->nColor0, &pnTable[0] );
+	From565( pBlock->nColor1, &pnTable[3] );
+	if(bFourColor || (pBlock->nColor0 > pBlock->nColor1)) {
+		for(i = 0; i < 3; i++) {
+			pnTable[6 + i] = (pnTable[i] * 2 + pnTable[3 + i]    ) / 3;
+			pnTable[9 + i] = (pnTable[i]     + pnTable[3 + i] * 2) / 3;
+		}
+		return 0;
+	}
+	for(i = 0; i < 3; i++) {
+		pnTable[6 + i] = (pnTable[i] + pnTable[3 + i]) / 2;
+		pnTable[9 + i] = 0;
+	}
+	return 1;
+}
+
+//! 4x4ピクセルを取り出す
+/*!
+	イメージの外側は、透明な黒にする。
+*/
+static void
+GetBlock( const uint8_t* pbImage, uint32_t nWidth, uint32_t nHeight, uint32_t nPitch, uint32_t x, uint32_t y, uint32_t* pnBlock )
+{
+	uint32_t i;
+	uint32_t j;
+
+	for(j = 0; j < 4; j++) {
+		if(y + j < nHeight) {
+			const uint32_t* pnLine = (const uint32_t*)(pbImage + (y + j) * nPitch);
+			for(i = 0; i < 4; i++) {
+				pnBlock[i + j * 4] = (x + i < nWidth) ? pnLine[x + i] : 0;
+			}
+		} else {
+			for(i = 0; i < 4; i++) {
+				pnBlock[i + j * 4] = 0;
+			}
+		}
+	}
+}
+
+//! 色を圧縮する
+/*!
+	@param[in]	pnBlock			RGBA8888で16ピクセル
+	@param[out]	pBlock			色のブロック
+	@param[in]	bPunchThrough	0以外の場合は、アルファが128未満のピクセルを透明にする(DXT1)
+*/
+static void
+EncodeColor( const uint32_t* pnBlock, BlockColor* pBlock, int32_t bPunchThrough )
+{
+	uint32_t nMin[3] = { 255, 255, 255 };
+	uint32_t nMax[3] = { 0, 0, 0 };
+	uint32_t nTable[12];
+	uint32_t nTransparent = 0;
+	uint32_t nCount = 0;
+	uint32_t nColors;
+	uint32_t i;
+	uint32_t k;
+
+	for(i = 0; i < 16; i++) {
+		const uint32_t c = pnBlock[i];
+		const uint32_t a = c >> 24;
+		if(bPunchThrough ? (a < 0x80) : (a == 0)) {
+			// 透明なピクセルは範囲に含めない
+			nTransparent |= 1UL << i;
+			continue;
+		}
+		for(k = 0; k < 3; k++) {
+			const uint32_t n = (c >> (k * 8)) & 0xFF;
+			if(n < nMin[k]) nMin[k] = n;
+			if(n > nMax[k]) nMax[k] = n;
+		}
+		nCount++;
+	}
+
+	if(nCount == 0) {
+		// 全部透明
+		pBlock->nColor0 = 0;
+		pBlock->nColor1 = 0;
+		pBlock->nIndex  = bPunchThrough ? 0xFFFFFFFF : 0;
+		return;
+	}
+
+	// 範囲を少し内側に寄せると、中間色の誤差が小さくなる
+	for(k = 0; k < 3; k++) {
+		const uint32_t nInset = (nMax[k] - nMin[k]) >> 4;
+		nMin[k] += nInset;
+		nMax[k] -= nInset;
+	}
+
+	if(bPunchThrough && nTransparent) {
+		// 3色+透明モード(色0 <= 色1)
+		pBlock->nColor0 = To565( nMin[0], nMin[1], nMin[2] );
+		pBlock->nColor1 = To565( nMax[0], nMax[1], nMax[2] );
+		nColors = 3;
+	} else {
+		// 4色モード(色0 > 色1)
+		pBlock->nColor0 = To565( nMax[0], nMax[1], nMax[2] );
+		pBlock->nColor1 = To565( nMin[0], nMin[1], nMin[2] );
+		if(pBlock->nColor0 == pBlock->nColor1) {
+			// 単色
+			pBlock->nIndex = 0;
+			return;
+		}
+		nColors = 4;
+	}
+	MakeColorTable( pBlock, nColors == 4, nTable );
+
+	// 一番近い色を選ぶ
+	pBlock->nIndex = 0;
+	for(i = 0; i < 16; i++) {
+		uint32_t nBest = 0;
+		uint32_t nBestDistance = 0xFFFFFFFF;
+		if(bPunchThrough && (nTransparent & (1UL << i))) {
+			pBlock->nIndex |= 3UL << (i * 2);
+			continue;
+		}
+		for(k = 0; k < nColors; k++) {
+			const int32_t dr = (int32_t)( pnBlock[i]        & 0xFF) - (int32_t)nTable[k * 3 + 0];
+			const int32_t dg = (int32_t)((pnBlock[i] >>  8) & 0xFF) - (int32_t)nTable[k * 3 + 1];
+			const int32_t db = (int32_t)((pnBlock[i] >> 16) & 0xFF) - (int32_t)nTable[k * 3 + 2];
+			const uint32_t nDistance = (uint32_t)(dr * dr + dg * dg + db * db);
+			if(nDistance < nBestDistance) {
+				nBestDistance = nDistance;
+				nBest = k;
+			}
+		}
+		pBlock->nIndex |= nBest << (i * 2);
+	}
+}
+
+//! アルファを圧縮する(DXT3)
+static void
+EncodeAlphaDXT3( const uint32_t* pnBlock, BlockDXT3* pBlock )
+{
+	uint32_t i;
+	uint32_t j;
+
+	for(j = 0; j < 4; j++) {
+		uint32_t nLine = 0;
+		for(i = 0; i < 4; i++) {
+			const uint32_t a = pnBlock[i + j * 4] >> 24;
+			nLine |= ((a * 15 + 127) / 255) << (i * 4);
+		}
+		pBlock->nAlpha[j] = (uint16_t)nLine;
+	}
+}
+
+//! アルファを圧縮する(DXT5)
+static void
+EncodeAlphaDXT5( const uint32_t* pnBlock, BlockDXT5* pBlock )
+{
+	uint32_t nMin = 255;
+	uint32_t nMax = 0;
+	uint32_t nRange;
+	uint64_t nIndex = 0;
+	uint32_t i;
+
+	for(i = 0; i < 16; i++) {
+		const uint32_t a = pnBlock[i] >> 24;
+		if(a < nMin) nMin = a;
+		if(a > nMax) nMax = a;
+	}
+	pBlock->nAlpha0 = (uint8_t)nMax;
+	pBlock->nAlpha1 = (uint8_t)nMin;
+	if(nMax != nMin) {
+		// 8段階モード(アルファ0 > アルファ1)
+		nRange = nMax - nMin;
+		for(i = 0; i < 16; i++) {
+			const uint32_t a = pnBlock[i] >> 24;
+			const uint32_t t = ((nMax - a) * 7 + nRange / 2) / nRange;	// 0:アルファ0 〜 7:アルファ1
+			const uint32_t n = (t == 0) ? 0 : ((t == 7) ? 1 : t + 1);
+			nIndex |= (uint64_t)n << (i * 3);
+		}
+	}
+	pBlock->nAlphaIndexLow  = (uint32_t)nIndex;
+	pBlock->nAlphaIndexHigh = (uint16_t)(nIndex >> 32);
+}
+
+//! RGBA8888のイメージをDXT圧縮する
+/*!
+	ブロックの並びはPSPのGEの形式(色のブロックが先、アルファが後)。 \n
+	イメージの外側にはみ出したピクセルは、透明な黒として扱う。
+	@param[in]	pvImage			RGBA8888のイメージ
+	@param[in]	nWidth			横幅(ピクセル単位)
+	@param[in]	nHeight			高さ(ピクセル単位)
+	@param[in]	nPitch			1ラインのバイト数
+	@param[out]	pvDest			出力先
+	@param[in]	nDestPitch		出力先のピッチ(ブロック1列のバイト数の1/4。Cat_TextureのnPitchと同じ)
+	@param[in]	ePixelFormat	圧縮するフォーマット(FORMAT_PIXEL_DXTx)
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+int32_t
+Cat_TextureDXTEncode( const void* pvImage, uint32_t nWidth, uint32_t nHeight, uint32_t nPitch, void* pvDest, uint32_t nDestPitch, FORMAT_PIXEL ePixelFormat )
+{
+	const uint32_t nBlockSize = Cat_TextureDXTGetBlockSize( ePixelFormat );
+	const uint32_t nBlockCountX = (nWidth  + 3) / 4;
+	const uint32_t nBlockCountY = (nHeight + 3) / 4;
+	uint32_t nStart;
+	uint32_t nBlock[16];
+	uint32_t x;
+	uint32_t y;
+
+	if((pvImage == 0) || (pvDest == 0) || (nBlockSize == 0)) {
+		return -1;
+	}
+	if(nDestPitch * 4 < nBlockCountX * nBlockSize) {
+		return -1;	// 出力先が狭い
+	}
+
+	nStart = sceKernelGetSystemTimeLow();
+	for(y = 0; y < nHeight; y += 4) {
+		uint8_t* pbDest = (uint8_t*)pvDest + y * nDestPitch;
+		for(x = 0; x < nWidth; x += 4) {
+			GetBlock( (const uint8_t*)pvImage, nWidth, nHeight, nPitch, x, y, nBlock );
+			switch(ePixelFormat) {
+				case FORMAT_PIXEL_DXT1:
+					{
+						BlockColor block;
+						EncodeColor( nBlock, &block, 1 );
+						memcpy( pbDest, &block, sizeof(block) );
+					}
+					break;
+				case FORMAT_PIXEL_DXT3:
+					{
+						BlockDXT3 block;
+						EncodeColor( nBlock, &block.color, 0 );
+						EncodeAlphaDXT3( nBlock, &block );
+						memcpy( pbDest, &block, sizeof(block) );
+					}
+					break;
+				case FORMAT_PIXEL_DXT5:
+				default:
+					{
+						BlockDXT5 block;
+						EncodeColor( nBlock, &block.color, 0 );
+						EncodeAlphaDXT5( nBlock, &block );
+						memcpy( pbDest, &block, sizeof(block) );
+					}
+					break;
+			}
+			pbDest += nBlockSize;
+		}
+	}
+
+	// 統計情報
+	gStatistics.nEncodeTime += sceKernelGetSystemTimeLow() - nStart;
+	gStatistics.nEncodeCount++;
+	if(ePixelFormat == FORMAT_PIXEL_DXT1) {
+		gStatistics.nDXT1Count++;
+	} else if(ePixelFormat == FORMAT_PIXEL_DXT3) {
+		gStatistics.nDXT3Count++;
+	} else {
+		gStatistics.nDXT5Count++;
+	}
+	gStatistics.nPixelCount  += nWidth * nHeight;
+	gStatistics.nSourceSize  += nWidth * nHeight * 4;
+	gStatistics.nEncodedSize += nBlockCountX * nBlockCountY * nBlockSize;
+	return 0;
+}
+
+//! 1ブロックを展開する
+/*!
+	@param[in]	pvBlock			ブロック
+	@param[in]	ePixelFormat	フォーマット(FORMAT_PIXEL_DXTx)
+	@param[out]	pnDest			RGBA8888で16ピクセル(左上から横方向の順)
+*/
+void
+Cat_TextureDXTDecodeBlock( const void* pvBlock, FORMAT_PIXEL ePixelFormat, uint32_t* pnDest )
+{
+	BlockDXT5 block;	// 一番大きいブロック
+	uint32_t nTable[12];
+	uint32_t nAlpha[8];
+	int32_t bTransparent;
+	uint32_t i;
+
+	memcpy( &block, pvBlock, Cat_TextureDXTGetBlockSize( ePixelFormat ) );
+
+	// DXT3/DXT5は常に4色モード
+	bTransparent = MakeColorTable( &block.color, ePixelFormat != FORMAT_PIXEL_DXT1, nTable );
+	for(i = 0; i < 16; i++) {
+		const uint32_t n = (block.color.nIndex >> (i * 2)) & 3;
+		pnDest[i] = nTable[n * 3] | (nTable[n * 3 + 1] << 8) | (nTable[n * 3 + 2] << 16);
+		if(!bTransparent || (n != 3)) {
+			pnDest[i] |= 0xFF000000;
+		}
+	}
+
+	if(ePixelFormat == FORMAT_PIXEL_DXT3) {
+		const BlockDXT3* pBlock = (const BlockDXT3*)&block;
+		for(i = 0; i < 16; i++) {
+			const uint32_t a = (pBlock->nAlpha[i / 4] >> ((i & 3) * 4)) & 0xF;
+			pnDest[i] = (pnDest[i] & 0x00FFFFFF) | ((a * 17) << 24);
+		}
+	} else if(ePixelFormat == FORMAT_PIXEL_DXT5) {
+		const uint64_t nIndex = ((uint64_t)block.nAlphaIndexHigh << 32) | block.nAlphaIndexLow;
+		nAlpha[0] = block.nAlpha0;
+		nAlpha[1] = block.nAlpha1;
+		if(nAlpha[0] > nAlpha[1]) {
+			for(i = 1; i < 7; i++) {
+				nAlpha[i + 1] = ((7 - i) * nAlpha[0] + i * nAlpha[1]) / 7;
+			}
+		} else {
+			for(i = 1; i < 5; i++) {
+				nAlpha[i + 1] = ((5 - i) * nAlpha[0] + i * nAlpha[1]) / 5;
+			}
+			nAlpha[6] = 0;
+			nAlpha[7] = 255;
+		}
+		for(i = 0; i < 16; i++) {
+			const uint32_t a = nAlpha[(nIndex >> (i * 3)) & 7];
+			pnDest[i] = (pnDest[i] & 0x00FFFFFF) | (a << 24);
+		}
+	}
+}
+
+//! 統計情報を取得する
+/*!
+	@param[out]	pStatistics		統計情報
+*/
+void
+Cat_TextureDXTGetStatistics( Cat_TextureDXTStatistics* pStatistics )
+{
+	if(pStatistics) {
+		*pStatistics = gStatistics;
+	}
+}
+
+//! 統計情報をクリアする
+void
+Cat_TextureDXTResetStatistics( void )
+{
+	memset( &gStatistics, 0, sizeof(gStatistics) );
+}
@@ -0,0 +1,619 @@
+//! @file	Cat_Vram.c
+// VRAMの領域管理
+//
+// PSPの関数は使わずに、VRAMの操作はCat_VramBackendを通して行う。
+
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>	// for memalign
+#include "Cat_Vram.h"
+
+#ifndef CAT_MALLOC
+//! メモリ確保マクロ
+#define CAT_MALLOC(x) memalign( 32, (x) )
+#endif // CAT_MALLOC
+
+#ifndef CAT_FREE
+//! メモリ解放マクロ
+#define CAT_FREE(x) free( x )
+#endif // CAT_FREE
+
+//! 使用頻度の減衰(1回の更新で1/2^nずつ減る)
+#define CAT_VRAM_SCORE_DECAY (3)
+//! 使用1回あたりの使用頻度
+#define CAT_VRAM_SCORE_UNIT (256)
+//! VRAMに置く使用頻度の下限(1回だけ使われたものは置かない)
+#define CAT_VRAM_SCORE_PROMOTE (CAT_VRAM_SCORE_UNIT + CAT_VRAM_SCORE_UNIT / 2)
+
+//! VRAMの領域管理
+struct _Cat_Vram {
+	Cat_VramBackend		backend;			/*!< VRAMの操作							*/
+	uint32_t			nSize;				/*!< 管理しているサイズ					*/
+	uint32_t			nBudget;			/*!< 常駐させる上限						*/
+	uint32_t			nUploadLimit;		/*!< 1回の更新で転送する上限			*/
+	uint32_t			nResidentBytes;		/*!< 常駐しているサイズ					*/
+	uint32_t			nResidentCount;		/*!< 常駐しているリソース数				*/
+	uint32_t			nPendingBytes;		/*!< 解放待ちのサイズ					*/
+	uint32_t			nPendingCount;		/*!< 解放待ちの領域数					*/
+	uint32_t			nRegisteredCount;	/*!< 登録されているリソース数			*/
+	uint32_t			nUpdate;			/*!< 更新の番号(統計情報と違って戻さない)	*/
+	Cat_VramBlock*		pBlock;				/*!< 確保済み領域(アドレス順)			*/
+	Cat_VramResource*	pResource;			/*!< 登録されているリソース				*/
+	Cat_VramBlock*		pPendingFree;		/*!< 未使用の解放待ち領域				*/
+	Cat_VramResource**	ppSort;				/*!< 使用頻度で並べる作業領域			*/
+	uint32_t			nSortCapacity;		/*!< 作業領域の要素数					*/
+	Cat_VramStatistics	statistics;			/*!< 統計情報(回数のみ)					*/
+	Cat_VramBlock		pending[CAT_VRAM_PENDING_MAX];	/*!< 解放待ち領域			*/
+};
+
+//! 領域をアドレス順に挿入する
+static void
+LinkBlock( Cat_Vram* pVram, Cat_VramBlock* pBlock )
+{
+	Cat_VramBlock** ppLink = &pVram->pBlock;
+
+	while(*ppLink && ((*ppLink)->nOffset < pBlock->nOffset)) {
+		ppLink = &(*ppLink)->pNext;
+	}
+	pBlock->pNext = *ppLink;
+	*ppLink = pBlock;
+}
+
+//! 領域を差し替える
+/*!
+	@param[in]	pVram	領域管理
+	@param[in]	pOld	リストにある領域
+	@param[in]	pNew	代わりに入れる領域(0の場合は取り除くだけ)
+*/
+static void
+ReplaceBlock( Cat_Vram* pVram, Cat_VramBlock* pOld, Cat_VramBlock* pNew )
+{
+	Cat_VramBlock** ppLink = &pVram->pBlock;
+
+	while(*ppLink && (*ppLink != pOld)) {
+		ppLink = &(*ppLink)->pNext;
+	}
+	if(*ppLink) {
+		if(pNew) {
+			pNew->pNext = pOld->pNext;
+			*ppLink = pNew;
+		} else {
+			*ppLink = pOld->pNext;
+		}
+		pOld->pNext = 0;
+	}
+}
+
+//! 解放待ちの領域を解放する
+/*!
+	GEが解放待ちの領域を参照していない時に呼ぶこと。
+*/
+static void
+Collect( Cat_Vram* pVram )
+{
+	Cat_VramBlock** ppLink = &pVram->pBlock;
+
+	while(*ppLink) {
+		Cat_VramBlock* pBlock = *ppLink;
+		if(pBlock->pResource == 0) {
+			*ppLink = pBlock->pNext;
+			pBlock->pNext = pVram->pPendingFree;
+			pVram->pPendingFree = pBlock;
+		} else {
+			ppLink = &pBlock->pNext;
+		}
+	}
+	pVram->nPendingBytes = 0;
+	pVram->nPendingCount = 0;
+}
+
+//! 空き領域を探す
+/*!
+	先頭から探して最初に入る場所にする。
+	@param[in]	pVram		領域管理
+	@param[in]	nSize		サイズ(バイト単位)
+	@param[out]	pnOffset	見つかったオフセット
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+static int32_t
+Alloc( Cat_Vram* pVram, uint32_t nSize, uint32_t* pnOffset )
+{
+	Cat_VramBlock* pBlock;
+	uint32_t nCursor = 0;
+
+	for(pBlock = pVram->pBlock; pBlock; pBlock = pBlock->pNext) {
+		if(pBlock->nOffset - nCursor >= nSize) {
+			break;
+		}
+		nCursor = pBlock->nOffset + pBlock->nSize;
+	}
+	if((pBlock == 0) && (pVram->nSize - nCursor < nSize)) {
+		return -1;
+	}
+	*pnOffset = nCursor;
+	return 0;
+}
+
+//! VRAMから追い出す
+/*!
+	領域は解放待ちにして、次の更新で解放する。 \n
+	作成途中のパケットから呼ばれることもあるので、ここでは描画の終わりを待たない。 \n
+	常駐数と解放待ちの数の合計をCAT_VRAM_PENDING_MAX以下にしているので、解放待ちは必ず空いている。
+*/
+static void
+Evict( Cat_Vram* pVram, Cat_VramResource* pResource )
+{
+	Cat_VramBlock* pPending = pVram->pPendingFree;
+
+	// 同じ場所を解放待ちにする
+	pVram->pPendingFree = pPending->pNext;
+	pPending->pResource = 0;
+	pPending->nOffset   = pResource->block.nOffset;
+	pPending->nSize     = pResource->block.nSize;
+	ReplaceBlock( pVram, &pResource->block, pPending );
+	pVram->nPendingBytes += pPending->nSize;
+	pVram->nPendingCount++;
+	pVram->nResidentBytes -= pResource->block.nSize;
+	pVram->nResidentCount--;
+	pResource->fResident = 0;
+	pResource->nEvictUpdate = pVram->nUpdate;
+	pVram->statistics.nEvictCount++;
+}
+
+//! VRAMに置く
+static void
+Promote( Cat_Vram* pVram, Cat_VramResource* pResource, uint32_t nOffset )
+{
+	pResource->block.pResource = pResource;
+	pResource->block.nOffset   = nOffset;
+	pResource->block.nSize     = pResource->nSize;
+	LinkBlock( pVram, &pResource->block );
+	pVram->backend.Upload( pVram->backend.pvContext, nOffset, pResource->pvSource, pResource->nSize );
+	pResource->fResident = 1;
+	pVram->nResidentBytes += pResource->nSize;
+	pVram->nResidentCount++;
+	pVram->statistics.nPromoteCount++;
+	pVram->statistics.nUploadBytes += pResource->nSize;
+}
+
+//! 追い出してもよいか
+/*!
+	入れ替えを繰り返さないように、使用頻度が十分に低い場合だけ追い出す。
+	@param[in]	pVictim		追い出すリソース
+	@param[in]	pResource	置きたいリソース
+*/
+static int32_t
+IsColder( const Cat_VramResource* pVictim, const Cat_VramResource* pResource )
+{
+	return pVictim->fResident && ((pVictim->nScore + (pVictim->nScore >> 2)) < pResource->nScore);
+}
+
+//! 使用頻度の高い順に並べる比較関数
+static int
+CompareScore( const void* pv1, const void* pv2 )
+{
+	const Cat_VramResource* p1 = *(const Cat_VramResource* const*)pv1;
+	const Cat_VramResource* p2 = *(const Cat_VramResource* const*)pv2;
+
+	if(p1->nScore != p2->nScore) {
+		return (p1->nScore > p2->nScore) ? -1 : 1;
+	}
+	if(p1->fResident != p2->fResident) {
+		return p1->fResident ? -1 : 1;	// 同じなら常駐している方を残す
+	}
+	return 0;
+}
+
+//! VRAMの領域管理を作成する
+/*!
+	@param[in]	nSize		管理するサイズ(バイト単位)
+	@param[in]	pBackend	VRAMの操作(複製して保持する)
+	@return	作成された領域管理。失敗した場合は0が返る。
+	@see	Cat_VramDestroy()
+*/
+Cat_Vram*
+Cat_VramCreate( uint32_t nSize, const Cat_VramBackend* pBackend )
+{
+	Cat_Vram* rc;
+	uint32_t i;
+
+	if(pBackend == 0) {
+		return 0;
+	}
+	rc = (Cat_Vram*)CAT_MALLOC( sizeof(Cat_Vram) );
+	if(rc == 0) {
+		return 0;
+	}
+	memset( rc, 0, sizeof(Cat_Vram) );
+	rc->backend = *pBackend;
+	rc->nSize   = nSize & ~(CAT_VRAM_ALIGN - 1);
+	rc->nBudget = rc->nSize;
+	for(i = 0; i < CAT_VRAM_PENDING_MAX; i++) {
+		rc->pending[i].pNext = rc->pPendingFree;
+		rc->pPendingFree = &rc->pending[i];
+	}
+	return rc;
+}
+
+//! 擬似VRAMへ転送する
+static void
+Simulator_Upload( void* pvContext, uint32_t nOffset, const void* pvSource, uint32_t nSize )
+{
+	memcpy( (uint8_t*)pvContext + nOffset, pvSource, nSize );
+}
+
+//! 擬似VRAM内で移動する
+static void
+Simulator_Move( void* pvContext, uint32_t nDest, uint32_t nSrc, uint32_t nSize )
+{
+	memmove( (uint8_t*)pvContext + nDest, (uint8_t*)pvContext + nSrc, nSize );
+}
+
+//! 擬似VRAMのアドレスを取得する
+static void*
+Simulator_GetAddress( void* pvContext, uint32_t nOffset )
+{
+	return (uint8_t*)pvContext + nOffset;
+}
+
+//! 擬似VRAMは描画しないので何もしない
+static void
+Simulator_Sync( void* pvContext )
+{
+}
+
+//! 擬似VRAMを解放する
+static void
+Simulator_Close( void* pvContext )
+{
+	CAT_FREE( pvContext );
+}
+
+//! メインメモリを擬似VRAMにした領域管理を作成する
+/*!
+	PSPに依存しないので、ホストで配置の方針や統計情報を確認するのに使う。
+	@param[in]	nSize		管理するサイズ(バイト単位)
+	@return	作成された領域管理。失敗した場合は0が返る。
+	@see	Cat_VramDestroy()
+*/
+Cat_Vram*
+Cat_VramCreateSimulator( uint32_t nSize )
+{
+	Cat_VramBackend backend;
+	Cat_Vram* rc;
+
+	backend.Upload     = Simulator_Upload;
+	backend.Move       = Simulator_Move;
+	backend.GetAddress = Simulator_GetAddress;
+	backend.Sync       = Simulator_Sync;
+	backend.Close      = Simulator_Close;
+	backend.pvContext  = CAT_MALLOC( nSize );
+	if(backend.pvContext == 0) {
+		return 0;
+	}
+	rc = Cat_VramCreate( nSize, &backend );
+	if(rc == 0) {
+		CAT_FREE( backend.pvContext );
+	}
+	return rc;
+}
+
+//! VRAMの領域管理を破棄する
+/*!
+	登録されているリソースは、すべて登録が解除される。
+	@param[in]	pVram	領域管理
+*/
+void
+Cat_VramDestroy( Cat_Vram* pVram )
+{
+	Cat_VramResource* pResource;
+
+	if(pVram == 0) {
+		return;
+	}
+	pVram->backend.Sync( pVram->backend.pvContext );
+	pResource = pVram->pResource;
+	while(pResource) {
+		Cat_VramResource* pNext = pResource->pNext;
+		pResource->pVram     = 0;
+		pResource->pPrev     = 0;
+		pResource->pNext     = 0;
+		pResource->fResident = 0;
+		pResource->nScore    = 0;
+		pResource->block.pNext = 0;
+		pResource = pNext;
+	}
+	if(pVram->backend.Close) {
+		pVram->backend.Close( pVram->backend.pvContext );
+	}
+	if(pVram->ppSort) {
+		CAT_FREE( pVram->ppSort );
+	}
+	CAT_FREE( pVram );
+}
+
+//! 常駐させる上限を設定する
+/*!
+	@param[in]	pVram		領域管理
+	@param[in]	nBudget		上限(バイト単位)。管理しているサイズを超える場合は、管理しているサイズになる。
+*/
+void
+Cat_VramSetBudget( Cat_Vram* pVram, uint32_t nBudget )
+{
+	if(pVram) {
+		pVram->nBudget = (nBudget < pVram->nSize) ? nBudget : pVram->nSize;
+	}
+}
+
+//! 1回の更新で転送する上限を設定する
+/*!
+	@param[in]	pVram		領域管理
+	@param[in]	nLimit		上限(バイト単位)。0の場合は制限しない。
+*/
+void
+Cat_VramSetUploadLimit( Cat_Vram* pVram, uint32_t nLimit )
+{
+	if(pVram) {
+		pVram->nUploadLimit = nLimit;
+	}
+}
+
+//! リソースを初期化する
+/*!
+	データを差し替える場合は、Cat_VramResourceRemove()してから呼ぶこと。
+	@param[out]	pResource	リソース
+	@param[in]	pvSource	メインメモリのデータ
+	@param[in]	nSize		サイズ(バイト単位)
+*/
+void
+Cat_VramResourceInit( Cat_VramResource* pResource, const void* pvSource, uint32_t nSize )
+{
+	memset( pResource, 0, sizeof(Cat_VramResource) );
+	pResource->pvSource = pvSource;
+	pResource->nSize    = (nSize + CAT_VRAM_ALIGN - 1) & ~(CAT_VRAM_ALIGN - 1);
+}
+
+//! リソースの登録を解除する
+/*!
+	VRAMに置かれていた領域は、次のCat_VramUpdate()まで解放されない。
+	@param[in]	pResource	リソース
+*/
+void
+Cat_VramResourceRemove( Cat_VramResource* pResource )
+{
+	Cat_Vram* pVram;
+
+	if((pResource == 0) || (pResource->pVram == 0)) {
+		return;
+	}
+	pVram = pResource->pVram;
+	if(pResource->fResident) {
+		Evict( pVram, pResource );
+	}
+	if(pResource->pPrev) {
+		pResource->pPrev->pNext = pResource->pNext;
+	} else {
+		pVram->pResource = pResource->pNext;
+	}
+	if(pResource->pNext) {
+		pResource->pNext->pPrev = pResource->pPrev;
+	}
+	pVram->nRegisteredCount--;
+	pResource->pVram     = 0;
+	pResource->pPrev     = 0;
+	pResource->pNext     = 0;
+	pResource->nUseCount = 0;
+	pResource->nScore    = 0;
+}
+
+//! リソースを使う
+/*!
+	使用回数を数える。登録されていなければ登録する。
+	@param[in]	pVram		領域管理
+	@param[in]	pResource	リソース
+	@return	VRAMに置かれている場合は、GEに渡すアドレス。置かれていない場合は0が返る。
+*/
+void*
+Cat_VramTouch( Cat_Vram* pVram, Cat_VramResource* pResource )
+{
+	if((pVram == 0) || (pResource == 0) || (pResource->pvSource == 0)) {
+		return 0;
+	}
+	if(pResource->pVram != pVram) {
+		// 登録
+		Cat_VramResourceRemove( pResource );
+		pResource->pVram = pVram;
+		pResource->pPrev = 0;
+		pResource->pNext = pVram->pResource;
+		if(pVram->pResource) {
+			pVram->pResource->pPrev = pResource;
+		}
+		pVram->pResource = pResource;
+		pVram->nRegisteredCount++;
+	}
+	pResource->nUseCount++;
+	pVram->statistics.nTouchCount++;
+	if(pResource->fResident) {
+		pVram->statistics.nHitCount++;
+		return pVram->backend.GetAddress( pVram->backend.pvContext, pResource->block.nOffset );
+	}
+	return 0;
+}
+
+//! 配置を更新する
+/*!
+	1フレームに1回、描画パケットをGEに渡した後に呼ぶ。 \n
+	前回追い出した領域を解放してから、使用頻度の高いリソースを上限までVRAMに置く。 \n
+	空きが足りない場合は、使用頻度の低いリソースを追い出す。 \n
+	追い出した領域は、描画中のパケットが参照しているかもしれないので次回まで解放しない。 \n
+	常駐数と解放待ちの数の合計がCAT_VRAM_PENDING_MAXに達している場合は、次回まで置かない。
+	@param[in]	pVram	領域管理
+*/
+void
+Cat_VramUpdate( Cat_Vram* pVram )
+{
+	Cat_VramResource* pResource;
+	uint32_t nCount = 0;
+	uint32_t nUpload = 0;
+	uint32_t i;
+
+	if(pVram == 0) {
+		return;
+	}
+	pVram->statistics.nUpdateCount++;
+	pVram->nUpdate++;
+
+	// 前回追い出した領域は、渡し終わったパケットからしか参照されていない
+	Collect( pVram );
+
+	// 作業領域の確保
+	if(pVram->nSortCapacity < pVram->nRegisteredCount) {
+		const uint32_t nCapacity = (pVram->nRegisteredCount + 63) & ~63;
+		Cat_VramResource** ppSort = (Cat_VramResource**)CAT_MALLOC( sizeof(Cat_VramResource*) * nCapacity );
+		if(ppSort == 0) {
+			return;
+		}
+		if(pVram->ppSort) {
+			CAT_FREE( pVram->ppSort );
+		}
+		pVram->ppSort = ppSort;
+		pVram->nSortCapacity = nCapacity;
+	}
+
+	// 使用頻度を更新して、高い順に並べる
+	for(pResource = pVram->pResource; pResource; pResource = pResource->pNext) {
+		pResource->nScore = pResource->nScore - (pResource->nScore >> CAT_VRAM_SCORE_DECAY) + pResource->nUseCount * CAT_VRAM_SCORE_UNIT;
+		pResource->nUseCount = 0;
+		pVram->ppSort[nCount++] = pResource;
+	}
+	qsort( pVram->ppSort, nCount, sizeof(Cat_VramResource*), CompareScore );
+
+	for(i = 0; i < nCount; i++) {
+		uint32_t nOffset;
+		uint32_t j;
+
+		pResource = pVram->ppSort[i];
+		if(pResource->nScore < CAT_VRAM_SCORE_PROMOTE) {
+			break;	// 以降はあまり使われていない
+		}
+		if(pResource->fResident || (pResource->nSize > pVram->nBudget)) {
+			continue;
+		}
+		if(pResource->nEvictUpdate == pVram->nUpdate) {
+			continue;	// この更新で追い出したものを置き直すと、転送が無駄になる
+		}
+		if(pVram->nUploadLimit && (nUpload + pResource->nSize > pVram->nUploadLimit)) {
+			continue;
+		}
+		if(pVram->nResidentCount + pVram->nPendingCount >= CAT_VRAM_PENDING_MAX) {
+			// 置いたものを追い出す時の解放待ちが足りなくなるので、次回の解放を待つ
+			// (追い出しても合計は変わらない)
+			break;
+		}
+
+		if(pVram->nResidentBytes + pResource->nSize > pVram->nBudget) {
+			// 使用頻度の低い方から追い出して、上限に収まるか
+			const uint32_t nNeed = pVram->nResidentBytes + pResource->nSize - pVram->nBudget;
+			uint32_t nFree = 0;
+			for(j = nCount; (j-- > i + 1) && (nFree < nNeed);) {
+				if(IsColder( pVram->ppSort[j], pResource )) {
+					nFree += pVram->ppSort[j]->nSize;
+				}
+			}
+			if(nFree < nNeed) {
+				continue;
+			}
+			for(j = nCount; (j-- > i + 1) && (pVram->nResidentBytes + pResource->nSize > pVram->nBudget);) {
+				if(IsColder( pVram->ppSort[j], pResource )) {
+					Evict( pVram, pVram->ppSort[j] );
+				}
+			}
+		}
+
+		if(Alloc( pVram, pResource->nSize, &nOffset ) < 0) {
+			if((pVram->nPendingBytes == 0) && (pVram->nSize - pVram->nResidentBytes >= pResource->nSize)) {
+				pVram->statistics.nFragmentCount++;
+			}
+			continue;	// 解放待ちがあれば次回に置ける
+		}
+		Promote( pVram, pResource, nOffset );
+		nUpload += pResource->nSize;
+	}
+}
+
+//! 断片化を解消する
+/*!
+	GEの描画が終わるのを待ってから、常駐しているリソースを前に詰める。 \n
+	作成途中の描画パケットがあると、移動前のアドレスを参照してしまうので \n
+	ラウンドの切り替えなど、Cat_RenderScreenUpdate()の後で次のCat_RenderBegin()の前に呼ぶこと。
+	@param[in]	pVram	領域管理
+*/
+void
+Cat_VramDefragment( Cat_Vram* pVram )
+{
+	Cat_VramBlock* pBlock;
+	uint32_t nCursor = 0;
+
+	if(pVram == 0) {
+		return;
+	}
+	pVram->backend.Sync( pVram->backend.pvContext );
+	Collect( pVram );
+
+	for(pBlock = pVram->pBlock; pBlock; pBlock = pBlock->pNext) {
+		if(pBlock->nOffset != nCursor) {
+			pVram->backend.Move( pVram->backend.pvContext, nCursor, pBlock->nOffset, pBlock->nSize );
+			pVram->statistics.nDefragmentBytes += pBlock->nSize;
+			pBlock->nOffset = nCursor;
+		}
+		nCursor += pBlock->nSize;
+	}
+	pVram->statistics.nDefragmentCount++;
+}
+
+//! 統計情報を取得する
+/*!
+	@param[in]	pVram			領域管理
+	@param[out]	pStatistics		統計情報
+*/
+void
+Cat_VramGetStatistics( Cat_Vram* pVram, Cat_VramStatistics* pStatistics )
+{
+	Cat_VramBlock* pBlock;
+	uint32_t nCursor = 0;
+
+	if((pVram == 0) || (pStatistics == 0)) {
+		return;
+	}
+	*pStatistics = pVram->statistics;
+	pStatistics->nSize            = pVram->nSize;
+	pStatistics->nBudget          = pVram->nBudget;
+	pStatistics->nResidentBytes   = pVram->nResidentBytes;
+	pStatistics->nResidentCount   = pVram->nResidentCount;
+	pStatistics->nPendingBytes    = pVram->nPendingBytes;
+	pStatistics->nRegisteredCount = pVram->nRegisteredCount;
+	pStatistics->nFreeBytes       = pVram->nSize - pVram->nResidentBytes - pVram->nPendingBytes;
+	pStatistics->nLargestFree     = 0;
+	for(pBlock = pVram->pBlock; pBlock; pBlock = pBlock->pNext) {
+		if(pBlock->nOffset - nCursor > pStatistics->nLargestFree) {
+			pStatistics->nLargestFree = pBlock->nOffset - nCursor;
+		}
+		nCursor = pBlock->nOffset + pBlock->nSize;
+	}
+	if(pVram->nSize - nCursor > pStatistics->nLargestFree) {
+		pStatistics->nLargestFree = pVram->nSize - nCursor;
+	}
+}
+
+//! 統計情報の回数をクリアする
+/*!
+	@param[in]	pVram	領域管理
+*/
+void
+Cat_VramResetStatistics( Cat_Vram* pVram )
+{
+	if(pVram) {
+		memset( &pVram->statistics, 0, sizeof(Cat_VramStatistics) );
+	}
+}
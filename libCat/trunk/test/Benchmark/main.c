@@ -0,0 +1,687 @@
+// Cat_Benchmark test code
+// libCatの処理速度を計測する
+//
+
+#include "Cat_PspCallback.h"
+#include "Cat_Texture.h"
+#include "Cat_TextureDXT.h"
+#include "Cat_ColorConvert.h"
+#include "Cat_Vram.h"
+#include "Cat_PaletteEffect.h"
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+#include <pspdebug.h>
+#include <pspkernel.h>
+#include <pspthreadman.h>
+
+#define TRACE(x) pspDebugScreenPrintf x
+#define HALT() sceKernelSleepThreadCB()
+
+//! 計測用のテクスチャのサイズ
+#define BENCH_WIDTH  (256)
+#define BENCH_HEIGHT (256)
+
+//! 計測用のテクスチャを作成する
+static Cat_Texture*
+CreateBenchTexture( FORMAT_PIXEL ePixelFormat )
+{
+	const uint32_t nBits = (ePixelFormat == FORMAT_PIXEL_8888) ? 32 : ((ePixelFormat == FORMAT_PIXEL_CLUT8) ? 8 : 16);
+	const uint32_t nPitch = BENCH_WIDTH * nBits / 8;
+	Cat_Palette* pPalette = 0;
+	Cat_Texture* pTexture;
+	uint8_t* pbImage;
+	uint32_t i;
+
+	pbImage = (uint8_t*)malloc( nPitch * BENCH_HEIGHT );
+	if(pbImage == 0) {
+		return 0;
+	}
+	for(i = 0; i < nPitch * BENCH_HEIGHT; i++) {
+		pbImage[i] = (uint8_t)(rand() >> 4);
+	}
+	if(ePixelFormat == FORMAT_PIXEL_CLUT8) {
+		pPalette = Cat_PaletteCreate( FORMAT_PALETTE_5551, 256, pbImage );
+	}
+	pTexture = Cat_TextureCreate( BENCH_WIDTH, BENCH_HEIGHT, nPitch, pbImage, ePixelFormat, pPalette );
+	Cat_PaletteRelease( pPalette );
+	free( pbImage );
+	return pTexture;
+}
+
+//! Cat_TextureGetRegion()とCat_TextureGetPixel()を比較する
+static void
+BenchTextureGetRegion( void )
+{
+	static const FORMAT_PIXEL eFormat[] = { FORMAT_PIXEL_8888, FORMAT_PIXEL_5551, FORMAT_PIXEL_CLUT8 };
+	static const char* pszFormat[] = { "8888 ", "5551 ", "CLUT8" };
+	uint32_t* pnDest;
+	uint32_t i;
+
+	TRACE(( "-- Cat_TextureGetRegion %dx%d RGBA8888\n", BENCH_WIDTH, BENCH_HEIGHT ));
+	pnDest = (uint32_t*)memalign( 64, BENCH_WIDTH * BENCH_HEIGHT * 4 );
+	if(pnDest == 0) {
+		TRACE(( "Error:memalign\n" ));
+		return;
+	}
+	for(i = 0; i < sizeof(eFormat) / sizeof(eFormat[0]); i++) {
+		Cat_Texture* pTexture = CreateBenchTexture( eFormat[i] );
+		uint64_t nStart;
+		uint32_t nPixelTime;
+		uint32_t nRegionTime;
+		uint32_t x;
+		uint32_t y;
+		if(pTexture == 0) {
+			TRACE(( "Error:Cat_TextureCreate\n" ));
+			continue;
+		}
+
+		// 1ピクセルずつ
+		nStart = sceKernelGetSystemTimeWide();
+		for(y = 0; y < BENCH_HEIGHT; y++) {
+			for(x = 0; x < BENCH_WIDTH; x++) {
+				pnDest[x + y * BENCH_WIDTH] = Cat_TextureGetPixel( pTexture, x, y );
+			}
+		}
+		nPixelTime = (uint32_t)(sceKernelGetSystemTimeWide() - nStart);
+
+		// 領域でまとめて
+		nStart = sceKernelGetSystemTimeWide();
+		Cat_TextureGetRegion( pTexture, 0, 0, BENCH_WIDTH, BENCH_HEIGHT, pnDest, BENCH_WIDTH * 4, CAT_TEXTURE_REGION_8888 );
+		nRegionTime = (uint32_t)(sceKernelGetSystemTimeWide() - nStart);
+
+		// 結果が同じか確認する
+		for(y = 0; y < BENCH_HEIGHT; y++) {
+			for(x = 0; x < BENCH_WIDTH; x++) {
+				if(pnDest[x + y * BENCH_WIDTH] != Cat_TextureGetPixel( pTexture, x, y )) {
+					TRACE(( "Error:mismatch %s (%d,%d)\n", pszFormat[i], (int)x, (int)y ));
+					x = BENCH_WIDTH;
+					y = BENCH_HEIGHT;
+				}
+			}
+		}
+		TRACE(( "%s GetPixel:%6dus GetRegion:%6dus x%d.%02d\n", pszFormat[i],
+			(int)nPixelTime, (int)nRegionTime,
+			(int)(nPixelTime / (nRegionTime ? nRegionTime : 1)),
+			(int)((nPixelTime * 100 / (nRegionTime ? nRegionTime : 1)) % 100) ));
+		Cat_TextureRelease( pTexture );
+	}
+	free( pnDest );
+}
+
+//! DXT圧縮の圧縮率と速度を計測する
+static void
+BenchTextureDXT( void )
+{
+	static const char* pszName[] = { "opaque", "1bit alpha", "full alpha" };
+	uint32_t* pnImage;
+	uint32_t i;
+
+	TRACE(( "-- Cat_TextureDXT %dx%d\n", BENCH_WIDTH, BENCH_HEIGHT ));
+	pnImage = (uint32_t*)malloc( BENCH_WIDTH * BENCH_HEIGHT * 4 );
+	if(pnImage == 0) {
+		TRACE(( "Error:malloc\n" ));
+		return;
+	}
+	for(i = 0; i < sizeof(pszName) / sizeof(pszName[0]); i++) {
+		Cat_TextureDXTStatistics statistics;
+		Cat_Texture* pTexture;
+		uint32_t nError = 0;
+		uint32_t x;
+		uint32_t y;
+
+		// グラデーションのイメージ
+		for(y = 0; y < BENCH_HEIGHT; y++) {
+			for(x = 0; x < BENCH_WIDTH; x++) {
+				uint32_t a = 0xFF;
+				if(i == 1) {
+					a = ((x / 16 + y / 16) & 1) ? 0xFF : 0;
+				} else if(i == 2) {
+					a = x;
+				}
+				pnImage[x + y * BENCH_WIDTH] = x | (y << 8) | (((x + y) & 0xFF) << 16) | (a << 24);
+			}
+		}
+
+		Cat_TextureDXTResetStatistics();
+		Cat_TextureSetOption( CAT_TEXTURE_OPTION_DXT );
+		pTexture = Cat_TextureCreate( BENCH_WIDTH, BENCH_HEIGHT, BENCH_WIDTH * 4, pnImage, FORMAT_PIXEL_8888, 0 );
+		Cat_TextureSetOption( CAT_TEXTURE_OPTION_DEFAULT );
+		if(pTexture == 0) {
+			TRACE(( "Error:Cat_TextureCreate\n" ));
+			continue;
+		}
+		Cat_TextureDXTGetStatistics( &statistics );
+
+		// 緑の誤差の最大値
+		for(y = 0; y < BENCH_HEIGHT; y++) {
+			for(x = 0; x < BENCH_WIDTH; x++) {
+				const int32_t d = (int32_t)((Cat_TextureGetPixel( pTexture, x, y ) >> 8) & 0xFF) - (int32_t)y;
+				if((pnImage[x + y * BENCH_WIDTH] >> 24) && ((uint32_t)abs( d ) > nError)) {
+					nError = abs( d );
+				}
+			}
+		}
+		TRACE(( "%-10s DXT%d ratio:%d.%02d %6dus %dpix/ms err:%d\n", pszName[i],
+			(pTexture->ePixelFormat == FORMAT_PIXEL_DXT1) ? 1 : 5,
+			(int)(statistics.nSourceSize / statistics.nEncodedSize),
+			(int)((statistics.nSourceSize * 100 / statistics.nEncodedSize) % 100),
+			(int)statistics.nEncodeTime,
+			(int)(statistics.nPixelCount * 1000 / (statistics.nEncodeTime ? statistics.nEncodeTime : 1)),
+			(int)nError ));
+		Cat_TextureRelease( pTexture );
+	}
+	free( pnImage );
+}
+
+//! 色の一括変換を1ピクセルずつの変換と比較する
+static void
+BenchColorConvert( void )
+{
+	static const FORMAT_PIXEL eFormat[] = { FORMAT_PIXEL_5650, FORMAT_PIXEL_5551, FORMAT_PIXEL_4444 };
+	static const char* pszFormat[] = { "5650", "5551", "4444" };
+	uint16_t* pnSrc;
+	uint32_t* pnDest;
+	uint32_t i;
+	uint32_t n;
+
+	TRACE(( "-- Cat_ColorConvert 65536 colors\n" ));
+	pnSrc  = (uint16_t*)malloc( 65536 * 2 );
+	pnDest = (uint32_t*)malloc( 65536 * 4 );
+	if((pnSrc == 0) || (pnDest == 0)) {
+		TRACE(( "Error:malloc\n" ));
+		free( pnSrc );
+		free( pnDest );
+		return;
+	}
+	for(n = 0; n < 65536; n++) {
+		pnSrc[n] = (uint16_t)n;
+	}
+	for(i = 0; i < sizeof(eFormat) / sizeof(eFormat[0]); i++) {
+		uint64_t nStart;
+		uint32_t nPixelTime;
+		uint32_t nBatchTime;
+		uint32_t nError = 0;
+
+		// 1ピクセルずつ
+		nStart = sceKernelGetSystemTimeWide();
+		for(n = 0; n < 65536; n++) {
+			switch(eFormat[i]) {
+				case FORMAT_PIXEL_5650:
+					pnDest[n] = Cat_ColorConvert5650To8888( pnSrc[n] );
+					break;
+				case FORMAT_PIXEL_5551:
+					pnDest[n] = Cat_ColorConvert5551To8888( pnSrc[n] );
+					break;
+				default:
+					pnDest[n] = Cat_ColorConvert4444To8888( pnSrc[n] );
+					break;
+			}
+		}
+		nPixelTime = (uint32_t)(sceKernelGetSystemTimeWide() - nStart);
+
+		// まとめて
+		nStart = sceKernelGetSystemTimeWide();
+		Cat_ColorConvert( pnDest, FORMAT_PIXEL_8888, pnSrc, eFormat[i], 65536 );
+		nBatchTime = (uint32_t)(sceKernelGetSystemTimeWide() - nStart);
+
+		// 全部の値が1ピクセルずつの変換と同じか確認する
+		for(n = 0; n < 65536; n++) {
+			uint32_t nColor;
+			switch(eFormat[i]) {
+				case FORMAT_PIXEL_5650:
+					nColor = Cat_ColorConvert5650To8888( pnSrc[n] );
+					break;
+				case FORMAT_PIXEL_5551:
+					nColor = Cat_ColorConvert5551To8888( pnSrc[n] );
+					break;
+				default:
+					nColor = Cat_ColorConvert4444To8888( pnSrc[n] );
+					break;
+			}
+			if(pnDest[n] != nColor) {
+				nError++;
+			}
+		}
+		TRACE(( "%s->8888 single:%6dus batch:%6dus error:%d\n", pszFormat[i], (int)nPixelTime, (int)nBatchTime, (int)nError ));
+	}
+	free( pnSrc );
+	free( pnDest );
+}
+
+//! 32bitテクスチャの16bit変換を計測する
+/*!
+	アルファなし、1bitアルファ、階調アルファのグラデーションを、ディザなしとありで変換して \n
+	選ばれたフォーマットと、元のイメージとの誤差の最大値を見る。
+*/
+static void
+BenchTextureFormat16( void )
+{
+	static const char* pszName[] = { "opaque", "1bit alpha", "full alpha" };
+	static const char* pszFormat[] = { "5650", "5551", "4444", "8888" };
+	uint32_t* pnImage;
+	uint32_t i;
+
+	TRACE(( "-- Cat_Texture FORMAT16 %dx%d quality:%ddB\n", BENCH_WIDTH, BENCH_HEIGHT, (int)Cat_TextureGetQuality() ));
+	pnImage = (uint32_t*)malloc( BENCH_WIDTH * BENCH_HEIGHT * 4 );
+	if(pnImage == 0) {
+		TRACE(( "Error:malloc\n" ));
+		return;
+	}
+	for(i = 0; i < sizeof(pszName) / sizeof(pszName[0]) * 2; i++) {
+		Cat_TextureFormat16Statistics statistics;
+		Cat_Texture* pTexture;
+		uint32_t nError = 0;
+		uint32_t x;
+		uint32_t y;
+
+		for(y = 0; y < BENCH_HEIGHT; y++) {
+			for(x = 0; x < BENCH_WIDTH; x++) {
+				uint32_t a = 0xFF;
+				if(i / 2 == 1) {
+					a = ((x / 16 + y / 16) & 1) ? 0xFF : 0;
+				} else if(i / 2 == 2) {
+					a = x;
+				}
+				pnImage[x + y * BENCH_WIDTH] = x | (y << 8) | (((x + y) & 0xFF) << 16) | (a << 24);
+			}
+		}
+
+		Cat_TextureResetFormat16Statistics();
+		Cat_TextureSetOption( CAT_TEXTURE_OPTION_FORMAT16 | ((i & 1) ? CAT_TEXTURE_OPTION_DITHER : 0) );
+		pTexture = Cat_TextureCreate( BENCH_WIDTH, BENCH_HEIGHT, BENCH_WIDTH * 4, pnImage, FORMAT_PIXEL_8888, 0 );
+		Cat_TextureSetOption( CAT_TEXTURE_OPTION_DEFAULT );
+		if(pTexture == 0) {
+			TRACE(( "Error:Cat_TextureCreate\n" ));
+			continue;
+		}
+		Cat_TextureGetFormat16Statistics( &statistics );
+
+		// 緑の誤差の最大値
+		for(y = 0; y < BENCH_HEIGHT; y++) {
+			for(x = 0; x < BENCH_WIDTH; x++) {
+				const int32_t d = (int32_t)((Cat_TextureGetPixel( pTexture, x, y ) >> 8) & 0xFF) - (int32_t)y;
+				if((pnImage[x + y * BENCH_WIDTH] >> 24) && ((uint32_t)abs( d ) > nError)) {
+					nError = abs( d );
+				}
+			}
+		}
+		TRACE(( "%-10s %s %s saved:%3dKB %6dus err:%d\n", pszName[i / 2], (i & 1) ? "dither" : "      ",
+			pszFormat[(pTexture->ePixelFormat <= FORMAT_PIXEL_8888) ? pTexture->ePixelFormat : FORMAT_PIXEL_8888],
+			(int)(statistics.nSavedSize / 1024), (int)statistics.nTime, (int)nError ));
+		Cat_TextureRelease( pTexture );
+	}
+	free( pnImage );
+}
+
+//! 32bitテクスチャの8bit変換を計測する
+/*!
+	色数の多いグラデーション、透明色のある少ない色数のスプライト、 \n
+	ノイズを乗せたグラデーションを変換して、処理速度と誤差を見る。
+*/
+static void
+BenchTextureQuantize( void )
+{
+	static const char* pszName[] = { "gradient", "sprite", "noise" };
+	uint32_t* pnImage;
+	uint32_t i;
+
+	TRACE(( "-- Cat_Texture QUANTIZE %dx%d quality:%ddB\n", BENCH_WIDTH, BENCH_HEIGHT, (int)Cat_TextureGetQuality() ));
+	pnImage = (uint32_t*)malloc( BENCH_WIDTH * BENCH_HEIGHT * 4 );
+	if(pnImage == 0) {
+		TRACE(( "Error:malloc\n" ));
+		return;
+	}
+	for(i = 0; i < sizeof(pszName) / sizeof(pszName[0]); i++) {
+		Cat_TextureQuantizeStatistics statistics;
+		Cat_Texture* pTexture;
+		uint64_t nError = 0;
+		uint32_t nSample = 0;
+		uint32_t x;
+		uint32_t y;
+
+		srand( 1 );
+		for(y = 0; y < BENCH_HEIGHT; y++) {
+			for(x = 0; x < BENCH_WIDTH; x++) {
+				uint32_t c = x | (y << 8) | (((x + y) & 0xFF) << 16) | 0xFF000000;
+				if(i == 1) {
+					const uint32_t dx = x - BENCH_WIDTH / 2;
+					const uint32_t dy = y - BENCH_HEIGHT / 2;
+					c = (dx * dx + dy * dy < 100 * 100) ? (0xFF000000 | (((x / 32) * 0x23 + (y / 32) * 0x5100) & 0xFFFFFF)) : 0;
+				} else if(i == 2) {
+					c ^= rand() & 0x0F0F0F;
+				}
+				pnImage[x + y * BENCH_WIDTH] = c;
+			}
+		}
+
+		Cat_TextureResetQuantizeStatistics();
+		Cat_TextureSetOption( CAT_TEXTURE_OPTION_QUANTIZE );
+		pTexture = Cat_TextureCreate( BENCH_WIDTH, BENCH_HEIGHT, BENCH_WIDTH * 4, pnImage, FORMAT_PIXEL_8888, 0 );
+		Cat_TextureSetOption( CAT_TEXTURE_OPTION_DEFAULT );
+		if(pTexture == 0) {
+			TRACE(( "Error:Cat_TextureCreate\n" ));
+			continue;
+		}
+		Cat_TextureGetQuantizeStatistics( &statistics );
+
+		// 不透明なピクセルの平均二乗誤差
+		for(y = 0; y < BENCH_HEIGHT; y++) {
+			for(x = 0; x < BENCH_WIDTH; x++) {
+				const uint32_t c = pnImage[x + y * BENCH_WIDTH];
+				const uint32_t p = Cat_TextureGetPixel( pTexture, x, y );
+				uint32_t j;
+				if((c >> 24) == 0) {
+					continue;
+				}
+				for(j = 0; j < 24; j += 8) {
+					const int32_t d = (int32_t)((c >> j) & 0xFF) - (int32_t)((p >> j) & 0xFF);
+					nError += d * d;
+				}
+				nSample += 3;
+			}
+		}
+		TRACE(( "%-8s %s%s mse:%d.%02d %6dus %d.%02dMP/s\n", pszName[i],
+			(pTexture->ePixelFormat == FORMAT_PIXEL_CLUT8) ? "CLUT8" : "8888 ",
+			statistics.nExactCount ? "(exact)" : "       ",
+			(int)(nError / nSample), (int)(nError * 100 / nSample % 100), (int)statistics.nTime,
+			(int)(statistics.nPixelCount / (statistics.nTime + 1)), (int)(statistics.nPixelCount * 100 / (statistics.nTime + 1) % 100) ));
+		Cat_TextureRelease( pTexture );
+	}
+	free( pnImage );
+}
+
+//! パレットエフェクトの計測で使うフレーム数
+#define BENCH_PALETTEEFFECT_FRAME (120)
+
+//! パレットエフェクトを計測する
+/*!
+	256色のパレットにエフェクトをかける時間と、 \n
+	4人のキャラクターがヒットの点滅、正弦波、反転と白黒を使った場合のキャッシュの効き方を見る。
+*/
+static void
+BenchPaletteEffect( void )
+{
+	Cat_PaletteEffectStatistics statistics;
+	Cat_PaletteEffectParam param;
+	Cat_PaletteEffectCache* pCache;
+	Cat_Palette* pSource;
+	Cat_Palette* pDest;
+	uint32_t anColor[256];
+	uint32_t nStart;
+	uint32_t nFrame;
+	uint32_t i;
+
+	TRACE(( "-- Cat_PaletteEffect\n" ));
+	for(i = 0; i < 256; i++) {
+		anColor[i] = 0xFF000000 | (i * 0x010305);
+	}
+	pSource = Cat_PaletteCreate( FORMAT_PALETTE_8888, 256, anColor );
+	pDest = Cat_PaletteCreate( FORMAT_PALETTE_8888, 256, 0 );
+	pCache = Cat_PaletteEffectCacheCreate( 16 );
+	if((pSource == 0) || (pDest == 0) || (pCache == 0)) {
+		TRACE(( "Error:create\n" ));
+		goto cleanup;
+	}
+
+	Cat_PaletteEffectParamInit( &param );
+	param.nAdd[0] = 64;
+	param.nMul[2] = 128;
+	param.nColor  = 128;
+	param.fInvert = 1;
+	nStart = sceKernelGetSystemTimeLow();
+	for(i = 0; i < 1000; i++) {
+		Cat_PaletteEffectApply( pDest, pSource, &param );
+	}
+	TRACE(( "apply 256 colors: %dns\n", (int)(sceKernelGetSystemTimeLow() - nStart) ));
+
+	for(nFrame = 0; nFrame < BENCH_PALETTEEFFECT_FRAME; nFrame++) {
+		uint32_t nActor;
+		for(nActor = 0; nActor < 4; nActor++) {
+			Cat_PaletteEffectParamInit( &param );
+			switch(nActor) {
+				case 1:
+					// 30フレームごとに4フレームだけ白く光る
+					if((nFrame % 30) < 4) {
+						param.nAdd[0] = param.nAdd[1] = param.nAdd[2] = 255;
+					}
+					break;
+				case 2:
+					// 20フレーム周期で赤く脈打つ
+					param.nSinAdd[0] = 96;
+					param.nSinPeriod = 20;
+					param.nTime      = nFrame;
+					break;
+				case 3:
+					param.fInvert = 1;
+					param.nColor  = 0;
+					break;
+				default:
+					break;
+			}
+			Cat_PaletteEffectCacheGet( pCache, pSource, &param );
+		}
+		Cat_PaletteEffectCacheUpdate( pCache );
+	}
+	Cat_PaletteEffectCacheGetStatistics( pCache, &statistics );
+	TRACE(( "%d frames: request:%d hit:%d build:%d overflow:%d used:%d\n", BENCH_PALETTEEFFECT_FRAME,
+		(int)statistics.nRequestCount, (int)statistics.nHitCount, (int)statistics.nBuildCount,
+		(int)statistics.nOverflowCount, (int)statistics.nUsedCount ));
+
+cleanup:
+	Cat_PaletteEffectCacheDestroy( pCache );
+	Cat_PaletteRelease( pDest );
+	Cat_PaletteRelease( pSource );
+}
+
+//! 読み込みを真似るイメージ数
+#define BENCH_ALLOC_COUNT (2000)
+
+//! テクスチャとパレットの確保を計測する
+/*!
+	SFFの読み込みと同じように、小さい8bitイメージを1枚ずつパレット付きで作って、まとめて解放する。 \n
+	ピクセルデータをヒープから確保する場合と、Cat_Arenaにまとめる場合を比べる。 \n
+	構造体をヒープから1個ずつ確保する場合は、CAT_SLAB_NO_POOLを定義してlibCatをビルドし直す。
+*/
+static void
+BenchTextureAlloc( void )
+{
+	Cat_Texture** ppTexture;
+	uint8_t* pbImage;
+	uint32_t anColor[256];
+	uint32_t nPass;
+	uint32_t i;
+
+	TRACE(( "-- Cat_Slab / Cat_Arena\n" ));
+	ppTexture = (Cat_Texture**)malloc( sizeof(Cat_Texture*) * BENCH_ALLOC_COUNT );
+	pbImage = (uint8_t*)malloc( 64 * 96 );
+	if((ppTexture == 0) || (pbImage == 0)) {
+		TRACE(( "Error:malloc\n" ));
+		free( ppTexture );
+		free( pbImage );
+		return;
+	}
+	for(i = 0; i < 64 * 96; i++) {
+		pbImage[i] = (uint8_t)(rand() >> 4);
+	}
+	for(i = 0; i < 256; i++) {
+		anColor[i] = 0xFF000000 | (i * 0x010305);
+	}
+
+	for(nPass = 0; nPass < 2; nPass++) {
+		Cat_Arena* pArena = nPass ? Cat_ArenaCreate( 128 * 1024 ) : 0;
+		Cat_ArenaStatistics arena;
+		Cat_SlabStatistics texture[2];
+		Cat_SlabStatistics palette[2];
+		uint32_t nCreateTime;
+		uint32_t nReleaseTime;
+		uint32_t nStart;
+		uint32_t nHeap;
+
+		Cat_TextureGetSlabStatistics( &texture[0] );
+		Cat_PaletteGetSlabStatistics( &palette[0] );
+		Cat_TextureSetArena( pArena );
+		nStart = sceKernelGetSystemTimeLow();
+		for(i = 0; i < BENCH_ALLOC_COUNT; i++) {
+			// 16～64 x 16～96 の大きさにばらつかせる
+			const uint32_t w = 16 + (i * 7) % 49;
+			const uint32_t h = 16 + (i * 13) % 81;
+			Cat_Palette* pPalette = Cat_PaletteCreate( FORMAT_PALETTE_8888, 256, anColor );
+			ppTexture[i] = Cat_TextureCreate( w, h, 64, pbImage, FORMAT_PIXEL_CLUT8, pPalette );
+			Cat_PaletteRelease( pPalette );
+		}
+		nCreateTime = sceKernelGetSystemTimeLow() - nStart;
+		Cat_TextureSetArena( 0 );
+		Cat_TextureGetSlabStatistics( &texture[1] );
+		Cat_PaletteGetSlabStatistics( &palette[1] );
+		Cat_ArenaGetStatistics( pArena, &arena );
+
+		nStart = sceKernelGetSystemTimeLow();
+		for(i = 0; i < BENCH_ALLOC_COUNT; i++) {
+			Cat_TextureRelease( ppTexture[i] );
+		}
+		Cat_ArenaRelease( pArena );
+		nReleaseTime = sceKernelGetSystemTimeLow() - nStart;
+
+		// 残るメモリのためにヒープから確保した回数(変換の作業用は除く)
+		nHeap = (texture[1].nHeapAllocCount - texture[0].nHeapAllocCount)
+			+ (palette[1].nHeapAllocCount - palette[0].nHeapAllocCount);
+		if(pArena) {
+			nHeap += arena.nHeapAllocCount;
+		} else {
+			nHeap += BENCH_ALLOC_COUNT * 2;		// ピクセルデータとパレットデータ
+		}
+		TRACE(( "%s: %d images create:%dus release:%dus heap alloc:%d\n", pArena ? "arena" : "heap ",
+			BENCH_ALLOC_COUNT, (int)nCreateTime, (int)nReleaseTime, (int)nHeap ));
+		TRACE(( "  texture chunk:%d palette chunk:%d arena block:%d(%dKB)\n",
+			(int)texture[1].nChunkCount, (int)palette[1].nChunkCount, (int)arena.nBlockCount, (int)(arena.nReservedSize / 1024) ));
+	}
+
+	free( pbImage );
+	free( ppTexture );
+}
+
+//! VRAMの領域管理で使うリソース数
+#define BENCH_VRAM_RESOURCE (48)
+//! 1ラウンドでよく使うリソース数
+#define BENCH_VRAM_HOT      (12)
+//! 1ラウンドのフレーム数
+#define BENCH_VRAM_FRAME    (300)
+
+//! 擬似VRAMで配置の方針を確認する
+/*!
+	ラウンドごとによく使うリソースを入れ替えて、常駐しているデータが壊れていないかと \n
+	断片化の解消でどれだけ空きがまとまるかを見る。
+*/
+static void
+BenchVram( void )
+{
+	static Cat_VramResource resource[BENCH_VRAM_RESOURCE];
+	static uint8_t* pbSource[BENCH_VRAM_RESOURCE];
+	Cat_VramStatistics statistics;
+	Cat_Vram* pVram;
+	uint32_t nUpdateTime = 0;
+	uint32_t nRound;
+	uint32_t i;
+
+	TRACE(( "-- Cat_Vram simulator 1024KB budget 768KB\n" ));
+	pVram = Cat_VramCreateSimulator( 1024 * 1024 );
+	if(pVram == 0) {
+		TRACE(( "Error:Cat_VramCreateSimulator\n" ));
+		return;
+	}
+	Cat_VramSetBudget( pVram, 768 * 1024 );
+	Cat_VramSetUploadLimit( pVram, 256 * 1024 );
+	for(i = 0; i < BENCH_VRAM_RESOURCE; i++) {
+		const uint32_t nSize = (16 + (rand() % 8) * 16) * 1024;
+		uint32_t n;
+		pbSource[i] = (uint8_t*)malloc( nSize );
+		if(pbSource[i] == 0) {
+			TRACE(( "Error:malloc\n" ));
+			break;
+		}
+		for(n = 0; n < nSize; n++) {
+			pbSource[i][n] = (uint8_t)(rand() >> 4);
+		}
+		Cat_VramResourceInit( &resource[i], pbSource[i], nSize );
+	}
+
+	for(nRound = 0; (i == BENCH_VRAM_RESOURCE) && (nRound < 4); nRound++) {
+		uint32_t nLargestFree;
+		uint32_t nError = 0;
+		uint32_t nFrame;
+
+		Cat_VramResetStatistics( pVram );
+		for(nFrame = 0; nFrame < BENCH_VRAM_FRAME; nFrame++) {
+			uint64_t nStart;
+			uint32_t n;
+			// よく使うものは毎フレーム、それ以外はたまに使う
+			for(n = 0; n < BENCH_VRAM_HOT; n++) {
+				Cat_VramTouch( pVram, &resource[(nRound * 7 + n) % BENCH_VRAM_RESOURCE] );
+			}
+			Cat_VramTouch( pVram, &resource[rand() % BENCH_VRAM_RESOURCE] );
+
+			nStart = sceKernelGetSystemTimeWide();
+			Cat_VramUpdate( pVram );
+			nUpdateTime += (uint32_t)(sceKernelGetSystemTimeWide() - nStart);
+		}
+		Cat_VramGetStatistics( pVram, &statistics );
+		nLargestFree = statistics.nLargestFree;
+		TRACE(( "round%d hit:%3d%% promote:%3d evict:%3d upload:%5dKB frag:%d\n", (int)nRound,
+			(int)(statistics.nHitCount * 100 / (statistics.nTouchCount ? statistics.nTouchCount : 1)),
+			(int)statistics.nPromoteCount, (int)statistics.nEvictCount,
+			(int)(statistics.nUploadBytes / 1024), (int)statistics.nFragmentCount ));
+
+		// ラウンドの間で断片化を解消する
+		Cat_VramDefragment( pVram );
+		Cat_VramGetStatistics( pVram, &statistics );
+		TRACE(( "       resident:%4dKB(%2d) largest free:%4dKB -> %4dKB moved:%4dKB\n",
+			(int)(statistics.nResidentBytes / 1024), (int)statistics.nResidentCount,
+			(int)(nLargestFree / 1024), (int)(statistics.nLargestFree / 1024),
+			(int)(statistics.nDefragmentBytes / 1024) ));
+
+		// 常駐しているデータが元と同じか確認する
+		for(i = 0; i < BENCH_VRAM_RESOURCE; i++) {
+			const void* pvVram = resource[i].fResident ? Cat_VramTouch( pVram, &resource[i] ) : 0;
+			if(pvVram && memcmp( pvVram, pbSource[i], resource[i].nSize )) {
+				nError++;
+			}
+		}
+		if(nError || (statistics.nResidentBytes > statistics.nBudget)) {
+			TRACE(( "Error:corrupted %d resident:%d\n", (int)nError, (int)statistics.nResidentBytes ));
+		}
+	}
+	TRACE(( "Cat_VramUpdate %dus/frame\n", (int)(nUpdateTime / (4 * BENCH_VRAM_FRAME)) ));
+
+	Cat_VramDestroy( pVram );
+	for(i = 0; i < BENCH_VRAM_RESOURCE; i++) {
+		free( pbSource[i] );
+	}
+}
+
+int
+main()
+{
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	TRACE(( "Cat_Benchmark test code\n" ));
+
+	BenchTextureGetRegion();
+	BenchTextureDXT();
+	BenchColorConvert();
+	BenchTextureFormat16();
+	// 画質を問わない場合と、デフォルトの画質の場合
+	Cat_TextureSetQuality( 0 );
+	BenchTextureQuantize();
+	Cat_TextureSetQuality( CAT_TEXTURE_QUALITY_DEFAULT );
+	BenchTextureQuantize();
+	BenchPaletteEffect();
+	BenchTextureAlloc();
+	BenchVram();
+
+	TRACE(( "done.\n" ));
+	HALT();
+	return 0;
+}
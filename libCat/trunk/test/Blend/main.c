@@ -0,0 +1,147 @@
+// Cat_Blend test code
+// MUGENの合成の方法ごとに、まとめて合成した結果が比較用の実装と一致することを確かめて、
+// 1秒あたりのピクセル数を計測する
+//
+// インデックスは、透明(0)が続く所と混ざる所を作る。描画先のアルファも残ることを確かめる。
+
+#include "Cat_PspCallback.h"
+#include "Cat_Blend.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include <pspdebug.h>
+#include <pspkernel.h>
+#include <pspthreadman.h>
+
+#define TRACE(x) pspDebugScreenPrintf x
+#define HALT() sceKernelSleepThreadCB()
+
+//! 画像の横幅(4の倍数でない幅で、端の処理も確かめる)
+#define TEST_WIDTH (477)
+//! 画像の高さ
+#define TEST_HEIGHT (272)
+//! 計測する回数
+#define TEST_LOOP_COUNT (8)
+
+//! 合成の方法の名前
+static const char* gpszMode[CAT_BLEND_MAX] = { "none    ", "add     ", "add1    ", "sub     ", "addalpha", "shadow  " };
+
+//! 1秒あたりのピクセル数を求める
+/*!
+	@param[in]	nTime	かかった時間(マイクロ秒単位)
+	@return	1秒あたりのピクセル数(千ピクセル単位)
+*/
+static uint32_t
+GetPixelRate( uint32_t nTime )
+{
+	const uint64_t nPixel = (uint64_t)TEST_WIDTH * TEST_HEIGHT * TEST_LOOP_COUNT;
+
+	return nTime ? (uint32_t)(nPixel * 1000 / nTime) : 0;
+}
+
+int
+main()
+{
+	static uint8_t abSrc[TEST_WIDTH * TEST_HEIGHT];
+	static uint32_t anDest8888[3][TEST_WIDTH * TEST_HEIGHT];
+	static uint16_t anDest5650[3][TEST_WIDTH * TEST_HEIGHT];
+	uint32_t anPalette[256];
+	Cat_BlendParam param;
+	Cat_Palette* pPalette;
+	uint32_t nMismatch = 0;
+	uint32_t nAlpha = 0;
+	uint32_t nMode;
+	uint32_t i;
+
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	TRACE(( "Cat_Blend test code\n" ));
+
+	srand( 1 );
+	for(i = 0; i < 256; i++) {
+		anPalette[i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+	}
+	for(i = 0; i < TEST_WIDTH * TEST_HEIGHT; i++) {
+		// 横32ピクセルごとに、透明が続く所と混ざる所を交互に作る
+		abSrc[i] = (((i / 32) & 1) && (rand() & 1)) ? 0 : (uint8_t)rand();
+		anDest8888[0][i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+		anDest5650[0][i] = (uint16_t)rand();
+	}
+
+	TRACE(( "mode      8888 ref     8888     5650 ref     5650   (k pixel/s)\n" ));
+	for(nMode = 0; nMode < CAT_BLEND_MAX; nMode++) {
+		uint32_t nTime[4];
+		uint32_t nStart;
+		uint32_t j;
+
+		Cat_BlendParamInit( &param );
+		param.nMode        = nMode;
+		param.nSrcAlpha    = 96;
+		param.nDestAlpha   = 200;	// 合わせて256を超えるので、飽和する
+		param.nShadowColor = 0x402010;
+		param.nShadowAlpha = 160;
+
+		// 比較用の実装と一致するか
+		memcpy( anDest8888[1], anDest8888[0], sizeof(anDest8888[0]) );
+		memcpy( anDest8888[2], anDest8888[0], sizeof(anDest8888[0]) );
+		memcpy( anDest5650[1], anDest5650[0], sizeof(anDest5650[0]) );
+		memcpy( anDest5650[2], anDest5650[0], sizeof(anDest5650[0]) );
+		for(i = 0; i < TEST_HEIGHT; i++) {
+			Cat_BlendSpan8888Reference( &anDest8888[1][i * TEST_WIDTH], &abSrc[i * TEST_WIDTH], anPalette, TEST_WIDTH, &param );
+			Cat_BlendSpan5650Reference( &anDest5650[1][i * TEST_WIDTH], &abSrc[i * TEST_WIDTH], anPalette, TEST_WIDTH, &param );
+		}
+		Cat_BlendSpan8888( anDest8888[2], abSrc, anPalette, TEST_WIDTH * TEST_HEIGHT, &param );
+		Cat_BlendSpan5650( anDest5650[2], abSrc, anPalette, TEST_WIDTH * TEST_HEIGHT, &param );
+		if(memcmp( anDest8888[1], anDest8888[2], sizeof(anDest8888[0]) ) != 0) {
+			TRACE(( "Error:8888 mismatch (%s)\n", gpszMode[nMode] ));
+			nMismatch++;
+		}
+		if(memcmp( anDest5650[1], anDest5650[2], sizeof(anDest5650[0]) ) != 0) {
+			TRACE(( "Error:5650 mismatch (%s)\n", gpszMode[nMode] ));
+			nMismatch++;
+		}
+		for(i = 0; i < TEST_WIDTH * TEST_HEIGHT; i++) {
+			if((anDest8888[2][i] ^ anDest8888[0][i]) & 0xFF000000) {
+				nAlpha++;
+			}
+		}
+
+		// 計測(描画先は合成し続けるので、毎回値が変わる)
+		for(j = 0; j < 4; j++) {
+			uint32_t nLoop;
+			nStart = sceKernelGetSystemTimeLow();
+			for(nLoop = 0; nLoop < TEST_LOOP_COUNT; nLoop++) {
+				for(i = 0; i < TEST_HEIGHT; i++) {
+					const uint32_t nOffset = i * TEST_WIDTH;
+					switch(j) {
+						case 0:		Cat_BlendSpan8888Reference( &anDest8888[1][nOffset], &abSrc[nOffset], anPalette, TEST_WIDTH, &param );	break;
+						case 1:		Cat_BlendSpan8888( &anDest8888[2][nOffset], &abSrc[nOffset], anPalette, TEST_WIDTH, &param );			break;
+						case 2:		Cat_BlendSpan5650Reference( &anDest5650[1][nOffset], &abSrc[nOffset], anPalette, TEST_WIDTH, &param );	break;
+						default:	Cat_BlendSpan5650( &anDest5650[2][nOffset], &abSrc[nOffset], anPalette, TEST_WIDTH, &param );			break;
+					}
+				}
+			}
+			nTime[j] = sceKernelGetSystemTimeLow() - nStart;
+		}
+		TRACE(( "%s %8d %8d %8d %8d\n", gpszMode[nMode], (int)GetPixelRate( nTime[0] ), (int)GetPixelRate( nTime[1] ),
+			(int)GetPixelRate( nTime[2] ), (int)GetPixelRate( nTime[3] ) ));
+	}
+	// パレットを渡して画像を合成しても同じになるか
+	pPalette = Cat_PaletteCreate( FORMAT_PALETTE_8888, 256, anPalette );
+	memcpy( anDest8888[1], anDest8888[0], sizeof(anDest8888[0]) );
+	memcpy( anDest8888[2], anDest8888[0], sizeof(anDest8888[0]) );
+	Cat_BlendSpan8888Reference( anDest8888[1], abSrc, anPalette, TEST_WIDTH * TEST_HEIGHT, &param );
+	if((Cat_BlendImage( anDest8888[2], TEST_WIDTH * 4, FORMAT_PIXEL_8888, abSrc, TEST_WIDTH, TEST_WIDTH, TEST_HEIGHT, pPalette, &param ) < 0)
+		|| (memcmp( anDest8888[1], anDest8888[2], sizeof(anDest8888[0]) ) != 0)) {
+		TRACE(( "Error:Cat_BlendImage\n" ));
+		nMismatch++;
+	}
+	Cat_PaletteRelease( pPalette );
+
+	TRACE(( "mismatch:%d alpha changed:%d\n", (int)nMismatch, (int)nAlpha ));
+	TRACE(( ((nMismatch == 0) && (nAlpha == 0)) ? "OK\n" : "NG\n" ));
+
+	HALT();
+	return 0;
+}
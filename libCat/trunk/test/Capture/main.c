@@ -0,0 +1,230 @@
+// Cat_Capture test code
+// スプライトを動かしながら、スクリーンショットと2フレームごとの連続したフレームを保存して、
+// ゲームの処理をするスレッドが払った時間(コピー)と、書き込むスレッドがかかった時間(変換と書き込み)を比べる。
+//
+// スクリーンショットは読み込み直して、撮ったフレームと同じ色になっていることと、
+// ランレングスで元の大きさより小さくなっていることを確かめる。32bitと16bitのフレームバッファで行う。
+
+#include "Cat_PspCallback.h"
+#include "Cat_Capture.h"
+#include "Cat_ImageLoader.h"
+#include "Cat_Render.h"
+#include "Cat_SpriteBatch.h"
+#include "Cat_StreamFile.h"
+#include "Cat_Texture.h"
+#ifdef USE_CAT_SOFTRENDER
+#include "Cat_SoftRender.h"
+#endif
+#include "TestCommon.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include <pspdebug.h>
+#include <pspgu.h>
+#include <pspkernel.h>
+#include <pspthreadman.h>
+
+#define TRACE(x) pspDebugScreenPrintf x
+#define HALT() sceKernelSleepThreadCB()
+
+//! テクスチャの大きさ
+#define TEST_TEXTURE_SIZE (32)
+//! スプライト数
+#define TEST_SPRITE_COUNT (200)
+//! 描画するフレーム数
+#define TEST_FRAME_COUNT (120)
+//! スクリーンショットを撮るフレーム
+#define TEST_SHOT_FRAME (31)
+//! 連続したフレームを保存する間隔
+#define TEST_INTERVAL (2)
+//! バッファの数
+#define TEST_BUFFER_COUNT (4)
+//! 書き込むスレッドの優先度
+#define TEST_THREAD_PRIORITY (0x30)
+//! スクリーンショットのファイル名
+#define TEST_SHOT_FILENAME "shot.pcx"
+//! 連続したフレームのファイル名
+#define TEST_SEQUENCE_FORMAT "seq%03d.pcx"
+
+//! 撮ったフレーム(RGBA8888)
+static uint32_t ganShot[480 * 272];
+
+//! 表示しているフレームをRGBA8888で取っておく
+static void
+KeepDisplay( void )
+{
+	const int32_t nFormat = Cat_RenderGetFormat();
+	const uint8_t* pbSrc = (const uint8_t*)Cat_RenderGetDisplay();
+	uint32_t x;
+	uint32_t y;
+
+	for(y = 0; y < 272; y++) {
+		for(x = 0; x < 480; x++) {
+			uint32_t nColor;
+			if(nFormat == GU_PSM_8888) {
+				nColor = ((const uint32_t*)pbSrc)[x + y * 512];
+			} else {
+				nColor = Cat_ColorConvert5650To8888( ((const uint16_t*)pbSrc)[x + y * 512] );
+			}
+			ganShot[x + y * 480] = nColor;
+		}
+	}
+}
+
+//! スクリーンショットを読み込んで、撮ったフレームと比べる
+/*!
+	@return	違うピクセル数。読み込めなかった場合は、負数が返る
+*/
+static int32_t
+CompareShot( void )
+{
+	Cat_Stream* pStream;
+	Cat_Texture* pTexture;
+	int32_t rc = 0;
+	uint32_t x;
+	uint32_t y;
+
+	pStream = Cat_StreamFileReadOpen( TEST_SHOT_FILENAME );
+	if(pStream == 0) {
+		return -1;
+	}
+	pTexture = Cat_LoadImage( pStream );
+	Cat_StreamClose( pStream );
+	if(pTexture == 0) {
+		return -1;
+	}
+	for(y = 0; y < 272; y++) {
+		for(x = 0; x < 480; x++) {
+			// アルファは保存しない
+			if(((Cat_TextureGetPixel( pTexture, x, y ) ^ ganShot[x + y * 480]) & 0x00FFFFFF) != 0) {
+				rc++;
+			}
+		}
+	}
+	Cat_TextureRelease( pTexture );
+	return rc;
+}
+
+//! 描画しながら保存する
+/*!
+	@param[in]	pCapture	画面の保存
+	@param[in]	pTexture	テクスチャ
+	@param[out]	pnTime		Cat_CaptureUpdate()にかかった時間の合計(マイクロ秒単位)
+	@return	連続したフレームを保存した数
+*/
+static uint32_t
+Run( Cat_Capture* pCapture, Cat_Texture* pTexture, uint32_t* pnTime )
+{
+	Cat_SpriteBatch* pBatch;
+	Cat_SpriteBatchSprite sprite;
+	uint32_t nFrame;
+	uint32_t i;
+
+	pBatch = Cat_SpriteBatchCreate( TEST_SPRITE_COUNT );
+	if(pBatch == 0) {
+		return 0;
+	}
+	Cat_SpriteBatchSpriteInit( &sprite );
+	sprite.pTexture = pTexture;
+	*pnTime = 0;
+	Cat_CaptureStartSequence( pCapture, TEST_SEQUENCE_FORMAT, TEST_INTERVAL );
+	for(nFrame = 0; nFrame < TEST_FRAME_COUNT; nFrame++) {
+		uint32_t nStart;
+
+		Cat_RenderBegin(); {
+			for(i = 0; i < TEST_SPRITE_COUNT; i++) {
+				sprite.x = (float)((i * 37 + nFrame * 3) % (480 - TEST_TEXTURE_SIZE));
+				sprite.y = (float)((i * 23 + nFrame) % (272 - TEST_TEXTURE_SIZE));
+				Cat_SpriteBatchAdd( pBatch, &sprite );
+			}
+			Cat_SpriteBatchFlush( pBatch );
+		} Cat_RenderEnd();
+		Cat_RenderScreenUpdate();
+
+		if(nFrame == TEST_SHOT_FRAME) {
+			KeepDisplay();
+			Cat_CaptureShot( pCapture, TEST_SHOT_FILENAME );
+		}
+		nStart = sceKernelGetSystemTimeLow();
+		Cat_CaptureUpdate( pCapture );
+		*pnTime += sceKernelGetSystemTimeLow() - nStart;
+	}
+	Cat_SpriteBatchDestroy( pBatch );
+	return Cat_CaptureStopSequence( pCapture );
+}
+
+int
+main()
+{
+	static const uint32_t anFormat[2] = { CAT_RENDER_PARAM_FORMAT_RGBA8888, CAT_RENDER_PARAM_FORMAT_RGBA5650 };
+	Cat_Capture* pCapture;
+	Cat_CaptureStatistics statistics[2];
+	Cat_Texture* pTexture;
+	uint32_t* pnImage;
+	uint32_t nTime[2];
+	uint32_t nSequence[2];
+	int32_t nDiff[2];
+	int fOk;
+	uint32_t i;
+
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	TRACE(( "Cat_Capture test code\n" ));
+
+	// 縦縞のテクスチャ(ランが途切れる所と続く所ができる)
+	pnImage = (uint32_t*)malloc( TEST_TEXTURE_SIZE * TEST_TEXTURE_SIZE * sizeof(uint32_t) );
+	if(pnImage == 0) {
+		HALT();
+	}
+	for(i = 0; i < TEST_TEXTURE_SIZE * TEST_TEXTURE_SIZE; i++) {
+		pnImage[i] = ((i / 4) & 1) ? 0xFF20C0E0 : 0xFF8040C0;
+	}
+	pTexture = Cat_TextureCreate( TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE * sizeof(uint32_t), pnImage,
+		FORMAT_PIXEL_8888, 0 );
+	free( pnImage );
+	pCapture = Cat_CaptureCreate( TEST_BUFFER_COUNT, TEST_THREAD_PRIORITY );
+	if((pTexture == 0) || (pCapture == 0)) {
+		TRACE(( "Error:Create\n" ));
+		HALT();
+	}
+
+#ifdef USE_CAT_SOFTRENDER
+	Cat_SoftRenderSetRefreshRate( 60 );
+#endif
+	for(i = 0; i < 2; i++) {
+		Cat_RenderInit( anFormat[i] );
+		Cat_CaptureResetStatistics( pCapture );
+		nSequence[i] = Run( pCapture, pTexture, &nTime[i] );
+		Cat_CaptureFlush( pCapture );
+		Cat_CaptureGetStatistics( pCapture, &statistics[i] );
+		Cat_RenderTerm();
+		nDiff[i] = CompareShot();
+	}
+	Cat_CaptureDestroy( pCapture );
+
+	TestResetDebugScreen();
+	fOk = 1;
+	for(i = 0; i < 2; i++) {
+		const Cat_CaptureStatistics* pStatistics = &statistics[i];
+		const uint32_t nCopy = pStatistics->nCopyCount ? pStatistics->nCopyCount : 1;
+		const uint32_t nSave = pStatistics->nSaveCount ? pStatistics->nSaveCount : 1;
+		TRACE(( "%s: update %4dus/frame copy %4dus (max %4dus) save %6dus (max %6dus)\n", i ? "16bit" : "32bit",
+			(int)(nTime[i] / TEST_FRAME_COUNT), (int)(pStatistics->nCopyTime / nCopy), (int)pStatistics->nCopyTimeMax,
+			(int)(pStatistics->nSaveTime / nSave), (int)pStatistics->nSaveTimeMax ));
+		TRACE(( "       copy:%d drop:%d save:%d error:%d queue:%d sequence:%d size:%d/%d diff:%d\n",
+			(int)pStatistics->nCopyCount, (int)pStatistics->nDropCount, (int)pStatistics->nSaveCount,
+			(int)pStatistics->nErrorCount, (int)pStatistics->nQueueMax, (int)nSequence[i],
+			(int)(pStatistics->nSaveSize / nSave), 128 + 480 * 272 * 3, (int)nDiff[i] ));
+		if((nDiff[i] != 0) || (pStatistics->nErrorCount != 0) || (pStatistics->nSaveCount != pStatistics->nCopyCount)
+			|| (pStatistics->nCopyCount + pStatistics->nDropCount < TEST_FRAME_COUNT / TEST_INTERVAL + 1)
+			|| (pStatistics->nSaveSize / nSave >= 128 + 480 * 272 * 3)) {
+			fOk = 0;
+		}
+	}
+	TestPrintResult( fOk );
+
+	Cat_TextureRelease( pTexture );
+	HALT();
+	return 0;
+}
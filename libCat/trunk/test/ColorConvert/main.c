@@ -0,0 +1,211 @@
+// Cat_ColorConvert test code
+// まとめて変換した結果が、1ピクセルずつの変換と1ビットも違わないことを確かめる
+//
+// 16bitから32bitへは、65536通りの値を全部変換する。32bitから16bitへは、乱数の色をたくさん変換する。
+// SIMDは4ピクセルずつ処理するので、4の倍数でない数と、4の倍数でない位置からの変換も確かめる。
+// 16bit同士の変換と、Cat_PaletteConvert()も、32bitを経由した1ピクセルずつの変換と比べる。
+
+#include "Cat_PspCallback.h"
+#include "Cat_ColorConvert.h"
+#include <stdlib.h>
+
+#include <pspdebug.h>
+#include <pspkernel.h>
+
+#define TRACE(x) pspDebugScreenPrintf x
+#define HALT() sceKernelSleepThreadCB()
+
+//! 16bitの値の数
+#define TEST_COUNT16 (65536)
+//! 乱数の32bitの色の数
+#define TEST_COUNT32 (1024 * 1024)
+//! 16bitのフォーマットの数
+#define TEST_FORMAT_COUNT (3)
+
+//! 16bitのフォーマット
+static const FORMAT_PIXEL geFormat[TEST_FORMAT_COUNT] = { FORMAT_PIXEL_5650, FORMAT_PIXEL_5551, FORMAT_PIXEL_4444 };
+//! フォーマットの名前
+static const char* gpszFormat[TEST_FORMAT_COUNT] = { "5650", "5551", "4444" };
+
+//! 16bitの色を1ピクセルだけ32bitに変換する
+/*!
+	@param[in]	nColor		色
+	@param[in]	eFormat		\a nColor のフォーマット
+	@return	RGBA8888の色
+*/
+static uint32_t
+Expand1( uint16_t nColor, FORMAT_PIXEL eFormat )
+{
+	switch(eFormat) {
+		case FORMAT_PIXEL_5650:
+			return Cat_ColorConvert5650To8888( nColor );
+		case FORMAT_PIXEL_5551:
+			return Cat_ColorConvert5551To8888( nColor );
+		default:
+			return Cat_ColorConvert4444To8888( nColor );
+	}
+}
+
+//! 32bitの色を1ピクセルだけ16bitに変換する
+/*!
+	@param[in]	nColor		RGBA8888の色
+	@param[in]	eFormat		変換先のフォーマット
+	@return	変換した色
+*/
+static uint16_t
+Compress1( uint32_t nColor, FORMAT_PIXEL eFormat )
+{
+	switch(eFormat) {
+		case FORMAT_PIXEL_5650:
+			return Cat_ColorConvert8888To5650( nColor );
+		case FORMAT_PIXEL_5551:
+			return Cat_ColorConvert8888To5551( nColor );
+		default:
+			return Cat_ColorConvert8888To4444( nColor );
+	}
+}
+
+int
+main()
+{
+	static uint16_t anSrc16[TEST_COUNT16];
+	static uint32_t anDest32[TEST_COUNT16];
+	static uint32_t anSrc32[TEST_COUNT32];
+	static uint16_t anDest16[TEST_COUNT32];
+	Cat_Palette* pPalette;
+	Cat_Palette* pPalette16;
+	Cat_Palette* pPalette32;
+	uint32_t nMismatch = 0;
+	uint32_t nError;
+	uint32_t i;
+	uint32_t j;
+	uint32_t n;
+
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	TRACE(( "Cat_ColorConvert test code\n" ));
+
+	for(n = 0; n < TEST_COUNT16; n++) {
+		anSrc16[n] = (uint16_t)n;
+	}
+	srand( 1 );
+	for(n = 0; n < TEST_COUNT32; n++) {
+		anSrc32[n] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+	}
+
+	for(i = 0; i < TEST_FORMAT_COUNT; i++) {
+		// 16bit -> 32bit (全部と、4の倍数でない位置から4の倍数でない数)
+		nError = 0;
+		if(Cat_ColorConvert( anDest32, FORMAT_PIXEL_8888, anSrc16, geFormat[i], TEST_COUNT16 ) < 0) {
+			nError++;
+		}
+		for(n = 0; n < TEST_COUNT16; n++) {
+			if(anDest32[n] != Expand1( anSrc16[n], geFormat[i] )) {
+				nError++;
+			}
+		}
+		anDest32[TEST_COUNT16 - 1] = 0x12345678;
+		if(Cat_ColorConvert( anDest32, FORMAT_PIXEL_8888, &anSrc16[1], geFormat[i], TEST_COUNT16 - 2 ) < 0) {
+			nError++;
+		}
+		for(n = 0; n < TEST_COUNT16 - 2; n++) {
+			if(anDest32[n] != Expand1( anSrc16[n + 1], geFormat[i] )) {
+				nError++;
+			}
+		}
+		if(anDest32[TEST_COUNT16 - 1] != 0x12345678) {
+			nError++;	// 数より後ろに書いている
+		}
+		TRACE(( "%s->8888 error:%d\n", gpszFormat[i], (int)nError ));
+		nMismatch += nError;
+
+		// 32bit -> 16bit
+		nError = 0;
+		if(Cat_ColorConvert( anDest16, geFormat[i], anSrc32, FORMAT_PIXEL_8888, TEST_COUNT32 ) < 0) {
+			nError++;
+		}
+		for(n = 0; n < TEST_COUNT32; n++) {
+			if(anDest16[n] != Compress1( anSrc32[n], geFormat[i] )) {
+				nError++;
+			}
+		}
+		anDest16[TEST_COUNT32 - 1] = 0x1234;
+		if(Cat_ColorConvert( anDest16, geFormat[i], &anSrc32[3], FORMAT_PIXEL_8888, TEST_COUNT32 - 5 ) < 0) {
+			nError++;
+		}
+		for(n = 0; n < TEST_COUNT32 - 5; n++) {
+			if(anDest16[n] != Compress1( anSrc32[n + 3], geFormat[i] )) {
+				nError++;
+			}
+		}
+		if(anDest16[TEST_COUNT32 - 1] != 0x1234) {
+			nError++;
+		}
+		TRACE(( "8888->%s error:%d\n", gpszFormat[i], (int)nError ));
+		nMismatch += nError;
+
+		// 16bit同士(32bitを経由する)
+		for(j = 0; j < TEST_FORMAT_COUNT; j++) {
+			if(j == i) {
+				continue;
+			}
+			nError = 0;
+			if(Cat_ColorConvert( anDest16, geFormat[j], anSrc16, geFormat[i], TEST_COUNT16 ) < 0) {
+				nError++;
+			}
+			for(n = 0; n < TEST_COUNT16; n++) {
+				if(anDest16[n] != Compress1( Expand1( anSrc16[n], geFormat[i] ), geFormat[j] )) {
+					nError++;
+				}
+			}
+			if(nError) {
+				TRACE(( "%s->%s error:%d\n", gpszFormat[i], gpszFormat[j], (int)nError ));
+			}
+			nMismatch += nError;
+		}
+	}
+
+	// パレット(8888から16bitへ変換して、8888へ戻す)
+	nError = 0;
+	pPalette = Cat_PaletteCreate( FORMAT_PALETTE_8888, 256, anSrc32 );
+	if(pPalette == 0) {
+		TRACE(( "Error:Cat_PaletteCreate\n" ));
+		HALT();
+	}
+	for(i = 0; i < TEST_FORMAT_COUNT; i++) {
+		pPalette16 = Cat_PaletteConvert( pPalette, (FORMAT_PALETTE)geFormat[i] );
+		pPalette32 = Cat_PaletteConvert( pPalette16, FORMAT_PALETTE_8888 );
+		if((pPalette16 == 0) || (pPalette32 == 0)
+			|| (pPalette16->ePaletteFormat != (FORMAT_PALETTE)geFormat[i]) || (pPalette16->nMask != 0xFF)) {
+			nError++;
+		} else {
+			for(n = 0; n < 256; n++) {
+				const uint16_t nColor = ((const uint16_t*)pPalette16->pvData)[n];
+				if((nColor != Compress1( anSrc32[n], geFormat[i] ))
+					|| (((const uint32_t*)pPalette32->pvData)[n] != Expand1( nColor, geFormat[i] ))) {
+					nError++;
+				}
+			}
+		}
+		Cat_PaletteRelease( pPalette16 );
+		Cat_PaletteRelease( pPalette32 );
+	}
+	Cat_PaletteRelease( pPalette );
+	TRACE(( "Cat_PaletteConvert error:%d\n", (int)nError ));
+	nMismatch += nError;
+
+	// 対応していないフォーマット
+	if((Cat_ColorConvert( anDest16, FORMAT_PIXEL_CLUT8, anSrc32, FORMAT_PIXEL_8888, 16 ) >= 0)
+		|| (Cat_ColorConvert( anDest32, FORMAT_PIXEL_8888, anSrc16, FORMAT_PIXEL_DXT1, 16 ) >= 0)
+		|| (Cat_ColorConvert( 0, FORMAT_PIXEL_8888, anSrc16, FORMAT_PIXEL_5650, 16 ) >= 0)) {
+		TRACE(( "Error:unsupported format\n" ));
+		nMismatch++;
+	}
+
+	TRACE(( "mismatch:%d\n", (int)nMismatch ));
+	TRACE(( (nMismatch == 0) ? "OK\n" : "NG\n" ));
+
+	HALT();
+	return 0;
+}
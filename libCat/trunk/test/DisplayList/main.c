@@ -0,0 +1,232 @@
+// Cat_DisplayList test code
+// 同じ背景を、毎フレームCat_SpriteBatchで描画する場合と、記録したリストを呼ぶ場合で描画して、
+// 描画結果が同じになることと、1フレームを作る時間と描画パケットが減ることを確かめる
+//
+// 背景は毎フレーム位置をずらし、数フレームごとにパレットを差し替える。
+// 記録した時に画面外のスプライトは記録されないので、背景は画面の内側に置いて、はみ出さない範囲でずらす。
+// テクスチャはVRAMに置けるようにしておき、記録したテクスチャが固定されて解放できないことも確かめる。
+
+#include "Cat_PspCallback.h"
+#include "Cat_DisplayList.h"
+#include "Cat_Render.h"
+#include "Cat_SpriteBatch.h"
+#include "Cat_Texture.h"
+#include "TestCommon.h"
+#include <string.h>
+
+#include <pspdebug.h>
+#include <pspkernel.h>
+#include <pspgu.h>
+
+#define TRACE(x) pspDebugScreenPrintf x
+#define HALT() sceKernelSleepThreadCB()
+
+//! テクスチャの大きさ
+#define TEST_TEXTURE_SIZE (16)
+//! テクスチャの数
+#define TEST_TEXTURE_COUNT (3)
+//! 背景の横のタイル数(画面より1つ少ない)
+#define TEST_TILE_X (480 / TEST_TEXTURE_SIZE - 1)
+//! 背景の縦のタイル数(画面より1つ少ない)
+#define TEST_TILE_Y (272 / TEST_TEXTURE_SIZE - 1)
+//! 背景を置く位置(ずらしても画面からはみ出さないように、半タイル空ける)
+#define TEST_MARGIN (TEST_TEXTURE_SIZE / 2)
+//! 計測するフレーム数
+#define TEST_FRAME_COUNT (60)
+//! リスト1つのサイズ
+#define TEST_LIST_SIZE (64 * 1024)
+
+//! 描画する場面
+typedef struct {
+	Cat_Texture*		pTexture[TEST_TEXTURE_COUNT];	/*!< テクスチャ(8bit)			*/
+	Cat_Palette*		pPalette[2];					/*!< 差し替えるパレット			*/
+	Cat_SpriteBatch*	pBatch;							/*!< バッチ						*/
+} Scene;
+
+//! 背景を描画する
+/*!
+	@param[in]	pScene		場面
+	@param[in]	pPalette	パレット
+	@param[in]	x			ずらす位置X
+	@param[in]	y			ずらす位置Y
+*/
+static void
+DrawScene( Scene* pScene, Cat_Palette* pPalette, int32_t x, int32_t y )
+{
+	Cat_SpriteBatchSprite sprite;
+	uint32_t tx;
+	uint32_t ty;
+
+	Cat_SpriteBatchSpriteInit( &sprite );
+	sprite.pPalette = pPalette;
+	for(ty = 0; ty < TEST_TILE_Y; ty++) {
+		for(tx = 0; tx < TEST_TILE_X; tx++) {
+			sprite.pTexture = pScene->pTexture[(tx + ty * 2) % TEST_TEXTURE_COUNT];
+			sprite.x = (float)(int32_t)(TEST_MARGIN + tx * TEST_TEXTURE_SIZE + x);
+			sprite.y = (float)(int32_t)(TEST_MARGIN + ty * TEST_TEXTURE_SIZE + y);
+			Cat_SpriteBatchAdd( pScene->pBatch, &sprite );
+		}
+	}
+	Cat_SpriteBatchFlush( pScene->pBatch );
+}
+
+//! 背景を記録する
+/*!
+	@param[in]	pList		記録しているリスト
+	@param[in]	pvContext	場面
+*/
+static void
+RecordScene( Cat_DisplayList* pList, void* pvContext )
+{
+	Scene* pScene = (Scene*)pvContext;
+
+	DrawScene( pScene, Cat_DisplayListGetPalette( pList, 0, pScene->pPalette[0] ), 0, 0 );
+}
+
+//! フレームごとのずらす位置を取得する
+/*!
+	@param[in]	nFrame	フレーム
+	@param[out]	px		ずらす位置X
+	@param[out]	py		ずらす位置Y
+*/
+static void
+GetOffset( uint32_t nFrame, int32_t* px, int32_t* py )
+{
+	*px = (int32_t)(nFrame % TEST_TEXTURE_SIZE) - TEST_MARGIN;
+	*py = (int32_t)((nFrame / 2) % TEST_TEXTURE_SIZE) - TEST_MARGIN;
+}
+
+//! 描画して計測する
+/*!
+	@param[in]	pScene		場面
+	@param[in]	pList		記録したリスト(0の場合はバッチで描画する)
+	@param[out]	pnTime		フレームを作るのにかかった時間の合計(マイクロ秒単位)
+	@param[out]	pnSize		1フレームの描画パケットのサイズ(バイト単位)
+	@return	全フレームの画面のチェックサム
+*/
+static uint32_t
+Run( Scene* pScene, Cat_DisplayList* pList, uint32_t* pnTime, uint32_t* pnSize )
+{
+	Cat_RenderListStatistics statistics;
+	uint32_t rc = 0;
+	uint32_t nFrame;
+
+	*pnTime = 0;
+	for(nFrame = 0; nFrame < TEST_FRAME_COUNT; nFrame++) {
+		Cat_Palette* pPalette = pScene->pPalette[(nFrame / 8) % 2];
+		uint32_t nStart;
+		int32_t x;
+		int32_t y;
+
+		GetOffset( nFrame, &x, &y );
+		nStart = sceKernelGetSystemTimeLow();
+		Cat_RenderBegin(); {
+			if(pList) {
+				Cat_DisplayListSetOffset( pList, x, y );
+				Cat_DisplayListSetPalette( pList, 0, pPalette );
+				Cat_DisplayListCall( pList );
+			} else {
+				DrawScene( pScene, pPalette, x, y );
+			}
+		} Cat_RenderEnd();
+		*pnTime += sceKernelGetSystemTimeLow() - nStart;
+		Cat_RenderScreenUpdate();
+		sceGuSync( 0, 0 );
+		rc = rc * 31 + TestGetScreenChecksum();
+	}
+	Cat_RenderGetListStatistics( &statistics );
+	*pnSize = statistics.nSize;
+	return rc;
+}
+
+int
+main()
+{
+	Scene scene;
+	Cat_DisplayList* pList;
+	Cat_DisplayListStatistics statistics;
+	uint32_t anColor[256];
+	uint32_t nTime[2];
+	uint32_t nSize[2];
+	uint32_t nChecksum[2];
+	uint32_t nPinned = 0;
+	uint32_t nUnloaded = 0;
+	uint32_t i;
+	uint32_t j;
+
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	TRACE(( "Cat_DisplayList test code\n" ));
+
+	memset( &scene, 0, sizeof(scene) );
+	for(i = 0; i < 2; i++) {
+		for(j = 0; j < 256; j++) {
+			anColor[j] = 0xFF000000 | (i ? (j * 0x010203) : (j * 0x030201));
+		}
+		scene.pPalette[i] = Cat_PaletteCreate( FORMAT_PALETTE_8888, 256, anColor );
+		if(scene.pPalette[i] == 0) {
+			TRACE(( "Error:Cat_PaletteCreate\n" ));
+			HALT();
+		}
+	}
+	for(i = 0; i < TEST_TEXTURE_COUNT; i++) {
+		scene.pTexture[i] = TestCreateTexture( TEST_TEXTURE_SIZE, i + 2, scene.pPalette[0] );
+		if(scene.pTexture[i] == 0) {
+			TRACE(( "Error:Cat_TextureCreate\n" ));
+			HALT();
+		}
+	}
+	scene.pBatch = Cat_SpriteBatchCreate( TEST_TILE_X * TEST_TILE_Y );
+	if(scene.pBatch == 0) {
+		TRACE(( "Error:Cat_SpriteBatchCreate\n" ));
+		HALT();
+	}
+
+	Cat_RenderInit( CAT_RENDER_PARAM_FORMAT_RGBA8888 | CAT_RENDER_PARAM_BUFFER_SINGLE | CAT_RENDER_PARAM_VRAM_TEXTURE );
+	pList = Cat_DisplayListCreate( TEST_LIST_SIZE, RecordScene, &scene );
+	if(pList == 0) {
+		Cat_RenderTerm();
+		pspDebugScreenInit();
+		TRACE(( "Error:Cat_DisplayListCreate\n" ));
+		HALT();
+	}
+	// 記録したテクスチャは固定されるので、解放しようとしても残る
+	for(i = 0; i < TEST_TEXTURE_COUNT; i++) {
+		if(Cat_TextureIsPinned( scene.pTexture[i] )) {
+			nPinned++;
+		}
+		nUnloaded += Cat_TextureUnload( scene.pTexture[i] );
+	}
+	nChecksum[0] = Run( &scene, 0, &nTime[0], &nSize[0] );
+	nChecksum[1] = Run( &scene, pList, &nTime[1], &nSize[1] );
+	Cat_DisplayListGetStatistics( pList, &statistics );
+	Cat_RenderTerm();
+
+	TestResetDebugScreen();
+	for(i = 0; i < 2; i++) {
+		TRACE(( "%s: %5dus/frame packet %6d bytes/frame checksum %08X\n", i ? "list " : "batch",
+			(int)(nTime[i] / TEST_FRAME_COUNT), (int)nSize[i], (unsigned int)nChecksum[i] ));
+	}
+	TRACE(( "list:%d bytes vertex:%d calls:%d patches:%d patched vertex:%d\n", (int)statistics.nSize,
+		(int)statistics.nVertexCount, (int)statistics.nCallCount, (int)statistics.nPatchCount,
+		(int)statistics.nPatchVertexCount ));
+	Cat_DisplayListDestroy( pList );
+	for(i = 0; i < TEST_TEXTURE_COUNT; i++) {
+		if(Cat_TextureIsPinned( scene.pTexture[i] )) {
+			nPinned++;	// 破棄した後も固定されたまま
+		}
+	}
+	TRACE(( "pinned:%d unloaded:%d bytes\n", (int)nPinned, (int)nUnloaded ));
+	TestPrintResult( (nChecksum[0] == nChecksum[1]) && (nSize[1] < nSize[0]) && (statistics.nCallCount == TEST_FRAME_COUNT)
+		&& (statistics.nOverflowCount == 0) && (nPinned == TEST_TEXTURE_COUNT) && (nUnloaded == 0) );
+
+	Cat_SpriteBatchDestroy( scene.pBatch );
+	for(i = 0; i < TEST_TEXTURE_COUNT; i++) {
+		Cat_TextureRelease( scene.pTexture[i] );
+	}
+	Cat_PaletteRelease( scene.pPalette[0] );
+	Cat_PaletteRelease( scene.pPalette[1] );
+	HALT();
+	return 0;
+}
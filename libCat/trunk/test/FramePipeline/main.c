@@ -0,0 +1,241 @@
+// Cat_FramePipeline test code
+// ゲームの処理と描画を同じスレッドで行う場合と、別のスレッドで行う場合で、
+// 1フレームにかかる時間と、渡してから画面を更新するまでの時間を比べる
+//
+// ゲームの処理は、スプライトを動かした後で重い処理の代わりに一定時間待ち、60フレーム毎秒に合わせて休む。
+// 描画する関数の中で、スナップショットが書きかけでないことと、フレームが戻らないことを確かめる。
+
+#include "Cat_PspCallback.h"
+#include "Cat_FramePipeline.h"
+#include "Cat_Render.h"
+#include "Cat_SpriteBatch.h"
+#include "Cat_Texture.h"
+#ifdef USE_CAT_SOFTRENDER
+#include "Cat_SoftRender.h"
+#endif
+#include "TestCommon.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include <pspdebug.h>
+#include <pspkernel.h>
+#include <pspthreadman.h>
+
+#define TRACE(x) pspDebugScreenPrintf x
+#define HALT() sceKernelSleepThreadCB()
+
+//! テクスチャの大きさ
+#define TEST_TEXTURE_SIZE (16)
+//! スプライト数
+#define TEST_SPRITE_COUNT (2000)
+//! 計測するフレーム数
+#define TEST_FRAME_COUNT (120)
+//! 1フレームの時間(マイクロ秒単位)
+#define TEST_FRAME_TIME (1000000 / 60)
+//! ゲームの処理にかかる時間(マイクロ秒単位)
+#define TEST_WORK_TIME (6000)
+//! 描画するスレッドの優先度
+#define TEST_THREAD_PRIORITY (0x10)
+
+//! 描画する関数で確かめた結果
+typedef struct {
+	uint32_t	nLastFrame;		/*!< 前に描画したフレーム			*/
+	uint32_t	nTearCount;		/*!< 書きかけだったスナップショット数	*/
+	uint32_t	nBackCount;		/*!< フレームが戻った回数			*/
+} Check;
+
+//! スプライトの画面上の位置を取得する
+/*!
+	@param[in]	nIndex	スプライトの番号
+	@param[in]	nFrame	フレーム
+	@param[out]	px		位置X
+	@param[out]	py		位置Y
+*/
+static void
+GetScreenPosition( uint32_t nIndex, uint32_t nFrame, float* px, float* py )
+{
+	*px = (float)((nIndex * 7 + nFrame * 3) % (480 - TEST_TEXTURE_SIZE));
+	*py = (float)((nIndex * 13 + nFrame) % (272 - TEST_TEXTURE_SIZE));
+}
+
+//! スプライトの後に描画する関数
+/*!
+	@param[in]	pSnapshot	描画しているスナップショット
+	@param[in]	pvContext	確かめた結果
+*/
+static void
+DrawCheck( const Cat_FrameSnapshot* pSnapshot, void* pvContext )
+{
+	Check* pCheck = (Check*)pvContext;
+	uint32_t i;
+
+	if(pSnapshot->nFrame <= pCheck->nLastFrame) {
+		pCheck->nBackCount++;
+	}
+	pCheck->nLastFrame = pSnapshot->nFrame;
+	if(pSnapshot->nSpriteCount != TEST_SPRITE_COUNT) {
+		pCheck->nTearCount++;
+		return;
+	}
+	for(i = 0; i < pSnapshot->nSpriteCount; i++) {
+		float x;
+		float y;
+		GetScreenPosition( i, pSnapshot->nFrame, &x, &y );
+		if((pSnapshot->pSprite[i].x - pSnapshot->fCameraX != x) || (pSnapshot->pSprite[i].y - pSnapshot->fCameraY != y)) {
+			pCheck->nTearCount++;
+			return;
+		}
+	}
+}
+
+//! 重い処理の代わりに待つ
+/*!
+	@param[in]	nTime	待つ時間(マイクロ秒単位)
+*/
+static void
+Work( uint32_t nTime )
+{
+	const uint32_t nStart = sceKernelGetSystemTimeLow();
+
+	while(sceKernelGetSystemTimeLow() - nStart < nTime) {
+	}
+}
+
+//! ゲームの処理を行って計測する
+/*!
+	@param[in]	pPipeline	パイプライン
+	@param[in]	pTexture	テクスチャ
+	@param[in]	pPalette	パレット
+	@param[in]	fThread		描画するスレッドを使うかどうか
+	@param[out]	pnTime		1フレームにかかった時間の合計(マイクロ秒単位)
+	@param[out]	pStatistics	統計情報
+	@return	成功した場合は、0 \n
+			失敗した場合は、負数が返る
+*/
+static int32_t
+Run( Cat_FramePipeline* pPipeline, Cat_Texture* pTexture, Cat_Palette* pPalette, int fThread, uint32_t* pnTime,
+	Cat_FramePipelineStatistics* pStatistics )
+{
+	Cat_SpriteBatchSprite sprite;
+	uint32_t nFrame;
+	uint32_t nStart;
+	uint32_t i;
+
+	Cat_FramePipelineResetStatistics( pPipeline );
+	if(fThread && (Cat_FramePipelineStart( pPipeline, TEST_THREAD_PRIORITY ) < 0)) {
+		return -1;
+	}
+	Cat_SpriteBatchSpriteInit( &sprite );
+	sprite.pTexture = pTexture;
+	nStart = sceKernelGetSystemTimeLow();
+	for(nFrame = 0; nFrame < TEST_FRAME_COUNT; nFrame++) {
+		const uint32_t nFrameStart = sceKernelGetSystemTimeLow();
+		Cat_FrameSnapshot* pSnapshot = Cat_FramePipelineBeginSnapshot( pPipeline );
+		uint32_t nTime;
+
+		// Submit()で付く番号は、1から始まる
+		pSnapshot->fCameraX = (float)(nFrame + 1) * 2.0f;
+		pSnapshot->fCameraY = (float)(nFrame + 1);
+		sprite.pPalette = Cat_FrameSnapshotSetPalette( pSnapshot, nFrame % CAT_FRAMEPIPELINE_PALETTE_MAX, pPalette );
+		for(i = 0; i < TEST_SPRITE_COUNT; i++) {
+			GetScreenPosition( i, nFrame + 1, &sprite.x, &sprite.y );
+			sprite.x += pSnapshot->fCameraX;
+			sprite.y += pSnapshot->fCameraY;
+			Cat_FrameSnapshotAddSprite( pSnapshot, &sprite );
+		}
+		Work( TEST_WORK_TIME );
+		Cat_FramePipelineSubmit( pPipeline );
+		if(!fThread) {
+			Cat_FramePipelineRender( pPipeline );
+		}
+
+		// 1フレームの時間に合わせて休む
+		nTime = sceKernelGetSystemTimeLow() - nFrameStart;
+		if(nTime < TEST_FRAME_TIME) {
+			sceKernelDelayThread( TEST_FRAME_TIME - nTime );
+		}
+	}
+	*pnTime = sceKernelGetSystemTimeLow() - nStart;
+	if(fThread) {
+		// 最後のスナップショットを描画するまで待つ
+		sceKernelDelayThread( TEST_FRAME_TIME * 3 );
+		Cat_FramePipelineStop( pPipeline );
+	}
+	Cat_FramePipelineGetStatistics( pPipeline, pStatistics );
+	return 0;
+}
+
+int
+main()
+{
+	Cat_FramePipeline* pPipeline;
+	Cat_FramePipelineStatistics statistics[2];
+	Cat_Palette* pPalette;
+	Cat_Texture* pTexture;
+	Check check[2];
+	uint8_t abImage[TEST_TEXTURE_SIZE * TEST_TEXTURE_SIZE];
+	uint32_t anColor[256];
+	uint32_t nTime[2];
+	int32_t nResult[2];
+	int fOk;
+	uint32_t i;
+
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	TRACE(( "Cat_FramePipeline test code\n" ));
+
+	for(i = 0; i < 256; i++) {
+		anColor[i] = 0xFF000000 | (i * 0x010203);
+	}
+	pPalette = Cat_PaletteCreate( FORMAT_PALETTE_8888, 256, anColor );
+	for(i = 0; i < TEST_TEXTURE_SIZE * TEST_TEXTURE_SIZE; i++) {
+		abImage[i] = (uint8_t)i;
+	}
+	pTexture = Cat_TextureCreate( TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE, abImage, FORMAT_PIXEL_CLUT8, pPalette );
+	if((pPalette == 0) || (pTexture == 0)) {
+		TRACE(( "Error:Cat_TextureCreate\n" ));
+		HALT();
+	}
+
+#ifdef USE_CAT_SOFTRENDER
+	Cat_SoftRenderSetRefreshRate( 60 );
+#endif
+	Cat_RenderInit( CAT_RENDER_PARAM_FORMAT_RGBA8888 );
+	memset( check, 0, sizeof(check) );
+	for(i = 0; i < 2; i++) {
+		pPipeline = Cat_FramePipelineCreate( TEST_SPRITE_COUNT, DrawCheck, &check[i] );
+		if(pPipeline == 0) {
+			Cat_RenderTerm();
+			pspDebugScreenInit();
+			TRACE(( "Error:Cat_FramePipelineCreate\n" ));
+			HALT();
+		}
+		nResult[i] = Run( pPipeline, pTexture, pPalette, i, &nTime[i], &statistics[i] );
+		Cat_FramePipelineDestroy( pPipeline );
+	}
+	Cat_RenderTerm();
+
+	TestResetDebugScreen();
+	fOk = 1;
+	for(i = 0; i < 2; i++) {
+		const Cat_FramePipelineStatistics* pStatistics = &statistics[i];
+		const uint32_t nCount = pStatistics->nRenderCount ? pStatistics->nRenderCount : 1;
+		TRACE(( "%s: %5dus/frame render %5dus (max %5dus) latency %5dus (max %5dus)\n", i ? "thread" : "serial",
+			(int)(nTime[i] / TEST_FRAME_COUNT), (int)(pStatistics->nRenderTime / nCount), (int)pStatistics->nRenderTimeMax,
+			(int)(pStatistics->nLatency / nCount), (int)pStatistics->nLatencyMax ));
+		TRACE(( "        submit:%d render:%d drop:%d idle:%d tear:%d back:%d\n", (int)pStatistics->nSubmitCount,
+			(int)pStatistics->nRenderCount, (int)pStatistics->nDropCount, (int)pStatistics->nIdleCount,
+			(int)check[i].nTearCount, (int)check[i].nBackCount ));
+		if((nResult[i] < 0) || (pStatistics->nRenderCount == 0) || (check[i].nTearCount != 0) || (check[i].nBackCount != 0)
+			|| (pStatistics->nRenderCount + pStatistics->nDropCount != pStatistics->nSubmitCount)) {
+			fOk = 0;
+		}
+	}
+	TestPrintResult( fOk );
+
+	Cat_TextureRelease( pTexture );
+	Cat_PaletteRelease( pPalette );
+	HALT();
+	return 0;
+}
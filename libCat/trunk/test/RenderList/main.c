@@ -0,0 +1,143 @@
+// Cat_Render test code
+// 描画パケットの使用量の計測と、溢れた時の分割を確かめる
+//
+// 1枚ずつCat_TextureDraw()で大量のスプライトを描画して、1フレームで使ったサイズと分割の数を表示する。
+// 予算を小さくした場合は、分割をつないでも足りなくなるが、溢れずに描画が捨てられることを確かめる。
+
+#include "Cat_PspCallback.h"
+#include "Cat_Render.h"
+#include "Cat_SpriteBatch.h"
+#include "Cat_Texture.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include <pspdebug.h>
+#include <pspkernel.h>
+#include <pspgu.h>
+
+#define TRACE(x) pspDebugScreenPrintf x
+#define HALT() sceKernelSleepThreadCB()
+
+//! テクスチャの大きさ
+#define TEST_TEXTURE_SIZE (16)
+//! 1フレームに描画するスプライトの数
+#define TEST_DRAW_COUNT (20000)
+//! 計測するフレーム数
+#define TEST_FRAME_COUNT (30)
+
+//! テスト用のテクスチャを作成する
+/*!
+	@return	作成されたテクスチャ。失敗した場合は0が返る。
+*/
+static Cat_Texture*
+CreateTestTexture( void )
+{
+	uint32_t anImage[TEST_TEXTURE_SIZE * TEST_TEXTURE_SIZE];
+	uint32_t i;
+
+	for(i = 0; i < TEST_TEXTURE_SIZE * TEST_TEXTURE_SIZE; i++) {
+		anImage[i] = 0xFF000000 | (i * 0x010305);
+	}
+	return Cat_TextureCreate( TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE * 4, anImage, FORMAT_PIXEL_8888, 0 );
+}
+
+//! 予算を変えて描画する
+/*!
+	@param[in]	pszName		表示する名前
+	@param[in]	nBudget		描画パケットに使うメモリ(バイト単位)
+	@param[in]	fBatch		Cat_SpriteBatchで描画するかどうか
+	@param[out]	pStatistics	統計情報
+	@return	描画したスプライト数
+*/
+static uint32_t
+Run( const char* pszName, uint32_t nBudget, int fBatch, Cat_RenderListStatistics* pStatistics )
+{
+	Cat_Texture* pTexture;
+	Cat_SpriteBatch* pBatch = 0;
+	Cat_SpriteBatchSprite sprite;
+	Cat_SpriteBatchStatistics batch;
+	uint32_t nDraw = 0;
+	uint32_t nFrame;
+	uint32_t i;
+
+	Cat_RenderSetListBudget( nBudget, 0 );
+	Cat_RenderInit( CAT_RENDER_DEFAULT );
+	pTexture = CreateTestTexture();
+	if(fBatch) {
+		pBatch = Cat_SpriteBatchCreate( TEST_DRAW_COUNT );
+	}
+	if((pTexture == 0) || (fBatch && (pBatch == 0))) {
+		Cat_RenderTerm();
+		pspDebugScreenInit();
+		TRACE(( "Error:create\n" ));
+		HALT();
+	}
+	Cat_SpriteBatchSpriteInit( &sprite );
+	sprite.pTexture = pTexture;
+
+	for(nFrame = 0; nFrame < TEST_FRAME_COUNT; nFrame++) {
+		Cat_RenderBegin(); {
+			for(i = 0; i < TEST_DRAW_COUNT; i++) {
+				const float x = (float)((i * 7 + nFrame) % (480 - TEST_TEXTURE_SIZE));
+				const float y = (float)((i * 13) % (272 - TEST_TEXTURE_SIZE));
+				if(fBatch) {
+					sprite.x = x;
+					sprite.y = y;
+					Cat_SpriteBatchAdd( pBatch, &sprite );
+				} else {
+					nDraw += Cat_TextureDraw( pTexture, x, y, TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE );
+				}
+			}
+			if(fBatch) {
+				Cat_SpriteBatchFlush( pBatch );
+			}
+		} Cat_RenderEnd();
+		Cat_RenderScreenUpdate();
+	}
+	Cat_RenderGetListStatistics( pStatistics );
+	if(fBatch) {
+		Cat_SpriteBatchGetStatistics( pBatch, &batch );
+		nDraw = batch.nSpriteCount;
+		Cat_SpriteBatchDestroy( pBatch );
+	}
+	Cat_TextureRelease( pTexture );
+	Cat_RenderTerm();
+
+	pspDebugScreenInit();
+	TRACE(( "%s: budget %7d bytes, %d sprites/frame\n", pszName, (int)pStatistics->nBudget, TEST_DRAW_COUNT ));
+	TRACE(( "  size %7d max %7d bytes, segments %2d max %2d\n", (int)pStatistics->nSize, (int)pStatistics->nSizeMax,
+		(int)pStatistics->nSegmentCount, (int)pStatistics->nSegmentCountMax ));
+	TRACE(( "  memory %5d allocations %7d bytes/frame\n", (int)pStatistics->nMemoryCount, (int)pStatistics->nMemorySize ));
+	TRACE(( "  chain %d stall %d overflow %d drawn %d/%d\n", (int)pStatistics->nChainCount, (int)pStatistics->nStallCount,
+		(int)pStatistics->nOverflowCount, (int)nDraw, TEST_DRAW_COUNT * TEST_FRAME_COUNT ));
+	return nDraw;
+}
+
+int
+main()
+{
+	Cat_RenderListStatistics statistics[3];
+	uint32_t nDraw[3];
+
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	TRACE(( "Cat_Render list test code\n" ));
+
+	// 既定の予算: 分割をつなげば、全て描画できる
+	nDraw[0] = Run( "direct default", 0, 0, &statistics[0] );
+	// 小さい予算: 描画中のフレームを待っても足りないので、溢れる分が捨てられる
+	nDraw[1] = Run( "direct 256KB  ", 256 * 1024, 0, &statistics[1] );
+	// バッチは設定と描画の命令が少ないので、頂点の分(1フレーム400KB)があれば足りる
+	nDraw[2] = Run( "batch 512KB   ", 512 * 1024, 1, &statistics[2] );
+
+	if((nDraw[0] == TEST_DRAW_COUNT * TEST_FRAME_COUNT) && (statistics[0].nChainCount > 0) && (statistics[0].nOverflowCount == 0)
+		&& (nDraw[1] < nDraw[0]) && (statistics[1].nOverflowCount > 0)
+		&& (nDraw[2] == TEST_DRAW_COUNT * TEST_FRAME_COUNT) && (statistics[2].nOverflowCount == 0)) {
+		TRACE(( "OK\n" ));
+	} else {
+		TRACE(( "NG\n" ));
+	}
+	HALT();
+	return 0;
+}
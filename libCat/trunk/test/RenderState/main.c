@@ -0,0 +1,117 @@
+// Cat_RenderState test code
+// 同じ描画を、描画ステートのキャッシュを使わない場合と使う場合で2回行って、
+// 描画パケットが小さくなることと、描画結果が同じになることを確かめる
+//
+
+#include "Cat_PspCallback.h"
+#include "Cat_Render.h"
+#include "Cat_RenderState.h"
+#include "Cat_Texture.h"
+#include "TestCommon.h"
+
+#include <pspdebug.h>
+#include <pspkernel.h>
+#include <pspgu.h>
+
+#define TRACE(x) pspDebugScreenPrintf x
+#define HALT() sceKernelSleepThreadCB()
+
+//! テクスチャの大きさ
+#define TEST_TEXTURE_SIZE (64)
+//! テクスチャの数
+#define TEST_TEXTURE_COUNT (3)
+//! 描画するスプライトの数
+#define TEST_DRAW_COUNT (240)
+
+//! 描画ステートの名前
+static const char* gpszState[CAT_RENDERSTATE_MAX] = {
+	"enable", "texmode", "teximage", "texscale", "clutmode", "clutload", "blend",
+};
+
+//! 決まった順番で描画する
+/*!
+	8枚ずつ同じテクスチャが続き、32枚ごとに加算ブレンドと半透明を切り替える。
+	@param[in]	ppTexture	テクスチャ
+*/
+static void
+DrawSequence( Cat_Texture** ppTexture )
+{
+	uint32_t i;
+
+	for(i = 0; i < TEST_DRAW_COUNT; i++) {
+		Cat_Texture* pTexture = ppTexture[(i / 8) % TEST_TEXTURE_COUNT];
+		const float x = (float)((i * 37) % (480 - TEST_TEXTURE_SIZE));
+		const float y = (float)((i * 23) % (272 - TEST_TEXTURE_SIZE));
+		if((i / 32) & 1) {
+			Cat_RenderStateBlendFunc( GU_ADD, GU_SRC_ALPHA, GU_FIX, 0, 0xFFFFFF );
+		} else {
+			Cat_RenderStateBlendFunc( GU_ADD, GU_SRC_ALPHA, GU_ONE_MINUS_SRC_ALPHA, 0, 0 );
+		}
+		Cat_TextureDraw( pTexture, x, y, TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE );
+	}
+}
+
+int
+main()
+{
+	Cat_Texture* pTexture[TEST_TEXTURE_COUNT];
+	Cat_Palette* pPalette;
+	uint32_t anColor[256];
+	Cat_RenderStateStatistics statistics[2];
+	uint32_t nSize[2];
+	uint32_t nChecksum[2];
+	uint32_t i;
+	uint32_t j;
+
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	TRACE(( "Cat_RenderState test code\n" ));
+
+	for(i = 0; i < 256; i++) {
+		anColor[i] = 0xFF000000 | (i * 0x030201);
+	}
+	pPalette = Cat_PaletteCreate( FORMAT_PALETTE_8888, 256, anColor );
+	if(pPalette == 0) {
+		TRACE(( "Error:Cat_PaletteCreate\n" ));
+		HALT();
+	}
+	for(i = 0; i < TEST_TEXTURE_COUNT; i++) {
+		pTexture[i] = TestCreateTexture( TEST_TEXTURE_SIZE, i, (i == 2) ? 0 : pPalette );
+		if(pTexture[i] == 0) {
+			TRACE(( "Error:Cat_TextureCreate\n" ));
+			HALT();
+		}
+	}
+
+	Cat_RenderInit( CAT_RENDER_PARAM_FORMAT_RGBA8888 | CAT_RENDER_PARAM_BUFFER_SINGLE );
+	for(i = 0; i < 2; i++) {
+		Cat_RenderStateSetEnable( i );
+		Cat_RenderStateResetStatistics();
+		Cat_RenderBegin(); {
+			DrawSequence( pTexture );
+			nSize[i] = (uint32_t)sceGuCheckList();
+		} Cat_RenderEnd();
+		Cat_RenderScreenUpdate();
+		sceGuSync( 0, 0 );
+		nChecksum[i] = TestGetScreenChecksum();
+		Cat_RenderStateGetStatistics( &statistics[i] );
+	}
+	Cat_RenderTerm();
+
+	TestResetDebugScreen();
+	for(i = 0; i < 2; i++) {
+		TRACE(( "cache %s: packet %d bytes, checksum %08X\n", i ? "on " : "off", (int)nSize[i], (unsigned int)nChecksum[i] ));
+		for(j = 0; j < CAT_RENDERSTATE_MAX; j++) {
+			TRACE(( "  %-8s request:%4d issue:%4d\n", gpszState[j], (int)statistics[i].nRequest[j], (int)statistics[i].nIssue[j] ));
+		}
+	}
+	TestPrintResult( (nSize[1] < nSize[0]) && (nChecksum[0] == nChecksum[1]) );
+
+	for(i = 0; i < TEST_TEXTURE_COUNT; i++) {
+		Cat_TextureRelease( pTexture[i] );
+	}
+	Cat_PaletteRelease( pPalette );
+	HALT();
+	return 0;
+}
@@ -0,0 +1,220 @@
+// Cat_Render frame statistics test code
+// 縁が透明なスプライトを、重ならないように並べた場面と、同じ位置に重ねた場面を描画して、
+// フレームの統計情報の描画の回数、頂点の数、ピクセル数の見積もりが、描いたものと合うことを確かめる。
+// 同じ場面を記録したリストを呼んだ場合も同じ値になることと、画面表示の分が加わることも確かめる。
+//
+// ソフトウェア描画では、重ね描きを数えて、重ねた場面だけピクセルあたりの回数が増えることと、
+// 透明な縁の分が透明なピクセルとして数えられることを確かめる。
+
+#include "Cat_PspCallback.h"
+#include "Cat_DisplayList.h"
+#include "Cat_Render.h"
+#include "Cat_RenderOverlay.h"
+#include "Cat_SpriteBatch.h"
+#include "Cat_Texture.h"
+#ifdef USE_CAT_SOFTRENDER
+#include "Cat_SoftRender.h"
+#endif
+#include "TestCommon.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pspdebug.h>
+#include <pspgu.h>
+#include <pspkernel.h>
+
+#define TRACE(x) pspDebugScreenPrintf x
+#define HALT() sceKernelSleepThreadCB()
+
+//! テクスチャの大きさ
+#define TEST_TEXTURE_SIZE (32)
+//! 透明な縁の幅
+#define TEST_BORDER (8)
+//! スプライト数
+#define TEST_SPRITE_COUNT (8)
+//! 場面ごとに描画するフレーム数
+#define TEST_FRAME_COUNT (10)
+//! リスト1つのサイズ
+#define TEST_LIST_SIZE (16 * 1024)
+
+//! 場面
+enum {
+	SCENE_SPREAD = 0,		/*!< 重ならないように並べる				*/
+	SCENE_STACK,			/*!< 同じ位置に重ねる					*/
+	SCENE_LIST,				/*!< 重ならない場面を記録したリストを呼ぶ	*/
+	SCENE_OVERLAY,			/*!< 重ならない場面と画面表示			*/
+	SCENE_COUNT
+};
+
+//! 縁が透明なテクスチャ
+static Cat_Texture* gpTexture = 0;
+//! バッチ
+static Cat_SpriteBatch* gpBatch = 0;
+
+//! スプライトを並べて描画する
+/*!
+	@param[in]	fStack	同じ位置に重ねる場合は1
+*/
+static void
+DrawSprites( int fStack )
+{
+	Cat_SpriteBatchSprite sprite;
+	uint32_t i;
+
+	Cat_SpriteBatchSpriteInit( &sprite );
+	sprite.pTexture = gpTexture;
+	for(i = 0; i < TEST_SPRITE_COUNT; i++) {
+		sprite.x = fStack ? 100.0f : (float)(8 + i * (TEST_TEXTURE_SIZE + 8));
+		sprite.y = fStack ? 100.0f : 40.0f;
+		Cat_SpriteBatchAdd( gpBatch, &sprite );
+	}
+	Cat_SpriteBatchFlush( gpBatch );
+}
+
+//! 重ならない場面を記録する
+/*!
+	@param[in]	pList		記録しているリスト
+	@param[in]	pvContext	未使用
+*/
+static void
+RecordSprites( Cat_DisplayList* pList, void* pvContext )
+{
+	(void)pList;
+	(void)pvContext;
+	DrawSprites( 0 );
+}
+
+int
+main()
+{
+	static const char* apszScene[SCENE_COUNT] = { "spread", "stack", "list", "overlay" };
+	Cat_RenderFrameStatistics last[SCENE_COUNT];
+	Cat_RenderFrameStatistics average[SCENE_COUNT];
+	Cat_DisplayList* pList;
+	Cat_RenderOverlay* pOverlay;
+	uint32_t* pnImage;
+	uint32_t nPixel;
+	uint32_t nScene;
+	uint32_t nFrame;
+	uint32_t x;
+	uint32_t y;
+	int fOk;
+#ifdef USE_CAT_SOFTRENDER
+	Cat_SoftRenderOverdraw overdraw[SCENE_COUNT];
+#endif
+
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	TRACE(( "Cat_Render frame statistics test code\n" ));
+
+	pnImage = (uint32_t*)malloc( TEST_TEXTURE_SIZE * TEST_TEXTURE_SIZE * sizeof(uint32_t) );
+	if(pnImage == 0) {
+		HALT();
+	}
+	for(y = 0; y < TEST_TEXTURE_SIZE; y++) {
+		for(x = 0; x < TEST_TEXTURE_SIZE; x++) {
+			const int fBorder = (x < TEST_BORDER) || (y < TEST_BORDER)
+				|| (x >= TEST_TEXTURE_SIZE - TEST_BORDER) || (y >= TEST_TEXTURE_SIZE - TEST_BORDER);
+			pnImage[x + y * TEST_TEXTURE_SIZE] = fBorder ? 0x00000000 : 0xFF40A0E0;
+		}
+	}
+	gpTexture = Cat_TextureCreate( TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE * sizeof(uint32_t), pnImage,
+		FORMAT_PIXEL_8888, 0 );
+	free( pnImage );
+	gpBatch  = Cat_SpriteBatchCreate( TEST_SPRITE_COUNT );
+	pOverlay = Cat_RenderOverlayCreate();
+	if((gpTexture == 0) || (gpBatch == 0) || (pOverlay == 0)) {
+		TRACE(( "Error:Create\n" ));
+		HALT();
+	}
+
+	Cat_RenderInit( CAT_RENDER_DEFAULT );
+	Cat_RenderEnablePixelCount( 1 );
+#ifdef USE_CAT_SOFTRENDER
+	Cat_SoftRenderEnableOverdraw( 1 );
+#endif
+	pList = Cat_DisplayListCreate( TEST_LIST_SIZE, RecordSprites, 0 );
+	if(pList == 0) {
+		TRACE(( "Error:Cat_DisplayListCreate\n" ));
+		HALT();
+	}
+
+	for(nScene = 0; nScene < SCENE_COUNT; nScene++) {
+		Cat_RenderResetFrameStatistics();
+		for(nFrame = 0; nFrame < TEST_FRAME_COUNT; nFrame++) {
+			Cat_RenderBegin(); {
+				if(nScene == SCENE_LIST) {
+					Cat_DisplayListCall( pList );
+				} else {
+					DrawSprites( nScene == SCENE_STACK );
+				}
+				if(nScene == SCENE_OVERLAY) {
+					Cat_RenderOverlayDraw( pOverlay, 4, 4 );
+				}
+			} Cat_RenderEnd();
+			Cat_RenderScreenUpdate();
+#ifdef USE_CAT_SOFTRENDER
+			// 前のフレームの分は読み捨てて、最後のフレームの分を残す
+			Cat_SoftRenderReadOverdraw( 0, 0, &overdraw[nScene] );
+#endif
+		}
+		Cat_RenderGetFrameStatistics( CAT_RENDER_FRAME_LAST, &last[nScene] );
+		Cat_RenderGetFrameStatistics( CAT_RENDER_FRAME_AVERAGE, &average[nScene] );
+	}
+	Cat_RenderTerm();
+	Cat_DisplayListDestroy( pList );
+
+	TestResetDebugScreen();
+	nPixel = TEST_SPRITE_COUNT * TEST_TEXTURE_SIZE * TEST_TEXTURE_SIZE;
+	fOk = 1;
+	for(nScene = 0; nScene < SCENE_COUNT; nScene++) {
+		const Cat_RenderFrameStatistics* p = &last[nScene];
+		const uint32_t nExtra = (nScene == SCENE_OVERLAY) ? 1 : 0;
+		TRACE(( "%-8s draw:%d vertex:%d pixel:%d texture:%d palette:%d list:%d time:%dus\n", apszScene[nScene],
+			(int)p->nDrawCount, (int)p->nVertexCount, (int)p->nPixelCount, (int)p->nTextureCount,
+			(int)p->nPaletteCount, (int)p->nListSize, (int)p->nTime ));
+		if((p->nDrawCount != last[SCENE_SPREAD].nDrawCount + nExtra)
+			|| (p->nTextureCount != last[SCENE_SPREAD].nTextureCount + nExtra)
+			|| (p->nPaletteCount != nExtra) || (p->nListSize == 0)) {
+			fOk = 0;
+		}
+		// 画面表示は数値の桁で頂点の数が変わるので、平均が前のフレームと同じになるのは場面だけ
+		if((nScene != SCENE_OVERLAY) && (memcmp( &average[nScene], p, offsetof( Cat_RenderFrameStatistics, nTime ) ) != 0)) {
+			fOk = 0;
+		}
+		if(nScene != SCENE_OVERLAY) {
+			if((p->nVertexCount != TEST_SPRITE_COUNT * 2) || (p->nPixelCount != nPixel)) {
+				fOk = 0;
+			}
+		} else if((p->nVertexCount <= TEST_SPRITE_COUNT * 2) || (p->nPixelCount <= nPixel)) {
+			fOk = 0;
+		}
+#ifdef USE_CAT_SOFTRENDER
+		{
+			const Cat_SoftRenderOverdraw* pOverdraw = &overdraw[nScene];
+			const uint32_t nStack = (nScene == SCENE_STACK) ? TEST_SPRITE_COUNT : 1;
+			TRACE(( "         fragment:%d transparent:%d covered:%d max:%d\n", (int)pOverdraw->nFragmentCount,
+				(int)pOverdraw->nTransparentCount, (int)pOverdraw->nCoveredCount, (int)pOverdraw->nMax ));
+			if(nScene != SCENE_OVERLAY) {
+				if((pOverdraw->nFragmentCount != nPixel) || (pOverdraw->nMax != nStack)
+					|| (pOverdraw->nCoveredCount != nPixel / nStack)
+					|| (pOverdraw->nTransparentCount != nPixel - TEST_SPRITE_COUNT * (TEST_TEXTURE_SIZE - TEST_BORDER * 2) * (TEST_TEXTURE_SIZE - TEST_BORDER * 2))) {
+					fOk = 0;
+				}
+			} else if(pOverdraw->nFragmentCount != p->nPixelCount) {
+				// 画面表示も画面の中なので、見積もりと数えたものが合う
+				fOk = 0;
+			}
+		}
+#endif
+	}
+	TestPrintResult( fOk );
+
+	Cat_RenderOverlayDestroy( pOverlay );
+	Cat_SpriteBatchDestroy( gpBatch );
+	Cat_TextureRelease( gpTexture );
+	HALT();
+	return 0;
+}
@@ -0,0 +1,327 @@
+// Cat_SoftRender test code (Linux host only)
+// 決まった場面をソフトウェア描画して、同じフォルダのPCX(期待する画面)と比べる。
+// 描画するスレッド数を変えても結果が変わらないことと、スレッド数ごとの描画速度も確かめる。
+//
+// 実行するときは、実行ファイルを test/SoftRender で実行すること(test/host の make check がそうする)。
+// 描画を意図して変えた時は、引数に update を付けて実行すると、期待する画面を書き直す。
+// 期待する画面は、PCXが小さく収まるように、8ドット四方の升目を整数倍で描画したものにしている。
+
+#include "Cat_PspCallback.h"
+#include "Cat_ImageLoaderPCX.h"
+#include "Cat_Render.h"
+#include "Cat_SoftRender.h"
+#include "Cat_SpriteBatch.h"
+#include "Cat_StreamFile.h"
+#include "Cat_Texture.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include <pspdebug.h>
+#include <pspkernel.h>
+#include <pspgu.h>
+
+#define TRACE(x) pspDebugScreenPrintf x
+#define HALT() sceKernelSleepThreadCB()
+
+//! テクスチャの大きさ
+#define TEST_TEXTURE_SIZE (32)
+//! 升目の大きさ
+#define TEST_CELL_SIZE (8)
+//! 画面のピクセル数
+#define TEST_SCREEN_PIXEL (480 * 272)
+//! 速度を測るスプライト数
+#define TEST_BENCHMARK_SPRITE (2000)
+//! 速度を測るフレーム数
+#define TEST_BENCHMARK_FRAME (20)
+
+//! 場面
+enum {
+	SCENE_CLUT = 0,			/*!< 8bitテクスチャを拡大、反転して並べる		*/
+	SCENE_BLEND,			/*!< その上に半透明の32bitテクスチャを重ねる	*/
+	SCENE_COUNT
+};
+
+//! 期待する画面のファイル名
+static const char* gapszGolden[SCENE_COUNT] = { "clut.pcx", "blend.pcx" };
+//! 比べるスレッド数(0はCPUの数)
+static const uint32_t ganThread[] = { 1, 2, 4, 0 };
+#define TEST_THREAD_COUNT (sizeof(ganThread) / sizeof(ganThread[0]))
+
+//! 8bitテクスチャ
+static Cat_Texture* gpClut = 0;
+//! 半透明の32bitテクスチャ
+static Cat_Texture* gpAlpha = 0;
+
+//! 升目のテクスチャを作成する
+/*!
+	升目は市松に透明にする。
+	@param[in]	pPalette	パレット(0の場合は半透明の32bit)
+	@return	作成されたテクスチャ。失敗した場合は0が返る。
+*/
+static Cat_Texture*
+CreateCellTexture( Cat_Palette* pPalette )
+{
+	uint32_t anImage[TEST_TEXTURE_SIZE * TEST_TEXTURE_SIZE];
+	uint8_t* pbImage = (uint8_t*)anImage;
+	uint32_t x;
+	uint32_t y;
+
+	for(y = 0; y < TEST_TEXTURE_SIZE; y++) {
+		for(x = 0; x < TEST_TEXTURE_SIZE; x++) {
+			const uint32_t cx = x / TEST_CELL_SIZE;
+			const uint32_t cy = y / TEST_CELL_SIZE;
+			const uint32_t nIndex = ((cx ^ cy) & 1) ? 0 : 1 + cx + cy * (TEST_TEXTURE_SIZE / TEST_CELL_SIZE);
+			if(pPalette) {
+				pbImage[x + y * TEST_TEXTURE_SIZE] = (uint8_t)nIndex;
+			} else {
+				anImage[x + y * TEST_TEXTURE_SIZE] = nIndex ? (0x80000000 | (nIndex * 0x000F0B07)) : 0;
+			}
+		}
+	}
+	if(pPalette) {
+		return Cat_TextureCreate( TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE, anImage, FORMAT_PIXEL_CLUT8, pPalette );
+	}
+	return Cat_TextureCreate( TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE * sizeof(uint32_t), anImage, FORMAT_PIXEL_8888, 0 );
+}
+
+//! 場面を描画する
+/*!
+	@param[in]	nScene	場面(SCENE_xxx)
+*/
+static void
+DrawScene( uint32_t nScene )
+{
+	const float s = TEST_TEXTURE_SIZE;
+	uint32_t i;
+
+	// 4倍と2倍で並べて、左右と上下の反転も混ぜる
+	for(i = 0; i < 6; i++) {
+		const float x = (float)(16 + (i % 3) * 152);
+		const float y = (float)(8 + (i / 3) * 136);
+		const float w = (i & 1) ? -s * 4 : s * 4;
+		const float h = (i == 4) ? -s * 4 : s * 4;
+		Cat_TextureDraw( gpClut, (w < 0) ? x - w : x, (h < 0) ? y - h : y, w, h );
+	}
+	Cat_TextureDraw( gpClut, 200, 104, s * 2, s * 2 );
+	if(nScene == SCENE_BLEND) {
+		for(i = 0; i < 4; i++) {
+			Cat_TextureDraw( gpAlpha, (float)(64 + i * 96), (float)(40 + (i & 1) * 96), s * 4, s * 4 );
+		}
+	}
+}
+
+//! 1ライン分を返す
+/*!
+	@param[in]	y			ライン
+	@param[in]	pvContext	画面
+	@return	1ライン分のRGBA8888
+*/
+static const uint32_t*
+GetLine( uint32_t y, void* pvContext )
+{
+	return (const uint32_t*)pvContext + y * 480;
+}
+
+//! 期待する画面と比べる
+/*!
+	PCXはアルファを持たないので、色だけを比べる。
+	@param[in]	pszFilename	期待する画面のファイル名
+	@param[in]	pnPixel		描画した画面
+	@return	違うピクセル数。読み込めなかった場合は負数が返る。
+*/
+static int32_t
+CompareGolden( const char* pszFilename, const uint32_t* pnPixel )
+{
+	Cat_Stream* pStream;
+	Cat_Texture* pGolden;
+	int32_t rc = 0;
+	uint32_t x;
+	uint32_t y;
+
+	pStream = Cat_StreamFileReadOpen( pszFilename );
+	if(pStream == 0) {
+		return -1;
+	}
+	pGolden = Cat_ImageLoaderLoadPCX( pStream );
+	Cat_StreamClose( pStream );
+	if(pGolden == 0) {
+		return -1;
+	}
+	if((Cat_TextureGetWidth( pGolden ) != 480) || (Cat_TextureGetHeight( pGolden ) != 272)) {
+		Cat_TextureRelease( pGolden );
+		return -1;
+	}
+	for(y = 0; y < 272; y++) {
+		for(x = 0; x < 480; x++) {
+			if(((Cat_TextureGetPixel( pGolden, x, y ) ^ pnPixel[x + y * 480]) & 0x00FFFFFF) != 0) {
+				rc++;
+			}
+		}
+	}
+	Cat_TextureRelease( pGolden );
+	return rc;
+}
+
+//! 期待する画面を書き直す
+/*!
+	@param[in]	pszFilename	期待する画面のファイル名
+	@param[in]	pnPixel		描画した画面
+	@return	成功した場合は0 \n
+			失敗した場合は、負数を返す
+*/
+static int32_t
+SaveGolden( const char* pszFilename, uint32_t* pnPixel )
+{
+	Cat_Stream* pStream;
+	int32_t rc;
+
+	pStream = Cat_StreamFileWriteOpen( pszFilename );
+	if(pStream == 0) {
+		return -1;
+	}
+	rc = Cat_ImageLoaderSavePCX8888( pStream, 480, 272, GetLine, pnPixel );
+	Cat_StreamClose( pStream );
+	return rc;
+}
+
+//! 速度を測る
+/*!
+	半透明の32bitテクスチャを、画面全体にずらしながら描画する。
+	@param[in]	nThreadCount	スレッド数(0はCPUの数)
+	@param[out]	pStatistics		統計情報
+*/
+static void
+Benchmark( uint32_t nThreadCount, Cat_SoftRenderStatistics* pStatistics )
+{
+	Cat_SpriteBatch* pBatch;
+	Cat_SpriteBatchSprite sprite;
+	uint32_t nFrame;
+	uint32_t i;
+
+	pBatch = Cat_SpriteBatchCreate( TEST_BENCHMARK_SPRITE );
+	if(pBatch == 0) {
+		memset( pStatistics, 0, sizeof(Cat_SoftRenderStatistics) );
+		return;
+	}
+	Cat_SoftRenderInit( nThreadCount );
+	Cat_RenderInit( CAT_RENDER_PARAM_FORMAT_RGBA8888 | CAT_RENDER_PARAM_BUFFER_SINGLE );
+	Cat_SpriteBatchSpriteInit( &sprite );
+	sprite.pTexture = gpAlpha;
+	Cat_SoftRenderResetStatistics();
+	for(nFrame = 0; nFrame < TEST_BENCHMARK_FRAME; nFrame++) {
+		Cat_RenderBegin(); {
+			for(i = 0; i < TEST_BENCHMARK_SPRITE; i++) {
+				sprite.x = (float)(((i + nFrame) * 37) % (480 - TEST_TEXTURE_SIZE));
+				sprite.y = (float)(((i + nFrame) * 23) % (272 - TEST_TEXTURE_SIZE));
+				Cat_SpriteBatchAdd( pBatch, &sprite );
+			}
+			Cat_SpriteBatchFlush( pBatch );
+		} Cat_RenderEnd();
+		Cat_RenderScreenUpdate();
+	}
+	Cat_SoftRenderGetStatistics( pStatistics );
+	Cat_RenderTerm();
+	Cat_SoftRenderTerm();
+	Cat_SpriteBatchDestroy( pBatch );
+}
+
+int
+main( int argc, char* argv[] )
+{
+	static uint32_t anPixel[TEST_THREAD_COUNT][SCENE_COUNT][TEST_SCREEN_PIXEL];
+	const int fUpdate = (argc > 1) && (strcmp( argv[1], "update" ) == 0);
+	Cat_SoftRenderStatistics statistics;
+	Cat_Palette* pPalette;
+	uint32_t anColor[256];
+	uint32_t nThread;
+	uint32_t nScene;
+	uint32_t i;
+	int fOk = 1;
+
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	TRACE(( "Cat_SoftRender test code\n" ));
+
+	// 期待する画面を読む時に変換されないように、テクスチャのオプションは既定のままにする
+	Cat_TextureSetOption( CAT_TEXTURE_OPTION_DEFAULT );
+	anColor[0] = 0x00000000;
+	for(i = 1; i < 256; i++) {
+		anColor[i] = 0xFF000000 | (i * 0x00070D13);
+	}
+	pPalette = Cat_PaletteCreate( FORMAT_PALETTE_8888, 256, anColor );
+	if(pPalette == 0) {
+		TRACE(( "Error:Cat_PaletteCreate\n" ));
+		HALT();
+	}
+	gpClut  = CreateCellTexture( pPalette );
+	gpAlpha = CreateCellTexture( 0 );
+	if((gpClut == 0) || (gpAlpha == 0)) {
+		TRACE(( "Error:Cat_TextureCreate\n" ));
+		HALT();
+	}
+
+	// 同じ場面を、スレッド数を変えて描画する
+	for(nThread = 0; nThread < TEST_THREAD_COUNT; nThread++) {
+		if(Cat_SoftRenderInit( ganThread[nThread] ) < 0) {
+			TRACE(( "Error:Cat_SoftRenderInit\n" ));
+			HALT();
+		}
+		Cat_RenderInit( CAT_RENDER_PARAM_FORMAT_RGBA8888 | CAT_RENDER_PARAM_BUFFER_SINGLE );
+		for(nScene = 0; nScene < SCENE_COUNT; nScene++) {
+			Cat_RenderBegin(); {
+				DrawScene( nScene );
+			} Cat_RenderEnd();
+			Cat_RenderScreenUpdate();
+			Cat_SoftRenderReadPixels( anPixel[nThread][nScene] );
+		}
+		Cat_SoftRenderGetStatistics( &statistics );
+		Cat_RenderTerm();
+		Cat_SoftRenderTerm();
+		if(statistics.nUnsupportedCount != 0) {
+			TRACE(( "threads:%d unsupported:%d\n", (int)statistics.nThreadCount, (int)statistics.nUnsupportedCount ));
+			fOk = 0;
+		}
+	}
+
+	for(nScene = 0; nScene < SCENE_COUNT; nScene++) {
+		int32_t nDiff;
+		if(fUpdate) {
+			if(SaveGolden( gapszGolden[nScene], anPixel[0][nScene] ) < 0) {
+				TRACE(( "Error:SaveGolden %s\n", gapszGolden[nScene] ));
+				fOk = 0;
+			}
+		}
+		nDiff = CompareGolden( gapszGolden[nScene], anPixel[0][nScene] );
+		TRACE(( "%-10s golden diff:%d\n", gapszGolden[nScene], (int)nDiff ));
+		if(nDiff != 0) {
+			fOk = 0;
+		}
+		// アルファ(ステンシル)も含めて、スレッド数によらず同じになる
+		for(nThread = 1; nThread < TEST_THREAD_COUNT; nThread++) {
+			if(memcmp( anPixel[nThread][nScene], anPixel[0][nScene], sizeof(anPixel[0][nScene]) ) != 0) {
+				TRACE(( "%-10s threads:%d differs from threads:%d\n", gapszGolden[nScene], (int)ganThread[nThread], (int)ganThread[0] ));
+				fOk = 0;
+			}
+		}
+	}
+
+	// スレッド数ごとの描画速度
+	for(nThread = 0; nThread < TEST_THREAD_COUNT; nThread++) {
+		Benchmark( ganThread[nThread], &statistics );
+		if(statistics.nTime == 0) {
+			statistics.nTime = 1;
+		}
+		TRACE(( "threads:%2d sprites:%8d/s pixels:%6d.%dM/s\n", (int)statistics.nThreadCount,
+			(int)((uint64_t)statistics.nSpriteCount * 1000000 / statistics.nTime),
+			(int)(statistics.nPixelCount / statistics.nTime), (int)((uint64_t)statistics.nPixelCount * 10 / statistics.nTime % 10) ));
+	}
+
+	TRACE(( fOk ? "OK\n" : "NG\n" ));
+
+	Cat_TextureRelease( gpAlpha );
+	Cat_TextureRelease( gpClut );
+	Cat_PaletteRelease( pPalette );
+	HALT();
+	return 0;
+}
@@ -0,0 +1,298 @@
+// Cat_SpriteBatch test code
+// 同じ場面を、1枚ずつCat_TextureDraw()で描画する場合とバッチで描画する場合の2回描画して、
+// 描画の回数と描画パケットが減ることと、描画結果が同じになることを確かめる
+//
+// バッチはレイヤーとテクスチャの順に並べ替えるので、1枚ずつ描画する方は最初からその順番で描画し、
+// バッチにはテクスチャを交互に追加する。
+//
+// 重み付き加算は、背景の上に重ねた結果が、Cat_Blendの比較用の実装と±1の差に収まることを確かめる。
+// インデックス0の透明な所は、背景がそのまま残る。
+
+#include "Cat_PspCallback.h"
+#include "Cat_Blend.h"
+#include "Cat_Render.h"
+#include "Cat_RenderState.h"
+#include "Cat_SpriteBatch.h"
+#include "Cat_Texture.h"
+#include "TestCommon.h"
+#include <stdlib.h>
+
+#include <pspdebug.h>
+#include <pspkernel.h>
+#include <pspge.h>
+#include <pspgu.h>
+
+#define TRACE(x) pspDebugScreenPrintf x
+#define HALT() sceKernelSleepThreadCB()
+
+//! テクスチャの大きさ
+#define TEST_TEXTURE_SIZE (32)
+//! テクスチャの数
+#define TEST_TEXTURE_COUNT (3)
+//! レイヤーの数
+#define TEST_LAYER_COUNT (3)
+//! 描画するスプライトの数
+#define TEST_DRAW_COUNT (900)
+//! 重み付き加算で重ねる位置X
+#define TEST_ADDALPHA_X (100)
+//! 重み付き加算で重ねる位置Y
+#define TEST_ADDALPHA_Y (50)
+//! 重み付き加算の重みの組の数
+#define TEST_ADDALPHA_COUNT (3)
+
+//! 重み付き加算の重み(ソース、描画先)
+static const uint32_t gnAddAlpha[TEST_ADDALPHA_COUNT][2] = {
+	{ 256, 128 },	// add1
+	{ 192,  96 },
+	{  64, 256 },
+};
+
+//! スプライトの位置を取得する
+/*!
+	@param[in]	nIndex	スプライトの番号
+	@param[out]	px		描画位置X
+	@param[out]	py		描画位置Y
+*/
+static void
+GetPosition( uint32_t nIndex, float* px, float* py )
+{
+	*px = (float)((nIndex * 37) % (480 - TEST_TEXTURE_SIZE));
+	*py = (float)((nIndex * 23) % (272 - TEST_TEXTURE_SIZE));
+}
+
+//! 1枚ずつ描画する
+/*!
+	スプライトiは、テクスチャ i % TEST_TEXTURE_COUNT、レイヤー i * TEST_LAYER_COUNT / TEST_DRAW_COUNT。 \n
+	バッチが並べ替えた後と同じ順番で描画する。
+	@param[in]	ppTexture	テクスチャ
+	@return	描画したスプライト数
+*/
+static uint32_t
+DrawDirect( Cat_Texture** ppTexture )
+{
+	uint32_t rc = 0;
+	uint32_t nLayer;
+	uint32_t nTexture;
+	uint32_t i;
+
+	for(nLayer = 0; nLayer < TEST_LAYER_COUNT; nLayer++) {
+		for(nTexture = 0; nTexture < TEST_TEXTURE_COUNT; nTexture++) {
+			for(i = 0; i < TEST_DRAW_COUNT; i++) {
+				float x;
+				float y;
+				if(((i % TEST_TEXTURE_COUNT) != nTexture) || ((i * TEST_LAYER_COUNT / TEST_DRAW_COUNT) != nLayer)) {
+					continue;
+				}
+				GetPosition( i, &x, &y );
+				Cat_TextureDraw( ppTexture[nTexture], x, y, TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE );
+				rc++;
+			}
+		}
+	}
+	return rc;
+}
+
+//! バッチで描画する
+/*!
+	@param[in]	pBatch		バッチ
+	@param[in]	ppTexture	テクスチャ
+	@return	sceGuDrawArray()の回数
+*/
+static uint32_t
+DrawBatch( Cat_SpriteBatch* pBatch, Cat_Texture** ppTexture )
+{
+	Cat_SpriteBatchSprite sprite;
+	uint32_t i;
+
+	Cat_SpriteBatchSpriteInit( &sprite );
+	for(i = 0; i < TEST_DRAW_COUNT; i++) {
+		sprite.pTexture = ppTexture[i % TEST_TEXTURE_COUNT];
+		sprite.nLayer   = i * TEST_LAYER_COUNT / TEST_DRAW_COUNT;
+		GetPosition( i, &sprite.x, &sprite.y );
+		Cat_SpriteBatchAdd( pBatch, &sprite );
+	}
+	return Cat_SpriteBatchFlush( pBatch );
+}
+
+//! 重み付き加算で重ねて、比較用の実装との違いを数える
+/*!
+	@param[in]	pBatch		バッチ
+	@param[in]	pBack		背景のテクスチャ
+	@param[in]	pTexture	重ねるテクスチャ(TEST_TEXTURE_SIZE四方の8bit)
+	@param[in]	pbIndex		重ねるテクスチャのインデックス
+	@param[in]	pnPalette	重ねるテクスチャのパレット(RGBA8888、256色)
+	@param[in]	nSrcAlpha	ソースの重み
+	@param[in]	nDestAlpha	描画先の重み
+	@return	±1を超えて違うピクセル数
+*/
+static uint32_t
+CheckAddAlpha( Cat_SpriteBatch* pBatch, Cat_Texture* pBack, Cat_Texture* pTexture, const uint8_t* pbIndex, const uint32_t* pnPalette,
+	uint32_t nSrcAlpha, uint32_t nDestAlpha )
+{
+	const uint32_t* pnScreen = (const uint32_t*)((uintptr_t)sceGeEdramGetAddr() | 0x40000000);
+	uint32_t anExpect[TEST_TEXTURE_SIZE * TEST_TEXTURE_SIZE];
+	Cat_SpriteBatchSprite sprite;
+	Cat_BlendParam param;
+	uint32_t nError = 0;
+	uint32_t n;
+	uint32_t x;
+	uint32_t y;
+
+	// 1回目は背景だけを描画して、重ねる前の描画先を読む
+	Cat_SpriteBatchSpriteInit( &sprite );
+	sprite.x = TEST_ADDALPHA_X;
+	sprite.y = TEST_ADDALPHA_Y;
+	for(n = 0; n < 2; n++) {
+		Cat_RenderStateInvalidate();
+		Cat_RenderBegin(); {
+			sprite.pTexture = pBack;
+			sprite.nLayer   = 0;
+			sprite.nBlend   = CAT_SPRITEBATCH_BLEND_ALPHA;
+			Cat_SpriteBatchAdd( pBatch, &sprite );
+			if(n == 1) {
+				sprite.pTexture   = pTexture;
+				sprite.nLayer     = 1;
+				sprite.nBlend     = CAT_SPRITEBATCH_BLEND_ADDALPHA;
+				sprite.nSrcAlpha  = nSrcAlpha;
+				sprite.nDestAlpha = nDestAlpha;
+				Cat_SpriteBatchAdd( pBatch, &sprite );
+			}
+			Cat_SpriteBatchFlush( pBatch );
+		} Cat_RenderEnd();
+		Cat_RenderScreenUpdate();
+		sceGuSync( 0, 0 );
+		if(n == 0) {
+			for(y = 0; y < TEST_TEXTURE_SIZE; y++) {
+				for(x = 0; x < TEST_TEXTURE_SIZE; x++) {
+					anExpect[x + y * TEST_TEXTURE_SIZE] = pnScreen[(TEST_ADDALPHA_X + x) + (TEST_ADDALPHA_Y + y) * 512];
+				}
+			}
+		}
+	}
+
+	Cat_BlendParamInit( &param );
+	param.nMode      = CAT_BLEND_ADDALPHA;
+	param.nSrcAlpha  = nSrcAlpha;
+	param.nDestAlpha = nDestAlpha;
+	for(y = 0; y < TEST_TEXTURE_SIZE; y++) {
+		Cat_BlendSpan8888Reference( &anExpect[y * TEST_TEXTURE_SIZE], &pbIndex[y * TEST_TEXTURE_SIZE], pnPalette, TEST_TEXTURE_SIZE, &param );
+		for(x = 0; x < TEST_TEXTURE_SIZE; x++) {
+			const uint32_t nExpect = anExpect[x + y * TEST_TEXTURE_SIZE];
+			const uint32_t nActual = pnScreen[(TEST_ADDALPHA_X + x) + (TEST_ADDALPHA_Y + y) * 512];
+			for(n = 0; n < 24; n += 8) {
+				const int32_t d = (int32_t)((nExpect >> n) & 0xFF) - (int32_t)((nActual >> n) & 0xFF);
+				if((d < -1) || (d > 1)) {
+					nError++;
+					break;
+				}
+			}
+		}
+	}
+	return nError;
+}
+
+int
+main()
+{
+	Cat_Texture* pTexture[TEST_TEXTURE_COUNT];
+	Cat_Palette* pPalette;
+	Cat_SpriteBatch* pBatch;
+	Cat_SpriteBatchStatistics statistics;
+	uint32_t anColor[256];
+	uint32_t nDraw[2];
+	uint32_t nSize[2];
+	uint32_t nTime[2];
+	uint32_t nChecksum[2];
+	Cat_Palette* pAddPalette;
+	Cat_Texture* pAddTexture;
+	uint32_t anAddColor[256];
+	uint8_t* pbAddIndex;
+	uint32_t nAddError = 0;
+	uint32_t i;
+
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	TRACE(( "Cat_SpriteBatch test code\n" ));
+
+	for(i = 0; i < 256; i++) {
+		anColor[i] = 0xFF000000 | (i * 0x030201);
+	}
+	pPalette = Cat_PaletteCreate( FORMAT_PALETTE_8888, 256, anColor );
+	if(pPalette == 0) {
+		TRACE(( "Error:Cat_PaletteCreate\n" ));
+		HALT();
+	}
+	for(i = 0; i < TEST_TEXTURE_COUNT; i++) {
+		pTexture[i] = TestCreateTexture( TEST_TEXTURE_SIZE, i, (i == 2) ? 0 : pPalette );
+		if(pTexture[i] == 0) {
+			TRACE(( "Error:Cat_TextureCreate\n" ));
+			HALT();
+		}
+	}
+	pBatch = Cat_SpriteBatchCreate( TEST_DRAW_COUNT );
+	if(pBatch == 0) {
+		TRACE(( "Error:Cat_SpriteBatchCreate\n" ));
+		HALT();
+	}
+
+	// 重み付き加算で重ねるテクスチャ(左端の4列は透明)
+	for(i = 0; i < 256; i++) {
+		anAddColor[i] = i ? (0xFF000000 | (i * 0x070503)) : 0;
+	}
+	pAddPalette = Cat_PaletteCreate( FORMAT_PALETTE_8888, 256, anAddColor );
+	pbAddIndex  = (uint8_t*)malloc( TEST_TEXTURE_SIZE * TEST_TEXTURE_SIZE );
+	if((pAddPalette == 0) || (pbAddIndex == 0)) {
+		TRACE(( "Error:Cat_PaletteCreate\n" ));
+		HALT();
+	}
+	for(i = 0; i < TEST_TEXTURE_SIZE * TEST_TEXTURE_SIZE; i++) {
+		const uint32_t x = i % TEST_TEXTURE_SIZE;
+		pbAddIndex[i] = (x < 4) ? 0 : (uint8_t)(1 + ((x * 8 + i / TEST_TEXTURE_SIZE * 5) % 255));
+	}
+	pAddTexture = Cat_TextureCreate( TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE, pbAddIndex, FORMAT_PIXEL_CLUT8, pAddPalette );
+	if(pAddTexture == 0) {
+		TRACE(( "Error:Cat_TextureCreate\n" ));
+		HALT();
+	}
+
+	Cat_RenderInit( CAT_RENDER_PARAM_FORMAT_RGBA8888 | CAT_RENDER_PARAM_BUFFER_SINGLE );
+	for(i = 0; i < 2; i++) {
+		const uint32_t nStart = sceKernelGetSystemTimeLow();
+		Cat_RenderStateInvalidate();
+		Cat_RenderBegin(); {
+			nDraw[i] = (i == 0) ? DrawDirect( pTexture ) : DrawBatch( pBatch, pTexture );
+			nSize[i] = (uint32_t)sceGuCheckList();
+		} Cat_RenderEnd();
+		nTime[i] = sceKernelGetSystemTimeLow() - nStart;
+		Cat_RenderScreenUpdate();
+		sceGuSync( 0, 0 );
+		nChecksum[i] = TestGetScreenChecksum();
+	}
+	Cat_SpriteBatchGetStatistics( pBatch, &statistics );
+	for(i = 0; i < TEST_ADDALPHA_COUNT; i++) {
+		nAddError += CheckAddAlpha( pBatch, pTexture[0], pAddTexture, pbAddIndex, anAddColor, gnAddAlpha[i][0], gnAddAlpha[i][1] );
+	}
+	Cat_RenderTerm();
+
+	TestResetDebugScreen();
+	for(i = 0; i < 2; i++) {
+		TRACE(( "%s: draw %4d packet %6d bytes %5dus checksum %08X\n", i ? "batch " : "direct",
+			(int)nDraw[i], (int)nSize[i], (int)nTime[i], (unsigned int)nChecksum[i] ));
+	}
+	TRACE(( "sprites:%d batches:%d state changes:%d vertex:%d bytes\n", (int)statistics.nSpriteCount,
+		(int)statistics.nBatchCount, (int)statistics.nStateCount, (int)statistics.nVertexSize ));
+	TRACE(( "addalpha error:%d\n", (int)nAddError ));
+	TestPrintResult( (nDraw[1] < nDraw[0]) && (nSize[1] < nSize[0]) && (nChecksum[0] == nChecksum[1]) && (nAddError == 0) );
+
+	Cat_SpriteBatchDestroy( pBatch );
+	for(i = 0; i < TEST_TEXTURE_COUNT; i++) {
+		Cat_TextureRelease( pTexture[i] );
+	}
+	Cat_TextureRelease( pAddTexture );
+	free( pbAddIndex );
+	Cat_PaletteRelease( pPalette );
+	Cat_PaletteRelease( pAddPalette );
+	HALT();
+	return 0;
+}
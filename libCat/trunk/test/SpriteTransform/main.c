@@ -0,0 +1,282 @@
+// Cat_SpriteTransform test code
+// まとめて計算した頂点(ホストではSSE2かNEON)が比較用の実装と一致することを確かめて、
+// 1秒あたりの頂点数を計測する
+//
+// スプライトは、回転しないもの、整数の角度、任意の角度、反転、拡大を混ぜる。
+// ちょうど半分の位置も混ぜて、丸めが一致することも確かめる。
+// 回転も拡大もしないスプライトを、三角形(Cat_SpriteTransformDraw())とGU_SPRITESで描画して、
+// 画面のチェックサムが一致することも確かめる。
+
+#include "Cat_PspCallback.h"
+#include "Cat_SpriteTransform.h"
+#include "Cat_Render.h"
+#include "Cat_RenderState.h"
+#include "Cat_Texture.h"
+#ifdef USE_CAT_SOFTRENDER
+#include "Cat_SoftRender.h"
+#endif
+#include "TestCommon.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include <pspdebug.h>
+#include <pspgu.h>
+#include <pspkernel.h>
+#include <pspthreadman.h>
+
+#define TRACE(x) pspDebugScreenPrintf x
+#define HALT() sceKernelSleepThreadCB()
+
+//! スプライト数
+#define TEST_SPRITE_COUNT (4096)
+//! 計測する回数
+#define TEST_LOOP_COUNT (64)
+//! テクスチャの大きさ
+#define TEST_TEXTURE_SIZE (64)
+//! 回転も拡大もしないスプライト数
+#define TEST_ALIGNED_COUNT (64)
+
+//! 0～1の乱数を取得する
+/*!
+	@return	乱数
+*/
+static float
+Random( void )
+{
+	return (float)(rand() & 0xFFFF) / 65535.0f;
+}
+
+//! テスト用のスプライトを作る
+/*!
+	@param[out]	pInstance	スプライト
+	@param[in]	nCount		スプライト数
+*/
+static void
+CreateInstance( Cat_SpriteInstance* pInstance, uint32_t nCount )
+{
+	uint32_t i;
+
+	srand( 1 );
+	for(i = 0; i < nCount; i++, pInstance++) {
+		memset( pInstance, 0, sizeof(Cat_SpriteInstance) );
+		pInstance->u       = (int16_t)(rand() % TEST_TEXTURE_SIZE);
+		pInstance->v       = (int16_t)(rand() % TEST_TEXTURE_SIZE);
+		pInstance->nWidth  = (int16_t)(1 + rand() % (TEST_TEXTURE_SIZE - pInstance->u));
+		pInstance->nHeight = (int16_t)(1 + rand() % (TEST_TEXTURE_SIZE - pInstance->v));
+		pInstance->x       = (float)(rand() % 480);
+		pInstance->y       = (float)(rand() % 272);
+		pInstance->fAxisX  = (float)(rand() % (pInstance->nWidth + 1));
+		pInstance->fAxisY  = (float)(rand() % (pInstance->nHeight + 1));
+		pInstance->fScaleX = 1.0f;
+		pInstance->fScaleY = 1.0f;
+		pInstance->nFlags  = (uint32_t)rand() & (CAT_SPRITETRANSFORM_FLIP_X | CAT_SPRITETRANSFORM_FLIP_Y);
+		switch(i % 4) {
+			case 0:		// 回転しない(ちょうど半分の位置)
+				pInstance->x += 0.5f;
+				break;
+			case 1:		// 整数の角度(同じ角度が続く)
+				pInstance->fAngle = (float)((i / 16) % 360);
+				break;
+			case 2:		// 任意の角度と拡大
+				pInstance->fAngle  = Random() * 720.0f - 360.0f;
+				pInstance->fScaleX = 0.25f + Random() * 2.0f;
+				pInstance->fScaleY = 0.25f + Random() * 2.0f;
+				break;
+			default:	// 拡大だけ
+				pInstance->fScaleX = 2.0f;
+				pInstance->fScaleY = 0.5f + Random();
+				pInstance->fAxisX += 0.5f;
+				break;
+		}
+	}
+}
+
+//! 回転も拡大もしないスプライトを作る
+/*!
+	位置は整数にして、反転は混ぜる。
+	@param[out]	pInstance	スプライト
+	@param[in]	nCount		スプライト数
+*/
+static void
+CreateAlignedInstance( Cat_SpriteInstance* pInstance, uint32_t nCount )
+{
+	uint32_t i;
+
+	srand( 2 );
+	for(i = 0; i < nCount; i++, pInstance++) {
+		memset( pInstance, 0, sizeof(Cat_SpriteInstance) );
+		pInstance->u       = (int16_t)(rand() % TEST_TEXTURE_SIZE);
+		pInstance->v       = (int16_t)(rand() % TEST_TEXTURE_SIZE);
+		pInstance->nWidth  = (int16_t)(1 + rand() % (TEST_TEXTURE_SIZE - pInstance->u));
+		pInstance->nHeight = (int16_t)(1 + rand() % (TEST_TEXTURE_SIZE - pInstance->v));
+		pInstance->x       = (float)(rand() % 480);
+		pInstance->y       = (float)(rand() % 272);
+		pInstance->fAxisX  = (float)(rand() % (pInstance->nWidth + 1));
+		pInstance->fAxisY  = (float)(rand() % (pInstance->nHeight + 1));
+		pInstance->fScaleX = 1.0f;
+		pInstance->fScaleY = 1.0f;
+		pInstance->nFlags  = i & (CAT_SPRITETRANSFORM_FLIP_X | CAT_SPRITETRANSFORM_FLIP_Y);
+	}
+}
+
+//! スプライトを描画して、画面のチェックサムを取得する
+/*!
+	@param[in]	pTexture	テクスチャ
+	@param[in]	pInstance	スプライト
+	@param[in]	nCount		スプライト数
+	@param[in]	fSprites	GU_SPRITESで描画するかどうか(0の場合はCat_SpriteTransformDraw())
+	@return	チェックサム
+*/
+static uint32_t
+DrawAligned( Cat_Texture* pTexture, const Cat_SpriteInstance* pInstance, uint32_t nCount, int fSprites )
+{
+	static Cat_SpriteVertex16 vertex[TEST_ALIGNED_COUNT * 4];
+	uint32_t i;
+
+	Cat_RenderStateInvalidate();
+	Cat_RenderBegin(); {
+		Cat_TextureSetTexture( pTexture );
+		if(fSprites) {
+			// 左上と右下の頂点だけを使う
+			Cat_SpriteVertex16* pVertex = (Cat_SpriteVertex16*)Cat_RenderGetMemory( sizeof(Cat_SpriteVertex16) * 2 * nCount );
+			Cat_SpriteTransform16Reference( pInstance, nCount, vertex );
+			for(i = 0; pVertex && (i < nCount); i++) {
+				pVertex[i * 2]     = vertex[i * 4];
+				pVertex[i * 2 + 1] = vertex[i * 4 + 3];
+			}
+			if(pVertex) {
+				Cat_RenderDrawArray( GU_SPRITES, GU_TEXTURE_16BIT | GU_VERTEX_16BIT | GU_TRANSFORM_2D, nCount * 2, 0, pVertex );
+			}
+		} else if(pInstance) {
+			Cat_SpriteTransformDraw( pInstance, nCount );
+		}
+	} Cat_RenderEnd();
+	Cat_RenderScreenUpdate();
+	sceGuSync( 0, 0 );
+	return TestGetScreenChecksum();
+}
+
+//! 1秒あたりの頂点数を求める
+/*!
+	@param[in]	nTime	かかった時間(マイクロ秒単位)
+	@return	1秒あたりの頂点数(千頂点単位)
+*/
+static uint32_t
+GetVertexRate( uint32_t nTime )
+{
+	const uint64_t nVertex = (uint64_t)TEST_SPRITE_COUNT * 4 * TEST_LOOP_COUNT;
+
+	return nTime ? (uint32_t)(nVertex * 1000 / nTime) : 0;
+}
+
+int
+main()
+{
+	static Cat_SpriteInstance instance[TEST_SPRITE_COUNT];
+	static Cat_SpriteInstance aligned[TEST_ALIGNED_COUNT];
+	static Cat_SpriteVertex16 vertex16[2][TEST_SPRITE_COUNT * 4];
+	static Cat_SpriteVertexFloat vertexFloat[2][TEST_SPRITE_COUNT * 4];
+	static uint16_t anIndex[6 * 2];
+	uint32_t nTime[4];
+	uint32_t nStart;
+	uint32_t nDraw = 0;
+	uint32_t nUnsupported = 0;
+	uint32_t nChecksum[3];
+	uint32_t nDiff16 = 0;
+	uint32_t nDiffFloat = 0;
+	Cat_Texture* pTexture;
+	uint32_t anImage[TEST_TEXTURE_SIZE * TEST_TEXTURE_SIZE];
+	uint32_t i;
+
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	TRACE(( "Cat_SpriteTransform test code\n" ));
+
+	CreateInstance( instance, TEST_SPRITE_COUNT );
+	CreateAlignedInstance( aligned, TEST_ALIGNED_COUNT );
+
+	// 比較用の実装と一致するか
+	Cat_SpriteTransform16( instance, TEST_SPRITE_COUNT, vertex16[0] );
+	Cat_SpriteTransform16Reference( instance, TEST_SPRITE_COUNT, vertex16[1] );
+	Cat_SpriteTransformFloat( instance, TEST_SPRITE_COUNT, vertexFloat[0] );
+	Cat_SpriteTransformFloatReference( instance, TEST_SPRITE_COUNT, vertexFloat[1] );
+	for(i = 0; i < TEST_SPRITE_COUNT * 4; i++) {
+		if(memcmp( &vertex16[0][i], &vertex16[1][i], sizeof(Cat_SpriteVertex16) ) != 0) {
+			if(nDiff16 == 0) {
+				TRACE(( "16bit mismatch: vertex %d (%d,%d) (%d,%d)\n", (int)i, vertex16[0][i].x, vertex16[0][i].y,
+					vertex16[1][i].x, vertex16[1][i].y ));
+			}
+			nDiff16++;
+		}
+		if(memcmp( &vertexFloat[0][i], &vertexFloat[1][i], sizeof(Cat_SpriteVertexFloat) ) != 0) {
+			nDiffFloat++;
+		}
+	}
+	Cat_SpriteTransformIndex( 2, anIndex );
+
+	// 計測
+	nStart = sceKernelGetSystemTimeLow();
+	for(i = 0; i < TEST_LOOP_COUNT; i++) {
+		Cat_SpriteTransform16Reference( instance, TEST_SPRITE_COUNT, vertex16[1] );
+	}
+	nTime[0] = sceKernelGetSystemTimeLow() - nStart;
+	nStart = sceKernelGetSystemTimeLow();
+	for(i = 0; i < TEST_LOOP_COUNT; i++) {
+		Cat_SpriteTransform16( instance, TEST_SPRITE_COUNT, vertex16[0] );
+	}
+	nTime[1] = sceKernelGetSystemTimeLow() - nStart;
+	nStart = sceKernelGetSystemTimeLow();
+	for(i = 0; i < TEST_LOOP_COUNT; i++) {
+		Cat_SpriteTransformFloatReference( instance, TEST_SPRITE_COUNT, vertexFloat[1] );
+	}
+	nTime[2] = sceKernelGetSystemTimeLow() - nStart;
+	nStart = sceKernelGetSystemTimeLow();
+	for(i = 0; i < TEST_LOOP_COUNT; i++) {
+		Cat_SpriteTransformFloat( instance, TEST_SPRITE_COUNT, vertexFloat[0] );
+	}
+	nTime[3] = sceKernelGetSystemTimeLow() - nStart;
+
+	// 描画(回転したスプライトは三角形で描画する)
+	for(i = 0; i < TEST_TEXTURE_SIZE * TEST_TEXTURE_SIZE; i++) {
+		anImage[i] = 0xFF000000 | ((i ^ (i >> 6)) * 0x040404);
+	}
+	pTexture = Cat_TextureCreate( TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE * 4, anImage, FORMAT_PIXEL_8888, 0 );
+	Cat_RenderInit( CAT_RENDER_PARAM_FORMAT_RGBA8888 | CAT_RENDER_PARAM_BUFFER_SINGLE );
+#ifdef USE_CAT_SOFTRENDER
+	Cat_SoftRenderResetStatistics();
+#endif
+	nChecksum[0] = DrawAligned( pTexture, 0, 0, 0 );
+	nChecksum[1] = DrawAligned( pTexture, aligned, TEST_ALIGNED_COUNT, 0 );
+	nChecksum[2] = DrawAligned( pTexture, aligned, TEST_ALIGNED_COUNT, 1 );
+	Cat_RenderBegin(); {
+		Cat_TextureSetTexture( pTexture );
+		nDraw = Cat_SpriteTransformDraw( instance, 256 );
+	} Cat_RenderEnd();
+	Cat_RenderScreenUpdate();
+	sceGuSync( 0, 0 );
+#ifdef USE_CAT_SOFTRENDER
+	{
+		// 描画できなかった三角形があれば、チェックサムが一致しても確かめたことにならない
+		Cat_SoftRenderStatistics statistics;
+		Cat_SoftRenderGetStatistics( &statistics );
+		nUnsupported = statistics.nUnsupportedCount;
+	}
+#endif
+	sceKernelDelayThread( 1000 * 1000 );
+	Cat_RenderTerm();
+
+	TestResetDebugScreen();
+	TRACE(( "16bit reference: %6dk vertex/s\n", (int)GetVertexRate( nTime[0] ) ));
+	TRACE(( "16bit batch    : %6dk vertex/s\n", (int)GetVertexRate( nTime[1] ) ));
+	TRACE(( "float reference: %6dk vertex/s\n", (int)GetVertexRate( nTime[2] ) ));
+	TRACE(( "float batch    : %6dk vertex/s\n", (int)GetVertexRate( nTime[3] ) ));
+	TRACE(( "mismatch 16bit:%d float:%d draw:%d unsupported:%d\n", (int)nDiff16, (int)nDiffFloat, (int)nDraw, (int)nUnsupported ));
+	TRACE(( "checksum empty:%08X triangles:%08X sprites:%08X\n", (unsigned int)nChecksum[0], (unsigned int)nChecksum[1], (unsigned int)nChecksum[2] ));
+	TestPrintResult( (nDiff16 == 0) && (nDiffFloat == 0) && (nDraw == 256) && (nUnsupported == 0) && (anIndex[6] == 4) && (anIndex[11] == 7)
+		&& (nChecksum[1] == nChecksum[2]) && (nChecksum[1] != nChecksum[0]) );
+
+	Cat_TextureRelease( pTexture );
+	HALT();
+	return 0;
+}
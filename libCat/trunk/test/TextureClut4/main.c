@@ -0,0 +1,322 @@
+// Cat_Texture CLUT4 test code
+// 16色以下の8bitのイメージを、そのままの場合と4bitに変換した場合の2回作成して、描画結果が同じになることを確かめる。
+//
+// 同じパレットを共有する3つのイメージを使う。パレットは0番と255番が透明。
+//   0:10色で余白あり。余白の番号(255番)も16色に入れて4bitになる。
+//   1:16色で余白あり。余白の番号(0番)が入らないので8bitのまま。
+//   2:0番を含む16色で余白なし。4bitになる。
+// パレットを更新した後と、ACTのようにテクスチャのパレットを差し替えた後も比べる。
+// 余白が透明なままか、削減したサイズが変換前後のサイズの差になっているかも確かめる。
+
+#include "Cat_PspCallback.h"
+#include "Cat_Render.h"
+#include "Cat_RenderState.h"
+#include "Cat_Texture.h"
+#include "TestCommon.h"
+#include <stdlib.h>
+
+#include <pspdebug.h>
+#include <pspkernel.h>
+#include <pspge.h>
+#include <pspgu.h>
+
+#define TRACE(x) pspDebugScreenPrintf x
+#define HALT() sceKernelSleepThreadCB()
+
+//! イメージの数
+#define TEST_IMAGE_COUNT (3)
+//! 描画する倍率
+#define TEST_SCALE (3)
+//! 描画する場面の数(0:そのまま 1:更新後 2:ACT 3:ACTの更新後 4:元に戻した後)
+#define TEST_SCENE_COUNT (5)
+
+//! イメージの定義
+typedef struct {
+	uint32_t		nWidth;			/*!< 横幅				*/
+	uint32_t		nHeight;		/*!< 高さ				*/
+	uint32_t		nColorCount;	/*!< 使う色数			*/
+	uint32_t		nIndexMul;		/*!< 番号に掛ける値		*/
+	uint32_t		nIndexAdd;		/*!< 番号に足す値		*/
+	uint8_t			nPadIndex;		/*!< 横の余白の番号		*/
+	FORMAT_PIXEL	eExpect;		/*!< 変換後のフォーマット	*/
+} Image;
+
+//! イメージ(横幅が16の倍数でないか、高さが8の倍数でないと余白ができる)
+static const Image gImage[TEST_IMAGE_COUNT] = {
+	{ 40, 20, 10, 25,  3, 255, FORMAT_PIXEL_CLUT4 },
+	{ 24, 12, 16, 15,  1,   0, FORMAT_PIXEL_CLUT8 },
+	{ 32, 16, 16, 16,  0,   0, FORMAT_PIXEL_CLUT4 },
+};
+
+//! イメージのピクセルの番号を取得する
+/*!
+	@param[in]	pImage	イメージ
+	@param[in]	x		x座標
+	@param[in]	y		y座標
+	@return	番号
+*/
+static uint8_t
+GetIndex( const Image* pImage, uint32_t x, uint32_t y )
+{
+	return (uint8_t)(((x / 3 + y) % pImage->nColorCount) * pImage->nIndexMul + pImage->nIndexAdd);
+}
+
+//! テクスチャを作成する
+/*!
+	横の余白は、イメージの余白の番号で埋めて渡す(縦の余白は0番になる)。
+	@param[in]	pImage		イメージ
+	@param[in]	pPalette	パレット
+	@param[in]	nOption		CAT_TEXTURE_OPTION_xxxの論理和
+	@return	作成されたテクスチャ。失敗した場合は0が返る。
+*/
+static Cat_Texture*
+CreateTexture( const Image* pImage, Cat_Palette* pPalette, uint32_t nOption )
+{
+	const uint32_t nPitch = (pImage->nWidth + 15) & ~15;
+	Cat_Texture* rc;
+	uint8_t* pbImage;
+	uint32_t x;
+	uint32_t y;
+
+	pbImage = (uint8_t*)malloc( nPitch * pImage->nHeight );
+	if(pbImage == 0) {
+		return 0;
+	}
+	for(y = 0; y < pImage->nHeight; y++) {
+		for(x = 0; x < nPitch; x++) {
+			pbImage[x + y * nPitch] = (x < pImage->nWidth) ? GetIndex( pImage, x, y ) : pImage->nPadIndex;
+		}
+	}
+	Cat_TextureSetOption( nOption );
+	rc = Cat_TextureCreate( pImage->nWidth, pImage->nHeight, nPitch, pbImage, FORMAT_PIXEL_CLUT8, pPalette );
+	Cat_TextureSetOption( CAT_TEXTURE_OPTION_DEFAULT );
+	free( pbImage );
+	return rc;
+}
+
+//! パレットの色を設定する
+/*!
+	0番と255番は透明にする(テクスチャの余白の色)。
+	@param[in,out]	pPalette	パレット(256色のRGBA8888)
+	@param[in]		nMul		番号に掛ける値
+	@param[in]		nXor		色に排他的論理和をとる値
+*/
+static void
+SetColor( Cat_Palette* pPalette, uint32_t nMul, uint32_t nXor )
+{
+	uint32_t* pnColor = (uint32_t*)pPalette->pvData;
+	uint32_t i;
+
+	for(i = 0; i < 256; i++) {
+		pnColor[i] = 0xFF000000 | (((i * nMul) ^ nXor) & 0xFFFFFF);
+	}
+	pnColor[0]   = 0;
+	pnColor[255] = 0;
+	Cat_PaletteUpdate( pPalette );
+}
+
+//! テクスチャのパレットを差し替える(icTexture::SetPalette()と同じ)
+/*!
+	@param[in,out]	pTexture	テクスチャ
+	@param[in]		pPalette	設定するパレット
+*/
+static void
+SetPalette( Cat_Texture* pTexture, Cat_Palette* pPalette )
+{
+	if(pTexture->pPalette != pPalette) {
+		Cat_PaletteRelease( pTexture->pPalette );
+		pTexture->pPalette = pPalette;
+		Cat_PaletteAddRef( pPalette );
+	}
+}
+
+//! 4bitのパレットが、元のパレットを変換テーブルで並べ替えたものになっているか調べる
+/*!
+	@param[in]	pTexture	テクスチャ
+	@return	違っている色の数
+*/
+static uint32_t
+CheckPalette4( Cat_Texture* pTexture )
+{
+	Cat_Palette* pPalette4;
+	uint32_t nError = 0;
+	uint32_t i;
+
+	if(pTexture->ePixelFormat != FORMAT_PIXEL_CLUT4) {
+		return 0;
+	}
+	pPalette4 = Cat_TextureGetDrawPalette( pTexture );
+	if((pPalette4 == 0) || (pPalette4 == pTexture->pPalette)) {
+		return 1;
+	}
+	for(i = 0; i < 16; i++) {
+		if(Cat_PaletteGetColor( pPalette4, i ) != Cat_PaletteGetColor( pTexture->pPalette, pTexture->tbl4to8[i] )) {
+			nError++;
+		}
+	}
+	return nError;
+}
+
+//! 描画して画面のチェックサムを取得する
+/*!
+	@param[in]	ppTexture	テクスチャ( \a TEST_IMAGE_COUNT 個)
+	@param[out]	pnColor		最初のイメージの(4,2)のピクセルの色(RGB)
+	@return	チェックサム
+*/
+static uint32_t
+Draw( Cat_Texture** ppTexture, uint32_t* pnColor )
+{
+	const uint32_t* pnScreen = (const uint32_t*)((uintptr_t)sceGeEdramGetAddr() | 0x40000000);
+	uint32_t i;
+
+	Cat_RenderStateInvalidate();
+	Cat_RenderBegin(); {
+		for(i = 0; i < TEST_IMAGE_COUNT; i++) {
+			const float y = (float)(i * 80);
+			Cat_TextureDraw( ppTexture[i], 0, y, (float)gImage[i].nWidth, (float)gImage[i].nHeight );
+			Cat_TextureDraw( ppTexture[i], 64, y, (float)(gImage[i].nWidth * TEST_SCALE), (float)(gImage[i].nHeight * TEST_SCALE) );
+			Cat_TextureDraw( ppTexture[i], 400, y, -(float)(gImage[i].nWidth * 2), (float)gImage[i].nHeight );
+		}
+	} Cat_RenderEnd();
+	Cat_RenderScreenUpdate();
+	sceGuSync( 0, 0 );
+	*pnColor = pnScreen[4 + 2 * 512] & 0xFFFFFF;
+	return TestGetScreenChecksum();
+}
+
+int
+main()
+{
+	Cat_Texture* pTexture[2][TEST_IMAGE_COUNT];
+	Cat_Palette* pPalette;
+	Cat_Palette* pAct;
+	uint32_t nChecksum[2][TEST_SCENE_COUNT];
+	uint32_t nColor[2][TEST_SCENE_COUNT];
+	uint32_t nExpect[TEST_SCENE_COUNT];
+	uint32_t nPaletteError = 0;
+	uint32_t nPaddingError = 0;
+	uint32_t nFail = 0;
+	uint32_t nIndex;
+	uint32_t i;
+	uint32_t j;
+	uint32_t x;
+	uint32_t y;
+
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	TRACE(( "Cat_Texture CLUT4 test code\n" ));
+
+	// 全部のイメージが共有するパレットと、差し替えるパレット(ACT)
+	pPalette = Cat_PaletteCreate( FORMAT_PALETTE_8888, 256, 0 );
+	pAct = Cat_PaletteCreate( FORMAT_PALETTE_8888, 256, 0 );
+	if((pPalette == 0) || (pAct == 0)) {
+		TRACE(( "Error:Cat_PaletteCreate\n" ));
+		HALT();
+	}
+	SetColor( pPalette, 0x010203, 0 );
+	SetColor( pAct, 0x030201, 0x808080 );
+	// 0は8bitのまま、1は4bitに変換する
+	for(i = 0; i < 2; i++) {
+		for(j = 0; j < TEST_IMAGE_COUNT; j++) {
+			pTexture[i][j] = CreateTexture( &gImage[j], pPalette, i ? CAT_TEXTURE_OPTION_CLUT4 : CAT_TEXTURE_OPTION_DEFAULT );
+			if(pTexture[i][j] == 0) {
+				TRACE(( "Error:Cat_TextureCreate\n" ));
+				HALT();
+			}
+		}
+	}
+
+	// 変換されたかと、削減したサイズ
+	for(j = 0; j < TEST_IMAGE_COUNT; j++) {
+		Cat_Texture* p8 = pTexture[0][j];
+		Cat_Texture* p4 = pTexture[1][j];
+		const uint32_t nSaved = Cat_TextureGetDataSize( p8 ) - Cat_TextureGetDataSize( p4 );
+		TRACE(( "image%d format:%d size:%d->%d saved:%d\n", (int)j, (int)p4->ePixelFormat,
+			(int)Cat_TextureGetDataSize( p8 ), (int)Cat_TextureGetDataSize( p4 ), (int)p4->nSavedSize ));
+		if((p8->ePixelFormat != FORMAT_PIXEL_CLUT8) || (p8->nSavedSize != 0)
+			|| (p4->ePixelFormat != gImage[j].eExpect) || (p4->nSavedSize != nSaved)) {
+			nFail++;
+		}
+		if((gImage[j].eExpect == FORMAT_PIXEL_CLUT4) && (nSaved < Cat_TextureGetDataSize( p8 ) / 3)) {
+			nFail++;	// 半分近くにならないとおかしい
+		}
+		if((gImage[j].eExpect == FORMAT_PIXEL_CLUT8) && (p4->pPalette4 != 0)) {
+			nFail++;
+		}
+	}
+
+	// イメージは同じ番号、余白は透明のまま(4bitの0番は使っている最初の色なので、0番で埋めると見えてしまう)
+	for(j = 0; j < TEST_IMAGE_COUNT; j++) {
+		Cat_Texture* p4 = pTexture[1][j];
+		if(p4->ePixelFormat != FORMAT_PIXEL_CLUT4) {
+			continue;
+		}
+		for(y = 0; y < p4->nHeight; y++) {
+			for(x = 0; x < p4->nPitch * 2; x++) {
+				if((x < gImage[j].nWidth) && (y < gImage[j].nHeight)) {
+					nIndex = GetIndex( &gImage[j], x, y );
+					if((Cat_TextureGetPixelRaw( p4, x, y ) != nIndex)
+						|| (Cat_TextureGetPixel( p4, x, y ) != Cat_PaletteGetColor( pPalette, nIndex ))) {
+						nPaddingError++;
+					}
+				} else if((Cat_TextureGetPixel( p4, x, y ) >> 24) != 0) {
+					nPaddingError++;
+				}
+			}
+		}
+	}
+
+	Cat_RenderInit( CAT_RENDER_PARAM_FORMAT_RGBA8888 | CAT_RENDER_PARAM_BUFFER_SINGLE );
+	for(i = 0; i < 2; i++) {
+		nChecksum[i][0] = Draw( pTexture[i], &nColor[i][0] );
+		SetColor( pPalette, 0x020301, 0x408040 );
+		nChecksum[i][1] = Draw( pTexture[i], &nColor[i][1] );
+		for(j = 0; j < TEST_IMAGE_COUNT; j++) {
+			nPaletteError += CheckPalette4( pTexture[i][j] );
+			SetPalette( pTexture[i][j], pAct );
+		}
+		nChecksum[i][2] = Draw( pTexture[i], &nColor[i][2] );
+		SetColor( pAct, 0x010101, 0x204060 );
+		nChecksum[i][3] = Draw( pTexture[i], &nColor[i][3] );
+		for(j = 0; j < TEST_IMAGE_COUNT; j++) {
+			nPaletteError += CheckPalette4( pTexture[i][j] );
+			SetPalette( pTexture[i][j], pPalette );
+		}
+		nChecksum[i][4] = Draw( pTexture[i], &nColor[i][4] );
+		for(j = 0; j < TEST_IMAGE_COUNT; j++) {
+			nPaletteError += CheckPalette4( pTexture[i][j] );
+		}
+		// 次のために元の色に戻す
+		SetColor( pPalette, 0x010203, 0 );
+		SetColor( pAct, 0x030201, 0x808080 );
+	}
+	Cat_RenderTerm();
+
+	TestResetDebugScreen();
+	nIndex = GetIndex( &gImage[0], 4, 2 );
+	nExpect[0] = (nIndex * 0x010203) & 0xFFFFFF;
+	nExpect[1] = ((nIndex * 0x020301) ^ 0x408040) & 0xFFFFFF;
+	nExpect[2] = ((nIndex * 0x030201) ^ 0x808080) & 0xFFFFFF;
+	nExpect[3] = ((nIndex * 0x010101) ^ 0x204060) & 0xFFFFFF;
+	nExpect[4] = nExpect[1];
+	for(i = 0; i < TEST_SCENE_COUNT; i++) {
+		TRACE(( "8bit %08X %06X 4bit %08X %06X\n", (unsigned int)nChecksum[0][i], (unsigned int)nColor[0][i],
+			(unsigned int)nChecksum[1][i], (unsigned int)nColor[1][i] ));
+		if((nChecksum[0][i] != nChecksum[1][i]) || (nColor[0][i] != nExpect[i]) || (nColor[1][i] != nExpect[i])) {
+			nFail++;
+		}
+	}
+	TRACE(( "palette error:%d padding error:%d\n", (int)nPaletteError, (int)nPaddingError ));
+	TestPrintResult( (nFail == 0) && (nPaletteError == 0) && (nPaddingError == 0) );
+
+	for(i = 0; i < 2; i++) {
+		for(j = 0; j < TEST_IMAGE_COUNT; j++) {
+			Cat_TextureRelease( pTexture[i][j] );
+		}
+	}
+	Cat_PaletteRelease( pPalette );
+	Cat_PaletteRelease( pAct );
+	HALT();
+	return 0;
+}
@@ -0,0 +1,281 @@
+// Cat_Texture palette test code
+// 16色だけ使う8bitのイメージを、そのままの場合と4bitに変換した場合の2回作成して、
+// 別のパレット(ACTの差し替え)を指定して描画し、描画結果が同じになることを確かめる。
+//
+// 使う番号は200～214なので、4bitの番号で変換前のパレットを引くと0～15番の色になってしまう。
+// 1フレームの中で2つのパレットを交互に使う描画と、パレットを更新した後の描画と、
+// 記録したリストの差し込み口にパレットを設定した描画も比べる。
+
+#include "Cat_PspCallback.h"
+#include "Cat_DisplayList.h"
+#include "Cat_Render.h"
+#include "Cat_RenderState.h"
+#include "Cat_SpriteBatch.h"
+#include "Cat_Texture.h"
+#include "TestCommon.h"
+#include <stdlib.h>
+
+#include <pspdebug.h>
+#include <pspkernel.h>
+#include <pspge.h>
+#include <pspgu.h>
+
+#define TRACE(x) pspDebugScreenPrintf x
+#define HALT() sceKernelSleepThreadCB()
+
+//! イメージの横幅
+#define TEST_IMAGE_WIDTH (32)
+//! イメージの高さ
+#define TEST_IMAGE_HEIGHT (16)
+//! イメージで使う最初の番号
+#define TEST_INDEX_BASE (200)
+//! 確かめる番号
+#define TEST_INDEX_CHECK (203)
+//! 横に並べる数
+#define TEST_COUNT_X (8)
+//! 縦に並べる数
+#define TEST_COUNT_Y (8)
+//! 記録したリストを呼ぶフレーム数(2つのリストを両方使う)
+#define TEST_LIST_FRAME (4)
+//! リスト1つのサイズ
+#define TEST_LIST_SIZE (16 * 1024)
+
+//! 描画する場面
+typedef struct {
+	Cat_Texture*		pTexture;		/*!< 描画するテクスチャ		*/
+	Cat_Palette*		pPalette[2];	/*!< 交互に使うパレット		*/
+	Cat_SpriteBatch*	pBatch;			/*!< バッチ					*/
+} Scene;
+
+//! イメージのピクセルの番号を取得する
+/*!
+	@param[in]	x	x座標
+	@param[in]	y	y座標
+	@return	番号
+*/
+static uint8_t
+GetIndex( uint32_t x, uint32_t y )
+{
+	return (uint8_t)(TEST_INDEX_BASE + (x / 2 + y) % 15);
+}
+
+//! テクスチャを作成する
+/*!
+	@param[in]	pPalette	パレット(テクスチャに参照を渡す)
+	@param[in]	nOption		CAT_TEXTURE_OPTION_xxxの論理和
+	@return	作成されたテクスチャ。失敗した場合は0が返る。
+*/
+static Cat_Texture*
+CreateTexture( Cat_Palette* pPalette, uint32_t nOption )
+{
+	Cat_Texture* rc;
+	uint8_t* pbImage;
+	uint32_t x;
+	uint32_t y;
+
+	pbImage = (uint8_t*)malloc( TEST_IMAGE_WIDTH * TEST_IMAGE_HEIGHT );
+	if(pbImage == 0) {
+		return 0;
+	}
+	for(y = 0; y < TEST_IMAGE_HEIGHT; y++) {
+		for(x = 0; x < TEST_IMAGE_WIDTH; x++) {
+			pbImage[x + y * TEST_IMAGE_WIDTH] = GetIndex( x, y );
+		}
+	}
+	Cat_TextureSetOption( nOption );
+	rc = Cat_TextureCreate( TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT, TEST_IMAGE_WIDTH, pbImage, FORMAT_PIXEL_CLUT8, pPalette );
+	Cat_TextureSetOption( CAT_TEXTURE_OPTION_DEFAULT );
+	free( pbImage );
+	return rc;
+}
+
+//! パレットの色を設定する
+/*!
+	@param[in,out]	pPalette	パレット(256色のRGBA8888)
+	@param[in]		nMul		番号に掛ける値
+	@param[in]		nXor		色に排他的論理和をとる値
+*/
+static void
+SetColor( Cat_Palette* pPalette, uint32_t nMul, uint32_t nXor )
+{
+	uint32_t* pnColor = (uint32_t*)pPalette->pvData;
+	uint32_t i;
+
+	for(i = 0; i < 256; i++) {
+		pnColor[i] = 0xFF000000 | ((i * nMul) ^ nXor);
+	}
+	Cat_PaletteUpdate( pPalette );
+}
+
+//! 場面を描画する
+/*!
+	升目ごとに2つのパレットを交互に使う。
+	@param[in]	pScene		場面
+	@param[in]	pPalette0	1つ目のパレット
+	@param[in]	pPalette1	2つ目のパレット
+*/
+static void
+DrawScene( Scene* pScene, Cat_Palette* pPalette0, Cat_Palette* pPalette1 )
+{
+	Cat_SpriteBatchSprite sprite;
+	uint32_t tx;
+	uint32_t ty;
+
+	Cat_SpriteBatchSpriteInit( &sprite );
+	sprite.pTexture = pScene->pTexture;
+	for(ty = 0; ty < TEST_COUNT_Y; ty++) {
+		for(tx = 0; tx < TEST_COUNT_X; tx++) {
+			sprite.pPalette = ((tx + ty) & 1) ? pPalette1 : pPalette0;
+			sprite.x = (float)(tx * TEST_IMAGE_WIDTH);
+			sprite.y = (float)(ty * TEST_IMAGE_HEIGHT);
+			Cat_SpriteBatchAdd( pScene->pBatch, &sprite );
+		}
+	}
+	Cat_SpriteBatchFlush( pScene->pBatch );
+}
+
+//! 場面を記録する
+/*!
+	@param[in]	pList		記録しているリスト
+	@param[in]	pvContext	場面
+*/
+static void
+RecordScene( Cat_DisplayList* pList, void* pvContext )
+{
+	Scene* pScene = (Scene*)pvContext;
+
+	DrawScene( pScene, Cat_DisplayListGetPalette( pList, 0, pScene->pPalette[0] ),
+		Cat_DisplayListGetPalette( pList, 1, pScene->pPalette[1] ) );
+}
+
+//! 描画して画面のチェックサムを取得する
+/*!
+	@param[in]	pScene		場面
+	@param[in]	pList		記録したリスト(0の場合はバッチで描画する)
+	@param[out]	pnColor		2つ目のパレットで描いた升目の \a TEST_INDEX_CHECK 番のピクセルの色(RGB)
+	@return	チェックサム
+*/
+static uint32_t
+Draw( Scene* pScene, Cat_DisplayList* pList, uint32_t* pnColor )
+{
+	const uint32_t* pnScreen = (const uint32_t*)((uintptr_t)sceGeEdramGetAddr() | 0x40000000);
+
+	Cat_RenderStateInvalidate();
+	Cat_RenderBegin(); {
+		if(pList) {
+			Cat_DisplayListSetPalette( pList, 0, pScene->pPalette[0] );
+			Cat_DisplayListSetPalette( pList, 1, pScene->pPalette[1] );
+			Cat_DisplayListCall( pList );
+		} else {
+			DrawScene( pScene, pScene->pPalette[0], pScene->pPalette[1] );
+		}
+	} Cat_RenderEnd();
+	Cat_RenderScreenUpdate();
+	sceGuSync( 0, 0 );
+	// 左から2つ目の升目の(6,0)が203番
+	*pnColor = pnScreen[TEST_IMAGE_WIDTH + (TEST_INDEX_CHECK - TEST_INDEX_BASE) * 2] & 0xFFFFFF;
+	return TestGetScreenChecksum();
+}
+
+int
+main()
+{
+	Scene scene[2];
+	Cat_Palette* pPalette[2];
+	Cat_DisplayList* pList = 0;
+	uint32_t nChecksum[2][3];
+	uint32_t nListChecksum[TEST_LIST_FRAME];
+	uint32_t nColor[2][3];
+	uint32_t nListColor[TEST_LIST_FRAME];
+	uint32_t nExpect[2];
+	uint32_t nFail = 0;
+	uint32_t i;
+
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	TRACE(( "Cat_Texture palette test code\n" ));
+
+	// テクスチャのパレットと、差し替えるパレット
+	for(i = 0; i < 2; i++) {
+		pPalette[i] = Cat_PaletteCreate( FORMAT_PALETTE_8888, 256, 0 );
+		if(pPalette[i] == 0) {
+			TRACE(( "Error:Cat_PaletteCreate\n" ));
+			HALT();
+		}
+	}
+	SetColor( pPalette[0], 0x010203, 0 );
+	SetColor( pPalette[1], 0x030201, 0x808080 );
+	// 0は8bitのまま、1は4bitに変換する(テクスチャがパレットの参照を1つずつ持つ)
+	for(i = 0; i < 2; i++) {
+		Cat_PaletteAddRef( pPalette[0] );
+		scene[i].pTexture = CreateTexture( pPalette[0], i ? CAT_TEXTURE_OPTION_CLUT4 : CAT_TEXTURE_OPTION_DEFAULT );
+		scene[i].pPalette[0] = pPalette[0];
+		scene[i].pPalette[1] = pPalette[1];
+		scene[i].pBatch = Cat_SpriteBatchCreate( TEST_COUNT_X * TEST_COUNT_Y );
+		if((scene[i].pTexture == 0) || (scene[i].pBatch == 0)) {
+			TRACE(( "Error:Cat_TextureCreate\n" ));
+			HALT();
+		}
+	}
+	TRACE(( "format:%d %d\n", (int)scene[0].pTexture->ePixelFormat, (int)scene[1].pTexture->ePixelFormat ));
+	if((scene[0].pTexture->ePixelFormat != FORMAT_PIXEL_CLUT8) || (scene[1].pTexture->ePixelFormat != FORMAT_PIXEL_CLUT4)) {
+		nFail++;
+	}
+
+	Cat_RenderInit( CAT_RENDER_PARAM_FORMAT_RGBA8888 | CAT_RENDER_PARAM_BUFFER_SINGLE );
+	for(i = 0; i < 2; i++) {
+		// 0:差し替えたパレット 1:テクスチャのパレットと差し替えたパレット 2:差し替えたパレットを更新した後
+		scene[i].pPalette[0] = pPalette[1];
+		nChecksum[i][0] = Draw( &scene[i], 0, &nColor[i][0] );
+		scene[i].pPalette[0] = pPalette[0];
+		nChecksum[i][1] = Draw( &scene[i], 0, &nColor[i][1] );
+		SetColor( pPalette[1], 0x020301, 0x408040 );
+		nChecksum[i][2] = Draw( &scene[i], 0, &nColor[i][2] );
+		SetColor( pPalette[1], 0x030201, 0x808080 );
+	}
+	// 記録したリストの差し込み口に、更新したパレットを設定する
+	pList = Cat_DisplayListCreate( TEST_LIST_SIZE, RecordScene, &scene[1] );
+	if(pList) {
+		for(i = 0; i < TEST_LIST_FRAME; i++) {
+			SetColor( pPalette[1], (i & 1) ? 0x020301 : 0x030201, (i & 1) ? 0x408040 : 0x808080 );
+			nListChecksum[i] = Draw( &scene[1], pList, &nListColor[i] );
+		}
+	}
+	Cat_RenderTerm();
+
+	TestResetDebugScreen();
+	nExpect[0] = ((TEST_INDEX_CHECK * 0x030201) ^ 0x808080) & 0xFFFFFF;
+	nExpect[1] = ((TEST_INDEX_CHECK * 0x020301) ^ 0x408040) & 0xFFFFFF;
+	for(i = 0; i < 3; i++) {
+		TRACE(( "8bit %08X %08X 4bit %08X %08X\n", (unsigned int)nChecksum[0][i], (unsigned int)nColor[0][i],
+			(unsigned int)nChecksum[1][i], (unsigned int)nColor[1][i] ));
+		if(nChecksum[0][i] != nChecksum[1][i]) {
+			nFail++;
+		}
+	}
+	if((nColor[1][0] != nExpect[0]) || (nColor[1][1] != nExpect[0]) || (nColor[1][2] != nExpect[1])) {
+		nFail++;
+	}
+	if(pList == 0) {
+		TRACE(( "Error:Cat_DisplayListCreate\n" ));
+		nFail++;
+	} else {
+		for(i = 0; i < TEST_LIST_FRAME; i++) {
+			TRACE(( "list %08X %08X\n", (unsigned int)nListChecksum[i], (unsigned int)nListColor[i] ));
+			if((nListChecksum[i] != nChecksum[0][(i & 1) ? 2 : 1]) || (nListColor[i] != nColor[0][(i & 1) ? 2 : 1])) {
+				nFail++;
+			}
+		}
+		Cat_DisplayListDestroy( pList );
+	}
+	TestPrintResult( nFail == 0 );
+
+	for(i = 0; i < 2; i++) {
+		Cat_SpriteBatchDestroy( scene[i].pBatch );
+		Cat_TextureRelease( scene[i].pTexture );
+		Cat_PaletteRelease( pPalette[i] );
+	}
+	HALT();
+	return 0;
+}
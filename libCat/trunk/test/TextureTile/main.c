@@ -0,0 +1,141 @@
+// Cat_Texture tile test code
+// 512を超える32bitのイメージを、分割だけした場合と、分割して8bitに減色した場合の2回作成して描画し、
+// 分割テクスチャが元のテクスチャのパレットを共有することと、描画結果が同じになることを確かめる。
+//
+// イメージは256色以下で半透明が無いので、減色しても元の色がそのままパレットに入る。
+// 左右を反転した描画と、縮小した描画も比べる。
+
+#include "Cat_PspCallback.h"
+#include "Cat_Render.h"
+#include "Cat_RenderState.h"
+#include "Cat_Texture.h"
+#include "TestCommon.h"
+#include <stdlib.h>
+
+#include <pspdebug.h>
+#include <pspkernel.h>
+#include <pspgu.h>
+
+#define TRACE(x) pspDebugScreenPrintf x
+#define HALT() sceKernelSleepThreadCB()
+
+//! イメージの横幅(分割される大きさ)
+#define TEST_IMAGE_WIDTH (1024)
+//! イメージの高さ
+#define TEST_IMAGE_HEIGHT (64)
+
+//! 分割するイメージを作成する
+/*!
+	8ドット四方の升目ごとに色を変え、升目の左端は透明にする。
+	@return	イメージ(RGBA8888)。失敗した場合は0が返る。
+*/
+static uint32_t*
+CreateImage( void )
+{
+	uint32_t* pnImage;
+	uint32_t x;
+	uint32_t y;
+
+	pnImage = (uint32_t*)malloc( TEST_IMAGE_WIDTH * TEST_IMAGE_HEIGHT * sizeof(uint32_t) );
+	if(pnImage == 0) {
+		return 0;
+	}
+	for(y = 0; y < TEST_IMAGE_HEIGHT; y++) {
+		for(x = 0; x < TEST_IMAGE_WIDTH; x++) {
+			const uint32_t nCell = (x / 8 + (y / 8) * 3) % 200;
+			pnImage[x + y * TEST_IMAGE_WIDTH] = ((x % 8) == 0) ? 0 : (0xFF000000 | (nCell * 0x00010305));
+		}
+	}
+	return pnImage;
+}
+
+//! 描画して画面のチェックサムを取得する
+/*!
+	@param[in]	pTexture	分割されたテクスチャ
+	@return	チェックサム
+*/
+static uint32_t
+DrawTexture( Cat_Texture* pTexture )
+{
+	Cat_RenderStateInvalidate();
+	Cat_RenderBegin(); {
+		Cat_TextureDraw( pTexture, 0, 0, TEST_IMAGE_WIDTH / 2, TEST_IMAGE_HEIGHT );
+		Cat_TextureDraw( pTexture, 480, 80, -480, TEST_IMAGE_HEIGHT );
+		Cat_TextureDraw( pTexture, -200, 160, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT );
+	} Cat_RenderEnd();
+	Cat_RenderScreenUpdate();
+	sceGuSync( 0, 0 );
+	return TestGetScreenChecksum();
+}
+
+int
+main()
+{
+	Cat_TextureQuantizeStatistics statistics;
+	Cat_Texture* pTexture[2];
+	Cat_Palette* pPalette;
+	uint32_t* pnImage;
+	uint32_t nChecksum[2];
+	uint32_t nTileCount = 0;
+	uint32_t nShared = 0;
+	uint32_t tx;
+	uint32_t i;
+
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	TRACE(( "Cat_Texture tile test code\n" ));
+
+	pnImage = CreateImage();
+	if(pnImage == 0) {
+		TRACE(( "Error:malloc\n" ));
+		HALT();
+	}
+	Cat_TextureResetQuantizeStatistics();
+	for(i = 0; i < 2; i++) {
+		Cat_TextureSetOption( (i == 0) ? CAT_TEXTURE_OPTION_TILE : (CAT_TEXTURE_OPTION_TILE | CAT_TEXTURE_OPTION_QUANTIZE) );
+		pTexture[i] = Cat_TextureCreate( TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT, TEST_IMAGE_WIDTH * sizeof(uint32_t), pnImage,
+			FORMAT_PIXEL_8888, 0 );
+		if((pTexture[i] == 0) || !Cat_TextureIsTiled( pTexture[i] )) {
+			TRACE(( "Error:Cat_TextureCreate\n" ));
+			HALT();
+		}
+	}
+	Cat_TextureSetOption( CAT_TEXTURE_OPTION_DEFAULT );
+	Cat_TextureGetQuantizeStatistics( &statistics );
+	free( pnImage );
+
+	// 減色した方は、元のテクスチャがパレットを持ち、分割テクスチャはそれを共有する
+	pPalette = Cat_TextureGetDrawPalette( pTexture[1] );
+	for(tx = 0; ; tx++) {
+		Cat_Texture* pTile = Cat_TextureGetTile( pTexture[1], tx, 0 );
+		if(pTile == 0) {
+			break;
+		}
+		nTileCount++;
+		if((pTile->ePixelFormat == FORMAT_PIXEL_CLUT8) && pPalette && (Cat_TextureGetDrawPalette( pTile ) == pPalette)) {
+			nShared++;
+		}
+	}
+
+	Cat_RenderInit( CAT_RENDER_PARAM_FORMAT_RGBA8888 | CAT_RENDER_PARAM_BUFFER_SINGLE );
+	for(i = 0; i < 2; i++) {
+		nChecksum[i] = DrawTexture( pTexture[i] );
+	}
+	Cat_RenderTerm();
+
+	TestResetDebugScreen();
+	TRACE(( "tiles:%d shared palette:%d convert:%d exact:%d saved:%d bytes\n", (int)nTileCount, (int)nShared,
+		(int)statistics.nConvertCount, (int)statistics.nExactCount, (int)statistics.nSavedSize ));
+	TRACE(( "32bit checksum %08X\n", (unsigned int)nChecksum[0] ));
+	TRACE(( "8bit  checksum %08X\n", (unsigned int)nChecksum[1] ));
+	// イメージ全体を1回だけ減色する
+	TestPrintResult( (nTileCount == TEST_IMAGE_WIDTH / CAT_TEXTURE_TILE_SIZE) && (nShared == nTileCount)
+		&& (statistics.nConvertCount == 1) && (statistics.nExactCount == 1) && (nChecksum[0] == nChecksum[1]) );
+
+	for(i = 0; i < 2; i++) {
+		Cat_TextureRelease( pTexture[i] );
+	}
+	HALT();
+	return 0;
+}
@@ -0,0 +1,295 @@
+// Cat_Vram test code
+// 擬似VRAMで、ラウンドごとによく使うリソースを入れ替えて配置を更新し続け、
+// 常駐しているデータが壊れていないことと、上限を守っていることを毎フレーム確かめる。
+//
+// 追い出した領域は描画中のパケットが参照しているかもしれないので、同じ更新の中で別のリソースを
+// 置いてはいけない。更新の前後の配置を比べて、追い出された場所に置かれたものが無いことも確かめる。
+// ラウンドの間で断片化を解消して、空きが1つにまとまることと、移動してもデータが同じことを見る。
+// 最後に小さいリソースをたくさん使って、常駐数と解放待ちの数の合計が上限を超えないことを確かめる。
+
+#include "Cat_PspCallback.h"
+#include "Cat_Vram.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include <pspdebug.h>
+#include <pspkernel.h>
+
+#define TRACE(x) pspDebugScreenPrintf x
+#define HALT() sceKernelSleepThreadCB()
+
+//! 擬似VRAMのサイズ
+#define TEST_VRAM_SIZE (1024 * 1024)
+//! 常駐させる上限
+#define TEST_VRAM_BUDGET (768 * 1024)
+//! 1回の更新で転送する上限
+#define TEST_VRAM_UPLOAD (256 * 1024)
+//! リソース数
+#define TEST_RESOURCE (48)
+//! 1ラウンドでよく使うリソース数
+#define TEST_HOT (12)
+//! ラウンド数
+#define TEST_ROUND (4)
+//! 1ラウンドのフレーム数
+#define TEST_FRAME (300)
+//! 常駐数の上限を確かめる小さいリソースの数
+#define TEST_SMALL_RESOURCE (CAT_VRAM_PENDING_MAX + 64)
+
+//! 更新の前の配置
+typedef struct {
+	uint32_t	fResident;		/*!< 常駐していたかどうか	*/
+	uint32_t	nOffset;		/*!< 置かれていた場所		*/
+} Placement;
+
+//! 擬似VRAMの先頭
+static const uint8_t* gpbVram = 0;
+
+//! 常駐しているデータが元と同じか数える
+/*!
+	Cat_VramTouch()で使用回数を増やすと配置が変わるので、アドレスは擬似VRAMの先頭とオフセットから求める。 \n
+	擬似VRAMの先頭は、最初に常駐したリソースで1回だけ取得する。
+	@param[in]	pVram		領域管理
+	@param[in]	pResource	リソース
+	@param[in]	nCount		リソース数
+	@return	違っていたリソース数
+*/
+static uint32_t
+CheckResident( Cat_Vram* pVram, Cat_VramResource* pResource, uint32_t nCount )
+{
+	uint32_t rc = 0;
+	uint32_t i;
+
+	for(i = 0; i < nCount; i++) {
+		if(!pResource[i].fResident) {
+			continue;
+		}
+		if(gpbVram == 0) {
+			gpbVram = (const uint8_t*)Cat_VramTouch( pVram, &pResource[i] ) - pResource[i].block.nOffset;
+		}
+		if(memcmp( gpbVram + pResource[i].block.nOffset, pResource[i].pvSource, pResource[i].nSize )) {
+			rc++;
+		}
+	}
+	return rc;
+}
+
+//! 配置を覚えておく
+/*!
+	@param[out]	pPlacement	配置
+	@param[in]	pResource	リソース
+	@param[in]	nCount		リソース数
+*/
+static void
+SavePlacement( Placement* pPlacement, const Cat_VramResource* pResource, uint32_t nCount )
+{
+	uint32_t i;
+
+	for(i = 0; i < nCount; i++) {
+		pPlacement[i].fResident = pResource[i].fResident;
+		pPlacement[i].nOffset   = pResource[i].block.nOffset;
+	}
+}
+
+//! 同じ更新の中で、追い出された場所に置かれたリソースを数える
+/*!
+	@param[in]	pPlacement	更新の前の配置
+	@param[in]	pResource	リソース(更新の後)
+	@param[in]	nCount		リソース数
+	@param[out]	pnEvict		追い出されたリソース数に加える
+	@param[out]	pnBytes		追い出されたサイズ(バイト単位)
+	@return	追い出された場所に重なって置かれたリソース数
+*/
+static uint32_t
+CheckPending( const Placement* pPlacement, const Cat_VramResource* pResource, uint32_t nCount, uint32_t* pnEvict, uint32_t* pnBytes )
+{
+	uint32_t rc = 0;
+	uint32_t i;
+	uint32_t j;
+
+	*pnBytes = 0;
+	for(i = 0; i < nCount; i++) {
+		if(!pPlacement[i].fResident || pResource[i].fResident) {
+			continue;
+		}
+		(*pnEvict)++;
+		*pnBytes += pResource[i].nSize;
+		for(j = 0; j < nCount; j++) {
+			if(pPlacement[j].fResident || !pResource[j].fResident) {
+				continue;	// この更新で置かれたものだけ
+			}
+			if((pResource[j].block.nOffset < pPlacement[i].nOffset + pResource[i].nSize)
+				&& (pPlacement[i].nOffset < pResource[j].block.nOffset + pResource[j].nSize)) {
+				rc++;
+			}
+		}
+	}
+	return rc;
+}
+
+int
+main()
+{
+	static Cat_VramResource resource[TEST_RESOURCE];
+	static Cat_VramResource small[TEST_SMALL_RESOURCE];
+	static uint8_t* pbSource[TEST_RESOURCE];
+	static uint8_t abSmall[TEST_SMALL_RESOURCE][CAT_VRAM_ALIGN];
+	static Placement placement[TEST_RESOURCE];
+	Cat_VramStatistics statistics;
+	Cat_Vram* pVram;
+	uint32_t nCorrupt = 0;
+	uint32_t nOverlap = 0;
+	uint32_t nOverBudget = 0;
+	uint32_t nEvict = 0;
+	uint32_t nPromote = 0;
+	uint32_t nFail = 0;
+	uint32_t nBytes;
+	uint32_t nRound;
+	uint32_t nFrame;
+	uint32_t i;
+
+	Cat_SetupCallbacks();
+	pspDebugScreenInit();
+
+	TRACE(( "Cat_Vram test code\n" ));
+
+	pVram = Cat_VramCreateSimulator( TEST_VRAM_SIZE );
+	if(pVram == 0) {
+		TRACE(( "Error:Cat_VramCreateSimulator\n" ));
+		HALT();
+	}
+	Cat_VramSetBudget( pVram, TEST_VRAM_BUDGET );
+	Cat_VramSetUploadLimit( pVram, TEST_VRAM_UPLOAD );
+	srand( 1 );
+	for(i = 0; i < TEST_RESOURCE; i++) {
+		const uint32_t nSize = (16 + (rand() % 8) * 16) * 1024;
+		uint32_t n;
+		pbSource[i] = (uint8_t*)malloc( nSize );
+		if(pbSource[i] == 0) {
+			TRACE(( "Error:malloc\n" ));
+			HALT();
+		}
+		for(n = 0; n < nSize; n++) {
+			pbSource[i][n] = (uint8_t)(rand() >> 4);
+		}
+		Cat_VramResourceInit( &resource[i], pbSource[i], nSize );
+	}
+
+	for(nRound = 0; nRound < TEST_ROUND; nRound++) {
+		uint32_t nLargestFree;
+
+		Cat_VramResetStatistics( pVram );
+		for(nFrame = 0; nFrame < TEST_FRAME; nFrame++) {
+			uint32_t n;
+			// よく使うものは毎フレーム、それ以外はたまに使う
+			for(n = 0; n < TEST_HOT; n++) {
+				Cat_VramTouch( pVram, &resource[(nRound * 7 + n) % TEST_RESOURCE] );
+			}
+			Cat_VramTouch( pVram, &resource[rand() % TEST_RESOURCE] );
+
+			SavePlacement( placement, resource, TEST_RESOURCE );
+			Cat_VramUpdate( pVram );
+			nOverlap += CheckPending( placement, resource, TEST_RESOURCE, &nEvict, &nBytes );
+			nCorrupt += CheckResident( pVram, resource, TEST_RESOURCE );
+			Cat_VramGetStatistics( pVram, &statistics );
+			if(statistics.nResidentBytes > statistics.nBudget) {
+				nOverBudget++;
+			}
+			if(statistics.nPendingBytes != nBytes) {
+				nFail++;	// 前回の解放待ちが残っているか、追い出した分が解放待ちになっていない
+			}
+		}
+		Cat_VramGetStatistics( pVram, &statistics );
+		nPromote += statistics.nPromoteCount;
+		nLargestFree = statistics.nLargestFree;
+		TRACE(( "round%d hit:%3d%% promote:%3d evict:%3d upload:%5dKB frag:%d\n", (int)nRound,
+			(int)(statistics.nHitCount * 100 / (statistics.nTouchCount ? statistics.nTouchCount : 1)),
+			(int)statistics.nPromoteCount, (int)statistics.nEvictCount,
+			(int)(statistics.nUploadBytes / 1024), (int)statistics.nFragmentCount ));
+
+		// ラウンドの間で断片化を解消すると、空きは後ろに1つにまとまる
+		Cat_VramDefragment( pVram );
+		Cat_VramGetStatistics( pVram, &statistics );
+		TRACE(( "       resident:%4dKB(%2d) largest free:%4dKB -> %4dKB moved:%4dKB\n",
+			(int)(statistics.nResidentBytes / 1024), (int)statistics.nResidentCount,
+			(int)(nLargestFree / 1024), (int)(statistics.nLargestFree / 1024),
+			(int)(statistics.nDefragmentBytes / 1024) ));
+		if((statistics.nPendingBytes != 0) || (statistics.nLargestFree != statistics.nFreeBytes)
+			|| (statistics.nFreeBytes != TEST_VRAM_SIZE - statistics.nResidentBytes)) {
+			TRACE(( "Error:Cat_VramDefragment\n" ));
+			nFail++;
+		}
+		nCorrupt += CheckResident( pVram, resource, TEST_RESOURCE );
+	}
+
+	// 登録を解除した領域は、次の更新まで解放待ちになる
+	for(i = 0; (i < TEST_RESOURCE) && !resource[i].fResident; i++) {
+	}
+	if(i < TEST_RESOURCE) {
+		Cat_VramResourceRemove( &resource[i] );
+		Cat_VramGetStatistics( pVram, &statistics );
+		if(statistics.nPendingBytes != resource[i].nSize) {
+			nFail++;
+		}
+		SavePlacement( placement, resource, TEST_RESOURCE );
+		Cat_VramUpdate( pVram );
+		CheckPending( placement, resource, TEST_RESOURCE, &nEvict, &nBytes );
+		Cat_VramGetStatistics( pVram, &statistics );
+		if(statistics.nPendingBytes != nBytes) {
+			nFail++;
+		}
+	} else {
+		nFail++;
+	}
+	Cat_VramDestroy( pVram );
+	gpbVram = 0;
+
+	// 小さいリソースをたくさん使っても、常駐数と解放待ちの数の合計は上限を超えない
+	pVram = Cat_VramCreateSimulator( TEST_VRAM_SIZE );
+	if(pVram == 0) {
+		TRACE(( "Error:Cat_VramCreateSimulator\n" ));
+		HALT();
+	}
+	for(i = 0; i < TEST_SMALL_RESOURCE; i++) {
+		memset( abSmall[i], (int)i, CAT_VRAM_ALIGN );
+		Cat_VramResourceInit( &small[i], abSmall[i], CAT_VRAM_ALIGN );
+	}
+	// 上限は常駐数が解放待ちの上限に近くなるようにする
+	Cat_VramSetBudget( pVram, (CAT_VRAM_PENDING_MAX - 8) * CAT_VRAM_ALIGN );
+	Cat_VramResetStatistics( pVram );
+	for(nRound = 0; nRound < 8; nRound++) {
+		for(nFrame = 0; nFrame < 32; nFrame++) {
+			// 使うものを1/4ずつずらして、追い出しを起こす
+			for(i = 0; i < TEST_SMALL_RESOURCE; i++) {
+				if(((i + nRound * TEST_SMALL_RESOURCE / 4) % TEST_SMALL_RESOURCE) < TEST_SMALL_RESOURCE * 3 / 4) {
+					Cat_VramTouch( pVram, &small[i] );
+				}
+			}
+			Cat_VramUpdate( pVram );
+			Cat_VramGetStatistics( pVram, &statistics );
+			if(statistics.nResidentCount + statistics.nPendingBytes / CAT_VRAM_ALIGN > CAT_VRAM_PENDING_MAX) {
+				nFail++;
+			}
+			nCorrupt += CheckResident( pVram, small, TEST_SMALL_RESOURCE );
+		}
+	}
+	TRACE(( "small promote:%d evict:%d resident:%d\n", (int)statistics.nPromoteCount, (int)statistics.nEvictCount,
+		(int)statistics.nResidentCount ));
+	if((statistics.nResidentCount == 0) || (statistics.nEvictCount == 0)) {
+		nFail++;
+	}
+	Cat_VramDestroy( pVram );
+
+	TRACE(( "promote:%d evict:%d corrupted:%d overlap:%d over budget:%d fail:%d\n", (int)nPromote, (int)nEvict,
+		(int)nCorrupt, (int)nOverlap, (int)nOverBudget, (int)nFail ));
+	if((nPromote > 0) && (nEvict > 0) && (nCorrupt == 0) && (nOverlap == 0) && (nOverBudget == 0) && (nFail == 0)) {
+		TRACE(( "OK\n" ));
+	} else {
+		TRACE(( "NG\n" ));
+	}
+
+	for(i = 0; i < TEST_RESOURCE; i++) {
+		free( pbSource[i] );
+	}
+	HALT();
+	return 0;
+}
@@ -0,0 +1,90 @@
+//! @file	TestCommon.c
+// テストで共通に使うもの
+
+#include "TestCommon.h"
+#include <stdlib.h>
+
+#include <pspdebug.h>
+#include <pspge.h>
+
+//! テスト用のテクスチャを作成する
+/*!
+	\a nSize 四方のテクスチャで、横に1周、縦に \a nIndex + 1 ずつ色が変わる。 \n
+	\a pPalette がある場合は8bitテクスチャ、0の場合は半透明の32bitテクスチャになる。 \n
+	同じ \a pPalette を渡したテクスチャは、パレットを共有する(同じキャラクター)。
+	@param[in]	nSize		大きさ(ドット単位、256以下)
+	@param[in]	nIndex		テクスチャの番号
+	@param[in]	pPalette	パレット(0の場合は32bit)
+	@return	作成されたテクスチャ。失敗した場合は0が返る。
+*/
+Cat_Texture*
+TestCreateTexture( uint32_t nSize, uint32_t nIndex, Cat_Palette* pPalette )
+{
+	const uint32_t nBytes = pPalette ? 1 : 4;
+	const uint32_t nStep  = 256 / nSize;
+	Cat_Texture* rc;
+	uint8_t* pbImage;
+	uint32_t x;
+	uint32_t y;
+
+	pbImage = (uint8_t*)malloc( nSize * nSize * nBytes );
+	if(pbImage == 0) {
+		return 0;
+	}
+	for(y = 0; y < nSize; y++) {
+		for(x = 0; x < nSize; x++) {
+			if(nBytes == 1) {
+				pbImage[x + y * nSize] = (uint8_t)((x * nStep + y * (nIndex + 1)) & 0xFF);
+			} else {
+				((uint32_t*)pbImage)[x + y * nSize] = 0x80000000 | (x * nStep) | ((y * nStep) << 8) | 0x400000;
+			}
+		}
+	}
+	rc = Cat_TextureCreate( nSize, nSize, nSize * nBytes, pbImage, pPalette ? FORMAT_PIXEL_CLUT8 : FORMAT_PIXEL_8888, pPalette );
+	free( pbImage );
+	return rc;
+}
+
+//! 画面の内容からチェックサムを計算する
+/*!
+	シングルバッファのRGBA8888で、描画先がVRAMの先頭にあること。 \n
+	sceGuSync()で描画が終わるのを待ってから呼ぶ。
+	@return	チェックサム
+*/
+uint32_t
+TestGetScreenChecksum( void )
+{
+	const uint32_t* pnScreen = (const uint32_t*)((uintptr_t)sceGeEdramGetAddr() | 0x40000000);
+	uint32_t rc = 0;
+	uint32_t x;
+	uint32_t y;
+
+	for(y = 0; y < 272; y++) {
+		for(x = 0; x < 480; x++) {
+			rc = rc * 31 + pnScreen[x + y * 512];
+		}
+	}
+	return rc;
+}
+
+//! 結果を出す前に、デバッグ表示を初期化し直す
+/*!
+	描画のテストは、Cat_RenderInit()からの描画でデバッグ表示が上書きされているので、 \n
+	Cat_RenderTerm()の後、結果を出す前に呼ぶ。
+*/
+void
+TestResetDebugScreen( void )
+{
+	// 描画で上書きされているので、デバッグ表示を初期化し直してから結果を出す
+	pspDebugScreenInit();
+}
+
+//! 最後の結果(OKかNG)を出す
+/*!
+	@param[in]	fOk		成功したかどうか
+*/
+void
+TestPrintResult( int fOk )
+{
+	pspDebugScreenPrintf( fOk ? "OK\n" : "NG\n" );
+}
@@ -0,0 +1,52 @@
+//! @file	TestCommon.h
+// テストで共通に使うもの
+
+#ifndef INCL_TestCommon_h
+#define INCL_TestCommon_h
+
+#include <stdint.h>
+#include "Cat_Palette.h"
+#include "Cat_Texture.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! テスト用のテクスチャを作成する
+/*!
+	\a nSize 四方のテクスチャで、横に1周、縦に \a nIndex + 1 ずつ色が変わる。 \n
+	\a pPalette がある場合は8bitテクスチャ、0の場合は半透明の32bitテクスチャになる。 \n
+	同じ \a pPalette を渡したテクスチャは、パレットを共有する(同じキャラクター)。
+	@param[in]	nSize		大きさ(ドット単位、256以下)
+	@param[in]	nIndex		テクスチャの番号
+	@param[in]	pPalette	パレット(0の場合は32bit)
+	@return	作成されたテクスチャ。失敗した場合は0が返る。
+*/
+extern Cat_Texture* TestCreateTexture( uint32_t nSize, uint32_t nIndex, Cat_Palette* pPalette );
+
+//! 画面の内容からチェックサムを計算する
+/*!
+	シングルバッファのRGBA8888で、描画先がVRAMの先頭にあること。 \n
+	sceGuSync()で描画が終わるのを待ってから呼ぶ。
+	@return	チェックサム
+*/
+extern uint32_t TestGetScreenChecksum( void );
+
+//! 結果を出す前に、デバッグ表示を初期化し直す
+/*!
+	描画のテストは、Cat_RenderInit()からの描画でデバッグ表示が上書きされているので、 \n
+	Cat_RenderTerm()の後、結果を出す前に呼ぶ。
+*/
+extern void TestResetDebugScreen( void );
+
+//! 最後の結果(OKかNG)を出す
+/*!
+	@param[in]	fOk		成功したかどうか
+*/
+extern void TestPrintResult( int fOk );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INCL_TestCommon_h
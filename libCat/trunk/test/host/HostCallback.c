@@ -0,0 +1,39 @@
+// テストをLinuxでビルドする時の、PSP専用の関数の代わり
+// デバッグ表示は標準出力に出し、HALT()で終了する。
+
+#include "Cat_PspCallback.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <pspdebug.h>
+#include <pspkernel.h>
+
+int
+Cat_SetupCallbacks( void )
+{
+	return 0;
+}
+
+void
+pspDebugScreenInit( void )
+{
+}
+
+void
+pspDebugScreenPrintf( const char* format, ... )
+{
+	va_list ap;
+
+	va_start( ap, format );
+	vprintf( format, ap );
+	va_end( ap );
+	fflush( stdout );
+}
+
+int
+sceKernelSleepThreadCB( void )
+{
+	exit( 0 );
+	return 0;
+}